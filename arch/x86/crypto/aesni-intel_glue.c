@@ -574,6 +574,98 @@ xts_crypt_slowpath(struct skcipher_request *req, xts_crypt_func crypt_func)
 	return skcipher_walk_done(&walk, 0);
 }
 
+/* Number of data units whose tweaks are computed in one go */
+#define XTS_DU_BATCH	8
+
+static void xts_du_tweaks(const struct aesni_xts_ctx *ctx, const u8 *iv,
+			  u64 du, unsigned int nr,
+			  u8 tweaks[XTS_DU_BATCH][AES_BLOCK_SIZE])
+{
+	u64 base = get_unaligned_le64(iv);
+	unsigned int i;
+
+	for (i = 0; i < nr; i++) {
+		put_unaligned_le64(base + du + i, tweaks[i]);
+		memcpy(tweaks[i] + 8, iv + 8, AES_BLOCK_SIZE - 8);
+	}
+	/* The tweaks are independent, so let the ECB code interleave them */
+	aesni_ecb_enc((struct crypto_aes_ctx *)&ctx->tweak_ctx, tweaks[0],
+		      tweaks[0], nr * AES_BLOCK_SIZE);
+}
+
+/*
+ * Handle a request made of several data units with consecutive plain64 IVs,
+ * typically all the sectors of a page of a dm-crypt bio. When the request
+ * stays within a page, all data units are processed under a single
+ * kernel_fpu_begin() and mapping, with their tweaks computed in batches.
+ */
+static noinline int
+xts_crypt_multi_du(struct skcipher_request *req, xts_crypt_func crypt_func)
+{
+	struct crypto_skcipher *tfm = crypto_skcipher_reqtfm(req);
+	const struct aesni_xts_ctx *ctx = aes_xts_ctx(tfm);
+	u8 tweaks[XTS_DU_BATCH][AES_BLOCK_SIZE] __aligned(AES_BLOCK_SIZE);
+	const unsigned int cryptlen = req->cryptlen;
+	const unsigned int du_size = req->du_size;
+	struct scatterlist *src = req->src;
+	struct scatterlist *dst = req->dst;
+	unsigned int du, nr, i;
+	int err;
+
+	if (du_size < AES_BLOCK_SIZE || du_size % AES_BLOCK_SIZE ||
+	    cryptlen % du_size)
+		return -EINVAL;
+
+	if (likely(src->length >= cryptlen && dst->length >= cryptlen &&
+		   src->offset + cryptlen <= PAGE_SIZE &&
+		   dst->offset + cryptlen <= PAGE_SIZE)) {
+		struct page *src_page = sg_page(src);
+		struct page *dst_page = sg_page(dst);
+		u8 *src_virt = kmap_local_page(src_page) + src->offset;
+		u8 *dst_virt = kmap_local_page(dst_page) + dst->offset;
+
+		kernel_fpu_begin();
+		for (du = 0; du < cryptlen / du_size; du += nr) {
+			nr = min(cryptlen / du_size - du, XTS_DU_BATCH);
+			xts_du_tweaks(ctx, req->iv, du, nr, tweaks);
+			for (i = 0; i < nr; i++)
+				(*crypt_func)(&ctx->crypt_ctx,
+					      src_virt + (du + i) * du_size,
+					      dst_virt + (du + i) * du_size,
+					      du_size, tweaks[i]);
+		}
+		kernel_fpu_end();
+		kunmap_local(dst_virt);
+		kunmap_local(src_virt);
+		return 0;
+	}
+
+	/* Otherwise, go through the slow path one data unit at a time */
+	for (du = 0; du < cryptlen / du_size; du++) {
+		struct scatterlist sg_src[2], sg_dst[2];
+		struct skcipher_request subreq;
+
+		kernel_fpu_begin();
+		xts_du_tweaks(ctx, req->iv, du, 1, tweaks);
+		kernel_fpu_end();
+
+		skcipher_request_set_tfm(&subreq, tfm);
+		skcipher_request_set_callback(&subreq,
+					      skcipher_request_flags(req),
+					      NULL, NULL);
+		src = scatterwalk_ffwd(sg_src, req->src, du * du_size);
+		dst = src;
+		if (req->dst != req->src)
+			dst = scatterwalk_ffwd(sg_dst, req->dst, du * du_size);
+		skcipher_request_set_crypt(&subreq, src, dst, du_size,
+					   tweaks[0]);
+		err = xts_crypt_slowpath(&subreq, crypt_func);
+		if (err)
+			return err;
+	}
+	return 0;
+}
+
 /* __always_inline to avoid indirect call in fastpath */
 static __always_inline int
 xts_crypt(struct skcipher_request *req, xts_encrypt_iv_func encrypt_iv,
@@ -588,6 +680,9 @@ xts_crypt(struct skcipher_request *req, xts_encrypt_iv_func encrypt_iv,
 	if (unlikely(cryptlen < AES_BLOCK_SIZE))
 		return -EINVAL;
 
+	if (req->du_size && req->du_size != cryptlen)
+		return xts_crypt_multi_du(req, crypt_func);
+
 	kernel_fpu_begin();
 	(*encrypt_iv)(&ctx->tweak_ctx, req->iv);
 
@@ -748,6 +843,7 @@ static struct skcipher_alg aesni_skciphers[] = {
 		.max_keysize	= 2 * AES_MAX_KEY_SIZE,
 		.ivsize		= AES_BLOCK_SIZE,
 		.walksize	= 2 * AES_BLOCK_SIZE,
+		.multi_data_unit = true,
 		.setkey		= xts_setkey_aesni,
 		.encrypt	= xts_encrypt_aesni,
 		.decrypt	= xts_decrypt_aesni,
@@ -819,6 +915,7 @@ static struct skcipher_alg aes_xts_alg_##suffix = {			       \
 	.max_keysize	= 2 * AES_MAX_KEY_SIZE,				       \
 	.ivsize		= AES_BLOCK_SIZE,				       \
 	.walksize	= 2 * AES_BLOCK_SIZE,				       \
+	.multi_data_unit = true,					       \
 	.setkey		= xts_setkey_aesni,				       \
 	.encrypt	= xts_encrypt_##suffix,				       \
 	.decrypt	= xts_decrypt_##suffix,				       \
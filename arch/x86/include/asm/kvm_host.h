@@ -1580,6 +1580,9 @@ struct kvm_vm_stat {
 		atomic64_t pages[KVM_NR_PAGE_SIZES];
 	};
 	u64 nx_lpage_splits;
+	atomic64_t lapic_timer_posted;
+	atomic64_t eager_split_pages;
+	u64 eager_split_ns;
 	u64 max_mmu_page_hash_collisions;
 	u64 max_mmu_rmap_size;
 };
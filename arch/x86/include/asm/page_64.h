@@ -59,6 +59,16 @@ static inline void clear_page(void *page)
 			   : "cc", "memory", "rax", "rcx");
 }
 
+void clear_page_movnti(void *page);
+
+/* Must be followed by a wmb() before the page is used */
+#define clear_page_nocache clear_page_nocache
+static inline void clear_page_nocache(void *page)
+{
+	kmsan_unpoison_memory(page, PAGE_SIZE);
+	clear_page_movnti(page);
+}
+
 void copy_page(void *to, void *from);
 
 #ifdef CONFIG_X86_5LEVEL
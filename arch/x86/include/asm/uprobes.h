@@ -22,6 +22,11 @@ typedef u8 uprobe_opcode_t;
 
 struct uprobe_xol_ops;
 
+enum {
+	ARCH_UPROBE_FLAG_CAN_OPTIMIZE	= 0,
+	ARCH_UPROBE_FLAG_OPTIMIZE_FAIL	= 1,
+};
+
 struct arch_uprobe {
 	union {
 		u8			insn[MAX_UINSN_BYTES];
@@ -29,6 +34,7 @@ struct arch_uprobe {
 	};
 
 	const struct uprobe_xol_ops	*ops;
+	unsigned long			flags;
 
 	union {
 		struct {
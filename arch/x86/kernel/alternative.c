@@ -1714,6 +1714,12 @@ void __init alternative_instructions(void)
 	 * patching.
 	 */
 
+	/*
+	 * Switch to the NUMA-aware spinlock slowpath, if it applies, before
+	 * the paravirt calls get patched.
+	 */
+	cna_configure_spin_lock_slowpath();
+
 	/*
 	 * Make sure to set (artificial) features depending on used paravirt
 	 * functions which can later influence alternative patching.
@@ -15,9 +15,13 @@
 #include <linux/syscalls.h>
 
 #include <linux/kdebug.h>
+#include <linux/highmem.h>
+#include <linux/security.h>
 #include <asm/processor.h>
 #include <asm/insn.h>
 #include <asm/mmu_context.h>
+#include <asm/nops.h>
+#include <asm/text-patching.h>
 
 /* Post-execution fixups. */
 
@@ -364,13 +368,472 @@ static unsigned long trampoline_check_ip(void)
 	return tramp + (uretprobe_syscall_check - uretprobe_trampoline_entry);
 }
 
+/*
+ * A uprobe on a 5-byte nop, which is what USDT probes typically are, is
+ * optimized on its first hit: the nop gets replaced by a call to a
+ * trampoline entering the kernel through the uretprobe syscall, which
+ * runs the uprobe consumers without a trap nor a single-step. The
+ * trampoline has to be in reach of a rel32 call, so each process gets
+ * a trampoline page per 4GB window of its address space it has such
+ * uprobes in.
+ */
+asm (
+	".pushsection .rodata\n"
+	".global uprobe_trampoline_entry\n"
+	"uprobe_trampoline_entry:\n"
+	"pushq %rcx\n"
+	"pushq %r11\n"
+	"pushq %rax\n"
+	"movq $" __stringify(__NR_uretprobe) ", %rax\n"
+	"syscall\n"
+	".global uprobe_syscall_check\n"
+	"uprobe_syscall_check:\n"
+	"popq %rax\n"
+	"popq %r11\n"
+	"popq %rcx\n"
+	"retq\n"
+	".global uprobe_trampoline_end\n"
+	"uprobe_trampoline_end:\n"
+	".popsection\n"
+);
+
+extern u8 uprobe_trampoline_entry[];
+extern u8 uprobe_trampoline_end[];
+extern u8 uprobe_syscall_check[];
+
+struct uprobe_trampoline {
+	struct hlist_node	node;
+	unsigned long		vaddr;
+};
+
+/* What the call to the trampoline and the trampoline push on the stack */
+struct uprobe_syscall_args {
+	unsigned long ax;
+	unsigned long r11;
+	unsigned long cx;
+	unsigned long retaddr;
+};
+
+static struct page *uprobe_tramp_pages[2] __ro_after_init;
+
+static int tramp_mremap(const struct vm_special_mapping *sm, struct vm_area_struct *new_vma)
+{
+	return -EPERM;
+}
+
+static const struct vm_special_mapping tramp_mapping = {
+	.name = "[uprobes-trampoline]",
+	.pages = uprobe_tramp_pages,
+	.mremap = tramp_mremap,
+};
+
+static int __init uprobe_trampoline_init(void)
+{
+	struct page *page = alloc_page(GFP_KERNEL);
+	void *kaddr;
+
+	if (!page)
+		return -ENOMEM;
+
+	kaddr = page_address(page);
+	memset(kaddr, INT3_INSN_OPCODE, PAGE_SIZE);
+	memcpy(kaddr, uprobe_trampoline_entry,
+	       uprobe_trampoline_end - uprobe_trampoline_entry);
+	uprobe_tramp_pages[0] = page;
+	return 0;
+}
+arch_initcall(uprobe_trampoline_init);
+
+static bool is_reachable_by_call(unsigned long vtramp, unsigned long vaddr)
+{
+	long delta = (long)(vtramp - (vaddr + CALL_INSN_SIZE));
+
+	return delta >= INT_MIN && delta <= INT_MAX;
+}
+
+static unsigned long find_nearest_trampoline(unsigned long vaddr)
+{
+	unsigned long call_end = vaddr + CALL_INSN_SIZE;
+	struct vm_unmapped_area_info info = {
+		.flags		= VM_UNMAPPED_AREA_TOPDOWN,
+		.length		= PAGE_SIZE,
+	};
+
+	if (call_end > (unsigned long)INT_MAX + 1)
+		info.low_limit = PAGE_ALIGN(call_end - ((unsigned long)INT_MAX + 1));
+	info.low_limit = max(info.low_limit, PAGE_ALIGN(mmap_min_addr));
+	info.high_limit = min(call_end + INT_MAX, TASK_SIZE) & PAGE_MASK;
+
+	return vm_unmapped_area(&info);
+}
+
+/* Called with mmap_lock held for writing */
+static struct uprobe_trampoline *get_uprobe_trampoline(unsigned long vaddr)
+{
+	struct mm_struct *mm = current->mm;
+	struct uprobe_trampoline *tramp;
+	struct vm_area_struct *vma;
+	unsigned long vtramp;
+
+	hlist_for_each_entry(tramp, &mm->uprobes_state.head_tramps, node) {
+		if (is_reachable_by_call(tramp->vaddr, vaddr))
+			return tramp;
+	}
+
+	vtramp = find_nearest_trampoline(vaddr);
+	if (offset_in_page(vtramp) || !is_reachable_by_call(vtramp, vaddr))
+		return NULL;
+
+	tramp = kzalloc(sizeof(*tramp), GFP_KERNEL);
+	if (!tramp)
+		return NULL;
+
+	vma = _install_special_mapping(mm, vtramp, PAGE_SIZE,
+				       VM_READ|VM_EXEC|VM_MAYREAD|VM_MAYEXEC,
+				       &tramp_mapping);
+	if (IS_ERR(vma)) {
+		kfree(tramp);
+		return NULL;
+	}
+
+	tramp->vaddr = vtramp;
+	hlist_add_head_rcu(&tramp->node, &mm->uprobes_state.head_tramps);
+	return tramp;
+}
+
+void arch_uprobe_clear_state(struct mm_struct *mm)
+{
+	struct uprobe_trampoline *tramp;
+	struct hlist_node *n;
+
+	hlist_for_each_entry_safe(tramp, n, &mm->uprobes_state.head_tramps, node)
+		kfree(tramp);
+}
+
+static bool in_uprobe_trampoline(unsigned long ip)
+{
+	unsigned long offset = uprobe_syscall_check - uprobe_trampoline_entry;
+	struct mm_struct *mm = current->mm;
+	struct uprobe_trampoline *tramp;
+	struct vm_area_struct *vma;
+	bool found = false;
+
+	rcu_read_lock();
+	hlist_for_each_entry_rcu(tramp, &mm->uprobes_state.head_tramps, node) {
+		if (ip == tramp->vaddr + offset) {
+			found = true;
+			break;
+		}
+	}
+	rcu_read_unlock();
+	if (found)
+		return true;
+
+	/* The trampolines a child inherits over fork() are not on its list */
+	mmap_read_lock(mm);
+	vma = vma_lookup(mm, ip);
+	found = vma && vma_is_special_mapping(vma, &tramp_mapping) &&
+		ip == vma->vm_start + offset;
+	mmap_read_unlock(mm);
+
+	return found;
+}
+
+/* Entered from the uretprobe syscall, when called from an uprobe trampoline */
+static long uprobe_syscall(struct pt_regs *regs)
+{
+	struct uprobe_syscall_args args;
+	unsigned long ip, sp;
+
+	if (copy_from_user(&args, (void __user *)regs->sp, sizeof(args)))
+		goto sigill;
+
+	ip = regs->ip;
+
+	/*
+	 * Expose the "right" values of ax/r11/cx/ip/sp to uprobe_consumer/s:
+	 * the probe is at the call before the return address, and the stack
+	 * is back at what it was before the call.
+	 */
+	regs->ax  = args.ax;
+	regs->r11 = args.r11;
+	regs->cx  = args.cx;
+	regs->ip  = args.retaddr - CALL_INSN_SIZE;
+	regs->sp += sizeof(args);
+	regs->orig_ax = -1;
+
+	sp = regs->sp;
+
+	handle_syscall_uprobe(regs, regs->ip);
+
+	/*
+	 * Some of the uprobe consumers has changed sp, we can do nothing,
+	 * just return via iret, past the nop unless ip was changed too.
+	 */
+	if (regs->sp != sp) {
+		if (regs->ip == args.retaddr - CALL_INSN_SIZE)
+			regs->ip = args.retaddr;
+		return regs->ax;
+	}
+
+	regs->sp -= sizeof(args);
+
+	/* for the case uprobe_consumer has changed ax/r11/cx */
+	args.ax  = regs->ax;
+	args.r11 = regs->r11;
+	args.cx  = regs->cx;
+
+	/* return past the nop, unless uprobe_consumer has changed ip */
+	if (regs->ip != args.retaddr - CALL_INSN_SIZE)
+		args.retaddr = regs->ip;
+
+	regs->ip = ip;
+
+	if (copy_to_user((void __user *)regs->sp, &args, sizeof(args)))
+		goto sigill;
+
+	/* ensure sysret, see do_syscall_64() */
+	regs->r11 = regs->flags;
+	regs->cx  = regs->ip;
+
+	return regs->ax;
+
+sigill:
+	force_sig(SIGILL);
+	return -1;
+}
+
+static int copy_from_vaddr(struct mm_struct *mm, unsigned long vaddr, void *dst, int len)
+{
+	struct vm_area_struct *vma;
+	struct page *page;
+
+	page = get_user_page_vma_remote(mm, vaddr, FOLL_FORCE, &vma);
+	if (IS_ERR(page))
+		return PTR_ERR(page);
+
+	memcpy_from_page(dst, page, offset_in_page(vaddr), len);
+	put_page(page);
+	return 0;
+}
+
+/* Whether the 5 bytes at @vaddr are a call to an uprobe trampoline */
+static int is_optimized(struct mm_struct *mm, unsigned long vaddr)
+{
+	uprobe_opcode_t insn[CALL_INSN_SIZE];
+	struct vm_area_struct *vma;
+	unsigned long target;
+	int err;
+
+	err = copy_from_vaddr(mm, vaddr, insn, CALL_INSN_SIZE);
+	if (err)
+		return err;
+
+	if (insn[0] != CALL_INSN_OPCODE)
+		return 0;
+
+	target = vaddr + CALL_INSN_SIZE + *(s32 *)(insn + 1);
+	vma = vma_lookup(mm, target);
+
+	return vma && vma_is_special_mapping(vma, &tramp_mapping) &&
+	       target == vma->vm_start;
+}
+
+enum {
+	EXPECT_SWBP,
+	EXPECT_CALL,
+};
+
+struct write_opcode_ctx {
+	unsigned long base;
+	int expect;
+};
+
+static int verify_insn(struct page *page, unsigned long vaddr,
+		       uprobe_opcode_t *new_opcode, int nbytes, void *data)
+{
+	struct write_opcode_ctx *ctx = data;
+	uprobe_opcode_t old_opcode;
+
+	memcpy_from_page(&old_opcode, page, offset_in_page(ctx->base), 1);
+
+	switch (ctx->expect) {
+	case EXPECT_SWBP:
+		if (is_swbp_insn(&old_opcode))
+			return 1;
+		break;
+	case EXPECT_CALL:
+		if (old_opcode == CALL_INSN_OPCODE)
+			return 1;
+		break;
+	}
+
+	return -EINVAL;
+}
+
+static int write_insn(struct arch_uprobe *auprobe, struct mm_struct *mm,
+		      unsigned long vaddr, uprobe_opcode_t *insn, int nbytes,
+		      struct write_opcode_ctx *ctx)
+{
+	return uprobe_write(auprobe, mm, vaddr, insn, nbytes, verify_insn,
+			    true /* is_register */, false /* do_update_ref_ctr */,
+			    ctx);
+}
+
+/*
+ * The breakpoint keeps other threads off the rest of the nop while the
+ * call offset is written behind it, and only then is the breakpoint
+ * turned into the call. All CPUs are serialized after each step, as in
+ * text_poke_bp(), so none of them can run a mix of old and new bytes.
+ */
+static int swbp_optimize(struct arch_uprobe *auprobe, struct mm_struct *mm,
+			 unsigned long vaddr, unsigned long tramp)
+{
+	struct write_opcode_ctx ctx = {
+		.base = vaddr,
+		.expect = EXPECT_SWBP,
+	};
+	uprobe_opcode_t call[CALL_INSN_SIZE];
+	int err;
+
+	__text_gen_insn(call, CALL_INSN_OPCODE, (void *)vaddr, (void *)tramp,
+			CALL_INSN_SIZE);
+
+	err = write_insn(auprobe, mm, vaddr + 1, call + 1, CALL_INSN_SIZE - 1, &ctx);
+	if (err)
+		return err;
+
+	text_poke_sync();
+
+	err = write_insn(auprobe, mm, vaddr, call, 1, &ctx);
+	if (err) {
+		/* Put back the original tail, which set_orig_insn() won't do */
+		write_insn(auprobe, mm, vaddr + 1, auprobe->insn + 1,
+			   CALL_INSN_SIZE - 1, &ctx);
+		return err;
+	}
+
+	text_poke_sync();
+	return 0;
+}
+
+/* The reverse of swbp_optimize(), leaves the breakpoint in place */
+static int swbp_unoptimize(struct arch_uprobe *auprobe, struct mm_struct *mm,
+			   unsigned long vaddr)
+{
+	uprobe_opcode_t int3 = UPROBE_SWBP_INSN;
+	struct write_opcode_ctx ctx = {
+		.base = vaddr,
+		.expect = EXPECT_CALL,
+	};
+	int err;
+
+	err = write_insn(auprobe, mm, vaddr, &int3, 1, &ctx);
+	if (err)
+		return err;
+
+	text_poke_sync();
+
+	ctx.expect = EXPECT_SWBP;
+	err = write_insn(auprobe, mm, vaddr + 1, auprobe->insn + 1,
+			 CALL_INSN_SIZE - 1, &ctx);
+	if (err)
+		return err;
+
+	text_poke_sync();
+	return 0;
+}
+
+int set_swbp(struct arch_uprobe *auprobe, struct mm_struct *mm, unsigned long vaddr)
+{
+	if (test_bit(ARCH_UPROBE_FLAG_CAN_OPTIMIZE, &auprobe->flags)) {
+		int ret = is_optimized(mm, vaddr);
+
+		if (ret < 0)
+			return ret;
+		/* already installed */
+		if (ret)
+			return 0;
+	}
+	return uprobe_write_opcode(auprobe, mm, vaddr, UPROBE_SWBP_INSN);
+}
+
+int set_orig_insn(struct arch_uprobe *auprobe, struct mm_struct *mm, unsigned long vaddr)
+{
+	if (test_bit(ARCH_UPROBE_FLAG_CAN_OPTIMIZE, &auprobe->flags)) {
+		int ret = is_optimized(mm, vaddr);
+
+		if (ret < 0)
+			return ret;
+		if (ret) {
+			ret = swbp_unoptimize(auprobe, mm, vaddr);
+			WARN_ON_ONCE(ret);
+			if (ret)
+				return ret;
+		}
+	}
+	return uprobe_write_opcode(auprobe, mm, vaddr,
+				   *(uprobe_opcode_t *)&auprobe->insn);
+}
+
+static bool should_optimize(struct arch_uprobe *auprobe, unsigned long vaddr)
+{
+	if (!test_bit(ARCH_UPROBE_FLAG_CAN_OPTIMIZE, &auprobe->flags) ||
+	    test_bit(ARCH_UPROBE_FLAG_OPTIMIZE_FAIL, &auprobe->flags))
+		return false;
+
+	if (!uprobe_tramp_pages[0] || !user_64bit_mode(task_pt_regs(current)))
+		return false;
+
+	/* Returning from the trampoline would not match the shadow stack */
+	if (shstk_is_enabled())
+		return false;
+
+	return offset_in_page(vaddr) + CALL_INSN_SIZE <= PAGE_SIZE;
+}
+
+void arch_uprobe_optimize(struct arch_uprobe *auprobe, unsigned long vaddr)
+{
+	struct mm_struct *mm = current->mm;
+	struct uprobe_trampoline *tramp;
+	uprobe_opcode_t insn;
+
+	if (!should_optimize(auprobe, vaddr))
+		return;
+
+	mmap_write_lock(mm);
+
+	/* Removed, or optimized by another thread meanwhile */
+	if (copy_from_vaddr(mm, vaddr, &insn, 1) || !is_swbp_insn(&insn))
+		goto unlock;
+
+	tramp = get_uprobe_trampoline(vaddr);
+	if (!tramp || swbp_optimize(auprobe, mm, vaddr, tramp->vaddr))
+		set_bit(ARCH_UPROBE_FLAG_OPTIMIZE_FAIL, &auprobe->flags);
+unlock:
+	mmap_write_unlock(mm);
+}
+
+static void uprobe_analyze_optimize(struct arch_uprobe *auprobe, struct insn *insn,
+				    struct mm_struct *mm)
+{
+	static const u8 nop5[] = { BYTES_NOP5 };
+
+	if (is_64bit_mm(mm) && insn->length == sizeof(nop5) &&
+	    !memcmp(auprobe->insn, nop5, sizeof(nop5)))
+		set_bit(ARCH_UPROBE_FLAG_CAN_OPTIMIZE, &auprobe->flags);
+}
+
 SYSCALL_DEFINE0(uretprobe)
 {
 	struct pt_regs *regs = task_pt_regs(current);
 	unsigned long err, ip, sp, r11_cx_ax[3];
 
-	if (regs->ip != trampoline_check_ip())
+	if (regs->ip != trampoline_check_ip()) {
+		if (in_uprobe_trampoline(regs->ip))
+			return uprobe_syscall(regs);
 		goto sigill;
+	}
 
 	err = copy_from_user(r11_cx_ax, (void __user *)regs->sp, sizeof(r11_cx_ax));
 	if (err)
@@ -617,6 +1080,10 @@ static void riprel_pre_xol(struct arch_uprobe *auprobe, struct pt_regs *regs)
 static void riprel_post_xol(struct arch_uprobe *auprobe, struct pt_regs *regs)
 {
 }
+static void uprobe_analyze_optimize(struct arch_uprobe *auprobe, struct insn *insn,
+				    struct mm_struct *mm)
+{
+}
 #endif /* CONFIG_X86_64 */
 
 struct uprobe_xol_ops {
@@ -978,6 +1445,8 @@ int arch_uprobe_analyze_insn(struct arch_uprobe *auprobe, struct mm_struct *mm,
 	if (ret)
 		return ret;
 
+	uprobe_analyze_optimize(auprobe, &insn, mm);
+
 	ret = branch_setup_xol_ops(auprobe, &insn);
 	if (ret != -ENOSYS)
 		return ret;
@@ -161,7 +161,8 @@ static inline u32 kvm_x2apic_id(struct kvm_lapic *apic)
 static bool kvm_can_post_timer_interrupt(struct kvm_vcpu *vcpu)
 {
 	return pi_inject_timer && kvm_vcpu_apicv_active(vcpu) &&
-		(kvm_mwait_in_guest(vcpu->kvm) || kvm_hlt_in_guest(vcpu->kvm));
+		(READ_ONCE(pi_inject_timer_always) ||
+		 kvm_mwait_in_guest(vcpu->kvm) || kvm_hlt_in_guest(vcpu->kvm));
 }
 
 bool kvm_can_use_hv_timer(struct kvm_vcpu *vcpu)
@@ -1936,6 +1937,8 @@ static void apic_timer_expired(struct kvm_lapic *apic, bool from_timer_fn)
 		    vcpu->arch.apic->lapic_timer.timer_advance_ns)
 			__kvm_wait_lapic_expire(vcpu);
 		kvm_apic_inject_pending_timer_irqs(apic);
+		/* Delivered without kicking the vCPU out of the guest */
+		atomic64_inc(&vcpu->kvm->stat.lapic_timer_posted);
 		return;
 	}
 
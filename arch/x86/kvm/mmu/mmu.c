@@ -6884,9 +6884,7 @@ void kvm_mmu_slot_try_split_huge_pages(struct kvm *kvm,
 		write_unlock(&kvm->mmu_lock);
 	}
 
-	read_lock(&kvm->mmu_lock);
-	kvm_tdp_mmu_try_split_huge_pages(kvm, memslot, start, end, target_level, true);
-	read_unlock(&kvm->mmu_lock);
+	kvm_tdp_mmu_slot_try_split_huge_pages(kvm, memslot, start, end, target_level);
 
 	/*
 	 * No TLB flush is necessary here. KVM will flush TLBs after
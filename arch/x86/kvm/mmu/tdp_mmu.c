@@ -8,6 +8,9 @@
 #include "tdp_mmu.h"
 #include "spte.h"
 
+#include <linux/memcontrol.h>
+#include <linux/sched/mm.h>
+
 #include <asm/cmpxchg.h>
 #include <trace/events/kvm.h>
 
@@ -1507,6 +1510,7 @@ static int tdp_mmu_split_huge_page(struct kvm *kvm, struct tdp_iter *iter,
 	 * the page stats with the new present child pages.
 	 */
 	kvm_update_page_stats(kvm, level - 1, SPTE_ENT_PER_PAGE);
+	atomic64_inc(&kvm->stat.eager_split_pages);
 
 out:
 	trace_kvm_mmu_split_huge_page(iter->gfn, huge_spte, level, ret);
@@ -1592,6 +1596,26 @@ static int tdp_mmu_split_huge_pages_root(struct kvm *kvm,
 }
 
 
+static int __kvm_tdp_mmu_try_split_huge_pages(struct kvm *kvm,
+					      const struct kvm_memory_slot *slot,
+					      gfn_t start, gfn_t end,
+					      int target_level, bool shared)
+{
+	struct kvm_mmu_page *root;
+	int r = 0;
+
+	kvm_lockdep_assert_mmu_lock_held(kvm, shared);
+	for_each_valid_tdp_mmu_root_yield_safe(kvm, root, slot->as_id) {
+		r = tdp_mmu_split_huge_pages_root(kvm, root, start, end, target_level, shared);
+		if (r) {
+			kvm_tdp_mmu_put_root(kvm, root);
+			break;
+		}
+	}
+
+	return r;
+}
+
 /*
  * Try to split all huge pages mapped by the TDP MMU down to the target level.
  */
@@ -1600,17 +1624,130 @@ void kvm_tdp_mmu_try_split_huge_pages(struct kvm *kvm,
 				      gfn_t start, gfn_t end,
 				      int target_level, bool shared)
 {
-	struct kvm_mmu_page *root;
-	int r = 0;
+	__kvm_tdp_mmu_try_split_huge_pages(kvm, slot, start, end, target_level,
+					   shared);
+}
 
-	kvm_lockdep_assert_mmu_lock_held(kvm, shared);
-	for_each_valid_tdp_mmu_root_yield_safe(kvm, root, slot->as_id) {
-		r = tdp_mmu_split_huge_pages_root(kvm, root, start, end, target_level, shared);
+/*
+ * Splitting a memslot is handed out in 1GiB aligned chunks, so that no two
+ * workers ever split the same huge page, and small enough that the workers
+ * finish at about the same time.
+ */
+#define TDP_MMU_SPLIT_CHUNK	(4 * KVM_PAGES_PER_HPAGE(PG_LEVEL_1G))
+
+struct tdp_mmu_split_ctx {
+	struct kvm *kvm;
+	const struct kvm_memory_slot *slot;
+	struct mem_cgroup *memcg;
+	atomic64_t next;
+	gfn_t start, end;
+	int target_level;
+};
+
+struct tdp_mmu_split_worker {
+	struct work_struct work;
+	struct tdp_mmu_split_ctx *ctx;
+};
+
+static void tdp_mmu_split_chunks(struct tdp_mmu_split_ctx *ctx)
+{
+	struct kvm *kvm = ctx->kvm;
+	gfn_t start, end;
+	int r;
+
+	for (;;) {
+		start = atomic64_fetch_add(TDP_MMU_SPLIT_CHUNK, &ctx->next);
+		if (start >= ctx->end)
+			break;
+
+		end = min(start + TDP_MMU_SPLIT_CHUNK, ctx->end);
+		start = max(start, ctx->start);
+
+		/*
+		 * Take mmu_lock per chunk, vCPUs faulting in the rest of the
+		 * memslot only contend with the chunks being split, and the
+		 * walk yields to pending writers via tdp_mmu_iter_cond_resched().
+		 */
+		read_lock(&kvm->mmu_lock);
+		r = __kvm_tdp_mmu_try_split_huge_pages(kvm, ctx->slot, start, end,
+						       ctx->target_level, true);
+		read_unlock(&kvm->mmu_lock);
+
+		/* Out of memory, the other workers would not fare any better */
 		if (r) {
-			kvm_tdp_mmu_put_root(kvm, root);
+			atomic64_set(&ctx->next, ctx->end);
 			break;
 		}
+
+		cond_resched();
+	}
+}
+
+static void tdp_mmu_split_work(struct work_struct *work)
+{
+	struct tdp_mmu_split_worker *worker;
+	struct mem_cgroup *old_memcg;
+
+	worker = container_of(work, struct tdp_mmu_split_worker, work);
+
+	/* Charge the page tables to the VM, not to the kworker */
+	old_memcg = set_active_memcg(worker->ctx->memcg);
+	tdp_mmu_split_chunks(worker->ctx);
+	set_active_memcg(old_memcg);
+}
+
+/*
+ * Split all huge pages mapped by the TDP MMU in [start, end) of a memslot
+ * down to the target level, spreading large memslots across several
+ * workers. Must be called without mmu_lock held, which is taken for read.
+ */
+void kvm_tdp_mmu_slot_try_split_huge_pages(struct kvm *kvm,
+					   const struct kvm_memory_slot *slot,
+					   gfn_t start, gfn_t end,
+					   int target_level)
+{
+	struct tdp_mmu_split_worker *workers = NULL;
+	struct tdp_mmu_split_ctx ctx = {
+		.kvm = kvm,
+		.slot = slot,
+		.next = ATOMIC64_INIT(ALIGN_DOWN(start, TDP_MMU_SPLIT_CHUNK)),
+		.start = start,
+		.end = end,
+		.target_level = target_level,
+	};
+	unsigned int nr_workers, i;
+	u64 start_ns = ktime_get_ns();
+
+	nr_workers = DIV_ROUND_UP(end - ALIGN_DOWN(start, TDP_MMU_SPLIT_CHUNK),
+				  TDP_MMU_SPLIT_CHUNK);
+	nr_workers = min(nr_workers, num_online_cpus());
+	if (READ_ONCE(eager_page_split_workers))
+		nr_workers = min(nr_workers, READ_ONCE(eager_page_split_workers));
+
+	/* The caller is worker 0 */
+	if (nr_workers > 1)
+		workers = kcalloc(nr_workers - 1, sizeof(*workers),
+				  GFP_KERNEL_ACCOUNT);
+	if (!workers)
+		nr_workers = 1;
+	else
+		ctx.memcg = get_mem_cgroup_from_current();
+
+	for (i = 0; i < nr_workers - 1; i++) {
+		workers[i].ctx = &ctx;
+		INIT_WORK(&workers[i].work, tdp_mmu_split_work);
+		queue_work(system_unbound_wq, &workers[i].work);
 	}
+
+	tdp_mmu_split_chunks(&ctx);
+
+	for (i = 0; i < nr_workers - 1; i++)
+		flush_work(&workers[i].work);
+	kfree(workers);
+	mem_cgroup_put(ctx.memcg);
+
+	/* Serialized by slots_lock */
+	kvm->stat.eager_split_ns += ktime_get_ns() - start_ns;
 }
 
 static bool tdp_mmu_need_write_protect(struct kvm_mmu_page *sp)
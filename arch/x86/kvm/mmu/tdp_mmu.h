@@ -96,6 +96,10 @@ void kvm_tdp_mmu_try_split_huge_pages(struct kvm *kvm,
 				      const struct kvm_memory_slot *slot,
 				      gfn_t start, gfn_t end,
 				      int target_level, bool shared);
+void kvm_tdp_mmu_slot_try_split_huge_pages(struct kvm *kvm,
+					   const struct kvm_memory_slot *slot,
+					   gfn_t start, gfn_t end,
+					   int target_level);
 
 static inline void kvm_tdp_mmu_walk_lockless_begin(void)
 {
@@ -183,6 +183,14 @@ module_param(force_emulation_prefix, int, 0644);
 int __read_mostly pi_inject_timer = -1;
 module_param(pi_inject_timer, bint, 0644);
 
+/*
+ * Post timer interrupts even if the vCPU does not own its CPU, i.e. if HLT
+ * and MWAIT exit; the hrtimer then no longer follows the vCPU and expires on
+ * the CPU that armed it, or on a housekeeping CPU for nohz_full vCPUs.
+ */
+bool __read_mostly pi_inject_timer_always;
+module_param(pi_inject_timer_always, bool, 0644);
+
 /* Enable/disable PMU virtualization */
 bool __read_mostly enable_pmu = true;
 EXPORT_SYMBOL_GPL(enable_pmu);
@@ -191,6 +199,10 @@ module_param(enable_pmu, bool, 0444);
 bool __read_mostly eager_page_split = true;
 module_param(eager_page_split, bool, 0644);
 
+/* Number of threads splitting the huge pages of a memslot, 0 for no limit */
+uint __read_mostly eager_page_split_workers = 8;
+module_param(eager_page_split_workers, uint, 0644);
+
 /* Enable/disable SMT_RSB bug mitigation */
 static bool __read_mostly mitigate_smt_rsb;
 module_param(mitigate_smt_rsb, bool, 0444);
@@ -240,6 +252,9 @@ const struct _kvm_stats_desc kvm_vm_stats_desc[] = {
 	STATS_DESC_ICOUNTER(VM, pages_2m),
 	STATS_DESC_ICOUNTER(VM, pages_1g),
 	STATS_DESC_ICOUNTER(VM, nx_lpage_splits),
+	STATS_DESC_COUNTER(VM, lapic_timer_posted),
+	STATS_DESC_COUNTER(VM, eager_split_pages),
+	STATS_DESC_TIME_NSEC(VM, eager_split_ns),
 	STATS_DESC_PCOUNTER(VM, max_mmu_rmap_size),
 	STATS_DESC_PCOUNTER(VM, max_mmu_page_hash_collisions)
 };
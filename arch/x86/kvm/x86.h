@@ -431,10 +431,12 @@ extern unsigned int min_timer_period_us;
 extern bool enable_vmware_backdoor;
 
 extern int pi_inject_timer;
+extern bool pi_inject_timer_always;
 
 extern bool report_ignored_msrs;
 
 extern bool eager_page_split;
+extern uint eager_page_split_workers;
 
 static inline void kvm_pr_unimpl_wrmsr(struct kvm_vcpu *vcpu, u32 msr, u64 data)
 {
@@ -1513,6 +1513,7 @@ void bio_endio(struct bio *bio)
 	blk_zone_bio_endio(bio);
 
 	rq_qos_done_bio(bio);
+	blk_cgroup_bio_done(bio);
 
 	if (bio->bi_bdev && bio_flagged(bio, BIO_TRACE_COMPLETION)) {
 		trace_block_bio_complete(bdev_get_queue(bio->bi_bdev), bio);
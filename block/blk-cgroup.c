@@ -142,6 +142,9 @@ static void blkg_free_workfn(struct work_struct *work)
 	mutex_unlock(&q->blkcg_mutex);
 
 	blk_put_queue(q);
+#ifdef CONFIG_BLK_CGROUP_LATENCY_HIST
+	free_percpu(blkg->lat_hist);
+#endif
 	free_percpu(blkg->iostat_cpu);
 	percpu_ref_exit(&blkg->refcnt);
 	kfree(blkg);
@@ -316,6 +319,14 @@ static struct blkcg_gq *blkg_alloc(struct blkcg *blkcg, struct gendisk *disk,
 	blkg->iostat_cpu = alloc_percpu_gfp(struct blkg_iostat_set, gfp_mask);
 	if (!blkg->iostat_cpu)
 		goto out_exit_refcnt;
+#ifdef CONFIG_BLK_CGROUP_LATENCY_HIST
+	if (blkcg != &blkcg_root) {
+		blkg->lat_hist = alloc_percpu_gfp(struct blkg_lat_hist,
+						  gfp_mask);
+		if (!blkg->lat_hist)
+			goto out_free_iostat;
+	}
+#endif
 	if (!blk_get_queue(disk->queue))
 		goto out_free_iostat;
 
@@ -360,6 +371,9 @@ static struct blkcg_gq *blkg_alloc(struct blkcg *blkcg, struct gendisk *disk,
 			blkcg_policy[i]->pd_free_fn(blkg->pd[i]);
 	blk_put_queue(disk->queue);
 out_free_iostat:
+#ifdef CONFIG_BLK_CGROUP_LATENCY_HIST
+	free_percpu(blkg->lat_hist);
+#endif
 	free_percpu(blkg->iostat_cpu);
 out_exit_refcnt:
 	percpu_ref_exit(&blkg->refcnt);
@@ -1213,11 +1227,77 @@ static int blkcg_print_stat(struct seq_file *sf, void *v)
 	return 0;
 }
 
+#ifdef CONFIG_BLK_CGROUP_LATENCY_HIST
+static void blkcg_print_one_latency_hist(struct blkcg_gq *blkg,
+					 struct seq_file *s)
+{
+	static const char * const names[BLKG_IOSTAT_NR] = {
+		[BLKG_IOSTAT_READ]	= "read",
+		[BLKG_IOSTAT_WRITE]	= "write",
+		[BLKG_IOSTAT_DISCARD]	= "discard",
+	};
+	unsigned long hist[BLKG_LAT_HIST_BUCKETS];
+	const char *dname;
+	int rwd, cpu, i;
+
+	if (!blkg->online || !blkg->lat_hist)
+		return;
+
+	dname = blkg_dev_name(blkg);
+	if (!dname)
+		return;
+
+	for (rwd = 0; rwd < BLKG_IOSTAT_NR; rwd++) {
+		unsigned long total = 0;
+
+		memset(hist, 0, sizeof(hist));
+		for_each_possible_cpu(cpu) {
+			struct blkg_lat_hist *lh = per_cpu_ptr(blkg->lat_hist, cpu);
+
+			for (i = 0; i < BLKG_LAT_HIST_BUCKETS; i++)
+				hist[i] += READ_ONCE(lh->buckets[rwd][i]);
+		}
+		for (i = 0; i < BLKG_LAT_HIST_BUCKETS; i++)
+			total += hist[i];
+		if (!total)
+			continue;
+
+		/* "<dev> <op> <usecs>=<bios below that> ... max=<bios>" */
+		seq_printf(s, "%s %s", dname, names[rwd]);
+		for (i = 0; i < BLKG_LAT_HIST_BUCKETS - 1; i++)
+			seq_printf(s, " %lu=%lu", 1UL << i, hist[i]);
+		seq_printf(s, " max=%lu\n", hist[i]);
+	}
+}
+
+static int blkcg_print_latency_hist(struct seq_file *sf, void *v)
+{
+	struct blkcg *blkcg = css_to_blkcg(seq_css(sf));
+	struct blkcg_gq *blkg;
+
+	rcu_read_lock();
+	hlist_for_each_entry_rcu(blkg, &blkcg->blkg_list, blkcg_node) {
+		spin_lock_irq(&blkg->q->queue_lock);
+		blkcg_print_one_latency_hist(blkg, sf);
+		spin_unlock_irq(&blkg->q->queue_lock);
+	}
+	rcu_read_unlock();
+	return 0;
+}
+#endif
+
 static struct cftype blkcg_files[] = {
 	{
 		.name = "stat",
 		.seq_show = blkcg_print_stat,
 	},
+#ifdef CONFIG_BLK_CGROUP_LATENCY_HIST
+	{
+		.name = "latency_hist",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.seq_show = blkcg_print_latency_hist,
+	},
+#endif
 	{ }	/* terminate */
 };
 
@@ -2190,6 +2270,23 @@ void blk_cgroup_bio_start(struct bio *bio)
 	put_cpu();
 }
 
+#ifdef CONFIG_BLK_CGROUP_LATENCY_HIST
+/* Account the completion latency of @bio in io.latency_hist */
+void __blk_cgroup_bio_done(struct bio *bio)
+{
+	u64 issue = bio_issue_time(&bio->bi_issue), now, lat;
+
+	/* never went through submit_bio() */
+	if (!issue || !cgroup_subsys_on_dfl(io_cgrp_subsys))
+		return;
+
+	now = __bio_issue_time(blk_time_get_ns());
+	lat = now > issue ? div_u64(now - issue, NSEC_PER_USEC) : 0;
+	this_cpu_inc(bio->bi_blkg->lat_hist->buckets[blk_cgroup_io_type(bio)]
+		     [min(fls64(lat), BLKG_LAT_HIST_BUCKETS - 1)]);
+}
+#endif
+
 bool blk_cgroup_congested(void)
 {
 	struct blkcg *blkcg;
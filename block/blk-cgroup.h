@@ -52,6 +52,13 @@ struct blkg_iostat_set {
 	struct blkg_iostat		last;
 };
 
+/* bucket i counts latencies below 2^i usecs, the last one all others */
+#define BLKG_LAT_HIST_BUCKETS		25
+
+struct blkg_lat_hist {
+	unsigned long			buckets[BLKG_IOSTAT_NR][BLKG_LAT_HIST_BUCKETS];
+};
+
 /* association between a blk cgroup and a request queue */
 struct blkcg_gq {
 	/* Pointer to the associated request_queue */
@@ -71,6 +78,10 @@ struct blkcg_gq {
 
 	struct blkg_iostat_set __percpu	*iostat_cpu;
 	struct blkg_iostat_set		iostat;
+#ifdef CONFIG_BLK_CGROUP_LATENCY_HIST
+	/* io.latency_hist, not allocated for the root blkcg */
+	struct blkg_lat_hist __percpu	*lat_hist;
+#endif
 
 	struct blkg_policy_data		*pd[BLKCG_MAX_POLS];
 #ifdef CONFIG_BLK_CGROUP_PUNT_BIO
@@ -459,6 +470,18 @@ static inline bool blk_cgroup_mergeable(struct request *rq, struct bio *bio)
 
 void blk_cgroup_bio_start(struct bio *bio);
 void blkcg_add_delay(struct blkcg_gq *blkg, u64 now, u64 delta);
+
+#ifdef CONFIG_BLK_CGROUP_LATENCY_HIST
+void __blk_cgroup_bio_done(struct bio *bio);
+
+static inline void blk_cgroup_bio_done(struct bio *bio)
+{
+	if (bio->bi_blkg && bio->bi_blkg->lat_hist)
+		__blk_cgroup_bio_done(bio);
+}
+#else
+static inline void blk_cgroup_bio_done(struct bio *bio) { }
+#endif
 #else	/* CONFIG_BLK_CGROUP */
 
 struct blkg_policy_data {
@@ -491,6 +514,7 @@ static inline void blkg_get(struct blkcg_gq *blkg) { }
 static inline void blkg_put(struct blkcg_gq *blkg) { }
 static inline void blkcg_bio_issue_init(struct bio *bio) { }
 static inline void blk_cgroup_bio_start(struct bio *bio) { }
+static inline void blk_cgroup_bio_done(struct bio *bio) { }
 static inline bool blk_cgroup_mergeable(struct request *rq, struct bio *bio) { return true; }
 
 #define blk_queue_for_each_rl(rl, q)	\
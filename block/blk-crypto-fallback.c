@@ -18,6 +18,7 @@
 #include <linux/module.h>
 #include <linux/random.h>
 #include <linux/scatterlist.h>
+#include <linux/sizes.h>
 
 #include "blk-cgroup.h"
 #include "blk-crypto-internal.h"
@@ -37,6 +38,19 @@ module_param(num_prealloc_fallback_crypt_ctxs, uint, 0);
 MODULE_PARM_DESC(num_prealloc_crypt_fallback_ctxs,
 		 "Number of preallocated bio fallback crypto contexts for blk-crypto to use during crypto API fallback");
 
+/*
+ * Bios are en/decrypted in chunks of at least this size, each of which may be
+ * processed on a different CPU.
+ */
+#define BLK_CRYPTO_FALLBACK_CHUNK_SIZE	SZ_64K
+
+static unsigned int blk_crypto_parallel_cpus;
+static const struct kernel_param_ops blk_crypto_parallel_cpus_ops;
+module_param_cb(parallel_cpus, &blk_crypto_parallel_cpus_ops,
+		&blk_crypto_parallel_cpus, 0644);
+MODULE_PARM_DESC(parallel_cpus,
+		 "Maximum number of CPUs used for the blk-crypto crypto API fallback (0 for all online CPUs)");
+
 struct bio_fallback_crypt_ctx {
 	struct bio_crypt_ctx crypt_ctx;
 	/*
@@ -72,6 +86,7 @@ static mempool_t *bio_fallback_crypt_ctx_pool;
  */
 static DEFINE_MUTEX(tfms_init_lock);
 static bool tfms_inited[BLK_ENCRYPTION_MODE_MAX];
+static bool blk_crypto_fallback_inited;
 
 static struct blk_crypto_fallback_keyslot {
 	enum blk_crypto_mode_num crypto_mode;
@@ -80,6 +95,7 @@ static struct blk_crypto_fallback_keyslot {
 
 static struct blk_crypto_profile *blk_crypto_fallback_profile;
 static struct workqueue_struct *blk_crypto_wq;
+static struct workqueue_struct *blk_crypto_chunk_wq;
 static mempool_t *blk_crypto_bounce_page_pool;
 static struct bio_set crypto_bio_split;
 
@@ -252,6 +268,196 @@ static void blk_crypto_dun_to_iv(const u64 dun[BLK_CRYPTO_DUN_ARRAY_SIZE],
 		iv->dun[i] = cpu_to_le64(dun[i]);
 }
 
+static unsigned int blk_crypto_max_parallel_cpus(void)
+{
+	unsigned int nr = READ_ONCE(blk_crypto_parallel_cpus);
+
+	return nr ? min(nr, num_online_cpus()) : num_online_cpus();
+}
+
+static int blk_crypto_parallel_cpus_set(const char *val,
+					const struct kernel_param *kp)
+{
+	unsigned int nr;
+	int ret;
+
+	ret = kstrtouint(val, 0, &nr);
+	if (ret)
+		return ret;
+
+	mutex_lock(&tfms_init_lock);
+	WRITE_ONCE(blk_crypto_parallel_cpus, nr);
+	if (blk_crypto_fallback_inited) {
+		workqueue_set_max_active(blk_crypto_wq,
+					 blk_crypto_max_parallel_cpus());
+		workqueue_set_max_active(blk_crypto_chunk_wq,
+					 blk_crypto_max_parallel_cpus());
+	}
+	mutex_unlock(&tfms_init_lock);
+
+	return 0;
+}
+
+static const struct kernel_param_ops blk_crypto_parallel_cpus_ops = {
+	.set	= blk_crypto_parallel_cpus_set,
+	.get	= param_get_uint,
+};
+
+/*
+ * The en/decryption of the data units of @src into @dst, which may be split in
+ * chunks processed in parallel, see blk_crypto_fallback_crypt().
+ */
+struct blk_crypto_fallback_crypt {
+	struct blk_crypto_keyslot *slot;
+	unsigned int data_unit_size;
+	bool encrypt;
+	struct bio *src;
+	struct bio *dst;
+	atomic_t pending;
+	struct completion done;
+	blk_status_t status;
+};
+
+struct blk_crypto_fallback_chunk {
+	struct work_struct work;
+	struct blk_crypto_fallback_crypt *crypt;
+	struct bvec_iter src_iter;
+	struct bvec_iter dst_iter;
+	u64 dun[BLK_CRYPTO_DUN_ARRAY_SIZE];
+};
+
+/* En/decrypt the data units of @src_iter into @dst_iter, starting at @dun */
+static void blk_crypto_fallback_crypt_chunk(struct blk_crypto_fallback_crypt *c,
+					    struct bvec_iter src_iter,
+					    struct bvec_iter dst_iter,
+					    u64 dun[BLK_CRYPTO_DUN_ARRAY_SIZE])
+{
+	const unsigned int data_unit_size = c->data_unit_size;
+	struct skcipher_request *ciph_req = NULL;
+	DECLARE_CRYPTO_WAIT(wait);
+	struct scatterlist src, dst;
+	union blk_crypto_iv iv;
+	blk_status_t status = BLK_STS_OK;
+
+	if (!blk_crypto_fallback_alloc_cipher_req(c->slot, &ciph_req, &wait)) {
+		status = BLK_STS_RESOURCE;
+		goto out;
+	}
+
+	sg_init_table(&src, 1);
+	sg_init_table(&dst, 1);
+	/* Decryption is done in place */
+	skcipher_request_set_crypt(ciph_req, &src,
+				   c->src == c->dst ? &src : &dst,
+				   data_unit_size, iv.bytes);
+
+	while (src_iter.bi_size) {
+		struct bio_vec src_bv = bio_iter_iovec(c->src, src_iter);
+		struct bio_vec dst_bv = bio_iter_iovec(c->dst, dst_iter);
+		int err;
+
+		sg_set_page(&src, src_bv.bv_page, data_unit_size,
+			    src_bv.bv_offset);
+		sg_set_page(&dst, dst_bv.bv_page, data_unit_size,
+			    dst_bv.bv_offset);
+
+		blk_crypto_dun_to_iv(dun, &iv);
+		if (c->encrypt)
+			err = crypto_skcipher_encrypt(ciph_req);
+		else
+			err = crypto_skcipher_decrypt(ciph_req);
+		if (crypto_wait_req(err, &wait)) {
+			status = BLK_STS_IOERR;
+			break;
+		}
+		bio_crypt_dun_increment(dun, 1);
+
+		bvec_iter_advance(c->src->bi_io_vec, &src_iter, data_unit_size);
+		bvec_iter_advance(c->dst->bi_io_vec, &dst_iter, data_unit_size);
+	}
+
+	skcipher_request_free(ciph_req);
+out:
+	if (status)
+		WRITE_ONCE(c->status, status);
+	if (atomic_dec_and_test(&c->pending))
+		complete(&c->done);
+}
+
+static void blk_crypto_fallback_chunk_workfn(struct work_struct *work)
+{
+	struct blk_crypto_fallback_chunk *chunk =
+		container_of(work, struct blk_crypto_fallback_chunk, work);
+
+	blk_crypto_fallback_crypt_chunk(chunk->crypt, chunk->src_iter,
+					chunk->dst_iter, chunk->dun);
+}
+
+/*
+ * En/decrypt the data units of @c->src described by @src_iter into those of
+ * @c->dst described by @dst_iter, starting at @dun.
+ *
+ * Bios larger than BLK_CRYPTO_FALLBACK_CHUNK_SIZE are split in up to
+ * parallel_cpus chunks. All of them but the first one are queued on
+ * blk_crypto_chunk_wq, the first one is processed by the caller, which then
+ * waits for the others. blk_crypto_chunk_wq is separate from blk_crypto_wq as
+ * blk_crypto_fallback_decrypt_bio() waits for chunks from there.
+ */
+static blk_status_t
+blk_crypto_fallback_crypt(struct blk_crypto_fallback_crypt *c,
+			  struct bvec_iter src_iter, struct bvec_iter dst_iter,
+			  const u64 dun[BLK_CRYPTO_DUN_ARRAY_SIZE])
+{
+	unsigned int nr_units = src_iter.bi_size / c->data_unit_size;
+	struct blk_crypto_fallback_chunk *chunks = NULL;
+	struct bvec_iter first_src = src_iter, first_dst = dst_iter;
+	u64 curr_dun[BLK_CRYPTO_DUN_ARRAY_SIZE];
+	unsigned int nr, per_chunk, bytes, i;
+
+	nr = min(blk_crypto_max_parallel_cpus(),
+		 DIV_ROUND_UP(src_iter.bi_size, BLK_CRYPTO_FALLBACK_CHUNK_SIZE));
+	if (nr > 1) {
+		chunks = kcalloc(nr - 1, sizeof(*chunks), GFP_NOIO);
+		if (!chunks)
+			nr = 1;
+	}
+	per_chunk = max(DIV_ROUND_UP(nr_units, nr), 1U);
+	nr = max(DIV_ROUND_UP(nr_units, per_chunk), 1U);
+	bytes = per_chunk * c->data_unit_size;
+
+	atomic_set(&c->pending, nr);
+	init_completion(&c->done);
+	c->status = BLK_STS_OK;
+
+	memcpy(curr_dun, dun, sizeof(curr_dun));
+	for (i = 1; i < nr; i++) {
+		struct blk_crypto_fallback_chunk *chunk = &chunks[i - 1];
+
+		bvec_iter_advance(c->src->bi_io_vec, &src_iter, bytes);
+		bvec_iter_advance(c->dst->bi_io_vec, &dst_iter, bytes);
+		bio_crypt_dun_increment(curr_dun, per_chunk);
+
+		chunk->crypt = c;
+		chunk->src_iter = src_iter;
+		chunk->src_iter.bi_size = min(src_iter.bi_size, bytes);
+		chunk->dst_iter = dst_iter;
+		chunk->dst_iter.bi_size = chunk->src_iter.bi_size;
+		memcpy(chunk->dun, curr_dun, sizeof(curr_dun));
+		INIT_WORK(&chunk->work, blk_crypto_fallback_chunk_workfn);
+		queue_work(blk_crypto_chunk_wq, &chunk->work);
+	}
+
+	memcpy(curr_dun, dun, sizeof(curr_dun));
+	first_src.bi_size = min(first_src.bi_size, bytes);
+	first_dst.bi_size = first_src.bi_size;
+	blk_crypto_fallback_crypt_chunk(c, first_src, first_dst, curr_dun);
+
+	wait_for_completion(&c->done);
+	kfree(chunks);
+
+	return c->status;
+}
+
 /*
  * The crypto API fallback's encryption routine.
  * Allocate a bounce bio for encryption, encrypt the input bio using crypto API,
@@ -264,13 +470,9 @@ static bool blk_crypto_fallback_encrypt_bio(struct bio **bio_ptr)
 	struct bio *src_bio, *enc_bio;
 	struct bio_crypt_ctx *bc;
 	struct blk_crypto_keyslot *slot;
+	struct blk_crypto_fallback_crypt crypt;
 	int data_unit_size;
-	struct skcipher_request *ciph_req = NULL;
-	DECLARE_CRYPTO_WAIT(wait);
-	u64 curr_dun[BLK_CRYPTO_DUN_ARRAY_SIZE];
-	struct scatterlist src, dst;
-	union blk_crypto_iv iv;
-	unsigned int i, j;
+	unsigned int i;
 	bool ret = false;
 	blk_status_t blk_st;
 
@@ -300,51 +502,29 @@ static bool blk_crypto_fallback_encrypt_bio(struct bio **bio_ptr)
 		goto out_put_enc_bio;
 	}
 
-	/* and then allocate an skcipher_request for it */
-	if (!blk_crypto_fallback_alloc_cipher_req(slot, &ciph_req, &wait)) {
-		src_bio->bi_status = BLK_STS_RESOURCE;
-		goto out_release_keyslot;
-	}
-
-	memcpy(curr_dun, bc->bc_dun, sizeof(curr_dun));
-	sg_init_table(&src, 1);
-	sg_init_table(&dst, 1);
-
-	skcipher_request_set_crypt(ciph_req, &src, &dst, data_unit_size,
-				   iv.bytes);
-
-	/* Encrypt each page in the bounce bio */
+	/* Allocate all the bounce pages before encrypting into them */
 	for (i = 0; i < enc_bio->bi_vcnt; i++) {
 		struct bio_vec *enc_bvec = &enc_bio->bi_io_vec[i];
-		struct page *plaintext_page = enc_bvec->bv_page;
 		struct page *ciphertext_page =
 			mempool_alloc(blk_crypto_bounce_page_pool, GFP_NOIO);
 
-		enc_bvec->bv_page = ciphertext_page;
-
 		if (!ciphertext_page) {
 			src_bio->bi_status = BLK_STS_RESOURCE;
 			goto out_free_bounce_pages;
 		}
+		enc_bvec->bv_page = ciphertext_page;
+	}
 
-		sg_set_page(&src, plaintext_page, data_unit_size,
-			    enc_bvec->bv_offset);
-		sg_set_page(&dst, ciphertext_page, data_unit_size,
-			    enc_bvec->bv_offset);
-
-		/* Encrypt each data unit in this page */
-		for (j = 0; j < enc_bvec->bv_len; j += data_unit_size) {
-			blk_crypto_dun_to_iv(curr_dun, &iv);
-			if (crypto_wait_req(crypto_skcipher_encrypt(ciph_req),
-					    &wait)) {
-				i++;
-				src_bio->bi_status = BLK_STS_IOERR;
-				goto out_free_bounce_pages;
-			}
-			bio_crypt_dun_increment(curr_dun, 1);
-			src.offset += data_unit_size;
-			dst.offset += data_unit_size;
-		}
+	crypt.slot = slot;
+	crypt.data_unit_size = data_unit_size;
+	crypt.encrypt = true;
+	crypt.src = src_bio;
+	crypt.dst = enc_bio;
+	blk_st = blk_crypto_fallback_crypt(&crypt, src_bio->bi_iter,
+					   enc_bio->bi_iter, bc->bc_dun);
+	if (blk_st != BLK_STS_OK) {
+		src_bio->bi_status = blk_st;
+		goto out_free_bounce_pages;
 	}
 
 	enc_bio->bi_private = src_bio;
@@ -353,14 +533,12 @@ static bool blk_crypto_fallback_encrypt_bio(struct bio **bio_ptr)
 	ret = true;
 
 	enc_bio = NULL;
-	goto out_free_ciph_req;
+	goto out_release_keyslot;
 
 out_free_bounce_pages:
 	while (i > 0)
 		mempool_free(enc_bio->bi_io_vec[--i].bv_page,
 			     blk_crypto_bounce_page_pool);
-out_free_ciph_req:
-	skcipher_request_free(ciph_req);
 out_release_keyslot:
 	blk_crypto_put_keyslot(slot);
 out_put_enc_bio:
@@ -381,15 +559,7 @@ static void blk_crypto_fallback_decrypt_bio(struct work_struct *work)
 	struct bio *bio = f_ctx->bio;
 	struct bio_crypt_ctx *bc = &f_ctx->crypt_ctx;
 	struct blk_crypto_keyslot *slot;
-	struct skcipher_request *ciph_req = NULL;
-	DECLARE_CRYPTO_WAIT(wait);
-	u64 curr_dun[BLK_CRYPTO_DUN_ARRAY_SIZE];
-	union blk_crypto_iv iv;
-	struct scatterlist sg;
-	struct bio_vec bv;
-	struct bvec_iter iter;
-	const int data_unit_size = bc->bc_key->crypto_cfg.data_unit_size;
-	unsigned int i;
+	struct blk_crypto_fallback_crypt crypt;
 	blk_status_t blk_st;
 
 	/*
@@ -403,38 +573,17 @@ static void blk_crypto_fallback_decrypt_bio(struct work_struct *work)
 		goto out_no_keyslot;
 	}
 
-	/* and then allocate an skcipher_request for it */
-	if (!blk_crypto_fallback_alloc_cipher_req(slot, &ciph_req, &wait)) {
-		bio->bi_status = BLK_STS_RESOURCE;
-		goto out;
-	}
-
-	memcpy(curr_dun, bc->bc_dun, sizeof(curr_dun));
-	sg_init_table(&sg, 1);
-	skcipher_request_set_crypt(ciph_req, &sg, &sg, data_unit_size,
-				   iv.bytes);
-
-	/* Decrypt each segment in the bio */
-	__bio_for_each_segment(bv, bio, iter, f_ctx->crypt_iter) {
-		struct page *page = bv.bv_page;
-
-		sg_set_page(&sg, page, data_unit_size, bv.bv_offset);
-
-		/* Decrypt each data unit in the segment */
-		for (i = 0; i < bv.bv_len; i += data_unit_size) {
-			blk_crypto_dun_to_iv(curr_dun, &iv);
-			if (crypto_wait_req(crypto_skcipher_decrypt(ciph_req),
-					    &wait)) {
-				bio->bi_status = BLK_STS_IOERR;
-				goto out;
-			}
-			bio_crypt_dun_increment(curr_dun, 1);
-			sg.offset += data_unit_size;
-		}
-	}
+	/* Decrypt the bio in place */
+	crypt.slot = slot;
+	crypt.data_unit_size = bc->bc_key->crypto_cfg.data_unit_size;
+	crypt.encrypt = false;
+	crypt.src = bio;
+	crypt.dst = bio;
+	blk_st = blk_crypto_fallback_crypt(&crypt, f_ctx->crypt_iter,
+					   f_ctx->crypt_iter, bc->bc_dun);
+	if (blk_st != BLK_STS_OK)
+		bio->bi_status = blk_st;
 
-out:
-	skcipher_request_free(ciph_req);
 	blk_crypto_put_keyslot(slot);
 out_no_keyslot:
 	mempool_free(f_ctx, bio_fallback_crypt_ctx_pool);
@@ -530,7 +679,6 @@ int blk_crypto_fallback_evict_key(const struct blk_crypto_key *key)
 	return __blk_crypto_evict_key(blk_crypto_fallback_profile, key);
 }
 
-static bool blk_crypto_fallback_inited;
 static int blk_crypto_fallback_init(void)
 {
 	int i;
@@ -569,15 +717,23 @@ static int blk_crypto_fallback_init(void)
 
 	blk_crypto_wq = alloc_workqueue("blk_crypto_wq",
 					WQ_UNBOUND | WQ_HIGHPRI |
-					WQ_MEM_RECLAIM, num_online_cpus());
+					WQ_MEM_RECLAIM,
+					blk_crypto_max_parallel_cpus());
 	if (!blk_crypto_wq)
 		goto fail_destroy_profile;
 
+	blk_crypto_chunk_wq = alloc_workqueue("blk_crypto_chunk_wq",
+					      WQ_UNBOUND | WQ_HIGHPRI |
+					      WQ_MEM_RECLAIM,
+					      blk_crypto_max_parallel_cpus());
+	if (!blk_crypto_chunk_wq)
+		goto fail_free_wq;
+
 	blk_crypto_keyslots = kcalloc(blk_crypto_num_keyslots,
 				      sizeof(blk_crypto_keyslots[0]),
 				      GFP_KERNEL);
 	if (!blk_crypto_keyslots)
-		goto fail_free_wq;
+		goto fail_free_chunk_wq;
 
 	blk_crypto_bounce_page_pool =
 		mempool_create_page_pool(num_prealloc_bounce_pg, 0);
@@ -603,6 +759,8 @@ static int blk_crypto_fallback_init(void)
 	mempool_destroy(blk_crypto_bounce_page_pool);
 fail_free_keyslots:
 	kfree(blk_crypto_keyslots);
+fail_free_chunk_wq:
+	destroy_workqueue(blk_crypto_chunk_wq);
 fail_free_wq:
 	destroy_workqueue(blk_crypto_wq);
 fail_destroy_profile:
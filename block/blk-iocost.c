@@ -445,6 +445,10 @@ struct ioc {
 	int				autop_idx;
 	bool				user_qos_params:1;
 	bool				user_cost_model:1;
+
+	/* duration of the last and longest period timer runs */
+	u64				timer_last_ns;
+	u64				timer_max_ns;
 };
 
 struct iocg_pcpu_stat {
@@ -537,6 +541,7 @@ struct ioc_gq {
 
 	/* statistics */
 	struct iocg_pcpu_stat __percpu	*pcpu_stat;
+	cpumask_var_t			usage_cpus;	/* CPUs in pcpu_stat */
 	struct iocg_stat		stat;
 	struct iocg_stat		last_stat;
 	u64				last_stat_abs_vusage;
@@ -714,19 +719,32 @@ static u64 cost_to_abs_cost(u64 cost, u32 hw_inuse)
 	return DIV64_U64_ROUND_UP(cost * hw_inuse, WEIGHT_ONE);
 }
 
-static void iocg_commit_bio(struct ioc_gq *iocg, struct bio *bio,
-			    u64 abs_cost, u64 cost)
+/*
+ * Charge @abs_cost to the local CPU's usage counter of @iocg and remember the
+ * CPU, so that iocg_flush_stat_leaf() only has to visit the CPUs @iocg was
+ * ever charged on instead of every possible CPU.
+ */
+static void iocg_add_abs_vusage(struct ioc_gq *iocg, u64 abs_cost)
 {
 	struct iocg_pcpu_stat *gcs;
-
-	bio->bi_iocost_cost = cost;
-	atomic64_add(cost, &iocg->vtime);
+	int cpu;
 
 	gcs = get_cpu_ptr(iocg->pcpu_stat);
+	cpu = smp_processor_id();
 	local64_add(abs_cost, &gcs->abs_vusage);
+	if (unlikely(!cpumask_test_cpu(cpu, iocg->usage_cpus)))
+		cpumask_set_cpu(cpu, iocg->usage_cpus);
 	put_cpu_ptr(gcs);
 }
 
+static void iocg_commit_bio(struct ioc_gq *iocg, struct bio *bio,
+			    u64 abs_cost, u64 cost)
+{
+	bio->bi_iocost_cost = cost;
+	atomic64_add(cost, &iocg->vtime);
+	iocg_add_abs_vusage(iocg, abs_cost);
+}
+
 static void iocg_lock(struct ioc_gq *iocg, bool lock_ioc, unsigned long *flags)
 {
 	if (lock_ioc) {
@@ -1418,8 +1436,6 @@ static bool iocg_kick_delay(struct ioc_gq *iocg, struct ioc_now *now)
 static void iocg_incur_debt(struct ioc_gq *iocg, u64 abs_cost,
 			    struct ioc_now *now)
 {
-	struct iocg_pcpu_stat *gcs;
-
 	lockdep_assert_held(&iocg->ioc->lock);
 	lockdep_assert_held(&iocg->waitq.lock);
 	WARN_ON_ONCE(list_empty(&iocg->active_list));
@@ -1434,10 +1450,7 @@ static void iocg_incur_debt(struct ioc_gq *iocg, u64 abs_cost,
 	}
 
 	iocg->abs_vdebt += abs_cost;
-
-	gcs = get_cpu_ptr(iocg->pcpu_stat);
-	local64_add(abs_cost, &gcs->abs_vusage);
-	put_cpu_ptr(gcs);
+	iocg_add_abs_vusage(iocg, abs_cost);
 }
 
 static void iocg_pay_debt(struct ioc_gq *iocg, u64 abs_vpay,
@@ -1709,8 +1722,11 @@ static void iocg_flush_stat_leaf(struct ioc_gq *iocg, struct ioc_now *now)
 
 	lockdep_assert_held(&iocg->ioc->lock);
 
-	/* collect per-cpu counters */
-	for_each_possible_cpu(cpu) {
+	/*
+	 * Collect per-cpu counters. They are cumulative, so a CPU which is
+	 * being added to @usage_cpus concurrently is accounted next period.
+	 */
+	for_each_cpu(cpu, iocg->usage_cpus) {
 		abs_vusage += local64_read(
 				per_cpu_ptr(&iocg->pcpu_stat->abs_vusage, cpu));
 	}
@@ -2253,6 +2269,7 @@ static void ioc_timer_fn(struct timer_list *timer)
 	u32 missed_ppm[2], rq_wait_pct;
 	u64 period_vtime;
 	int prev_busy_level;
+	u64 start_ns = ktime_get_ns();
 
 	/* how were the latencies during the period? */
 	ioc_lat_stat(ioc, missed_ppm, &rq_wait_pct);
@@ -2463,6 +2480,9 @@ static void ioc_timer_fn(struct timer_list *timer)
 		ioc_refresh_vrate(ioc, &now);
 	}
 
+	ioc->timer_last_ns = ktime_get_ns() - start_ns;
+	ioc->timer_max_ns = max(ioc->timer_max_ns, ioc->timer_last_ns);
+
 	spin_unlock_irq(&ioc->lock);
 }
 
@@ -2974,12 +2994,19 @@ static struct blkg_policy_data *ioc_pd_alloc(struct gendisk *disk,
 		return NULL;
 
 	iocg->pcpu_stat = alloc_percpu_gfp(struct iocg_pcpu_stat, gfp);
-	if (!iocg->pcpu_stat) {
-		kfree(iocg);
-		return NULL;
-	}
+	if (!iocg->pcpu_stat)
+		goto err_free_iocg;
+
+	if (!zalloc_cpumask_var_node(&iocg->usage_cpus, gfp, disk->node_id))
+		goto err_free_pcpu_stat;
 
 	return &iocg->pd;
+
+err_free_pcpu_stat:
+	free_percpu(iocg->pcpu_stat);
+err_free_iocg:
+	kfree(iocg);
+	return NULL;
 }
 
 static void ioc_pd_init(struct blkg_policy_data *pd)
@@ -3043,6 +3070,7 @@ static void ioc_pd_free(struct blkg_policy_data *pd)
 
 		hrtimer_cancel(&iocg->waitq_timer);
 	}
+	free_cpumask_var(iocg->usage_cpus);
 	free_percpu(iocg->pcpu_stat);
 	kfree(iocg);
 }
@@ -3060,6 +3088,10 @@ static void ioc_pd_stat(struct blkg_policy_data *pd, struct seq_file *s)
 			ioc->vtime_base_rate * 10000,
 			VTIME_PER_USEC);
 		seq_printf(s, " cost.vrate=%u.%02u", vp10k / 100, vp10k % 100);
+		if (blkcg_debug_stats)
+			seq_printf(s, " cost.timer=%llu cost.timer_max=%llu",
+				   READ_ONCE(ioc->timer_last_ns) / NSEC_PER_USEC,
+				   READ_ONCE(ioc->timer_max_ns) / NSEC_PER_USEC);
 	}
 
 	seq_printf(s, " cost.usage=%llu", iocg->last_stat.usage_us);
@@ -568,6 +568,17 @@ struct blk_mq_tags *blk_mq_init_tags(unsigned int total_tags,
 	if (bt_alloc(&tags->breserved_tags, reserved_tags, round_robin, node))
 		goto out_free_bitmap_tags;
 
+	/*
+	 * Allocate the tags of deep queues through per-cpu caches, to avoid
+	 * bouncing the bitmap between the submitting CPUs. Tags shared by
+	 * several hardware queues are left alone, as the caches would make
+	 * waiting for the requests of one of them unreliable, and failing to
+	 * allocate the caches is not fatal.
+	 */
+	if (!round_robin && !(flags & BLK_MQ_F_TAG_HCTX_SHARED) &&
+	    depth >= BLK_MQ_TAG_CACHE_DEPTH)
+		sbitmap_queue_enable_cache(&tags->bitmap_tags, GFP_KERNEL);
+
 	return tags;
 
 out_free_bitmap_tags:
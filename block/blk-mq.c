@@ -3623,6 +3623,8 @@ static bool blk_mq_hctx_has_requests(struct blk_mq_hw_ctx *hctx)
 		.hctx	= hctx,
 	};
 
+	/* Cached free tags would look like requests in flight */
+	sbitmap_queue_flush_cache(&tags->bitmap_tags);
 	blk_mq_all_tag_iter(tags, blk_mq_has_request, &data);
 	return data.has_rq;
 }
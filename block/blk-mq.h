@@ -38,6 +38,9 @@ enum {
 
 #define BLK_MQ_CPU_WORK_BATCH	(8)
 
+/* Minimum depth of a tag map for its tags to be allocated via per-cpu caches */
+#define BLK_MQ_TAG_CACHE_DEPTH	(256)
+
 typedef unsigned int __bitwise blk_insert_t;
 #define BLK_MQ_INSERT_AT_HEAD		((__force blk_insert_t)0x01)
 
@@ -102,6 +102,16 @@ struct deadline_data {
 	int prio_aging_expire;
 
 	spinlock_t lock;
+
+	/*
+	 * Requests are staged on these lists by dd_insert_requests() and
+	 * only sorted into the per_prio lists under @lock by the next
+	 * dispatch or bio merge, so that insertion does not contend with
+	 * dispatching on other hardware queues.
+	 */
+	spinlock_t insert_lock;
+	struct list_head at_head;
+	struct list_head insert;
 };
 
 /* Maps an I/O priority class to a deadline scheduler priority. */
@@ -451,6 +461,88 @@ static struct request *dd_dispatch_prio_aged_requests(struct deadline_data *dd,
 	return NULL;
 }
 
+/*
+ * add rq to rbtree and fifo
+ */
+static void dd_insert_request(struct request_queue *q, struct request *rq,
+			      blk_insert_t flags, struct list_head *free)
+{
+	struct deadline_data *dd = q->elevator->elevator_data;
+	const enum dd_data_dir data_dir = rq_data_dir(rq);
+	u16 ioprio = req_get_ioprio(rq);
+	u8 ioprio_class = IOPRIO_PRIO_CLASS(ioprio);
+	struct dd_per_prio *per_prio;
+	enum dd_prio prio;
+
+	lockdep_assert_held(&dd->lock);
+
+	prio = ioprio_class_to_prio[ioprio_class];
+	per_prio = &dd->per_prio[prio];
+	if (!rq->elv.priv[0])
+		per_prio->stats.inserted++;
+	rq->elv.priv[0] = per_prio;
+
+	if (blk_mq_sched_try_insert_merge(q, rq, free))
+		return;
+
+	trace_block_rq_insert(rq);
+
+	/* rq->fifo_time is the time at which @rq was staged */
+	if (flags & BLK_MQ_INSERT_AT_HEAD) {
+		list_add(&rq->queuelist, &per_prio->dispatch);
+	} else {
+		deadline_add_rq_rb(per_prio, rq);
+
+		if (rq_mergeable(rq)) {
+			elv_rqhash_add(q, rq);
+			if (!q->last_merge)
+				q->last_merge = rq;
+		}
+
+		/*
+		 * set expire time and add to fifo list
+		 */
+		rq->fifo_time += dd->fifo_expire[data_dir];
+		list_add_tail(&rq->queuelist, &per_prio->fifo_list[data_dir]);
+	}
+}
+
+static void dd_insert_list(struct request_queue *q, struct list_head *list,
+			   blk_insert_t flags, struct list_head *free)
+{
+	while (!list_empty(list)) {
+		struct request *rq;
+
+		rq = list_first_entry(list, struct request, queuelist);
+		list_del_init(&rq->queuelist);
+		dd_insert_request(q, rq, flags, free);
+	}
+}
+
+/*
+ * Move the requests staged by dd_insert_requests() into the sort and FIFO
+ * lists. Requests which got merged on the way are added to @free.
+ */
+static void dd_insert_staged(struct request_queue *q, struct list_head *free)
+{
+	struct deadline_data *dd = q->elevator->elevator_data;
+	LIST_HEAD(at_head);
+	LIST_HEAD(at_tail);
+
+	lockdep_assert_held(&dd->lock);
+
+	if (list_empty_careful(&dd->at_head) && list_empty_careful(&dd->insert))
+		return;
+
+	spin_lock(&dd->insert_lock);
+	list_splice_init(&dd->at_head, &at_head);
+	list_splice_init(&dd->insert, &at_tail);
+	spin_unlock(&dd->insert_lock);
+
+	dd_insert_list(q, &at_head, BLK_MQ_INSERT_AT_HEAD, free);
+	dd_insert_list(q, &at_tail, 0, free);
+}
+
 /*
  * Called from blk_mq_run_hw_queue() -> __blk_mq_sched_dispatch_requests().
  *
@@ -465,8 +557,10 @@ static struct request *dd_dispatch_request(struct blk_mq_hw_ctx *hctx)
 	const unsigned long now = jiffies;
 	struct request *rq;
 	enum dd_prio prio;
+	LIST_HEAD(free);
 
 	spin_lock(&dd->lock);
+	dd_insert_staged(hctx->queue, &free);
 	rq = dd_dispatch_prio_aged_requests(dd, now);
 	if (rq)
 		goto unlock;
@@ -484,6 +578,8 @@ static struct request *dd_dispatch_request(struct blk_mq_hw_ctx *hctx)
 unlock:
 	spin_unlock(&dd->lock);
 
+	blk_mq_free_requests(&free);
+
 	return rq;
 }
 
@@ -544,6 +640,9 @@ static void dd_exit_sched(struct elevator_queue *e)
 	struct deadline_data *dd = e->elevator_data;
 	enum dd_prio prio;
 
+	WARN_ON_ONCE(!list_empty(&dd->at_head));
+	WARN_ON_ONCE(!list_empty(&dd->insert));
+
 	for (prio = 0; prio <= DD_PRIO_MAX; prio++) {
 		struct dd_per_prio *per_prio = &dd->per_prio[prio];
 		const struct io_stats_per_prio *stats = &per_prio->stats;
@@ -602,6 +701,9 @@ static int dd_init_sched(struct request_queue *q, struct elevator_type *e)
 	dd->fifo_batch = fifo_batch;
 	dd->prio_aging_expire = prio_aging_expire;
 	spin_lock_init(&dd->lock);
+	spin_lock_init(&dd->insert_lock);
+	INIT_LIST_HEAD(&dd->at_head);
+	INIT_LIST_HEAD(&dd->insert);
 
 	/* We dispatch from request queue wide instead of hw queue */
 	blk_queue_flag_set(QUEUE_FLAG_SQ_SCHED, q);
@@ -655,67 +757,25 @@ static bool dd_bio_merge(struct request_queue *q, struct bio *bio,
 {
 	struct deadline_data *dd = q->elevator->elevator_data;
 	struct request *free = NULL;
+	LIST_HEAD(staged_free);
 	bool ret;
 
 	spin_lock(&dd->lock);
+	dd_insert_staged(q, &staged_free);
 	ret = blk_mq_sched_try_merge(q, bio, nr_segs, &free);
 	spin_unlock(&dd->lock);
 
+	blk_mq_free_requests(&staged_free);
 	if (free)
 		blk_mq_free_request(free);
 
 	return ret;
 }
 
-/*
- * add rq to rbtree and fifo
- */
-static void dd_insert_request(struct blk_mq_hw_ctx *hctx, struct request *rq,
-			      blk_insert_t flags, struct list_head *free)
-{
-	struct request_queue *q = hctx->queue;
-	struct deadline_data *dd = q->elevator->elevator_data;
-	const enum dd_data_dir data_dir = rq_data_dir(rq);
-	u16 ioprio = req_get_ioprio(rq);
-	u8 ioprio_class = IOPRIO_PRIO_CLASS(ioprio);
-	struct dd_per_prio *per_prio;
-	enum dd_prio prio;
-
-	lockdep_assert_held(&dd->lock);
-
-	prio = ioprio_class_to_prio[ioprio_class];
-	per_prio = &dd->per_prio[prio];
-	if (!rq->elv.priv[0])
-		per_prio->stats.inserted++;
-	rq->elv.priv[0] = per_prio;
-
-	if (blk_mq_sched_try_insert_merge(q, rq, free))
-		return;
-
-	trace_block_rq_insert(rq);
-
-	if (flags & BLK_MQ_INSERT_AT_HEAD) {
-		list_add(&rq->queuelist, &per_prio->dispatch);
-		rq->fifo_time = jiffies;
-	} else {
-		deadline_add_rq_rb(per_prio, rq);
-
-		if (rq_mergeable(rq)) {
-			elv_rqhash_add(q, rq);
-			if (!q->last_merge)
-				q->last_merge = rq;
-		}
-
-		/*
-		 * set expire time and add to fifo list
-		 */
-		rq->fifo_time = jiffies + dd->fifo_expire[data_dir];
-		list_add_tail(&rq->queuelist, &per_prio->fifo_list[data_dir]);
-	}
-}
-
 /*
  * Called from blk_mq_insert_request() or blk_mq_dispatch_plug_list().
+ *
+ * Only stage the requests here, see dd_insert_staged().
  */
 static void dd_insert_requests(struct blk_mq_hw_ctx *hctx,
 			       struct list_head *list,
@@ -723,19 +783,18 @@ static void dd_insert_requests(struct blk_mq_hw_ctx *hctx,
 {
 	struct request_queue *q = hctx->queue;
 	struct deadline_data *dd = q->elevator->elevator_data;
-	LIST_HEAD(free);
-
-	spin_lock(&dd->lock);
-	while (!list_empty(list)) {
-		struct request *rq;
+	const unsigned long now = jiffies;
+	struct request *rq;
 
-		rq = list_first_entry(list, struct request, queuelist);
-		list_del_init(&rq->queuelist);
-		dd_insert_request(hctx, rq, flags, &free);
-	}
-	spin_unlock(&dd->lock);
+	list_for_each_entry(rq, list, queuelist)
+		rq->fifo_time = now;
 
-	blk_mq_free_requests(&free);
+	spin_lock(&dd->insert_lock);
+	if (flags & BLK_MQ_INSERT_AT_HEAD)
+		list_splice_tail_init(list, &dd->at_head);
+	else
+		list_splice_tail_init(list, &dd->insert);
+	spin_unlock(&dd->insert_lock);
 }
 
 /* Callback from inside blk_mq_rq_ctx_init(). */
@@ -772,6 +831,10 @@ static bool dd_has_work(struct blk_mq_hw_ctx *hctx)
 	struct deadline_data *dd = hctx->queue->elevator->elevator_data;
 	enum dd_prio prio;
 
+	if (!list_empty_careful(&dd->at_head) ||
+	    !list_empty_careful(&dd->insert))
+		return true;
+
 	for (prio = 0; prio <= DD_PRIO_MAX; prio++)
 		if (dd_has_work_for_prio(&dd->per_prio[prio]))
 			return true;
@@ -108,6 +108,82 @@ int crypto_aead_decrypt(struct aead_request *req)
 }
 EXPORT_SYMBOL_GPL(crypto_aead_decrypt);
 
+static int crypto_aead_batch_status(const int *errs, unsigned int nreqs)
+{
+	unsigned int i;
+
+	for (i = 0; i < nreqs; i++)
+		if (errs[i])
+			return errs[i];
+
+	return 0;
+}
+
+int crypto_aead_encrypt_batch(struct aead_request **reqs, unsigned int nreqs,
+			      int *errs)
+{
+	struct crypto_aead *aead;
+	struct aead_alg *alg;
+	unsigned int i;
+
+	if (!nreqs)
+		return 0;
+
+	aead = crypto_aead_reqtfm(reqs[0]);
+	alg = crypto_aead_alg(aead);
+
+	if (crypto_aead_get_flags(aead) & CRYPTO_TFM_NEED_KEY) {
+		for (i = 0; i < nreqs; i++)
+			errs[i] = -ENOKEY;
+		return -ENOKEY;
+	}
+
+	if (alg->encrypt_batch)
+		alg->encrypt_batch(reqs, nreqs, errs);
+	else
+		for (i = 0; i < nreqs; i++)
+			errs[i] = alg->encrypt(reqs[i]);
+
+	return crypto_aead_batch_status(errs, nreqs);
+}
+EXPORT_SYMBOL_GPL(crypto_aead_encrypt_batch);
+
+int crypto_aead_decrypt_batch(struct aead_request **reqs, unsigned int nreqs,
+			      int *errs)
+{
+	struct crypto_aead *aead;
+	struct aead_alg *alg;
+	bool batch;
+	unsigned int i;
+
+	if (!nreqs)
+		return 0;
+
+	aead = crypto_aead_reqtfm(reqs[0]);
+	alg = crypto_aead_alg(aead);
+
+	if (crypto_aead_get_flags(aead) & CRYPTO_TFM_NEED_KEY) {
+		for (i = 0; i < nreqs; i++)
+			errs[i] = -ENOKEY;
+		return -ENOKEY;
+	}
+
+	/* Requests too short for a tag fail on their own, outside the batch */
+	batch = alg->decrypt_batch;
+	for (i = 0; i < nreqs && batch; i++)
+		if (reqs[i]->cryptlen < crypto_aead_authsize(aead))
+			batch = false;
+
+	if (batch)
+		alg->decrypt_batch(reqs, nreqs, errs);
+	else
+		for (i = 0; i < nreqs; i++)
+			errs[i] = crypto_aead_decrypt(reqs[i]);
+
+	return crypto_aead_batch_status(errs, nreqs);
+}
+EXPORT_SYMBOL_GPL(crypto_aead_decrypt_batch);
+
 static void crypto_aead_exit_tfm(struct crypto_tfm *tfm)
 {
 	struct crypto_aead *aead = __crypto_aead_cast(tfm);
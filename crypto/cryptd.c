@@ -259,6 +259,7 @@ static struct skcipher_request *cryptd_skcipher_prepare(
 				      NULL, NULL);
 	skcipher_request_set_crypt(subreq, req->src, req->dst, req->cryptlen,
 				   req->iv);
+	skcipher_request_set_data_unit_size(subreq, req->du_size);
 
 	return subreq;
 }
@@ -805,21 +806,61 @@ static void cryptd_aead_decrypt(void *data, int err)
 			  cryptd_aead_decrypt);
 }
 
-static int cryptd_aead_enqueue(struct aead_request *req,
-				    crypto_completion_t compl)
+static void cryptd_aead_prepare(struct aead_request *req,
+				crypto_completion_t compl)
 {
 	struct cryptd_aead_request_ctx *rctx = aead_request_ctx(req);
-	struct crypto_aead *tfm = crypto_aead_reqtfm(req);
-	struct cryptd_queue *queue = cryptd_get_queue(crypto_aead_tfm(tfm));
 	struct aead_request *subreq = &rctx->req;
 
 	subreq->base.complete = req->base.complete;
 	subreq->base.data = req->base.data;
 	req->base.complete = compl;
 	req->base.data = req;
+}
+
+static int cryptd_aead_enqueue(struct aead_request *req,
+				    crypto_completion_t compl)
+{
+	struct crypto_aead *tfm = crypto_aead_reqtfm(req);
+	struct cryptd_queue *queue = cryptd_get_queue(crypto_aead_tfm(tfm));
+
+	cryptd_aead_prepare(req, compl);
 	return cryptd_enqueue_request(queue, &req->base);
 }
 
+/*
+ * Queue the whole batch to this CPU's queue and kick its worker only once,
+ * rather than paying for both for every request.
+ */
+static void cryptd_aead_enqueue_batch(struct aead_request **reqs,
+				      unsigned int nreqs, int *errs,
+				      crypto_completion_t compl)
+{
+	struct crypto_aead *tfm = crypto_aead_reqtfm(reqs[0]);
+	struct cryptd_queue *queue = cryptd_get_queue(crypto_aead_tfm(tfm));
+	refcount_t *refcnt = crypto_aead_ctx(tfm);
+	struct cryptd_cpu_queue *cpu_queue;
+	bool queued = false;
+	unsigned int i;
+
+	local_bh_disable();
+	cpu_queue = this_cpu_ptr(queue->cpu_queue);
+	for (i = 0; i < nreqs; i++) {
+		cryptd_aead_prepare(reqs[i], compl);
+		errs[i] = crypto_enqueue_request(&cpu_queue->queue,
+						 &reqs[i]->base);
+		if (errs[i] == -ENOSPC)
+			continue;
+
+		queued = true;
+		if (refcount_read(refcnt))
+			refcount_inc(refcnt);
+	}
+	if (queued)
+		queue_work_on(smp_processor_id(), cryptd_wq, &cpu_queue->work);
+	local_bh_enable();
+}
+
 static int cryptd_aead_encrypt_enqueue(struct aead_request *req)
 {
 	return cryptd_aead_enqueue(req, cryptd_aead_encrypt );
@@ -830,6 +871,18 @@ static int cryptd_aead_decrypt_enqueue(struct aead_request *req)
 	return cryptd_aead_enqueue(req, cryptd_aead_decrypt );
 }
 
+static void cryptd_aead_encrypt_enqueue_batch(struct aead_request **reqs,
+					      unsigned int nreqs, int *errs)
+{
+	cryptd_aead_enqueue_batch(reqs, nreqs, errs, cryptd_aead_encrypt);
+}
+
+static void cryptd_aead_decrypt_enqueue_batch(struct aead_request **reqs,
+					      unsigned int nreqs, int *errs)
+{
+	cryptd_aead_enqueue_batch(reqs, nreqs, errs, cryptd_aead_decrypt);
+}
+
 static int cryptd_aead_init_tfm(struct crypto_aead *tfm)
 {
 	struct aead_instance *inst = aead_alg_instance(tfm);
@@ -907,6 +960,8 @@ static int cryptd_create_aead(struct crypto_template *tmpl,
 	inst->alg.setauthsize = cryptd_aead_setauthsize;
 	inst->alg.encrypt = cryptd_aead_encrypt_enqueue;
 	inst->alg.decrypt = cryptd_aead_decrypt_enqueue;
+	inst->alg.encrypt_batch = cryptd_aead_encrypt_enqueue_batch;
+	inst->alg.decrypt_batch = cryptd_aead_decrypt_enqueue_batch;
 
 	inst->free = cryptd_aead_free;
 
@@ -175,6 +175,7 @@ struct simd_skcipher_alg *simd_skcipher_create_compat(struct skcipher_alg *ialg,
 	alg->chunksize = ialg->chunksize;
 	alg->min_keysize = ialg->min_keysize;
 	alg->max_keysize = ialg->max_keysize;
+	alg->multi_data_unit = ialg->multi_data_unit;
 
 	alg->init = simd_skcipher_init;
 	alg->exit = simd_skcipher_exit;
@@ -327,6 +328,58 @@ static int simd_aead_decrypt(struct aead_request *req)
 	return crypto_aead_decrypt(subreq);
 }
 
+#define SIMD_AEAD_BATCH	16
+
+/*
+ * Forward a batch to the same child as single requests would go to, picking
+ * it once for the whole batch.
+ */
+static void simd_aead_batch(struct aead_request **reqs, unsigned int nreqs,
+			    int *errs, bool enc)
+{
+	struct crypto_aead *tfm = crypto_aead_reqtfm(reqs[0]);
+	struct simd_aead_ctx *ctx = crypto_aead_ctx(tfm);
+	struct aead_request *subreqs[SIMD_AEAD_BATCH];
+	struct crypto_aead *child;
+	unsigned int i, n;
+
+	if (!crypto_simd_usable() ||
+	    (in_atomic() && cryptd_aead_queued(ctx->cryptd_tfm)))
+		child = &ctx->cryptd_tfm->base;
+	else
+		child = cryptd_aead_child(ctx->cryptd_tfm);
+
+	while (nreqs) {
+		n = min_t(unsigned int, nreqs, SIMD_AEAD_BATCH);
+		for (i = 0; i < n; i++) {
+			subreqs[i] = aead_request_ctx(reqs[i]);
+			*subreqs[i] = *reqs[i];
+			aead_request_set_tfm(subreqs[i], child);
+		}
+
+		if (enc)
+			crypto_aead_encrypt_batch(subreqs, n, errs);
+		else
+			crypto_aead_decrypt_batch(subreqs, n, errs);
+
+		reqs += n;
+		errs += n;
+		nreqs -= n;
+	}
+}
+
+static void simd_aead_encrypt_batch(struct aead_request **reqs,
+				    unsigned int nreqs, int *errs)
+{
+	simd_aead_batch(reqs, nreqs, errs, true);
+}
+
+static void simd_aead_decrypt_batch(struct aead_request **reqs,
+				    unsigned int nreqs, int *errs)
+{
+	simd_aead_batch(reqs, nreqs, errs, false);
+}
+
 static void simd_aead_exit(struct crypto_aead *tfm)
 {
 	struct simd_aead_ctx *ctx = crypto_aead_ctx(tfm);
@@ -407,6 +460,8 @@ static struct simd_aead_alg *simd_aead_create_compat(struct aead_alg *ialg,
 	alg->setauthsize = simd_aead_setauthsize;
 	alg->encrypt = simd_aead_encrypt;
 	alg->decrypt = simd_aead_decrypt;
+	alg->encrypt_batch = simd_aead_encrypt_batch;
+	alg->decrypt_batch = simd_aead_decrypt_batch;
 
 	err = crypto_register_aead(alg);
 	if (err)
@@ -468,6 +468,22 @@ int crypto_skcipher_setkey(struct crypto_skcipher *tfm, const u8 *key,
 }
 EXPORT_SYMBOL_GPL(crypto_skcipher_setkey);
 
+/**
+ * crypto_skcipher_multi_data_unit() - check for multi data unit support
+ * @tfm: cipher handle
+ *
+ * Return: %true if requests to @tfm may be split into data units with
+ * skcipher_request_set_data_unit_size()
+ */
+bool crypto_skcipher_multi_data_unit(struct crypto_skcipher *tfm)
+{
+	struct skcipher_alg *alg = crypto_skcipher_alg(tfm);
+
+	return alg->co.base.cra_type == &crypto_skcipher_type &&
+	       alg->multi_data_unit;
+}
+EXPORT_SYMBOL_GPL(crypto_skcipher_multi_data_unit);
+
 int crypto_skcipher_encrypt(struct skcipher_request *req)
 {
 	struct crypto_skcipher *tfm = crypto_skcipher_reqtfm(req);
@@ -494,6 +510,53 @@ int crypto_skcipher_decrypt(struct skcipher_request *req)
 }
 EXPORT_SYMBOL_GPL(crypto_skcipher_decrypt);
 
+static int crypto_skcipher_batch(struct skcipher_request **reqs,
+				 unsigned int nreqs, int *errs, bool enc)
+{
+	struct crypto_skcipher *tfm;
+	struct skcipher_alg *alg;
+	void (*batch)(struct skcipher_request **reqs, unsigned int nreqs,
+		      int *errs) = NULL;
+	unsigned int i;
+
+	if (!nreqs)
+		return 0;
+
+	tfm = crypto_skcipher_reqtfm(reqs[0]);
+	alg = crypto_skcipher_alg(tfm);
+
+	if (!(crypto_skcipher_get_flags(tfm) & CRYPTO_TFM_NEED_KEY) &&
+	    alg->co.base.cra_type == &crypto_skcipher_type)
+		batch = enc ? alg->encrypt_batch : alg->decrypt_batch;
+
+	if (batch)
+		batch(reqs, nreqs, errs);
+	else
+		for (i = 0; i < nreqs; i++)
+			errs[i] = enc ? crypto_skcipher_encrypt(reqs[i]) :
+					crypto_skcipher_decrypt(reqs[i]);
+
+	for (i = 0; i < nreqs; i++)
+		if (errs[i])
+			return errs[i];
+
+	return 0;
+}
+
+int crypto_skcipher_encrypt_batch(struct skcipher_request **reqs,
+				  unsigned int nreqs, int *errs)
+{
+	return crypto_skcipher_batch(reqs, nreqs, errs, true);
+}
+EXPORT_SYMBOL_GPL(crypto_skcipher_encrypt_batch);
+
+int crypto_skcipher_decrypt_batch(struct skcipher_request **reqs,
+				  unsigned int nreqs, int *errs)
+{
+	return crypto_skcipher_batch(reqs, nreqs, errs, false);
+}
+EXPORT_SYMBOL_GPL(crypto_skcipher_decrypt_batch);
+
 static int crypto_lskcipher_export(struct skcipher_request *req, void *out)
 {
 	struct crypto_skcipher *tfm = crypto_skcipher_reqtfm(req);
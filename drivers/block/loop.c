@@ -80,6 +80,8 @@ struct loop_device {
 struct loop_cmd {
 	struct list_head list_entry;
 	bool use_aio; /* use AIO interface to handle I/O */
+	bool nowait; /* issued from ->queue_rq() with IOCB_NOWAIT */
+	bool nowait_failed; /* the last IOCB_NOWAIT attempt got -EAGAIN */
 	atomic_t ref; /* only for aio */
 	long ret;
 	struct kiocb iocb;
@@ -366,6 +368,14 @@ static void lo_complete_rq(struct request *rq)
 	struct loop_cmd *cmd = blk_mq_rq_to_pdu(rq);
 	blk_status_t ret = BLK_STS_OK;
 
+	/* IOCB_NOWAIT failed after submission, retry from the worker */
+	if (cmd->nowait && cmd->ret == -EAGAIN) {
+		cmd->nowait_failed = true;
+		cmd->ret = 0;
+		blk_mq_requeue_request(rq, true);
+		return;
+	}
+
 	if (!cmd->use_aio || cmd->ret < 0 || cmd->ret == blk_rq_bytes(rq) ||
 	    req_op(rq) != REQ_OP_READ) {
 		if (cmd->ret < 0)
@@ -436,9 +446,9 @@ static int lo_rw_aio(struct loop_device *lo, struct loop_cmd *cmd,
 	if (rq->bio != rq->biotail) {
 
 		bvec = kmalloc_array(nr_bvec, sizeof(struct bio_vec),
-				     GFP_NOIO);
+				     cmd->nowait ? GFP_NOWAIT : GFP_NOIO);
 		if (!bvec)
-			return -EIO;
+			return cmd->nowait ? -EAGAIN : -EIO;
 		cmd->bvec = bvec;
 
 		/*
@@ -470,7 +480,15 @@ static int lo_rw_aio(struct loop_device *lo, struct loop_cmd *cmd,
 	cmd->iocb.ki_pos = pos;
 	cmd->iocb.ki_filp = file;
 	cmd->iocb.ki_complete = lo_rw_aio_complete;
-	cmd->iocb.ki_flags = IOCB_DIRECT;
+	cmd->iocb.ki_flags = 0;
+	if (lo->lo_flags & LO_FLAGS_DIRECT_IO)
+		cmd->iocb.ki_flags |= IOCB_DIRECT;
+	if (cmd->nowait) {
+		cmd->iocb.ki_flags |= IOCB_NOWAIT;
+		/* buffered reads from ->queue_rq() only hit the page cache */
+		if (!(cmd->iocb.ki_flags & IOCB_DIRECT))
+			cmd->iocb.ki_flags |= IOCB_NOIO;
+	}
 	cmd->iocb.ki_ioprio = IOPRIO_PRIO_VALUE(IOPRIO_CLASS_NONE, 0);
 
 	if (rw == ITER_SOURCE)
@@ -478,6 +496,17 @@ static int lo_rw_aio(struct loop_device *lo, struct loop_cmd *cmd,
 	else
 		ret = file->f_op->read_iter(&cmd->iocb, &iter);
 
+	/*
+	 * Let the worker handle what can't be done without blocking, and
+	 * buffered reads at EOF, which lo_read_simple() zero-fills.
+	 */
+	if (cmd->nowait && (ret == -EAGAIN ||
+	    (!ret && !(cmd->iocb.ki_flags & IOCB_DIRECT)))) {
+		kfree(cmd->bvec);
+		cmd->bvec = NULL;
+		return -EAGAIN;
+	}
+
 	lo_rw_aio_do_completion(cmd);
 
 	if (ret != -EIOCBQUEUED)
@@ -1851,10 +1880,90 @@ static const struct kernel_param_ops loop_hw_qdepth_param_ops = {
 device_param_cb(hw_queue_depth, &loop_hw_qdepth_param_ops, &hw_queue_depth, 0444);
 MODULE_PARM_DESC(hw_queue_depth, "Queue depth for each hardware queue. Default: " __stringify(LOOP_DEFAULT_HW_Q_DEPTH));
 
+static int hw_queues;
+
+static int loop_set_hw_queues(const char *s, const struct kernel_param *p)
+{
+	int nr, ret;
+
+	ret = kstrtoint(s, 0, &nr);
+	if (ret < 0)
+		return ret;
+	if (nr < 0)
+		return -EINVAL;
+	hw_queues = nr;
+	return 0;
+}
+
+static const struct kernel_param_ops loop_hw_queues_param_ops = {
+	.set	= loop_set_hw_queues,
+	.get	= param_get_int,
+};
+
+device_param_cb(hw_queues, &loop_hw_queues_param_ops, &hw_queues, 0444);
+MODULE_PARM_DESC(hw_queues, "Number of hardware queues. Default: 0 (one per CPU)");
+
 MODULE_DESCRIPTION("Loopback device support");
 MODULE_LICENSE("GPL");
 MODULE_ALIAS_BLOCKDEV_MAJOR(LOOP_MAJOR);
 
+static bool lo_can_use_nowait(struct loop_device *lo, struct loop_cmd *cmd)
+{
+	struct request *rq = blk_mq_rq_from_pdu(cmd);
+
+	if (!(lo->lo_backing_file->f_mode & FMODE_NOWAIT))
+		return false;
+
+	/* the workers issue I/O on behalf of the request's cgroups */
+	if (!queue_on_root_worker(cmd->blkcg_css))
+		return false;
+
+	switch (req_op(rq)) {
+	case REQ_OP_READ:
+		return true;
+	case REQ_OP_WRITE:
+		return cmd->use_aio && !(lo->lo_flags & LO_FLAGS_READ_ONLY);
+	default:
+		return false;
+	}
+}
+
+/*
+ * Try to issue the read or write from ->queue_rq() with IOCB_NOWAIT, which
+ * saves the hop to the worker whenever the backing file can serve the
+ * request without blocking. Buffered reads are only tried this way if they
+ * hit the page cache. Returns false if the request has to go to a worker.
+ */
+static bool loop_queue_nowait(struct loop_device *lo, struct loop_cmd *cmd)
+{
+	struct request *rq = blk_mq_rq_from_pdu(cmd);
+	loff_t pos = ((loff_t) blk_rq_pos(rq) << 9) + lo->lo_offset;
+	const bool use_aio = cmd->use_aio;
+	int ret;
+
+	cmd->nowait = false;
+	if (cmd->nowait_failed) {
+		cmd->nowait_failed = false;
+		return false;
+	}
+	if (!lo_can_use_nowait(lo, cmd))
+		return false;
+
+	cmd->nowait = true;
+	cmd->use_aio = true;
+	ret = lo_rw_aio(lo, cmd, pos, op_is_write(req_op(rq)) ?
+			ITER_SOURCE : ITER_DEST);
+	if (ret == -EAGAIN) {
+		cmd->nowait = false;
+		cmd->use_aio = use_aio;
+		return false;
+	}
+
+	if (cmd->memcg_css)
+		css_put(cmd->memcg_css);
+	return true;
+}
+
 static blk_status_t loop_queue_rq(struct blk_mq_hw_ctx *hctx,
 		const struct blk_mq_queue_data *bd)
 {
@@ -1893,7 +2002,8 @@ static blk_status_t loop_queue_rq(struct blk_mq_hw_ctx *hctx,
 #endif
 	}
 #endif
-	loop_queue_work(lo, cmd);
+	if (!loop_queue_nowait(lo, cmd))
+		loop_queue_work(lo, cmd);
 
 	return BLK_STS_OK;
 }
@@ -2039,11 +2149,16 @@ static int loop_add(int i)
 	i = err;
 
 	lo->tag_set.ops = &loop_mq_ops;
-	lo->tag_set.nr_hw_queues = 1;
+	lo->tag_set.nr_hw_queues = hw_queues ?: nr_cpu_ids;
 	lo->tag_set.queue_depth = hw_queue_depth;
 	lo->tag_set.numa_node = NUMA_NO_NODE;
 	lo->tag_set.cmd_size = sizeof(struct loop_cmd);
-	lo->tag_set.flags = BLK_MQ_F_STACKING | BLK_MQ_F_NO_SCHED_BY_DEFAULT;
+	/*
+	 * ->queue_rq() may block when issuing I/O to the backing file, and
+	 * the hardware queues share one set of tags of hw_queue_depth.
+	 */
+	lo->tag_set.flags = BLK_MQ_F_STACKING | BLK_MQ_F_NO_SCHED_BY_DEFAULT |
+		BLK_MQ_F_BLOCKING | BLK_MQ_F_TAG_HCTX_SHARED;
 	lo->tag_set.driver_data = lo;
 
 	err = blk_mq_alloc_tag_set(&lo->tag_set);
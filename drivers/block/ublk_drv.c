@@ -36,6 +36,7 @@
 #include <linux/sched/mm.h>
 #include <linux/uaccess.h>
 #include <linux/cdev.h>
+#include <linux/io_uring.h>
 #include <linux/io_uring/cmd.h>
 #include <linux/blk-mq.h>
 #include <linux/delay.h>
@@ -61,7 +62,8 @@
 		| UBLK_F_CMD_IOCTL_ENCODE \
 		| UBLK_F_USER_COPY \
 		| UBLK_F_ZONED \
-		| UBLK_F_USER_RECOVERY_FAIL_IO)
+		| UBLK_F_USER_RECOVERY_FAIL_IO \
+		| UBLK_F_BATCH_IO)
 
 #define UBLK_F_ALL_RECOVERY_FLAGS (UBLK_F_USER_RECOVERY \
 		| UBLK_F_USER_RECOVERY_REISSUE \
@@ -81,8 +83,16 @@ struct ublk_rq_data {
 struct ublk_uring_cmd_pdu {
 	struct ublk_queue *ubq;
 	u16 tag;
+
+	/* UBLK_U_IO_FETCH_IO_CMDS only */
+	u16 nr_elem;
+	u64 elem_addr;
+	struct io_uring_cmd *next;
 };
 
+/* pdu->tag of UBLK_U_IO_FETCH_IO_CMDS */
+#define UBLK_BATCH_FETCH_TAG	U16_MAX
+
 /*
  * io command is active: sqe cmd is received, and its cqe isn't done
  *
@@ -151,6 +161,17 @@ struct ublk_queue {
 	bool fail_io; /* copy of dev->state == UBLK_S_DEV_FAIL_IO */
 	unsigned short nr_io_ready;	/* how many ios setup */
 	spinlock_t		cancel_lock;
+
+	/*
+	 * UBLK_F_BATCH_IO: pending UBLK_U_IO_FETCH_IO_CMDS, and whether one
+	 * of them is delivering requests; only that one touches
+	 * @batch_backlog, the requests it couldn't deliver in order
+	 */
+	spinlock_t		batch_lock;
+	struct io_uring_cmd	*batch_fetch_cmds;
+	bool			batch_kicked;
+	struct llist_node	*batch_backlog;
+
 	struct ublk_device *dev;
 	struct ublk_io ios[];
 };
@@ -584,13 +605,30 @@ static inline bool ublk_support_user_copy(const struct ublk_queue *ubq)
 	return ubq->flags & UBLK_F_USER_COPY;
 }
 
+static inline bool ublk_support_zero_copy(const struct ublk_queue *ubq)
+{
+	return ubq->flags & UBLK_F_SUPPORT_ZERO_COPY;
+}
+
+static inline bool ublk_support_batch_io(const struct ublk_queue *ubq)
+{
+	return ubq->flags & UBLK_F_BATCH_IO;
+}
+
+/* Whether the data is copied into/from the buffers passed in io commands */
+static inline bool ublk_need_map_io(const struct ublk_queue *ubq)
+{
+	return !ublk_support_user_copy(ubq) && !ublk_support_zero_copy(ubq);
+}
+
 static inline bool ublk_need_req_ref(const struct ublk_queue *ubq)
 {
 	/*
-	 * read()/write() is involved in user copy, so request reference
-	 * has to be grabbed
+	 * read()/write() is involved in user copy, and registered buffers
+	 * outlive io commands in zero copy, so request reference has to be
+	 * grabbed
 	 */
-	return ublk_support_user_copy(ubq);
+	return ublk_support_user_copy(ubq) || ublk_support_zero_copy(ubq);
 }
 
 static inline void ublk_init_req_ref(const struct ublk_queue *ubq,
@@ -911,7 +949,7 @@ static int ublk_map_io(const struct ublk_queue *ubq, const struct request *req,
 {
 	const unsigned int rq_bytes = blk_rq_bytes(req);
 
-	if (ublk_support_user_copy(ubq))
+	if (!ublk_need_map_io(ubq))
 		return rq_bytes;
 
 	/*
@@ -935,7 +973,7 @@ static int ublk_unmap_io(const struct ublk_queue *ubq,
 {
 	const unsigned int rq_bytes = blk_rq_bytes(req);
 
-	if (ublk_support_user_copy(ubq))
+	if (!ublk_need_map_io(ubq))
 		return rq_bytes;
 
 	if (ublk_need_unmap_req(req)) {
@@ -1239,10 +1277,157 @@ static void ublk_rq_task_work_cb(struct io_uring_cmd *cmd, unsigned issue_flags)
 	ublk_forward_io_cmds(ubq, issue_flags);
 }
 
+static inline bool ublk_batch_has_work(const struct ublk_queue *ubq)
+{
+	return ubq->batch_backlog || !llist_empty(&ubq->io_cmds);
+}
+
+/* Take the queued requests, oldest first, called with ->batch_kicked set */
+static struct llist_node *ublk_batch_take_work(struct ublk_queue *ubq)
+{
+	struct llist_node *list = llist_reverse_order(llist_del_all(&ubq->io_cmds));
+	struct llist_node *head = ubq->batch_backlog, *pos;
+
+	if (!head)
+		return list;
+
+	ubq->batch_backlog = NULL;
+	for (pos = head; pos->next; pos = pos->next)
+		;
+	pos->next = list;
+	return head;
+}
+
+static void ublk_batch_abort_work(struct ublk_queue *ubq)
+{
+	struct llist_node *list = ublk_batch_take_work(ubq);
+	struct ublk_rq_data *data, *tmp;
+
+	llist_for_each_entry_safe(data, tmp, list, node)
+		__ublk_abort_rq(ubq, blk_mq_rq_from_pdu(data));
+}
+
+/*
+ * Hand queued requests over to the ublk server by completing the
+ * UBLK_U_IO_FETCH_IO_CMDS @cmd, called with ->batch_kicked set.
+ */
+static void ublk_batch_dispatch(struct ublk_queue *ubq,
+		struct io_uring_cmd *cmd, unsigned int issue_flags)
+{
+	struct ublk_uring_cmd_pdu *pdu = ublk_get_uring_cmd_pdu(cmd);
+	u16 __user *tags = u64_to_user_ptr(pdu->elem_addr);
+	struct llist_node *list = ublk_batch_take_work(ubq);
+	struct ublk_rq_data *data, *tmp;
+	unsigned int nr = 0;
+	int ret = 0;
+
+	/* see __ublk_rq_task_work() */
+	if (unlikely(current != io_uring_cmd_get_task(cmd) ||
+		     current->flags & PF_EXITING ||
+		     READ_ONCE(ubq->canceling))) {
+		llist_for_each_entry_safe(data, tmp, list, node)
+			__ublk_abort_rq(ubq, blk_mq_rq_from_pdu(data));
+		io_uring_cmd_done(cmd, UBLK_IO_RES_ABORT, 0, issue_flags);
+		return;
+	}
+
+	llist_for_each_entry_safe(data, tmp, list, node) {
+		struct request *req = blk_mq_rq_from_pdu(data);
+		struct ublk_io *io = &ubq->ios[req->tag];
+
+		if (nr == pdu->nr_elem || put_user(req->tag, &tags[nr])) {
+			if (!nr)
+				ret = -EFAULT;
+			ubq->batch_backlog = &data->node;
+			break;
+		}
+
+		/* serialized with ublk_abort_queue() */
+		spin_lock(&ubq->cancel_lock);
+		if (unlikely(ubq->canceling)) {
+			spin_unlock(&ubq->cancel_lock);
+			__ublk_abort_rq(ubq, req);
+			continue;
+		}
+		ublk_init_req_ref(ubq, req);
+		io->flags |= UBLK_IO_FLAG_OWNED_BY_SRV;
+		io->flags &= ~UBLK_IO_FLAG_ACTIVE;
+		spin_unlock(&ubq->cancel_lock);
+		nr++;
+	}
+
+	io_uring_cmd_done(cmd, ret ?: nr, 0, issue_flags);
+}
+
+static void ublk_batch_fetch_cb(struct io_uring_cmd *cmd,
+		unsigned int issue_flags);
+
+/* Pass on ->batch_kicked if there is still work, or clear it */
+static void ublk_batch_unkick(struct ublk_queue *ubq)
+{
+	struct io_uring_cmd *cmd = NULL;
+
+	spin_lock(&ubq->batch_lock);
+	ubq->batch_kicked = false;
+	/* pairs with llist_add() in ublk_batch_queue_cmd() */
+	smp_mb();
+	if (ublk_batch_has_work(ubq)) {
+		cmd = ubq->batch_fetch_cmds;
+		if (cmd) {
+			ubq->batch_fetch_cmds = ublk_get_uring_cmd_pdu(cmd)->next;
+			ubq->batch_kicked = true;
+		} else if (READ_ONCE(ubq->canceling)) {
+			/* no server left to deliver to */
+			ublk_batch_abort_work(ubq);
+		}
+	}
+	spin_unlock(&ubq->batch_lock);
+
+	if (cmd)
+		io_uring_cmd_complete_in_task(cmd, ublk_batch_fetch_cb);
+}
+
+static void ublk_batch_fetch_cb(struct io_uring_cmd *cmd,
+		unsigned int issue_flags)
+{
+	struct ublk_queue *ubq = ublk_get_uring_cmd_pdu(cmd)->ubq;
+
+	ublk_batch_dispatch(ubq, cmd, issue_flags);
+	ublk_batch_unkick(ubq);
+}
+
+static void ublk_batch_queue_cmd(struct ublk_queue *ubq, struct request *rq)
+{
+	struct ublk_rq_data *data = blk_mq_rq_to_pdu(rq);
+	struct io_uring_cmd *cmd;
+
+	llist_add(&data->node, &ubq->io_cmds);
+	/* requests queued meantime are picked up by the kicked fetch cmd */
+	if (READ_ONCE(ubq->batch_kicked))
+		return;
+
+	spin_lock(&ubq->batch_lock);
+	cmd = ubq->batch_fetch_cmds;
+	if (ubq->batch_kicked || !cmd) {
+		spin_unlock(&ubq->batch_lock);
+		return;
+	}
+	ubq->batch_fetch_cmds = ublk_get_uring_cmd_pdu(cmd)->next;
+	ubq->batch_kicked = true;
+	spin_unlock(&ubq->batch_lock);
+
+	io_uring_cmd_complete_in_task(cmd, ublk_batch_fetch_cb);
+}
+
 static void ublk_queue_cmd(struct ublk_queue *ubq, struct request *rq)
 {
 	struct ublk_rq_data *data = blk_mq_rq_to_pdu(rq);
 
+	if (ublk_support_batch_io(ubq)) {
+		ublk_batch_queue_cmd(ubq, rq);
+		return;
+	}
+
 	if (llist_add(&data->node, &ubq->io_cmds)) {
 		struct ublk_io *io = &ubq->ios[rq->tag];
 
@@ -1428,14 +1613,20 @@ static void ublk_commit_completion(struct ublk_device *ub,
  * Called from ubq_daemon context via cancel fn, meantime quiesce ublk
  * blk-mq queue, so we are called exclusively with blk-mq and ubq_daemon
  * context, so everything is serialized.
+ *
+ * With UBLK_F_BATCH_IO, other server threads may still fetch and commit
+ * requests, which is serialized by ->cancel_lock.
  */
 static void ublk_abort_queue(struct ublk_device *ub, struct ublk_queue *ubq)
 {
+	bool batch = ublk_support_batch_io(ubq);
 	int i;
 
 	for (i = 0; i < ubq->q_depth; i++) {
 		struct ublk_io *io = &ubq->ios[i];
 
+		if (batch)
+			spin_lock(&ubq->cancel_lock);
 		if (!(io->flags & UBLK_IO_FLAG_ACTIVE)) {
 			struct request *rq;
 
@@ -1449,6 +1640,8 @@ static void ublk_abort_queue(struct ublk_device *ub, struct ublk_queue *ubq)
 				__ublk_fail_req(ubq, io, rq);
 			}
 		}
+		if (batch)
+			spin_unlock(&ubq->cancel_lock);
 	}
 }
 
@@ -1502,6 +1695,41 @@ static void ublk_cancel_cmd(struct ublk_queue *ubq, struct ublk_io *io,
 		io_uring_cmd_done(io->cmd, UBLK_IO_RES_ABORT, 0, issue_flags);
 }
 
+/*
+ * Complete UBLK_U_IO_FETCH_IO_CMDS @cmd, or all of them if @cmd is NULL,
+ * with UBLK_IO_RES_ABORT, and fail the queued requests once there is
+ * nobody left to deliver them to.
+ */
+static void ublk_batch_cancel_cmds(struct ublk_queue *ubq,
+		struct io_uring_cmd *cmd, unsigned int issue_flags)
+{
+	struct io_uring_cmd *list = NULL, **pp = &ubq->batch_fetch_cmds;
+
+	spin_lock(&ubq->batch_lock);
+	while (*pp) {
+		struct io_uring_cmd *cur = *pp;
+		struct ublk_uring_cmd_pdu *pdu = ublk_get_uring_cmd_pdu(cur);
+
+		if (cmd && cur != cmd) {
+			pp = &pdu->next;
+			continue;
+		}
+		*pp = pdu->next;
+		pdu->next = list;
+		list = cur;
+	}
+	if (!ubq->batch_kicked && !ubq->batch_fetch_cmds)
+		ublk_batch_abort_work(ubq);
+	spin_unlock(&ubq->batch_lock);
+
+	while (list) {
+		struct io_uring_cmd *next = ublk_get_uring_cmd_pdu(list)->next;
+
+		io_uring_cmd_done(list, UBLK_IO_RES_ABORT, 0, issue_flags);
+		list = next;
+	}
+}
+
 /*
  * The ublk char device won't be closed when calling cancel fn, so both
  * ublk device and queue are guaranteed to be live
@@ -1519,6 +1747,15 @@ static void ublk_uring_cmd_cancel_fn(struct io_uring_cmd *cmd,
 	if (WARN_ON_ONCE(!ubq))
 		return;
 
+	if (ublk_support_batch_io(ubq) && pdu->tag == UBLK_BATCH_FETCH_TAG) {
+		ub = ubq->dev;
+		need_schedule = ublk_abort_requests(ub, ubq);
+		ublk_batch_cancel_cmds(ubq, cmd, issue_flags);
+		if (need_schedule)
+			schedule_work(&ub->nosrv_work);
+		return;
+	}
+
 	if (WARN_ON_ONCE(pdu->tag >= ubq->q_depth))
 		return;
 
@@ -1547,6 +1784,11 @@ static void ublk_cancel_queue(struct ublk_queue *ubq)
 {
 	int i;
 
+	if (ublk_support_batch_io(ubq)) {
+		ublk_batch_cancel_cmds(ubq, NULL, IO_URING_F_UNLOCKED);
+		return;
+	}
+
 	for (i = 0; i < ubq->q_depth; i++)
 		ublk_cancel_cmd(ubq, &ubq->ios[i], IO_URING_F_UNLOCKED);
 }
@@ -1684,21 +1926,45 @@ static void ublk_nosrv_work(struct work_struct *work)
 	ublk_cancel_dev(ub);
 }
 
+static void ublk_queue_set_ready(struct ublk_device *ub,
+		struct ublk_queue *ubq)
+{
+	lockdep_assert_held(&ub->mutex);
+
+	ubq->ubq_daemon = current;
+	get_task_struct(ubq->ubq_daemon);
+	ub->nr_queues_ready++;
+
+	if (capable(CAP_SYS_ADMIN))
+		ub->nr_privileged_daemon++;
+
+	if (ub->nr_queues_ready == ub->dev_info.nr_hw_queues)
+		complete_all(&ub->completion);
+}
+
 /* device can only be started after all IOs are ready */
 static void ublk_mark_io_ready(struct ublk_device *ub, struct ublk_queue *ubq)
 {
 	mutex_lock(&ub->mutex);
 	ubq->nr_io_ready++;
-	if (ublk_queue_ready(ubq)) {
-		ubq->ubq_daemon = current;
-		get_task_struct(ubq->ubq_daemon);
-		ub->nr_queues_ready++;
+	if (ublk_queue_ready(ubq))
+		ublk_queue_set_ready(ub, ubq);
+	mutex_unlock(&ub->mutex);
+}
 
-		if (capable(CAP_SYS_ADMIN))
-			ub->nr_privileged_daemon++;
+/* UBLK_F_BATCH_IO: the first UBLK_U_IO_FETCH_IO_CMDS sets up all ios */
+static void ublk_batch_mark_queue_ready(struct ublk_device *ub,
+		struct ublk_queue *ubq)
+{
+	int i;
+
+	mutex_lock(&ub->mutex);
+	if (!ublk_queue_ready(ubq)) {
+		for (i = 0; i < ubq->q_depth; i++)
+			ubq->ios[i].flags |= UBLK_IO_FLAG_ACTIVE;
+		ubq->nr_io_ready = ubq->q_depth;
+		ublk_queue_set_ready(ub, ubq);
 	}
-	if (ub->nr_queues_ready == ub->dev_info.nr_hw_queues)
-		complete_all(&ub->completion);
 	mutex_unlock(&ub->mutex);
 }
 
@@ -1747,6 +2013,91 @@ static inline void ublk_prep_cancel(struct io_uring_cmd *cmd,
 	io_uring_cmd_mark_cancelable(cmd, issue_flags);
 }
 
+static inline struct request *__ublk_check_and_get_req(struct ublk_device *ub,
+		struct ublk_queue *ubq, int tag, size_t offset)
+{
+	struct request *req;
+
+	if (!ublk_need_req_ref(ubq))
+		return NULL;
+
+	req = blk_mq_tag_to_rq(ub->tag_set.tags[ubq->q_id], tag);
+	if (!req)
+		return NULL;
+
+	if (!ublk_get_req_ref(ubq, req))
+		return NULL;
+
+	if (unlikely(!blk_mq_request_started(req) || req->tag != tag))
+		goto fail_put;
+
+	if (!ublk_rq_has_data(req))
+		goto fail_put;
+
+	if (offset > blk_rq_bytes(req))
+		goto fail_put;
+
+	return req;
+fail_put:
+	ublk_put_req_ref(ubq, req);
+	return NULL;
+}
+
+static void ublk_io_release(void *priv)
+{
+	struct request *rq = priv;
+	struct ublk_queue *ubq = rq->mq_hctx->driver_data;
+
+	ublk_put_req_ref(ubq, rq);
+}
+
+static int ublk_register_io_buf(struct io_uring_cmd *cmd,
+				struct ublk_device *ub, struct ublk_queue *ubq,
+				unsigned int tag, unsigned int index,
+				unsigned int issue_flags)
+{
+	struct request *req;
+	int ret;
+
+	if (!ublk_support_zero_copy(ubq))
+		return -EINVAL;
+
+	/* the reference is dropped by ublk_io_release() */
+	req = __ublk_check_and_get_req(ub, ubq, tag, 0);
+	if (!req)
+		return -EINVAL;
+
+	ret = io_buffer_register_bvec(cmd, req, ublk_io_release, index,
+				      issue_flags);
+	if (ret) {
+		ublk_put_req_ref(ubq, req);
+		return ret;
+	}
+
+	return 0;
+}
+
+static int ublk_unregister_io_buf(struct io_uring_cmd *cmd,
+				  struct ublk_queue *ubq, unsigned int index,
+				  unsigned int issue_flags)
+{
+	if (!ublk_support_zero_copy(ubq))
+		return -EINVAL;
+
+	return io_buffer_unregister_bvec(cmd, index, issue_flags);
+}
+
+/* Whether io commands of @ubq may be issued from current */
+static inline bool ublk_is_server_task(const struct ublk_queue *ubq)
+{
+	if (!ubq->ubq_daemon)
+		return true;
+	/* any thread of the ublk server may serve the queue */
+	if (ublk_support_batch_io(ubq))
+		return same_thread_group(ubq->ubq_daemon, current);
+	return ubq->ubq_daemon == current;
+}
+
 static int __ublk_ch_uring_cmd(struct io_uring_cmd *cmd,
 			       unsigned int issue_flags,
 			       const struct ublksrv_io_cmd *ub_cmd)
@@ -1770,7 +2121,7 @@ static int __ublk_ch_uring_cmd(struct io_uring_cmd *cmd,
 	if (!ubq || ub_cmd->q_id != ubq->q_id)
 		goto out;
 
-	if (ubq->ubq_daemon && ubq->ubq_daemon != current)
+	if (!ublk_is_server_task(ubq))
 		goto out;
 
 	if (tag >= ubq->q_depth)
@@ -1778,6 +2129,22 @@ static int __ublk_ch_uring_cmd(struct io_uring_cmd *cmd,
 
 	io = &ubq->ios[tag];
 
+	/* buffer (un)registration completes right away */
+	if (cmd_op == UBLK_U_IO_REGISTER_IO_BUF) {
+		ret = ublk_register_io_buf(cmd, ub, ubq, tag, ub_cmd->addr,
+					   issue_flags);
+		goto out;
+	}
+	if (cmd_op == UBLK_U_IO_UNREGISTER_IO_BUF) {
+		ret = ublk_unregister_io_buf(cmd, ubq, ub_cmd->addr,
+					     issue_flags);
+		goto out;
+	}
+
+	/* requests are fetched and committed in batches */
+	if (ublk_support_batch_io(ubq))
+		goto out;
+
 	/* there is pending io cmd, something must be wrong */
 	if (io->flags & UBLK_IO_FLAG_ACTIVE) {
 		ret = -EBUSY;
@@ -1811,7 +2178,7 @@ static int __ublk_ch_uring_cmd(struct io_uring_cmd *cmd,
 		if (io->flags & UBLK_IO_FLAG_OWNED_BY_SRV)
 			goto out;
 
-		if (!ublk_support_user_copy(ubq)) {
+		if (ublk_need_map_io(ubq)) {
 			/*
 			 * FETCH_RQ has to provide IO buffer if NEED GET
 			 * DATA is not enabled
@@ -1833,7 +2200,7 @@ static int __ublk_ch_uring_cmd(struct io_uring_cmd *cmd,
 		if (!(io->flags & UBLK_IO_FLAG_OWNED_BY_SRV))
 			goto out;
 
-		if (!ublk_support_user_copy(ubq)) {
+		if (ublk_need_map_io(ubq)) {
 			/*
 			 * COMMIT_AND_FETCH_REQ has to provide IO buffer if
 			 * NEED GET DATA is not enabled or it is Read IO.
@@ -1872,34 +2239,117 @@ static int __ublk_ch_uring_cmd(struct io_uring_cmd *cmd,
 	return -EIOCBQUEUED;
 }
 
-static inline struct request *__ublk_check_and_get_req(struct ublk_device *ub,
-		struct ublk_queue *ubq, int tag, size_t offset)
+static int ublk_batch_fetch(struct ublk_device *ub, struct ublk_queue *ubq,
+		struct io_uring_cmd *cmd, const struct ublk_batch_io *b,
+		unsigned int issue_flags)
 {
-	struct request *req;
+	struct ublk_uring_cmd_pdu *pdu = ublk_get_uring_cmd_pdu(cmd);
 
-	if (!ublk_need_req_ref(ubq))
-		return NULL;
+	if (!ublk_queue_ready(ubq))
+		ublk_batch_mark_queue_ready(ub, ubq);
 
-	req = blk_mq_tag_to_rq(ub->tag_set.tags[ubq->q_id], tag);
-	if (!req)
-		return NULL;
+	pdu->ubq = ubq;
+	pdu->tag = UBLK_BATCH_FETCH_TAG;
+	pdu->nr_elem = b->nr_elem;
+	pdu->elem_addr = b->elem_addr;
+	pdu->next = NULL;
+
+	spin_lock(&ubq->batch_lock);
+	if (READ_ONCE(ubq->canceling)) {
+		spin_unlock(&ubq->batch_lock);
+		return UBLK_IO_RES_ABORT;
+	}
+	if (!ubq->batch_kicked && ublk_batch_has_work(ubq)) {
+		ubq->batch_kicked = true;
+		spin_unlock(&ubq->batch_lock);
+
+		ublk_batch_dispatch(ubq, cmd, issue_flags);
+		ublk_batch_unkick(ubq);
+		return -EIOCBQUEUED;
+	}
+	io_uring_cmd_mark_cancelable(cmd, issue_flags);
+	pdu->next = ubq->batch_fetch_cmds;
+	ubq->batch_fetch_cmds = cmd;
+	spin_unlock(&ubq->batch_lock);
 
-	if (!ublk_get_req_ref(ubq, req))
-		return NULL;
+	return -EIOCBQUEUED;
+}
 
-	if (unlikely(!blk_mq_request_started(req) || req->tag != tag))
-		goto fail_put;
+static int ublk_batch_commit(struct ublk_device *ub, struct ublk_queue *ubq,
+		const struct ublk_batch_io *b)
+{
+	struct ublk_batch_commit_elem __user *elems =
+		u64_to_user_ptr(b->elem_addr);
+	int i;
 
-	if (!ublk_rq_has_data(req))
-		goto fail_put;
+	if (!ublk_queue_ready(ubq))
+		return -EINVAL;
 
-	if (offset > blk_rq_bytes(req))
-		goto fail_put;
+	for (i = 0; i < b->nr_elem; i++) {
+		struct ublk_batch_commit_elem elem;
+		struct ublksrv_io_cmd ub_cmd;
+		struct ublk_io *io;
+
+		if (copy_from_user(&elem, &elems[i], sizeof(elem)))
+			return i ?: -EFAULT;
+		if (elem.tag >= ubq->q_depth)
+			return i ?: -EINVAL;
+
+		io = &ubq->ios[elem.tag];
+		spin_lock(&ubq->cancel_lock);
+		if ((io->flags & (UBLK_IO_FLAG_OWNED_BY_SRV |
+				  UBLK_IO_FLAG_ACTIVE |
+				  UBLK_IO_FLAG_ABORTED)) !=
+		    UBLK_IO_FLAG_OWNED_BY_SRV) {
+			spin_unlock(&ubq->cancel_lock);
+			return i ?: -EINVAL;
+		}
+		/* the io waits for the next fetch, as if re-issued */
+		io->flags |= UBLK_IO_FLAG_ACTIVE;
+		spin_unlock(&ubq->cancel_lock);
 
-	return req;
-fail_put:
-	ublk_put_req_ref(ubq, req);
-	return NULL;
+		ub_cmd = (struct ublksrv_io_cmd) {
+			.q_id = ubq->q_id,
+			.tag = elem.tag,
+			.result = elem.result,
+			.zone_append_lba = elem.zone_append_lba,
+		};
+		ublk_commit_completion(ub, &ub_cmd);
+	}
+	return i;
+}
+
+static int ublk_ch_batch_io_cmd(struct io_uring_cmd *cmd,
+		unsigned int issue_flags)
+{
+	struct ublk_device *ub = cmd->file->private_data;
+	const struct ublk_batch_io *src = io_uring_sqe_cmd(cmd->sqe);
+	const struct ublk_batch_io b = {
+		.q_id = READ_ONCE(src->q_id),
+		.nr_elem = READ_ONCE(src->nr_elem),
+		.flags = READ_ONCE(src->flags),
+		.elem_addr = READ_ONCE(src->elem_addr),
+	};
+	struct ublk_queue *ubq;
+	int ret = -EINVAL;
+
+	if (b.q_id >= ub->dev_info.nr_hw_queues || b.flags || !b.nr_elem)
+		goto out;
+
+	ubq = ublk_get_queue(ub, b.q_id);
+	if (!ublk_support_batch_io(ubq) || !ublk_is_server_task(ubq))
+		goto out;
+
+	if (cmd->cmd_op == UBLK_U_IO_FETCH_IO_CMDS) {
+		ret = ublk_batch_fetch(ub, ubq, cmd, &b, issue_flags);
+		if (ret == -EIOCBQUEUED)
+			return ret;
+	} else {
+		ret = ublk_batch_commit(ub, ubq, &b);
+	}
+ out:
+	io_uring_cmd_done(cmd, ret, 0, issue_flags);
+	return -EIOCBQUEUED;
 }
 
 static inline int ublk_ch_uring_cmd_local(struct io_uring_cmd *cmd,
@@ -1919,6 +2369,10 @@ static inline int ublk_ch_uring_cmd_local(struct io_uring_cmd *cmd,
 
 	WARN_ON_ONCE(issue_flags & IO_URING_F_UNLOCKED);
 
+	if (cmd->cmd_op == UBLK_U_IO_FETCH_IO_CMDS ||
+	    cmd->cmd_op == UBLK_U_IO_COMMIT_IO_CMDS)
+		return ublk_ch_batch_io_cmd(cmd, issue_flags);
+
 	return __ublk_ch_uring_cmd(cmd, issue_flags, &ub_cmd);
 }
 
@@ -1990,6 +2444,9 @@ static struct request *ublk_check_and_get_req(struct kiocb *iocb,
 	if (!ubq)
 		return ERR_PTR(-EINVAL);
 
+	if (!ublk_support_user_copy(ubq))
+		return ERR_PTR(-EACCES);
+
 	if (tag >= ubq->q_depth)
 		return ERR_PTR(-EINVAL);
 
@@ -2075,6 +2532,7 @@ static int ublk_init_queue(struct ublk_device *ub, int q_id)
 	int size;
 
 	spin_lock_init(&ubq->cancel_lock);
+	spin_lock_init(&ubq->batch_lock);
 	ubq->flags = ub->dev_info.flags;
 	ubq->q_id = q_id;
 	ubq->q_depth = ub->dev_info.queue_depth;
@@ -2457,9 +2915,10 @@ static int ublk_ctrl_add_dev(struct io_uring_cmd *cmd)
 		/*
 		 * For USER_COPY, we depends on userspace to fill request
 		 * buffer by pwrite() to ublk char device, which can't be
-		 * used for unprivileged device
+		 * used for unprivileged device. The same goes for zero copy,
+		 * which hands the request pages to the server's io_uring.
 		 */
-		if (info.flags & UBLK_F_USER_COPY)
+		if (info.flags & (UBLK_F_USER_COPY | UBLK_F_SUPPORT_ZERO_COPY))
 			return -EINVAL;
 	}
 
@@ -2516,10 +2975,22 @@ static int ublk_ctrl_add_dev(struct io_uring_cmd *cmd)
 	ub->dev_info.flags |= UBLK_F_CMD_IOCTL_ENCODE |
 		UBLK_F_URING_CMD_COMP_IN_TASK;
 
-	/* GET_DATA isn't needed any more with USER_COPY */
-	if (ublk_dev_is_user_copy(ub))
+	/* GET_DATA isn't needed any more with USER_COPY or ZERO_COPY */
+	if (ub->dev_info.flags & (UBLK_F_USER_COPY | UBLK_F_SUPPORT_ZERO_COPY))
 		ub->dev_info.flags &= ~UBLK_F_NEED_GET_DATA;
 
+	/*
+	 * Batched io commands carry no buffer address, and the recovery
+	 * path re-fetches io commands per tag
+	 */
+	if ((ub->dev_info.flags & UBLK_F_BATCH_IO) &&
+	    (!(ub->dev_info.flags & (UBLK_F_USER_COPY |
+				     UBLK_F_SUPPORT_ZERO_COPY)) ||
+	     (ub->dev_info.flags & UBLK_F_ALL_RECOVERY_FLAGS))) {
+		ret = -EINVAL;
+		goto out_free_dev_number;
+	}
+
 	/* Zoned storage support requires user copy feature */
 	if (ublk_dev_is_zoned(ub) &&
 	    (!IS_ENABLED(CONFIG_BLK_DEV_ZONED) || !ublk_dev_is_user_copy(ub))) {
@@ -2527,9 +2998,6 @@ static int ublk_ctrl_add_dev(struct io_uring_cmd *cmd)
 		goto out_free_dev_number;
 	}
 
-	/* We are not ready to support zero copy */
-	ub->dev_info.flags &= ~UBLK_F_SUPPORT_ZERO_COPY;
-
 	ub->dev_info.nr_hw_queues = min_t(unsigned int,
 			ub->dev_info.nr_hw_queues, nr_cpu_ids);
 	ublk_align_max_io_size(ub);
@@ -2860,7 +3328,7 @@ static int ublk_ctrl_get_features(struct io_uring_cmd *cmd)
 {
 	const struct ublksrv_ctrl_cmd *header = io_uring_sqe_cmd(cmd->sqe);
 	void __user *argp = (void __user *)(unsigned long)header->addr;
-	u64 features = UBLK_F_ALL & ~UBLK_F_SUPPORT_ZERO_COPY;
+	u64 features = UBLK_F_ALL;
 
 	if (header->len != UBLK_FEATURES_LEN || !header->addr)
 		return -EINVAL;
@@ -30,6 +30,7 @@
 #include <linux/spinlock.h>
 #include <linux/swiotlb.h>
 #include <linux/vmalloc.h>
+#include <linux/workqueue.h>
 #include <trace/events/swiotlb.h>
 
 #include "dma-iommu.h"
@@ -76,6 +77,10 @@ struct iommu_dma_cookie {
 			struct timer_list	fq_timer;
 			/* 1 when timer is active, 0 when not */
 			atomic_t		fq_timer_on;
+			/* Flushes forced by a full per-CPU queue since the last timeout */
+			atomic_t		fq_full_cnt;
+			/* Grows the per-CPU queues of busy domains */
+			struct work_struct	fq_resize_work;
 		};
 		/* Trivial linear page allocator for IOMMU_DMA_MSI_COOKIE */
 		dma_addr_t		msi_iova;
@@ -104,6 +109,7 @@ early_param("iommu.forcedac", iommu_dma_forcedac_setup);
 
 /* Number of entries per flush queue */
 #define IOVA_DEFAULT_FQ_SIZE	256
+#define IOVA_MAX_FQ_SIZE	4096
 #define IOVA_SINGLE_FQ_SIZE	32768
 
 /* Timeout (in ms) after which entries are flushed from the queue */
@@ -194,8 +200,21 @@ static void fq_flush_timeout(struct timer_list *t)
 	if (cookie->options.qt == IOMMU_DMA_OPTS_SINGLE_QUEUE) {
 		fq_ring_free(cookie, cookie->single_fq);
 	} else {
+		struct iova_fq __percpu *percpu_fq;
+
+		rcu_read_lock();
+		percpu_fq = READ_ONCE(cookie->percpu_fq);
 		for_each_possible_cpu(cpu)
-			fq_ring_free(cookie, per_cpu_ptr(cookie->percpu_fq, cpu));
+			fq_ring_free(cookie, per_cpu_ptr(percpu_fq, cpu));
+		rcu_read_unlock();
+
+		/*
+		 * A queue that filled up within one timeout has forced an
+		 * IOTLB flush per queue-full of unmaps; give it more room.
+		 */
+		if (atomic_xchg(&cookie->fq_full_cnt, 0) &&
+		    READ_ONCE(cookie->options.fq_size) < IOVA_MAX_FQ_SIZE)
+			schedule_work(&cookie->fq_resize_work);
 	}
 }
 
@@ -216,10 +235,12 @@ static void queue_iova(struct iommu_dma_cookie *cookie,
 	 */
 	smp_mb();
 
+	/* Keeps the per-CPU queues alive against iommu_dma_fq_resize() */
+	rcu_read_lock();
 	if (cookie->options.qt == IOMMU_DMA_OPTS_SINGLE_QUEUE)
 		fq = cookie->single_fq;
 	else
-		fq = raw_cpu_ptr(cookie->percpu_fq);
+		fq = raw_cpu_ptr(READ_ONCE(cookie->percpu_fq));
 
 	spin_lock_irqsave(&fq->lock, flags);
 
@@ -233,6 +254,8 @@ static void queue_iova(struct iommu_dma_cookie *cookie,
 	if (fq_full(fq)) {
 		fq_flush_iotlb(cookie);
 		fq_ring_free_locked(cookie, fq);
+		if (cookie->options.qt != IOMMU_DMA_OPTS_SINGLE_QUEUE)
+			atomic_inc(&cookie->fq_full_cnt);
 	}
 
 	idx = fq_ring_add(fq);
@@ -243,6 +266,7 @@ static void queue_iova(struct iommu_dma_cookie *cookie,
 	list_splice(freelist, &fq->entries[idx].freelist);
 
 	spin_unlock_irqrestore(&fq->lock, flags);
+	rcu_read_unlock();
 
 	/* Avoid false sharing as much as possible. */
 	if (!atomic_read(&cookie->fq_timer_on) &&
@@ -281,10 +305,12 @@ static void iommu_dma_free_fq(struct iommu_dma_cookie *cookie)
 		return;
 
 	del_timer_sync(&cookie->fq_timer);
-	if (cookie->options.qt == IOMMU_DMA_OPTS_SINGLE_QUEUE)
+	if (cookie->options.qt == IOMMU_DMA_OPTS_SINGLE_QUEUE) {
 		iommu_dma_free_fq_single(cookie->single_fq);
-	else
+	} else {
+		cancel_work_sync(&cookie->fq_resize_work);
 		iommu_dma_free_fq_percpu(cookie->percpu_fq);
+	}
 }
 
 static void iommu_dma_init_one_fq(struct iova_fq *fq, size_t fq_size)
@@ -315,19 +341,62 @@ static int iommu_dma_init_fq_single(struct iommu_dma_cookie *cookie)
 	return 0;
 }
 
-static int iommu_dma_init_fq_percpu(struct iommu_dma_cookie *cookie)
+static struct iova_fq __percpu *iommu_dma_alloc_fq_percpu(size_t fq_size)
 {
-	size_t fq_size = cookie->options.fq_size;
 	struct iova_fq __percpu *queue;
 	int cpu;
 
 	queue = __alloc_percpu(struct_size(queue, entries, fq_size),
 			       __alignof__(*queue));
 	if (!queue)
-		return -ENOMEM;
+		return NULL;
 
 	for_each_possible_cpu(cpu)
 		iommu_dma_init_one_fq(per_cpu_ptr(queue, cpu), fq_size);
+	return queue;
+}
+
+/*
+ * Double the size of the per-CPU queues of a domain that keeps filling them
+ * up before the timeout, so that its unmaps at a high rate are batched into
+ * fewer IOTLB flushes. The new queues are published first, and the old ones
+ * are drained once nobody can be queueing to them any more.
+ */
+static void iommu_dma_fq_resize(struct work_struct *work)
+{
+	struct iommu_dma_cookie *cookie = container_of(work,
+			struct iommu_dma_cookie, fq_resize_work);
+	struct iova_fq __percpu *old = cookie->percpu_fq, *new;
+	size_t fq_size = cookie->options.fq_size * 2;
+	int cpu;
+
+	if (fq_size > IOVA_MAX_FQ_SIZE)
+		return;
+
+	new = iommu_dma_alloc_fq_percpu(fq_size);
+	if (!new)
+		return;
+
+	WRITE_ONCE(cookie->options.fq_size, fq_size);
+	smp_store_release(&cookie->percpu_fq, new);
+	synchronize_rcu();
+
+	fq_flush_iotlb(cookie);
+	for_each_possible_cpu(cpu)
+		fq_ring_free(cookie, per_cpu_ptr(old, cpu));
+	iommu_dma_free_fq_percpu(old);
+}
+
+static int iommu_dma_init_fq_percpu(struct iommu_dma_cookie *cookie)
+{
+	struct iova_fq __percpu *queue;
+
+	queue = iommu_dma_alloc_fq_percpu(cookie->options.fq_size);
+	if (!queue)
+		return -ENOMEM;
+
+	atomic_set(&cookie->fq_full_cnt, 0);
+	INIT_WORK(&cookie->fq_resize_work, iommu_dma_fq_resize);
 	cookie->percpu_fq = queue;
 	return 0;
 }
@@ -1238,6 +1307,126 @@ void iommu_dma_unmap_page(struct device *dev, dma_addr_t dma_handle,
 	swiotlb_tbl_unmap_single(dev, phys, size, dir, attrs);
 }
 
+/*
+ * With an IOVA granule larger than a page, whole pages are not granule
+ * aligned and may need bouncing, so leave them to iommu_dma_map_page().
+ */
+static bool iommu_dma_pages_need_single(struct iova_domain *iovad)
+{
+	return iovad->granule > PAGE_SIZE;
+}
+
+/*
+ * Map @nr pages into one contiguous IOVA range, merging physically contiguous
+ * runs into single iommu_map_nosync() calls, and make them visible to the
+ * device with a single IOTLB sync.
+ */
+int iommu_dma_map_pages(struct device *dev, struct page **pages,
+		unsigned int nr, dma_addr_t *addrs, enum dma_data_direction dir,
+		unsigned long attrs)
+{
+	bool coherent = dev_is_dma_coherent(dev);
+	int prot = dma_info_to_prot(dir, coherent, attrs);
+	struct iommu_domain *domain = iommu_get_dma_domain(dev);
+	struct iommu_dma_cookie *cookie = domain->iova_cookie;
+	struct iova_domain *iovad = &cookie->iovad;
+	size_t size = (size_t)nr << PAGE_SHIFT, mapped = 0;
+	unsigned int i, n;
+	dma_addr_t iova;
+	int ret;
+
+	if (iommu_dma_pages_need_single(iovad)) {
+		for (i = 0; i < nr; i++) {
+			addrs[i] = iommu_dma_map_page(dev, pages[i], 0,
+						      PAGE_SIZE, dir, attrs);
+			if (addrs[i] == DMA_MAPPING_ERROR)
+				goto out_unmap_single;
+		}
+		return 0;
+	}
+
+	if (static_branch_unlikely(&iommu_deferred_attach_enabled) &&
+	    iommu_deferred_attach(dev, domain))
+		return -ENOMEM;
+
+	/* If anyone ever wants this we'd need support in the IOVA allocator */
+	if (dev_WARN_ONCE(dev, dma_get_min_align_mask(dev) > iova_mask(iovad),
+	    "Unsupported alignment constraint\n"))
+		return -ENOMEM;
+
+	iova = iommu_dma_alloc_iova(domain, size, dma_get_mask(dev), dev);
+	if (!iova)
+		return -ENOMEM;
+
+	for (i = 0; i < nr; i += n) {
+		phys_addr_t phys = page_to_phys(pages[i]);
+		size_t len;
+
+		for (n = 1; i + n < nr; n++)
+			if (page_to_phys(pages[i + n]) !=
+			    phys + ((phys_addr_t)n << PAGE_SHIFT))
+				break;
+		len = (size_t)n << PAGE_SHIFT;
+
+		if (!coherent && !(attrs & DMA_ATTR_SKIP_CPU_SYNC))
+			arch_sync_dma_for_device(phys, len, dir);
+
+		ret = iommu_map_nosync(domain, iova + mapped, phys, len, prot,
+				       GFP_ATOMIC);
+		if (ret)
+			goto out_unmap;
+		mapped += len;
+	}
+
+	ret = iommu_sync_map(domain, iova, size);
+	if (ret)
+		goto out_unmap;
+
+	for (i = 0; i < nr; i++)
+		addrs[i] = iova + ((dma_addr_t)i << PAGE_SHIFT);
+	return 0;
+
+out_unmap:
+	if (mapped)
+		iommu_unmap(domain, iova, mapped);
+	iommu_dma_free_iova(cookie, iova, size, NULL);
+	return -ENOMEM;
+
+out_unmap_single:
+	while (i--)
+		iommu_dma_unmap_page(dev, addrs[i], PAGE_SIZE, dir,
+				     attrs | DMA_ATTR_SKIP_CPU_SYNC);
+	return -ENOMEM;
+}
+
+void iommu_dma_unmap_pages(struct device *dev, dma_addr_t *addrs,
+		unsigned int nr, enum dma_data_direction dir,
+		unsigned long attrs)
+{
+	struct iommu_domain *domain = iommu_get_dma_domain(dev);
+	struct iommu_dma_cookie *cookie = domain->iova_cookie;
+	unsigned int i;
+
+	if (iommu_dma_pages_need_single(&cookie->iovad)) {
+		for (i = 0; i < nr; i++)
+			iommu_dma_unmap_page(dev, addrs[i], PAGE_SIZE, dir,
+					     attrs);
+		return;
+	}
+
+	if (!(attrs & DMA_ATTR_SKIP_CPU_SYNC) && !dev_is_dma_coherent(dev)) {
+		for (i = 0; i < nr; i++) {
+			phys_addr_t phys = iommu_iova_to_phys(domain, addrs[i]);
+
+			if (!WARN_ON(!phys))
+				arch_sync_dma_for_cpu(phys, PAGE_SIZE, dir);
+		}
+	}
+
+	/* The pages were mapped into a single IOVA allocation */
+	__iommu_dma_unmap(dev, addrs[0], (size_t)nr << PAGE_SHIFT);
+}
+
 /*
  * Prepare a successfully-mapped scatterlist to give back to the caller.
  *
@@ -2475,12 +2475,21 @@ static int __iommu_map(struct iommu_domain *domain, unsigned long iova,
 	return ret;
 }
 
-int iommu_map(struct iommu_domain *domain, unsigned long iova,
-	      phys_addr_t paddr, size_t size, int prot, gfp_t gfp)
+/**
+ * iommu_map_nosync - map without syncing the IOTLB
+ * @domain: the domain to map into
+ * @iova: IO virtual address to map at
+ * @paddr: physical address to map
+ * @size: size of the mapping
+ * @prot: IOMMU_* protection flags
+ * @gfp: allocation flags for the page tables
+ *
+ * Like iommu_map(), but leaves calling iommu_sync_map() to the caller, so
+ * that several adjacent mappings can be made visible with a single sync.
+ */
+int iommu_map_nosync(struct iommu_domain *domain, unsigned long iova,
+		     phys_addr_t paddr, size_t size, int prot, gfp_t gfp)
 {
-	const struct iommu_domain_ops *ops = domain->ops;
-	int ret;
-
 	might_sleep_if(gfpflags_allow_blocking(gfp));
 
 	/* Discourage passing strange GFP flags */
@@ -2488,18 +2497,35 @@ int iommu_map(struct iommu_domain *domain, unsigned long iova,
 				__GFP_HIGHMEM)))
 		return -EINVAL;
 
-	ret = __iommu_map(domain, iova, paddr, size, prot, gfp);
-	if (ret == 0 && ops->iotlb_sync_map) {
-		ret = ops->iotlb_sync_map(domain, iova, size);
-		if (ret)
-			goto out_err;
-	}
+	return __iommu_map(domain, iova, paddr, size, prot, gfp);
+}
+EXPORT_SYMBOL_GPL(iommu_map_nosync);
 
-	return ret;
+int iommu_sync_map(struct iommu_domain *domain, unsigned long iova,
+		   size_t size)
+{
+	const struct iommu_domain_ops *ops = domain->ops;
 
-out_err:
-	/* undo mappings already done */
-	iommu_unmap(domain, iova, size);
+	if (!ops->iotlb_sync_map)
+		return 0;
+	return ops->iotlb_sync_map(domain, iova, size);
+}
+EXPORT_SYMBOL_GPL(iommu_sync_map);
+
+int iommu_map(struct iommu_domain *domain, unsigned long iova,
+	      phys_addr_t paddr, size_t size, int prot, gfp_t gfp)
+{
+	int ret;
+
+	ret = iommu_map_nosync(domain, iova, paddr, size, prot, gfp);
+	if (ret)
+		return ret;
+
+	ret = iommu_sync_map(domain, iova, size);
+	if (ret) {
+		/* undo mappings already done */
+		iommu_unmap(domain, iova, size);
+	}
 
 	return ret;
 }
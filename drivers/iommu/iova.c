@@ -6,25 +6,42 @@
  */
 
 #include <linux/iova.h>
-#include <linux/kmemleak.h>
 #include <linux/module.h>
 #include <linux/slab.h>
 #include <linux/smp.h>
 #include <linux/bitops.h>
 #include <linux/cpu.h>
 #include <linux/workqueue.h>
+#include <linux/debugfs.h>
+#include <linux/iommu.h>
+#include <linux/seq_file.h>
 
 /* The anchor node sits above the top of the usable address space */
 #define IOVA_ANCHOR	~0UL
 
 #define IOVA_RANGE_CACHE_MAX_SIZE 6	/* log of max cached IOVA range size (in pages) */
 
-static bool iova_rcache_insert(struct iova_domain *iovad,
-			       unsigned long pfn,
-			       unsigned long size);
-static unsigned long iova_rcache_get(struct iova_domain *iovad,
-				     unsigned long size,
-				     unsigned long limit_pfn);
+struct iova_rcache_stats {
+	unsigned long hits;		/* allocations served by the rcache */
+	unsigned long misses;		/* allocations from the rbtree */
+	unsigned long depot_pushes;
+	unsigned long depot_pops;
+	unsigned long remote_pops;	/* magazines taken from another node */
+	unsigned long depot_contended;
+};
+
+static DEFINE_PER_CPU(struct iova_rcache_stats, iova_rcache_stats);
+
+#define iova_stat_inc(field)	this_cpu_inc(iova_rcache_stats.field)
+#define iova_stat_add(field, n)	this_cpu_add(iova_rcache_stats.field, n)
+
+static unsigned int iova_rcache_insert(struct iova_domain *iovad,
+				       const unsigned long *pfns,
+				       unsigned int nr, unsigned long size);
+static unsigned int iova_rcache_get(struct iova_domain *iovad,
+				    unsigned long size,
+				    unsigned long limit_pfn,
+				    unsigned long *pfns, unsigned int nr);
 static void free_iova_rcaches(struct iova_domain *iovad);
 static void free_cpu_cached_iovas(unsigned int cpu, struct iova_domain *iovad);
 static void free_global_cached_iovas(struct iova_domain *iovad);
@@ -389,11 +406,11 @@ alloc_iova_fast(struct iova_domain *iovad, unsigned long size,
 	if (size < (1 << (IOVA_RANGE_CACHE_MAX_SIZE - 1)))
 		size = roundup_pow_of_two(size);
 
-	iova_pfn = iova_rcache_get(iovad, size, limit_pfn + 1);
-	if (iova_pfn)
+	if (iova_rcache_get(iovad, size, limit_pfn + 1, &iova_pfn, 1))
 		return iova_pfn;
 
 retry:
+	iova_stat_inc(misses);
 	new_iova = alloc_iova(iovad, size, limit_pfn, true);
 	if (!new_iova) {
 		unsigned int cpu;
@@ -424,13 +441,69 @@ EXPORT_SYMBOL_GPL(alloc_iova_fast);
 void
 free_iova_fast(struct iova_domain *iovad, unsigned long pfn, unsigned long size)
 {
-	if (iova_rcache_insert(iovad, pfn, size))
+	if (iova_rcache_insert(iovad, &pfn, 1, size))
 		return;
 
 	free_iova(iovad, pfn);
 }
 EXPORT_SYMBOL_GPL(free_iova_fast);
 
+/**
+ * alloc_iova_fast_bulk - allocates several iovas of the same size
+ * @iovad: - iova domain in question
+ * @size: - size of page frames to allocate
+ * @limit_pfn: - max limit address
+ * @pfns: - array receiving the allocated pfns
+ * @nr: - number of iovas to allocate
+ * This function is the batched version of alloc_iova_fast() for callers
+ * such as RX refill paths, taking the rcache lock once for the whole batch.
+ * The rcache is not flushed on failure. Returns the number of iovas
+ * allocated, which may be less than @nr.
+ */
+unsigned int
+alloc_iova_fast_bulk(struct iova_domain *iovad, unsigned long size,
+		     unsigned long limit_pfn, unsigned long *pfns,
+		     unsigned int nr)
+{
+	struct iova *new_iova;
+	unsigned int i;
+
+	/* See alloc_iova_fast() */
+	if (size < (1 << (IOVA_RANGE_CACHE_MAX_SIZE - 1)))
+		size = roundup_pow_of_two(size);
+
+	i = iova_rcache_get(iovad, size, limit_pfn + 1, pfns, nr);
+	for (; i < nr; i++) {
+		iova_stat_inc(misses);
+		new_iova = alloc_iova(iovad, size, limit_pfn, true);
+		if (!new_iova)
+			break;
+		pfns[i] = new_iova->pfn_lo;
+	}
+
+	return i;
+}
+EXPORT_SYMBOL_GPL(alloc_iova_fast_bulk);
+
+/**
+ * free_iova_fast_bulk - free several iova ranges of the same size into rcache
+ * @iovad: - iova domain in question.
+ * @pfns: - pfns that were allocated previously
+ * @nr: - number of ranges
+ * @size: - # of pages in each range
+ * This function is the batched version of free_iova_fast().
+ */
+void
+free_iova_fast_bulk(struct iova_domain *iovad, const unsigned long *pfns,
+		    unsigned int nr, unsigned long size)
+{
+	unsigned int i = iova_rcache_insert(iovad, pfns, nr, size);
+
+	for (; i < nr; i++)
+		free_iova(iovad, pfns[i]);
+}
+EXPORT_SYMBOL_GPL(free_iova_fast_bulk);
+
 static void iova_domain_free_rcaches(struct iova_domain *iovad)
 {
 	cpuhp_state_remove_instance_nocalls(CPUHP_IOMMU_IOVA_DEAD,
@@ -553,25 +626,24 @@ EXPORT_SYMBOL_GPL(reserve_iova);
  * Magazine caches for IOVA ranges.  For an introduction to magazines,
  * see the USENIX 2001 paper "Magazines and Vmem: Extending the Slab
  * Allocator to Many CPUs and Arbitrary Resources" by Bonwick and Adams.
- * For simplicity, we use a static magazine size and don't implement the
- * dynamic size tuning described in the paper.
+ * Full magazines are kept in one depot per NUMA node, and as described in
+ * the paper, magazines start small and grow whenever a depot lock is found
+ * contended, so that busy caches go to the depots less often.
  */
 
 /*
- * As kmalloc's buffer size is fixed to power of 2, 127 is chosen to
+ * As kmalloc's buffer size is fixed to power of 2, 126 is chosen to
  * assure size of 'iova_magazine' to be 1024 bytes, so that no memory
- * will be wasted. Since only full magazines are inserted into the depot,
- * we don't need to waste PFN capacity on a separate list head either.
+ * will be wasted.
  */
-#define IOVA_MAG_SIZE 127
+#define IOVA_MAG_SIZE 126
+#define IOVA_MAG_INIT_SIZE 32
 
 #define IOVA_DEPOT_DELAY msecs_to_jiffies(100)
 
 struct iova_magazine {
-	union {
-		unsigned long size;
-		struct iova_magazine *next;
-	};
+	unsigned long size;
+	struct iova_magazine *next;
 	unsigned long pfns[IOVA_MAG_SIZE];
 };
 static_assert(!(sizeof(struct iova_magazine) & (sizeof(struct iova_magazine) - 1)));
@@ -582,10 +654,15 @@ struct iova_cpu_rcache {
 	struct iova_magazine *prev;
 };
 
-struct iova_rcache {
+struct iova_depot {
 	spinlock_t lock;
-	unsigned int depot_size;
-	struct iova_magazine *depot;
+	unsigned int size;
+	struct iova_magazine *head;
+} ____cacheline_aligned_in_smp;
+
+struct iova_rcache {
+	unsigned int mag_size;
+	struct iova_depot *depots;	/* indexed by NUMA node */
 	struct iova_cpu_rcache __percpu *cpu_rcaches;
 	struct iova_domain *iovad;
 	struct delayed_work work;
@@ -637,9 +714,10 @@ iova_magazine_free_pfns(struct iova_magazine *mag, struct iova_domain *iovad)
 	mag->size = 0;
 }
 
-static bool iova_magazine_full(struct iova_magazine *mag)
+static bool iova_magazine_full(struct iova_rcache *rcache,
+			       struct iova_magazine *mag)
 {
-	return mag->size == IOVA_MAG_SIZE;
+	return mag->size >= READ_ONCE(rcache->mag_size);
 }
 
 static bool iova_magazine_empty(struct iova_magazine *mag)
@@ -670,50 +748,69 @@ static void iova_magazine_push(struct iova_magazine *mag, unsigned long pfn)
 	mag->pfns[mag->size++] = pfn;
 }
 
-static struct iova_magazine *iova_depot_pop(struct iova_rcache *rcache)
+static struct iova_magazine *iova_depot_pop(struct iova_depot *depot)
 {
-	struct iova_magazine *mag = rcache->depot;
+	struct iova_magazine *mag = depot->head;
 
-	/*
-	 * As the mag->next pointer is moved to rcache->depot and reset via
-	 * the mag->size assignment, mark it as a transient false positive.
-	 */
-	kmemleak_transient_leak(mag->next);
-	rcache->depot = mag->next;
-	mag->size = IOVA_MAG_SIZE;
-	rcache->depot_size--;
+	depot->head = mag->next;
+	depot->size--;
 	return mag;
 }
 
-static void iova_depot_push(struct iova_rcache *rcache, struct iova_magazine *mag)
+static void iova_depot_push(struct iova_depot *depot, struct iova_magazine *mag)
 {
-	mag->next = rcache->depot;
-	rcache->depot = mag;
-	rcache->depot_size++;
+	mag->next = depot->head;
+	depot->head = mag;
+	depot->size++;
+}
+
+/* Called with interrupts disabled, under the lock of a CPU cache */
+static void iova_depot_lock(struct iova_rcache *rcache, struct iova_depot *depot)
+{
+	unsigned int mag_size;
+
+	if (spin_trylock(&depot->lock))
+		return;
+
+	iova_stat_inc(depot_contended);
+	mag_size = READ_ONCE(rcache->mag_size);
+	if (mag_size < IOVA_MAG_SIZE)
+		WRITE_ONCE(rcache->mag_size, min_t(unsigned int, 2 * mag_size, IOVA_MAG_SIZE));
+
+	spin_lock(&depot->lock);
 }
 
 static void iova_depot_work_func(struct work_struct *work)
 {
 	struct iova_rcache *rcache = container_of(work, typeof(*rcache), work.work);
-	struct iova_magazine *mag = NULL;
-	unsigned long flags;
+	bool trimmed = false;
+	int nid;
 
-	spin_lock_irqsave(&rcache->lock, flags);
-	if (rcache->depot_size > num_online_cpus())
-		mag = iova_depot_pop(rcache);
-	spin_unlock_irqrestore(&rcache->lock, flags);
+	for_each_node(nid) {
+		struct iova_depot *depot = &rcache->depots[nid];
+		struct iova_magazine *mag = NULL;
+		unsigned long flags;
 
-	if (mag) {
-		iova_magazine_free_pfns(mag, rcache->iovad);
-		iova_magazine_free(mag);
-		schedule_delayed_work(&rcache->work, IOVA_DEPOT_DELAY);
+		spin_lock_irqsave(&depot->lock, flags);
+		if (depot->size > nr_cpus_node(nid))
+			mag = iova_depot_pop(depot);
+		spin_unlock_irqrestore(&depot->lock, flags);
+
+		if (mag) {
+			iova_magazine_free_pfns(mag, rcache->iovad);
+			iova_magazine_free(mag);
+			trimmed = true;
+		}
 	}
+
+	if (trimmed)
+		schedule_delayed_work(&rcache->work, IOVA_DEPOT_DELAY);
 }
 
 int iova_domain_init_rcaches(struct iova_domain *iovad)
 {
 	unsigned int cpu;
-	int i, ret;
+	int i, nid, ret;
 
 	iovad->rcaches = kcalloc(IOVA_RANGE_CACHE_MAX_SIZE,
 				 sizeof(struct iova_rcache),
@@ -726,9 +823,17 @@ int iova_domain_init_rcaches(struct iova_domain *iovad)
 		struct iova_rcache *rcache;
 
 		rcache = &iovad->rcaches[i];
-		spin_lock_init(&rcache->lock);
+		rcache->mag_size = IOVA_MAG_INIT_SIZE;
 		rcache->iovad = iovad;
 		INIT_DELAYED_WORK(&rcache->work, iova_depot_work_func);
+		rcache->depots = kcalloc(nr_node_ids, sizeof(*rcache->depots),
+					 GFP_KERNEL);
+		if (!rcache->depots) {
+			ret = -ENOMEM;
+			goto out_err;
+		}
+		for_each_node(nid)
+			spin_lock_init(&rcache->depots[nid].lock);
 		rcache->cpu_rcaches = __alloc_percpu(sizeof(*cpu_rcache),
 						     cache_line_size());
 		if (!rcache->cpu_rcaches) {
@@ -761,114 +866,170 @@ int iova_domain_init_rcaches(struct iova_domain *iovad)
 EXPORT_SYMBOL_GPL(iova_domain_init_rcaches);
 
 /*
- * Try inserting IOVA range starting with 'iova_pfn' into 'rcache', and
- * return true on success.  Can fail if rcache is full and we can't free
- * space, and free_iova() (our only caller) will then return the IOVA
- * range to the rbtree instead.
+ * Hand the full loaded magazine of a CPU over to the depot of its node,
+ * and replace it with an empty one.
  */
-static bool __iova_rcache_insert(struct iova_domain *iovad,
-				 struct iova_rcache *rcache,
-				 unsigned long iova_pfn)
+static bool iova_depot_put(struct iova_rcache *rcache,
+			   struct iova_cpu_rcache *cpu_rcache)
+{
+	struct iova_magazine *new_mag = iova_magazine_alloc(GFP_ATOMIC);
+	struct iova_depot *depot = &rcache->depots[numa_node_id()];
+
+	if (!new_mag)
+		return false;
+
+	iova_depot_lock(rcache, depot);
+	iova_depot_push(depot, cpu_rcache->loaded);
+	spin_unlock(&depot->lock);
+	schedule_delayed_work(&rcache->work, IOVA_DEPOT_DELAY);
+	iova_stat_inc(depot_pushes);
+
+	cpu_rcache->loaded = new_mag;
+	return true;
+}
+
+/*
+ * Replace the empty loaded magazine of a CPU with a full one from the depot
+ * of its node or, rather than falling back to the rbtree, of another node.
+ */
+static bool iova_depot_get(struct iova_rcache *rcache,
+			   struct iova_cpu_rcache *cpu_rcache)
+{
+	int nid, local = numa_node_id();
+	struct iova_depot *depot = &rcache->depots[local];
+	struct iova_magazine *mag = NULL;
+
+	iova_depot_lock(rcache, depot);
+	if (depot->head)
+		mag = iova_depot_pop(depot);
+	spin_unlock(&depot->lock);
+
+	for_each_node(nid) {
+		if (mag)
+			break;
+
+		depot = &rcache->depots[nid];
+		if (nid == local || !READ_ONCE(depot->head))
+			continue;
+
+		spin_lock(&depot->lock);
+		if (depot->head) {
+			mag = iova_depot_pop(depot);
+			iova_stat_inc(remote_pops);
+		}
+		spin_unlock(&depot->lock);
+	}
+
+	if (!mag)
+		return false;
+
+	iova_stat_inc(depot_pops);
+	iova_magazine_free(cpu_rcache->loaded);
+	cpu_rcache->loaded = mag;
+	return true;
+}
+
+/*
+ * Try inserting the IOVA ranges starting with 'pfns' into 'rcache', and
+ * return how many were inserted.  Can fall short if rcache is full and we
+ * can't free space, and the callers will then return the remaining IOVA
+ * ranges to the rbtree instead.
+ */
+static unsigned int __iova_rcache_insert(struct iova_domain *iovad,
+					 struct iova_rcache *rcache,
+					 const unsigned long *pfns,
+					 unsigned int nr)
 {
 	struct iova_cpu_rcache *cpu_rcache;
-	bool can_insert = false;
 	unsigned long flags;
+	unsigned int i;
 
 	cpu_rcache = raw_cpu_ptr(rcache->cpu_rcaches);
 	spin_lock_irqsave(&cpu_rcache->lock, flags);
 
-	if (!iova_magazine_full(cpu_rcache->loaded)) {
-		can_insert = true;
-	} else if (!iova_magazine_full(cpu_rcache->prev)) {
-		swap(cpu_rcache->prev, cpu_rcache->loaded);
-		can_insert = true;
-	} else {
-		struct iova_magazine *new_mag = iova_magazine_alloc(GFP_ATOMIC);
-
-		if (new_mag) {
-			spin_lock(&rcache->lock);
-			iova_depot_push(rcache, cpu_rcache->loaded);
-			spin_unlock(&rcache->lock);
-			schedule_delayed_work(&rcache->work, IOVA_DEPOT_DELAY);
-
-			cpu_rcache->loaded = new_mag;
-			can_insert = true;
+	for (i = 0; i < nr; i++) {
+		if (iova_magazine_full(rcache, cpu_rcache->loaded)) {
+			if (!iova_magazine_full(rcache, cpu_rcache->prev))
+				swap(cpu_rcache->prev, cpu_rcache->loaded);
+			else if (!iova_depot_put(rcache, cpu_rcache))
+				break;
 		}
-	}
 
-	if (can_insert)
-		iova_magazine_push(cpu_rcache->loaded, iova_pfn);
+		iova_magazine_push(cpu_rcache->loaded, pfns[i]);
+	}
 
 	spin_unlock_irqrestore(&cpu_rcache->lock, flags);
 
-	return can_insert;
+	return i;
 }
 
-static bool iova_rcache_insert(struct iova_domain *iovad, unsigned long pfn,
-			       unsigned long size)
+static unsigned int iova_rcache_insert(struct iova_domain *iovad,
+				       const unsigned long *pfns,
+				       unsigned int nr, unsigned long size)
 {
 	unsigned int log_size = order_base_2(size);
 
 	if (log_size >= IOVA_RANGE_CACHE_MAX_SIZE)
-		return false;
+		return 0;
 
-	return __iova_rcache_insert(iovad, &iovad->rcaches[log_size], pfn);
+	return __iova_rcache_insert(iovad, &iovad->rcaches[log_size], pfns, nr);
 }
 
 /*
- * Caller wants to allocate a new IOVA range from 'rcache'.  If we can
- * satisfy the request, return a matching non-NULL range and remove
- * it from the 'rcache'.
+ * Caller wants to allocate new IOVA ranges from 'rcache'.  Store the
+ * matching ranges we can satisfy the request with in 'pfns', remove them
+ * from the 'rcache' and return how many they are.
  */
-static unsigned long __iova_rcache_get(struct iova_rcache *rcache,
-				       unsigned long limit_pfn)
+static unsigned int __iova_rcache_get(struct iova_rcache *rcache,
+				      unsigned long limit_pfn,
+				      unsigned long *pfns, unsigned int nr)
 {
 	struct iova_cpu_rcache *cpu_rcache;
-	unsigned long iova_pfn = 0;
-	bool has_pfn = false;
-	unsigned long flags;
+	unsigned long flags, pfn;
+	unsigned int i;
 
 	cpu_rcache = raw_cpu_ptr(rcache->cpu_rcaches);
 	spin_lock_irqsave(&cpu_rcache->lock, flags);
 
-	if (!iova_magazine_empty(cpu_rcache->loaded)) {
-		has_pfn = true;
-	} else if (!iova_magazine_empty(cpu_rcache->prev)) {
-		swap(cpu_rcache->prev, cpu_rcache->loaded);
-		has_pfn = true;
-	} else {
-		spin_lock(&rcache->lock);
-		if (rcache->depot) {
-			iova_magazine_free(cpu_rcache->loaded);
-			cpu_rcache->loaded = iova_depot_pop(rcache);
-			has_pfn = true;
+	for (i = 0; i < nr; i++) {
+		if (iova_magazine_empty(cpu_rcache->loaded)) {
+			if (!iova_magazine_empty(cpu_rcache->prev))
+				swap(cpu_rcache->prev, cpu_rcache->loaded);
+			else if (!iova_depot_get(rcache, cpu_rcache))
+				break;
 		}
-		spin_unlock(&rcache->lock);
-	}
 
-	if (has_pfn)
-		iova_pfn = iova_magazine_pop(cpu_rcache->loaded, limit_pfn);
+		pfn = iova_magazine_pop(cpu_rcache->loaded, limit_pfn);
+		if (!pfn)
+			break;
+		pfns[i] = pfn;
+	}
 
 	spin_unlock_irqrestore(&cpu_rcache->lock, flags);
 
-	return iova_pfn;
+	return i;
 }
 
 /*
- * Try to satisfy IOVA allocation range from rcache.  Fail if requested
+ * Try to satisfy IOVA allocation ranges from rcache.  Fail if requested
  * size is too big or the DMA limit we are given isn't satisfied by the
  * top element in the magazine.
  */
-static unsigned long iova_rcache_get(struct iova_domain *iovad,
-				     unsigned long size,
-				     unsigned long limit_pfn)
+static unsigned int iova_rcache_get(struct iova_domain *iovad,
+				    unsigned long size,
+				    unsigned long limit_pfn,
+				    unsigned long *pfns, unsigned int nr)
 {
 	unsigned int log_size = order_base_2(size);
+	unsigned int got;
 
 	if (log_size >= IOVA_RANGE_CACHE_MAX_SIZE)
 		return 0;
 
-	return __iova_rcache_get(&iovad->rcaches[log_size], limit_pfn - size);
+	got = __iova_rcache_get(&iovad->rcaches[log_size], limit_pfn - size,
+				pfns, nr);
+	iova_stat_add(hits, got);
+	return got;
 }
 
 /*
@@ -878,21 +1039,29 @@ static void free_iova_rcaches(struct iova_domain *iovad)
 {
 	struct iova_rcache *rcache;
 	struct iova_cpu_rcache *cpu_rcache;
+	struct iova_depot *depot;
 	unsigned int cpu;
+	int nid;
 
 	for (int i = 0; i < IOVA_RANGE_CACHE_MAX_SIZE; ++i) {
 		rcache = &iovad->rcaches[i];
-		if (!rcache->cpu_rcaches)
+		if (!rcache->depots)
 			break;
-		for_each_possible_cpu(cpu) {
-			cpu_rcache = per_cpu_ptr(rcache->cpu_rcaches, cpu);
-			iova_magazine_free(cpu_rcache->loaded);
-			iova_magazine_free(cpu_rcache->prev);
+		if (rcache->cpu_rcaches) {
+			for_each_possible_cpu(cpu) {
+				cpu_rcache = per_cpu_ptr(rcache->cpu_rcaches, cpu);
+				iova_magazine_free(cpu_rcache->loaded);
+				iova_magazine_free(cpu_rcache->prev);
+			}
+			free_percpu(rcache->cpu_rcaches);
 		}
-		free_percpu(rcache->cpu_rcaches);
 		cancel_delayed_work_sync(&rcache->work);
-		while (rcache->depot)
-			iova_magazine_free(iova_depot_pop(rcache));
+		for_each_node(nid) {
+			depot = &rcache->depots[nid];
+			while (depot->head)
+				iova_magazine_free(iova_depot_pop(depot));
+		}
+		kfree(rcache->depots);
 	}
 
 	kfree(iovad->rcaches);
@@ -924,22 +1093,73 @@ static void free_cpu_cached_iovas(unsigned int cpu, struct iova_domain *iovad)
  */
 static void free_global_cached_iovas(struct iova_domain *iovad)
 {
-	struct iova_rcache *rcache;
+	struct iova_depot *depot;
 	unsigned long flags;
+	int nid;
 
 	for (int i = 0; i < IOVA_RANGE_CACHE_MAX_SIZE; ++i) {
-		rcache = &iovad->rcaches[i];
-		spin_lock_irqsave(&rcache->lock, flags);
-		while (rcache->depot) {
-			struct iova_magazine *mag = iova_depot_pop(rcache);
-
-			iova_magazine_free_pfns(mag, iovad);
-			iova_magazine_free(mag);
+		for_each_node(nid) {
+			depot = &iovad->rcaches[i].depots[nid];
+			spin_lock_irqsave(&depot->lock, flags);
+			while (depot->head) {
+				struct iova_magazine *mag = iova_depot_pop(depot);
+
+				iova_magazine_free_pfns(mag, iovad);
+				iova_magazine_free(mag);
+			}
+			spin_unlock_irqrestore(&depot->lock, flags);
 		}
-		spin_unlock_irqrestore(&rcache->lock, flags);
 	}
 }
 
+#ifdef CONFIG_IOMMU_DEBUGFS
+static struct dentry *iova_debugfs_file;
+
+static int iova_stats_show(struct seq_file *m, void *unused)
+{
+	struct iova_rcache_stats sum = {};
+	unsigned int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct iova_rcache_stats *stats = per_cpu_ptr(&iova_rcache_stats, cpu);
+
+		sum.hits += stats->hits;
+		sum.misses += stats->misses;
+		sum.depot_pushes += stats->depot_pushes;
+		sum.depot_pops += stats->depot_pops;
+		sum.remote_pops += stats->remote_pops;
+		sum.depot_contended += stats->depot_contended;
+	}
+
+	seq_printf(m, "rcache_hits: %lu\n", sum.hits);
+	seq_printf(m, "rcache_misses: %lu\n", sum.misses);
+	seq_printf(m, "depot_pushes: %lu\n", sum.depot_pushes);
+	seq_printf(m, "depot_pops: %lu\n", sum.depot_pops);
+	seq_printf(m, "depot_remote_pops: %lu\n", sum.remote_pops);
+	seq_printf(m, "depot_contended: %lu\n", sum.depot_contended);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(iova_stats);
+
+static void iova_debugfs_init(void)
+{
+	if (iommu_debugfs_dir)
+		iova_debugfs_file = debugfs_create_file("iova_stats", 0444,
+							iommu_debugfs_dir, NULL,
+							&iova_stats_fops);
+}
+
+static void iova_debugfs_exit(void)
+{
+	debugfs_remove(iova_debugfs_file);
+	iova_debugfs_file = NULL;
+}
+#else
+static inline void iova_debugfs_init(void) {}
+static inline void iova_debugfs_exit(void) {}
+#endif
+
 static int iova_cpuhp_dead(unsigned int cpu, struct hlist_node *node)
 {
 	struct iova_domain *iovad;
@@ -973,6 +1193,8 @@ int iova_cache_get(void)
 			pr_err("IOVA: Couldn't register cpuhp handler: %pe\n", ERR_PTR(err));
 			goto out_err;
 		}
+
+		iova_debugfs_init();
 	}
 
 	iova_cache_users++;
@@ -997,6 +1219,7 @@ void iova_cache_put(void)
 	}
 	iova_cache_users--;
 	if (!iova_cache_users) {
+		iova_debugfs_exit();
 		cpuhp_remove_multi_state(CPUHP_IOMMU_IOVA_DEAD);
 		kmem_cache_destroy(iova_cache);
 		kmem_cache_destroy(iova_magazine_cache);
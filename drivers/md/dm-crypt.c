@@ -149,6 +149,7 @@ enum cipher_flags {
 	CRYPT_IV_LARGE_SECTORS,		/* Calculate IV from sector_size, not 512B sectors */
 	CRYPT_ENCRYPT_PREPROCESS,	/* Must preprocess data for encryption (elephant) */
 	CRYPT_KEY_MAC_SIZE_SET,		/* The integrity_key_size option was used */
+	CRYPT_MULTI_DATA_UNIT,		/* Encrypt several sectors per request */
 };
 
 /*
@@ -1424,16 +1425,38 @@ static int crypt_convert_block_aead(struct crypt_config *cc,
 	return r;
 }
 
+/*
+ * Number of sectors to process with the next request: all those of the
+ * current page segment when the cipher can take them at once, else one.
+ */
+static unsigned int crypt_convert_nr_sectors(struct crypt_config *cc,
+					     struct convert_context *ctx)
+{
+	struct bio_vec bv_in, bv_out;
+	unsigned int len;
+
+	if (!test_bit(CRYPT_MULTI_DATA_UNIT, &cc->cipher_flags))
+		return 1;
+
+	bv_in = bio_iter_iovec(ctx->bio_in, ctx->iter_in);
+	bv_out = bio_iter_iovec(ctx->bio_out, ctx->iter_out);
+	len = min(bv_in.bv_len, bv_out.bv_len);
+
+	return max(len >> (SECTOR_SHIFT + cc->sector_shift), 1U);
+}
+
 static int crypt_convert_block_skcipher(struct crypt_config *cc,
 					struct convert_context *ctx,
 					struct skcipher_request *req,
-					unsigned int tag_offset)
+					unsigned int tag_offset,
+					unsigned int nr_sectors)
 {
 	struct bio_vec bv_in = bio_iter_iovec(ctx->bio_in, ctx->iter_in);
 	struct bio_vec bv_out = bio_iter_iovec(ctx->bio_out, ctx->iter_out);
 	struct scatterlist *sg_in, *sg_out;
 	struct dm_crypt_request *dmreq;
 	u8 *iv, *org_iv, *tag_iv;
+	unsigned int len = nr_sectors * cc->sector_size;
 	__le64 *sector;
 	int r = 0;
 
@@ -1461,10 +1484,10 @@ static int crypt_convert_block_skcipher(struct crypt_config *cc,
 	sg_out = &dmreq->sg_out[0];
 
 	sg_init_table(sg_in, 1);
-	sg_set_page(sg_in, bv_in.bv_page, cc->sector_size, bv_in.bv_offset);
+	sg_set_page(sg_in, bv_in.bv_page, len, bv_in.bv_offset);
 
 	sg_init_table(sg_out, 1);
-	sg_set_page(sg_out, bv_out.bv_page, cc->sector_size, bv_out.bv_offset);
+	sg_set_page(sg_out, bv_out.bv_page, len, bv_out.bv_offset);
 
 	if (cc->iv_gen_ops) {
 		/* For READs use IV stored in integrity metadata */
@@ -1485,7 +1508,9 @@ static int crypt_convert_block_skcipher(struct crypt_config *cc,
 		memcpy(iv, org_iv, cc->iv_size);
 	}
 
-	skcipher_request_set_crypt(req, sg_in, sg_out, cc->sector_size, iv);
+	skcipher_request_set_crypt(req, sg_in, sg_out, len, iv);
+	if (nr_sectors > 1)
+		skcipher_request_set_data_unit_size(req, cc->sector_size);
 
 	if (bio_data_dir(ctx->bio_in) == WRITE)
 		r = crypto_skcipher_encrypt(req);
@@ -1495,8 +1520,8 @@ static int crypt_convert_block_skcipher(struct crypt_config *cc,
 	if (!r && cc->iv_gen_ops && cc->iv_gen_ops->post)
 		r = cc->iv_gen_ops->post(cc, org_iv, dmreq);
 
-	bio_advance_iter(ctx->bio_in, &ctx->iter_in, cc->sector_size);
-	bio_advance_iter(ctx->bio_out, &ctx->iter_out, cc->sector_size);
+	bio_advance_iter(ctx->bio_in, &ctx->iter_in, len);
+	bio_advance_iter(ctx->bio_out, &ctx->iter_out, len);
 
 	return r;
 }
@@ -1602,6 +1627,7 @@ static blk_status_t crypt_convert(struct crypt_config *cc,
 		atomic_set(&ctx->cc_pending, 1);
 
 	while (ctx->iter_in.bi_size && ctx->iter_out.bi_size) {
+		unsigned int nr_sectors = 1;
 
 		r = crypt_alloc_req(cc, ctx);
 		if (r) {
@@ -1611,10 +1637,13 @@ static blk_status_t crypt_convert(struct crypt_config *cc,
 
 		atomic_inc(&ctx->cc_pending);
 
-		if (crypt_integrity_aead(cc))
+		if (crypt_integrity_aead(cc)) {
 			r = crypt_convert_block_aead(cc, ctx, ctx->r.req_aead, ctx->tag_offset);
-		else
-			r = crypt_convert_block_skcipher(cc, ctx, ctx->r.req, ctx->tag_offset);
+		} else {
+			nr_sectors = crypt_convert_nr_sectors(cc, ctx);
+			r = crypt_convert_block_skcipher(cc, ctx, ctx->r.req,
+							 ctx->tag_offset, nr_sectors);
+		}
 
 		switch (r) {
 		/*
@@ -1634,8 +1663,8 @@ static blk_status_t crypt_convert(struct crypt_config *cc,
 					 * exit and continue processing in a workqueue
 					 */
 					ctx->r.req = NULL;
-					ctx->tag_offset++;
-					ctx->cc_sector += sector_step;
+					ctx->tag_offset += nr_sectors;
+					ctx->cc_sector += sector_step * nr_sectors;
 					return BLK_STS_DEV_RESOURCE;
 				}
 			} else {
@@ -1649,16 +1678,16 @@ static blk_status_t crypt_convert(struct crypt_config *cc,
 		 */
 		case -EINPROGRESS:
 			ctx->r.req = NULL;
-			ctx->tag_offset++;
-			ctx->cc_sector += sector_step;
+			ctx->tag_offset += nr_sectors;
+			ctx->cc_sector += sector_step * nr_sectors;
 			continue;
 		/*
 		 * The request was already processed (synchronously).
 		 */
 		case 0:
 			atomic_dec(&ctx->cc_pending);
-			ctx->cc_sector += sector_step;
-			ctx->tag_offset++;
+			ctx->cc_sector += sector_step * nr_sectors;
+			ctx->tag_offset += nr_sectors;
 			if (!atomic)
 				cond_resched();
 			continue;
@@ -3309,6 +3338,19 @@ static int crypt_ctr(struct dm_target *ti, unsigned int argc, char **argv)
 	if (ret < 0)
 		goto bad;
 
+	/*
+	 * With one key and plain64 IVs, consecutive sectors have consecutive
+	 * IVs, and a cipher that supports data units can take all those of
+	 * a page in a single request.
+	 */
+	if (!crypt_integrity_aead(cc) && !cc->integrity_tag_size &&
+	    !cc->integrity_iv_size && cc->tfms_count == 1 &&
+	    cc->iv_gen_ops == &crypt_iv_plain64_ops &&
+	    (cc->sector_size == (1 << SECTOR_SHIFT) ||
+	     test_bit(CRYPT_IV_LARGE_SECTORS, &cc->cipher_flags)) &&
+	    crypto_skcipher_multi_data_unit(any_tfm(cc)))
+		set_bit(CRYPT_MULTI_DATA_UNIT, &cc->cipher_flags);
+
 	if (crypt_integrity_aead(cc)) {
 		cc->dmreq_start = sizeof(struct aead_request);
 		cc->dmreq_start += crypto_aead_reqsize(any_tfm_aead(cc));
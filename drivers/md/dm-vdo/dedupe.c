@@ -123,6 +123,7 @@
 #include <linux/list.h>
 #include <linux/ratelimit.h>
 #include <linux/spinlock.h>
+#include <linux/nodemask.h>
 #include <linux/timer.h>
 
 #include "logger.h"
@@ -2344,6 +2345,23 @@ static void timeout_index_operations(struct timer_list *t)
 		vdo_launch_completion(&zone->completion);
 }
 
+/*
+ * Spread the zones round-robin over the nodes with CPUs, so that each node gets its share of the
+ * zone threads.
+ */
+static int get_zone_node(zone_count_t zone_number)
+{
+	unsigned int n = zone_number % num_node_state(N_CPU);
+	int node;
+
+	for_each_node_state(node, N_CPU) {
+		if (n-- == 0)
+			return node;
+	}
+
+	return NUMA_NO_NODE;
+}
+
 static int __must_check initialize_zone(struct vdo *vdo, struct hash_zones *zones,
 					zone_count_t zone_number)
 {
@@ -2387,7 +2405,20 @@ static int __must_check initialize_zone(struct vdo *vdo, struct hash_zones *zone
 		list_add(&context->list_entry, &zone->available);
 	}
 
-	return vdo_make_default_thread(vdo, zone->thread_id);
+	result = vdo_make_default_thread(vdo, zone->thread_id);
+	if (result != VDO_SUCCESS)
+		return result;
+
+	zone->numa_node = NUMA_NO_NODE;
+	if (vdo->device_config->thread_counts.auto_hash_zones &&
+	    (num_node_state(N_CPU) > 1)) {
+		zone->numa_node = get_zone_node(zone_number);
+		if (zone->numa_node != NUMA_NO_NODE)
+			vdo_set_work_queue_node(vdo->threads[zone->thread_id].queue,
+						zone->numa_node);
+	}
+
+	return VDO_SUCCESS;
 }
 
 /** get_thread_id_for_zone() - Implements vdo_zone_thread_getter_fn. */
@@ -2788,8 +2819,10 @@ static void dump_hash_zone(const struct hash_zone *zone)
 		return;
 	}
 
-	vdo_log_info("struct hash_zone %u: mapSize=%zu",
-		     zone->zone_number, vdo_int_map_size(zone->hash_lock_map));
+	vdo_log_info("struct hash_zone %u: node=%d mapSize=%zu queries=%llu active=%u maxActive=%u",
+		     zone->zone_number, zone->numa_node, vdo_int_map_size(zone->hash_lock_map),
+		     (unsigned long long) READ_ONCE(zone->queries), READ_ONCE(zone->active),
+		     READ_ONCE(zone->max_active));
 	for (i = 0; i < LOCK_POOL_CAPACITY; i++)
 		dump_hash_lock(&zone->lock_array[i]);
 }
@@ -2869,6 +2902,8 @@ static struct dedupe_context * __must_check acquire_context(struct hash_zone *zo
 
 	if (!list_empty(&zone->available)) {
 		WRITE_ONCE(zone->active, zone->active + 1);
+		if (zone->active > zone->max_active)
+			WRITE_ONCE(zone->max_active, zone->active);
 		context = list_first_entry(&zone->available, struct dedupe_context,
 					   list_entry);
 		list_del_init(&context->list_entry);
@@ -2930,6 +2965,7 @@ static void query_index(struct data_vio *data_vio, enum uds_request_type operati
 	prepare_uds_request(&context->request, data_vio, operation);
 	atomic_set(&context->state, DEDUPE_CONTEXT_PENDING);
 	list_add_tail(&context->list_entry, &zone->pending);
+	WRITE_ONCE(zone->queries, zone->queries + 1);
 	start_expiration_timer(context);
 	result = uds_launch_request(&context->request);
 	if (result != UDS_SUCCESS) {
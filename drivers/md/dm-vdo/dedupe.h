@@ -39,6 +39,9 @@ struct hash_zone {
 	/* The thread ID for this zone */
 	thread_id_t thread_id;
 
+	/* The NUMA node the zone thread runs on, or NUMA_NO_NODE if it is not bound */
+	int numa_node;
+
 	/* Mapping from record name fields to hash_locks */
 	struct int_map *hash_lock_map;
 
@@ -63,6 +66,13 @@ struct hash_zone {
 	unsigned int active;
 	atomic_t timer_state;
 
+	/*
+	 * Queueing statistics of the zone, only modified on the zone thread: the number of index
+	 * queries issued and the largest number of them outstanding at once.
+	 */
+	u64 queries;
+	unsigned int max_active;
+
 	/* The dedupe contexts for querying the index from this zone */
 	struct dedupe_context contexts[MAXIMUM_VDO_USER_VIOS];
 };
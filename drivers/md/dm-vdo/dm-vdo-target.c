@@ -10,6 +10,7 @@
 #include <linux/device-mapper.h>
 #include <linux/err.h>
 #include <linux/module.h>
+#include <linux/cpumask.h>
 #include <linux/mutex.h>
 #include <linux/spinlock.h>
 
@@ -395,6 +396,21 @@ static int process_one_thread_config_spec(const char *thread_param_type,
 					  unsigned int count,
 					  struct thread_count_config *config)
 {
+	/* Handle automatically scaled thread parameters */
+	if (count == VDO_AUTO_THREAD_COUNT) {
+		if (strcmp(thread_param_type, "hash") == 0) {
+			config->hash_zones = count;
+			return VDO_SUCCESS;
+		}
+		if (strcmp(thread_param_type, "cpu") == 0) {
+			config->cpu_threads = count;
+			return VDO_SUCCESS;
+		}
+		vdo_log_error("thread config string error: '%s' threads cannot be 'auto'",
+			      thread_param_type);
+		return -EINVAL;
+	}
+
 	/* Handle limited thread parameters */
 	if (strcmp(thread_param_type, "bioRotationInterval") == 0) {
 		if (count == 0) {
@@ -465,6 +481,23 @@ static int process_one_thread_config_spec(const char *thread_param_type,
 	return VDO_SUCCESS;
 }
 
+/**
+ * parse_thread_count() - Parse a thread count, which is either a number or "auto".
+ * @value: The string to parse.
+ * @count: A pointer to hold the count.
+ *
+ * Return: 0 or an error from kstrtouint()
+ */
+static int parse_thread_count(const char *value, unsigned int *count)
+{
+	if (strcmp(value, "auto") == 0) {
+		*count = VDO_AUTO_THREAD_COUNT;
+		return 0;
+	}
+
+	return kstrtouint(value, 10, count);
+}
+
 /**
  * parse_one_thread_config_spec() - Parse one component of a thread parameter configuration string
  *				    and update the configuration data structure.
@@ -489,7 +522,7 @@ static int parse_one_thread_config_spec(const char *spec,
 		return -EINVAL;
 	}
 
-	result = kstrtouint(fields[1], 10, &count);
+	result = parse_thread_count(fields[1], &count);
 	if (result) {
 		vdo_log_error("thread config string error: integer value needed, found \"%s\"",
 			      fields[1]);
@@ -511,7 +544,7 @@ static int parse_one_thread_config_spec(const char *spec,
  *
  * The configuration string should contain one or more comma-separated specs of the form
  * "typename=number"; the supported type names are "cpu", "ack", "bio", "bioRotationInterval",
- * "logical", "physical", and "hash".
+ * "logical", "physical", and "hash". The "cpu" and "hash" counts may also be "auto".
  *
  * If an error occurs during parsing of a single key/value pair, we deem it serious enough to stop
  * further parsing.
@@ -600,8 +633,8 @@ static int parse_one_key_value_pair(const char *key, const char *value,
 	if (strcmp(key, "compression") == 0)
 		return parse_bool(value, "on", "off", &config->compression);
 
-	/* The remaining arguments must have integral values. */
-	result = kstrtouint(value, 10, &count);
+	/* The remaining arguments must have integral (or automatic thread count) values. */
+	result = parse_thread_count(value, &count);
 	if (result) {
 		vdo_log_error("optional config string error: integer value needed, found \"%s\"",
 			      value);
@@ -650,7 +683,7 @@ static int parse_key_value_pairs(int argc, char **argv, struct device_config *co
  * For V0/V1 configurations, there will only be one optional parameter; the thread configuration.
  * The configuration string should contain one or more comma-separated specs of the form
  * "typename=number"; the supported type names are "cpu", "ack", "bio", "bioRotationInterval",
- * "logical", "physical", and "hash".
+ * "logical", "physical", and "hash". The "cpu" and "hash" counts may also be "auto".
  *
  * For V2 configurations and beyond, there could be any number of arguments. They should contain
  * one or more key/value pairs separated by a space.
@@ -696,6 +729,32 @@ static void handle_parse_error(struct device_config *config, char **error_ptr,
 	*error_ptr = error_str;
 }
 
+/**
+ * resolve_auto_thread_counts() - Replace "auto" thread counts with ones that scale with the
+ *				  number of online CPUs.
+ * @config: The thread configuration to update.
+ *
+ * Each hash zone thread serves the index queries and hash locks of its share of the hash space,
+ * so a fixed default caps deduplication throughput on large machines. With "hash=auto" there is
+ * one hash zone for every four online CPUs, and the hash zone threads are spread over the NUMA
+ * nodes. The "cpu" threads, which hash and compress the data, scale with half the CPUs.
+ */
+static void resolve_auto_thread_counts(struct thread_count_config *config)
+{
+	unsigned int cpus = num_online_cpus();
+
+	if (config->hash_zones == VDO_AUTO_THREAD_COUNT) {
+		config->hash_zones = clamp_t(unsigned int, cpus / 4, 1, MAXIMUM_VDO_THREADS);
+		config->auto_hash_zones = true;
+		vdo_log_info("using %u hash zones for %u CPUs", config->hash_zones, cpus);
+	}
+
+	if (config->cpu_threads == VDO_AUTO_THREAD_COUNT) {
+		config->cpu_threads = clamp_t(unsigned int, cpus / 2, 1, MAXIMUM_VDO_THREADS);
+		vdo_log_info("using %u cpu threads for %u CPUs", config->cpu_threads, cpus);
+	}
+}
+
 /**
  * parse_device_config() - Convert the dmsetup table into a struct device_config.
  * @argc: The number of table values.
@@ -847,6 +906,8 @@ static int parse_device_config(int argc, char **argv, struct dm_target *ti,
 		return result;
 	}
 
+	resolve_auto_thread_counts(&config->thread_counts);
+
 	/*
 	 * Logical, physical, and hash zone counts can all be zero; then we get one thread doing
 	 * everything, our older configuration. If any zone count is non-zero, the others must be
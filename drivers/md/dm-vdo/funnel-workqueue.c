@@ -11,6 +11,8 @@
 #include <linux/err.h>
 #include <linux/kthread.h>
 #include <linux/percpu.h>
+#include <linux/sched.h>
+#include <linux/topology.h>
 
 #include "funnel-queue.h"
 #include "logger.h"
@@ -370,6 +372,28 @@ static int make_simple_work_queue(const char *thread_name_prefix, const char *na
 	return VDO_SUCCESS;
 }
 
+/**
+ * vdo_set_work_queue_node() - Restrict the worker threads of a work queue to the CPUs of a NUMA
+ *                             node.
+ * @queue: The work queue.
+ * @node: The node whose CPUs the threads may run on.
+ */
+void vdo_set_work_queue_node(struct vdo_work_queue *queue, int node)
+{
+	const struct cpumask *mask = cpumask_of_node(node);
+	struct round_robin_work_queue *round_robin;
+	unsigned int i;
+
+	if (!queue->round_robin_mode) {
+		set_cpus_allowed_ptr(as_simple_work_queue(queue)->thread, mask);
+		return;
+	}
+
+	round_robin = as_round_robin_work_queue(queue);
+	for (i = 0; i < round_robin->num_service_queues; i++)
+		set_cpus_allowed_ptr(round_robin->service_queues[i]->thread, mask);
+}
+
 /**
  * vdo_make_work_queue() - Create a work queue; if multiple threads are requested, completions will
  *                         be distributed to them in round-robin fashion.
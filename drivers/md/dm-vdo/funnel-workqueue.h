@@ -30,6 +30,8 @@ int vdo_make_work_queue(const char *thread_name_prefix, const char *name,
 			unsigned int thread_count, void *thread_privates[],
 			struct vdo_work_queue **queue_ptr);
 
+void vdo_set_work_queue_node(struct vdo_work_queue *queue, int node);
+
 void vdo_enqueue_work_queue(struct vdo_work_queue *queue, struct vdo_completion *completion);
 
 void vdo_finish_work_queue(struct vdo_work_queue *queue);
@@ -195,6 +195,9 @@ struct slab_config {
  * This structure is memcmp'd for equality. Keep it packed and don't add any fields that are not
  * properly set in both extant and parsed configs.
  */
+/* A thread count of "auto" in the table line, scaled to the number of online CPUs */
+#define VDO_AUTO_THREAD_COUNT UINT_MAX
+
 struct thread_count_config {
 	unsigned int bio_ack_threads;
 	unsigned int bio_threads;
@@ -203,6 +206,8 @@ struct thread_count_config {
 	unsigned int logical_zones;
 	unsigned int physical_zones;
 	unsigned int hash_zones;
+	/* Whether the hash zone count was scaled, and its threads spread over NUMA nodes */
+	bool auto_hash_zones;
 } __packed;
 
 struct device_config {
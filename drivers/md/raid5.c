@@ -187,12 +187,14 @@ static void raid5_wakeup_stripe_thread(struct stripe_head *sh)
 	if (list_empty(&sh->lru)) {
 		struct r5worker_group *group;
 		group = conf->worker_groups + cpu_to_group(cpu);
+		spin_lock(&group->lock);
 		if (stripe_is_lowprio(sh))
 			list_add_tail(&sh->lru, &group->loprio_list);
 		else
 			list_add_tail(&sh->lru, &group->handle_list);
 		group->stripes_cnt++;
 		sh->group = group;
+		spin_unlock(&group->lock);
 	}
 
 	if (conf->worker_cnt_per_group == 0) {
@@ -206,7 +208,7 @@ static void raid5_wakeup_stripe_thread(struct stripe_head *sh)
 	/* at least one worker should run to avoid race */
 	queue_work_on(sh->cpu, raid5_wq, &group->workers[0].work);
 
-	thread_cnt = group->stripes_cnt / MAX_STRIPE_BATCH - 1;
+	thread_cnt = READ_ONCE(group->stripes_cnt) / MAX_STRIPE_BATCH - 1;
 	/* wakeup more workers */
 	for (i = 1; i < conf->worker_cnt_per_group && thread_cnt > 0; i++) {
 		if (group->workers[i].working == false) {
@@ -632,6 +634,7 @@ static struct stripe_head *find_get_stripe(struct r5conf *conf,
 		sector_t sector, short generation, int hash)
 {
 	int inc_empty_inactive_list_flag;
+	struct r5worker_group *group;
 	struct stripe_head *sh;
 
 	sh = __find_stripe(conf, sector, generation);
@@ -648,6 +651,13 @@ static struct stripe_head *find_get_stripe(struct r5conf *conf,
 	 */
 
 	spin_lock(&conf->device_lock);
+	/*
+	 * A worker may take the stripe off its group list concurrently, but
+	 * nobody can put it on one while we hold the device_lock.
+	 */
+	group = READ_ONCE(sh->group);
+	if (group)
+		spin_lock(&group->lock);
 	if (!atomic_read(&sh->count)) {
 		if (!test_bit(STRIPE_HANDLE, &sh->state))
 			atomic_inc(&conf->active_stripes);
@@ -666,6 +676,8 @@ static struct stripe_head *find_get_stripe(struct r5conf *conf,
 		}
 	}
 	atomic_inc(&sh->count);
+	if (group)
+		spin_unlock(&group->lock);
 	spin_unlock(&conf->device_lock);
 
 	return sh;
@@ -5543,6 +5555,8 @@ static struct stripe_head *__get_priority_stripe(struct r5conf *conf, int group)
 		  list_empty(&conf->hold_list) ? "empty" : "busy",
 		  atomic_read(&conf->pending_full_writes), conf->bypass_count);
 
+	if (wg)
+		spin_lock(&wg->lock);
 	if (!list_empty(handle_list)) {
 		sh = list_entry(handle_list->next, typeof(*sh), lru);
 
@@ -5558,7 +5572,20 @@ static struct stripe_head *__get_priority_stripe(struct r5conf *conf, int group)
 					conf->bypass_count = 0;
 			}
 		}
-	} else if (!list_empty(&conf->hold_list) &&
+		if (wg) {
+			wg->stripes_cnt--;
+			sh->group = NULL;
+		}
+		list_del_init(&sh->lru);
+		BUG_ON(atomic_inc_return(&sh->count) != 1);
+		if (wg)
+			spin_unlock(&wg->lock);
+		return sh;
+	}
+	if (wg)
+		spin_unlock(&wg->lock);
+
+	if (!list_empty(&conf->hold_list) &&
 		   ((conf->bypass_threshold &&
 		     conf->bypass_count > conf->bypass_threshold) ||
 		    atomic_read(&conf->pending_full_writes) == 0)) {
@@ -5578,7 +5605,6 @@ static struct stripe_head *__get_priority_stripe(struct r5conf *conf, int group)
 			if (conf->bypass_count < 0)
 				conf->bypass_count = 0;
 		}
-		wg = NULL;
 	}
 
 	if (!sh) {
@@ -5589,10 +5615,6 @@ static struct stripe_head *__get_priority_stripe(struct r5conf *conf, int group)
 		goto again;
 	}
 
-	if (wg) {
-		wg->stripes_cnt--;
-		sh->group = NULL;
-	}
 	list_del_init(&sh->lru);
 	BUG_ON(atomic_inc_return(&sh->count) != 1);
 	return sh;
@@ -6690,6 +6712,37 @@ static int handle_active_stripes(struct r5conf *conf, int group,
 	return batch_size;
 }
 
+/*
+ * Take stripes off the handle list of the worker's own group with only the
+ * group lock. The hold list and the journal's low priority handling are
+ * array-wide, so leave those cases to __get_priority_stripe().
+ */
+static int get_group_stripes(struct r5conf *conf, struct r5worker_group *group,
+			     struct stripe_head **batch)
+{
+	struct stripe_head *sh;
+	int batch_size = 0;
+
+	if (conf->log || !list_empty_careful(&conf->hold_list) ||
+	    list_empty_careful(&group->handle_list))
+		return 0;
+
+	spin_lock_irq(&group->lock);
+	while (batch_size < MAX_STRIPE_BATCH &&
+	       !list_empty(&group->handle_list)) {
+		sh = list_first_entry(&group->handle_list, struct stripe_head,
+				      lru);
+		list_del_init(&sh->lru);
+		group->stripes_cnt--;
+		sh->group = NULL;
+		BUG_ON(atomic_inc_return(&sh->count) != 1);
+		batch[batch_size++] = sh;
+	}
+	spin_unlock_irq(&group->lock);
+
+	return batch_size;
+}
+
 static void raid5_do_work(struct work_struct *work)
 {
 	struct r5worker *worker = container_of(work, struct r5worker, work);
@@ -6697,16 +6750,39 @@ static void raid5_do_work(struct work_struct *work)
 	struct r5conf *conf = group->conf;
 	struct mddev *mddev = conf->mddev;
 	int group_id = group - conf->worker_groups;
-	int handled;
+	struct stripe_head *batch[MAX_STRIPE_BATCH];
+	int handled, batch_size, i;
 	struct blk_plug plug;
 
 	pr_debug("+++ raid5worker active\n");
 
 	blk_start_plug(&plug);
 	handled = 0;
+
+	/*
+	 * Handle the stripes queued to this group without device_lock for as
+	 * long as possible; it is then only taken once per batch to release
+	 * them.
+	 */
+	while (!test_bit(MD_SB_CHANGE_PENDING, &mddev->sb_flags) &&
+	       (batch_size = get_group_stripes(conf, group, batch))) {
+		for (i = 0; i < batch_size; i++)
+			handle_stripe(batch[i]);
+		cond_resched();
+
+		spin_lock_irq(&conf->device_lock);
+		for (i = 0; i < batch_size; i++)
+			__release_stripe(conf, batch[i],
+				&worker->temp_inactive_list[batch[i]->hash_lock_index]);
+		spin_unlock_irq(&conf->device_lock);
+		release_inactive_stripe_list(conf, worker->temp_inactive_list,
+					     NR_STRIPE_HASH_LOCKS);
+		handled += batch_size;
+	}
+
 	spin_lock_irq(&conf->device_lock);
 	while (1) {
-		int batch_size, released;
+		int released;
 
 		released = release_stripe_list(conf, worker->temp_inactive_list);
 
@@ -7255,6 +7331,7 @@ static int alloc_thread_groups(struct r5conf *conf, int cnt, int *group_cnt,
 		struct r5worker_group *group;
 
 		group = &(*worker_groups)[i];
+		spin_lock_init(&group->lock);
 		INIT_LIST_HEAD(&group->handle_list);
 		INIT_LIST_HEAD(&group->loprio_list);
 		group->conf = conf;
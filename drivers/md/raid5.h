@@ -508,6 +508,12 @@ struct r5worker {
 };
 
 struct r5worker_group {
+	/*
+	 * Protects the lists and stripes_cnt, and sh->group of the stripes on
+	 * them. Stripes are only added with device_lock held as well, so
+	 * that the workers of the group can take them off without it.
+	 */
+	spinlock_t lock;
 	struct list_head handle_list;
 	struct list_head loprio_list;
 	struct r5conf *conf;
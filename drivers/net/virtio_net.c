@@ -26,6 +26,7 @@
 #include <net/netdev_rx_queue.h>
 #include <net/netdev_queues.h>
 #include <net/xdp_sock_drv.h>
+#include <net/page_pool/helpers.h>
 
 static int napi_weight = NAPI_POLL_WEIGHT;
 module_param(napi_weight, int, 0444);
@@ -270,13 +271,6 @@ struct virtnet_interrupt_coalesce {
 };
 
 /* The dma information of pages allocated at a time. */
-struct virtnet_rq_dma {
-	dma_addr_t addr;
-	u32 ref;
-	u16 len;
-	u16 need_sync;
-};
-
 /* Internal representation of a send virtqueue */
 struct send_queue {
 	/* Virtqueue associated with this send _queue */
@@ -335,8 +329,8 @@ struct receive_queue {
 	/* Average packet length for mergeable receive buffers. */
 	struct ewma_pkt_len mrg_avg_pkt_len;
 
-	/* Page frag for packet buffer allocation. */
-	struct page_frag alloc_frag;
+	/* Page pool for small and mergeable buffers. */
+	struct page_pool *page_pool;
 
 	/* RX: fragments + linear part + virtio header */
 	struct scatterlist sg[MAX_SKB_FRAGS + 2];
@@ -349,9 +343,6 @@ struct receive_queue {
 
 	struct xdp_rxq_info xdp_rxq;
 
-	/* Record the last dma info to free after new pages is allocated. */
-	struct virtnet_rq_dma *last_dma;
-
 	struct xsk_buff_pool *xsk_pool;
 
 	/* xdp rxq used by xsk */
@@ -705,12 +696,11 @@ static struct page *get_a_page(struct receive_queue *rq, gfp_t gfp_mask)
 static void virtnet_rq_free_buf(struct virtnet_info *vi,
 				struct receive_queue *rq, void *buf)
 {
-	if (vi->mergeable_rx_bufs)
-		put_page(virt_to_head_page(buf));
-	else if (vi->big_packets)
+	if (vi->big_packets && !vi->mergeable_rx_bufs)
 		give_pages(rq, buf);
 	else
-		put_page(virt_to_head_page(buf));
+		page_pool_put_full_page(rq->page_pool, virt_to_head_page(buf),
+					false);
 }
 
 static void enable_delayed_refill(struct virtnet_info *vi)
@@ -852,9 +842,16 @@ static struct sk_buff *page_to_skb(struct virtnet_info *vi,
 		if (unlikely(!skb))
 			return NULL;
 
-		page = (struct page *)page->private;
-		if (page)
-			give_pages(rq, page);
+		/* Only big packets chain pages through page->private, which
+		 * aliases pp_ref_count for page pool pages.
+		 */
+		if (rq->page_pool) {
+			skb_mark_for_recycle(skb);
+		} else {
+			page = (struct page *)page->private;
+			if (page)
+				give_pages(rq, page);
+		}
 		goto ok;
 	}
 
@@ -876,6 +873,7 @@ static struct sk_buff *page_to_skb(struct virtnet_info *vi,
 	offset += copy;
 
 	if (vi->mergeable_rx_bufs) {
+		skb_mark_for_recycle(skb);
 		if (len)
 			skb_add_rx_frag(skb, 0, page, offset, len, truesize);
 		else
@@ -911,133 +909,53 @@ static struct sk_buff *page_to_skb(struct virtnet_info *vi,
 	hdr = skb_vnet_common_hdr(skb);
 	memcpy(hdr, hdr_p, hdr_len);
 	if (page_to_free)
-		put_page(page_to_free);
+		page_pool_put_full_page(rq->page_pool, page_to_free, true);
 
 	return skb;
 }
 
-static void virtnet_rq_unmap(struct receive_queue *rq, void *buf, u32 len)
-{
-	struct virtnet_info *vi = rq->vq->vdev->priv;
-	struct page *page = virt_to_head_page(buf);
-	struct virtnet_rq_dma *dma;
-	void *head;
-	int offset;
-
-	BUG_ON(vi->big_packets && !vi->mergeable_rx_bufs);
-
-	head = page_address(page);
-
-	dma = head;
-
-	--dma->ref;
-
-	if (dma->need_sync && len) {
-		offset = buf - (head + sizeof(*dma));
-
-		virtqueue_dma_sync_single_range_for_cpu(rq->vq, dma->addr,
-							offset, len,
-							DMA_FROM_DEVICE);
-	}
-
-	if (dma->ref)
-		return;
-
-	virtqueue_dma_unmap_single_attrs(rq->vq, dma->addr, dma->len,
-					 DMA_FROM_DEVICE, DMA_ATTR_SKIP_CPU_SYNC);
-	put_page(page);
-}
-
 static void *virtnet_rq_get_buf(struct receive_queue *rq, u32 *len, void **ctx)
 {
 	struct virtnet_info *vi = rq->vq->vdev->priv;
+	struct page *page;
 	void *buf;
 
 	BUG_ON(vi->big_packets && !vi->mergeable_rx_bufs);
 
 	buf = virtqueue_get_buf_ctx(rq->vq, len, ctx);
-	if (buf)
-		virtnet_rq_unmap(rq, buf, *len);
+	if (buf && rq->page_pool->dma_map) {
+		page = virt_to_head_page(buf);
+		page_pool_dma_sync_for_cpu(rq->page_pool, page,
+					   buf - page_address(page), *len);
+	}
 
 	return buf;
 }
 
 static void virtnet_rq_init_one_sg(struct receive_queue *rq, void *buf, u32 len)
 {
-	struct virtnet_info *vi = rq->vq->vdev->priv;
-	struct virtnet_rq_dma *dma;
+	struct page *page = virt_to_head_page(buf);
 	dma_addr_t addr;
-	u32 offset;
-	void *head;
-
-	BUG_ON(vi->big_packets && !vi->mergeable_rx_bufs);
 
-	head = page_address(rq->alloc_frag.page);
-
-	offset = buf - head;
-
-	dma = head;
-
-	addr = dma->addr - sizeof(*dma) + offset;
+	/* Without the DMA API the device is given physical addresses, as
+	 * virtio core itself would for an unmapped buffer.
+	 */
+	if (rq->page_pool->dma_map)
+		addr = page_pool_get_dma_addr(page) + (buf - page_address(page));
+	else
+		addr = virt_to_phys(buf);
 
 	sg_init_table(rq->sg, 1);
 	sg_fill_dma(rq->sg, addr, len);
 }
 
-static void *virtnet_rq_alloc(struct receive_queue *rq, u32 size, gfp_t gfp)
+static void *virtnet_rq_alloc(struct receive_queue *rq, u32 *size, gfp_t gfp)
 {
-	struct page_frag *alloc_frag = &rq->alloc_frag;
 	struct virtnet_info *vi = rq->vq->vdev->priv;
-	struct virtnet_rq_dma *dma;
-	void *buf, *head;
-	dma_addr_t addr;
 
 	BUG_ON(vi->big_packets && !vi->mergeable_rx_bufs);
 
-	head = page_address(alloc_frag->page);
-
-	dma = head;
-
-	/* new pages */
-	if (!alloc_frag->offset) {
-		if (rq->last_dma) {
-			/* Now, the new page is allocated, the last dma
-			 * will not be used. So the dma can be unmapped
-			 * if the ref is 0.
-			 */
-			virtnet_rq_unmap(rq, rq->last_dma, 0);
-			rq->last_dma = NULL;
-		}
-
-		dma->len = alloc_frag->size - sizeof(*dma);
-
-		addr = virtqueue_dma_map_single_attrs(rq->vq, dma + 1,
-						      dma->len, DMA_FROM_DEVICE, 0);
-		if (virtqueue_dma_mapping_error(rq->vq, addr))
-			return NULL;
-
-		dma->addr = addr;
-		dma->need_sync = virtqueue_dma_need_sync(rq->vq, addr);
-
-		/* Add a reference to dma to prevent the entire dma from
-		 * being released during error handling. This reference
-		 * will be freed after the pages are no longer used.
-		 */
-		get_page(alloc_frag->page);
-		dma->ref = 1;
-		alloc_frag->offset = sizeof(*dma);
-
-		rq->last_dma = dma;
-	}
-
-	++dma->ref;
-
-	buf = head + alloc_frag->offset;
-
-	get_page(alloc_frag->page);
-	alloc_frag->offset += size;
-
-	return buf;
+	return page_pool_alloc_va(rq->page_pool, size, gfp);
 }
 
 static void virtnet_rq_unmap_free_buf(struct virtqueue *vq, void *buf)
@@ -1053,9 +971,6 @@ static void virtnet_rq_unmap_free_buf(struct virtqueue *vq, void *buf)
 		return;
 	}
 
-	if (!vi->big_packets || vi->mergeable_rx_bufs)
-		virtnet_rq_unmap(rq, buf, 0);
-
 	virtnet_rq_free_buf(vi, rq, buf);
 }
 
@@ -1713,7 +1628,7 @@ static int virtnet_xdp_xmit(struct net_device *dev,
 	return ret;
 }
 
-static void put_xdp_frags(struct xdp_buff *xdp)
+static void put_xdp_frags(struct receive_queue *rq, struct xdp_buff *xdp)
 {
 	struct skb_shared_info *shinfo;
 	struct page *xdp_page;
@@ -1723,7 +1638,7 @@ static void put_xdp_frags(struct xdp_buff *xdp)
 		shinfo = xdp_get_shared_info_from_buff(xdp);
 		for (i = 0; i < shinfo->nr_frags; i++) {
 			xdp_page = skb_frag_page(&shinfo->frags[i]);
-			put_page(xdp_page);
+			page_pool_put_full_page(rq->page_pool, xdp_page, true);
 		}
 	}
 }
@@ -1814,7 +1729,7 @@ static struct page *xdp_linearize_page(struct receive_queue *rq,
 	if (page_off + *len + tailroom > PAGE_SIZE)
 		return NULL;
 
-	page = alloc_page(GFP_ATOMIC);
+	page = page_pool_dev_alloc_pages(rq->page_pool);
 	if (!page)
 		return NULL;
 
@@ -1837,21 +1752,21 @@ static struct page *xdp_linearize_page(struct receive_queue *rq,
 		 * is sending packet larger than the MTU.
 		 */
 		if ((page_off + buflen + tailroom) > PAGE_SIZE) {
-			put_page(p);
+			page_pool_put_full_page(rq->page_pool, p, true);
 			goto err_buf;
 		}
 
 		memcpy(page_address(page) + page_off,
 		       page_address(p) + off, buflen);
 		page_off += buflen;
-		put_page(p);
+		page_pool_put_full_page(rq->page_pool, p, true);
 	}
 
 	/* Headroom does not contribute to packet length */
 	*len = page_off - XDP_PACKET_HEADROOM;
 	return page;
 err_buf:
-	__free_pages(page, 0);
+	page_pool_put_full_page(rq->page_pool, page, true);
 	return NULL;
 }
 
@@ -1874,6 +1789,8 @@ static struct sk_buff *receive_small_build_skb(struct virtnet_info *vi,
 	if (unlikely(!skb))
 		return NULL;
 
+	skb_mark_for_recycle(skb);
+
 	buf += header_offset;
 	memcpy(skb_vnet_common_hdr(skb), buf, vi->hdr_len);
 
@@ -1928,7 +1845,7 @@ static struct sk_buff *receive_small_xdp(struct net_device *dev,
 			goto err_xdp;
 
 		buf = page_address(xdp_page);
-		put_page(page);
+		page_pool_put_full_page(rq->page_pool, page, true);
 		page = xdp_page;
 	}
 
@@ -1957,6 +1874,7 @@ static struct sk_buff *receive_small_xdp(struct net_device *dev,
 	if (unlikely(!skb))
 		goto err;
 
+	skb_mark_for_recycle(skb);
 	if (metasize)
 		skb_metadata_set(skb, metasize);
 
@@ -1966,7 +1884,7 @@ static struct sk_buff *receive_small_xdp(struct net_device *dev,
 	u64_stats_inc(&stats->xdp_drops);
 err:
 	u64_stats_inc(&stats->drops);
-	put_page(page);
+	page_pool_put_full_page(rq->page_pool, page, true);
 xdp_xmit:
 	return NULL;
 }
@@ -2019,7 +1937,7 @@ static struct sk_buff *receive_small(struct net_device *dev,
 
 err:
 	u64_stats_inc(&stats->drops);
-	put_page(page);
+	page_pool_put_full_page(rq->page_pool, page, true);
 	return NULL;
 }
 
@@ -2064,7 +1982,7 @@ static void mergeable_buf_free(struct receive_queue *rq, int num_buf,
 		}
 		u64_stats_add(&stats->bytes, len);
 		page = virt_to_head_page(buf);
-		put_page(page);
+		page_pool_put_full_page(rq->page_pool, page, true);
 	}
 }
 
@@ -2098,6 +2016,8 @@ static struct sk_buff *build_skb_from_xdp_buff(struct net_device *dev,
 	if (unlikely(!skb))
 		return NULL;
 
+	skb_mark_for_recycle(skb);
+
 	headroom = xdp->data - xdp->data_hard_start;
 	data_len = xdp->data_end - xdp->data;
 	skb_reserve(skb, headroom);
@@ -2184,7 +2104,7 @@ static int virtnet_build_xdp_buff_mrg(struct net_device *dev,
 		cur_frag_size = truesize;
 		xdp_frags_truesz += cur_frag_size;
 		if (unlikely(len > truesize - room || cur_frag_size > PAGE_SIZE)) {
-			put_page(page);
+			page_pool_put_full_page(rq->page_pool, page, true);
 			pr_debug("%s: rx error: len %u exceeds truesize %lu\n",
 				 dev->name, len, (unsigned long)(truesize - room));
 			DEV_STATS_INC(dev, rx_length_errors);
@@ -2203,7 +2123,7 @@ static int virtnet_build_xdp_buff_mrg(struct net_device *dev,
 	return 0;
 
 err:
-	put_xdp_frags(xdp);
+	put_xdp_frags(rq, xdp);
 	return -EINVAL;
 }
 
@@ -2268,7 +2188,7 @@ static void *mergeable_xdp_get_buf(struct virtnet_info *vi,
 		if (*len + xdp_room > PAGE_SIZE)
 			return NULL;
 
-		xdp_page = alloc_page(GFP_ATOMIC);
+		xdp_page = page_pool_dev_alloc_pages(rq->page_pool);
 		if (!xdp_page)
 			return NULL;
 
@@ -2278,7 +2198,7 @@ static void *mergeable_xdp_get_buf(struct virtnet_info *vi,
 
 	*frame_sz = PAGE_SIZE;
 
-	put_page(*page);
+	page_pool_put_full_page(rq->page_pool, *page, true);
 
 	*page = xdp_page;
 
@@ -2334,10 +2254,10 @@ static struct sk_buff *receive_mergeable_xdp(struct net_device *dev,
 		break;
 	}
 
-	put_xdp_frags(&xdp);
+	put_xdp_frags(rq, &xdp);
 
 err_xdp:
-	put_page(page);
+	page_pool_put_full_page(rq->page_pool, page, true);
 	mergeable_buf_free(rq, num_buf, dev, stats);
 
 	u64_stats_inc(&stats->xdp_drops);
@@ -2360,6 +2280,9 @@ static struct sk_buff *virtnet_skb_append_frag(struct sk_buff *head_skb,
 		if (unlikely(!nskb))
 			return NULL;
 
+		if (head_skb->pp_recycle)
+			skb_mark_for_recycle(nskb);
+
 		if (curr_skb == head_skb)
 			skb_shinfo(curr_skb)->frag_list = nskb;
 		else
@@ -2377,7 +2300,7 @@ static struct sk_buff *virtnet_skb_append_frag(struct sk_buff *head_skb,
 
 	offset = buf - page_address(page);
 	if (skb_can_coalesce(curr_skb, num_skb_frags, page, offset)) {
-		put_page(page);
+		skb_page_unref(page_to_netmem(page), curr_skb->pp_recycle);
 		skb_coalesce_rx_frag(curr_skb, num_skb_frags - 1,
 				     len, truesize);
 	} else {
@@ -2471,7 +2394,7 @@ static struct sk_buff *receive_mergeable(struct net_device *dev,
 	return head_skb;
 
 err_skb:
-	put_page(page);
+	page_pool_put_full_page(rq->page_pool, page, true);
 	mergeable_buf_free(rq, num_buf, dev, stats);
 
 err_buf:
@@ -2593,16 +2516,13 @@ static int add_recvbuf_small(struct virtnet_info *vi, struct receive_queue *rq,
 	char *buf;
 	unsigned int xdp_headroom = virtnet_get_headroom(vi);
 	void *ctx = (void *)(unsigned long)xdp_headroom;
-	int len = vi->hdr_len + VIRTNET_RX_PAD + GOOD_PACKET_LEN + xdp_headroom;
+	u32 len = vi->hdr_len + VIRTNET_RX_PAD + GOOD_PACKET_LEN + xdp_headroom;
 	int err;
 
 	len = SKB_DATA_ALIGN(len) +
 	      SKB_DATA_ALIGN(sizeof(struct skb_shared_info));
 
-	if (unlikely(!skb_page_frag_refill(len, &rq->alloc_frag, gfp)))
-		return -ENOMEM;
-
-	buf = virtnet_rq_alloc(rq, len, gfp);
+	buf = virtnet_rq_alloc(rq, &len, gfp);
 	if (unlikely(!buf))
 		return -ENOMEM;
 
@@ -2611,10 +2531,9 @@ static int add_recvbuf_small(struct virtnet_info *vi, struct receive_queue *rq,
 	virtnet_rq_init_one_sg(rq, buf, vi->hdr_len + GOOD_PACKET_LEN);
 
 	err = virtqueue_add_inbuf_premapped(rq->vq, rq->sg, 1, buf, ctx, gfp);
-	if (err < 0) {
-		virtnet_rq_unmap(rq, buf, 0);
-		put_page(virt_to_head_page(buf));
-	}
+	if (err < 0)
+		page_pool_put_full_page(rq->page_pool, virt_to_head_page(buf),
+					false);
 
 	return err;
 }
@@ -2688,11 +2607,10 @@ static unsigned int get_mergeable_buf_len(struct receive_queue *rq,
 static int add_recvbuf_mergeable(struct virtnet_info *vi,
 				 struct receive_queue *rq, gfp_t gfp)
 {
-	struct page_frag *alloc_frag = &rq->alloc_frag;
 	unsigned int headroom = virtnet_get_headroom(vi);
 	unsigned int tailroom = headroom ? sizeof(struct skb_shared_info) : 0;
 	unsigned int room = SKB_DATA_ALIGN(headroom + tailroom);
-	unsigned int len, hole;
+	unsigned int len, size;
 	void *ctx;
 	char *buf;
 	int err;
@@ -2703,38 +2621,27 @@ static int add_recvbuf_mergeable(struct virtnet_info *vi,
 	 */
 	len = get_mergeable_buf_len(rq, &rq->mrg_avg_pkt_len, room);
 
-	if (unlikely(!skb_page_frag_refill(len + room, alloc_frag, gfp)))
-		return -ENOMEM;
-
-	if (!alloc_frag->offset && len + room + sizeof(struct virtnet_rq_dma) > alloc_frag->size)
-		len -= sizeof(struct virtnet_rq_dma);
-
-	buf = virtnet_rq_alloc(rq, len + room, gfp);
+	/* The pool hands out the rest of the page along with the last
+	 * fragment that fits in it, to avoid internal fragmentation. With
+	 * XDP, room is set and the buffer always covers a whole page, as
+	 * XDP core assumes that frame_size of xdp_buff and the length of
+	 * the frag are PAGE_SIZE.
+	 */
+	size = len + room;
+	buf = virtnet_rq_alloc(rq, &size, gfp);
 	if (unlikely(!buf))
 		return -ENOMEM;
 
 	buf += headroom; /* advance address leaving hole at front of pkt */
-	hole = alloc_frag->size - alloc_frag->offset;
-	if (hole < len + room) {
-		/* To avoid internal fragmentation, if there is very likely not
-		 * enough space for another buffer, add the remaining space to
-		 * the current buffer.
-		 * XDP core assumes that frame_size of xdp_buff and the length
-		 * of the frag are PAGE_SIZE, so we disable the hole mechanism.
-		 */
-		if (!headroom)
-			len += hole;
-		alloc_frag->offset += hole;
-	}
+	len = size - room;
 
 	virtnet_rq_init_one_sg(rq, buf, len);
 
-	ctx = mergeable_len_to_ctx(len + room, headroom);
+	ctx = mergeable_len_to_ctx(size, headroom);
 	err = virtqueue_add_inbuf_premapped(rq->vq, rq->sg, 1, buf, ctx, gfp);
-	if (err < 0) {
-		virtnet_rq_unmap(rq, buf, 0);
-		put_page(virt_to_head_page(buf));
-	}
+	if (err < 0)
+		page_pool_put_full_page(rq->page_pool, virt_to_head_page(buf),
+					false);
 
 	return err;
 }
@@ -3042,6 +2949,7 @@ static void virtnet_disable_queue_pair(struct virtnet_info *vi, int qp_index)
 
 static int virtnet_enable_queue_pair(struct virtnet_info *vi, int qp_index)
 {
+	struct page_pool *pool = vi->rq[qp_index].page_pool;
 	struct net_device *dev = vi->dev;
 	int err;
 
@@ -3051,7 +2959,9 @@ static int virtnet_enable_queue_pair(struct virtnet_info *vi, int qp_index)
 		return err;
 
 	err = xdp_rxq_info_reg_mem_model(&vi->rq[qp_index].xdp_rxq,
-					 MEM_TYPE_PAGE_SHARED, NULL);
+					 pool ? MEM_TYPE_PAGE_POOL :
+						MEM_TYPE_PAGE_SHARED,
+					 pool);
 	if (err < 0)
 		goto err_xdp_reg_mem_model;
 
@@ -6201,15 +6111,67 @@ static void free_receive_bufs(struct virtnet_info *vi)
 	rtnl_unlock();
 }
 
-static void free_receive_page_frags(struct virtnet_info *vi)
+static void virtnet_destroy_page_pools(struct virtnet_info *vi)
 {
 	int i;
-	for (i = 0; i < vi->max_queue_pairs; i++)
-		if (vi->rq[i].alloc_frag.page) {
-			if (vi->rq[i].last_dma)
-				virtnet_rq_unmap(&vi->rq[i], vi->rq[i].last_dma, 0);
-			put_page(vi->rq[i].alloc_frag.page);
+
+	for (i = 0; i < vi->max_queue_pairs; i++) {
+		page_pool_destroy(vi->rq[i].page_pool);
+		vi->rq[i].page_pool = NULL;
+	}
+}
+
+static int virtnet_create_page_pools(struct virtnet_info *vi)
+{
+	struct page_pool_params pp_params = {
+		.order		= 0,
+		.nid		= NUMA_NO_NODE,
+		.netdev		= vi->dev,
+	};
+	struct receive_queue *rq;
+	struct device *dma_dev;
+	int i, err;
+
+	/* Big packets are built from chains of whole pages, see
+	 * add_recvbuf_big().
+	 */
+	if (vi->big_packets && !vi->mergeable_rx_bufs)
+		return 0;
+
+	for (i = 0; i < vi->max_queue_pairs; i++) {
+		rq = &vi->rq[i];
+
+		pp_params.pool_size = virtqueue_get_vring_size(rq->vq);
+		pp_params.napi = &rq->napi;
+		pp_params.queue_idx = i;
+
+		/* Let the pool map and sync the pages when virtio uses the
+		 * DMA API, otherwise buffers are given by physical address.
+		 */
+		dma_dev = virtqueue_dma_dev(rq->vq);
+		if (dma_dev) {
+			pp_params.flags = PP_FLAG_DMA_MAP | PP_FLAG_DMA_SYNC_DEV;
+			pp_params.dev = dma_dev;
+			pp_params.dma_dir = DMA_FROM_DEVICE;
+			pp_params.max_len = PAGE_SIZE;
+		} else {
+			pp_params.flags = 0;
+			pp_params.dev = NULL;
 		}
+
+		rq->page_pool = page_pool_create(&pp_params);
+		if (IS_ERR(rq->page_pool)) {
+			err = PTR_ERR(rq->page_pool);
+			rq->page_pool = NULL;
+			goto err;
+		}
+	}
+
+	return 0;
+
+err:
+	virtnet_destroy_page_pools(vi);
+	return err;
 }
 
 static void virtnet_sq_free_unused_buf(struct virtqueue *vq, void *buf)
@@ -6428,12 +6390,19 @@ static int init_vqs(struct virtnet_info *vi)
 	if (ret)
 		goto err_free;
 
+	ret = virtnet_create_page_pools(vi);
+	if (ret)
+		goto err_del_vqs;
+
 	cpus_read_lock();
 	virtnet_set_affinity(vi);
 	cpus_read_unlock();
 
 	return 0;
 
+err_del_vqs:
+	virtnet_del_vqs(vi);
+	return ret;
 err_free:
 	virtnet_free_queues(vi);
 err:
@@ -6967,7 +6936,7 @@ static int virtnet_probe(struct virtio_device *vdev)
 free_vqs:
 	virtio_reset_device(vdev);
 	cancel_delayed_work_sync(&vi->refill);
-	free_receive_page_frags(vi);
+	virtnet_destroy_page_pools(vi);
 	virtnet_del_vqs(vi);
 free:
 	free_netdev(dev);
@@ -6992,7 +6961,7 @@ static void remove_vq_common(struct virtnet_info *vi)
 
 	free_receive_bufs(vi);
 
-	free_receive_page_frags(vi);
+	virtnet_destroy_page_pools(vi);
 
 	virtnet_del_vqs(vi);
 }
@@ -44,6 +44,14 @@ static bool wq_unbound;
 module_param(wq_unbound, bool, 0644);
 MODULE_PARM_DESC(wq_unbound, "Use unbound workqueue for nvme-tcp IO context (default false)");
 
+/*
+ * Receive on I/O queues from a separate work item, which runs on another
+ * cpu than the one sending, so that both directions can progress at once.
+ */
+static bool split_rx;
+module_param(split_rx, bool, 0644);
+MODULE_PARM_DESC(split_rx, "Separate receive context for nvme-tcp I/O queues (default false)");
+
 /*
  * TLS handshake timeout
  */
@@ -130,6 +138,7 @@ enum nvme_tcp_queue_flags {
 	NVME_TCP_Q_LIVE		= 1,
 	NVME_TCP_Q_POLLING	= 2,
 	NVME_TCP_Q_IO_CPU_SET	= 3,
+	NVME_TCP_Q_RECV_CPU_SET	= 4,
 };
 
 enum nvme_tcp_recv_state {
@@ -143,6 +152,10 @@ struct nvme_tcp_queue {
 	struct socket		*sock;
 	struct work_struct	io_work;
 	int			io_cpu;
+	/* receive context, if split from io_work */
+	bool			recv_split;
+	struct work_struct	recv_work;
+	int			recv_cpu;
 
 	struct mutex		queue_lock;
 	struct mutex		send_mutex;
@@ -1025,8 +1038,14 @@ static void nvme_tcp_data_ready(struct sock *sk)
 	read_lock_bh(&sk->sk_callback_lock);
 	queue = sk->sk_user_data;
 	if (likely(queue && queue->rd_enabled) &&
-	    !test_bit(NVME_TCP_Q_POLLING, &queue->flags))
-		queue_work_on(queue->io_cpu, nvme_tcp_wq, &queue->io_work);
+	    !test_bit(NVME_TCP_Q_POLLING, &queue->flags)) {
+		if (queue->recv_split)
+			queue_work_on(queue->recv_cpu, nvme_tcp_wq,
+				      &queue->recv_work);
+		else
+			queue_work_on(queue->io_cpu, nvme_tcp_wq,
+				      &queue->io_work);
+	}
 	read_unlock_bh(&sk->sk_callback_lock);
 }
 
@@ -1345,11 +1364,13 @@ static void nvme_tcp_io_work(struct work_struct *w)
 				break;
 		}
 
-		result = nvme_tcp_try_recv(queue);
-		if (result > 0)
-			pending = true;
-		else if (unlikely(result < 0))
-			return;
+		if (!queue->recv_split) {
+			result = nvme_tcp_try_recv(queue);
+			if (result > 0)
+				pending = true;
+			else if (unlikely(result < 0))
+				return;
+		}
 
 		if (!pending || !queue->rd_enabled)
 			return;
@@ -1359,6 +1380,20 @@ static void nvme_tcp_io_work(struct work_struct *w)
 	queue_work_on(queue->io_cpu, nvme_tcp_wq, &queue->io_work);
 }
 
+static void nvme_tcp_recv_work(struct work_struct *w)
+{
+	struct nvme_tcp_queue *queue =
+		container_of(w, struct nvme_tcp_queue, recv_work);
+	unsigned long deadline = jiffies + msecs_to_jiffies(1);
+
+	do {
+		if (nvme_tcp_try_recv(queue) <= 0 || !queue->rd_enabled)
+			return;
+	} while (!time_after(jiffies, deadline)); /* quota is exhausted */
+
+	queue_work_on(queue->recv_cpu, nvme_tcp_wq, &queue->recv_work);
+}
+
 static void nvme_tcp_free_crypto(struct nvme_tcp_queue *queue)
 {
 	struct crypto_ahash *tfm = crypto_ahash_reqtfm(queue->rcv_hash);
@@ -1620,6 +1655,54 @@ static bool nvme_tcp_poll_queue(struct nvme_tcp_queue *queue)
  * simply putting our best effort to select the best candidate cpu core that we
  * find at any given point.
  */
+/*
+ * Place the receive context of @queue on the least used other cpu mapped
+ * to the queue, or failing that on the least used other cpu of the node,
+ * and share the cpu of io_work if there is none.
+ */
+static void nvme_tcp_set_queue_recv_cpu(struct nvme_tcp_queue *queue,
+		unsigned int *mq_map, int qid)
+{
+	int cpu, min_queues = INT_MAX, recv_cpu = WORK_CPU_UNBOUND;
+	const struct cpumask *node_mask;
+
+	if (queue->io_cpu == WORK_CPU_UNBOUND)
+		return;
+
+	for_each_online_cpu(cpu) {
+		int num_queues = atomic_read(&nvme_tcp_cpu_queues[cpu]);
+
+		if (mq_map[cpu] != qid || cpu == queue->io_cpu)
+			continue;
+		if (num_queues < min_queues) {
+			recv_cpu = cpu;
+			min_queues = num_queues;
+		}
+	}
+
+	node_mask = cpumask_of_node(cpu_to_node(queue->io_cpu));
+	if (recv_cpu == WORK_CPU_UNBOUND) {
+		for_each_cpu_and(cpu, node_mask, cpu_online_mask) {
+			int num_queues = atomic_read(&nvme_tcp_cpu_queues[cpu]);
+
+			if (cpu == queue->io_cpu)
+				continue;
+			if (num_queues < min_queues) {
+				recv_cpu = cpu;
+				min_queues = num_queues;
+			}
+		}
+	}
+
+	if (recv_cpu == WORK_CPU_UNBOUND) {
+		queue->recv_cpu = queue->io_cpu;
+		return;
+	}
+	queue->recv_cpu = recv_cpu;
+	atomic_inc(&nvme_tcp_cpu_queues[recv_cpu]);
+	set_bit(NVME_TCP_Q_RECV_CPU_SET, &queue->flags);
+}
+
 static void nvme_tcp_set_queue_io_cpu(struct nvme_tcp_queue *queue)
 {
 	struct nvme_tcp_ctrl *ctrl = queue->ctrl;
@@ -1658,6 +1741,8 @@ static void nvme_tcp_set_queue_io_cpu(struct nvme_tcp_queue *queue)
 		atomic_inc(&nvme_tcp_cpu_queues[io_cpu]);
 		set_bit(NVME_TCP_Q_IO_CPU_SET, &queue->flags);
 	}
+	if (queue->recv_split)
+		nvme_tcp_set_queue_recv_cpu(queue, mq_map, qid);
 out:
 	dev_dbg(ctrl->ctrl.device, "queue %d: using cpu %d\n",
 		qid, queue->io_cpu);
@@ -1757,6 +1842,7 @@ static int nvme_tcp_alloc_queue(struct nvme_ctrl *nctrl, int qid,
 	INIT_LIST_HEAD(&queue->send_list);
 	mutex_init(&queue->send_mutex);
 	INIT_WORK(&queue->io_work, nvme_tcp_io_work);
+	INIT_WORK(&queue->recv_work, nvme_tcp_recv_work);
 
 	if (qid > 0)
 		queue->cmnd_capsule_len = nctrl->ioccsz * 16;
@@ -1805,6 +1891,7 @@ static int nvme_tcp_alloc_queue(struct nvme_ctrl *nctrl, int qid,
 	queue->sock->sk->sk_allocation = GFP_ATOMIC;
 	queue->sock->sk->sk_use_task_frag = false;
 	queue->io_cpu = WORK_CPU_UNBOUND;
+	queue->recv_cpu = WORK_CPU_UNBOUND;
 	queue->request = NULL;
 	queue->data_remaining = 0;
 	queue->ddgst_remaining = 0;
@@ -1916,6 +2003,7 @@ static void __nvme_tcp_stop_queue(struct nvme_tcp_queue *queue)
 	kernel_sock_shutdown(queue->sock, SHUT_RDWR);
 	nvme_tcp_restore_sock_ops(queue);
 	cancel_work_sync(&queue->io_work);
+	cancel_work_sync(&queue->recv_work);
 }
 
 static void nvme_tcp_stop_queue(struct nvme_ctrl *nctrl, int qid)
@@ -1928,6 +2016,8 @@ static void nvme_tcp_stop_queue(struct nvme_ctrl *nctrl, int qid)
 
 	if (test_and_clear_bit(NVME_TCP_Q_IO_CPU_SET, &queue->flags))
 		atomic_dec(&nvme_tcp_cpu_queues[queue->io_cpu]);
+	if (test_and_clear_bit(NVME_TCP_Q_RECV_CPU_SET, &queue->flags))
+		atomic_dec(&nvme_tcp_cpu_queues[queue->recv_cpu]);
 
 	mutex_lock(&queue->queue_lock);
 	if (test_and_clear_bit(NVME_TCP_Q_LIVE, &queue->flags))
@@ -1960,6 +2050,8 @@ static int nvme_tcp_start_queue(struct nvme_ctrl *nctrl, int idx)
 	int ret;
 
 	queue->rd_enabled = true;
+	/* polled queues receive from ->poll() instead */
+	queue->recv_split = split_rx && idx && !nvme_tcp_poll_queue(queue);
 	nvme_tcp_init_recv_ctx(queue);
 	nvme_tcp_setup_sock_ops(queue);
 
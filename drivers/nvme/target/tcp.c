@@ -18,6 +18,11 @@
 #include <net/handshake.h>
 #include <linux/inet.h>
 #include <linux/llist.h>
+#include <linux/kthread.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/sched/clock.h>
+#include <net/busy_poll.h>
 #include <crypto/hash.h>
 #include <trace/events/sock.h>
 
@@ -73,6 +78,17 @@ device_param_cb(idle_poll_period_usecs, &set_param_ops,
 MODULE_PARM_DESC(idle_poll_period_usecs,
 		"nvmet tcp io_work poll till idle time period in usecs: Default 0");
 
+/* Serve the queues from per-cpu poll group threads instead of io_work.
+ * A poll group thread keeps polling its queues, busy polling their NAPI
+ * contexts where available, until none had any activity for
+ * idle_poll_period_usecs, and only then sleeps until the next socket
+ * callback.
+ */
+static bool poll_groups;
+module_param(poll_groups, bool, 0444);
+MODULE_PARM_DESC(poll_groups,
+		"nvmet tcp per-cpu poll group threads: Default false");
+
 #ifdef CONFIG_NVME_TARGET_TCP_TLS
 /*
  * TLS handshake timeout
@@ -196,11 +212,31 @@ struct nvmet_tcp_queue {
 
 	struct page_frag_cache	pf_cache;
 
+	/* poll group serving the queue instead of io_work */
+	struct nvmet_tcp_poll_group *pg;
+	struct list_head	pg_entry;
+
 	void (*data_ready)(struct sock *);
 	void (*state_change)(struct sock *);
 	void (*write_space)(struct sock *);
 };
 
+struct nvmet_tcp_poll_group {
+	struct task_struct	*thread;
+	atomic_t		kicked;
+
+	struct mutex		lock;	/* protects queues */
+	struct list_head	queues;
+	unsigned int		nr_queues;
+
+	/* statistics, updated by the thread only */
+	u64			rounds;
+	u64			ops;
+	u64			busy_ns;	/* polling with activity */
+	u64			idle_ns;	/* polling without activity */
+	u64			sleeps;
+};
+
 struct nvmet_tcp_port {
 	struct socket		*sock;
 	struct work_struct	accept_work;
@@ -214,6 +250,8 @@ static LIST_HEAD(nvmet_tcp_queue_list);
 static DEFINE_MUTEX(nvmet_tcp_queue_mutex);
 
 static struct workqueue_struct *nvmet_tcp_wq;
+static struct nvmet_tcp_poll_group *nvmet_tcp_poll_groups;
+static struct dentry *nvmet_tcp_debugfs;
 static const struct nvmet_fabrics_ops nvmet_tcp_ops;
 static void nvmet_tcp_free_cmd(struct nvmet_tcp_cmd *c);
 static void nvmet_tcp_free_cmd_buffers(struct nvmet_tcp_cmd *cmd);
@@ -285,6 +323,19 @@ static inline int queue_cpu(struct nvmet_tcp_queue *queue)
 	return queue->sock->sk->sk_incoming_cpu;
 }
 
+/* Get io_work or the poll group of @queue to process it */
+static void nvmet_tcp_schedule_io(struct nvmet_tcp_queue *queue)
+{
+	struct nvmet_tcp_poll_group *pg = queue->pg;
+
+	if (pg) {
+		if (!atomic_xchg(&pg->kicked, 1))
+			wake_up_process(pg->thread);
+		return;
+	}
+	queue_work_on(queue_cpu(queue), nvmet_tcp_wq, &queue->io_work);
+}
+
 static inline u8 nvmet_tcp_hdgst_len(struct nvmet_tcp_queue *queue)
 {
 	return queue->hdr_digest ? NVME_TCP_DIGEST_LENGTH : 0;
@@ -590,7 +641,7 @@ static void nvmet_tcp_queue_response(struct nvmet_req *req)
 	}
 
 	llist_add(&cmd->lentry, &queue->resp_list);
-	queue_work_on(queue_cpu(queue), nvmet_tcp_wq, &cmd->queue->io_work);
+	nvmet_tcp_schedule_io(queue);
 }
 
 static void nvmet_tcp_execute_request(struct nvmet_tcp_cmd *cmd)
@@ -1423,38 +1474,166 @@ static bool nvmet_tcp_check_queue_deadline(struct nvmet_tcp_queue *queue,
 	return !time_after(jiffies, queue->poll_end);
 }
 
-static void nvmet_tcp_io_work(struct work_struct *w)
+/*
+ * Receive and send on @queue for up to NVMET_TCP_IO_WORK_BUDGET ops.
+ * Returns 1 if there is more to do, 0 if not, and < 0 on error.
+ */
+static int nvmet_tcp_do_io(struct nvmet_tcp_queue *queue, int *ops)
 {
-	struct nvmet_tcp_queue *queue =
-		container_of(w, struct nvmet_tcp_queue, io_work);
 	bool pending;
-	int ret, ops = 0;
+	int ret;
 
 	do {
 		pending = false;
 
-		ret = nvmet_tcp_try_recv(queue, NVMET_TCP_RECV_BUDGET, &ops);
+		ret = nvmet_tcp_try_recv(queue, NVMET_TCP_RECV_BUDGET, ops);
 		if (ret > 0)
 			pending = true;
 		else if (ret < 0)
-			return;
+			return ret;
 
-		ret = nvmet_tcp_try_send(queue, NVMET_TCP_SEND_BUDGET, &ops);
+		ret = nvmet_tcp_try_send(queue, NVMET_TCP_SEND_BUDGET, ops);
 		if (ret > 0)
 			pending = true;
 		else if (ret < 0)
-			return;
+			return ret;
+
+	} while (pending && *ops < NVMET_TCP_IO_WORK_BUDGET);
+
+	return pending;
+}
+
+static void nvmet_tcp_io_work(struct work_struct *w)
+{
+	struct nvmet_tcp_queue *queue =
+		container_of(w, struct nvmet_tcp_queue, io_work);
+	int ret, ops = 0;
 
-	} while (pending && ops < NVMET_TCP_IO_WORK_BUDGET);
+	ret = nvmet_tcp_do_io(queue, &ops);
+	if (ret < 0)
+		return;
 
 	/*
 	 * Requeue the worker if idle deadline period is in progress or any
 	 * ops activity was recorded during the do-while loop above.
 	 */
-	if (nvmet_tcp_check_queue_deadline(queue, ops) || pending)
+	if (nvmet_tcp_check_queue_deadline(queue, ops) || ret)
 		queue_work_on(queue_cpu(queue), nvmet_tcp_wq, &queue->io_work);
 }
 
+#ifdef CONFIG_NET_RX_BUSY_POLL
+/* Busy poll each NAPI context once per round */
+static void nvmet_tcp_pg_busy_poll(struct sock *sk, unsigned int *napi_id)
+{
+	unsigned int id = READ_ONCE(sk->sk_napi_id);
+
+	if (id == *napi_id || !sk_can_busy_loop(sk) ||
+	    !skb_queue_empty_lockless(&sk->sk_receive_queue))
+		return;
+	*napi_id = id;
+	sk_busy_loop(sk, true);
+}
+#else
+static inline void nvmet_tcp_pg_busy_poll(struct sock *sk,
+		unsigned int *napi_id)
+{
+}
+#endif
+
+static int nvmet_tcp_poll_group_thread(void *data)
+{
+	struct nvmet_tcp_poll_group *pg = data;
+	unsigned long idle_end = jiffies;
+
+	while (!kthread_should_stop()) {
+		struct nvmet_tcp_queue *queue;
+		unsigned int napi_id = 0;
+		struct blk_plug plug;
+		u64 start = local_clock(), delta;
+		int ops = 0;
+
+		/* pairs with atomic_xchg() in nvmet_tcp_schedule_io() */
+		atomic_xchg(&pg->kicked, 0);
+
+		/* batch the backend I/O of all queues of the round */
+		blk_start_plug(&plug);
+		mutex_lock(&pg->lock);
+		list_for_each_entry(queue, &pg->queues, pg_entry) {
+			nvmet_tcp_pg_busy_poll(queue->sock->sk, &napi_id);
+			nvmet_tcp_do_io(queue, &ops);
+		}
+		mutex_unlock(&pg->lock);
+		blk_finish_plug(&plug);
+
+		delta = local_clock() - start;
+		pg->rounds++;
+		pg->ops += ops;
+		if (ops) {
+			pg->busy_ns += delta;
+			idle_end = jiffies +
+				usecs_to_jiffies(idle_poll_period_usecs);
+		} else {
+			pg->idle_ns += delta;
+		}
+
+		if (ops || time_before(jiffies, idle_end)) {
+			cond_resched();
+			continue;
+		}
+
+		set_current_state(TASK_INTERRUPTIBLE);
+		if (!atomic_read(&pg->kicked) && !kthread_should_stop()) {
+			pg->sleeps++;
+			schedule();
+		}
+		__set_current_state(TASK_RUNNING);
+	}
+	return 0;
+}
+
+/* Pick the poll group of the cpu receiving for @queue, if any */
+static struct nvmet_tcp_poll_group *
+nvmet_tcp_queue_poll_group(struct nvmet_tcp_queue *queue)
+{
+	int cpu = queue_cpu(queue);
+
+	if (!nvmet_tcp_poll_groups)
+		return NULL;
+	if (cpu < 0 || cpu >= nr_cpu_ids ||
+	    !nvmet_tcp_poll_groups[cpu].thread)
+		cpu = raw_smp_processor_id();
+	if (!nvmet_tcp_poll_groups[cpu].thread)
+		return NULL;
+	return &nvmet_tcp_poll_groups[cpu];
+}
+
+static void nvmet_tcp_pg_add_queue(struct nvmet_tcp_queue *queue)
+{
+	struct nvmet_tcp_poll_group *pg = queue->pg;
+
+	mutex_lock(&pg->lock);
+	list_add_tail(&queue->pg_entry, &pg->queues);
+	pg->nr_queues++;
+	mutex_unlock(&pg->lock);
+	nvmet_tcp_schedule_io(queue);
+}
+
+/* Once this returns, the poll group doesn't touch @queue anymore */
+static void nvmet_tcp_pg_del_queue(struct nvmet_tcp_queue *queue)
+{
+	struct nvmet_tcp_poll_group *pg = queue->pg;
+
+	if (!pg)
+		return;
+
+	mutex_lock(&pg->lock);
+	if (!list_empty(&queue->pg_entry)) {
+		list_del_init(&queue->pg_entry);
+		pg->nr_queues--;
+	}
+	mutex_unlock(&pg->lock);
+}
+
 static int nvmet_tcp_alloc_cmd(struct nvmet_tcp_queue *queue,
 		struct nvmet_tcp_cmd *c)
 {
@@ -1598,6 +1777,7 @@ static void nvmet_tcp_release_queue_work(struct work_struct *w)
 
 	nvmet_tcp_restore_socket_callbacks(queue);
 	cancel_delayed_work_sync(&queue->tls_handshake_tmo_work);
+	nvmet_tcp_pg_del_queue(queue);
 	cancel_work_sync(&queue->io_work);
 	/* stop accepting incoming data */
 	queue->rcv_state = NVMET_TCP_RECV_ERR;
@@ -1628,8 +1808,7 @@ static void nvmet_tcp_data_ready(struct sock *sk)
 		if (queue->data_ready)
 			queue->data_ready(sk);
 		if (queue->state != NVMET_TCP_Q_TLS_HANDSHAKE)
-			queue_work_on(queue_cpu(queue), nvmet_tcp_wq,
-				      &queue->io_work);
+			nvmet_tcp_schedule_io(queue);
 	}
 	read_unlock_bh(&sk->sk_callback_lock);
 }
@@ -1650,7 +1829,7 @@ static void nvmet_tcp_write_space(struct sock *sk)
 
 	if (sk_stream_is_writeable(sk)) {
 		clear_bit(SOCK_NOSPACE, &sk->sk_socket->flags);
-		queue_work_on(queue_cpu(queue), nvmet_tcp_wq, &queue->io_work);
+		nvmet_tcp_schedule_io(queue);
 	}
 out:
 	read_unlock_bh(&sk->sk_callback_lock);
@@ -1713,6 +1892,12 @@ static int nvmet_tcp_set_queue_sock(struct nvmet_tcp_queue *queue)
 	if (inet->rcv_tos > 0)
 		ip_sock_set_tos(sock->sk, inet->rcv_tos);
 
+	/*
+	 * Pick the poll group before the callbacks are installed, so that
+	 * the queue is never processed by io_work concurrently
+	 */
+	queue->pg = nvmet_tcp_queue_poll_group(queue);
+
 	ret = 0;
 	write_lock_bh(&sock->sk->sk_callback_lock);
 	if (sock->sk->sk_state != TCP_ESTABLISHED) {
@@ -1731,10 +1916,17 @@ static int nvmet_tcp_set_queue_sock(struct nvmet_tcp_queue *queue)
 		sock->sk->sk_write_space = nvmet_tcp_write_space;
 		if (idle_poll_period_usecs)
 			nvmet_tcp_arm_queue_deadline(queue);
-		queue_work_on(queue_cpu(queue), nvmet_tcp_wq, &queue->io_work);
+		if (!queue->pg)
+			queue_work_on(queue_cpu(queue), nvmet_tcp_wq,
+				      &queue->io_work);
 	}
 	write_unlock_bh(&sock->sk->sk_callback_lock);
 
+	if (!ret && queue->pg)
+		nvmet_tcp_pg_add_queue(queue);
+	else if (ret)
+		queue->pg = NULL;
+
 	return ret;
 }
 
@@ -1884,6 +2076,7 @@ static void nvmet_tcp_alloc_queue(struct nvmet_tcp_port *port,
 
 	INIT_WORK(&queue->release_work, nvmet_tcp_release_queue_work);
 	INIT_WORK(&queue->io_work, nvmet_tcp_io_work);
+	INIT_LIST_HEAD(&queue->pg_entry);
 	kref_init(&queue->kref);
 	queue->sock = newsock;
 	queue->port = port;
@@ -2195,6 +2388,82 @@ static const struct nvmet_fabrics_ops nvmet_tcp_ops = {
 	.host_traddr		= nvmet_tcp_host_port_addr,
 };
 
+static int nvmet_tcp_poll_groups_show(struct seq_file *m, void *p)
+{
+	int cpu;
+
+	seq_puts(m, "cpu queues rounds ops busy_us idle_us sleeps\n");
+	for_each_possible_cpu(cpu) {
+		struct nvmet_tcp_poll_group *pg = &nvmet_tcp_poll_groups[cpu];
+
+		if (!pg->thread)
+			continue;
+		seq_printf(m, "%d %u %llu %llu %llu %llu %llu\n", cpu,
+			   READ_ONCE(pg->nr_queues), READ_ONCE(pg->rounds),
+			   READ_ONCE(pg->ops),
+			   div_u64(READ_ONCE(pg->busy_ns), NSEC_PER_USEC),
+			   div_u64(READ_ONCE(pg->idle_ns), NSEC_PER_USEC),
+			   READ_ONCE(pg->sleeps));
+	}
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(nvmet_tcp_poll_groups);
+
+static void nvmet_tcp_free_poll_groups(void)
+{
+	int cpu;
+
+	if (!nvmet_tcp_poll_groups)
+		return;
+
+	debugfs_remove_recursive(nvmet_tcp_debugfs);
+	for_each_possible_cpu(cpu) {
+		struct nvmet_tcp_poll_group *pg = &nvmet_tcp_poll_groups[cpu];
+
+		if (pg->thread) {
+			WARN_ON_ONCE(!list_empty(&pg->queues));
+			kthread_stop(pg->thread);
+		}
+	}
+	kfree(nvmet_tcp_poll_groups);
+	nvmet_tcp_poll_groups = NULL;
+}
+
+static int __init nvmet_tcp_alloc_poll_groups(void)
+{
+	int cpu;
+
+	nvmet_tcp_poll_groups = kcalloc(nr_cpu_ids,
+					sizeof(*nvmet_tcp_poll_groups),
+					GFP_KERNEL);
+	if (!nvmet_tcp_poll_groups)
+		return -ENOMEM;
+
+	cpus_read_lock();
+	for_each_online_cpu(cpu) {
+		struct nvmet_tcp_poll_group *pg = &nvmet_tcp_poll_groups[cpu];
+		struct task_struct *thread;
+
+		mutex_init(&pg->lock);
+		INIT_LIST_HEAD(&pg->queues);
+		thread = kthread_create_on_cpu(nvmet_tcp_poll_group_thread, pg,
+					       cpu, "nvmet_tcp_pg/%u");
+		if (IS_ERR(thread)) {
+			cpus_read_unlock();
+			nvmet_tcp_free_poll_groups();
+			return PTR_ERR(thread);
+		}
+		pg->thread = thread;
+		wake_up_process(thread);
+	}
+	cpus_read_unlock();
+
+	nvmet_tcp_debugfs = debugfs_create_dir("nvmet_tcp", NULL);
+	debugfs_create_file("poll_groups", 0400, nvmet_tcp_debugfs, NULL,
+			    &nvmet_tcp_poll_groups_fops);
+	return 0;
+}
+
 static int __init nvmet_tcp_init(void)
 {
 	int ret;
@@ -2204,11 +2473,19 @@ static int __init nvmet_tcp_init(void)
 	if (!nvmet_tcp_wq)
 		return -ENOMEM;
 
+	if (poll_groups) {
+		ret = nvmet_tcp_alloc_poll_groups();
+		if (ret)
+			goto err;
+	}
+
 	ret = nvmet_register_transport(&nvmet_tcp_ops);
 	if (ret)
-		goto err;
+		goto err_free_poll_groups;
 
 	return 0;
+err_free_poll_groups:
+	nvmet_tcp_free_poll_groups();
 err:
 	destroy_workqueue(nvmet_tcp_wq);
 	return ret;
@@ -2227,6 +2504,7 @@ static void __exit nvmet_tcp_exit(void)
 	mutex_unlock(&nvmet_tcp_queue_mutex);
 	flush_workqueue(nvmet_wq);
 
+	nvmet_tcp_free_poll_groups();
 	destroy_workqueue(nvmet_tcp_wq);
 	ida_destroy(&nvmet_tcp_queue_ida);
 }
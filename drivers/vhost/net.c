@@ -40,6 +40,11 @@ module_param(experimental_zcopytx, int, 0444);
 MODULE_PARM_DESC(experimental_zcopytx, "Enable Zero Copy TX;"
 		                       " 1 -Enable; 0 - Disable");
 
+static bool adaptive_busyloop;
+module_param(adaptive_busyloop, bool, 0644);
+MODULE_PARM_DESC(adaptive_busyloop, "Shrink the busy poll window of idle"
+		 " virtqueues and grow it back when polling finds work");
+
 /* Max number of bytes transferred before requeueing the job.
  * Using this limit prevents one virtqueue from starving others. */
 #define VHOST_NET_WEIGHT 0x80000
@@ -50,6 +55,12 @@ MODULE_PARM_DESC(experimental_zcopytx, "Enable Zero Copy TX;"
  */
 #define VHOST_NET_PKT_WEIGHT 256
 
+/* With adaptive busy polling, the window of a virtqueue is halved each time
+ * polling finds nothing, down to 1/2^VHOST_NET_BUSYLOOP_SHRINK of the
+ * configured timeout, and doubled each time it finds work.
+ */
+#define VHOST_NET_BUSYLOOP_SHRINK 4
+
 /* MAX number of TX used buffers for outstanding zerocopy */
 #define VHOST_MAX_PEND 128
 #define VHOST_GOODCOPY_LEN 256
@@ -127,6 +138,10 @@ struct vhost_net_virtqueue {
 	struct vhost_net_buf rxq;
 	/* Batched XDP buffs */
 	struct xdp_buff *xdp;
+	/* Current busy poll window with adaptive_busyloop, 0 until first
+	 * used. Protected by vq mutex.
+	 */
+	unsigned long busyloop_cur;
 };
 
 struct vhost_net {
@@ -520,16 +535,49 @@ static void vhost_net_busy_poll_try_queue(struct vhost_net *net,
 	}
 }
 
+static unsigned long vhost_net_busyloop_window(struct vhost_net_virtqueue *nvq)
+{
+	unsigned long timeout = nvq->vq.busyloop_timeout;
+
+	if (!READ_ONCE(adaptive_busyloop))
+		return timeout;
+
+	if (!nvq->busyloop_cur || nvq->busyloop_cur > timeout)
+		nvq->busyloop_cur = timeout;
+
+	return nvq->busyloop_cur;
+}
+
+static void vhost_net_busyloop_update(struct vhost_net_virtqueue *nvq,
+				      bool found)
+{
+	unsigned long timeout = nvq->vq.busyloop_timeout;
+	unsigned long floor;
+
+	if (!READ_ONCE(adaptive_busyloop) || !nvq->busyloop_cur)
+		return;
+
+	if (found) {
+		nvq->busyloop_cur = min(nvq->busyloop_cur << 1, timeout);
+	} else {
+		floor = max(timeout >> VHOST_NET_BUSYLOOP_SHRINK, 1UL);
+		nvq->busyloop_cur = max(nvq->busyloop_cur >> 1, floor);
+	}
+}
+
 static void vhost_net_busy_poll(struct vhost_net *net,
 				struct vhost_virtqueue *rvq,
 				struct vhost_virtqueue *tvq,
 				bool *busyloop_intr,
 				bool poll_rx)
 {
+	struct vhost_net_virtqueue *nvq =
+		container_of(poll_rx ? rvq : tvq, struct vhost_net_virtqueue, vq);
 	unsigned long busyloop_timeout;
 	unsigned long endtime;
 	struct socket *sock;
 	struct vhost_virtqueue *vq = poll_rx ? tvq : rvq;
+	bool found = false;
 
 	/* Try to hold the vq mutex of the paired virtqueue. We can't
 	 * use mutex_lock() here since we could not guarantee a
@@ -541,8 +589,7 @@ static void vhost_net_busy_poll(struct vhost_net *net,
 	vhost_disable_notify(&net->dev, vq);
 	sock = vhost_vq_get_backend(rvq);
 
-	busyloop_timeout = poll_rx ? rvq->busyloop_timeout:
-				     tvq->busyloop_timeout;
+	busyloop_timeout = vhost_net_busyloop_window(nvq);
 
 	preempt_disable();
 	endtime = busy_clock() + busyloop_timeout;
@@ -550,19 +597,24 @@ static void vhost_net_busy_poll(struct vhost_net *net,
 	while (vhost_can_busy_poll(endtime)) {
 		if (vhost_vq_has_work(vq)) {
 			*busyloop_intr = true;
+			found = true;
 			break;
 		}
 
 		if ((sock_has_rx_data(sock) &&
 		     !vhost_vq_avail_empty(&net->dev, rvq)) ||
-		    !vhost_vq_avail_empty(&net->dev, tvq))
+		    !vhost_vq_avail_empty(&net->dev, tvq)) {
+			found = true;
 			break;
+		}
 
 		cpu_relax();
 	}
 
 	preempt_enable();
 
+	vhost_net_busyloop_update(nvq, found);
+
 	if (poll_rx || sock_has_rx_data(sock))
 		vhost_net_busy_poll_try_queue(net, vq);
 	else if (!poll_rx) /* On tx here, sock has no rx data. */
@@ -1708,6 +1760,18 @@ static long vhost_net_ioctl(struct file *f, unsigned int ioctl,
 		return vhost_net_reset_owner(n);
 	case VHOST_SET_OWNER:
 		return vhost_net_set_owner(n);
+	case VHOST_NEW_WORKER:
+	case VHOST_FREE_WORKER:
+	case VHOST_ATTACH_VRING_WORKER:
+	case VHOST_GET_VRING_WORKER:
+		/* RX and TX handlers only take each other's vq mutex with
+		 * mutex_trylock() when busy polling, so the two vqs of the
+		 * device can be served by different workers.
+		 */
+		mutex_lock(&n->dev.mutex);
+		r = vhost_worker_ioctl(&n->dev, ioctl, argp);
+		mutex_unlock(&n->dev.mutex);
+		return r;
 	default:
 		mutex_lock(&n->dev.mutex);
 		r = vhost_dev_ioctl(&n->dev, ioctl, argp);
@@ -500,6 +500,95 @@ static unsigned long maximum_alignment(struct elf_phdr *cmds, int nr)
 	return ELF_PAGEALIGN(alignment);
 }
 
+/*
+ * An executable segment that can be mapped with PMD sized pages once it is
+ * loaded at a PMD aligned address: large enough, and at a file offset that
+ * is congruent to its address.
+ */
+static bool elf_huge_text_segment(const struct elf_phdr *phdr)
+{
+	return phdr->p_type == PT_LOAD && (phdr->p_flags & PF_X) &&
+	       phdr->p_filesz >= PMD_SIZE &&
+	       IS_ALIGNED(phdr->p_vaddr - phdr->p_offset, PMD_SIZE);
+}
+
+#define HUGE_TEXT_NOTE_NAME	"Linux"
+#define HUGE_TEXT_NOTES_MAX	256
+
+static bool elf_has_huge_text_note(struct file *file,
+				   const struct elf_phdr *phdr)
+{
+	char buf[HUGE_TEXT_NOTES_MAX] __aligned(4);
+	size_t off = 0, size = phdr->p_filesz;
+
+	if (size < sizeof(struct elf_note) || size > sizeof(buf))
+		return false;
+	if (elf_read(file, buf, size, phdr->p_offset) < 0)
+		return false;
+
+	while (size - off >= sizeof(struct elf_note)) {
+		struct elf_note *nhdr = (struct elf_note *)(buf + off);
+		size_t namesz = ALIGN(nhdr->n_namesz, 4);
+		size_t descsz = ALIGN(nhdr->n_descsz, 4);
+
+		off += sizeof(*nhdr);
+		if (namesz > size - off || descsz > size - off - namesz)
+			return false;
+
+		if (nhdr->n_type == NT_LINUX_HUGE_TEXT &&
+		    nhdr->n_namesz == sizeof(HUGE_TEXT_NOTE_NAME) &&
+		    !memcmp(buf + off, HUGE_TEXT_NOTE_NAME, nhdr->n_namesz))
+			return true;
+
+		off += namesz + descsz;
+	}
+
+	return false;
+}
+
+/*
+ * Whether to lay out the binary for huge text pages: only when it has a
+ * large enough executable segment and the process asked for it with
+ * PR_SET_EXEC_HUGE_TEXT or the binary with an NT_LINUX_HUGE_TEXT note.
+ */
+static bool elf_wants_huge_text(struct file *file,
+				const struct elf_phdr *phdrs, int nr)
+{
+	bool found = false;
+	int i;
+
+	if (!IS_ENABLED(CONFIG_TRANSPARENT_HUGEPAGE))
+		return false;
+
+	for (i = 0; i < nr && !found; i++)
+		found = elf_huge_text_segment(&phdrs[i]);
+	if (!found)
+		return false;
+
+	if (task_exec_huge_text(current))
+		return true;
+
+	for (i = 0; i < nr; i++)
+		if (phdrs[i].p_type == PT_NOTE &&
+		    elf_has_huge_text_note(file, &phdrs[i]))
+			return true;
+
+	return false;
+}
+
+/*
+ * Fill the text segment mapped at @addr from the page cache right away,
+ * rather than taking a fault for every page of it, and let it be mapped
+ * or collapsed to huge pages.
+ */
+static void elf_prefault_text(unsigned long addr, const struct elf_phdr *phdr)
+{
+	size_t len = ELF_PAGEALIGN(phdr->p_filesz + ELF_PAGEOFFSET(phdr->p_vaddr));
+
+	do_madvise(current->mm, addr, len, MADV_HUGEPAGE);
+	do_madvise(current->mm, addr, len, MADV_POPULATE_READ);
+}
+
 /**
  * load_elf_phdrs() - load ELF program headers
  * @elf_ex:   ELF header of the binary whose program headers should be loaded
@@ -838,6 +927,7 @@ static int load_elf_binary(struct linux_binprm *bprm)
 	unsigned long start_code, end_code, start_data, end_data;
 	unsigned long reloc_func_desc __maybe_unused = 0;
 	int executable_stack = EXSTACK_DEFAULT;
+	bool huge_text;
 	struct elfhdr *elf_ex = (struct elfhdr *)bprm->buf;
 	struct elfhdr *interp_elf_ex = NULL;
 	struct arch_elf_state arch_state = INIT_ARCH_ELF_STATE;
@@ -946,6 +1036,8 @@ static int load_elf_binary(struct linux_binprm *bprm)
 			break;
 		}
 
+	huge_text = elf_wants_huge_text(bprm->file, elf_phdata, elf_ex->e_phnum);
+
 	/* Some simple consistency checks for the interpreter */
 	if (interpreter) {
 		retval = -ELIBBAD;
@@ -1098,6 +1190,10 @@ static int load_elf_binary(struct linux_binprm *bprm)
 			/* Calculate any requested alignment. */
 			alignment = maximum_alignment(elf_phdata, elf_ex->e_phnum);
 
+			/* Let the text be mapped with PMD sized pages */
+			if (huge_text)
+				alignment = max_t(unsigned long, alignment, PMD_SIZE);
+
 			/*
 			 * There are effectively two types of ET_DYN
 			 * binaries: programs (i.e. PIE: ET_DYN with PT_INTERP)
@@ -1178,6 +1274,9 @@ static int load_elf_binary(struct linux_binprm *bprm)
 			goto out_free_dentry;
 		}
 
+		if (huge_text && elf_huge_text_segment(elf_ppnt))
+			elf_prefault_text(error, elf_ppnt);
+
 		if (first_pt_load) {
 			first_pt_load = 0;
 			if (elf_ex->e_type == ET_DYN) {
@@ -6,6 +6,7 @@
 
 #include <linux/slab.h>
 #include <linux/iversion.h>
+#include <linux/sort.h>
 #include "ctree.h"
 #include "fs.h"
 #include "messages.h"
@@ -1316,58 +1317,116 @@ struct btrfs_async_delayed_work {
 	struct btrfs_work work;
 };
 
+/*
+ * Order delayed nodes by root and then by inode number, so that a batch of
+ * nodes is flushed walking the subvolume trees left to right.
+ */
+static int btrfs_delayed_node_cmp(const void *a, const void *b)
+{
+	const struct btrfs_delayed_node *node1 =
+		*(const struct btrfs_delayed_node **)a;
+	const struct btrfs_delayed_node *node2 =
+		*(const struct btrfs_delayed_node **)b;
+	const u64 root1 = btrfs_root_id(node1->root);
+	const u64 root2 = btrfs_root_id(node2->root);
+
+	if (root1 != root2)
+		return root1 < root2 ? -1 : 1;
+	if (node1->inode_id != node2->inode_id)
+		return node1->inode_id < node2->inode_id ? -1 : 1;
+	return 0;
+}
+
+/*
+ * Flush the delayed items of a batch of prepared nodes.
+ *
+ * Create heavy workloads queue long runs of delayed nodes for inodes that are
+ * close to each other in the same subvolume tree. Instead of joining a
+ * transaction for every node and flushing them in queueing order, sort the
+ * batch and flush all nodes of the same root under one transaction handle, in
+ * key order. Consecutive searches then go down to the same or neighbouring
+ * leaves while they are still cached, and we do the transaction join and dirty
+ * metadata balancing once per root instead of once per inode.
+ */
+static void btrfs_async_run_delayed_batch(struct btrfs_path *path,
+					  struct btrfs_delayed_node **batch,
+					  int nr)
+{
+	int i = 0;
+
+	sort(batch, nr, sizeof(batch[0]), btrfs_delayed_node_cmp, NULL);
+
+	while (i < nr) {
+		struct btrfs_root *root = batch[i]->root;
+		struct btrfs_trans_handle *trans;
+		struct btrfs_block_rsv *block_rsv;
+		int end = i;
+
+		while (end < nr && batch[end]->root == root)
+			end++;
+
+		trans = btrfs_join_transaction(root);
+		if (IS_ERR(trans)) {
+			for (; i < end; i++)
+				btrfs_release_prepared_delayed_node(batch[i]);
+			continue;
+		}
+
+		block_rsv = trans->block_rsv;
+		trans->block_rsv = &root->fs_info->delayed_block_rsv;
+
+		for (int j = i; j < end; j++) {
+			__btrfs_commit_inode_delayed_items(trans, path, batch[j]);
+			btrfs_release_path(path);
+		}
+
+		trans->block_rsv = block_rsv;
+		btrfs_end_transaction(trans);
+		btrfs_btree_balance_dirty_nodelay(root->fs_info);
+
+		for (; i < end; i++)
+			btrfs_release_prepared_delayed_node(batch[i]);
+	}
+}
+
 static void btrfs_async_run_delayed_root(struct btrfs_work *work)
 {
 	struct btrfs_async_delayed_work *async_work;
 	struct btrfs_delayed_root *delayed_root;
-	struct btrfs_trans_handle *trans;
 	struct btrfs_path *path;
-	struct btrfs_delayed_node *delayed_node = NULL;
-	struct btrfs_root *root;
-	struct btrfs_block_rsv *block_rsv;
 	int total_done = 0;
+	int limit;
 
 	async_work = container_of(work, struct btrfs_async_delayed_work, work);
 	delayed_root = async_work->delayed_root;
+	limit = async_work->nr ?: BTRFS_DELAYED_WRITEBACK;
 
 	path = btrfs_alloc_path();
 	if (!path)
 		goto out;
 
 	do {
+		struct btrfs_delayed_node *batch[BTRFS_DELAYED_BATCH];
+		int nr = 0;
+
 		if (atomic_read(&delayed_root->items) <
 		    BTRFS_DELAYED_BACKGROUND / 2)
 			break;
 
-		delayed_node = btrfs_first_prepared_delayed_node(delayed_root);
-		if (!delayed_node)
-			break;
-
-		root = delayed_node->root;
+		while (nr < ARRAY_SIZE(batch) && total_done + nr < limit) {
+			struct btrfs_delayed_node *node;
 
-		trans = btrfs_join_transaction(root);
-		if (IS_ERR(trans)) {
-			btrfs_release_path(path);
-			btrfs_release_prepared_delayed_node(delayed_node);
-			total_done++;
-			continue;
+			node = btrfs_first_prepared_delayed_node(delayed_root);
+			if (!node)
+				break;
+			batch[nr++] = node;
 		}
+		if (!nr)
+			break;
 
-		block_rsv = trans->block_rsv;
-		trans->block_rsv = &root->fs_info->delayed_block_rsv;
-
-		__btrfs_commit_inode_delayed_items(trans, path, delayed_node);
-
-		trans->block_rsv = block_rsv;
-		btrfs_end_transaction(trans);
-		btrfs_btree_balance_dirty_nodelay(root->fs_info);
-
-		btrfs_release_path(path);
-		btrfs_release_prepared_delayed_node(delayed_node);
-		total_done++;
-
-	} while ((async_work->nr == 0 && total_done < BTRFS_DELAYED_WRITEBACK)
-		 || total_done < async_work->nr);
+		btrfs_async_run_delayed_batch(path, batch, nr);
+		total_done += nr;
+	} while (total_done < limit);
 
 	btrfs_free_path(path);
 out:
@@ -1375,7 +1434,6 @@ static void btrfs_async_run_delayed_root(struct btrfs_work *work)
 	kfree(async_work);
 }
 
-
 static int btrfs_wq_run_delayed_node(struct btrfs_delayed_root *delayed_root,
 				     struct btrfs_fs_info *fs_info, int nr)
 {
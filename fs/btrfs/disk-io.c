@@ -1963,6 +1963,22 @@ static void btrfs_init_qgroup(struct btrfs_fs_info *fs_info)
 	mutex_init(&fs_info->qgroup_rescan_lock);
 }
 
+/*
+ * Compressing async delalloc chunks is CPU bound, every chunk is independent
+ * and their submission is kept in order by the ordered work callbacks.  Unless
+ * the thread pool size was set by the user, let the delalloc workers use all
+ * CPUs instead of stopping at the default pool size, so compressed writeback
+ * is not capped at 8 concurrent chunks on large machines.
+ */
+u32 btrfs_delalloc_max_active(const struct btrfs_fs_info *fs_info)
+{
+	const u32 def = min_t(unsigned long, num_online_cpus() + 2, 8);
+
+	if (fs_info->thread_pool_size != def)
+		return fs_info->thread_pool_size;
+	return max_t(u32, def, num_online_cpus());
+}
+
 static int btrfs_init_workqueues(struct btrfs_fs_info *fs_info)
 {
 	u32 max_active = fs_info->thread_pool_size;
@@ -1973,8 +1989,8 @@ static int btrfs_init_workqueues(struct btrfs_fs_info *fs_info)
 		btrfs_alloc_workqueue(fs_info, "worker", flags, max_active, 16);
 
 	fs_info->delalloc_workers =
-		btrfs_alloc_workqueue(fs_info, "delalloc",
-				      flags, max_active, 2);
+		btrfs_alloc_workqueue(fs_info, "delalloc", flags,
+				      btrfs_delalloc_max_active(fs_info), 2);
 
 	fs_info->flush_workers =
 		btrfs_alloc_workqueue(fs_info, "flush_delalloc",
@@ -2045,7 +2061,8 @@ static int btrfs_init_csum_hash(struct btrfs_fs_info *fs_info, u16 csum_type)
 	 */
 	switch (csum_type) {
 	case BTRFS_CSUM_TYPE_CRC32:
-		if (!strstr(crypto_shash_driver_name(csum_shash), "generic"))
+		/* Data checksums use the crc32c library, see btrfs_csum_data(). */
+		if (crc32_optimizations() & CRC32C_OPTIMIZATION)
 			set_bit(BTRFS_FS_CSUM_IMPL_FAST, &fs_info->flags);
 		break;
 	case BTRFS_CSUM_TYPE_XXHASH:
@@ -3332,6 +3349,7 @@ int __cold open_ctree(struct super_block *sb, struct btrfs_fs_devices *fs_device
 	}
 
 	fs_info->csum_size = btrfs_super_csum_size(disk_super);
+	fs_info->csum_type = csum_type;
 
 	ret = btrfs_init_csum_hash(fs_info, csum_type);
 	if (ret) {
@@ -1,5 +1,8 @@
 // SPDX-License-Identifier: GPL-2.0
 
+#include <linux/crc32c.h>
+#include <linux/unaligned.h>
+#include <crypto/hash.h>
 #include "messages.h"
 #include "ctree.h"
 #include "fs.h"
@@ -55,6 +58,27 @@ size_t __attribute_const__ btrfs_get_num_csums(void)
 	return ARRAY_SIZE(btrfs_csums);
 }
 
+/*
+ * Calculate the checksum of one data block into @out.
+ *
+ * crc32c data checksums are computed by the crc32c library directly, which is
+ * architecture optimized where possible, saving the shash indirection and
+ * descriptor setup that otherwise has to be paid for every single sector.
+ */
+void btrfs_csum_data(struct btrfs_fs_info *fs_info, const u8 *data, u32 len,
+		     u8 *out)
+{
+	SHASH_DESC_ON_STACK(shash, fs_info->csum_shash);
+
+	if (fs_info->csum_type == BTRFS_CSUM_TYPE_CRC32) {
+		put_unaligned_le32(~crc32c(~0, data, len), out);
+		return;
+	}
+
+	shash->tfm = fs_info->csum_shash;
+	crypto_shash_digest(shash, data, len, out);
+}
+
 /*
  * Start exclusive operation @type, return true on success.
  */
@@ -800,6 +800,7 @@ struct btrfs_fs_info {
 	/* ilog2 of sectorsize, use to avoid 64bit division */
 	u32 sectorsize_bits;
 	u32 csum_size;
+	u16 csum_type;
 	u32 csums_per_leaf;
 	u32 stripesize;
 
@@ -997,6 +998,8 @@ int btrfs_super_csum_size(const struct btrfs_super_block *s);
 const char *btrfs_super_csum_name(u16 csum_type);
 const char *btrfs_super_csum_driver(u16 csum_type);
 size_t __attribute_const__ btrfs_get_num_csums(void);
+void btrfs_csum_data(struct btrfs_fs_info *fs_info, const u8 *data, u32 len,
+		     u8 *out);
 
 static inline bool btrfs_is_empty_uuid(const u8 *uuid)
 {
@@ -43,6 +43,9 @@
 #include <linux/timekeeping.h>
 #include <linux/sysctl.h>
 #include <linux/elf.h>
+#include <linux/sizes.h>
+#include <linux/workqueue.h>
+#include <linux/zstd.h>
 
 #include <linux/uaccess.h>
 #include <asm/mmu_context.h>
@@ -56,6 +59,8 @@
 
 static bool dump_vma_snapshot(struct coredump_params *cprm);
 static void free_vma_snapshot(struct coredump_params *cprm);
+static bool core_compress_start(struct coredump_params *cprm);
+static bool core_compress_finish(struct coredump_params *cprm, bool flush);
 
 #define CORE_FILE_NOTE_SIZE_DEFAULT (4*1024*1024)
 /* Define a reasonable max cap */
@@ -753,6 +758,10 @@ void do_coredump(const kernel_siginfo_t *siginfo)
 		}
 		if (!dump_vma_snapshot(&cprm))
 			goto close_fail;
+		if (!core_compress_start(&cprm)) {
+			free_vma_snapshot(&cprm);
+			goto close_fail;
+		}
 
 		file_start_write(cprm.file);
 		core_dumped = binfmt->core_dump(&cprm);
@@ -766,6 +775,8 @@ void do_coredump(const kernel_siginfo_t *siginfo)
 			cprm.to_skip--;
 			dump_emit(&cprm, "", 1);
 		}
+		if (!core_compress_finish(&cprm, core_dumped))
+			core_dumped = false;
 		file_end_write(cprm.file);
 		free_vma_snapshot(&cprm);
 	}
@@ -788,6 +799,246 @@ void do_coredump(const kernel_siginfo_t *siginfo)
 	return;
 }
 
+#ifdef CONFIG_COREDUMP_ZSTD
+/*
+ * Compressed core dumps: everything the binfmt emits is gathered into
+ * CORE_COMPRESS_CHUNK sized chunks, and each chunk is compressed as an
+ * independent zstd frame by an unbound worker while the dumping thread
+ * keeps collecting pages into the next slot. Frames are written out in
+ * slot order, so the output is a plain multi-frame zstd stream of the
+ * ELF core. Holes are emitted as zeroes, which compress to almost
+ * nothing. cprm->pos and cprm->written keep counting uncompressed bytes,
+ * so RLIMIT_CORE still applies to the size of the core itself.
+ */
+#define CORE_COMPRESS_CHUNK	SZ_1M
+#define CORE_COMPRESS_MAX_WORKERS	4
+
+static unsigned int core_compress_level;
+
+struct core_compress_slot {
+	struct work_struct work;
+	struct completion done;
+	struct core_compress *cc;
+	zstd_cctx *cctx;
+	void *workspace;
+	void *src;
+	void *dst;
+	size_t src_len;
+	size_t dst_len;
+	bool busy;
+};
+
+struct core_compress {
+	zstd_parameters params;
+	size_t dst_cap;
+	unsigned int nr_slots;
+	unsigned int cur;
+	bool failed;
+	struct core_compress_slot slots[];
+};
+
+static void core_compress_work(struct work_struct *work)
+{
+	struct core_compress_slot *slot =
+		container_of(work, struct core_compress_slot, work);
+	struct core_compress *cc = slot->cc;
+	size_t ret;
+
+	ret = zstd_compress_cctx(slot->cctx, slot->dst, cc->dst_cap,
+				 slot->src, slot->src_len, &cc->params);
+	slot->dst_len = zstd_is_error(ret) ? 0 : ret;
+	complete(&slot->done);
+}
+
+static void core_compress_free_slot(struct core_compress_slot *slot)
+{
+	kvfree(slot->workspace);
+	kvfree(slot->dst);
+	kvfree(slot->src);
+}
+
+static bool core_compress_alloc_slot(struct core_compress *cc,
+				     struct core_compress_slot *slot,
+				     size_t ws_size)
+{
+	slot->cc = cc;
+	INIT_WORK(&slot->work, core_compress_work);
+	init_completion(&slot->done);
+	slot->src = kvmalloc(CORE_COMPRESS_CHUNK, GFP_KERNEL);
+	slot->dst = kvmalloc(cc->dst_cap, GFP_KERNEL);
+	slot->workspace = kvmalloc(ws_size, GFP_KERNEL);
+	if (slot->src && slot->dst && slot->workspace)
+		slot->cctx = zstd_init_cctx(slot->workspace, ws_size);
+	if (!slot->cctx) {
+		core_compress_free_slot(slot);
+		return false;
+	}
+	return true;
+}
+
+static bool core_compress_start(struct coredump_params *cprm)
+{
+	unsigned int level = READ_ONCE(core_compress_level);
+	unsigned int nr, i;
+	struct core_compress *cc;
+	size_t ws_size;
+
+	if (!level)
+		return true;
+
+	/* One slot per worker, plus the one being filled */
+	nr = min(num_online_cpus(), CORE_COMPRESS_MAX_WORKERS) + 1;
+	cc = kzalloc(struct_size(cc, slots, nr), GFP_KERNEL);
+	if (!cc)
+		goto fail;
+	cc->params = zstd_get_params(min_t(int, level, zstd_max_clevel()),
+				     CORE_COMPRESS_CHUNK);
+	cc->dst_cap = zstd_compress_bound(CORE_COMPRESS_CHUNK);
+	ws_size = zstd_cctx_workspace_bound(&cc->params.cParams);
+
+	/* Make do with fewer workers if memory is tight */
+	for (i = 0; i < nr; i++)
+		if (!core_compress_alloc_slot(cc, &cc->slots[i], ws_size))
+			break;
+	if (!i) {
+		kfree(cc);
+		goto fail;
+	}
+	cc->nr_slots = i;
+	cprm->compress = cc;
+	return true;
+
+fail:
+	coredump_report_failure("Unable to allocate compression buffers, skipping core dump");
+	return false;
+}
+
+static void core_compress_submit(struct core_compress *cc,
+				 struct core_compress_slot *slot)
+{
+	slot->busy = true;
+	reinit_completion(&slot->done);
+	queue_work(system_unbound_wq, &slot->work);
+	cc->cur = (cc->cur + 1) % cc->nr_slots;
+}
+
+/* Wait for @slot to be compressed and write it out, unless @flush is false */
+static bool core_compress_write(struct coredump_params *cprm,
+				struct core_compress_slot *slot, bool flush)
+{
+	struct core_compress *cc = cprm->compress;
+	struct file *file = cprm->file;
+	loff_t pos = file->f_pos;
+	size_t off = 0;
+	ssize_t n;
+
+	wait_for_completion(&slot->done);
+	slot->busy = false;
+	slot->src_len = 0;
+	if (cc->failed || !flush)
+		return false;
+	if (!slot->dst_len)
+		goto fail;
+
+	while (off < slot->dst_len) {
+		if (dump_interrupted())
+			goto fail;
+		n = __kernel_write(file, slot->dst + off, slot->dst_len - off, &pos);
+		if (n <= 0)
+			goto fail;
+		off += n;
+	}
+	file->f_pos = pos;
+	return true;
+
+fail:
+	cc->failed = true;
+	return false;
+}
+
+/* Append @nr bytes from @addr, or zeroes if @addr is NULL, to the stream */
+static int core_compress_emit(struct coredump_params *cprm, const void *addr,
+			      size_t nr)
+{
+	struct core_compress *cc = cprm->compress;
+
+	while (nr) {
+		struct core_compress_slot *slot = &cc->slots[cc->cur];
+		size_t n;
+
+		/* The slot to fill next is always the oldest one in flight */
+		if (slot->busy && !core_compress_write(cprm, slot, true))
+			return 0;
+		if (cc->failed)
+			return 0;
+
+		n = min(nr, CORE_COMPRESS_CHUNK - slot->src_len);
+		if (addr) {
+			memcpy(slot->src + slot->src_len, addr, n);
+			addr += n;
+		} else {
+			memset(slot->src + slot->src_len, 0, n);
+		}
+		slot->src_len += n;
+		nr -= n;
+
+		if (slot->src_len == CORE_COMPRESS_CHUNK)
+			core_compress_submit(cc, slot);
+	}
+	return 1;
+}
+
+/*
+ * Compress and write out whatever is left, in order, then release the
+ * buffers. With @flush false the dump failed and in-flight work is only
+ * waited for.
+ */
+static bool core_compress_finish(struct coredump_params *cprm, bool flush)
+{
+	struct core_compress *cc = cprm->compress;
+	struct core_compress_slot *slot;
+	bool ret = true;
+	unsigned int i;
+
+	if (!cc)
+		return true;
+
+	slot = &cc->slots[cc->cur];
+	if (flush && !cc->failed && !slot->busy && slot->src_len)
+		core_compress_submit(cc, slot);
+
+	for (i = 0; i < cc->nr_slots; i++) {
+		slot = &cc->slots[(cc->cur + i) % cc->nr_slots];
+		if (slot->busy && !core_compress_write(cprm, slot, flush))
+			ret = false;
+	}
+	ret = ret && flush && !cc->failed;
+
+	for (i = 0; i < cc->nr_slots; i++)
+		core_compress_free_slot(&cc->slots[i]);
+	kfree(cc);
+	cprm->compress = NULL;
+	return ret;
+}
+#else
+static inline bool core_compress_start(struct coredump_params *cprm)
+{
+	return true;
+}
+
+static inline bool core_compress_finish(struct coredump_params *cprm,
+					bool flush)
+{
+	return true;
+}
+
+static inline int core_compress_emit(struct coredump_params *cprm,
+				     const void *addr, size_t nr)
+{
+	return 0;
+}
+#endif /* CONFIG_COREDUMP_ZSTD */
+
 /*
  * Core dumping helper functions.  These are the only things you should
  * do on a core-file: use only these functions to write out all the
@@ -804,6 +1055,13 @@ static int __dump_emit(struct coredump_params *cprm, const void *addr, int nr)
 
 	if (dump_interrupted())
 		return 0;
+	if (cprm->compress) {
+		if (!core_compress_emit(cprm, addr, nr))
+			return 0;
+		cprm->written += nr;
+		cprm->pos += nr;
+		return 1;
+	}
 	n = __kernel_write(file, addr, nr, &pos);
 	if (n != nr)
 		return 0;
@@ -818,7 +1076,14 @@ static int __dump_skip(struct coredump_params *cprm, size_t nr)
 {
 	static char zeroes[PAGE_SIZE];
 	struct file *file = cprm->file;
-	if (file->f_mode & FMODE_LSEEK) {
+	if (cprm->compress) {
+		if (cprm->written + nr > cprm->limit || dump_interrupted() ||
+		    !core_compress_emit(cprm, NULL, nr))
+			return 0;
+		cprm->written += nr;
+		cprm->pos += nr;
+		return 1;
+	} else if (file->f_mode & FMODE_LSEEK) {
 		if (dump_interrupted() ||
 		    vfs_llseek(file, nr, SEEK_CUR) < 0)
 			return 0;
@@ -878,6 +1143,17 @@ static int dump_emit_page(struct coredump_params *cprm, struct page *page)
 		return 0;
 	if (dump_interrupted())
 		return 0;
+	if (cprm->compress) {
+		void *buf = kmap_local_page(page);
+		int ret = core_compress_emit(cprm, buf, PAGE_SIZE);
+
+		kunmap_local(buf);
+		if (!ret)
+			return 0;
+		cprm->written += PAGE_SIZE;
+		cprm->pos += PAGE_SIZE;
+		return 1;
+	}
 	pos = file->f_pos;
 	bvec_set_page(&bvec, page, PAGE_SIZE, 0);
 	iov_iter_bvec(&iter, ITER_SOURCE, &bvec, 1, PAGE_SIZE);
@@ -920,6 +1196,25 @@ static inline struct page *dump_page_copy(struct page *src, struct page *dst)
 }
 #endif
 
+/*
+ * A page that reads as all zeroes can be left as a hole when the core
+ * file is seekable, which keeps the dump sparse and saves the write.
+ * Compressed dumps don't bother: the zeroes cost next to nothing there.
+ */
+static bool dump_page_is_zero(struct coredump_params *cprm, struct page *page)
+{
+	bool zero;
+	void *buf;
+
+	if (!page || cprm->compress || !(cprm->file->f_mode & FMODE_LSEEK))
+		return false;
+
+	buf = kmap_local_page(page);
+	zero = !memchr_inv(buf, 0, PAGE_SIZE);
+	kunmap_local(buf);
+	return zero;
+}
+
 int dump_user_range(struct coredump_params *cprm, unsigned long start,
 		    unsigned long len)
 {
@@ -942,7 +1237,13 @@ int dump_user_range(struct coredump_params *cprm, unsigned long start,
 		 */
 		page = get_dump_page(addr);
 		if (page) {
-			int stop = !dump_emit_page(cprm, dump_page_copy(page, dump_page));
+			struct page *copy = dump_page_copy(page, dump_page);
+			int stop = 0;
+
+			if (dump_page_is_zero(cprm, copy))
+				dump_skip(cprm, PAGE_SIZE);
+			else
+				stop = !dump_emit_page(cprm, copy);
 			put_page(page);
 			if (stop) {
 				dump_page_free(dump_page);
@@ -994,6 +1295,9 @@ static int proc_dostring_coredump(const struct ctl_table *table, int write,
 
 static const unsigned int core_file_note_size_min = CORE_FILE_NOTE_SIZE_DEFAULT;
 static const unsigned int core_file_note_size_max = CORE_FILE_NOTE_SIZE_MAX;
+#ifdef CONFIG_COREDUMP_ZSTD
+static const unsigned int core_compress_level_max = 22;
+#endif
 
 static const struct ctl_table coredump_sysctls[] = {
 	{
@@ -1026,6 +1330,17 @@ static const struct ctl_table coredump_sysctls[] = {
 		.extra1		= (unsigned int *)&core_file_note_size_min,
 		.extra2		= (unsigned int *)&core_file_note_size_max,
 	},
+#ifdef CONFIG_COREDUMP_ZSTD
+	{
+		.procname	= "core_compress_level",
+		.data		= &core_compress_level,
+		.maxlen		= sizeof(unsigned int),
+		.mode		= 0644,
+		.proc_handler	= proc_douintvec_minmax,
+		.extra1		= SYSCTL_ZERO,
+		.extra2		= (unsigned int *)&core_compress_level_max,
+	},
+#endif
 };
 
 static int __init init_fs_coredump_sysctls(void)
@@ -74,6 +74,20 @@ int z_erofs_stream_switch_bufs(struct z_erofs_stream_dctx *dctx, void **dst,
 			       void **src, struct page **pgpl);
 int z_erofs_fixup_insize(struct z_erofs_decompress_req *rq, const char *padbuf,
 			 unsigned int padbufsize);
+#ifdef CONFIG_EROFS_FS_ZIP_ACCEL
+int z_erofs_crypto_init(struct super_block *sb);
+void z_erofs_crypto_exit(void);
+int z_erofs_crypto_decompress(struct z_erofs_decompress_req *rq,
+			      struct page **pgpl);
+#else
+static inline int z_erofs_crypto_init(struct super_block *sb) { return 0; }
+static inline void z_erofs_crypto_exit(void) {}
+static inline int z_erofs_crypto_decompress(struct z_erofs_decompress_req *rq,
+					    struct page **pgpl)
+{
+	return -EOPNOTSUPP;
+}
+#endif
 int __init z_erofs_init_decompressor(void);
 void z_erofs_exit_decompressor(void);
 #endif
@@ -548,4 +548,5 @@ void z_erofs_exit_decompressor(void)
 	for (i = 0; i < Z_EROFS_COMPRESSION_MAX; ++i)
 		if (z_erofs_decomp[i])
 			z_erofs_decomp[i]->exit();
+	z_erofs_crypto_exit();
 }
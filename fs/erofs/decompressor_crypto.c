@@ -0,0 +1,132 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#include <linux/ratelimit.h>
+#include <linux/scatterlist.h>
+#include <crypto/acompress.h>
+#include "compress.h"
+
+static char *z_erofs_deflate_accel;
+module_param_named(deflate_accel, z_erofs_deflate_accel, charp, 0444);
+
+static DEFINE_MUTEX(z_erofs_crypto_mutex);
+static struct crypto_acomp *z_erofs_deflate_tfm;
+static DEFINE_RATELIMIT_STATE(z_erofs_crypto_rs, DEFAULT_RATELIMIT_INTERVAL,
+			      DEFAULT_RATELIMIT_BURST);
+
+int z_erofs_crypto_init(struct super_block *sb)
+{
+	struct crypto_acomp *tfm;
+
+	if (!z_erofs_deflate_accel || !*z_erofs_deflate_accel ||
+	    READ_ONCE(z_erofs_deflate_tfm))
+		return 0;
+
+	mutex_lock(&z_erofs_crypto_mutex);
+	if (!z_erofs_deflate_tfm) {
+		tfm = crypto_alloc_acomp(z_erofs_deflate_accel, 0, 0);
+		if (IS_ERR(tfm)) {
+			erofs_info(sb, "failed to load %s, decompressing DEFLATE on CPU: %ld",
+				   z_erofs_deflate_accel, PTR_ERR(tfm));
+		} else {
+			erofs_info(sb, "offloading DEFLATE decompression to %s",
+				   crypto_acomp_driver_name(tfm));
+			WRITE_ONCE(z_erofs_deflate_tfm, tfm);
+		}
+	}
+	mutex_unlock(&z_erofs_crypto_mutex);
+	return 0;
+}
+
+void z_erofs_crypto_exit(void)
+{
+	/* there should be no running fs instance */
+	if (z_erofs_deflate_tfm) {
+		crypto_free_acomp(z_erofs_deflate_tfm);
+		z_erofs_deflate_tfm = NULL;
+	}
+}
+
+static int __z_erofs_crypto_decompress(struct z_erofs_decompress_req *rq,
+				       struct crypto_acomp *tfm,
+				       struct page **pgpl)
+{
+	unsigned int inpages = PAGE_ALIGN(rq->pageofs_in + rq->inputsize) >>
+				PAGE_SHIFT;
+	unsigned int outpages = PAGE_ALIGN(rq->pageofs_out + rq->outputsize) >>
+				PAGE_SHIFT;
+	struct sg_table st_src, st_dst;
+	struct acomp_req *req;
+	DECLARE_CRYPTO_WAIT(wait);
+	unsigned int i;
+	int err;
+
+	/* the accelerator needs every output page, including deduped ones */
+	for (i = 0; i < outpages; ++i) {
+		if (rq->out[i])
+			continue;
+		rq->out[i] = erofs_allocpage(pgpl, rq->gfp);
+		if (!rq->out[i])
+			return -ENOMEM;
+		set_page_private(rq->out[i], Z_EROFS_SHORTLIVED_PAGE);
+	}
+	rq->fillgaps = true;
+
+	req = acomp_request_alloc(tfm);
+	if (!req)
+		return -ENOMEM;
+
+	err = sg_alloc_table_from_pages_segment(&st_src, rq->in, inpages,
+			rq->pageofs_in, rq->inputsize, UINT_MAX, rq->gfp);
+	if (err)
+		goto out_req;
+	err = sg_alloc_table_from_pages_segment(&st_dst, rq->out, outpages,
+			rq->pageofs_out, rq->outputsize, UINT_MAX, rq->gfp);
+	if (err)
+		goto out_src;
+
+	acomp_request_set_params(req, st_src.sgl, st_dst.sgl,
+				 rq->inputsize, rq->outputsize);
+	acomp_request_set_callback(req, CRYPTO_TFM_REQ_MAY_BACKLOG,
+				   crypto_req_done, &wait);
+	err = crypto_wait_req(crypto_acomp_decompress(req), &wait);
+	if (!err && req->dlen != rq->outputsize)
+		err = -EIO;
+
+	sg_free_table(&st_dst);
+out_src:
+	sg_free_table(&st_src);
+out_req:
+	acomp_request_free(req);
+	return err;
+}
+
+/*
+ * Try to decompress a DEFLATE pcluster with the configured accelerator.
+ * Returns 0 if it did; otherwise the caller decompresses it on the CPU,
+ * which rewrites all output pages.
+ */
+int z_erofs_crypto_decompress(struct z_erofs_decompress_req *rq,
+			      struct page **pgpl)
+{
+	struct crypto_acomp *tfm = READ_ONCE(z_erofs_deflate_tfm);
+	struct erofs_sb_info *sbi = EROFS_SB(rq->sb);
+	int err;
+
+	/* in-place and partial decoding are left to the CPU decompressor */
+	if (!tfm || rq->inplace_io || rq->partial_decoding) {
+		atomic_long_inc(&sbi->cpu_decompressed);
+		return -EOPNOTSUPP;
+	}
+
+	err = __z_erofs_crypto_decompress(rq, tfm, pgpl);
+	if (!err) {
+		atomic_long_inc(&sbi->accel_decompressed);
+		return 0;
+	}
+	if (__ratelimit(&z_erofs_crypto_rs))
+		erofs_info(rq->sb, "%s failed to decompress in[%u] out[%u]: %d, fall back to CPU",
+			   crypto_acomp_driver_name(tfm), rq->inputsize,
+			   rq->outputsize, err);
+	atomic_long_inc(&sbi->accel_fallbacks);
+	atomic_long_inc(&sbi->cpu_decompressed);
+	return err;
+}
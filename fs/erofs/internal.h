@@ -124,6 +124,10 @@ struct erofs_sb_info {
 	struct inode *managed_cache;
 
 	struct erofs_sb_lz4_info lz4;
+#ifdef CONFIG_EROFS_FS_ZIP_ACCEL
+	/* DEFLATE pclusters decompressed by the accelerator or on CPU */
+	atomic_long_t accel_decompressed, accel_fallbacks, cpu_decompressed;
+#endif
 #endif	/* CONFIG_EROFS_FS_ZIP */
 	struct inode *packed_inode;
 	struct erofs_dev_context *devs;
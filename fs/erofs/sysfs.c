@@ -13,6 +13,7 @@ enum {
 	attr_drop_caches,
 	attr_pointer_ui,
 	attr_pointer_bool,
+	attr_pointer_atomic_long,
 };
 
 enum {
@@ -60,11 +61,21 @@ static struct erofs_attr erofs_attr_##_name = {			\
 EROFS_ATTR_RW_UI(sync_decompress, erofs_mount_opts);
 EROFS_ATTR_FUNC(drop_caches, 0200);
 #endif
+#ifdef CONFIG_EROFS_FS_ZIP_ACCEL
+EROFS_RO_ATTR(accel_decompressed, pointer_atomic_long, erofs_sb_info);
+EROFS_RO_ATTR(accel_fallbacks, pointer_atomic_long, erofs_sb_info);
+EROFS_RO_ATTR(cpu_decompressed, pointer_atomic_long, erofs_sb_info);
+#endif
 
 static struct attribute *erofs_attrs[] = {
 #ifdef CONFIG_EROFS_FS_ZIP
 	ATTR_LIST(sync_decompress),
 	ATTR_LIST(drop_caches),
+#endif
+#ifdef CONFIG_EROFS_FS_ZIP_ACCEL
+	ATTR_LIST(accel_decompressed),
+	ATTR_LIST(accel_fallbacks),
+	ATTR_LIST(cpu_decompressed),
 #endif
 	NULL,
 };
@@ -126,6 +137,11 @@ static ssize_t erofs_attr_show(struct kobject *kobj,
 		if (!ptr)
 			return 0;
 		return sysfs_emit(buf, "%d\n", *(bool *)ptr);
+	case attr_pointer_atomic_long:
+		if (!ptr)
+			return 0;
+		return sysfs_emit(buf, "%ld\n",
+				  atomic_long_read((atomic_long_t *)ptr));
 	}
 	return 0;
 }
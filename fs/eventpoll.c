@@ -2445,6 +2445,47 @@ SYSCALL_DEFINE4(epoll_ctl, int, epfd, int, op, int, fd,
 	return do_epoll_ctl(epfd, op, fd, &epds, false);
 }
 
+/**
+ * epoll_sendevents - harvest ready events without blocking
+ *
+ * @file: the eventpoll file
+ * @events: pointer to the userspace buffer where the ready events should be
+ *          stored
+ * @maxevents: size (in terms of number of events) of the provided buffer
+ *
+ * Used by io_uring, which drives readiness off the eventpoll file's own
+ * ->poll() and only needs the ready list transferred once it has fired.
+ *
+ * Return: the number of ready events which have been fetched, 0 if none
+ *          were available, or an error code.
+ */
+int epoll_sendevents(struct file *file, struct epoll_event __user *events,
+		     int maxevents)
+{
+	struct eventpoll *ep;
+	int res;
+
+	if (maxevents <= 0 || maxevents > EP_MAX_EVENTS)
+		return -EINVAL;
+	if (!access_ok(events, maxevents * sizeof(struct epoll_event)))
+		return -EFAULT;
+	if (!is_file_epoll(file))
+		return -EINVAL;
+
+	ep = file->private_data;
+	/*
+	 * Racy check, same as in ep_poll(). A miss is fine, the caller will
+	 * retry once the eventpoll file signals readiness again.
+	 */
+	if (!ep_events_available(ep))
+		return 0;
+
+	res = ep_send_events(ep, events, maxevents);
+	if (res > 0)
+		ep_suspend_napi_irqs(ep);
+	return res;
+}
+
 /*
  * Implement the event wait interface for the eventpoll file. It is the kernel
  * part of the user space epoll_wait(2).
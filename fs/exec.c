@@ -2051,6 +2051,32 @@ static int do_execveat(int fd, struct filename *filename,
 	return do_execveat_common(fd, filename, argv, envp, flags);
 }
 
+/*
+ * Execute the program of a clone3(CLONE_SPAWN) child. The child still shares
+ * the mm of its parent, so it reads the arguments straight from there.
+ */
+int spawn_execve(const char __user *filename, const void __user *argv,
+		 const void __user *envp, bool compat)
+{
+	struct user_arg_ptr uargv = { .ptr.native = argv };
+	struct user_arg_ptr uenvp = { .ptr.native = envp };
+
+#ifdef CONFIG_COMPAT
+	if (compat) {
+		uargv = (struct user_arg_ptr) {
+			.is_compat = true,
+			.ptr.compat = argv,
+		};
+		uenvp = (struct user_arg_ptr) {
+			.is_compat = true,
+			.ptr.compat = envp,
+		};
+	}
+#endif
+
+	return do_execveat_common(AT_FDCWD, getname(filename), uargv, uenvp, 0);
+}
+
 #ifdef CONFIG_COMPAT
 static int compat_do_execve(struct filename *filename,
 	const compat_uptr_t __user *__argv,
@@ -410,6 +410,15 @@ static inline int ext4_journal_blocks_per_page(struct inode *inode)
 	return 0;
 }
 
+/* Like ext4_journal_blocks_per_page(), for the largest folio of @inode */
+static inline int ext4_journal_blocks_per_folio(struct inode *inode)
+{
+	if (EXT4_JOURNAL(inode) != NULL)
+		return ext4_journal_blocks_per_page(inode) <<
+			mapping_max_folio_order(inode->i_mapping);
+	return 0;
+}
+
 static inline int ext4_journal_force_commit(journal_t *journal)
 {
 	if (journal)
@@ -1265,6 +1265,7 @@ struct inode *__ext4_new_inode(struct mnt_idmap *idmap,
 	ei->i_last_alloc_group = ~0;
 
 	ext4_set_inode_flags(inode, true);
+	ext4_set_inode_mapping_order(inode);
 	if (IS_DIRSYNC(inode))
 		ext4_handle_sync(handle);
 	if (insert_inode_locked(inode) < 0) {
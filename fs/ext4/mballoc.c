@@ -15,6 +15,7 @@
 #include <linux/module.h>
 #include <linux/slab.h>
 #include <linux/nospec.h>
+#include <linux/hash.h>
 #include <linux/backing-dev.h>
 #include <linux/freezer.h>
 #include <trace/events/ext4.h>
@@ -867,6 +868,25 @@ mb_update_avg_fragment_size(struct super_block *sb, struct ext4_group_info *grp)
 					grp->bb_avg_fragment_size_order]);
 }
 
+/*
+ * Lock-free check for a group that another allocator is working on. Below
+ * CR_ANY_FREE, such groups are skipped instead of serialising on their lock:
+ * there usually is another good enough group further down the list.
+ */
+static inline bool ext4_mb_group_busy(struct ext4_allocation_context *ac,
+				      ext4_group_t group, enum criteria cr)
+{
+	struct ext4_sb_info *sbi = EXT4_SB(ac->ac_sb);
+
+	if (cr >= CR_ANY_FREE ||
+	    !spin_is_locked(ext4_group_lock_ptr(ac->ac_sb, group)))
+		return false;
+
+	if (sbi->s_mb_stats)
+		atomic64_inc(&sbi->s_bal_busy_skipped);
+	return true;
+}
+
 /*
  * Choose next group by traversing largest_free_order lists. Updates *new_cr if
  * cr level needs an update.
@@ -896,6 +916,8 @@ static void ext4_mb_choose_next_group_p2_aligned(struct ext4_allocation_context
 				    bb_largest_free_order_node) {
 			if (sbi->s_mb_stats)
 				atomic64_inc(&sbi->s_bal_cX_groups_considered[CR_POWER2_ALIGNED]);
+			if (ext4_mb_group_busy(ac, iter->bb_group, CR_POWER2_ALIGNED))
+				continue;
 			if (likely(ext4_mb_good_group(ac, iter->bb_group, CR_POWER2_ALIGNED))) {
 				*group = iter->bb_group;
 				ac->ac_flags |= EXT4_MB_CR_POWER2_ALIGNED_OPTIMIZED;
@@ -932,6 +954,8 @@ ext4_mb_find_good_group_avg_frag_lists(struct ext4_allocation_context *ac, int o
 	list_for_each_entry(iter, frag_list, bb_avg_fragment_size_node) {
 		if (sbi->s_mb_stats)
 			atomic64_inc(&sbi->s_bal_cX_groups_considered[cr]);
+		if (ext4_mb_group_busy(ac, iter->bb_group, cr))
+			continue;
 		if (likely(ext4_mb_good_group(ac, iter->bb_group, cr))) {
 			grp = iter;
 			break;
@@ -2133,6 +2157,13 @@ static int mb_mark_used(struct ext4_buddy *e4b, struct ext4_free_extent *ex)
 /*
  * Must be called under group lock!
  */
+/* Stream allocation goal slot of the file being allocated for */
+static inline unsigned int ext4_mb_goal_idx(struct ext4_allocation_context *ac)
+{
+	return hash_long(ac->ac_inode->i_ino, 32) %
+		EXT4_SB(ac->ac_sb)->s_mb_nr_global_goals;
+}
+
 static void ext4_mb_use_best_found(struct ext4_allocation_context *ac,
 					struct ext4_buddy *e4b)
 {
@@ -2166,12 +2197,9 @@ static void ext4_mb_use_best_found(struct ext4_allocation_context *ac,
 	ac->ac_buddy_folio = e4b->bd_buddy_folio;
 	folio_get(ac->ac_buddy_folio);
 	/* store last allocated for subsequent stream allocation */
-	if (ac->ac_flags & EXT4_MB_STREAM_ALLOC) {
-		spin_lock(&sbi->s_md_lock);
-		sbi->s_mb_last_group = ac->ac_f_ex.fe_group;
-		sbi->s_mb_last_start = ac->ac_f_ex.fe_start;
-		spin_unlock(&sbi->s_md_lock);
-	}
+	if (ac->ac_flags & EXT4_MB_STREAM_ALLOC)
+		WRITE_ONCE(sbi->s_mb_last_groups[ext4_mb_goal_idx(ac)],
+			   ac->ac_f_ex.fe_group);
 	/*
 	 * As we've just preallocated more space than
 	 * user requested originally, we store allocated
@@ -2843,13 +2871,9 @@ ext4_mb_regular_allocator(struct ext4_allocation_context *ac)
 	}
 
 	/* if stream allocation is enabled, use global goal */
-	if (ac->ac_flags & EXT4_MB_STREAM_ALLOC) {
-		/* TBD: may be hot point */
-		spin_lock(&sbi->s_md_lock);
-		ac->ac_g_ex.fe_group = sbi->s_mb_last_group;
-		ac->ac_g_ex.fe_start = sbi->s_mb_last_start;
-		spin_unlock(&sbi->s_md_lock);
-	}
+	if (ac->ac_flags & EXT4_MB_STREAM_ALLOC)
+		ac->ac_g_ex.fe_group =
+			READ_ONCE(sbi->s_mb_last_groups[ext4_mb_goal_idx(ac)]);
 
 	/*
 	 * Let's just scan groups to find more-less suitable blocks We
@@ -2899,6 +2923,9 @@ ext4_mb_regular_allocator(struct ext4_allocation_context *ac)
 							nr, &prefetch_ios);
 			}
 
+			if (ext4_mb_group_busy(ac, group, cr))
+				continue;
+
 			/* This now checks without needing the buddy page */
 			ret = ext4_mb_good_group_nolock(ac, group, cr);
 			if (ret <= 0) {
@@ -2911,7 +2938,18 @@ ext4_mb_regular_allocator(struct ext4_allocation_context *ac)
 			if (err)
 				goto out;
 
-			ext4_lock_group(sb, group);
+			if (!ext4_try_lock_group(sb, group)) {
+				/* Someone else got there first, move on */
+				if (cr < CR_ANY_FREE) {
+					if (sbi->s_mb_stats)
+						atomic64_inc(&sbi->s_bal_busy_skipped);
+					ext4_mb_unload_buddy(&e4b);
+					continue;
+				}
+				if (sbi->s_mb_stats)
+					atomic64_inc(&sbi->s_bal_lock_waits);
+				ext4_lock_group(sb, group);
+			}
 
 			/*
 			 * We need to check again after locking the
@@ -3188,6 +3226,10 @@ int ext4_seq_mb_stats_show(struct seq_file *seq, void *offset)
 	seq_printf(seq, "\t\t2^n_hits: %u\n", atomic_read(&sbi->s_bal_2orders));
 	seq_printf(seq, "\t\tbreaks: %u\n", atomic_read(&sbi->s_bal_breaks));
 	seq_printf(seq, "\t\tlost: %u\n", atomic_read(&sbi->s_mb_lost_chunks));
+	seq_printf(seq, "\t\tbusy_skipped: %llu\n",
+		   atomic64_read(&sbi->s_bal_busy_skipped));
+	seq_printf(seq, "\t\tlock_waits: %llu\n",
+		   atomic64_read(&sbi->s_bal_lock_waits));
 	seq_printf(seq, "\tbuddies_generated: %u/%u\n",
 		   atomic_read(&sbi->s_mb_buddies_generated),
 		   ext4_get_groups_count(sb));
@@ -3711,10 +3753,23 @@ int ext4_mb_init(struct super_block *sb)
 			sbi->s_mb_group_prealloc, EXT4_NUM_B2C(sbi, sbi->s_stripe));
 	}
 
+	/*
+	 * Spread stream allocations of different files over several goals,
+	 * so that parallel writers do not all start scanning at one group.
+	 */
+	sbi->s_mb_nr_global_goals = umin(num_possible_cpus(),
+					 DIV_ROUND_UP(sbi->s_groups_count, 4));
+	sbi->s_mb_last_groups = kcalloc(sbi->s_mb_nr_global_goals,
+					sizeof(ext4_group_t), GFP_KERNEL);
+	if (sbi->s_mb_last_groups == NULL) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
 	sbi->s_locality_groups = alloc_percpu(struct ext4_locality_group);
 	if (sbi->s_locality_groups == NULL) {
 		ret = -ENOMEM;
-		goto out;
+		goto out_free_last_groups;
 	}
 	for_each_possible_cpu(i) {
 		struct ext4_locality_group *lg;
@@ -3739,6 +3794,9 @@ int ext4_mb_init(struct super_block *sb)
 out_free_locality_groups:
 	free_percpu(sbi->s_locality_groups);
 	sbi->s_locality_groups = NULL;
+out_free_last_groups:
+	kfree(sbi->s_mb_last_groups);
+	sbi->s_mb_last_groups = NULL;
 out:
 	kfree(sbi->s_mb_avg_fragment_size);
 	kfree(sbi->s_mb_avg_fragment_size_locks);
@@ -3816,6 +3874,7 @@ void ext4_mb_release(struct super_block *sb)
 	kfree(sbi->s_mb_largest_free_orders_locks);
 	kfree(sbi->s_mb_offsets);
 	kfree(sbi->s_mb_maxs);
+	kfree(sbi->s_mb_last_groups);
 	iput(sbi->s_buddy_cache);
 	if (sbi->s_mb_stats) {
 		ext4_msg(sb, KERN_INFO,
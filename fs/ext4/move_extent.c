@@ -107,6 +107,39 @@ mext_check_coverage(struct inode *inode, ext4_lblk_t from, ext4_lblk_t count,
 	return ret;
 }
 
+/*
+ * Extents are moved one page at a time, so split a large folio covering
+ * @index first. ext4_move_extents() wrote back the files, a folio that got
+ * dirty again since then cannot be split and makes us give up.
+ */
+static struct folio *mext_get_small_folio(struct address_space *mapping,
+					  pgoff_t index)
+{
+	struct folio *folio;
+	int err;
+
+	folio = __filemap_get_folio(mapping, index, FGP_WRITEBEGIN,
+				    mapping_gfp_mask(mapping));
+	if (IS_ERR(folio) || !folio_test_large(folio))
+		return folio;
+
+	folio_wait_writeback(folio);
+	err = folio_test_dirty(folio) ? -EBUSY : split_folio(folio);
+	folio_unlock(folio);
+	folio_put(folio);
+	if (err)
+		return ERR_PTR(err);
+
+	folio = __filemap_get_folio(mapping, index, FGP_WRITEBEGIN,
+				    mapping_gfp_mask(mapping));
+	if (!IS_ERR(folio) && folio_test_large(folio)) {
+		folio_unlock(folio);
+		folio_put(folio);
+		return ERR_PTR(-EBUSY);
+	}
+	return folio;
+}
+
 /**
  * mext_folio_double_lock - Grab and lock folio on both @inode1 and @inode2
  *
@@ -136,15 +169,13 @@ mext_folio_double_lock(struct inode *inode1, struct inode *inode2,
 	}
 
 	flags = memalloc_nofs_save();
-	folio[0] = __filemap_get_folio(mapping[0], index1, FGP_WRITEBEGIN,
-			mapping_gfp_mask(mapping[0]));
+	folio[0] = mext_get_small_folio(mapping[0], index1);
 	if (IS_ERR(folio[0])) {
 		memalloc_nofs_restore(flags);
 		return PTR_ERR(folio[0]);
 	}
 
-	folio[1] = __filemap_get_folio(mapping[1], index2, FGP_WRITEBEGIN,
-			mapping_gfp_mask(mapping[1]));
+	folio[1] = mext_get_small_folio(mapping[1], index2);
 	memalloc_nofs_restore(flags);
 	if (IS_ERR(folio[1])) {
 		folio_unlock(folio[0]);
@@ -617,6 +648,18 @@ ext4_move_extents(struct file *o_filp, struct file *d_filp, __u64 orig_blk,
 	inode_dio_wait(orig_inode);
 	inode_dio_wait(donor_inode);
 
+	/* Large folios have to be clean to be split, see mext_get_small_folio() */
+	if (mapping_large_folio_support(orig_inode->i_mapping) ||
+	    mapping_large_folio_support(donor_inode->i_mapping)) {
+		ret = filemap_write_and_wait(orig_inode->i_mapping);
+		if (!ret)
+			ret = filemap_write_and_wait(donor_inode->i_mapping);
+		if (ret) {
+			unlock_two_nondirectories(orig_inode, donor_inode);
+			return ret;
+		}
+	}
+
 	/* Protect extent tree against block allocations via delalloc */
 	ext4_double_down_write_data_sem(orig_inode, donor_inode);
 	/* Check the filesystem environment whether move_extent can be done */
@@ -595,6 +595,15 @@ static int ext4_journal_submit_inode_data_buffers(struct jbd2_inode *jinode)
 	return ret;
 }
 
+static int ext4_journal_submit_running_inode_data_buffers(
+						struct jbd2_inode *jinode)
+{
+	/* Journalled data is only written out by the commit itself */
+	if (ext4_should_journal_data(jinode->i_vfs_inode))
+		return 0;
+	return ext4_running_submit_inode_data_buffers(jinode);
+}
+
 static int ext4_journal_finish_inode_data_buffers(struct jbd2_inode *jinode)
 {
 	int ret = 0;
@@ -4969,6 +4978,8 @@ static int ext4_load_and_init_journal(struct super_block *sb,
 		ext4_journal_submit_inode_data_buffers;
 	sbi->s_journal->j_finish_inode_data_buffers =
 		ext4_journal_finish_inode_data_buffers;
+	sbi->s_journal->j_submit_running_inode_data_buffers =
+		ext4_journal_submit_running_inode_data_buffers;
 
 	return 0;
 
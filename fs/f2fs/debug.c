@@ -647,6 +647,17 @@ static int stat_show(struct seq_file *s, void *v)
 				si->bg_node_blks);
 		seq_printf(s, "BG skip : IO: %u, Other: %u\n",
 				si->io_skip_bggc, si->other_skip_bggc);
+		if (sbi->gc_thread) {
+			struct f2fs_gc_kthread *gc_th = sbi->gc_thread;
+
+			seq_printf(s, "GC thread : rounds: %u, reclaimed secs: %u\n",
+				gc_th->bggc_rounds, gc_th->bggc_reclaimed_secs);
+			seq_printf(s, "  - latency : avg %llu us, max %u us\n",
+				gc_th->bggc_rounds ?
+				div_u64(gc_th->bggc_total_time,
+					gc_th->bggc_rounds) : 0,
+				gc_th->bggc_max_time);
+		}
 		seq_puts(s, "\nExtent Cache (Read):\n");
 		seq_printf(s, "  - Hit Count: L1-1:%llu L1-2:%llu L2:%llu\n",
 				si->hit_largest, si->hit_cached[EX_READ],
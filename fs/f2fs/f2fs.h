@@ -1304,6 +1304,7 @@ struct f2fs_gc_control {
 	bool err_gc_skipped;		/* return EAGAIN if GC skipped */
 	bool one_time;			/* require one time GC in one migration unit */
 	unsigned int nr_free_secs;	/* # of free sections to do GC */
+	unsigned int nr_freed_secs;	/* # of sections freed by GC */
 };
 
 /*
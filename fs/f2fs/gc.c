@@ -45,6 +45,7 @@ static int gc_thread_func(void *data)
 	set_freezable();
 	do {
 		bool sync_mode, foreground = false;
+		u64 start_time, elapsed;
 
 		wait_event_freezable_timeout(*wq,
 				kthread_should_stop() ||
@@ -151,6 +152,8 @@ static int gc_thread_func(void *data)
 		gc_control.no_bg_gc = foreground;
 		gc_control.nr_free_secs = foreground ? 1 : 0;
 
+		start_time = ktime_get_ns();
+
 		/* if return value is not zero, no victim was selected */
 		if (f2fs_gc(sbi, &gc_control)) {
 			/* don't bother wait_ms by foreground gc */
@@ -162,6 +165,13 @@ static int gc_thread_func(void *data)
 				wait_ms = gc_th->min_sleep_time;
 		}
 
+		elapsed = div_u64(ktime_get_ns() - start_time, NSEC_PER_USEC);
+		gc_th->bggc_rounds++;
+		gc_th->bggc_reclaimed_secs += gc_control.nr_freed_secs;
+		gc_th->bggc_total_time += elapsed;
+		if (elapsed > gc_th->bggc_max_time)
+			gc_th->bggc_max_time = elapsed;
+
 		if (foreground)
 			wake_up_all(&gc_th->fggc_wq);
 
@@ -212,6 +222,12 @@ int f2fs_start_gc_thread(struct f2fs_sb_info *sbi)
 		gc_th->boost_zoned_gc_percent = 0;
 	}
 
+	gc_th->boost_gc_multiple = BOOST_GC_MULTIPLE;
+	gc_th->bggc_rounds = 0;
+	gc_th->bggc_reclaimed_secs = 0;
+	gc_th->bggc_total_time = 0;
+	gc_th->bggc_max_time = 0;
+
 	gc_th->gc_wake = false;
 
 	sbi->gc_thread = gc_th;
@@ -1751,7 +1767,7 @@ static int do_garbage_collect(struct f2fs_sb_info *sbi,
 					!has_enough_free_blocks(sbi,
 					sbi->gc_thread->boost_zoned_gc_percent))
 				window_granularity *=
-					BOOST_GC_MULTIPLE;
+					sbi->gc_thread->boost_gc_multiple;
 
 			end_segno = start_segno + window_granularity;
 		}
@@ -2003,6 +2019,8 @@ int f2fs_gc(struct f2fs_sb_info *sbi, struct f2fs_gc_control *gc_control)
 
 	put_gc_inode(&gc_list);
 
+	gc_control->nr_freed_secs = total_sec_freed;
+
 	if (gc_control->err_gc_skipped && !ret)
 		ret = total_sec_freed ? 0 : -EAGAIN;
 	return ret;
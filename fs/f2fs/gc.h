@@ -34,7 +34,7 @@
 #define LIMIT_NO_ZONED_GC	60 /* percentage over total user space of no gc for zoned devices */
 #define LIMIT_BOOST_ZONED_GC	25 /* percentage over total user space of boosted gc for zoned devices */
 #define DEF_MIGRATION_WINDOW_GRANULARITY_ZONED	3
-#define BOOST_GC_MULTIPLE	5
+#define BOOST_GC_MULTIPLE	5 /* default multiple of migration window in boosted gc */
 #define ZONED_PIN_SEC_REQUIRED_COUNT	1
 
 #define DEF_GC_FAILED_PINNED_FILES	2048
@@ -68,6 +68,13 @@ struct f2fs_gc_kthread {
 	unsigned int no_zoned_gc_percent;
 	unsigned int boost_zoned_gc_percent;
 	unsigned int valid_thresh_ratio;
+	unsigned int boost_gc_multiple;
+
+	/* background gc statistics */
+	unsigned int bggc_rounds;		/* # of f2fs_gc() calls */
+	unsigned int bggc_reclaimed_secs;	/* # of sections freed */
+	unsigned long long bggc_total_time;	/* time in f2fs_gc(), in us */
+	unsigned int bggc_max_time;		/* longest f2fs_gc(), in us */
 };
 
 struct gc_inode_list {
@@ -109,6 +109,8 @@ static void free_fdtable_rcu(struct rcu_head *rcu)
 
 #define BITBIT_NR(nr)	BITS_TO_LONGS(BITS_TO_LONGS(nr))
 #define BITBIT_SIZE(nr)	(BITBIT_NR(nr) * sizeof(long))
+#define BITBITBIT_NR(nr)	BITS_TO_LONGS(BITBIT_NR(nr))
+#define BITBITBIT_SIZE(nr)	(BITBITBIT_NR(nr) * sizeof(long))
 
 #define fdt_words(fdt) ((fdt)->max_fds / BITS_PER_LONG) // words in ->open_fds
 /*
@@ -127,6 +129,10 @@ static inline void copy_fd_bitmaps(struct fdtable *nfdt, struct fdtable *ofdt,
 			copy_words * BITS_PER_LONG, nwords * BITS_PER_LONG);
 	bitmap_copy_and_extend(nfdt->full_fds_bits, ofdt->full_fds_bits,
 			copy_words, nwords);
+	/* a partially copied word of full_fds_bits is never full */
+	bitmap_copy_and_extend(nfdt->full_fds_bitbits, ofdt->full_fds_bitbits,
+			copy_words / BITS_PER_LONG,
+			BITS_TO_LONGS(nwords));
 }
 
 /*
@@ -202,7 +208,8 @@ static struct fdtable *alloc_fdtable(unsigned int slots_wanted)
 	fdt->fd = data;
 
 	data = kvmalloc(max_t(size_t,
-				 2 * nr / BITS_PER_BYTE + BITBIT_SIZE(nr), L1_CACHE_BYTES),
+				 2 * nr / BITS_PER_BYTE + BITBIT_SIZE(nr) +
+				 BITBITBIT_SIZE(nr), L1_CACHE_BYTES),
 				 GFP_KERNEL_ACCOUNT);
 	if (!data)
 		goto out_arr;
@@ -211,6 +218,8 @@ static struct fdtable *alloc_fdtable(unsigned int slots_wanted)
 	fdt->close_on_exec = data;
 	data += nr / BITS_PER_BYTE;
 	fdt->full_fds_bits = data;
+	data += BITBIT_SIZE(nr);
+	fdt->full_fds_bitbits = data;
 
 	return fdt;
 
@@ -315,16 +324,24 @@ static inline void __set_open_fd(unsigned int fd, struct fdtable *fdt, bool set)
 	__set_bit(fd, fdt->open_fds);
 	__set_close_on_exec(fd, fdt, set);
 	fd /= BITS_PER_LONG;
-	if (!~fdt->open_fds[fd])
+	if (!~fdt->open_fds[fd]) {
 		__set_bit(fd, fdt->full_fds_bits);
+		fd /= BITS_PER_LONG;
+		if (!~fdt->full_fds_bits[fd])
+			__set_bit(fd, fdt->full_fds_bitbits);
+	}
 }
 
 static inline void __clear_open_fd(unsigned int fd, struct fdtable *fdt)
 {
 	__clear_bit(fd, fdt->open_fds);
 	fd /= BITS_PER_LONG;
-	if (test_bit(fd, fdt->full_fds_bits))
+	if (test_bit(fd, fdt->full_fds_bits)) {
 		__clear_bit(fd, fdt->full_fds_bits);
+		fd /= BITS_PER_LONG;
+		if (test_bit(fd, fdt->full_fds_bitbits))
+			__clear_bit(fd, fdt->full_fds_bitbits);
+	}
 }
 
 static inline bool fd_is_open(unsigned int fd, const struct fdtable *fdt)
@@ -382,6 +399,7 @@ struct files_struct *dup_fd(struct files_struct *oldf, struct fd_range *punch_ho
 	new_fdt->close_on_exec = newf->close_on_exec_init;
 	new_fdt->open_fds = newf->open_fds_init;
 	new_fdt->full_fds_bits = newf->full_fds_bits_init;
+	new_fdt->full_fds_bitbits = newf->full_fds_bitbits_init;
 	new_fdt->fd = &newf->fd_array[0];
 
 	spin_lock(&oldf->file_lock);
@@ -508,6 +526,7 @@ struct files_struct init_files = {
 		.close_on_exec	= init_files.close_on_exec_init,
 		.open_fds	= init_files.open_fds_init,
 		.full_fds_bits	= init_files.full_fds_bits_init,
+		.full_fds_bitbits = init_files.full_fds_bitbits_init,
 	},
 	.file_lock	= __SPIN_LOCK_UNLOCKED(init_files.file_lock),
 	.resize_wait	= __WAIT_QUEUE_HEAD_INITIALIZER(init_files.resize_wait),
@@ -518,7 +537,8 @@ static unsigned int find_next_fd(struct fdtable *fdt, unsigned int start)
 	unsigned int maxfd = fdt->max_fds; /* always multiple of BITS_PER_LONG */
 	unsigned int maxbit = maxfd / BITS_PER_LONG;
 	unsigned int bitbit = start / BITS_PER_LONG;
-	unsigned int bit;
+	unsigned int word = bitbit / BITS_PER_LONG;
+	unsigned int bit, nbits;
 
 	/*
 	 * Try to avoid looking at the second level bitmap
@@ -528,7 +548,25 @@ static unsigned int find_next_fd(struct fdtable *fdt, unsigned int start)
 	if (bit < BITS_PER_LONG)
 		return bit + bitbit * BITS_PER_LONG;
 
-	bitbit = find_next_zero_bit(fdt->full_fds_bits, maxbit, bitbit) * BITS_PER_LONG;
+	/*
+	 * Then at the rest of its word, and only use the third level bitmap
+	 * to skip over runs of full words with huge tables.
+	 */
+	nbits = min_t(unsigned int, maxbit - word * BITS_PER_LONG,
+		      BITS_PER_LONG);
+	bit = find_next_zero_bit(&fdt->full_fds_bits[word], nbits,
+				 bitbit & (BITS_PER_LONG - 1));
+	if (bit < nbits) {
+		bitbit = word * BITS_PER_LONG + bit;
+	} else {
+		word = find_next_zero_bit(fdt->full_fds_bitbits,
+					  BITS_TO_LONGS(maxbit), word + 1);
+		if (word * BITS_PER_LONG >= maxbit)
+			return maxfd;
+		bitbit = find_next_zero_bit(fdt->full_fds_bits, maxbit,
+					    word * BITS_PER_LONG);
+	}
+	bitbit *= BITS_PER_LONG;
 	if (bitbit >= maxfd)
 		return maxfd;
 	if (bitbit > start)
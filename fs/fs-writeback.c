@@ -2213,19 +2213,72 @@ static struct wb_writeback_work *get_next_work_item(struct bdi_writeback *wb)
 	return work;
 }
 
-static long wb_check_background_flush(struct bdi_writeback *wb)
+static long wb_background_writeback(struct bdi_writeback *wb)
 {
-	if (wb_over_bg_thresh(wb)) {
+	struct wb_writeback_work work = {
+		.nr_pages	= LONG_MAX,
+		.sync_mode	= WB_SYNC_NONE,
+		.for_background	= 1,
+		.range_cyclic	= 1,
+		.reason		= WB_REASON_BACKGROUND,
+	};
 
-		struct wb_writeback_work work = {
-			.nr_pages	= LONG_MAX,
-			.sync_mode	= WB_SYNC_NONE,
-			.for_background	= 1,
-			.range_cyclic	= 1,
-			.reason		= WB_REASON_BACKGROUND,
-		};
+	return wb_writeback(wb, &work);
+}
 
-		return wb_writeback(wb, &work);
+/*
+ * Background writeback helpers for bdis with ->wb_threads > 1.  They run
+ * wb_writeback() on the same wb as its flusher: writeback_sb_inodes() skips
+ * inodes that another flusher holds I_SYNC on, so each inode is still only
+ * written by one of them at a time.
+ */
+struct wb_flush_helper {
+	struct work_struct work;
+	struct bdi_writeback *wb;
+};
+
+static void wb_flush_helper_workfn(struct work_struct *work)
+{
+	struct wb_flush_helper *helper =
+		container_of(work, struct wb_flush_helper, work);
+	struct bdi_writeback *wb = helper->wb;
+
+	set_worker_desc("flush-%s", bdi_dev_name(wb->bdi));
+
+	/* don't hog the rescuer, the flusher itself will get the work done */
+	if (!current_is_workqueue_rescuer() &&
+	    test_bit(WB_registered, &wb->state) && wb_over_bg_thresh(wb))
+		trace_writeback_pages_written(wb_background_writeback(wb));
+
+	wb_put(wb);
+	if (atomic_dec_and_test(&wb->nr_flush_helpers))
+		wake_up_var(&wb->nr_flush_helpers);
+	kfree(helper);
+}
+
+static void wb_start_flush_helpers(struct bdi_writeback *wb)
+{
+	unsigned int nr = READ_ONCE(wb->bdi->wb_threads);
+
+	while (atomic_read(&wb->nr_flush_helpers) + 1 < nr) {
+		struct wb_flush_helper *helper;
+
+		helper = kmalloc(sizeof(*helper), GFP_NOWAIT | __GFP_NOWARN);
+		if (!helper)
+			break;
+		INIT_WORK(&helper->work, wb_flush_helper_workfn);
+		helper->wb = wb;
+		wb_get(wb);
+		atomic_inc(&wb->nr_flush_helpers);
+		queue_work(bdi_wq, &helper->work);
+	}
+}
+
+static long wb_check_background_flush(struct bdi_writeback *wb)
+{
+	if (wb_over_bg_thresh(wb)) {
+		wb_start_flush_helpers(wb);
+		return wb_background_writeback(wb);
 	}
 
 	return 0;
@@ -7,6 +7,7 @@
 */
 
 #include "fuse_i.h"
+#include "dev_uring_i.h"
 
 #include <linux/init.h>
 #include <linux/module.h>
@@ -64,6 +65,20 @@ static ssize_t fuse_conn_waiting_read(struct file *file, char __user *buf,
 	return simple_read_from_buffer(buf, len, ppos, tmp, size);
 }
 
+static ssize_t fuse_conn_uring_stats_read(struct file *file, char __user *buf,
+					  size_t len, loff_t *ppos)
+{
+	struct fuse_conn *fc = fuse_ctl_file_conn_get(file);
+	ssize_t ret;
+
+	if (!fc)
+		return 0;
+
+	ret = fuse_uring_stats_read(fc, buf, len, ppos);
+	fuse_conn_put(fc);
+	return ret;
+}
+
 static ssize_t fuse_conn_limit_read(struct file *file, char __user *buf,
 				    size_t len, loff_t *ppos, unsigned val)
 {
@@ -190,6 +205,11 @@ static const struct file_operations fuse_ctl_waiting_ops = {
 	.read = fuse_conn_waiting_read,
 };
 
+static const struct file_operations fuse_ctl_uring_stats_ops = {
+	.open = nonseekable_open,
+	.read = fuse_conn_uring_stats_read,
+};
+
 static const struct file_operations fuse_conn_max_background_ops = {
 	.open = nonseekable_open,
 	.read = fuse_conn_max_background_read,
@@ -273,6 +293,11 @@ int fuse_ctl_add_conn(struct fuse_conn *fc)
 				 &fuse_conn_congestion_threshold_ops))
 		goto err;
 
+	if (IS_ENABLED(CONFIG_FUSE_IO_URING) &&
+	    !fuse_ctl_add_dentry(parent, fc, "io_uring_stats", S_IFREG | 0400,
+				 1, NULL, &fuse_ctl_uring_stats_ops))
+		goto err;
+
 	return 0;
 
  err:
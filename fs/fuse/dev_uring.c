@@ -229,11 +229,13 @@ static struct fuse_ring_queue *fuse_uring_create_queue(struct fuse_ring *ring,
 	struct fuse_conn *fc = ring->fc;
 	struct fuse_ring_queue *queue;
 	struct list_head *pq;
+	int node = cpu_to_node(qid);	/* queues are per cpu */
 
-	queue = kzalloc(sizeof(*queue), GFP_KERNEL_ACCOUNT);
+	queue = kzalloc_node(sizeof(*queue), GFP_KERNEL_ACCOUNT, node);
 	if (!queue)
 		return NULL;
-	pq = kcalloc(FUSE_PQ_HASH_SIZE, sizeof(struct list_head), GFP_KERNEL);
+	pq = kcalloc_node(FUSE_PQ_HASH_SIZE, sizeof(struct list_head),
+			  GFP_KERNEL, node);
 	if (!pq) {
 		kfree(queue);
 		return NULL;
@@ -1238,12 +1240,15 @@ void fuse_uring_queue_fuse_req(struct fuse_iqueue *fiq, struct fuse_req *req)
 	if (unlikely(queue->stopped))
 		goto err_unlock;
 
+	queue->nr_reqs++;
 	ent = list_first_entry_or_null(&queue->ent_avail_queue,
 				       struct fuse_ring_ent, list);
-	if (ent)
+	if (ent) {
 		fuse_uring_add_req_to_ring_ent(ent, req);
-	else
+	} else {
 		list_add_tail(&req->list, &queue->fuse_req_queue);
+		queue->nr_reqs_waited++;
+	}
 	spin_unlock(&queue->lock);
 
 	if (ent)
@@ -1277,6 +1282,7 @@ bool fuse_uring_queue_bq_req(struct fuse_req *req)
 	}
 
 	list_add_tail(&req->list, &queue->fuse_req_bg_queue);
+	queue->nr_bg_reqs++;
 
 	ent = list_first_entry_or_null(&queue->ent_avail_queue,
 				       struct fuse_ring_ent, list);
@@ -1306,6 +1312,44 @@ bool fuse_uring_queue_bq_req(struct fuse_req *req)
 	return true;
 }
 
+/*
+ * Per-queue request counters, one line per registered queue:
+ * "<qid> <numa node> <requests> <background requests> <waited for entry>"
+ */
+ssize_t fuse_uring_stats_read(struct fuse_conn *fc, char __user *buf,
+			      size_t len, loff_t *ppos)
+{
+	struct fuse_ring *ring = READ_ONCE(fc->ring);
+	size_t size = 0, bufsize;
+	ssize_t ret;
+	char *tmp;
+	int qid;
+
+	if (!ring)
+		return 0;
+
+	bufsize = ring->nr_queues * 80;
+	tmp = kvmalloc(bufsize, GFP_KERNEL);
+	if (!tmp)
+		return -ENOMEM;
+
+	for (qid = 0; qid < ring->nr_queues; qid++) {
+		struct fuse_ring_queue *queue = READ_ONCE(ring->queues[qid]);
+
+		if (!queue)
+			continue;
+		size += scnprintf(tmp + size, bufsize - size,
+				  "%d %d %lu %lu %lu\n", qid, cpu_to_node(qid),
+				  READ_ONCE(queue->nr_reqs),
+				  READ_ONCE(queue->nr_bg_reqs),
+				  READ_ONCE(queue->nr_reqs_waited));
+	}
+
+	ret = simple_read_from_buffer(buf, len, ppos, tmp, size);
+	kvfree(tmp);
+	return ret;
+}
+
 static const struct fuse_iqueue_ops fuse_io_uring_ops = {
 	/* should be send over io-uring as enhancement */
 	.send_forget = fuse_dev_queue_forget,
@@ -98,6 +98,11 @@ struct fuse_ring_queue {
 
 	unsigned int active_background;
 
+	/* requests queued here, and those that had to wait for an entry */
+	unsigned long nr_reqs;
+	unsigned long nr_bg_reqs;
+	unsigned long nr_reqs_waited;
+
 	bool stopped;
 };
 
@@ -142,6 +147,8 @@ void fuse_uring_abort_end_requests(struct fuse_ring *ring);
 int fuse_uring_cmd(struct io_uring_cmd *cmd, unsigned int issue_flags);
 void fuse_uring_queue_fuse_req(struct fuse_iqueue *fiq, struct fuse_req *req);
 bool fuse_uring_queue_bq_req(struct fuse_req *req);
+ssize_t fuse_uring_stats_read(struct fuse_conn *fc, char __user *buf,
+			      size_t len, loff_t *ppos);
 
 static inline void fuse_uring_abort(struct fuse_conn *fc)
 {
@@ -195,6 +202,13 @@ static inline void fuse_uring_wait_stopped_queues(struct fuse_conn *fc)
 {
 }
 
+static inline ssize_t fuse_uring_stats_read(struct fuse_conn *fc,
+					    char __user *buf, size_t len,
+					    loff_t *ppos)
+{
+	return 0;
+}
+
 static inline bool fuse_uring_ready(struct fuse_conn *fc)
 {
 	return false;
@@ -1330,6 +1330,15 @@ static int fuse_update_get_attr(struct mnt_idmap *idmap, struct inode *inode,
 	else
 		sync = time_before64(fi->i_time, get_jiffies_64());
 
+	if (sync && stat && IS_ENABLED(CONFIG_FUSE_PASSTHROUGH) &&
+	    fuse_inode_backing(fi)) {
+		err = fuse_passthrough_getattr(idmap, inode, stat,
+					       request_mask, flags);
+		if (err != -ENODATA)
+			return err;
+		err = 0;
+	}
+
 	if (sync) {
 		forget_all_cached_acls(inode);
 		/* Try statx if BTIME is requested */
@@ -42,7 +42,7 @@
 #define FUSE_NAME_MAX 1024
 
 /** Number of dentries for each connection in the control filesystem */
-#define FUSE_CTL_NUM_DENTRIES 5
+#define FUSE_CTL_NUM_DENTRIES 6
 
 /** Maximum of max_pages received in init_out */
 extern unsigned int fuse_max_pages_limit;
@@ -80,6 +80,8 @@ struct fuse_submount_lookup {
 struct fuse_backing {
 	struct file *file;
 	struct cred *cred;
+	/* FUSE_BACKING_* flags */
+	unsigned int flags;
 
 	/** refcount */
 	refcount_t count;
@@ -1525,6 +1527,9 @@ ssize_t fuse_passthrough_splice_write(struct pipe_inode_info *pipe,
 				      struct file *out, loff_t *ppos,
 				      size_t len, unsigned int flags);
 ssize_t fuse_passthrough_mmap(struct file *file, struct vm_area_struct *vma);
+int fuse_passthrough_getattr(struct mnt_idmap *idmap, struct inode *inode,
+			     struct kstat *stat, u32 request_mask,
+			     unsigned int flags);
 
 #ifdef CONFIG_SYSCTL
 extern int fuse_sysctl_register(void);
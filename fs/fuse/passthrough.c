@@ -144,6 +144,55 @@ ssize_t fuse_passthrough_mmap(struct file *file, struct vm_area_struct *vma)
 	return backing_file_mmap(backing_file, vma, &ctx);
 }
 
+/*
+ * Answer getattr for an inode in passthrough mode without a round trip to
+ * the server, if its backing file was registered with FUSE_BACKING_ATTR.
+ * Identity and permissions stay those of the FUSE inode; the data attributes
+ * that passthrough I/O changes come from the backing inode.  Returns -ENODATA
+ * if the server has to be asked.
+ */
+int fuse_passthrough_getattr(struct mnt_idmap *idmap, struct inode *inode,
+			     struct kstat *stat, u32 request_mask,
+			     unsigned int flags)
+{
+	struct fuse_inode *fi = get_fuse_inode(inode);
+	const struct cred *old_cred;
+	struct fuse_backing *fb;
+	struct kstat bstat;
+	int err = -ENODATA;
+
+	rcu_read_lock();
+	fb = fuse_backing_get(fuse_inode_backing(fi));
+	rcu_read_unlock();
+	if (!fb)
+		return -ENODATA;
+	if (!(fb->flags & FUSE_BACKING_ATTR))
+		goto out;
+
+	old_cred = override_creds(fb->cred);
+	err = vfs_getattr(&fb->file->f_path, &bstat, request_mask, flags);
+	revert_creds(old_cred);
+	if (err)
+		goto out;
+
+	generic_fillattr(idmap, request_mask, inode, stat);
+	stat->mode = fi->orig_i_mode;
+	stat->ino = fi->orig_ino;
+	stat->size = bstat.size;
+	stat->blocks = bstat.blocks;
+	stat->blksize = bstat.blksize;
+	stat->atime = bstat.atime;
+	stat->mtime = bstat.mtime;
+	stat->ctime = bstat.ctime;
+	if (bstat.result_mask & STATX_BTIME) {
+		stat->btime = bstat.btime;
+		stat->result_mask |= STATX_BTIME;
+	}
+out:
+	fuse_backing_put(fb);
+	return err;
+}
+
 struct fuse_backing *fuse_backing_get(struct fuse_backing *fb)
 {
 	if (fb && refcount_inc_not_zero(&fb->count))
@@ -229,7 +278,7 @@ int fuse_backing_open(struct fuse_conn *fc, struct fuse_backing_map *map)
 		goto out;
 
 	res = -EINVAL;
-	if (map->flags || map->padding)
+	if ((map->flags & ~FUSE_BACKING_ATTR) || map->padding)
 		goto out;
 
 	file = fget_raw(map->fd);
@@ -249,6 +298,7 @@ int fuse_backing_open(struct fuse_conn *fc, struct fuse_backing_map *map)
 
 	fb->file = file;
 	fb->cred = prepare_creds();
+	fb->flags = map->flags;
 	refcount_set(&fb->count, 1);
 
 	res = fuse_backing_id_alloc(fc, fb);
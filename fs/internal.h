@@ -248,6 +248,8 @@ int open_namespace(struct ns_common *ns);
 
 int do_statx(int dfd, struct filename *filename, unsigned int flags,
 	     unsigned int mask, struct statx __user *buffer);
+int do_statx_cached(int dfd, struct filename *filename, unsigned int flags,
+		    unsigned int mask, struct statx __user *buffer);
 int do_statx_fd(int fd, unsigned int flags, unsigned int mask,
 		struct statx __user *buffer);
 
@@ -914,7 +914,8 @@ static loff_t iomap_write_iter(struct iomap_iter *iter, struct iov_iter *i)
 	ssize_t total_written = 0;
 	long status = 0;
 	struct address_space *mapping = iter->inode->i_mapping;
-	size_t chunk = mapping_max_folio_size(mapping);
+	size_t max_chunk = mapping_max_folio_size(mapping);
+	size_t chunk = max_chunk;
 	unsigned int bdp_flags = (iter->flags & IOMAP_NOWAIT) ? BDP_ASYNC : 0;
 
 	do {
@@ -1009,6 +1010,12 @@ static loff_t iomap_write_iter(struct iomap_iter *iter, struct iov_iter *i)
 			pos += written;
 			total_written += written;
 			length -= written;
+			/*
+			 * The short copy that shrank the chunk has been dealt
+			 * with, so go back to folios as large as the mapping
+			 * allows for the rest of the write.
+			 */
+			chunk = max_chunk;
 		}
 	} while (iov_iter_count(i) && length);
 
@@ -34,6 +34,9 @@
 #define IOMAP_ZERO_PAGE_ORDER (get_order(IOMAP_ZERO_PAGE_SIZE))
 static struct page *zero_page;
 
+/* used unless the file system needs its own bio_set, with a per-cpu cache */
+static struct bio_set iomap_dio_bioset;
+
 struct iomap_dio {
 	struct kiocb		*iocb;
 	const struct iomap_dio_ops *dops;
@@ -65,7 +68,10 @@ static struct bio *iomap_dio_alloc_bio(const struct iomap_iter *iter,
 	if (dio->dops && dio->dops->bio_set)
 		return bio_alloc_bioset(iter->iomap.bdev, nr_vecs, opf,
 					GFP_KERNEL, dio->dops->bio_set);
-	return bio_alloc(iter->iomap.bdev, nr_vecs, opf, GFP_KERNEL);
+	if (dio->iocb->ki_flags & IOCB_ALLOC_CACHE)
+		opf |= REQ_ALLOC_CACHE;
+	return bio_alloc_bioset(iter->iomap.bdev, nr_vecs, opf, GFP_KERNEL,
+				&iomap_dio_bioset);
 }
 
 static void iomap_dio_submit_bio(const struct iomap_iter *iter,
@@ -803,6 +809,7 @@ static int __init iomap_dio_init(void)
 	if (!zero_page)
 		return -ENOMEM;
 
-	return 0;
+	return bioset_init(&iomap_dio_bioset, 4, 0,
+			   BIOSET_NEED_BVECS | BIOSET_PERCPU_CACHE);
 }
 fs_initcall(iomap_dio_init);
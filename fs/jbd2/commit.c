@@ -246,6 +246,46 @@ int jbd2_journal_finish_inode_data_buffers(struct jbd2_inode *jinode)
 						   jinode->i_dirty_end);
 }
 
+/*
+ * Start writing out the ordered data of the running transaction while the
+ * committing one waits for its commit record. When the running transaction
+ * commits next, most of its data is then already written or in flight and
+ * journal_submit_data_buffers() has little left to do.
+ *
+ * Handles keep adding inodes to the list, but an inode only leaves it when
+ * its transaction commits, which only we do. JI_COMMIT_RUNNING protects the
+ * inode we write out from being released, as for the committing transaction.
+ */
+static void journal_submit_running_data_buffers(journal_t *journal)
+{
+	transaction_t *transaction;
+	struct jbd2_inode *jinode;
+
+	read_lock(&journal->j_state_lock);
+	transaction = journal->j_running_transaction;
+	read_unlock(&journal->j_state_lock);
+	if (!transaction || !journal->j_submit_running_inode_data_buffers)
+		return;
+
+	spin_lock(&journal->j_list_lock);
+	list_for_each_entry(jinode, &transaction->t_inode_list, i_list) {
+		if (!(jinode->i_flags & JI_WRITE_DATA) ||
+		    (jinode->i_flags & JI_COMMIT_RUNNING))
+			continue;
+		jinode->i_flags |= JI_COMMIT_RUNNING;
+		spin_unlock(&journal->j_list_lock);
+		trace_jbd2_submit_inode_data(jinode->i_vfs_inode);
+		/* errors are reported when the transaction commits */
+		journal->j_submit_running_inode_data_buffers(jinode);
+		spin_lock(&journal->j_list_lock);
+		J_ASSERT(jinode->i_transaction == transaction);
+		jinode->i_flags &= ~JI_COMMIT_RUNNING;
+		smp_mb();
+		wake_up_bit(&jinode->i_flags, __JI_COMMIT_RUNNING);
+	}
+	spin_unlock(&journal->j_list_lock);
+}
+
 /*
  * Wait for data submitted for writeout, refile inodes to proper
  * transaction if needed.
@@ -356,7 +396,7 @@ void jbd2_journal_commit_transaction(journal_t *journal)
 	int escape;
 	int err;
 	unsigned long long blocknr;
-	ktime_t start_time;
+	ktime_t start_time, phase_time, now;
 	u64 commit_time;
 	char *tagp = NULL;
 	journal_block_tag_t *tag = NULL;
@@ -567,6 +607,7 @@ void jbd2_journal_commit_transaction(journal_t *journal)
 					       stats.run.rs_logging);
 	stats.run.rs_blocks = commit_transaction->t_nr_buffers;
 	stats.run.rs_blocks_logged = 0;
+	phase_time = ktime_get();
 
 	J_ASSERT(commit_transaction->t_nr_buffers <=
 		 atomic_read(&commit_transaction->t_outstanding_credits));
@@ -735,7 +776,14 @@ void jbd2_journal_commit_transaction(journal_t *journal)
 		}
 	}
 
+	now = ktime_get();
+	stats.run.rs_log_write = ktime_to_ns(ktime_sub(now, phase_time));
+	phase_time = now;
+
 	err = journal_finish_inode_data_buffers(journal, commit_transaction);
+	now = ktime_get();
+	stats.run.rs_data_wait = ktime_to_ns(ktime_sub(now, phase_time));
+	phase_time = now;
 	if (err) {
 		printk(KERN_WARNING
 			"JBD2: Detected IO errors while flushing file data "
@@ -867,6 +915,10 @@ void jbd2_journal_commit_transaction(journal_t *journal)
 	if (err)
 		jbd2_journal_abort(journal, err);
 
+	now = ktime_get();
+	stats.run.rs_log_wait = ktime_to_ns(ktime_sub(now, phase_time));
+	phase_time = now;
+
 	jbd2_debug(3, "JBD2: commit phase 5\n");
 	write_lock(&journal->j_state_lock);
 	J_ASSERT(commit_transaction->t_state == T_COMMIT_DFLUSH);
@@ -879,13 +931,20 @@ void jbd2_journal_commit_transaction(journal_t *journal)
 		if (err)
 			jbd2_journal_abort(journal, err);
 	}
-	if (cbh)
+	if (cbh) {
+		/* Overlap the next commit's data writeout with the flush */
+		if (!is_journal_aborted(journal))
+			journal_submit_running_data_buffers(journal);
 		err = journal_wait_on_commit_record(journal, cbh);
+	}
 	stats.run.rs_blocks_logged++;
 	if (jbd2_has_feature_async_commit(journal) &&
 	    journal->j_flags & JBD2_BARRIER) {
 		blkdev_issue_flush(journal->j_dev);
 	}
+	now = ktime_get();
+	stats.run.rs_commit_write = ktime_to_ns(ktime_sub(now, phase_time));
+	phase_time = now;
 
 	if (err)
 		jbd2_journal_abort(journal, err);
@@ -1090,6 +1149,8 @@ void jbd2_journal_commit_transaction(journal_t *journal)
 	commit_transaction->t_start = jiffies;
 	stats.run.rs_logging = jbd2_time_diff(stats.run.rs_logging,
 					      commit_transaction->t_start);
+	stats.run.rs_checkpoint = ktime_to_ns(ktime_sub(ktime_get(),
+							phase_time));
 
 	/*
 	 * File the transaction statistics
@@ -1155,6 +1216,11 @@ void jbd2_journal_commit_transaction(journal_t *journal)
 	journal->j_stats.run.rs_locked += stats.run.rs_locked;
 	journal->j_stats.run.rs_flushing += stats.run.rs_flushing;
 	journal->j_stats.run.rs_logging += stats.run.rs_logging;
+	journal->j_stats.run.rs_log_write += stats.run.rs_log_write;
+	journal->j_stats.run.rs_data_wait += stats.run.rs_data_wait;
+	journal->j_stats.run.rs_log_wait += stats.run.rs_log_wait;
+	journal->j_stats.run.rs_commit_write += stats.run.rs_commit_write;
+	journal->j_stats.run.rs_checkpoint += stats.run.rs_checkpoint;
 	journal->j_stats.run.rs_handle_count += stats.run.rs_handle_count;
 	journal->j_stats.run.rs_blocks += stats.run.rs_blocks;
 	journal->j_stats.run.rs_blocks_logged += stats.run.rs_blocks_logged;
@@ -1113,6 +1113,11 @@ static void *jbd2_seq_info_next(struct seq_file *seq, void *v, loff_t *pos)
 	return NULL;
 }
 
+static u64 jbd2_avg_usecs(u64 ns, unsigned long nr)
+{
+	return div_u64(div64_ul(ns, nr), NSEC_PER_USEC);
+}
+
 static int jbd2_seq_info_show(struct seq_file *seq, void *v)
 {
 	struct jbd2_stats_proc_session *s = seq->private;
@@ -1139,6 +1144,16 @@ static int jbd2_seq_info_show(struct seq_file *seq, void *v)
 	    jiffies_to_msecs(s->stats->run.rs_flushing / s->stats->ts_tid));
 	seq_printf(seq, "  %ums logging transaction\n",
 	    jiffies_to_msecs(s->stats->run.rs_logging / s->stats->ts_tid));
+	seq_printf(seq, "    %lluus writing log blocks\n",
+	    jbd2_avg_usecs(s->stats->run.rs_log_write, s->stats->ts_tid));
+	seq_printf(seq, "    %lluus waiting for data (in ordered mode)\n",
+	    jbd2_avg_usecs(s->stats->run.rs_data_wait, s->stats->ts_tid));
+	seq_printf(seq, "    %lluus waiting for log blocks\n",
+	    jbd2_avg_usecs(s->stats->run.rs_log_wait, s->stats->ts_tid));
+	seq_printf(seq, "    %lluus writing commit record\n",
+	    jbd2_avg_usecs(s->stats->run.rs_commit_write, s->stats->ts_tid));
+	seq_printf(seq, "    %lluus checkpoint processing\n",
+	    jbd2_avg_usecs(s->stats->run.rs_checkpoint, s->stats->ts_tid));
 	seq_printf(seq, "  %lluus average transaction commit time\n",
 		   div_u64(s->journal->j_average_commit_time, 1000));
 	seq_printf(seq, "  %lu handles per transaction\n",
@@ -75,7 +75,6 @@ static void netfs_unlock_read_folio(struct netfs_io_request *rreq,
 			trace_netfs_folio(folio, netfs_folio_trace_read_done);
 		}
 
-		folioq_clear(folioq, slot);
 	} else {
 		// TODO: Use of PG_private_2 is deprecated.
 		if (test_bit(NETFS_RREQ_FOLIO_COPY_TO_CACHE, &rreq->flags))
@@ -153,11 +152,10 @@ static void netfs_read_unlock_folios(struct netfs_io_request *rreq,
 
 		clear_bit(NETFS_RREQ_FOLIO_COPY_TO_CACHE, &rreq->flags);
 
-		/* Clean up the head folioq.  If we clear an entire folioq, then
-		 * we can get rid of it provided it's not also the tail folioq
-		 * being filled by the issuer.
+		/* netfs_unlock_read_folio() cleared the slot.  If we clear an
+		 * entire folioq, then we can get rid of it provided it's not
+		 * also the tail folioq being filled by the issuer.
 		 */
-		folioq_clear(folioq, slot);
 		slot++;
 		if (slot >= folioq_nr_slots(folioq)) {
 			folioq = rolling_buffer_delete_spent(&rreq->buffer);
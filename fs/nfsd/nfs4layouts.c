@@ -781,7 +781,8 @@ nfsd4_init_pnfs(void)
 	if (!nfs4_layout_cache)
 		return -ENOMEM;
 
-	nfs4_layout_stateid_cache = KMEM_CACHE(nfs4_layout_stateid, 0);
+	nfs4_layout_stateid_cache = KMEM_CACHE(nfs4_layout_stateid,
+					       SLAB_TYPESAFE_BY_RCU);
 	if (!nfs4_layout_stateid_cache) {
 		kmem_cache_destroy(nfs4_layout_cache);
 		return -ENOMEM;
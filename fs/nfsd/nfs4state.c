@@ -941,6 +941,8 @@ struct nfs4_stid *nfs4_alloc_stid(struct nfs4_client *cl, struct kmem_cache *sla
 	stid->sc_client = cl;
 	stid->sc_stateid.si_opaque.so_id = new_id;
 	stid->sc_stateid.si_opaque.so_clid = cl->cl_clientid;
+	/* Publish the identity before the reference, see find_stateid_by_type() */
+	smp_wmb();
 	/* Will be incremented before return to client: */
 	refcount_set(&stid->sc_count, 1);
 	spin_lock_init(&stid->sc_lock);
@@ -2705,16 +2707,27 @@ find_stateid_by_type(struct nfs4_client *cl, stateid_t *t,
 {
 	struct nfs4_stid *s;
 
-	spin_lock(&cl->cl_lock);
-	s = find_stateid_locked(cl, t);
-	if (s != NULL) {
-		if ((s->sc_status & ~ok_states) == 0 &&
-		    (typemask & s->sc_type))
-			refcount_inc(&s->sc_count);
-		else
-			s = NULL;
+	rcu_read_lock();
+	s = idr_find(&cl->cl_stateids, t->si_opaque.so_id);
+	if (s && !refcount_inc_not_zero(&s->sc_count))
+		s = NULL;
+	rcu_read_unlock();
+	if (!s)
+		return NULL;
+	smp_acquire__after_ctrl_dep();
+
+	/*
+	 * The stateid slabs are SLAB_TYPESAFE_BY_RCU, so @s may have been
+	 * freed and reused since idr_find(): make sure the reference we got
+	 * is on the stateid that was asked for.
+	 */
+	if (s->sc_client != cl ||
+	    s->sc_stateid.si_opaque.so_id != t->si_opaque.so_id ||
+	    !(typemask & READ_ONCE(s->sc_type)) ||
+	    (READ_ONCE(s->sc_status) & ~ok_states)) {
+		nfs4_put_stid(s);
+		return NULL;
 	}
-	spin_unlock(&cl->cl_lock);
 	return s;
 }
 
@@ -4785,10 +4798,10 @@ nfsd4_init_slabs(void)
 	file_slab = KMEM_CACHE(nfs4_file, 0);
 	if (file_slab == NULL)
 		goto out_free_lockowner_slab;
-	stateid_slab = KMEM_CACHE(nfs4_ol_stateid, 0);
+	stateid_slab = KMEM_CACHE(nfs4_ol_stateid, SLAB_TYPESAFE_BY_RCU);
 	if (stateid_slab == NULL)
 		goto out_free_file_slab;
-	deleg_slab = KMEM_CACHE(nfs4_delegation, 0);
+	deleg_slab = KMEM_CACHE(nfs4_delegation, SLAB_TYPESAFE_BY_RCU);
 	if (deleg_slab == NULL)
 		goto out_free_stateid_slab;
 	odstate_slab = KMEM_CACHE(nfs4_clnt_odstate, 0);
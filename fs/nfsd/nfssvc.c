@@ -710,8 +710,10 @@ int nfsd_set_nrthreads(int n, int *nthreads, struct net *net)
 	 * Special case: When n == 1, pass in NULL for the pool, so that the
 	 * change is distributed equally among them.
 	 */
-	if (n == 1)
-		return svc_set_num_threads(nn->nfsd_serv, NULL, nthreads[0]);
+	if (n == 1) {
+		err = svc_set_num_threads(nn->nfsd_serv, NULL, nthreads[0]);
+		goto out;
+	}
 
 	if (n > nn->nfsd_serv->sv_nrpools)
 		n = nn->nfsd_serv->sv_nrpools;
@@ -753,6 +755,13 @@ int nfsd_set_nrthreads(int n, int *nthreads, struct net *net)
 			goto out;
 	}
 out:
+	/* What the admin asked for is the floor for on-demand sizing */
+	for (i = 0; i < nn->nfsd_serv->sv_nrpools; i++) {
+		struct svc_pool *pool = &nn->nfsd_serv->sv_pools[i];
+
+		pool->sp_nrthrmin = pool->sp_nrthreads;
+		pool->sp_starved_at = jiffies;
+	}
 	return err;
 }
 
@@ -896,6 +905,61 @@ nfsd_init_request(struct svc_rqst *rqstp,
 	return rpc_prog_mismatch;
 }
 
+static unsigned int nfsd_pool_max_threads;
+module_param(nfsd_pool_max_threads, uint, 0644);
+MODULE_PARM_DESC(nfsd_pool_max_threads,
+		 "Start threads on demand, up to this many per pool. Default: 0 (off)");
+
+/* How long a pool must go without running out of threads to shrink */
+#define NFSD_POOL_IDLE_TIMEOUT	(30 * HZ)
+
+/*
+ * Grow the pool of @rqstp by one thread when work had to wait for a
+ * thread to become idle, and give back one of the threads started that
+ * way once the pool has had idle threads for a while.  This is only done
+ * when nfsd_mutex is free, so it never waits for an admin resizing the
+ * pools or for the server shutting down.
+ */
+static void nfsd_resize_pool(struct svc_rqst *rqstp)
+{
+	unsigned int max = READ_ONCE(nfsd_pool_max_threads);
+	struct svc_serv *serv = rqstp->rq_server;
+	struct svc_pool *pool = rqstp->rq_pool;
+	unsigned int nr;
+	bool grow;
+
+	if (!max)
+		return;
+
+	if (test_bit(SP_STARVED, &pool->sp_flags)) {
+		clear_bit(SP_STARVED, &pool->sp_flags);
+		WRITE_ONCE(pool->sp_starved_at, jiffies);
+		grow = true;
+	} else if (READ_ONCE(pool->sp_nrthreads) > pool->sp_nrthrmin &&
+		   pool->sp_idle_threads.first &&
+		   time_after(jiffies, READ_ONCE(pool->sp_starved_at) +
+				       NFSD_POOL_IDLE_TIMEOUT)) {
+		/* Give the threads back one per second */
+		WRITE_ONCE(pool->sp_starved_at,
+			   jiffies - NFSD_POOL_IDLE_TIMEOUT + HZ);
+		grow = false;
+	} else {
+		return;
+	}
+
+	if (!mutex_trylock(&nfsd_mutex))
+		return;
+	if (svc_thread_should_stop(rqstp))
+		goto out;
+	nr = pool->sp_nrthreads;
+	if (grow && nr < min_t(unsigned int, max, NFSD_MAXSERVS))
+		svc_set_num_threads(serv, pool, nr + 1);
+	else if (!grow && nr > pool->sp_nrthrmin)
+		svc_set_num_threads(serv, pool, nr - 1);
+out:
+	mutex_unlock(&nfsd_mutex);
+}
+
 /*
  * This is the NFS server kernel thread
  */
@@ -925,6 +989,7 @@ nfsd(void *vrqstp)
 	while (!svc_thread_should_stop(rqstp)) {
 		svc_recv(rqstp);
 		nfsd_file_net_dispose(nn);
+		nfsd_resize_pool(rqstp);
 	}
 
 	atomic_dec(&nfsd_th_cnt);
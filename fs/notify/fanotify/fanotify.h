@@ -477,11 +477,13 @@ static inline const struct path *fanotify_event_path(struct fanotify_event *even
 }
 
 /*
- * Use 128 size hash table to speed up events merge.
+ * Use a hash table to speed up events merge.  It is sized to the queue
+ * limit of the group, aiming at 16 queued events per bucket, between 128
+ * and 4096 buckets.
  */
-#define FANOTIFY_HTABLE_BITS	(7)
-#define FANOTIFY_HTABLE_SIZE	(1 << FANOTIFY_HTABLE_BITS)
-#define FANOTIFY_HTABLE_MASK	(FANOTIFY_HTABLE_SIZE - 1)
+#define FANOTIFY_HTABLE_MIN_BITS	(7)
+#define FANOTIFY_HTABLE_MAX_BITS	(12)
+#define FANOTIFY_HTABLE_EVENTS_BITS	(4)
 
 /*
  * Permission events and overflow event do not get merged - don't hash them.
@@ -496,7 +498,8 @@ static inline unsigned int fanotify_event_hash_bucket(
 						struct fsnotify_group *group,
 						struct fanotify_event *event)
 {
-	return event->hash & FANOTIFY_HTABLE_MASK;
+	return event->hash &
+		((1U << group->fanotify_data.merge_hash_bits) - 1);
 }
 
 struct fanotify_mark {
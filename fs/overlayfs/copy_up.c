@@ -269,6 +269,7 @@ static int ovl_copy_up_file(struct ovl_fs *ofs, struct dentry *dentry,
 	loff_t data_pos = -1;
 	loff_t hole_len;
 	bool skip_hole = false;
+	bool copy_offload = true;
 	int error = 0;
 
 	ovl_path_lowerdata(dentry, &datapath);
@@ -346,6 +347,25 @@ static int ovl_copy_up_file(struct ovl_fs *ofs, struct dentry *dentry,
 		if (error)
 			break;
 
+		/*
+		 * Let the filesystems reflink or offload the copy of this chunk
+		 * (e.g. partial reflink on the same sb, server side copy on
+		 * nfs/cifs) and only move the data through the page cache if
+		 * they can't.  Stop trying after the first refusal.
+		 */
+		if (copy_offload) {
+			bytes = vfs_copy_file_range(old_file, old_pos,
+						    new_file, new_pos,
+						    this_len, 0);
+			if (bytes > 0) {
+				old_pos += bytes;
+				new_pos += bytes;
+				len -= bytes;
+				continue;
+			}
+			copy_offload = false;
+		}
+
 		bytes = do_splice_direct(old_file, &old_pos,
 					 new_file, &new_pos,
 					 this_len, SPLICE_F_MOVE);
@@ -523,6 +523,18 @@ static int proc_pid_schedstat(struct seq_file *m, struct pid_namespace *ns,
 }
 #endif
 
+#ifdef CONFIG_SCHED_LATENCY_HIST
+/*
+ * Provides /proc/PID/schedlat
+ */
+static int proc_pid_schedlat(struct seq_file *m, struct pid_namespace *ns,
+			     struct pid *pid, struct task_struct *task)
+{
+	proc_sched_lat_show_task(task, m);
+	return 0;
+}
+#endif
+
 #ifdef CONFIG_LATENCYTOP
 static int lstats_show_proc(struct seq_file *m, void *v)
 {
@@ -3376,6 +3388,9 @@ static const struct pid_entry tgid_base_stuff[] = {
 #ifdef CONFIG_SCHED_INFO
 	ONE("schedstat",  S_IRUGO, proc_pid_schedstat),
 #endif
+#ifdef CONFIG_SCHED_LATENCY_HIST
+	ONE("schedlat",   S_IRUGO, proc_pid_schedlat),
+#endif
 #ifdef CONFIG_LATENCYTOP
 	REG("latency",  S_IRUGO, proc_lstats_operations),
 #endif
@@ -3725,6 +3740,9 @@ static const struct pid_entry tid_base_stuff[] = {
 #ifdef CONFIG_SCHED_INFO
 	ONE("schedstat", S_IRUGO, proc_pid_schedstat),
 #endif
+#ifdef CONFIG_SCHED_LATENCY_HIST
+	ONE("schedlat",  S_IRUGO, proc_pid_schedlat),
+#endif
 #ifdef CONFIG_LATENCYTOP
 	REG("latency",  S_IRUGO, proc_lstats_operations),
 #endif
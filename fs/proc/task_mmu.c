@@ -603,6 +603,10 @@ static int do_procmap_query(struct proc_maps_private *priv, void __user *uarg)
 	return err;
 }
 
+#ifdef CONFIG_PROC_PAGE_MONITOR
+static int do_procmap_stats(struct proc_maps_private *priv, void __user *uarg);
+#endif
+
 static long procfs_procmap_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 {
 	struct seq_file *seq = file->private_data;
@@ -611,6 +615,10 @@ static long procfs_procmap_ioctl(struct file *file, unsigned int cmd, unsigned l
 	switch (cmd) {
 	case PROCMAP_QUERY:
 		return do_procmap_query(priv, (void __user *)arg);
+#ifdef CONFIG_PROC_PAGE_MONITOR
+	case PROCMAP_STATS:
+		return do_procmap_stats(priv, (void __user *)arg);
+#endif
 	default:
 		return -ENOIOCTLCMD;
 	}
@@ -1048,6 +1056,20 @@ static const struct mm_walk_ops smaps_shmem_walk_ops = {
 	.walk_lock		= PGWALK_RDLOCK,
 };
 
+/* Same as above, for walks under the VMA lock only, see PROCMAP_STATS */
+static const struct mm_walk_ops smaps_vma_walk_ops = {
+	.pmd_entry		= smaps_pte_range,
+	.hugetlb_entry		= smaps_hugetlb_range,
+	.walk_lock		= PGWALK_VMA_RDLOCK_VERIFY,
+};
+
+static const struct mm_walk_ops smaps_shmem_vma_walk_ops = {
+	.pmd_entry		= smaps_pte_range,
+	.hugetlb_entry		= smaps_hugetlb_range,
+	.pte_hole		= smaps_pte_hole,
+	.walk_lock		= PGWALK_VMA_RDLOCK_VERIFY,
+};
+
 /*
  * Gather mem stats from @vma with the indicated beginning
  * address @start, and keep them in @mss.
@@ -1285,6 +1307,135 @@ static int show_smaps_rollup(struct seq_file *m, void *v)
 }
 #undef SEQ_PUT_DEC
 
+/*
+ * Like smap_gather_stats(), for [start, end) within the VMA, with either the
+ * VMA read locked or mmap_lock held.
+ */
+static void smap_gather_range(struct vm_area_struct *vma,
+		struct mem_size_stats *mss, unsigned long start,
+		unsigned long end, bool vma_locked)
+{
+	const struct mm_walk_ops *ops;
+
+	ops = vma_locked ? &smaps_vma_walk_ops : &smaps_walk_ops;
+	if (vma->vm_file && shmem_mapping(vma->vm_file->f_mapping)) {
+		unsigned long shmem_swapped = shmem_swap_usage(vma);
+		bool whole = start == vma->vm_start && end == vma->vm_end;
+
+		/* See smap_gather_stats() */
+		if (whole && (!shmem_swapped || (vma->vm_flags & VM_SHARED) ||
+			      !(vma->vm_flags & VM_WRITE)))
+			mss->swap += shmem_swapped;
+		else
+			ops = vma_locked ? &smaps_shmem_vma_walk_ops :
+					   &smaps_shmem_walk_ops;
+	}
+
+	walk_page_range_vma(vma, start, end, ops, mss);
+}
+
+/*
+ * Binary smaps_rollup for a range. Each VMA is walked under its own VMA lock
+ * where possible, so writers of mmap_lock don't wait for the whole walk; only
+ * gaps and VMAs that can't be locked that way fall back to mmap_lock.
+ */
+static int do_procmap_stats(struct proc_maps_private *priv, void __user *uarg)
+{
+	struct mem_size_stats mss = {};
+	struct procmap_stats karg;
+	unsigned long addr, end;
+	struct mm_struct *mm;
+	u64 max_vmas, nr = 0;
+	__u64 usize;
+	int err;
+
+	if (copy_from_user(&usize, uarg, sizeof(usize)))
+		return -EFAULT;
+	/* argument struct can never be that large, reject abuse */
+	if (usize > PAGE_SIZE)
+		return -E2BIG;
+	if (usize < offsetofend(struct procmap_stats, max_vmas))
+		return -EINVAL;
+	err = copy_struct_from_user(&karg, sizeof(karg), uarg, usize);
+	if (err)
+		return err;
+
+	if (karg.flags || karg.start >= karg.end)
+		return -EINVAL;
+
+	max_vmas = karg.max_vmas;
+	if (!max_vmas || max_vmas > PROCMAP_STATS_MAX_VMAS)
+		max_vmas = PROCMAP_STATS_MAX_VMAS;
+
+	mm = priv->mm;
+	if (!mm || !mmget_not_zero(mm))
+		return -ESRCH;
+
+	addr = min_t(u64, karg.start, mm->task_size);
+	end = min_t(u64, karg.end, mm->task_size);
+
+	while (addr < end && nr < max_vmas) {
+		struct vm_area_struct *vma;
+		bool vma_locked = true;
+
+		if (fatal_signal_pending(current)) {
+			err = -EINTR;
+			break;
+		}
+
+		vma = lock_vma_under_rcu(mm, addr);
+		if (!vma) {
+			vma_locked = false;
+			err = mmap_read_lock_killable(mm);
+			if (err)
+				break;
+			vma = find_vma(mm, addr);
+			if (!vma || vma->vm_start >= end) {
+				mmap_read_unlock(mm);
+				addr = end;
+				break;
+			}
+		}
+
+		smap_gather_range(vma, &mss, max(addr, vma->vm_start),
+				  min(end, vma->vm_end), vma_locked);
+		addr = min(end, vma->vm_end);
+		nr++;
+
+		if (vma_locked)
+			vma_end_read(vma);
+		else
+			mmap_read_unlock(mm);
+		cond_resched();
+	}
+	mmput(mm);
+
+	if (err)
+		return err;
+
+	karg.walk_end = addr;
+	karg.nr_vmas = nr;
+	karg.rss = mss.resident;
+	karg.pss = mss.pss >> PSS_SHIFT;
+	karg.pss_anon = mss.pss_anon >> PSS_SHIFT;
+	karg.pss_file = mss.pss_file >> PSS_SHIFT;
+	karg.pss_shmem = mss.pss_shmem >> PSS_SHIFT;
+	karg.pss_dirty = mss.pss_dirty >> PSS_SHIFT;
+	karg.anonymous = mss.anonymous;
+	karg.anon_thp = mss.anonymous_thp;
+	karg.shmem_thp = mss.shmem_thp;
+	karg.file_thp = mss.file_thp;
+	karg.swap = mss.swap;
+	karg.swap_pss = mss.swap_pss >> PSS_SHIFT;
+	karg.shared_hugetlb = mss.shared_hugetlb;
+	karg.private_hugetlb = mss.private_hugetlb;
+
+	if (copy_to_user(uarg, &karg, min_t(size_t, sizeof(karg), usize)))
+		return -EFAULT;
+
+	return 0;
+}
+
 static const struct seq_operations proc_pid_smaps_op = {
 	.start	= m_start,
 	.next	= m_next,
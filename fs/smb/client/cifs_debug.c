@@ -147,7 +147,8 @@ cifs_dump_channel(struct seq_file *m, int i, struct cifs_chan *chan)
 		   "\n\t\tNumber of credits: %d,%d,%d Dialect 0x%x"
 		   "\n\t\tTCP status: %d Instance: %d"
 		   "\n\t\tLocal Users To Server: %d SecMode: 0x%x Req On Wire: %d"
-		   "\n\t\tIn Send: %d In MaxReq Wait: %d",
+		   "\n\t\tIn Send: %d In MaxReq Wait: %d"
+		   "\n\t\tBytes read: %lld Bytes written: %lld",
 		   i+1, server->conn_id,
 		   server->credits,
 		   server->echo_credits,
@@ -159,7 +160,9 @@ cifs_dump_channel(struct seq_file *m, int i, struct cifs_chan *chan)
 		   server->sec_mode,
 		   in_flight(server),
 		   atomic_read(&server->in_send),
-		   atomic_read(&server->num_waiters));
+		   atomic_read(&server->num_waiters),
+		   atomic64_read(&server->bytes_read),
+		   atomic64_read(&server->bytes_written));
 #ifdef CONFIG_NET_NS
 	if (server->net)
 		seq_printf(m, " Net namespace: %u ", server->net->ns.inum);
@@ -1010,10 +1010,24 @@ cifs_cancelled_callback(struct mid_q_entry *mid)
  * If we are currently binding a new channel (negprot/sess.setup),
  * return the new incomplete channel.
  */
+/*
+ * A channel that is out of credits makes the request wait for some in
+ * wait_mtu_credits(), however few requests it has on the wire, so rank
+ * it behind all channels that have credits left.
+ */
+static inline unsigned int cifs_chan_load(struct TCP_Server_Info *server)
+{
+	unsigned int load = server->in_flight;
+
+	if (!server->credits)
+		load += UINT_MAX / 2;
+	return load;
+}
+
 struct TCP_Server_Info *cifs_pick_channel(struct cifs_ses *ses)
 {
 	uint index = 0;
-	unsigned int min_in_flight = UINT_MAX, max_in_flight = 0;
+	unsigned int min_in_flight = UINT_MAX, max_in_flight = 0, load;
 	struct TCP_Server_Info *server = NULL;
 	int i;
 
@@ -1037,12 +1051,13 @@ struct TCP_Server_Info *cifs_pick_channel(struct cifs_ses *ses)
 		 * taking the lock could help reduce wait time, which is
 		 * important for this function
 		 */
-		if (server->in_flight < min_in_flight) {
-			min_in_flight = server->in_flight;
+		load = cifs_chan_load(server);
+		if (load < min_in_flight) {
+			min_in_flight = load;
 			index = i;
 		}
-		if (server->in_flight > max_in_flight)
-			max_in_flight = server->in_flight;
+		if (load > max_in_flight)
+			max_in_flight = load;
 	}
 
 	/* if all channels are equally loaded, fall back to round-robin */
@@ -321,6 +321,7 @@ static int vfs_statx_fd(int fd, int flags, struct kstat *stat,
  * @dfd: A file descriptor representing the base dir for a relative filename
  * @filename: The name of the file of interest
  * @flags: Flags to control the query
+ * @lookup_flags: Extra LOOKUP_* flags for the path walk
  * @stat: The result structure to fill in.
  * @request_mask: STATX_xxx flags indicating what the caller wants
  *
@@ -332,12 +333,13 @@ static int vfs_statx_fd(int fd, int flags, struct kstat *stat,
  * 0 will be returned on success, and a -ve error code if unsuccessful.
  */
 static int vfs_statx(int dfd, struct filename *filename, int flags,
-	      struct kstat *stat, u32 request_mask)
+	      unsigned int lookup_flags, struct kstat *stat, u32 request_mask)
 {
 	struct path path;
-	unsigned int lookup_flags = statx_lookup_flags(flags);
 	int error;
 
+	lookup_flags |= statx_lookup_flags(flags);
+
 	if (flags & ~(AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT | AT_EMPTY_PATH |
 		      AT_STATX_SYNC_TYPE))
 		return -EINVAL;
@@ -365,7 +367,7 @@ int vfs_fstatat(int dfd, const char __user *filename,
 	if (!name && dfd >= 0)
 		return vfs_fstat(dfd, stat);
 
-	ret = vfs_statx(dfd, name, statx_flags, stat, STATX_BASIC_STATS);
+	ret = vfs_statx(dfd, name, statx_flags, 0, stat, STATX_BASIC_STATS);
 	putname(name);
 
 	return ret;
@@ -736,8 +738,9 @@ cp_statx(const struct kstat *stat, struct statx __user *buffer)
 	return copy_to_user(buffer, &tmp, sizeof(tmp)) ? -EFAULT : 0;
 }
 
-int do_statx(int dfd, struct filename *filename, unsigned int flags,
-	     unsigned int mask, struct statx __user *buffer)
+static int __do_statx(int dfd, struct filename *filename, unsigned int flags,
+		      unsigned int lookup_flags, unsigned int mask,
+		      struct statx __user *buffer)
 {
 	struct kstat stat;
 	int error;
@@ -753,13 +756,29 @@ int do_statx(int dfd, struct filename *filename, unsigned int flags,
 	 */
 	mask &= ~STATX_CHANGE_COOKIE;
 
-	error = vfs_statx(dfd, filename, flags, &stat, mask);
+	error = vfs_statx(dfd, filename, flags, lookup_flags, &stat, mask);
 	if (error)
 		return error;
 
 	return cp_statx(&stat, buffer);
 }
 
+int do_statx(int dfd, struct filename *filename, unsigned int flags,
+	     unsigned int mask, struct statx __user *buffer)
+{
+	return __do_statx(dfd, filename, flags, 0, mask, buffer);
+}
+
+/*
+ * Like do_statx(), but fail with -EAGAIN instead of leaving the dcache
+ * during the path walk, for callers that cannot block.
+ */
+int do_statx_cached(int dfd, struct filename *filename, unsigned int flags,
+		    unsigned int mask, struct statx __user *buffer)
+{
+	return __do_statx(dfd, filename, flags, LOOKUP_CACHED, mask, buffer);
+}
+
 int do_statx_fd(int fd, unsigned int flags, unsigned int mask,
 	     struct statx __user *buffer)
 {
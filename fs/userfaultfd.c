@@ -1990,6 +1990,70 @@ static int userfaultfd_api(struct userfaultfd_ctx *ctx,
 	goto out;
 }
 
+/*
+ * Resolve many faults with one system call: run each request of the array
+ * through the same handler as its own ioctl.
+ */
+static int userfaultfd_batch(struct userfaultfd_ctx *ctx, unsigned long arg)
+{
+	int (*fn)(struct userfaultfd_ctx *ctx, unsigned long arg);
+	struct uffdio_batch __user *user_uffdio_batch;
+	struct uffdio_batch uffdio_batch;
+	unsigned long reqs;
+	size_t size;
+	u64 done;
+	int ret;
+
+	user_uffdio_batch = (struct uffdio_batch __user *) arg;
+
+	if (copy_from_user(&uffdio_batch, user_uffdio_batch,
+			   /* don't copy "done" last field */
+			   sizeof(uffdio_batch)-sizeof(__s64)))
+		return -EFAULT;
+
+	if (uffdio_batch.mode)
+		return -EINVAL;
+
+	switch (uffdio_batch.cmd) {
+	case _UFFDIO_COPY:
+		fn = userfaultfd_copy;
+		size = sizeof(struct uffdio_copy);
+		break;
+	case _UFFDIO_CONTINUE:
+		fn = userfaultfd_continue;
+		size = sizeof(struct uffdio_continue);
+		break;
+	case _UFFDIO_MOVE:
+		fn = userfaultfd_move;
+		size = sizeof(struct uffdio_move);
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	reqs = uffdio_batch.reqs;
+	if (reqs != uffdio_batch.reqs ||
+	    uffdio_batch.nr > (ULONG_MAX - reqs) / size)
+		return -EINVAL;
+
+	ret = 0;
+	for (done = 0; done < uffdio_batch.nr; done++) {
+		if (fatal_signal_pending(current)) {
+			ret = -EINTR;
+			break;
+		}
+		ret = fn(ctx, reqs + done * size);
+		if (ret)
+			break;
+		cond_resched();
+	}
+
+	if (unlikely(put_user(done, &user_uffdio_batch->done)))
+		return -EFAULT;
+
+	return ret;
+}
+
 static long userfaultfd_ioctl(struct file *file, unsigned cmd,
 			      unsigned long arg)
 {
@@ -2030,6 +2094,9 @@ static long userfaultfd_ioctl(struct file *file, unsigned cmd,
 	case UFFDIO_POISON:
 		ret = userfaultfd_poison(ctx, arg);
 		break;
+	case UFFDIO_BATCH:
+		ret = userfaultfd_batch(ctx, arg);
+		break;
 	}
 	return ret;
 }
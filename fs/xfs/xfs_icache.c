@@ -52,6 +52,8 @@ static int xfs_icwalk(struct xfs_mount *mp,
 		enum xfs_icwalk_goal goal, struct xfs_icwalk *icw);
 static int xfs_icwalk_ag(struct xfs_perag *pag,
 		enum xfs_icwalk_goal goal, struct xfs_icwalk *icw);
+static void xfs_icwalk_reclaim_spread(struct xfs_mount *mp,
+		struct xfs_icwalk *icw);
 
 /*
  * Private inode cache walk flags for struct xfs_icwalk.  Must not
@@ -1100,7 +1102,7 @@ xfs_reclaim_inodes_nr(
 	xfs_reclaim_work_queue(mp);
 	xfs_ail_push_all(mp->m_ail);
 
-	xfs_icwalk(mp, XFS_ICWALK_RECLAIM, &icw);
+	xfs_icwalk_reclaim_spread(mp, &icw);
 	return 0;
 }
 
@@ -1869,6 +1871,51 @@ xfs_icwalk(
 	BUILD_BUG_ON(XFS_ICWALK_PRIVATE_FLAGS & XFS_ICWALK_FLAGS_VALID);
 }
 
+/*
+ * Reclaim walk with a scan limit, as run from the shrinker.  A plain
+ * xfs_icwalk() spends the whole budget in the lowest numbered AGs with
+ * reclaimable inodes, so concurrent shrinker calls all pile up on the same
+ * per-AG cursors while the rest of the inode cache is left alone.  Instead give
+ * each AG a share of the budget proportional to the number of reclaimable
+ * inodes it holds, so that reclaim is spread over all AGs and concurrent
+ * callers fan out across them.  The total scanned is still bounded by the
+ * limit we were given.
+ */
+static void
+xfs_icwalk_reclaim_spread(
+	struct xfs_mount	*mp,
+	struct xfs_icwalk	*icw)
+{
+	struct xfs_perag	*pag = NULL;
+	long			limit = icw->icw_scan_limit;
+	long			budget = limit;
+	long			total;
+
+	total = xfs_reclaim_inodes_count(mp);
+	if (limit >= total) {
+		xfs_icwalk(mp, XFS_ICWALK_RECLAIM, icw);
+		return;
+	}
+
+	while ((pag = xfs_perag_grab_next_tag(mp, pag, XFS_ICI_RECLAIM_TAG))) {
+		long		share;
+		int		error;
+
+		share = div64_u64((u64)limit *
+				READ_ONCE(pag->pag_ici_reclaimable), total);
+		share = min_t(long, max_t(long, share, XFS_LOOKUP_BATCH),
+				budget);
+
+		icw->icw_scan_limit = share;
+		error = xfs_icwalk_ag(pag, XFS_ICWALK_RECLAIM, icw);
+		budget -= share - max(icw->icw_scan_limit, 0L);
+		if (error == -EFSCORRUPTED || budget <= 0) {
+			xfs_perag_rele(pag);
+			break;
+		}
+	}
+}
+
 #ifdef DEBUG
 static void
 xfs_check_delalloc(
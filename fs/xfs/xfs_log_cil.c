@@ -907,7 +907,15 @@ xlog_cil_committed(
 	xfs_extent_busy_clear(&ctx->busy_extents.extent_list,
 			      xfs_has_discard(mp) && !abort);
 
+	/*
+	 * Commit records are written in sequence order and iclog completions
+	 * are processed in LSN order, so every checkpoint older than this one
+	 * is stable too. Record that so log forces for sequences that are
+	 * already on disk don't have to serialise on the push lock.
+	 */
 	spin_lock(&ctx->cil->xc_push_lock);
+	if (!abort && ctx->sequence > ctx->cil->xc_stable_seq)
+		WRITE_ONCE(ctx->cil->xc_stable_seq, ctx->sequence);
 	list_del(&ctx->committing);
 	spin_unlock(&ctx->cil->xc_push_lock);
 
@@ -1836,6 +1844,14 @@ xlog_cil_force_seq(
 		sequence = cil->xc_current_sequence;
 	trace_xfs_log_force(log->l_mp, sequence, _RET_IP_);
 
+	/*
+	 * In fsync heavy workloads most forces are for a sequence that another
+	 * thread has already forced to disk. Let those return without taking
+	 * the push lock or touching the iclog state machine.
+	 */
+	if (sequence <= READ_ONCE(cil->xc_stable_seq))
+		return NULLCOMMITLSN;
+
 	/*
 	 * check to see if we need to force out the current context.
 	 * xlog_cil_push() handles racing pushes for the same sequence,
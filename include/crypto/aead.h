@@ -119,6 +119,8 @@ struct aead_request {
  * @setkey: see struct skcipher_alg
  * @encrypt: see struct skcipher_alg
  * @decrypt: see struct skcipher_alg
+ * @encrypt_batch: see struct skcipher_alg
+ * @decrypt_batch: see struct skcipher_alg
  * @ivsize: see struct skcipher_alg
  * @chunksize: see struct skcipher_alg
  * @init: Initialize the cryptographic transformation object. This function
@@ -134,7 +136,8 @@ struct aead_request {
  *	  @init.
  * @base: Definition of a generic crypto cipher algorithm.
  *
- * All fields except @ivsize is mandatory and must be filled.
+ * All fields except @ivsize, @encrypt_batch and @decrypt_batch are mandatory
+ * and must be filled.
  */
 struct aead_alg {
 	int (*setkey)(struct crypto_aead *tfm, const u8 *key,
@@ -142,6 +145,10 @@ struct aead_alg {
 	int (*setauthsize)(struct crypto_aead *tfm, unsigned int authsize);
 	int (*encrypt)(struct aead_request *req);
 	int (*decrypt)(struct aead_request *req);
+	void (*encrypt_batch)(struct aead_request **reqs, unsigned int nreqs,
+			      int *errs);
+	void (*decrypt_batch)(struct aead_request **reqs, unsigned int nreqs,
+			      int *errs);
 	int (*init)(struct crypto_aead *tfm);
 	void (*exit)(struct crypto_aead *tfm);
 
@@ -381,6 +388,38 @@ int crypto_aead_encrypt(struct aead_request *req);
  */
 int crypto_aead_decrypt(struct aead_request *req);
 
+/**
+ * crypto_aead_encrypt_batch() - encrypt several requests at once
+ * @reqs: array of aead_request handles, all set up for the same tfm
+ * @nreqs: number of requests in @reqs
+ * @errs: array of @nreqs integers receiving the result of each request
+ *
+ * Submit a batch of requests in one call, so that implementations can process
+ * them in parallel SIMD lanes or queue them to hardware in one go. Each entry
+ * of @errs receives what crypto_aead_encrypt() would have returned for the
+ * request, and asynchronous requests complete through their own callbacks.
+ *
+ * Return: 0 if all requests completed successfully, otherwise the first
+ *	   non-zero value stored in @errs
+ */
+int crypto_aead_encrypt_batch(struct aead_request **reqs, unsigned int nreqs,
+			      int *errs);
+
+/**
+ * crypto_aead_decrypt_batch() - decrypt several requests at once
+ * @reqs: array of aead_request handles, all set up for the same tfm
+ * @nreqs: number of requests in @reqs
+ * @errs: array of @nreqs integers receiving the result of each request
+ *
+ * The batched counterpart of crypto_aead_decrypt(), see
+ * crypto_aead_encrypt_batch().
+ *
+ * Return: 0 if all requests completed successfully, otherwise the first
+ *	   non-zero value stored in @errs
+ */
+int crypto_aead_decrypt_batch(struct aead_request **reqs, unsigned int nreqs,
+			      int *errs);
+
 /**
  * DOC: Asynchronous AEAD Request Handle
  *
@@ -34,11 +34,13 @@ struct scatterlist;
  *	@iv: Initialisation Vector
  *	@src: Source SG list
  *	@dst: Destination SG list
+ *	@du_size: Size of each data unit, or 0 if the request is a single one
  *	@base: Underlying async request
  *	@__ctx: Start of private context data
  */
 struct skcipher_request {
 	unsigned int cryptlen;
+	unsigned int du_size;
 
 	u8 *iv;
 
@@ -119,6 +121,12 @@ struct skcipher_alg_common SKCIPHER_ALG_COMMON;
  *	     be called in parallel with the same transformation object.
  * @decrypt: Decrypt a single block. This is a reverse counterpart to @encrypt
  *	     and the conditions are exactly the same.
+ * @encrypt_batch: Optional. Encrypt an array of requests for the same
+ *		   transformation object, storing what @encrypt would have
+ *		   returned for each of them in the array of results. This
+ *		   lets implementations process several requests in parallel
+ *		   SIMD lanes or submit them to hardware together.
+ * @decrypt_batch: Optional. The batched counterpart of @decrypt.
  * @export: Export partial state of the transformation. This function dumps the
  *	    entire state of the ongoing transformation into a provided block of
  *	    data so it can be @import 'ed back later on. This is useful in case
@@ -144,21 +152,29 @@ struct skcipher_alg_common SKCIPHER_ALG_COMMON;
  * @walksize: Equal to the chunk size except in cases where the algorithm is
  * 	      considerably more efficient if it can operate on multiple chunks
  * 	      in parallel. Should be a multiple of chunksize.
+ * @multi_data_unit: The algorithm handles requests made of several data
+ *		     units, see skcipher_request_set_data_unit_size().
  * @co: see struct skcipher_alg_common
  *
- * All fields except @ivsize are mandatory and must be filled.
+ * All fields except @ivsize, @encrypt_batch and @decrypt_batch are mandatory
+ * and must be filled.
  */
 struct skcipher_alg {
 	int (*setkey)(struct crypto_skcipher *tfm, const u8 *key,
 	              unsigned int keylen);
 	int (*encrypt)(struct skcipher_request *req);
 	int (*decrypt)(struct skcipher_request *req);
+	void (*encrypt_batch)(struct skcipher_request **reqs,
+			      unsigned int nreqs, int *errs);
+	void (*decrypt_batch)(struct skcipher_request **reqs,
+			      unsigned int nreqs, int *errs);
 	int (*export)(struct skcipher_request *req, void *out);
 	int (*import)(struct skcipher_request *req, const void *in);
 	int (*init)(struct crypto_skcipher *tfm);
 	void (*exit)(struct crypto_skcipher *tfm);
 
 	unsigned int walksize;
+	bool multi_data_unit;
 
 	union {
 		struct SKCIPHER_ALG_COMMON;
@@ -705,6 +721,37 @@ int crypto_skcipher_encrypt(struct skcipher_request *req);
  */
 int crypto_skcipher_decrypt(struct skcipher_request *req);
 
+/**
+ * crypto_skcipher_encrypt_batch() - encrypt several requests at once
+ * @reqs: array of skcipher_request handles, all set up for the same tfm
+ * @nreqs: number of requests in @reqs
+ * @errs: array of @nreqs integers receiving the result of each request
+ *
+ * Each entry of @errs receives what crypto_skcipher_encrypt() would have
+ * returned for the request, and asynchronous requests complete through their
+ * own callbacks.
+ *
+ * Return: 0 if all requests completed successfully, otherwise the first
+ *	   non-zero value stored in @errs
+ */
+int crypto_skcipher_encrypt_batch(struct skcipher_request **reqs,
+				  unsigned int nreqs, int *errs);
+
+/**
+ * crypto_skcipher_decrypt_batch() - decrypt several requests at once
+ * @reqs: array of skcipher_request handles, all set up for the same tfm
+ * @nreqs: number of requests in @reqs
+ * @errs: array of @nreqs integers receiving the result of each request
+ *
+ * The batched counterpart of crypto_skcipher_decrypt(), see
+ * crypto_skcipher_encrypt_batch().
+ *
+ * Return: 0 if all requests completed successfully, otherwise the first
+ *	   non-zero value stored in @errs
+ */
+int crypto_skcipher_decrypt_batch(struct skcipher_request **reqs,
+				  unsigned int nreqs, int *errs);
+
 /**
  * crypto_skcipher_export() - export partial state
  * @req: reference to the skcipher_request handle that holds all information
@@ -926,8 +973,31 @@ static inline void skcipher_request_set_crypt(
 	req->src = src;
 	req->dst = dst;
 	req->cryptlen = cryptlen;
+	req->du_size = 0;
 	req->iv = iv;
 }
 
+bool crypto_skcipher_multi_data_unit(struct crypto_skcipher *tfm);
+
+/**
+ * skcipher_request_set_data_unit_size() - process a request as data units
+ * @req: request handle
+ * @du_size: size in bytes of each data unit
+ *
+ * Treat the request as a sequence of independent messages of @du_size bytes
+ * each, such as consecutive disk sectors. The first one uses the request IV,
+ * and each following one the IV of the previous one with its first 64 bits
+ * incremented as a little-endian integer (the "plain64" IV of dm-crypt).
+ * The request length must be a multiple of @du_size.
+ *
+ * Must be called after skcipher_request_set_crypt(), and only for
+ * transformations for which crypto_skcipher_multi_data_unit() is true.
+ */
+static inline void skcipher_request_set_data_unit_size(
+	struct skcipher_request *req, unsigned int du_size)
+{
+	req->du_size = du_size;
+}
+
 #endif	/* _CRYPTO_SKCIPHER_H */
 
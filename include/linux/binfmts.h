@@ -147,5 +147,7 @@ extern ssize_t read_code(struct file *, unsigned long, loff_t, size_t);
 
 int kernel_execve(const char *filename,
 		  const char *const *argv, const char *const *envp);
+int spawn_execve(const char __user *filename, const void __user *argv,
+		 const void __user *envp, bool compat);
 
 #endif /* _LINUX_BINFMTS_H */
@@ -379,6 +379,9 @@ struct ceph_connection_v1_info {
 
 #define CEPH_FRAME_MAX_SEGMENT_COUNT	4
 
+/* # of data pieces received with a single recvmsg */
+#define CEPH_MSGR2_IN_DATA_BVECS	16
+
 struct ceph_frame_desc {
 	int fd_tag;  /* FRAME_TAG_* */
 	int fd_seg_cnt;
@@ -395,6 +398,9 @@ struct ceph_connection_v2_info {
 	struct iov_iter in_iter;
 	struct kvec in_kvecs[5];  /* recvmsg */
 	struct bio_vec in_bvec;  /* recvmsg (in_cursor) */
+	struct bio_vec in_data_bvecs[CEPH_MSGR2_IN_DATA_BVECS];  /* recvmsg
+						(in_cursor, plain data) */
+	int in_data_bvec_cnt;
 	int in_kvec_cnt;
 	int in_state;  /* IN_S_* */
 
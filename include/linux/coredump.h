@@ -16,6 +16,8 @@ struct core_vma_metadata {
 	struct file   *file;
 };
 
+struct core_compress;
+
 struct coredump_params {
 	const kernel_siginfo_t *siginfo;
 	struct file *file;
@@ -28,6 +30,7 @@ struct coredump_params {
 	int vma_count;
 	size_t vma_data_size;
 	struct core_vma_metadata *vma_meta;
+	struct core_compress *compress;
 };
 
 extern unsigned int core_file_note_size_limit;
@@ -257,6 +257,7 @@ struct fsnotify_group {
 		struct fanotify_group_private_data {
 			/* Hash table of events for merge */
 			struct hlist_head *merge_hash;
+			unsigned int merge_hash_bits;
 			/* allows a group to block waiting for a userspace response */
 			struct list_head access_list;
 			wait_queue_head_t access_waitq;
@@ -47,10 +47,11 @@ union futex_key {
 		u64 ptr;
 		unsigned long word;
 		unsigned int offset;
+		int node;	/* FUTEX2_NUMA node or FUTEX_NO_NODE, not hashed */
 	} both;
 };
 
-#define FUTEX_KEY_INIT (union futex_key) { .both = { .ptr = 0ULL } }
+#define FUTEX_KEY_INIT (union futex_key) { .both = { .ptr = 0ULL, .node = FUTEX_NO_NODE } }
 
 #ifdef CONFIG_FUTEX
 enum {
@@ -77,6 +78,9 @@ void futex_exec_release(struct task_struct *tsk);
 
 long do_futex(u32 __user *uaddr, int op, u32 val, ktime_t *timeout,
 	      u32 __user *uaddr2, u32 val2, u32 val3);
+void futex_hash_free(struct mm_struct *mm);
+int futex_hash_prctl(unsigned long arg2, unsigned long arg3,
+		     unsigned long arg4, unsigned long arg5);
 #else
 static inline void futex_init_task(struct task_struct *tsk) { }
 static inline void futex_exit_recursive(struct task_struct *tsk) { }
@@ -88,6 +92,12 @@ static inline long do_futex(u32 __user *uaddr, int op, u32 val,
 {
 	return -EINVAL;
 }
+static inline void futex_hash_free(struct mm_struct *mm) { }
+static inline int futex_hash_prctl(unsigned long arg2, unsigned long arg3,
+				   unsigned long arg4, unsigned long arg5)
+{
+	return -EINVAL;
+}
 #endif
 
 #endif
@@ -10,5 +10,6 @@
 #include <linux/cpu.h>
 
 struct cpumask *group_cpus_evenly(unsigned int numgrps);
+unsigned int group_cpus_nr_llcs(void);
 
 #endif
@@ -207,6 +207,23 @@ static inline void clear_user_highpage(struct page *page, unsigned long vaddr)
 }
 #endif
 
+/*
+ * Like clear_user_highpage(), but bypassing the caches where the architecture
+ * has a clear_page_nocache(). A wmb() must follow before the page is mapped.
+ */
+static inline void clear_user_highpage_nocache(struct page *page,
+					       unsigned long vaddr)
+{
+#ifdef clear_page_nocache
+	void *addr = kmap_local_page(page);
+
+	clear_page_nocache(addr);
+	kunmap_local(addr);
+#else
+	clear_user_highpage(page, vaddr);
+#endif
+}
+
 #ifndef vma_alloc_zeroed_movable_folio
 /**
  * vma_alloc_zeroed_movable_folio - Allocate a zeroed page for a VMA.
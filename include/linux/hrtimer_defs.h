@@ -83,6 +83,9 @@ enum  hrtimer_base_type {
  * @nr_retries:		Total number of hrtimer interrupt retries
  * @nr_hangs:		Total number of hrtimer interrupt hangs
  * @max_hang_time:	Maximum time spent in hrtimer_interrupt
+ * @nr_expired:		Total number of expired hrtimers
+ * @nr_batched:		Number of expired hrtimers which were found right-of
+ *			a not yet expired hrtimer, see hrtimer_batch_next()
  * @softirq_expiry_lock: Lock which is taken while softirq based hrtimer are
  *			 expired
  * @online:		CPU is online from an hrtimers point of view
@@ -116,6 +119,8 @@ struct hrtimer_cpu_base {
 	unsigned short			nr_hangs;
 	unsigned int			max_hang_time;
 #endif
+	unsigned long			nr_expired;
+	unsigned long			nr_batched;
 #ifdef CONFIG_PREEMPT_RT
 	spinlock_t			softirq_expiry_lock;
 	atomic_t			timer_waiters;
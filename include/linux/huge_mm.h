@@ -50,6 +50,7 @@ enum transparent_hugepage_flag {
 	TRANSPARENT_HUGEPAGE_DEFRAG_REQ_MADV_FLAG,
 	TRANSPARENT_HUGEPAGE_DEFRAG_KHUGEPAGED_FLAG,
 	TRANSPARENT_HUGEPAGE_USE_ZERO_PAGE_FLAG,
+	TRANSPARENT_HUGEPAGE_ANON_ADAPTIVE_FLAG,
 };
 
 struct kobject;
@@ -128,11 +129,17 @@ enum mthp_stat_item {
 	MTHP_STAT_SHMEM_ALLOC,
 	MTHP_STAT_SHMEM_FALLBACK,
 	MTHP_STAT_SHMEM_FALLBACK_CHARGE,
+	MTHP_STAT_SHMEM_SWPIN,
+	MTHP_STAT_SHMEM_SWPIN_FALLBACK,
+	MTHP_STAT_SHMEM_SWPOUT,
+	MTHP_STAT_SHMEM_SWPOUT_FALLBACK,
 	MTHP_STAT_SPLIT,
 	MTHP_STAT_SPLIT_FAILED,
 	MTHP_STAT_SPLIT_DEFERRED,
 	MTHP_STAT_NR_ANON,
 	MTHP_STAT_NR_ANON_PARTIALLY_MAPPED,
+	MTHP_STAT_ANON_ACCESS_HIT,
+	MTHP_STAT_ANON_ACCESS_WASTE,
 	__MTHP_STAT_COUNT
 };
 
@@ -312,6 +319,17 @@ struct thpsize {
 	(transparent_hugepage_flags &					\
 	 (1<<TRANSPARENT_HUGEPAGE_USE_ZERO_PAGE_FLAG))
 
+static inline bool transparent_hugepage_anon_adaptive(void)
+{
+	return transparent_hugepage_flags &
+	       (1 << TRANSPARENT_HUGEPAGE_ANON_ADAPTIVE_FLAG);
+}
+
+void mthp_anon_record_access(struct mm_struct *mm, struct folio *folio,
+			     unsigned int young);
+unsigned long mthp_anon_adapt_orders(struct mm_struct *mm,
+				     unsigned long orders);
+
 static inline bool vma_thp_disabled(struct vm_area_struct *vma,
 		unsigned long vm_flags)
 {
@@ -480,6 +498,17 @@ static inline bool folio_test_pmd_mappable(struct folio *folio)
 	return false;
 }
 
+static inline bool transparent_hugepage_anon_adaptive(void)
+{
+	return false;
+}
+
+static inline void mthp_anon_record_access(struct mm_struct *mm,
+					   struct folio *folio,
+					   unsigned int young)
+{
+}
+
 static inline bool thp_vma_suitable_order(struct vm_area_struct *vma,
 		unsigned long addr, int order)
 {
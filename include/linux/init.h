@@ -315,6 +315,25 @@ extern struct module __this_module;
 
 #define __initcall(fn) device_initcall(fn)
 
+/*
+ * A parallel initcall declares that @fn only depends on the initcall
+ * levels before its own. When booted with initcall_parallel, it is run
+ * from an async worker alongside the rest of its level, and the level
+ * waits for it to finish before the next one starts. Otherwise it is
+ * called in place like any other initcall.
+ */
+int __init schedule_parallel_initcall(initcall_t fn);
+
+#define __define_parallel_initcall(fn, id)			\
+	static int __init __parallel_##fn(void)			\
+	{							\
+		return schedule_parallel_initcall(fn);		\
+	}							\
+	__define_initcall(__parallel_##fn, id)
+
+#define device_initcall_parallel(fn)	__define_parallel_initcall(fn, 6)
+#define late_initcall_parallel(fn)	__define_parallel_initcall(fn, 7)
+
 #define __exitcall(fn)						\
 	static exitcall_t __exitcall_##fn __exit_call = fn
 
@@ -288,6 +288,8 @@ struct irq_affinity_notify {
  *			of interrupt sets
  * @priv:		Private data for usage by @calc_sets, usually a
  *			pointer to driver/device specific data.
+ * @per_llc:		Without @calc_sets, ask for one vector per last level
+ *			cache rather than one per CPU
  */
 struct irq_affinity {
 	unsigned int	pre_vectors;
@@ -296,6 +298,7 @@ struct irq_affinity {
 	unsigned int	set_size[IRQ_AFFINITY_MAX_SETS];
 	void		(*calc_sets)(struct irq_affinity *, unsigned int nvecs);
 	void		*priv;
+	bool		per_llc;
 };
 
 /**
@@ -6,7 +6,15 @@
 #include <linux/xarray.h>
 #include <uapi/linux/io_uring.h>
 
+struct io_uring_cmd;
+struct request;
+
 #if defined(CONFIG_IO_URING)
+int io_buffer_register_bvec(struct io_uring_cmd *cmd, struct request *rq,
+			    void (*release)(void *), unsigned int index,
+			    unsigned int issue_flags);
+int io_buffer_unregister_bvec(struct io_uring_cmd *cmd, unsigned int index,
+			      unsigned int issue_flags);
 void __io_uring_cancel(bool cancel_all);
 void __io_uring_free(struct task_struct *tsk);
 void io_uring_unreg_ringfd(void);
@@ -29,6 +37,20 @@ static inline void io_uring_free(struct task_struct *tsk)
 		__io_uring_free(tsk);
 }
 #else
+static inline int io_buffer_register_bvec(struct io_uring_cmd *cmd,
+					  struct request *rq,
+					  void (*release)(void *),
+					  unsigned int index,
+					  unsigned int issue_flags)
+{
+	return -EOPNOTSUPP;
+}
+static inline int io_buffer_unregister_bvec(struct io_uring_cmd *cmd,
+					    unsigned int index,
+					    unsigned int issue_flags)
+{
+	return -EOPNOTSUPP;
+}
 static inline void io_uring_task_cancel(void)
 {
 }
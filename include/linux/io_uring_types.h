@@ -61,6 +61,12 @@ struct io_rsrc_data {
 	struct io_rsrc_node		**nodes;
 };
 
+/* bvec array built from an iovec pointing into a registered buffer */
+struct iou_vec {
+	struct bio_vec		*bvec;
+	unsigned		nr;
+};
+
 struct io_file_table {
 	struct io_rsrc_data data;
 	unsigned long *bitmap;
@@ -243,6 +249,10 @@ struct io_ring_ctx {
 		unsigned int		drain_disabled: 1;
 		unsigned int		compat: 1;
 		unsigned int		iowq_limits_set : 1;
+		unsigned int		coarse_timeouts: 1;
+
+		/* IORING_REGISTER_OP_STATS, NULL if disabled */
+		struct io_op_stats	*op_stats;
 
 		struct task_struct	*submitter_task;
 		struct io_rings		*rings;
@@ -356,6 +366,8 @@ struct io_ring_ctx {
 		struct list_head	timeout_list;
 		struct list_head	ltimeout_list;
 		unsigned		cq_last_tm_flush;
+		/* IORING_SETUP_COARSE_TIMEOUTS */
+		struct io_timer_wheel	*timer_wheel;
 	} ____cacheline_aligned_in_smp;
 
 	spinlock_t		completion_lock;
@@ -375,6 +387,11 @@ struct io_ring_ctx {
 
 	struct wait_queue_head	sqo_sq_wait;
 	struct list_head	sqd_list;
+	/* SQPOLL scheduling and accounting, protected by sqd->lock */
+	unsigned int		sq_weight;
+	unsigned int		sq_deficit;
+	u64			sq_busy_time;
+	u64			sq_submitted;
 
 	unsigned int		file_alloc_start;
 	unsigned int		file_alloc_end;
@@ -411,6 +428,9 @@ struct io_ring_ctx {
 	struct io_alloc_cache		msg_cache;
 	spinlock_t			msg_lock;
 
+	/* protected by ->uring_lock, published under ->mmap_lock */
+	struct io_zcrx_ifq		*ifq;
+
 #ifdef CONFIG_NET_RX_BUSY_POLL
 	struct list_head	napi_list;	/* track busy poll napi_id */
 	spinlock_t		napi_lock;	/* napi_list lock */
@@ -420,6 +440,15 @@ struct io_ring_ctx {
 	bool			napi_prefer_busy_poll;
 	u8			napi_track_mode;
 
+	/* IO_URING_NAPI_ADAPTIVE state, updated locklessly by waiters */
+	bool			napi_adaptive;
+	bool			napi_irqs_suspended;
+	u8			napi_misses;
+	unsigned		napi_last_cq_tail;
+	ktime_t			napi_last_cqe_time;
+	/* moving average of the time between CQEs */
+	ktime_t			napi_cqe_interval;
+
 	DECLARE_HASHTABLE(napi_ht, 4);
 #endif
 
@@ -437,6 +466,8 @@ struct io_ring_ctx {
 	struct io_mapped_region		ring_region;
 	/* used for optimised request parameter and wait argument passing  */
 	struct io_mapped_region		param_region;
+	/* backing memory for ->op_stats, kept until the ring is freed */
+	struct io_op_stats		*op_stats_alloc;
 };
 
 struct io_tw_state {
@@ -678,6 +709,8 @@ struct io_kiocb {
 	struct io_kiocb			*link;
 	/* custom credentials, valid IFF REQ_F_CREDS is set */
 	const struct cred		*creds;
+	/* submission time, only set while op stats are enabled */
+	u64				stats_ts;
 	struct io_wq_work		work;
 
 	struct {
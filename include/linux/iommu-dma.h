@@ -26,6 +26,12 @@ dma_addr_t iommu_dma_map_page(struct device *dev, struct page *page,
 		unsigned long attrs);
 void iommu_dma_unmap_page(struct device *dev, dma_addr_t dma_handle,
 		size_t size, enum dma_data_direction dir, unsigned long attrs);
+int iommu_dma_map_pages(struct device *dev, struct page **pages,
+		unsigned int nr, dma_addr_t *addrs, enum dma_data_direction dir,
+		unsigned long attrs);
+void iommu_dma_unmap_pages(struct device *dev, dma_addr_t *addrs,
+		unsigned int nr, enum dma_data_direction dir,
+		unsigned long attrs);
 int iommu_dma_map_sg(struct device *dev, struct scatterlist *sg, int nents,
 		enum dma_data_direction dir, unsigned long attrs);
 void iommu_dma_unmap_sg(struct device *dev, struct scatterlist *sg, int nents,
@@ -95,6 +95,11 @@ void free_iova_fast(struct iova_domain *iovad, unsigned long pfn,
 		    unsigned long size);
 unsigned long alloc_iova_fast(struct iova_domain *iovad, unsigned long size,
 			      unsigned long limit_pfn, bool flush_rcache);
+unsigned int alloc_iova_fast_bulk(struct iova_domain *iovad, unsigned long size,
+				  unsigned long limit_pfn, unsigned long *pfns,
+				  unsigned int nr);
+void free_iova_fast_bulk(struct iova_domain *iovad, const unsigned long *pfns,
+			 unsigned int nr, unsigned long size);
 struct iova *reserve_iova(struct iova_domain *iovad, unsigned long pfn_lo,
 	unsigned long pfn_hi);
 void init_iova_domain(struct iova_domain *iovad, unsigned long granule,
@@ -142,6 +147,21 @@ static inline unsigned long alloc_iova_fast(struct iova_domain *iovad,
 	return 0;
 }
 
+static inline unsigned int alloc_iova_fast_bulk(struct iova_domain *iovad,
+						unsigned long size,
+						unsigned long limit_pfn,
+						unsigned long *pfns,
+						unsigned int nr)
+{
+	return 0;
+}
+
+static inline void free_iova_fast_bulk(struct iova_domain *iovad,
+				       const unsigned long *pfns,
+				       unsigned int nr, unsigned long size)
+{
+}
+
 static inline struct iova *reserve_iova(struct iova_domain *iovad,
 					unsigned long pfn_lo,
 					unsigned long pfn_hi)
@@ -716,6 +716,13 @@ struct transaction_run_stats_s {
 	unsigned long		rs_flushing;
 	unsigned long		rs_logging;
 
+	/* Breakdown of rs_logging, in nanoseconds */
+	u64			rs_log_write;	/* building, submitting log blocks */
+	u64			rs_data_wait;	/* waiting for ordered data */
+	u64			rs_log_wait;	/* waiting for log blocks */
+	u64			rs_commit_write; /* writing the commit record */
+	u64			rs_checkpoint;	/* filing buffers for checkpoint */
+
 	__u32			rs_handle_count;
 	__u32			rs_blocks;
 	__u32			rs_blocks_logged;
@@ -1209,6 +1216,17 @@ struct journal_s
 	int			(*j_finish_inode_data_buffers)
 					(struct jbd2_inode *);
 
+	/**
+	 * @j_submit_running_inode_data_buffers:
+	 *
+	 * Optional. This function is called for inodes associated with the
+	 * running transaction marked with JI_WRITE_DATA flag while the
+	 * commit record of the committing transaction is being written. It
+	 * may start writing out data early, but must not block on handles.
+	 */
+	int			(*j_submit_running_inode_data_buffers)
+					(struct jbd2_inode *);
+
 	/*
 	 * Journal statistics
 	 */
@@ -356,6 +356,11 @@ struct kimage {
 	bool elfcorehdr_updated;
 #endif
 
+#ifdef CONFIG_KEXEC_PRESERVE
+	/* Descriptor of the memory ranges handed over to the next kernel */
+	void *preserve_buf;
+#endif
+
 #ifdef CONFIG_IMA_KEXEC
 	/* Virtual address of IMA measurement buffer for kexec syscall */
 	void *ima_buffer;
@@ -477,6 +482,28 @@ static inline int kexec_crash_loaded(void) { return 0; }
 #define kexec_in_progress false
 #endif /* CONFIG_KEXEC_CORE */
 
+#define KEXEC_PRESERVE_NAME_LEN	32
+
+#ifdef CONFIG_KEXEC_PRESERVE
+int kexec_preserve_range(const char *name, phys_addr_t start, size_t size);
+void kexec_unpreserve_range(const char *name);
+int kexec_preserved_range(const char *name, phys_addr_t *start, size_t *size);
+void kexec_preserved_release(const char *name);
+#else
+static inline int kexec_preserve_range(const char *name, phys_addr_t start,
+				       size_t size)
+{
+	return -EOPNOTSUPP;
+}
+static inline void kexec_unpreserve_range(const char *name) { }
+static inline int kexec_preserved_range(const char *name, phys_addr_t *start,
+					size_t *size)
+{
+	return -ENOENT;
+}
+static inline void kexec_preserved_release(const char *name) { }
+#endif
+
 #ifdef CONFIG_KEXEC_SIG
 void set_kexec_sig_enforced(void);
 #else
@@ -55,6 +55,9 @@ enum memcg_memory_event {
 	MEMCG_NR_MEMORY_EVENTS,
 };
 
+/* Log2 buckets of memory.refault_distance, the last one is open ended */
+#define MEMCG_NR_REFAULT_BUCKETS	24
+
 struct mem_cgroup_reclaim_cookie {
 	pg_data_t *pgdat;
 	int generation;
@@ -236,6 +239,11 @@ struct mem_cgroup {
 	atomic_long_t		memory_events[MEMCG_NR_MEMORY_EVENTS];
 	atomic_long_t		memory_events_local[MEMCG_NR_MEMORY_EVENTS];
 
+#ifdef CONFIG_MEMCG_REFAULT_HISTOGRAM
+	/* memory.refault_distance, bucket i counts distances < 2^i pages */
+	atomic_long_t		refault_distance[MEMCG_NR_REFAULT_BUCKETS];
+#endif
+
 	/*
 	 * Hint of reclaim pressure for socket memroy management. Note
 	 * that this indicator should NOT be used in legacy cgroup mode
@@ -944,6 +952,16 @@ unsigned long lruvec_page_state_local(struct lruvec *lruvec,
 void mem_cgroup_flush_stats(struct mem_cgroup *memcg);
 void mem_cgroup_flush_stats_ratelimited(struct mem_cgroup *memcg);
 
+#ifdef CONFIG_MEMCG_REFAULT_HISTOGRAM
+void mem_cgroup_record_refault(struct mem_cgroup *memcg,
+			       unsigned long distance);
+#else
+static inline void mem_cgroup_record_refault(struct mem_cgroup *memcg,
+					     unsigned long distance)
+{
+}
+#endif
+
 void __mod_lruvec_kmem_state(void *p, enum node_stat_item idx, int val);
 
 static inline void mod_lruvec_kmem_state(void *p, enum node_stat_item idx,
@@ -1422,6 +1440,11 @@ static inline void mem_cgroup_flush_stats_ratelimited(struct mem_cgroup *memcg)
 {
 }
 
+static inline void mem_cgroup_record_refault(struct mem_cgroup *memcg,
+					     unsigned long distance)
+{
+}
+
 static inline void __mod_lruvec_kmem_state(void *p, enum node_stat_item idx,
 					   int val)
 {
@@ -1740,6 +1740,15 @@ static inline int folio_xchg_access_time(struct folio *folio, int time)
 	return last_time << PAGE_ACCESS_TIME_BUCKETS;
 }
 
+/* Time in ms since the access time of @folio, which is left unchanged */
+static inline unsigned int folio_access_latency(struct folio *folio,
+						unsigned int time)
+{
+	int last_time = folio_last_cpupid(folio) << PAGE_ACCESS_TIME_BUCKETS;
+
+	return (time - last_time) & PAGE_ACCESS_TIME_MASK;
+}
+
 static inline void vma_set_access_pid_bit(struct vm_area_struct *vma)
 {
 	unsigned int pid_bit;
@@ -1801,6 +1810,12 @@ static inline bool cpupid_match_pid(struct task_struct *task, int cpupid)
 	return false;
 }
 
+static inline unsigned int folio_access_latency(struct folio *folio,
+						unsigned int time)
+{
+	return 0;
+}
+
 static inline void vma_set_access_pid_bit(struct vm_area_struct *vma)
 {
 }
@@ -2395,6 +2410,15 @@ void free_pgd_range(struct mmu_gather *tlb, unsigned long addr,
 		unsigned long end, unsigned long floor, unsigned long ceiling);
 int
 copy_page_range(struct vm_area_struct *dst_vma, struct vm_area_struct *src_vma);
+
+struct vma_copy {
+	struct vm_area_struct *dst_vma;
+	struct vm_area_struct *src_vma;
+};
+
+bool copy_page_range_can_defer(struct vm_area_struct *src_vma);
+int copy_page_ranges_parallel(struct vma_copy *vmas, unsigned int nr,
+			      unsigned int nr_threads);
 int generic_access_phys(struct vm_area_struct *vma, unsigned long addr,
 			void *buf, int len, int write);
 
@@ -3529,6 +3553,8 @@ void vma_set_file(struct vm_area_struct *vma, struct file *file);
 #ifdef CONFIG_NUMA_BALANCING
 unsigned long change_prot_numa(struct vm_area_struct *vma,
 			unsigned long start, unsigned long end);
+unsigned long numa_scan_young(struct vm_area_struct *vma,
+			unsigned long start, unsigned long end);
 #endif
 
 struct vm_area_struct *find_extend_vma_locked(struct mm_struct *,
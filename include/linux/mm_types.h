@@ -31,6 +31,7 @@
 
 struct address_space;
 struct mem_cgroup;
+struct futex_private_hash;
 
 /*
  * Each physical page in the system has a struct page associated with
@@ -839,6 +840,13 @@ struct mm_struct {
 		 * cache-line, which needs to be touched by switch_mm().
 		 */
 		atomic_t membarrier_state;
+
+		/**
+		 * @membarrier_seq: Odd while a private expedited membarrier
+		 * IPI round is in flight on this mm, even otherwise. Lets
+		 * concurrent callers share a round.
+		 */
+		unsigned long membarrier_seq;
 #endif
 
 		/**
@@ -894,6 +902,14 @@ struct mm_struct {
 		atomic_long_t pgtables_bytes;	/* size of all page tables */
 #endif
 		int map_count;			/* number of VMAs */
+		/* threads to copy page tables with at fork, 0 or 1 for serial */
+		unsigned int fork_copy_threads;
+		/* freed by a worker once the last task using it exits */
+		bool exit_mm_async;
+#ifdef CONFIG_FUTEX
+		/* private futex hash, NULL for the global one, see PR_FUTEX_HASH */
+		struct futex_private_hash *futex_phash;
+#endif
 
 		spinlock_t page_table_lock; /* Protects page tables and some
 					     * counters
@@ -1001,6 +1017,14 @@ struct mm_struct {
 #if defined(CONFIG_TRANSPARENT_HUGEPAGE) && !defined(CONFIG_SPLIT_PMD_PTLOCKS)
 		pgtable_t pmd_huge_pte; /* protected by page_table_lock */
 #endif
+#ifdef CONFIG_TRANSPARENT_HUGEPAGE
+		/*
+		 * Access feedback on the anonymous mTHPs of this mm, and the
+		 * number of enabled orders anonymous faults step down by.
+		 */
+		atomic_t mthp_anon_score;
+		unsigned int mthp_anon_demote;
+#endif
 #ifdef CONFIG_NUMA_BALANCING
 		/*
 		 * numa_next_scan is the next time that PTEs will be remapped
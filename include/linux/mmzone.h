@@ -476,6 +476,8 @@ struct lru_gen_folio {
 	u8 gen;
 	/* the list segment this lru_gen_folio belongs to */
 	u8 seg;
+	/* whether the background aging was asked to age this lruvec */
+	bool aging_pending;
 	/* per-node lru_gen_folio list for global reclaim */
 	struct hlist_nulls_node list;
 };
@@ -722,6 +724,23 @@ struct per_cpu_pages {
 	struct list_head lists[NR_PCP_LISTS];
 } ____cacheline_aligned_in_smp;
 
+/*
+ * Pages held on behalf of a group of CPUs between their pcp lists and the
+ * buddy free lists of the zone. Pcp refills and drains are served from
+ * here first, so that zone->lock is only taken for the part of a batch a
+ * shard cannot absorb, and the merging of buddies is left to when a shard
+ * runs empty or full.
+ */
+struct zone_shard {
+	spinlock_t lock;	/* Protects the fields below */
+	int count;		/* number of pages in the lists */
+	int high;		/* max number of pages in the lists */
+	unsigned int nr_free[NR_PAGE_ORDERS];	/* blocks per order */
+
+	/* Lists of pages, indexed the same way as the pcp lists */
+	struct list_head lists[NR_PCP_LISTS];
+} ____cacheline_aligned_in_smp;
+
 struct per_cpu_zonestat {
 #ifdef CONFIG_SMP
 	s8 vm_stat_diff[NR_VM_ZONE_STAT_ITEMS];
@@ -866,6 +885,9 @@ struct zone {
 	struct pglist_data	*zone_pgdat;
 	struct per_cpu_pages	__percpu *per_cpu_pageset;
 	struct per_cpu_zonestat	__percpu *per_cpu_zonestats;
+	/* Shards of CPUs sharing pcp spill lists, see struct zone_shard */
+	struct zone_shard	*shards;
+	int			nr_shards;
 	/*
 	 * the high and batch values are copied to individual pagesets for
 	 * faster access
@@ -1311,6 +1333,12 @@ struct memory_failure_stats {
 };
 #endif
 
+/*
+ * Batched promotions are ranked by hint fault latency: bucket i holds folios
+ * with a latency in [2^i - 1, 2^(i + 1) - 1) ms, the last one the rest.
+ */
+#define NUMA_PROMOTE_BUCKETS	10
+
 /*
  * On NUMA machines, each NUMA node would have a pg_data_t to describe
  * it's memory layout. On UMA machines there is a single pglist_data which
@@ -1429,6 +1457,17 @@ typedef struct pglist_data {
 	 * threshold adjustment period
 	 */
 	unsigned long nbp_th_nr_cand;
+	/*
+	 * folios isolated for batched promotion to this node, by hint fault
+	 * latency, see migrate_misplaced_folio_queue()
+	 */
+	spinlock_t promote_lock;
+	struct list_head promote_lists[NUMA_PROMOTE_BUCKETS];
+	unsigned long nr_promote;
+	struct delayed_work promote_work;
+	/* start time in ms, and pages promoted, of the current promote period */
+	unsigned int promote_bw_start;
+	unsigned long promote_bw_nr;
 #endif
 	/* Fields commonly accessed by the page reclaim scanner */
 
@@ -1446,6 +1485,8 @@ typedef struct pglist_data {
 	struct lru_gen_mm_walk mm_walk;
 	/* lru_gen_folio list */
 	struct lru_gen_memcg memcg_lru;
+	/* background aging of the lruvecs of this node */
+	struct work_struct lru_gen_aging;
 #endif
 
 	CACHELINE_PADDING(_pad2_);
@@ -87,6 +87,15 @@ extern void cleanup_module(void);
  */
 #define module_init(x)	__initcall(x);
 
+/**
+ * module_init_parallel() - driver initialization entry point, parallel
+ * @x: function to be run at kernel boot time or module insertion
+ *
+ * Like module_init(), but when built in, @x may run concurrently with
+ * the other device initcalls; see device_initcall_parallel().
+ */
+#define module_init_parallel(x)	device_initcall_parallel(x);
+
 /**
  * module_exit() - driver exit entry point
  * @x: function to be run when driver is removed
@@ -123,6 +132,9 @@ extern void cleanup_module(void);
 #define device_initcall_sync(fn)	module_init(fn)
 #define late_initcall(fn)		module_init(fn)
 #define late_initcall_sync(fn)		module_init(fn)
+#define device_initcall_parallel(fn)	module_init(fn)
+#define late_initcall_parallel(fn)	module_init(fn)
+#define module_init_parallel(fn)	module_init(fn)
 
 #define console_initcall(fn)		module_init(fn)
 
@@ -454,6 +466,9 @@ struct module {
 	const u32 *gpl_crcs;
 	bool using_gplonly_symbols;
 
+	/* Hash table entries for syms and gpl_syms. */
+	struct module_export *exports;
+
 #ifdef CONFIG_MODULE_SIG
 	/* Signature was verified. */
 	bool sig_ok;
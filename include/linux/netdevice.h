@@ -340,10 +340,26 @@ struct gro_list {
 };
 
 /*
- * size of gro hash buckets, must less than bit number of
- * napi_struct::gro_bitmask
+ * Default and maximum number of gro hash buckets. napi_struct::gro_active
+ * has one bit per bucket, napi_struct::gro_bitmask one bit per word of
+ * gro_active, so the maximum must not exceed BITS_PER_LONG squared.
  */
 #define GRO_HASH_BUCKETS	8
+#define GRO_HASH_BUCKETS_MAX	1024
+
+struct napi_gro_stats {
+	u64_stats_t		packets;	/* skbs run through GRO */
+	u64_stats_t		merged;		/* skbs merged into a held skb */
+	u64_stats_t		evicted;	/* held skbs flushed, bucket full */
+	u64_stats_t		overlimit;	/* skbs not held, flow limit hit */
+	struct u64_stats_sync	syncp;
+};
+
+struct napi_poll_stats {
+	u64_stats_t		softirq_ns;	/* time spent polling in softirq */
+	u64_stats_t		threaded_ns;	/* time spent polling in kthread */
+	struct u64_stats_sync	syncp;
+};
 
 /*
  * Structure for per-NAPI config
@@ -352,6 +368,8 @@ struct napi_config {
 	u64 gro_flush_timeout;
 	u64 irq_suspend_timeout;
 	u32 defer_hard_irqs;
+	u32 gro_buckets;
+	u32 gro_flow_limit;
 	unsigned int napi_id;
 };
 
@@ -379,7 +397,14 @@ struct napi_struct {
 	/* CPU on which NAPI has been scheduled for processing */
 	int			list_owner;
 	struct net_device	*dev;
-	struct gro_list		gro_hash[GRO_HASH_BUCKETS];
+	struct gro_list		*gro_hash;
+	unsigned long		*gro_active;
+	u32			gro_hash_mask;
+	u32			gro_count; /* skbs held in gro_hash */
+	struct napi_gro_stats	gro_stats;
+	struct napi_poll_stats	poll_stats;
+	/* consecutive polls counted towards an adaptive mode switch */
+	u32			adaptive_count;
 	struct sk_buff		*skb;
 	struct list_head	rx_list; /* Pending GRO_NORMAL skbs */
 	int			rx_count; /* length of rx_list */
@@ -390,12 +415,19 @@ struct napi_struct {
 	unsigned long		gro_flush_timeout;
 	unsigned long		irq_suspend_timeout;
 	u32			defer_hard_irqs;
+	u32			gro_flow_limit;
 	/* control-path-only fields follow */
 	struct list_head	dev_list;
 	struct hlist_node	napi_hash_node;
 	int			irq;
 	int			index;
 	struct napi_config	*config;
+	/* gro hash size to use from the next napi_enable() on */
+	u32			gro_buckets;
+	/* enum netdev_napi_threaded, applied from the next napi_enable() on */
+	u8			threaded;
+	struct gro_list		gro_hash_inline[GRO_HASH_BUCKETS];
+	unsigned long		gro_active_inline;
 };
 
 enum {
@@ -409,6 +441,7 @@ enum {
 	NAPI_STATE_PREFER_BUSY_POLL,	/* prefer busy-polling over softirq processing*/
 	NAPI_STATE_THREADED,		/* The poll is performed inside its own thread*/
 	NAPI_STATE_SCHED_THREADED,	/* Napi is currently scheduled in threaded mode */
+	NAPI_STATE_THREADED_ADAPTIVE,	/* Switch between softirq and thread by load */
 };
 
 enum {
@@ -422,6 +455,7 @@ enum {
 	NAPIF_STATE_PREFER_BUSY_POLL	= BIT(NAPI_STATE_PREFER_BUSY_POLL),
 	NAPIF_STATE_THREADED		= BIT(NAPI_STATE_THREADED),
 	NAPIF_STATE_SCHED_THREADED	= BIT(NAPI_STATE_SCHED_THREADED),
+	NAPIF_STATE_THREADED_ADAPTIVE	= BIT(NAPI_STATE_THREADED_ADAPTIVE),
 };
 
 enum gro_result {
@@ -1995,6 +2029,8 @@ enum netdev_reg_state {
  *	@change_proto_down: device supports setting carrier via IFLA_PROTO_DOWN
  *	@netns_local: interface can't change network namespaces
  *	@fcoe_mtu:	device supports maximum FCoE MTU, 2158 bytes
+ *	@netmem_tx:	device supports transmitting skbs with net_iov frags,
+ *			and does not DMA-map or unmap them itself
  *
  *	@net_notifier_list:	List of per-net netdev notifier block
  *				that follow this device when it is moved
@@ -2401,6 +2437,7 @@ struct net_device {
 	unsigned long		change_proto_down:1;
 	unsigned long		netns_local:1;
 	unsigned long		fcoe_mtu:1;
+	unsigned long		netmem_tx:1;
 
 	struct list_head	net_notifier_list;
 
@@ -3307,6 +3344,7 @@ u16 dev_pick_tx_zero(struct net_device *dev, struct sk_buff *skb,
 
 int __dev_queue_xmit(struct sk_buff *skb, struct net_device *sb_dev);
 int __dev_direct_xmit(struct sk_buff *skb, u16 queue_id);
+int __dev_direct_xmit_bulk(struct sk_buff **skbs, int n, u16 queue_id);
 
 static inline int dev_queue_xmit(struct sk_buff *skb)
 {
@@ -3425,6 +3463,11 @@ struct softnet_data {
 #endif
 
 	unsigned int		received_rps;
+#ifdef CONFIG_RPS
+	unsigned int		rfs_hit;
+	unsigned int		rfs_miss;
+	unsigned int		rfs_collision;
+#endif
 	bool			in_net_rx_action;
 	bool			in_napi_threaded_poll;
 
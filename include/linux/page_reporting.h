@@ -21,6 +21,11 @@ struct page_reporting_dev_info {
 
 	/* Minimal order of page reporting */
 	unsigned int order;
+
+	/* Adaptive batching state, managed by mm/page_reporting.c */
+	unsigned long delay;
+	unsigned int budget_shift;
+	bool budget_exhausted;
 };
 
 /* Tear-down and bring-up for page reporting devices */
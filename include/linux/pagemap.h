@@ -13,6 +13,7 @@
 #include <linux/uaccess.h>
 #include <linux/gfp.h>
 #include <linux/bitops.h>
+#include <linux/bitfield.h>
 #include <linux/hardirq.h> /* for in_interrupt() */
 #include <linux/hugetlb_inline.h>
 
@@ -1336,6 +1337,15 @@ static inline bool filemap_range_needs_writeback(struct address_space *mapping,
 	return filemap_range_has_writeback(mapping, start_byte, end_byte);
 }
 
+/*
+ * Layout of address_space->ra_history: the window and folio order of the
+ * last sequential readahead on the mapping, and how many times in a row
+ * readahead found the mapping read sequentially.
+ */
+#define RA_HISTORY_SIZE		GENMASK(23, 0)
+#define RA_HISTORY_ORDER	GENMASK(28, 24)
+#define RA_HISTORY_CONF		GENMASK(31, 29)
+
 /**
  * struct readahead_control - Describes a readahead request.
  *
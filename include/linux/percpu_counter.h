@@ -19,6 +19,8 @@
 
 #ifdef CONFIG_SMP
 
+struct percpu_counter_node;
+
 struct percpu_counter {
 	raw_spinlock_t lock;
 	s64 count;
@@ -26,6 +28,10 @@ struct percpu_counter {
 	struct list_head list;	/* All percpu_counters are on a list */
 #endif
 	s32 __percpu *counters;
+#ifdef CONFIG_NUMA
+	/* Per-node sums, see percpu_counter_enable_node_sums() */
+	struct percpu_counter_node **nodes;
+#endif
 };
 
 extern int percpu_counter_batch;
@@ -52,6 +58,17 @@ static inline void percpu_counter_destroy(struct percpu_counter *fbc)
 	percpu_counter_destroy_many(fbc, 1);
 }
 
+#ifdef CONFIG_NUMA
+int percpu_counter_enable_node_sums(struct percpu_counter *fbc, gfp_t gfp);
+s64 __percpu_counter_read_nodes(struct percpu_counter *fbc);
+#else
+static inline int percpu_counter_enable_node_sums(struct percpu_counter *fbc,
+						  gfp_t gfp)
+{
+	return 0;
+}
+#endif
+
 void percpu_counter_set(struct percpu_counter *fbc, s64 amount);
 void percpu_counter_add_batch(struct percpu_counter *fbc, s64 amount,
 			      s32 batch);
@@ -107,6 +124,10 @@ static inline s64 percpu_counter_sum(struct percpu_counter *fbc)
 
 static inline s64 percpu_counter_read(struct percpu_counter *fbc)
 {
+#ifdef CONFIG_NUMA
+	if (unlikely(fbc->nodes))
+		return __percpu_counter_read_nodes(fbc);
+#endif
 	return fbc->count;
 }
 
@@ -117,8 +138,15 @@ static inline s64 percpu_counter_read(struct percpu_counter *fbc)
  */
 static inline s64 percpu_counter_read_positive(struct percpu_counter *fbc)
 {
-	/* Prevent reloads of fbc->count */
-	s64 ret = READ_ONCE(fbc->count);
+	s64 ret;
+
+#ifdef CONFIG_NUMA
+	if (unlikely(fbc->nodes))
+		ret = __percpu_counter_read_nodes(fbc);
+	else
+#endif
+		/* Prevent reloads of fbc->count */
+		ret = READ_ONCE(fbc->count);
 
 	if (ret >= 0)
 		return ret;
@@ -163,6 +191,12 @@ static inline void percpu_counter_destroy(struct percpu_counter *fbc)
 {
 }
 
+static inline int percpu_counter_enable_node_sums(struct percpu_counter *fbc,
+						  gfp_t gfp)
+{
+	return 0;
+}
+
 static inline void percpu_counter_set(struct percpu_counter *fbc, s64 amount)
 {
 	fbc->count = amount;
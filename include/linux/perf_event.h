@@ -1231,6 +1231,7 @@ struct perf_sample_data {
 	 */
 	u64				ip;
 	struct perf_callchain_entry	*callchain;
+	u64				callchain_shared;
 	struct perf_raw_record		*raw;
 	struct perf_branch_stack	*br_stack;
 	u64				*br_stack_cntr;
@@ -1287,6 +1288,12 @@ static inline void perf_sample_save_callchain(struct perf_sample_data *data,
 	data->callchain = perf_callchain(event, regs);
 	size += data->callchain->nr;
 
+	/* Full callchain, unless perf_event_output() finds a reference */
+	if (event->attr.callchain_delta) {
+		data->callchain_shared = PERF_CALLCHAIN_SHARED_NOREF;
+		size++;
+	}
+
 	data->dyn_size += size * sizeof(u64);
 	data->sample_flags |= PERF_SAMPLE_CALLCHAIN;
 }
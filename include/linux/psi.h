@@ -41,6 +41,7 @@ int psi_cgroup_alloc(struct cgroup *cgrp);
 void psi_cgroup_free(struct cgroup *cgrp);
 void cgroup_move_task(struct task_struct *p, struct css_set *to);
 void psi_cgroup_restart(struct psi_group *group);
+void psi_cgroup_set_aggregate(struct cgroup *cgrp, bool aggregate);
 #endif
 
 #else /* CONFIG_PSI */
@@ -160,9 +160,17 @@ struct psi_trigger {
 };
 
 struct psi_group {
+	/* Closest ancestor aggregating this group's state, see below */
 	struct psi_group *parent;
 	bool enabled;
 
+	/*
+	 * When cleared, descendants are not accounted in this group and
+	 * link past it to its own parent, which saves a level of updates
+	 * on every task state change below it.
+	 */
+	bool aggregate;
+
 	/* Protects data used by the aggregator */
 	struct mutex avgs_lock;
 
@@ -138,6 +138,11 @@ void ring_buffer_change_overwrite(struct trace_buffer *buffer, int val);
 struct ring_buffer_event *ring_buffer_lock_reserve(struct trace_buffer *buffer,
 						   unsigned long length);
 int ring_buffer_unlock_commit(struct trace_buffer *buffer);
+int ring_buffer_lock_reserve_batch(struct trace_buffer *buffer,
+				   const unsigned long *lengths,
+				   struct ring_buffer_event **events,
+				   unsigned int nr);
+int ring_buffer_unlock_commit_batch(struct trace_buffer *buffer, unsigned int nr);
 int ring_buffer_write(struct trace_buffer *buffer,
 		      unsigned long length, void *data);
 
@@ -33,6 +33,8 @@
 #include <linux/osq_lock.h>
 #endif
 
+struct rwsem_pcpu;
+
 /*
  * For an uncontended rwsem, count and owner are the only fields a task
  * needs to touch when acquiring the rwsem. So they are put next to each
@@ -64,20 +66,42 @@ struct rw_semaphore {
 #ifdef CONFIG_DEBUG_LOCK_ALLOC
 	struct lockdep_map	dep_map;
 #endif
+#ifdef CONFIG_RWSEM_PERCPU_READERS
+	/* per-CPU reader counts, see rwsem_enable_percpu_readers() */
+	struct rwsem_pcpu	*pcpu;
+#endif
 };
 
 #define RWSEM_UNLOCKED_VALUE		0UL
 #define RWSEM_WRITER_LOCKED		(1UL << 0)
 #define __RWSEM_COUNT_INIT(name)	.count = ATOMIC_LONG_INIT(RWSEM_UNLOCKED_VALUE)
 
+#ifdef CONFIG_RWSEM_PERCPU_READERS
+extern int rwsem_enable_percpu_readers(struct rw_semaphore *sem);
+extern void rwsem_free_percpu_readers(struct rw_semaphore *sem);
+extern bool rwsem_percpu_read_locked(const struct rw_semaphore *sem);
+#else
+static inline int rwsem_enable_percpu_readers(struct rw_semaphore *sem)
+{
+	return 0;
+}
+static inline void rwsem_free_percpu_readers(struct rw_semaphore *sem) { }
+static inline bool rwsem_percpu_read_locked(const struct rw_semaphore *sem)
+{
+	return false;
+}
+#endif
+
 static inline int rwsem_is_locked(struct rw_semaphore *sem)
 {
-	return atomic_long_read(&sem->count) != RWSEM_UNLOCKED_VALUE;
+	return atomic_long_read(&sem->count) != RWSEM_UNLOCKED_VALUE ||
+	       rwsem_percpu_read_locked(sem);
 }
 
 static inline void rwsem_assert_held_nolockdep(const struct rw_semaphore *sem)
 {
-	WARN_ON(atomic_long_read(&sem->count) == RWSEM_UNLOCKED_VALUE);
+	WARN_ON(atomic_long_read(&sem->count) == RWSEM_UNLOCKED_VALUE &&
+		!rwsem_percpu_read_locked(sem));
 }
 
 static inline void rwsem_assert_held_write_nolockdep(const struct rw_semaphore *sem)
@@ -22,6 +22,7 @@
 #include <linux/wait.h>
 
 struct seq_file;
+struct sbq_cache;
 
 /**
  * struct sbitmap_word - Word in a &struct sbitmap.
@@ -149,6 +150,12 @@ struct sbitmap_queue {
 	 * @wakeup_cnt: Number of thread wake ups issued.
 	 */
 	atomic_t wakeup_cnt;
+
+	/**
+	 * @cache: Optional per-cpu caches of free bits, see
+	 * sbitmap_queue_enable_cache().
+	 */
+	struct sbq_cache __percpu *cache;
 };
 
 /**
@@ -425,10 +432,37 @@ int sbitmap_queue_init_node(struct sbitmap_queue *sbq, unsigned int depth,
  */
 static inline void sbitmap_queue_free(struct sbitmap_queue *sbq)
 {
+	free_percpu(sbq->cache);
 	kfree(sbq->ws);
 	sbitmap_free(&sbq->sb);
 }
 
+/**
+ * sbitmap_queue_enable_cache() - Keep per-cpu caches of free bits.
+ * @sbq: Bitmap queue, not yet in use.
+ * @flags: Allocation flags.
+ *
+ * Make __sbitmap_queue_get() and sbitmap_queue_clear() allocate and free bits
+ * through small per-cpu caches, which are refilled from and flushed to the
+ * bitmap in batches. This keeps the cachelines of the bitmap words from
+ * bouncing between CPUs when a deep queue is used by many of them. Bits in a
+ * cache count as allocated in the bitmap. Caches are bypassed and flushed
+ * while there are waiters, and are stolen from before an allocation fails,
+ * so that no bit is kept out of reach. Not for round-robin bitmap queues.
+ *
+ * Return: Zero on success or -ENOMEM, in which case @sbq works without caches.
+ */
+int sbitmap_queue_enable_cache(struct sbitmap_queue *sbq, gfp_t flags);
+
+/**
+ * sbitmap_queue_flush_cache() - Put back the bits of the per-cpu caches.
+ * @sbq: Bitmap queue to flush.
+ *
+ * For users which need the bitmap to only account the bits really in use,
+ * e.g. to wait for them to be freed.
+ */
+void sbitmap_queue_flush_cache(struct sbitmap_queue *sbq);
+
 /**
  * sbitmap_queue_recalculate_wake_batch() - Recalculate wake batch
  * @sbq: Bitmap queue to recalculate wake batch.
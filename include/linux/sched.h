@@ -388,6 +388,12 @@ struct sched_param {
 	int sched_priority;
 };
 
+/*
+ * Runqueue latency histogram buckets, see kernel/sched/stats.c: 4 buckets per
+ * power of two of ~1us units, the last one collecting everything above ~30s.
+ */
+#define SCHED_LAT_NR_BUCKETS		96
+
 struct sched_info {
 #ifdef CONFIG_SCHED_INFO
 	/* Cumulative counters: */
@@ -412,6 +418,11 @@ struct sched_info {
 	/* When were we last queued to run? */
 	unsigned long long		last_queued;
 
+#ifdef CONFIG_SCHED_LATENCY_HIST
+	/* Distribution of the time spent waiting on a runqueue: */
+	unsigned int			run_delay_hist[SCHED_LAT_NR_BUCKETS];
+#endif
+
 #endif /* CONFIG_SCHED_INFO */
 };
 
@@ -1767,6 +1778,7 @@ static __always_inline bool is_percpu_thread(void)
 #define PFA_SPEC_IB_DISABLE		5	/* Indirect branch speculation restricted */
 #define PFA_SPEC_IB_FORCE_DISABLE	6	/* Indirect branch speculation permanently restricted */
 #define PFA_SPEC_SSB_NOEXEC		7	/* Speculative Store Bypass clear on execve() */
+#define PFA_EXEC_HUGE_TEXT		8	/* Map ELF text for huge pages on execve() */
 
 #define TASK_PFA_TEST(name, func)					\
 	static inline bool task_##func(struct task_struct *p)		\
@@ -1809,6 +1821,10 @@ TASK_PFA_CLEAR(SPEC_IB_DISABLE, spec_ib_disable)
 TASK_PFA_TEST(SPEC_IB_FORCE_DISABLE, spec_ib_force_disable)
 TASK_PFA_SET(SPEC_IB_FORCE_DISABLE, spec_ib_force_disable)
 
+TASK_PFA_TEST(EXEC_HUGE_TEXT, exec_huge_text)
+TASK_PFA_SET(EXEC_HUGE_TEXT, exec_huge_text)
+TASK_PFA_CLEAR(EXEC_HUGE_TEXT, exec_huge_text)
+
 static inline void
 current_restore_flags(unsigned long orig_flags, unsigned long flags)
 {
@@ -2217,6 +2233,10 @@ static inline bool owner_on_cpu(struct task_struct *owner)
 	return READ_ONCE(owner->on_cpu) && !vcpu_is_preempted(task_cpu(owner));
 }
 
+/* Hints for optimistic spinning on a lock owner */
+extern bool sched_task_preempt_pending(struct task_struct *p);
+extern u64 sched_cpu_steal_clock(int cpu);
+
 /* Returns effective CPU energy utilization, as seen by the scheduler */
 unsigned long sched_cpu_util(int cpu);
 #endif /* CONFIG_SMP */
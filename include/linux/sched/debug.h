@@ -42,6 +42,11 @@ extern void proc_sched_show_task(struct task_struct *p,
 extern void proc_sched_set_task(struct task_struct *p);
 #endif
 
+#ifdef CONFIG_SCHED_LATENCY_HIST
+struct seq_file;
+extern void proc_sched_lat_show_task(struct task_struct *p, struct seq_file *m);
+#endif
+
 /* Attach to any functions which should be ignored in wchan output. */
 #define __sched		__section(".sched.text")
 
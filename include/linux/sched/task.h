@@ -41,6 +41,10 @@ struct kernel_clone_args {
 	int idle;
 	int (*fn)(void *);
 	void *fn_arg;
+	/* CLONE_SPAWN: the program the child executes */
+	const char __user *exec_path;
+	const void __user *exec_argv;
+	const void __user *exec_envp;
 	struct cgroup *cgrp;
 	struct css_set *cset;
 	unsigned int kill_seq;
@@ -80,10 +80,20 @@ struct sched_group;
 struct sched_domain_shared {
 	atomic_t	ref;
 	atomic_t	nr_busy_cpus;
-	int		has_idle_cores;
 	int		nr_idle_scan;
+	/*
+	 * Cores of the LLC whose SMT siblings are all idle, each one by its
+	 * first sibling. Set at idle entry, cleared at idle exit and when
+	 * found stale by select_idle_cpu().
+	 */
+	unsigned long	idle_cores[];
 };
 
+static inline struct cpumask *sds_idle_cores(struct sched_domain_shared *sds)
+{
+	return to_cpumask(sds->idle_cores);
+}
+
 struct sched_domain {
 	/* These fields must be setup */
 	struct sched_domain __rcu *parent;	/* top domain must be null terminated */
@@ -108,6 +118,8 @@ struct sched_domain {
 	/* idle_balance() stats */
 	u64 max_newidle_lb_cost;
 	unsigned long last_decay_max_lb_cost;
+	/* sched_clock_cpu() until which newidle balance sees no busier group */
+	u64 newidle_balanced_until;
 
 #ifdef CONFIG_SCHEDSTATS
 	/* sched_balance_rq() stats */
@@ -123,6 +135,10 @@ struct sched_domain {
 	unsigned int lb_nobusyg[CPU_MAX_IDLE_TYPES];
 	unsigned int lb_nobusyq[CPU_MAX_IDLE_TYPES];
 
+	/* sched_balance_newidle() stats */
+	unsigned int newidle_lb_skipped;
+	u64 newidle_lb_cost;
+
 	/* Active load balancing */
 	unsigned int alb_count;
 	unsigned int alb_failed;
@@ -166,7 +182,7 @@ static inline struct cpumask *sched_domain_span(struct sched_domain *sd)
 	return to_cpumask(sd->span);
 }
 
-extern void partition_sched_domains_locked(int ndoms_new,
+extern bool partition_sched_domains_locked(int ndoms_new,
 					   cpumask_var_t doms_new[],
 					   struct sched_domain_attr *dattr_new);
 
@@ -210,10 +226,11 @@ extern void __init set_sched_topology(struct sched_domain_topology_level *tl);
 
 struct sched_domain_attr;
 
-static inline void
+static inline bool
 partition_sched_domains_locked(int ndoms_new, cpumask_var_t doms_new[],
 			       struct sched_domain_attr *dattr_new)
 {
+	return false;
 }
 
 static inline void
@@ -331,6 +331,21 @@ struct kmem_cache_args {
 	 * %NULL means no constructor.
 	 */
 	void (*ctor)(void *);
+	/**
+	 * @sheaf_capacity: Enable percpu arrays of objects of this capacity.
+	 *
+	 * With a non-zero value, allocations and frees are served from percpu
+	 * arrays ("sheaves") that are refilled from and flushed to the slabs
+	 * in bulk, and exchanged with a per-node stock of full and empty
+	 * arrays. This suits caches with a high rate of allocations and frees
+	 * on many cpus, at the cost of keeping more objects allocated.
+	 *
+	 * Ignored for caches with debugging enabled. Caches using it are never
+	 * merged.
+	 *
+	 * %0 means no sheaves.
+	 */
+	unsigned int sheaf_capacity;
 };
 
 struct kmem_cache *__kmem_cache_create_args(const char *name,
@@ -105,6 +105,28 @@ static inline void on_each_cpu_cond(smp_cond_func_t cond_func,
 	on_each_cpu_cond_mask(cond_func, func, info, wait, cpu_online_mask);
 }
 
+#define SMP_CALL_BATCH_MAX	8
+
+/*
+ * A batch of synchronous cross calls, delivered with a single IPI per
+ * target CPU, see on_each_cpu_batch_add().
+ */
+struct smp_call_batch {
+	unsigned int nr;
+	struct {
+		smp_call_func_t func;
+		void *info;
+		const struct cpumask *mask;
+	} calls[SMP_CALL_BATCH_MAX];
+};
+
+#define DEFINE_SMP_CALL_BATCH(name)	struct smp_call_batch name = { .nr = 0 }
+
+void on_each_cpu_batch_add(struct smp_call_batch *batch,
+			   const struct cpumask *mask,
+			   smp_call_func_t func, void *info);
+void on_each_cpu_batch_flush(struct smp_call_batch *batch);
+
 /*
  * Architecture specific boot CPU setup.  Defined as empty weak function in
  * init/main.c. Architectures can override it.
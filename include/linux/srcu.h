@@ -344,6 +344,28 @@ static inline int srcu_down_read(struct srcu_struct *ssp) __acquires(ssp)
 	return __srcu_read_lock(ssp);
 }
 
+/**
+ * srcu_down_read_lite - register a new lite reader for an SRCU-protected structure.
+ * @ssp: srcu_struct in which to register the new reader.
+ *
+ * Enter a semaphore-like, light-weight smp_mb()-free SRCU read-side
+ * critical section, see srcu_down_read() and srcu_read_lock_lite() for
+ * more information.  The matching srcu_up_read_lite() can be invoked
+ * from some other context, for example, from some other task or from a
+ * timer handler, as long as RCU is watching in both contexts.  This
+ * suits readers that hold the srcu_struct across a return to user space,
+ * but that are too frequent to afford the smp_mb() of srcu_down_read().
+ *
+ * As with srcu_read_lock_lite(), no other flavor may be used on an
+ * srcu_struct on which srcu_down_read_lite() is ever used.
+ */
+static inline int srcu_down_read_lite(struct srcu_struct *ssp) __acquires(ssp)
+{
+	WARN_ON_ONCE(in_nmi());
+	srcu_check_read_flavor_lite(ssp);
+	return __srcu_read_lock_lite(ssp);
+}
+
 /**
  * srcu_read_unlock - unregister a old reader from an SRCU-protected structure.
  * @ssp: srcu_struct in which to unregister the old reader.
@@ -417,6 +439,23 @@ static inline void srcu_up_read(struct srcu_struct *ssp, int idx)
 	__srcu_read_unlock(ssp, idx);
 }
 
+/**
+ * srcu_up_read_lite - unregister a old lite reader from an SRCU-protected structure.
+ * @ssp: srcu_struct in which to unregister the old reader.
+ * @idx: return value from corresponding srcu_down_read_lite().
+ *
+ * Exit a light-weight SRCU read-side critical section, but not
+ * necessarily from the same context as the maching srcu_down_read_lite().
+ */
+static inline void srcu_up_read_lite(struct srcu_struct *ssp, int idx)
+	__releases(ssp)
+{
+	WARN_ON_ONCE(idx & ~0x1);
+	WARN_ON_ONCE(in_nmi());
+	srcu_check_read_flavor(ssp, SRCU_READ_FLAVOR_LITE);
+	__srcu_read_unlock_lite(ssp, idx);
+}
+
 /**
  * smp_mb__after_srcu_read_unlock - ensure full ordering after srcu_read_unlock
  *
@@ -450,4 +489,9 @@ DEFINE_LOCK_GUARD_1(srcu, struct srcu_struct,
 		    srcu_read_unlock(_T->lock, _T->idx),
 		    int idx)
 
+DEFINE_LOCK_GUARD_1(srcu_lite, struct srcu_struct,
+		    _T->idx = srcu_read_lock_lite(_T->lock),
+		    srcu_read_unlock_lite(_T->lock, _T->idx),
+		    int idx)
+
 #endif
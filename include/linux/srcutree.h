@@ -230,7 +230,8 @@ static inline int __srcu_read_lock_lite(struct srcu_struct *ssp)
  * Removes the count for the old reader from the appropriate
  * per-CPU element of the srcu_struct.  Note that this may well be a
  * different CPU than that which was incremented by the corresponding
- * srcu_read_lock_lite(), but it must be within the same task.
+ * srcu_read_lock_lite().  It must be within the same task, except for
+ * srcu_up_read_lite(), whose caller must merely have RCU watching.
  *
  * Note that this_cpu_inc() is an RCU read-side critical section either
  * because it disables interrupts, because it is a single instruction,
@@ -45,6 +45,10 @@ struct svc_pool {
 	struct percpu_counter	sp_sockets_queued;
 	struct percpu_counter	sp_threads_woken;
 
+	/* for services that size their pools on demand */
+	unsigned int		sp_nrthrmin;	/* # of threads set by admin */
+	unsigned long		sp_starved_at;	/* jiffies, last SP_STARVED */
+
 	unsigned long		sp_flags;
 } ____cacheline_aligned_in_smp;
 
@@ -53,6 +57,7 @@ enum {
 	SP_TASK_PENDING,	/* still work to do even if no xprt is queued */
 	SP_NEED_VICTIM,		/* One thread needs to agree to exit */
 	SP_VICTIM_REMAINS,	/* One thread needs to actually exit */
+	SP_STARVED,		/* work was queued with no idle thread */
 };
 
 
@@ -263,6 +263,7 @@ struct rpc_xprt {
 
 	struct list_head	xmit_queue;	/* Send queue */
 	atomic_long_t		xmit_queuelen;
+	unsigned long		srtt_us;	/* smoothed reply latency */
 
 	struct svc_xprt		*bc_xprt;	/* NFSv4.1 backchannel */
 #if defined(CONFIG_SUNRPC_BACKCHANNEL)
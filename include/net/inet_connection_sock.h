@@ -212,6 +212,24 @@ static inline void inet_csk_clear_xmit_timer(struct sock *sk, const int what)
 	}
 }
 
+/* Arm @timer for @expires. With net.ipv4.tcp_timer_coalesce, a timer that is
+ * already pending and due no later than @expires is left alone: the handlers
+ * find that the deadline moved (icsk_timeout, icsk_ack.timeout) and re-arm
+ * then. Pushing the RTO or delayed ACK back on every segment then costs no
+ * timer base locking, at most one early expiry per timeout period.
+ */
+static inline void inet_csk_reset_timer(struct sock *sk,
+					struct timer_list *timer,
+					unsigned long expires)
+{
+	if (READ_ONCE(sock_net(sk)->ipv4.sysctl_tcp_timer_coalesce) &&
+	    timer_pending(timer) &&
+	    !time_after(READ_ONCE(timer->expires), expires))
+		return;
+
+	sk_reset_timer(sk, timer, expires);
+}
+
 /*
  *	Reset the retransmission timer
  */
@@ -231,12 +249,14 @@ static inline void inet_csk_reset_xmit_timer(struct sock *sk, const int what,
 	    what == ICSK_TIME_LOSS_PROBE || what == ICSK_TIME_REO_TIMEOUT) {
 		smp_store_release(&icsk->icsk_pending, what);
 		icsk->icsk_timeout = jiffies + when;
-		sk_reset_timer(sk, &icsk->icsk_retransmit_timer, icsk->icsk_timeout);
+		inet_csk_reset_timer(sk, &icsk->icsk_retransmit_timer,
+				     icsk->icsk_timeout);
 	} else if (what == ICSK_TIME_DACK) {
 		smp_store_release(&icsk->icsk_ack.pending,
 				  icsk->icsk_ack.pending | ICSK_ACK_TIMER);
 		icsk->icsk_ack.timeout = jiffies + when;
-		sk_reset_timer(sk, &icsk->icsk_delack_timer, icsk->icsk_ack.timeout);
+		inet_csk_reset_timer(sk, &icsk->icsk_delack_timer,
+				     icsk->icsk_ack.timeout);
 	} else {
 		pr_debug("inet_csk BUG: unknown timer value\n");
 	}
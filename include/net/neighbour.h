@@ -131,9 +131,12 @@ struct neigh_statistics {
 
 	unsigned long unres_discards;	/* number of unresolved drops */
 	unsigned long table_fulls;      /* times even gc couldn't help */
+	unsigned long unres_failed;	/* queued drops on failed resolution */
 };
 
 #define NEIGH_CACHE_STAT_INC(tbl, field) this_cpu_inc((tbl)->stats->field)
+#define NEIGH_CACHE_STAT_ADD(tbl, field, val) \
+	this_cpu_add((tbl)->stats->field, val)
 
 struct neighbour {
 	struct hlist_node	hash;
@@ -224,6 +227,7 @@ struct neigh_table {
 	int			gc_thresh3;
 	unsigned long		last_flush;
 	struct delayed_work	gc_work;
+	unsigned int		gc_bucket;
 	struct delayed_work	managed_work;
 	struct timer_list 	proxy_timer;
 	struct sk_buff_head	proxy_queue;
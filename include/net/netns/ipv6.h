@@ -11,6 +11,7 @@
 #include <uapi/linux/icmpv6.h>
 
 struct ctl_table_header;
+struct rt6_pcpu_cache;
 
 struct netns_sysctl_ipv6 {
 #ifdef CONFIG_SYSCTL
@@ -54,6 +55,7 @@ struct netns_sysctl_ipv6 {
 	u32 ioam6_id;
 	u64 ioam6_id_wide;
 	u8 skip_notify_on_dev_down;
+	u8 ip6_rt_pcpu_cache;
 	u8 fib_notify_on_flag_change;
 	u8 icmpv6_error_anycast_as_unicast;
 };
@@ -109,6 +111,7 @@ struct netns_ipv6 {
 #endif
 	atomic_t		dev_addr_genid;
 	atomic_t		fib6_sernum;
+	struct rt6_pcpu_cache __percpu *rt6_pcpu_cache;
 	struct seg6_pernet_data *seg6_data;
 	struct fib_notifier_ops	*notifier_ops;
 	struct fib_notifier_ops	*ip6mr_notifier_ops;
@@ -179,16 +179,36 @@ struct fastopen_queue {
 	struct tcp_fastopen_context __rcu *ctx; /* cipher context for cookie */
 };
 
+/* Optional per-CPU accept queues of a listener (TCP_ACCEPT_PERCPU).
+ * Children are queued on the CPU which completed the handshake, accept()
+ * dequeues from the local CPU first and steals from the others when that
+ * queue is empty, without taking the listener lock.
+ */
+struct request_sock_pcpu_queue {
+	spinlock_t		lock;
+	struct request_sock	*head;
+	struct request_sock	*tail;
+};
+
+struct request_sock_pcpu {
+	struct request_sock_pcpu_queue __percpu *q;
+	struct rcu_head		rcu;
+};
+
 /** struct request_sock_queue - queue of request_socks
  *
  * @rskq_accept_head - FIFO head of established children
  * @rskq_accept_tail - FIFO tail of established children
  * @rskq_defer_accept - User waits for some data after accept()
+ * @rskq_pcpu_accept - Use per-CPU accept queues from the next listen() on
+ * @rskq_pcpu_len - Children queued on the per-CPU accept queues
+ * @rskq_pcpu - Per-CPU accept queues, while listening
  *
  */
 struct request_sock_queue {
 	spinlock_t		rskq_lock;
 	u8			rskq_defer_accept;
+	u8			rskq_pcpu_accept;
 
 	u32			synflood_warned;
 	atomic_t		qlen;
@@ -196,19 +216,25 @@ struct request_sock_queue {
 
 	struct request_sock	*rskq_accept_head;
 	struct request_sock	*rskq_accept_tail;
+	atomic_t		rskq_pcpu_len;
+	struct request_sock_pcpu __rcu *rskq_pcpu;
 	struct fastopen_queue	fastopenq;  /* Check max_qlen != 0 to determine
 					     * if TFO is enabled.
 					     */
 };
 
-void reqsk_queue_alloc(struct request_sock_queue *queue);
+int reqsk_queue_alloc(struct request_sock_queue *queue);
+void reqsk_queue_free(struct request_sock_queue *queue);
+struct request_sock *reqsk_queue_pcpu_remove(struct request_sock_queue *queue,
+					     struct sock *parent);
 
 void reqsk_fastopen_remove(struct sock *sk, struct request_sock *req,
 			   bool reset);
 
 static inline bool reqsk_queue_empty(const struct request_sock_queue *queue)
 {
-	return READ_ONCE(queue->rskq_accept_head) == NULL;
+	return READ_ONCE(queue->rskq_accept_head) == NULL &&
+	       !atomic_read(&queue->rskq_pcpu_len);
 }
 
 static inline struct request_sock *reqsk_queue_remove(struct request_sock_queue *queue,
@@ -216,6 +242,9 @@ static inline struct request_sock *reqsk_queue_remove(struct request_sock_queue
 {
 	struct request_sock *req;
 
+	if (rcu_access_pointer(queue->rskq_pcpu))
+		return reqsk_queue_pcpu_remove(queue, parent);
+
 	spin_lock_bh(&queue->rskq_lock);
 	req = queue->rskq_accept_head;
 	if (req) {
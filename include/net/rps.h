@@ -49,15 +49,22 @@ struct rps_dev_flow_table {
 /*
  * The rps_sock_flow_table contains mappings of flows to the last CPU
  * on which they were processed by the application (set in recvmsg).
- * Each entry is a 32bit value. Upper part is the high-order bits
- * of flow hash, lower part is CPU number.
+ * It is organised in buckets of RPS_SOCK_FLOW_WAYS entries, selected by
+ * the low-order bits of the flow hash, so that flows hashing to the same
+ * bucket do not overwrite each other.
+ * Each entry is a 32bit value. Upper part is a tag made of the flow hash
+ * bits not used to select the bucket, lower part is CPU number.
  * rps_cpu_mask is used to partition the space, depending on number of
  * possible CPUs : rps_cpu_mask = roundup_pow_of_two(nr_cpu_ids) - 1
  * For example, if 64 CPUs are possible, rps_cpu_mask = 0x3f,
- * meaning we use 32-6=26 bits for the hash.
+ * meaning we use up to 32-6=26 bits for the tag.
  */
+#define RPS_SOCK_FLOW_WAYS	4
+
 struct rps_sock_flow_table {
-	u32	mask;
+	u32	mask;		/* number of buckets - 1 */
+	u8	hash_shift;	/* ilog2(number of buckets) */
+	u8	cpu_bits;	/* ilog2(rps_cpu_mask + 1) */
 
 	u32	ents[] ____cacheline_aligned_in_smp;
 };
@@ -65,20 +72,43 @@ struct rps_sock_flow_table {
 
 #define RPS_NO_CPU 0xffff
 
+static inline u32 rps_sock_flow_tag(const struct rps_sock_flow_table *table,
+				    u32 hash)
+{
+	return (hash >> table->hash_shift) << table->cpu_bits;
+}
+
 static inline void rps_record_sock_flow(struct rps_sock_flow_table *table,
 					u32 hash)
 {
-	unsigned int index = hash & table->mask;
-	u32 val = hash & ~net_hotdata.rps_cpu_mask;
+	u32 *bucket = &table->ents[(hash & table->mask) * RPS_SOCK_FLOW_WAYS];
+	u32 tag = rps_sock_flow_tag(table, hash);
+	u32 val, ent;
+	int i, slot = -1;
 
 	/* We only give a hint, preemption can change CPU under us */
-	val |= raw_smp_processor_id();
+	val = tag | raw_smp_processor_id();
 
 	/* The following WRITE_ONCE() is paired with the READ_ONCE()
 	 * here, and another one in get_rps_cpu().
 	 */
-	if (READ_ONCE(table->ents[index]) != val)
-		WRITE_ONCE(table->ents[index], val);
+	for (i = 0; i < RPS_SOCK_FLOW_WAYS; i++) {
+		ent = READ_ONCE(bucket[i]);
+		if ((ent & ~net_hotdata.rps_cpu_mask) == tag) {
+			if (ent != val)
+				WRITE_ONCE(bucket[i], val);
+			return;
+		}
+		if (ent == RPS_NO_CPU && slot < 0)
+			slot = i;
+	}
+
+	if (slot < 0) {
+		/* bucket is full, evict one of the other flows */
+		this_cpu_inc(softnet_data.rfs_collision);
+		slot = (hash >> table->hash_shift) & (RPS_SOCK_FLOW_WAYS - 1);
+	}
+	WRITE_ONCE(bucket[slot], val);
 }
 
 #endif /* CONFIG_RPS */
@@ -1027,6 +1027,15 @@ static inline void sk_acceptq_added(struct sock *sk)
 	WRITE_ONCE(sk->sk_ack_backlog, sk->sk_ack_backlog + 1);
 }
 
+/* For accept queues which are not serialized by a single lock */
+static inline void sk_acceptq_update_atomic(struct sock *sk, int delta)
+{
+	u32 old = READ_ONCE(sk->sk_ack_backlog);
+
+	while (!try_cmpxchg(&sk->sk_ack_backlog, &old, old + delta))
+		;
+}
+
 /* Note: If you think the test should be:
  *	return READ_ONCE(sk->sk_ack_backlog) >= READ_ONCE(sk->sk_max_ack_backlog);
  * Then please take a look at commit 64a146513f8f ("[NET]: Revert incorrect accept queue backlog changes.")
@@ -1823,6 +1832,7 @@ struct sockcm_cookie {
 	u32 tsflags;
 	u32 ts_opt_id;
 	u32 priority;
+	u32 dmabuf_id;
 };
 
 static inline void sockcm_init(struct sockcm_cookie *sockc,
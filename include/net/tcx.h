@@ -46,6 +46,15 @@ static inline struct tcx_link *tcx_link(const struct bpf_link *link)
 void tcx_inc(void);
 void tcx_dec(void);
 
+/* Progs attached to tcx hooks are called through this dispatcher */
+DECLARE_BPF_DISPATCHER(tcx)
+
+static inline void tcx_dispatcher_change(struct bpf_prog *from,
+					 struct bpf_prog *to)
+{
+	bpf_dispatcher_change_prog(BPF_DISPATCHER_PTR(tcx), from, to);
+}
+
 static inline void tcx_entry_sync(void)
 {
 	/* bpf_mprog_entry got a/b swapped, therefore ensure that
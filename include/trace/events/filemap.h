@@ -8,6 +8,7 @@
 #include <linux/types.h>
 #include <linux/tracepoint.h>
 #include <linux/mm.h>
+#include <linux/pagemap.h>
 #include <linux/memcontrol.h>
 #include <linux/device.h>
 #include <linux/kdev_t.h>
@@ -196,6 +197,39 @@ TRACE_EVENT(file_check_and_advance_wb_err,
 			MINOR(__entry->s_dev), __entry->i_ino, __entry->old,
 			__entry->new)
 );
+
+TRACE_EVENT(mm_filemap_ra_history,
+		TP_PROTO(struct address_space *mapping, pgoff_t index,
+			 unsigned int history),
+
+		TP_ARGS(mapping, index, history),
+
+		TP_STRUCT__entry(
+			__field(unsigned long, i_ino)
+			__field(dev_t, s_dev)
+			__field(pgoff_t, index)
+			__field(unsigned int, size)
+			__field(unsigned int, order)
+			__field(unsigned int, confidence)
+		),
+
+		TP_fast_assign(
+			__entry->i_ino = mapping->host->i_ino;
+			if (mapping->host->i_sb)
+				__entry->s_dev = mapping->host->i_sb->s_dev;
+			else
+				__entry->s_dev = mapping->host->i_rdev;
+			__entry->index = index;
+			__entry->size = FIELD_GET(RA_HISTORY_SIZE, history);
+			__entry->order = FIELD_GET(RA_HISTORY_ORDER, history);
+			__entry->confidence = FIELD_GET(RA_HISTORY_CONF, history);
+		),
+
+		TP_printk("dev=%d:%d ino=0x%lx index=%lu size=%u order=%u confidence=%u",
+			MAJOR(__entry->s_dev), MINOR(__entry->s_dev),
+			__entry->i_ino, __entry->index, __entry->size,
+			__entry->order, __entry->confidence)
+);
 #endif /* _TRACE_FILEMAP_H */
 
 /* This part must be outside protection */
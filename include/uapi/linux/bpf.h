@@ -1010,6 +1010,8 @@ enum bpf_map_type {
 	BPF_MAP_TYPE_USER_RINGBUF,
 	BPF_MAP_TYPE_CGRP_STORAGE,
 	BPF_MAP_TYPE_ARENA,
+	BPF_MAP_TYPE_RHASH,
+	BPF_MAP_TYPE_PERCPU_RINGBUF,
 	__MAX_BPF_MAP_TYPE
 };
 
@@ -463,6 +463,9 @@ typedef struct elf64_shdr {
 /* Note types with note name "GNU" */
 #define NT_GNU_PROPERTY_TYPE_0	5
 
+/* Note types with note name "Linux" in PT_NOTE segments of executables */
+#define NT_LINUX_HUGE_TEXT	0x100	/* Map large text for huge pages, see PR_SET_EXEC_HUGE_TEXT */
+
 /* Note header in a PT_NOTE section */
 typedef struct elf32_note {
   Elf32_Word	n_namesz;	/* Name size */
@@ -413,6 +413,7 @@ struct pm_scan_arg {
 
 /* /proc/<pid>/maps ioctl */
 #define PROCMAP_QUERY	_IOWR(PROCFS_IOCTL_MAGIC, 17, struct procmap_query)
+#define PROCMAP_STATS	_IOWR(PROCFS_IOCTL_MAGIC, 18, struct procmap_stats)
 
 enum procmap_query_flags {
 	/*
@@ -565,4 +566,41 @@ struct procmap_query {
 	__u64 build_id_addr;		/* in */
 };
 
+/*
+ * Memory usage totals of the VMAs intersecting [start, end), as reported by
+ * /proc/<pid>/smaps_rollup but in binary form. All sizes are in bytes.
+ *
+ * At most max_vmas VMAs (PROCMAP_STATS_MAX_VMAS if zero or larger) are
+ * walked per call. walk_end is set to the address the walk stopped at, equal
+ * to end once the range was covered; call again with start = walk_end to
+ * continue, accumulating the totals in user space.
+ */
+#define PROCMAP_STATS_MAX_VMAS	1024
+
+struct procmap_stats {
+	/* Argument struct size, for backwards/forward compatibility */
+	__u64 size;
+	/* Must be zero */
+	__u64 flags;			/* in */
+	__u64 start;			/* in */
+	__u64 end;			/* in */
+	__u64 max_vmas;			/* in */
+	__u64 walk_end;			/* out */
+	__u64 nr_vmas;			/* out */
+	__u64 rss;			/* out */
+	__u64 pss;			/* out */
+	__u64 pss_anon;			/* out */
+	__u64 pss_file;			/* out */
+	__u64 pss_shmem;		/* out */
+	__u64 pss_dirty;		/* out */
+	__u64 anonymous;		/* out */
+	__u64 anon_thp;			/* out */
+	__u64 shmem_thp;		/* out */
+	__u64 file_thp;			/* out */
+	__u64 swap;			/* out */
+	__u64 swap_pss;			/* out */
+	__u64 shared_hugetlb;		/* out */
+	__u64 private_hugetlb;		/* out */
+};
+
 #endif /* _UAPI_LINUX_FS_H */
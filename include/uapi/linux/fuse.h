@@ -229,6 +229,9 @@
  *    - FUSE_URING_IN_OUT_HEADER_SZ
  *    - FUSE_URING_OP_IN_OUT_SZ
  *    - enum fuse_uring_cmd
+ *
+ *  7.43
+ *  - add FUSE_BACKING_ATTR backing map flag
  */
 
 #ifndef _LINUX_FUSE_H
@@ -264,7 +267,7 @@
 #define FUSE_KERNEL_VERSION 7
 
 /** Minor version number of this interface */
-#define FUSE_KERNEL_MINOR_VERSION 42
+#define FUSE_KERNEL_MINOR_VERSION 43
 
 /** The node ID of the root inode */
 #define FUSE_ROOT_ID 1
@@ -1104,6 +1107,14 @@ struct fuse_notify_retrieve_in {
 	uint64_t	dummy4;
 };
 
+/**
+ * fuse_backing_map flags
+ *
+ * FUSE_BACKING_ATTR: take size, blocks and timestamps of inodes in
+ *		      passthrough mode from the backing file on getattr
+ */
+#define FUSE_BACKING_ATTR	(1 << 0)
+
 struct fuse_backing_map {
 	int32_t		fd;
 	uint32_t	flags;
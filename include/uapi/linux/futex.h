@@ -71,6 +71,13 @@
 
 #define FUTEX2_SIZE_MASK	0x03
 
+/*
+ * A FUTEX2_NUMA futex is made of two words of the futex size, the value and
+ * the node whose hash table it is queued on. FUTEX_NO_NODE in the node word
+ * lets the kernel store the node of the first task using the futex there.
+ */
+#define FUTEX_NO_NODE		(-1)
+
 /* do not use */
 #define FUTEX_32		FUTEX2_SIZE_U32 /* historical accident :-( */
 
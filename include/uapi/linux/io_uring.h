@@ -87,6 +87,7 @@ struct io_uring_sqe {
 	union {
 		__s32	splice_fd_in;
 		__u32	file_index;
+		__u32	zcrx_ifq_idx;
 		__u32	optlen;
 		struct {
 			__u16	addr_len;
@@ -219,6 +220,13 @@ enum io_uring_sqe_flags_bit {
 /* Use hybrid poll in iopoll process */
 #define IORING_SETUP_HYBRID_IOPOLL	(1U << 17)
 
+/*
+ * Keep relative CLOCK_MONOTONIC timeouts and linked timeouts on a per-ring
+ * timer wheel with jiffy resolution instead of a hrtimer each. They may
+ * fire up to a jiffy late, and expire in batches.
+ */
+#define IORING_SETUP_COARSE_TIMEOUTS	(1U << 18)
+
 enum io_uring_op {
 	IORING_OP_NOP,
 	IORING_OP_READV,
@@ -278,6 +286,10 @@ enum io_uring_op {
 	IORING_OP_FTRUNCATE,
 	IORING_OP_BIND,
 	IORING_OP_LISTEN,
+	IORING_OP_RECV_ZC,
+	IORING_OP_EPOLL_WAIT,
+	IORING_OP_READV_FIXED,
+	IORING_OP_WRITEV_FIXED,
 
 	/* this goes last, obviously */
 	IORING_OP_LAST,
@@ -364,7 +376,8 @@ enum io_uring_op {
  *				CQEs on behalf of the same SQE.
  *
  * IORING_RECVSEND_FIXED_BUF	Use registered buffers, the index is stored in
- *				the buf_index field.
+ *				the buf_index field. For SENDMSG_ZC every
+ *				msg_iov entry must point into that buffer.
  *
  * IORING_SEND_ZC_REPORT_USAGE
  *				If set, SEND[MSG]_ZC should report
@@ -404,6 +417,15 @@ enum io_uring_op {
 #define IORING_ACCEPT_DONTWAIT	(1U << 1)
 #define IORING_ACCEPT_POLL_FIRST	(1U << 2)
 
+/*
+ * IORING_OP_EPOLL_WAIT flags stored in sqe->ioprio
+ *
+ * IORING_EPOLL_WAIT_MULTISHOT	Keep reaping ready events for as long as the
+ *				request stays armed. Requires provided
+ *				buffers, each CQE consumes one buffer.
+ */
+#define IORING_EPOLL_WAIT_MULTISHOT	(1U << 0)
+
 /*
  * IORING_OP_MSG_RING command types, stored in sqe->addr
  */
@@ -421,6 +443,17 @@ enum io_uring_msg_ring_flags {
 #define IORING_MSG_RING_CQE_SKIP	(1U << 0)
 /* Pass through the flags from sqe->file_index to cqe->flags */
 #define IORING_MSG_RING_FLAGS_PASS	(1U << 1)
+/*
+ * IORING_MSG_RING_MULTI	IORING_MSG_DATA only. Besides the sqe->fd ring,
+ *				also post the message to each ring in the
+ *				array of __u32 ring fds at sqe->addr3, holding
+ *				sqe->ioprio entries. The result is the number
+ *				of rings the message was posted to.
+ * IORING_MSG_RING_MULTI_REG	The sqe->addr3 array holds indexes of rings
+ *				registered with IORING_REGISTER_RING_FDS.
+ */
+#define IORING_MSG_RING_MULTI		(1U << 2)
+#define IORING_MSG_RING_MULTI_REG	(1U << 3)
 
 /*
  * IORING_OP_FIXED_FD_INSTALL flags (sqe->install_fd_flags)
@@ -639,13 +672,23 @@ enum io_uring_register_op {
 	/* send MSG_RING without having a ring */
 	IORING_REGISTER_SEND_MSG_RING		= 31,
 
-	/* 32 reserved for zc rx */
+	/* register a netdev hw rx queue for zerocopy */
+	IORING_REGISTER_ZCRX_IFQ		= 32,
 
 	/* resize CQ ring */
 	IORING_REGISTER_RESIZE_RINGS		= 33,
 
 	IORING_REGISTER_MEM_REGION		= 34,
 
+	/* set the share of a shared SQPOLL thread this ring gets */
+	IORING_REGISTER_SQPOLL_WEIGHT		= 35,
+
+	/* group buffer rings of different buffer sizes under one bgid */
+	IORING_REGISTER_PBUF_CLASSES		= 36,
+
+	/* enable (nr_args 1) or disable (0) per-opcode stats in fdinfo */
+	IORING_REGISTER_OP_STATS		= 37,
+
 	/* this goes last */
 	IORING_REGISTER_LAST,
 
@@ -824,6 +867,31 @@ struct io_uring_buf_reg {
 	__u64	resv[3];
 };
 
+#define IORING_MAX_BUF_CLASSES	8
+
+struct io_uring_buf_class {
+	__u32	buf_size;	/* size of the buffers in this ring */
+	__u16	bgid;		/* registered buffer ring */
+	__u16	resv;
+};
+
+/*
+ * Argument for IORING_REGISTER_PBUF_CLASSES. Creates buffer group @bgid out
+ * of @nr_classes already registered buffer rings, given in increasing order
+ * of buffer size. Selecting a buffer from @bgid picks the ring with the
+ * smallest buffers that fit the expected transfer size. The CQE carries only
+ * the buffer ID, so applications should use disjoint buffer ID ranges in the
+ * member rings. The group is removed with IORING_UNREGISTER_PBUF_RING, which
+ * must happen before any of its member rings can be unregistered.
+ */
+struct io_uring_buf_classes_reg {
+	__u64	classes;	/* pointer to struct io_uring_buf_class array */
+	__u16	nr_classes;
+	__u16	bgid;
+	__u32	flags;
+	__u64	resv[2];
+};
+
 /* argument for IORING_REGISTER_PBUF_STATUS */
 struct io_uring_buf_status {
 	__u32	buf_group;	/* input */
@@ -847,6 +915,19 @@ enum io_uring_napi_tracking_strategy {
 	IO_URING_NAPI_TRACKING_INACTIVE = 255
 };
 
+/*
+ * io_uring_napi->flags, for IO_URING_NAPI_REGISTER_OP
+ *
+ * IO_URING_NAPI_ADAPTIVE	Treat busy_poll_to as an upper bound, and size
+ *				each busy poll window from the recent CQE
+ *				arrival rate, shrinking it while polls keep
+ *				coming up empty. With prefer_busy_poll set,
+ *				device irqs are suspended while busy polling
+ *				keeps finding completions, see
+ *				irq-suspend-timeout.
+ */
+#define IO_URING_NAPI_ADAPTIVE		(1U << 0)
+
 /* argument for IORING_(UN)REGISTER_NAPI */
 struct io_uring_napi {
 	__u32	busy_poll_to;
@@ -864,7 +945,7 @@ struct io_uring_napi {
 	 * it is the napi id to add/del from napi_list.
 	 */
 	__u32	op_param;
-	__u32	resv;
+	__u32	flags;
 };
 
 /*
@@ -946,6 +1027,55 @@ struct io_uring_recvmsg_out {
 	__u32 flags;
 };
 
+/* Zero copy receive refill queue entry */
+struct io_uring_zcrx_rqe {
+	__u64	off;
+	__u32	len;
+	__u32	__pad;
+};
+
+struct io_uring_zcrx_cqe {
+	__u64	off;
+	__u64	__pad;
+};
+
+/* The bit from which area id is encoded into offsets */
+#define IORING_ZCRX_AREA_SHIFT	48
+#define IORING_ZCRX_AREA_MASK	(~(((__u64)1 << IORING_ZCRX_AREA_SHIFT) - 1))
+
+struct io_uring_zcrx_offsets {
+	__u32	head;
+	__u32	tail;
+	__u32	rqes;
+	__u32	__resv2;
+	__u64	__resv[2];
+};
+
+struct io_uring_zcrx_area_reg {
+	__u64	addr;
+	__u64	len;
+	__u64	rq_area_token;
+	__u32	flags;
+	__u32	__resv1;
+	__u64	__resv2[2];
+};
+
+/*
+ * Argument for IORING_REGISTER_ZCRX_IFQ
+ */
+struct io_uring_zcrx_ifq_reg {
+	__u32	if_idx;
+	__u32	if_rxq;
+	__u32	rq_entries;
+	__u32	flags;
+
+	__u64	area_ptr; /* pointer to struct io_uring_zcrx_area_reg */
+	__u64	region_ptr; /* struct io_uring_region_desc * */
+
+	struct io_uring_zcrx_offsets offsets;
+	__u64	__resv[4];
+};
+
 /*
  * Argument for IORING_OP_URING_CMD when file is a socket
  */
@@ -138,6 +138,8 @@ struct ndt_stats {
 	__u64		ndts_periodic_gc_runs;
 	__u64		ndts_forced_gc_runs;
 	__u64		ndts_table_fulls;
+	__u64		ndts_unres_discards;
+	__u64		ndts_unres_failed;
 };
 
 enum {
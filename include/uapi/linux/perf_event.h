@@ -460,7 +460,8 @@ struct perf_event_attr {
 				inherit_thread :  1, /* children only inherit if cloned with CLONE_THREAD */
 				remove_on_exec :  1, /* event is removed from task on exec */
 				sigtrap        :  1, /* send synchronous SIGTRAP on event */
-				__reserved_1   : 26;
+				callchain_delta:  1, /* callchain relative to the previous sample */
+				__reserved_1   : 25;
 
 	union {
 		__u32		wakeup_events;	  /* wakeup every n events */
@@ -979,6 +980,15 @@ enum perf_event_type {
 	 *	  u64			ips[nr];  } && PERF_SAMPLE_CALLCHAIN
 	 *
 	 *	#
+	 *	# With attr.callchain_delta the callchain is instead written
+	 *	# as below, where the last @shared entries of ips[] are those
+	 *	# of the reference callchain, see PERF_CALLCHAIN_SHARED_NOREF.
+	 *	#
+	 *	{ u64			nr,
+	 *	  u64			shared,
+	 *	  u64			ips[nr - shared]; } && PERF_SAMPLE_CALLCHAIN
+	 *
+	 *	#
 	 *	# The RAW record below is opaque data wrt the ABI
 	 *	#
 	 *	# That is, the ABI doesn't make any promises wrt to
@@ -1264,6 +1274,13 @@ enum perf_callchain_context {
 	PERF_CONTEXT_MAX		= (__u64)-4095,
 };
 
+/*
+ * attr.callchain_delta: the reference callchain of a sample is the callchain
+ * of the previous sample on the same CPU that did not have this bit set in
+ * its @shared word. The first sample on a CPU has no reference and @shared 0.
+ */
+#define PERF_CALLCHAIN_SHARED_NOREF	(1ULL << 63)
+
 /**
  * PERF_RECORD_AUX::flags bits
  */
@@ -353,4 +353,35 @@ struct prctl_mm_map {
  */
 #define PR_LOCK_SHADOW_STACK_STATUS      76
 
+/*
+ * Number of threads fork() may use to copy the page tables of large
+ * private mappings of this process. 0 or 1 copies them serially.
+ */
+#define PR_SET_FORK_COPY_THREADS	77
+#define PR_GET_FORK_COPY_THREADS	78
+
+/*
+ * Free the address space from a background worker once the last task using
+ * it exits, instead of in that task.
+ */
+#define PR_SET_EXIT_MM_ASYNC		79
+#define PR_GET_EXIT_MM_ASYNC		80
+
+/*
+ * Hash private futexes of this process into a table of its own rather than
+ * into the system wide one. Only possible while the process is single
+ * threaded; 0 slots goes back to the global table.
+ */
+#define PR_FUTEX_HASH			81
+# define PR_FUTEX_HASH_SET_SLOTS	1
+# define PR_FUTEX_HASH_GET_SLOTS	2
+
+/*
+ * Map large executable ELF segments of programs executed from now on at
+ * PMD aligned addresses and prefault them, so that their text can be mapped
+ * with huge pages. Inherited across fork() and execve().
+ */
+#define PR_SET_EXEC_HUGE_TEXT		82
+#define PR_GET_EXEC_HUGE_TEXT		83
+
 #endif /* _LINUX_PRCTL_H */
@@ -36,6 +36,7 @@
 /* Flags for the clone3() syscall. */
 #define CLONE_CLEAR_SIGHAND 0x100000000ULL /* Clear any signal handler and reset to SIG_DFL. */
 #define CLONE_INTO_CGROUP 0x200000000ULL /* Clone into a specific cgroup given the right permissions. */
+#define CLONE_SPAWN 0x400000000ULL /* Execute a program in the child without duplicating the mm. */
 
 /*
  * cloning flags intersect with CSIGNAL so can be used with unshare and clone3
@@ -84,6 +85,12 @@
  *                kernel's limit of nested PID namespaces.
  * @cgroup:       If CLONE_INTO_CGROUP is specified set this to
  *                a file descriptor for the cgroup.
+ * @exec_path:    If CLONE_SPAWN is specified, the path of the
+ *                program the child executes.
+ * @exec_argv:    If CLONE_SPAWN is specified, the argument vector
+ *                of the program, as for execve().
+ * @exec_envp:    If CLONE_SPAWN is specified, the environment of
+ *                the program, as for execve().
  *
  * The structure is versioned by size and thus extensible.
  * New struct members must go at the end of the struct and
@@ -101,12 +108,16 @@ struct clone_args {
 	__aligned_u64 set_tid;
 	__aligned_u64 set_tid_size;
 	__aligned_u64 cgroup;
+	__aligned_u64 exec_path;
+	__aligned_u64 exec_argv;
+	__aligned_u64 exec_envp;
 };
 #endif
 
 #define CLONE_ARGS_SIZE_VER0 64 /* sizeof first published struct */
 #define CLONE_ARGS_SIZE_VER1 80 /* sizeof second published struct */
 #define CLONE_ARGS_SIZE_VER2 88 /* sizeof third published struct */
+#define CLONE_ARGS_SIZE_VER3 112 /* sizeof fourth published struct */
 
 /*
  * Scheduling policies
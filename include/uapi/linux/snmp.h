@@ -303,6 +303,11 @@ enum
 	LINUX_MIB_TCPAOKEYNOTFOUND,		/* TCPAOKeyNotFound */
 	LINUX_MIB_TCPAOGOOD,			/* TCPAOGood */
 	LINUX_MIB_TCPAODROPPEDICMPS,		/* TCPAODroppedIcmps */
+	LINUX_MIB_REUSEPORTLOADKEEP,		/* ReusePortLoadKeep */
+	LINUX_MIB_REUSEPORTLOADDIVERT,		/* ReusePortLoadDivert */
+	LINUX_MIB_REUSEPORTLOADOVERLOAD,	/* ReusePortLoadOverload */
+	LINUX_MIB_IP6RTPCPUCACHEHIT,		/* IP6RtPcpuCacheHit */
+	LINUX_MIB_IP6RTPCPUCACHEMISS,		/* IP6RtPcpuCacheMiss */
 	__LINUX_MIB_MAX
 };
 
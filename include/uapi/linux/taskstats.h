@@ -230,7 +230,8 @@ struct taskstats {
 
 enum {
 	TASKSTATS_CMD_UNSPEC = 0,	/* Reserved */
-	TASKSTATS_CMD_GET,		/* user->kernel request/get-response */
+	TASKSTATS_CMD_GET,		/* user->kernel request/get-response,
+				 * NLM_F_DUMP: stats of all tasks */
 	TASKSTATS_CMD_NEW,		/* kernel->user event */
 	__TASKSTATS_CMD_MAX,
 };
@@ -136,6 +136,7 @@ enum {
 #define TCP_AO_REPAIR		42	/* Get/Set SNEs and ISNs */
 
 #define TCP_IS_MPTCP		43	/* Is MPTCP being used? */
+#define TCP_ACCEPT_PERCPU	44	/* Per-CPU accept queues from listen() on */
 
 #define TCP_REPAIR_ON		1
 #define TCP_REPAIR_OFF		0
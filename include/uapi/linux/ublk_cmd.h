@@ -77,6 +77,17 @@
  *
  *      It is only used if ublksrv set UBLK_F_NEED_GET_DATA flag
  *      while starting a ublk device.
+ *
+ * FETCH_IO_CMDS: only used with UBLK_F_BATCH_IO, issued via sqe(URING_CMD)
+ *      described by struct ublk_batch_io for fetching several IO requests
+ *      of one queue at once. The cqe completes once at least one request
+ *      is available; the tags of the fetched requests are written to the
+ *      __u16 array at `elem_addr`, and cqe->res is their number.
+ *
+ * COMMIT_IO_CMDS: only used with UBLK_F_BATCH_IO, commits the results of
+ *      the struct ublk_batch_commit_elem array at `elem_addr` to ublk
+ *      driver. It completes right away, and cqe->res is the number of
+ *      committed elements.
  */
 
 /*
@@ -94,6 +105,14 @@
 	_IOWR('u', UBLK_IO_COMMIT_AND_FETCH_REQ, struct ublksrv_io_cmd)
 #define	UBLK_U_IO_NEED_GET_DATA		\
 	_IOWR('u', UBLK_IO_NEED_GET_DATA, struct ublksrv_io_cmd)
+#define	UBLK_U_IO_REGISTER_IO_BUF	\
+	_IOWR('u', 0x23, struct ublksrv_io_cmd)
+#define	UBLK_U_IO_UNREGISTER_IO_BUF	\
+	_IOWR('u', 0x24, struct ublksrv_io_cmd)
+#define	UBLK_U_IO_FETCH_IO_CMDS		\
+	_IOWR('u', 0x25, struct ublk_batch_io)
+#define	UBLK_U_IO_COMMIT_IO_CMDS	\
+	_IOWR('u', 0x26, struct ublk_batch_io)
 
 /* only ABORT means that no re-fetch */
 #define UBLK_IO_RES_OK			0
@@ -127,8 +146,16 @@
 #define UBLKSRV_IO_BUF_TOTAL_SIZE	(1ULL << UBLKSRV_IO_BUF_TOTAL_BITS)
 
 /*
- * zero copy requires 4k block size, and can remap ublk driver's io
- * request into ublksrv's vm space
+ * The pages of a request can be registered as fixed buffer of the io_uring
+ * the io commands are issued on with UBLK_U_IO_REGISTER_IO_BUF, at the buffer
+ * index passed in the `addr` field of struct ublksrv_io_cmd. The ublk server
+ * can then pass them to fixed buffer requests to its backend, at offset 0 of
+ * the buffer, without copying the data. The buffer has to be unregistered
+ * with UBLK_U_IO_UNREGISTER_IO_BUF, the request completes once that is done
+ * and all the requests using the buffer have completed.
+ *
+ * As with UBLK_F_USER_COPY, `addr` must not be set in FETCH and COMMIT
+ * commands.
  */
 #define UBLK_F_SUPPORT_ZERO_COPY	(1ULL << 0)
 
@@ -207,6 +234,17 @@
  */
 #define UBLK_F_USER_RECOVERY_FAIL_IO (1ULL << 9)
 
+/*
+ * IO requests are fetched and committed in batches with
+ * UBLK_U_IO_FETCH_IO_CMDS and UBLK_U_IO_COMMIT_IO_CMDS instead of one
+ * io command per tag, and any thread of the ublk server may handle
+ * requests of any queue.
+ *
+ * Requires UBLK_F_USER_COPY or UBLK_F_SUPPORT_ZERO_COPY, and can't be
+ * combined with user recovery.
+ */
+#define UBLK_F_BATCH_IO (1ULL << 10)
+
 /* device state */
 #define UBLK_S_DEV_DEAD	0
 #define UBLK_S_DEV_LIVE	1
@@ -348,12 +386,38 @@ struct ublksrv_io_cmd {
 		 * re-used to pass back the allocated LBA for
 		 * UBLK_IO_OP_ZONE_APPEND which actually depends on
 		 * UBLK_F_USER_COPY
+		 *
+		 * For UBLK_U_IO_REGISTER_IO_BUF and UBLK_U_IO_UNREGISTER_IO_BUF,
+		 * it is the index in the io_uring registered buffer table.
 		 */
 		__u64	addr;
 		__u64	zone_append_lba;
 	};
 };
 
+/* sqe cmd payload of UBLK_U_IO_FETCH_IO_CMDS and UBLK_U_IO_COMMIT_IO_CMDS */
+struct ublk_batch_io {
+	__u16	q_id;
+	/* number of elements at `elem_addr` */
+	__u16	nr_elem;
+	/* must be zero */
+	__u32	flags;
+	/*
+	 * __u16 tag array for FETCH_IO_CMDS, struct ublk_batch_commit_elem
+	 * array for COMMIT_IO_CMDS
+	 */
+	__u64	elem_addr;
+};
+
+struct ublk_batch_commit_elem {
+	__u16	tag;
+	__u16	reserved;
+	/* io result, as ublksrv_io_cmd->result */
+	__s32	result;
+	/* allocated LBA of UBLK_IO_OP_ZONE_APPEND */
+	__u64	zone_append_lba;
+};
+
 struct ublk_param_basic {
 #define UBLK_ATTR_READ_ONLY            (1 << 0)
 #define UBLK_ATTR_ROTATIONAL           (1 << 1)
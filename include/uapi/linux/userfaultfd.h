@@ -46,6 +46,7 @@
 #define UFFD_API_IOCTLS				\
 	((__u64)1 << _UFFDIO_REGISTER |		\
 	 (__u64)1 << _UFFDIO_UNREGISTER |	\
+	 (__u64)1 << _UFFDIO_BATCH |		\
 	 (__u64)1 << _UFFDIO_API)
 #define UFFD_API_RANGE_IOCTLS			\
 	((__u64)1 << _UFFDIO_WAKE |		\
@@ -79,6 +80,7 @@
 #define _UFFDIO_WRITEPROTECT		(0x06)
 #define _UFFDIO_CONTINUE		(0x07)
 #define _UFFDIO_POISON			(0x08)
+#define _UFFDIO_BATCH			(0x09)
 #define _UFFDIO_API			(0x3F)
 
 /* userfaultfd ioctl ids */
@@ -103,6 +105,8 @@
 				      struct uffdio_continue)
 #define UFFDIO_POISON		_IOWR(UFFDIO, _UFFDIO_POISON, \
 				      struct uffdio_poison)
+#define UFFDIO_BATCH		_IOWR(UFFDIO, _UFFDIO_BATCH, \
+				      struct uffdio_batch)
 
 /* read() structure */
 struct uffd_msg {
@@ -374,6 +378,26 @@ struct uffdio_move {
 	__s64 move;
 };
 
+/*
+ * UFFDIO_BATCH runs "nr" UFFDIO_COPY, UFFDIO_CONTINUE or UFFDIO_MOVE
+ * requests, selected by "cmd" (_UFFDIO_COPY, ...), from the array of the
+ * matching structures at "reqs", in order. The result of each request is
+ * written back to its own structure, and the ioctl stops at the first
+ * request that does not complete, returning its error.
+ */
+struct uffdio_batch {
+	__u64 cmd;
+	__u64 reqs;
+	__u64 nr;
+	__u64 mode;	/* must be zero */
+
+	/*
+	 * "done" is written by the ioctl and must be at the end: the
+	 * copy_from_user will not read the last 8 bytes.
+	 */
+	__s64 done;
+};
+
 /*
  * Flags for the userfaultfd(2) system call itself.
  */
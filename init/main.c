@@ -1304,9 +1304,107 @@ static int __init ignore_unknown_bootoption(char *param, char *val,
 	return 0;
 }
 
+static bool initcall_parallel __ro_after_init;
+core_param(initcall_parallel, initcall_parallel, bool, 0444);
+
+static ASYNC_DOMAIN_EXCLUSIVE(initcall_domain);
+
+/* One parallel initcall, kept until the end of boot for the report */
+struct parallel_initcall {
+	struct list_head list;
+	initcall_t fn;
+	int level;
+	int cpu;
+	int ret;
+	ktime_t start;
+	ktime_t end;
+};
+
+static LIST_HEAD(parallel_initcalls);
+static DEFINE_SPINLOCK(parallel_initcalls_lock);
+static int initcall_cur_level __initdata;
+
+static void __init run_parallel_initcall(void *data, async_cookie_t cookie)
+{
+	struct parallel_initcall *pi = data;
+
+	pi->cpu = raw_smp_processor_id();
+	pi->start = ktime_get();
+	pi->ret = do_one_initcall(pi->fn);
+	pi->end = ktime_get();
+}
+
+int __init schedule_parallel_initcall(initcall_t fn)
+{
+	struct parallel_initcall *pi;
+
+	if (!initcall_parallel)
+		return fn();
+
+	pi = kzalloc(sizeof(*pi), GFP_KERNEL);
+	if (!pi)
+		return fn();
+
+	pi->fn = fn;
+	pi->level = initcall_cur_level;
+	spin_lock(&parallel_initcalls_lock);
+	list_add_tail(&pi->list, &parallel_initcalls);
+	spin_unlock(&parallel_initcalls_lock);
+
+	async_schedule_domain(run_parallel_initcall, pi, &initcall_domain);
+	return 0;
+}
+
+/*
+ * Report how each level spent its time with initcall_parallel: the wall
+ * time of the level, and the longest parallel initcall, which is what the
+ * level cannot finish before. Levels are the dependency edges, so the
+ * critical path of the boot is the chain of those longest initcalls.
+ */
+static void __init report_parallel_level(int level, ktime_t start)
+{
+	struct parallel_initcall *pi, *longest = NULL;
+	s64 total_us = ktime_us_delta(ktime_get(), start);
+	unsigned int nr = 0;
+
+	list_for_each_entry(pi, &parallel_initcalls, list) {
+		if (pi->level != level)
+			continue;
+		if (pi->ret)
+			pr_warn("parallel initcall %pS returned %d\n",
+				pi->fn, pi->ret);
+		if (!longest || ktime_sub(pi->end, pi->start) >
+				ktime_sub(longest->end, longest->start))
+			longest = pi;
+		nr++;
+	}
+
+	if (!longest) {
+		pr_info("initcall level %s: %lld usecs\n",
+			initcall_level_names[level], total_us);
+		return;
+	}
+
+	pr_info("initcall level %s: %lld usecs, %u parallel, longest %pS %lld usecs on CPU%d (started at +%lld usecs)\n",
+		initcall_level_names[level], total_us, nr, longest->fn,
+		ktime_us_delta(longest->end, longest->start), longest->cpu,
+		ktime_us_delta(longest->start, start));
+}
+
+static void __init free_parallel_initcalls(void)
+{
+	struct parallel_initcall *pi, *tmp;
+
+	list_for_each_entry_safe(pi, tmp, &parallel_initcalls, list) {
+		list_del(&pi->list);
+		kfree(pi);
+	}
+}
+
 static void __init do_initcall_level(int level, char *command_line)
 {
 	initcall_entry_t *fn;
+	ktime_t start = ktime_get();
 
 	parse_args(initcall_level_names[level],
 		   command_line, __start___param,
@@ -1315,8 +1413,14 @@ static void __init do_initcall_level(int level, char *command_line)
 		   NULL, ignore_unknown_bootoption);
 
 	trace_initcall_level(initcall_level_names[level]);
+	initcall_cur_level = level;
 	for (fn = initcall_levels[level]; fn < initcall_levels[level+1]; fn++)
 		do_one_initcall(initcall_from_entry(fn));
+
+	if (initcall_parallel) {
+		async_synchronize_full_domain(&initcall_domain);
+		report_parallel_level(level, start);
+	}
 }
 
 static void __init do_initcalls(void)
@@ -1335,6 +1439,7 @@ static void __init do_initcalls(void)
 		do_initcall_level(level, command_line);
 	}
 
+	free_parallel_initcalls();
 	kfree(command_line);
 }
 
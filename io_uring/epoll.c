@@ -11,6 +11,8 @@
 
 #include "io_uring.h"
 #include "epoll.h"
+#include "kbuf.h"
+#include "poll.h"
 
 #if defined(CONFIG_EPOLL)
 struct io_epoll {
@@ -21,6 +23,12 @@ struct io_epoll {
 	struct epoll_event		event;
 };
 
+struct io_epoll_wait {
+	struct file			*file;
+	int				maxevents;
+	struct epoll_event __user	*events;
+};
+
 int io_epoll_ctl_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe)
 {
 	struct io_epoll *epoll = io_kiocb_to_cmd(req, struct io_epoll);
@@ -58,4 +66,93 @@ int io_epoll_ctl(struct io_kiocb *req, unsigned int issue_flags)
 	io_req_set_res(req, ret, 0);
 	return IOU_OK;
 }
+
+int io_epoll_wait_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe)
+{
+	struct io_epoll_wait *iew = io_kiocb_to_cmd(req, struct io_epoll_wait);
+	unsigned int flags;
+
+	if (sqe->off || sqe->rw_flags || sqe->splice_fd_in)
+		return -EINVAL;
+
+	flags = READ_ONCE(sqe->ioprio);
+	if (flags & ~IORING_EPOLL_WAIT_MULTISHOT)
+		return -EINVAL;
+
+	iew->maxevents = READ_ONCE(sqe->len);
+	iew->events = u64_to_user_ptr(READ_ONCE(sqe->addr));
+
+	if (req->flags & REQ_F_BUFFER_SELECT) {
+		if (iew->events)
+			return -EINVAL;
+	} else if (flags & IORING_EPOLL_WAIT_MULTISHOT) {
+		/* every CQE needs its own buffer, must use provided buffers */
+		return -EINVAL;
+	}
+
+	if (flags & IORING_EPOLL_WAIT_MULTISHOT)
+		req->flags |= REQ_F_APOLL_MULTISHOT;
+	return 0;
+}
+
+int io_epoll_wait(struct io_kiocb *req, unsigned int issue_flags)
+{
+	struct io_epoll_wait *iew = io_kiocb_to_cmd(req, struct io_epoll_wait);
+	struct epoll_event __user *events = iew->events;
+	int maxevents = iew->maxevents;
+	unsigned int cflags = 0;
+	int ret;
+
+	if (io_do_buffer_select(req)) {
+		size_t len = (size_t)maxevents * sizeof(struct epoll_event);
+
+		events = io_buffer_select(req, &len, issue_flags);
+		if (!events)
+			return -ENOBUFS;
+		maxevents = len / sizeof(struct epoll_event);
+	}
+
+	ret = epoll_sendevents(req->file, events, maxevents);
+	if (ret == 0) {
+		/*
+		 * Nothing ready, recycle any buffer and let poll arming on
+		 * the eventpoll file retry us once events get queued.
+		 */
+		io_kbuf_recycle(req, issue_flags);
+		if (issue_flags & IO_URING_F_MULTISHOT)
+			return IOU_ISSUE_SKIP_COMPLETE;
+		return -EAGAIN;
+	} else if (ret < 0) {
+		io_kbuf_recycle(req, issue_flags);
+		req_set_fail(req);
+	} else if (!(req->flags & REQ_F_APOLL_MULTISHOT)) {
+		cflags = io_put_kbuf(req, ret * sizeof(struct epoll_event),
+				     issue_flags);
+	} else {
+		cflags = io_put_kbuf(req, ret * sizeof(struct epoll_event),
+				     issue_flags);
+		if (io_req_post_cqe(req, ret, cflags | IORING_CQE_F_MORE)) {
+			if (issue_flags & IO_URING_F_MULTISHOT) {
+				/*
+				 * Level triggered events are put back on the
+				 * ready list without waking ->poll() waiters,
+				 * so force a retry rather than wait for the
+				 * next edge.
+				 */
+				io_poll_multishot_retry(req);
+				return IOU_ISSUE_SKIP_COMPLETE;
+			}
+			return -EAGAIN;
+		}
+	}
+
+	/*
+	 * Either an error, or we've hit overflow posting the CQE. For any
+	 * multishot request, hitting overflow will terminate it.
+	 */
+	io_req_set_res(req, ret, cflags);
+	if (issue_flags & IO_URING_F_MULTISHOT)
+		return IOU_STOP_MULTISHOT;
+	return IOU_OK;
+}
 #endif
@@ -14,6 +14,9 @@
 #include "fdinfo.h"
 #include "cancel.h"
 #include "rsrc.h"
+#include "tctx.h"
+#include "io-wq.h"
+#include "opstats.h"
 
 #ifdef CONFIG_PROC_FS
 static __cold int io_uring_show_cred(struct seq_file *m, unsigned int id,
@@ -58,6 +61,16 @@ static __cold void common_tracking_show_fdinfo(struct io_ring_ctx *ctx,
 		seq_puts(m, "napi_prefer_busy_poll:\ttrue\n");
 	else
 		seq_puts(m, "napi_prefer_busy_poll:\tfalse\n");
+	if (ctx->napi_adaptive) {
+		seq_puts(m, "napi_adaptive:\ttrue\n");
+		seq_printf(m, "napi_cqe_interval:\t%lld\n",
+			   ctx->napi_cqe_interval);
+		seq_printf(m, "napi_misses:\t%u\n", ctx->napi_misses);
+		seq_printf(m, "napi_irqs_suspended:\t%s\n",
+			   ctx->napi_irqs_suspended ? "true" : "false");
+	} else {
+		seq_puts(m, "napi_adaptive:\tfalse\n");
+	}
 }
 
 static __cold void napi_show_fdinfo(struct io_ring_ctx *ctx,
@@ -86,6 +99,41 @@ static inline void napi_show_fdinfo(struct io_ring_ctx *ctx,
 }
 #endif
 
+static __cold void op_stats_show_fdinfo(struct io_ring_ctx *ctx,
+					struct seq_file *m)
+{
+	struct io_op_stats *stats = ctx->op_stats_alloc;
+	int op, i;
+
+	if (!stats) {
+		seq_puts(m, "OpStats:\tdisabled\n");
+		return;
+	}
+	seq_printf(m, "OpStats:\t%s\n",
+		   READ_ONCE(ctx->op_stats) ? "enabled" : "disabled");
+	for (op = 0; op < IORING_OP_LAST; op++) {
+		struct io_op_stat *s = &stats->op[op];
+		u64 nr = atomic64_read(&s->nr);
+		int last = -1;
+
+		if (!nr && !atomic64_read(&s->nr_iowq) &&
+		    !atomic64_read(&s->nr_poll))
+			continue;
+		seq_printf(m, "  %s: nr=%llu iowq=%lld poll=%lld avg_ns=%llu lat_us=",
+			   io_uring_get_opcode(op), nr,
+			   atomic64_read(&s->nr_iowq),
+			   atomic64_read(&s->nr_poll),
+			   nr ? div64_u64(atomic64_read(&s->lat_ns), nr) : 0);
+		for (i = 0; i < IO_OP_STATS_BUCKETS; i++)
+			if (atomic64_read(&s->lat[i]))
+				last = i;
+		for (i = 0; i <= last; i++)
+			seq_printf(m, "%s%lld", i ? "," : "",
+				   atomic64_read(&s->lat[i]));
+		seq_puts(m, "\n");
+	}
+}
+
 /*
  * Caller holds a reference to the file already, we don't need to do
  * anything else to get an extra reference.
@@ -106,6 +154,8 @@ __cold void io_uring_show_fdinfo(struct seq_file *m, struct file *file)
 	unsigned int sq_entries, cq_entries;
 	int sq_pid = -1, sq_cpu = -1;
 	u64 sq_total_time = 0, sq_work_time = 0;
+	u64 sq_busy_time = 0, sq_submitted = 0;
+	unsigned int sq_weight = 0;
 	bool has_lock;
 	unsigned int i;
 
@@ -199,12 +249,19 @@ __cold void io_uring_show_fdinfo(struct seq_file *m, struct file *file)
 					 + sq_usage.ru_stime.tv_usec);
 			sq_work_time = sq->work_time;
 		}
+		sq_weight = READ_ONCE(ctx->sq_weight);
+		sq_busy_time = div_u64(READ_ONCE(ctx->sq_busy_time),
+				       NSEC_PER_USEC);
+		sq_submitted = READ_ONCE(ctx->sq_submitted);
 	}
 
 	seq_printf(m, "SqThread:\t%d\n", sq_pid);
 	seq_printf(m, "SqThreadCpu:\t%d\n", sq_cpu);
 	seq_printf(m, "SqTotalTime:\t%llu\n", sq_total_time);
 	seq_printf(m, "SqWorkTime:\t%llu\n", sq_work_time);
+	seq_printf(m, "SqRingWeight:\t%u\n", sq_weight);
+	seq_printf(m, "SqRingBusyTime:\t%llu\n", sq_busy_time);
+	seq_printf(m, "SqRingSubmitted:\t%llu\n", sq_submitted);
 	seq_printf(m, "UserFiles:\t%u\n", ctx->file_table.data.nr);
 	for (i = 0; has_lock && i < ctx->file_table.data.nr; i++) {
 		struct file *f = NULL;
@@ -247,6 +304,28 @@ __cold void io_uring_show_fdinfo(struct seq_file *m, struct file *file)
 					task_work_pending(req->tctx->task));
 	}
 
+	seq_puts(m, "IoWqPending:\n");
+	if (has_lock) {
+		struct io_tctx_node *node;
+
+		/*
+		 * A task's io-wq is torn down only after its tctx nodes have
+		 * been removed, which happens under ->uring_lock.
+		 */
+		list_for_each_entry(node, &ctx->tctx_list, ctx_node) {
+			struct io_uring_task *tctx = node->task->io_uring;
+			int nid;
+
+			if (!tctx || !tctx->io_wq)
+				continue;
+			for_each_online_node(nid)
+				seq_printf(m, "  pid=%d node=%d bound=%u unbound=%u\n",
+					   task_pid_nr(node->task), nid,
+					   io_wq_node_pending(tctx->io_wq, nid, true),
+					   io_wq_node_pending(tctx->io_wq, nid, false));
+		}
+	}
+
 	if (has_lock)
 		mutex_unlock(&ctx->uring_lock);
 
@@ -261,5 +340,6 @@ __cold void io_uring_show_fdinfo(struct seq_file *m, struct file *file)
 	}
 	spin_unlock(&ctx->completion_lock);
 	napi_show_fdinfo(ctx, m);
+	op_stats_show_fdinfo(ctx, m);
 }
 #endif
@@ -56,6 +56,9 @@ struct io_worker {
 	struct io_wq_work *cur_work;
 	raw_spinlock_t lock;
 
+	/* NUMA node this worker is affine to, and prefers work from */
+	int node;
+
 	struct completion ref_done;
 
 	unsigned long create_state;
@@ -81,7 +84,11 @@ struct io_wq_acct {
 	unsigned max_workers;
 	int index;
 	atomic_t nr_running;
+	/* protects the work queues of this acct on all nodes */
 	raw_spinlock_t lock;
+};
+
+struct io_wq_queue {
 	struct io_wq_work_list work_list;
 	unsigned long flags;
 };
@@ -92,6 +99,15 @@ enum {
 	IO_WQ_ACCT_NR,
 };
 
+/*
+ * Work is queued on the node it was submitted from. Workers run work from
+ * their own node first, and only steal from other nodes once that is empty.
+ */
+struct io_wq_node {
+	struct io_wq_queue queue[IO_WQ_ACCT_NR];
+	struct io_wq_work *hash_tail[IO_WQ_NR_HASH_BUCKETS];
+};
+
 /*
  * Per io_wq state
   */
@@ -120,9 +136,9 @@ struct io_wq {
 
 	struct wait_queue_entry wait;
 
-	struct io_wq_work *hash_tail[IO_WQ_NR_HASH_BUCKETS];
-
 	cpumask_var_t cpu_mask;
+
+	struct io_wq_node nodes[];
 };
 
 static enum cpuhp_state io_wq_online;
@@ -135,7 +151,7 @@ struct io_cb_cancel_data {
 	bool cancel_all;
 };
 
-static bool create_io_worker(struct io_wq *wq, int index);
+static bool create_io_worker(struct io_wq *wq, int index, int node);
 static void io_wq_dec_running(struct io_worker *worker);
 static bool io_acct_cancel_pending_work(struct io_wq *wq,
 					struct io_wq_acct *acct,
@@ -170,6 +186,13 @@ static inline struct io_wq_acct *io_wq_get_acct(struct io_worker *worker)
 	return io_get_acct(worker->wq, test_bit(IO_WORKER_F_BOUND, &worker->flags));
 }
 
+static inline struct io_wq_queue *io_acct_queue(struct io_wq *wq,
+						struct io_wq_acct *acct,
+						int node)
+{
+	return &wq->nodes[node].queue[acct->index];
+}
+
 static void io_worker_ref_put(struct io_wq *wq)
 {
 	if (atomic_dec_and_test(&wq->worker_refs))
@@ -244,21 +267,42 @@ static void io_worker_exit(struct io_worker *worker)
 	do_exit(0);
 }
 
-static inline bool __io_acct_run_queue(struct io_wq_acct *acct)
+static inline bool __io_queue_runnable(struct io_wq_queue *queue)
+{
+	return !test_bit(IO_ACCT_STALLED_BIT, &queue->flags) &&
+		!wq_list_empty(&queue->work_list);
+}
+
+static inline bool __io_acct_run_queue(struct io_wq *wq,
+				       struct io_wq_acct *acct)
+{
+	int node;
+
+	for (node = 0; node < nr_node_ids; node++) {
+		if (__io_queue_runnable(io_acct_queue(wq, acct, node)))
+			return true;
+	}
+	return false;
+}
+
+static void io_acct_clear_stalled(struct io_wq *wq, struct io_wq_acct *acct)
 {
-	return !test_bit(IO_ACCT_STALLED_BIT, &acct->flags) &&
-		!wq_list_empty(&acct->work_list);
+	int node;
+
+	for (node = 0; node < nr_node_ids; node++)
+		clear_bit(IO_ACCT_STALLED_BIT,
+			  &io_acct_queue(wq, acct, node)->flags);
 }
 
 /*
  * If there's work to do, returns true with acct->lock acquired. If not,
  * returns false with no lock held.
  */
-static inline bool io_acct_run_queue(struct io_wq_acct *acct)
+static inline bool io_acct_run_queue(struct io_wq *wq, struct io_wq_acct *acct)
 	__acquires(&acct->lock)
 {
 	raw_spin_lock(&acct->lock);
-	if (__io_acct_run_queue(acct))
+	if (__io_acct_run_queue(wq, acct))
 		return true;
 
 	raw_spin_unlock(&acct->lock);
@@ -266,22 +310,27 @@ static inline bool io_acct_run_queue(struct io_wq_acct *acct)
 }
 
 /*
- * Check head of free list for an available worker. If one isn't available,
- * caller must create one.
+ * Check head of free list for an available worker on @node. If the acct
+ * can't grow any further, settle for an idle worker on another node, which
+ * will steal the work. If no worker is available, caller must create one.
  */
 static bool io_wq_activate_free_worker(struct io_wq *wq,
-					struct io_wq_acct *acct)
+					struct io_wq_acct *acct, int node)
 	__must_hold(RCU)
 {
 	struct hlist_nulls_node *n;
 	struct io_worker *worker;
+	bool any_node = false;
 
+retry:
 	/*
 	 * Iterate free_list and see if we can find an idle worker to
 	 * activate. If a given worker is on the free_list but in the process
 	 * of exiting, keep trying.
 	 */
 	hlist_nulls_for_each_entry_rcu(worker, n, &wq->free_list, nulls_node) {
+		if (!any_node && worker->node != node)
+			continue;
 		if (!io_worker_get(worker))
 			continue;
 		if (io_wq_get_acct(worker) != acct) {
@@ -298,6 +347,11 @@ static bool io_wq_activate_free_worker(struct io_wq *wq,
 		return true;
 	}
 
+	if (!any_node && nr_node_ids > 1 &&
+	    READ_ONCE(acct->nr_workers) >= READ_ONCE(acct->max_workers)) {
+		any_node = true;
+		goto retry;
+	}
 	return false;
 }
 
@@ -305,7 +359,8 @@ static bool io_wq_activate_free_worker(struct io_wq *wq,
  * We need a worker. If we find a free one, we're good. If not, and we're
  * below the max number of workers, create one.
  */
-static bool io_wq_create_worker(struct io_wq *wq, struct io_wq_acct *acct)
+static bool io_wq_create_worker(struct io_wq *wq, struct io_wq_acct *acct,
+				int node)
 {
 	/*
 	 * Most likely an attempt to queue unbounded work on an io_wq that
@@ -323,7 +378,7 @@ static bool io_wq_create_worker(struct io_wq *wq, struct io_wq_acct *acct)
 	raw_spin_unlock(&wq->lock);
 	atomic_inc(&acct->nr_running);
 	atomic_inc(&wq->worker_refs);
-	return create_io_worker(wq, acct->index);
+	return create_io_worker(wq, acct->index, node);
 }
 
 static void io_wq_inc_running(struct io_worker *worker)
@@ -352,7 +407,7 @@ static void create_worker_cb(struct callback_head *cb)
 	}
 	raw_spin_unlock(&wq->lock);
 	if (do_create) {
-		create_io_worker(wq, worker->create_index);
+		create_io_worker(wq, worker->create_index, worker->node);
 	} else {
 		atomic_dec(&acct->nr_running);
 		io_worker_ref_put(wq);
@@ -417,7 +472,7 @@ static void io_wq_dec_running(struct io_worker *worker)
 
 	if (!atomic_dec_and_test(&acct->nr_running))
 		return;
-	if (!io_acct_run_queue(acct))
+	if (!io_acct_run_queue(wq, acct))
 		return;
 
 	raw_spin_unlock(&acct->lock);
@@ -474,55 +529,85 @@ static bool io_wait_on_hash(struct io_wq *wq, unsigned int hash)
 	return ret;
 }
 
-static struct io_wq_work *io_get_next_work(struct io_wq_acct *acct,
-					   struct io_worker *worker)
-	__must_hold(acct->lock)
+static struct io_wq_work *io_queue_get_next_work(struct io_wq *wq,
+						 struct io_wq_node *wqn,
+						 struct io_wq_queue *queue,
+						 unsigned int *stall_hash)
 {
 	struct io_wq_work_node *node, *prev;
 	struct io_wq_work *work, *tail;
-	unsigned int stall_hash = -1U;
-	struct io_wq *wq = worker->wq;
 
-	wq_list_for_each(node, prev, &acct->work_list) {
+	wq_list_for_each(node, prev, &queue->work_list) {
 		unsigned int hash;
 
 		work = container_of(node, struct io_wq_work, list);
 
 		/* not hashed, can run anytime */
 		if (!io_wq_is_hashed(work)) {
-			wq_list_del(&acct->work_list, node, prev);
+			wq_list_del(&queue->work_list, node, prev);
 			return work;
 		}
 
 		hash = io_get_work_hash(work);
 		/* all items with this hash lie in [work, tail] */
-		tail = wq->hash_tail[hash];
+		tail = wqn->hash_tail[hash];
 
 		/* hashed, can run if not already running */
 		if (!test_and_set_bit(hash, &wq->hash->map)) {
-			wq->hash_tail[hash] = NULL;
-			wq_list_cut(&acct->work_list, &tail->list, prev);
+			wqn->hash_tail[hash] = NULL;
+			wq_list_cut(&queue->work_list, &tail->list, prev);
 			return work;
 		}
-		if (stall_hash == -1U)
-			stall_hash = hash;
+		if (*stall_hash == -1U)
+			*stall_hash = hash;
 		/* fast forward to a next hash, for-each will fix up @prev */
 		node = &tail->list;
 	}
 
-	if (stall_hash != -1U) {
+	return NULL;
+}
+
+static struct io_wq_work *io_get_next_work(struct io_wq_acct *acct,
+					   struct io_worker *worker)
+	__must_hold(acct->lock)
+{
+	struct io_wq_queue *stall_queue = NULL;
+	unsigned int stall_hash = -1U;
+	struct io_wq *wq = worker->wq;
+	int i;
+
+	/* local node first, then try and steal from the others */
+	for (i = 0; i < nr_node_ids; i++) {
+		int node = (worker->node + i) % nr_node_ids;
+		struct io_wq_queue *queue = io_acct_queue(wq, acct, node);
+		unsigned int hash = -1U;
+		struct io_wq_work *work;
+
+		if (test_bit(IO_ACCT_STALLED_BIT, &queue->flags))
+			continue;
+		work = io_queue_get_next_work(wq, &wq->nodes[node], queue,
+					      &hash);
+		if (work)
+			return work;
+		if (hash != -1U && !stall_queue) {
+			stall_queue = queue;
+			stall_hash = hash;
+		}
+	}
+
+	if (stall_queue) {
 		bool unstalled;
 
 		/*
 		 * Set this before dropping the lock to avoid racing with new
 		 * work being added and clearing the stalled bit.
 		 */
-		set_bit(IO_ACCT_STALLED_BIT, &acct->flags);
+		set_bit(IO_ACCT_STALLED_BIT, &stall_queue->flags);
 		raw_spin_unlock(&acct->lock);
 		unstalled = io_wait_on_hash(wq, stall_hash);
 		raw_spin_lock(&acct->lock);
 		if (unstalled) {
-			clear_bit(IO_ACCT_STALLED_BIT, &acct->flags);
+			clear_bit(IO_ACCT_STALLED_BIT, &stall_queue->flags);
 			if (wq_has_sleeper(&wq->hash->wait))
 				wake_up(&wq->hash->wait);
 		}
@@ -615,14 +700,14 @@ static void io_worker_handle_work(struct io_wq_acct *acct,
 				/* serialize hash clear with wake_up() */
 				spin_lock_irq(&wq->hash->wait.lock);
 				clear_bit(hash, &wq->hash->map);
-				clear_bit(IO_ACCT_STALLED_BIT, &acct->flags);
+				io_acct_clear_stalled(wq, acct);
 				spin_unlock_irq(&wq->hash->wait.lock);
 				if (wq_has_sleeper(&wq->hash->wait))
 					wake_up(&wq->hash->wait);
 			}
 		} while (work);
 
-		if (!__io_acct_run_queue(acct))
+		if (!__io_acct_run_queue(wq, acct))
 			break;
 		raw_spin_lock(&acct->lock);
 	} while (1);
@@ -651,7 +736,7 @@ static int io_wq_worker(void *data)
 		 * If we have work to do, io_acct_run_queue() returns with
 		 * the acct->lock held. If not, it will drop it.
 		 */
-		while (io_acct_run_queue(acct))
+		while (io_acct_run_queue(wq, acct))
 			io_worker_handle_work(acct, worker);
 
 		raw_spin_lock(&wq->lock);
@@ -685,7 +770,7 @@ static int io_wq_worker(void *data)
 		}
 	}
 
-	if (test_bit(IO_WQ_BIT_EXIT, &wq->state) && io_acct_run_queue(acct))
+	if (test_bit(IO_WQ_BIT_EXIT, &wq->state) && io_acct_run_queue(wq, acct))
 		io_worker_handle_work(acct, worker);
 
 	io_worker_exit(worker);
@@ -728,12 +813,34 @@ void io_wq_worker_sleeping(struct task_struct *tsk)
 	io_wq_dec_running(worker);
 }
 
+/*
+ * Keep the worker on the CPUs of its node, if the allowed mask has any.
+ */
+static void io_worker_set_affinity(struct io_wq *wq, struct io_worker *worker,
+				   struct task_struct *tsk)
+{
+	cpumask_var_t mask;
+
+	if (nr_node_ids > 1 && alloc_cpumask_var(&mask, GFP_KERNEL)) {
+		bool local;
+
+		local = cpumask_and(mask, wq->cpu_mask,
+				    cpumask_of_node(worker->node));
+		if (local)
+			set_cpus_allowed_ptr(tsk, mask);
+		free_cpumask_var(mask);
+		if (local)
+			return;
+	}
+	set_cpus_allowed_ptr(tsk, wq->cpu_mask);
+}
+
 static void io_init_new_worker(struct io_wq *wq, struct io_worker *worker,
 			       struct task_struct *tsk)
 {
 	tsk->worker_private = worker;
 	worker->task = tsk;
-	set_cpus_allowed_ptr(tsk, wq->cpu_mask);
+	io_worker_set_affinity(wq, worker, tsk);
 
 	raw_spin_lock(&wq->lock);
 	hlist_nulls_add_head_rcu(&worker->nulls_node, &wq->free_list);
@@ -791,7 +898,7 @@ static void create_worker_cont(struct callback_head *cb)
 	worker = container_of(cb, struct io_worker, create_work);
 	clear_bit_unlock(0, &worker->create_state);
 	wq = worker->wq;
-	tsk = create_io_thread(io_wq_worker, worker, NUMA_NO_NODE);
+	tsk = create_io_thread(io_wq_worker, worker, worker->node);
 	if (!IS_ERR(tsk)) {
 		io_init_new_worker(wq, worker, tsk);
 		io_worker_release(worker);
@@ -834,7 +941,7 @@ static void io_workqueue_create(struct work_struct *work)
 		kfree(worker);
 }
 
-static bool create_io_worker(struct io_wq *wq, int index)
+static bool create_io_worker(struct io_wq *wq, int index, int node)
 {
 	struct io_wq_acct *acct = &wq->acct[index];
 	struct io_worker *worker;
@@ -855,13 +962,14 @@ static bool create_io_worker(struct io_wq *wq, int index)
 
 	refcount_set(&worker->ref, 1);
 	worker->wq = wq;
+	worker->node = node;
 	raw_spin_lock_init(&worker->lock);
 	init_completion(&worker->ref_done);
 
 	if (index == IO_WQ_ACCT_BOUND)
 		set_bit(IO_WORKER_F_BOUND, &worker->flags);
 
-	tsk = create_io_thread(io_wq_worker, worker, NUMA_NO_NODE);
+	tsk = create_io_thread(io_wq_worker, worker, node);
 	if (!IS_ERR(tsk)) {
 		io_init_new_worker(wq, worker, tsk);
 	} else if (!io_should_retry_thread(worker, PTR_ERR(tsk))) {
@@ -916,25 +1024,27 @@ static void io_run_cancel(struct io_wq_work *work, struct io_wq *wq)
 	} while (work);
 }
 
-static void io_wq_insert_work(struct io_wq *wq, struct io_wq_work *work)
+static void io_wq_insert_work(struct io_wq *wq, struct io_wq_acct *acct,
+			      struct io_wq_work *work, int node)
 {
-	struct io_wq_acct *acct = io_work_get_acct(wq, work);
+	struct io_wq_queue *queue = io_acct_queue(wq, acct, node);
+	struct io_wq_node *wqn = &wq->nodes[node];
 	unsigned int hash;
 	struct io_wq_work *tail;
 
 	if (!io_wq_is_hashed(work)) {
 append:
-		wq_list_add_tail(&work->list, &acct->work_list);
+		wq_list_add_tail(&work->list, &queue->work_list);
 		return;
 	}
 
 	hash = io_get_work_hash(work);
-	tail = wq->hash_tail[hash];
-	wq->hash_tail[hash] = work;
+	tail = wqn->hash_tail[hash];
+	wqn->hash_tail[hash] = work;
 	if (!tail)
 		goto append;
 
-	wq_list_add_after(&work->list, &tail->list, &acct->work_list);
+	wq_list_add_after(&work->list, &tail->list, &queue->work_list);
 }
 
 static bool io_wq_work_match_item(struct io_wq_work *work, void *data)
@@ -951,6 +1061,7 @@ void io_wq_enqueue(struct io_wq *wq, struct io_wq_work *work)
 		.data		= work,
 		.cancel_all	= false,
 	};
+	int node = numa_node_id();
 	bool do_create;
 
 	/*
@@ -964,19 +1075,19 @@ void io_wq_enqueue(struct io_wq *wq, struct io_wq_work *work)
 	}
 
 	raw_spin_lock(&acct->lock);
-	io_wq_insert_work(wq, work);
-	clear_bit(IO_ACCT_STALLED_BIT, &acct->flags);
+	io_wq_insert_work(wq, acct, work, node);
+	clear_bit(IO_ACCT_STALLED_BIT, &io_acct_queue(wq, acct, node)->flags);
 	raw_spin_unlock(&acct->lock);
 
 	rcu_read_lock();
-	do_create = !io_wq_activate_free_worker(wq, acct);
+	do_create = !io_wq_activate_free_worker(wq, acct, node);
 	rcu_read_unlock();
 
 	if (do_create && ((work_flags & IO_WQ_WORK_CONCURRENT) ||
 	    !atomic_read(&acct->nr_running))) {
 		bool did_create;
 
-		did_create = io_wq_create_worker(wq, acct);
+		did_create = io_wq_create_worker(wq, acct, node);
 		if (likely(did_create))
 			return;
 
@@ -1035,21 +1146,22 @@ static bool io_wq_worker_cancel(struct io_worker *worker, void *data)
 
 static inline void io_wq_remove_pending(struct io_wq *wq,
 					 struct io_wq_work *work,
+					 struct io_wq_queue *queue,
+					 struct io_wq_node *wqn,
 					 struct io_wq_work_node *prev)
 {
-	struct io_wq_acct *acct = io_work_get_acct(wq, work);
 	unsigned int hash = io_get_work_hash(work);
 	struct io_wq_work *prev_work = NULL;
 
-	if (io_wq_is_hashed(work) && work == wq->hash_tail[hash]) {
+	if (io_wq_is_hashed(work) && work == wqn->hash_tail[hash]) {
 		if (prev)
 			prev_work = container_of(prev, struct io_wq_work, list);
 		if (prev_work && io_get_work_hash(prev_work) == hash)
-			wq->hash_tail[hash] = prev_work;
+			wqn->hash_tail[hash] = prev_work;
 		else
-			wq->hash_tail[hash] = NULL;
+			wqn->hash_tail[hash] = NULL;
 	}
-	wq_list_del(&acct->work_list, &work->list, prev);
+	wq_list_del(&queue->work_list, &work->list, prev);
 }
 
 static bool io_acct_cancel_pending_work(struct io_wq *wq,
@@ -1058,18 +1170,24 @@ static bool io_acct_cancel_pending_work(struct io_wq *wq,
 {
 	struct io_wq_work_node *node, *prev;
 	struct io_wq_work *work;
+	int nid;
 
 	raw_spin_lock(&acct->lock);
-	wq_list_for_each(node, prev, &acct->work_list) {
-		work = container_of(node, struct io_wq_work, list);
-		if (!match->fn(work, match->data))
-			continue;
-		io_wq_remove_pending(wq, work, prev);
-		raw_spin_unlock(&acct->lock);
-		io_run_cancel(work, wq);
-		match->nr_pending++;
-		/* not safe to continue after unlock */
-		return true;
+	for (nid = 0; nid < nr_node_ids; nid++) {
+		struct io_wq_queue *queue = io_acct_queue(wq, acct, nid);
+
+		wq_list_for_each(node, prev, &queue->work_list) {
+			work = container_of(node, struct io_wq_work, list);
+			if (!match->fn(work, match->data))
+				continue;
+			io_wq_remove_pending(wq, work, queue, &wq->nodes[nid],
+					     prev);
+			raw_spin_unlock(&acct->lock);
+			io_run_cancel(work, wq);
+			match->nr_pending++;
+			/* not safe to continue after unlock */
+			return true;
+		}
 	}
 	raw_spin_unlock(&acct->lock);
 
@@ -1150,9 +1268,14 @@ static int io_wq_hash_wake(struct wait_queue_entry *wait, unsigned mode,
 	rcu_read_lock();
 	for (i = 0; i < IO_WQ_ACCT_NR; i++) {
 		struct io_wq_acct *acct = &wq->acct[i];
+		int node;
 
-		if (test_and_clear_bit(IO_ACCT_STALLED_BIT, &acct->flags))
-			io_wq_activate_free_worker(wq, acct);
+		for (node = 0; node < nr_node_ids; node++) {
+			struct io_wq_queue *queue = io_acct_queue(wq, acct, node);
+
+			if (test_and_clear_bit(IO_ACCT_STALLED_BIT, &queue->flags))
+				io_wq_activate_free_worker(wq, acct, node);
+		}
 	}
 	rcu_read_unlock();
 	return 1;
@@ -1160,7 +1283,7 @@ static int io_wq_hash_wake(struct wait_queue_entry *wait, unsigned mode,
 
 struct io_wq *io_wq_create(unsigned bounded, struct io_wq_data *data)
 {
-	int ret, i;
+	int ret, i, node;
 	struct io_wq *wq;
 
 	if (WARN_ON_ONCE(!data->free_work || !data->do_work))
@@ -1168,7 +1291,7 @@ struct io_wq *io_wq_create(unsigned bounded, struct io_wq_data *data)
 	if (WARN_ON_ONCE(!bounded))
 		return ERR_PTR(-EINVAL);
 
-	wq = kzalloc(sizeof(struct io_wq), GFP_KERNEL);
+	wq = kzalloc(struct_size(wq, nodes, nr_node_ids), GFP_KERNEL);
 	if (!wq)
 		return ERR_PTR(-ENOMEM);
 
@@ -1192,8 +1315,9 @@ struct io_wq *io_wq_create(unsigned bounded, struct io_wq_data *data)
 
 		acct->index = i;
 		atomic_set(&acct->nr_running, 0);
-		INIT_WQ_LIST(&acct->work_list);
 		raw_spin_lock_init(&acct->lock);
+		for (node = 0; node < nr_node_ids; node++)
+			INIT_WQ_LIST(&io_acct_queue(wq, acct, node)->work_list);
 	}
 
 	raw_spin_lock_init(&wq->lock);
@@ -1361,6 +1485,22 @@ int io_wq_cpu_affinity(struct io_uring_task *tctx, cpumask_var_t mask)
 	return ret;
 }
 
+/*
+ * Number of work items currently queued on @node, for diagnostics only.
+ */
+unsigned int io_wq_node_pending(struct io_wq *wq, int node, bool bound)
+{
+	struct io_wq_acct *acct = io_get_acct(wq, bound);
+	struct io_wq_work_node *pos, *prev;
+	unsigned int nr = 0;
+
+	raw_spin_lock(&acct->lock);
+	wq_list_for_each(pos, prev, &io_acct_queue(wq, acct, node)->work_list)
+		nr++;
+	raw_spin_unlock(&acct->lock);
+	return nr;
+}
+
 /*
  * Set max number of unbounded workers, returns old value. If new_count is 0,
  * then just return the old value.
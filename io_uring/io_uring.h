@@ -13,6 +13,7 @@
 #include "slist.h"
 #include "filetable.h"
 #include "opdef.h"
+#include "opstats.h"
 
 #ifndef CREATE_TRACE_POINTS
 #include <trace/events/io_uring.h>
@@ -185,6 +186,16 @@ static inline bool io_get_cqe(struct io_ring_ctx *ctx, struct io_uring_cqe **ret
 	return io_get_cqe_overflow(ctx, ret, false);
 }
 
+static inline bool io_defer_get_uncommited_cqe(struct io_ring_ctx *ctx,
+					       struct io_uring_cqe **cqe_ret)
+{
+	io_lockdep_assert_cq_locked(ctx);
+
+	ctx->cq_extra++;
+	ctx->submit_state.cq_flush = true;
+	return io_get_cqe(ctx, cqe_ret);
+}
+
 static __always_inline bool io_fill_cqe_req(struct io_ring_ctx *ctx,
 					    struct io_kiocb *req)
 {
@@ -200,6 +211,7 @@ static __always_inline bool io_fill_cqe_req(struct io_ring_ctx *ctx,
 
 
 	memcpy(cqe, &req->cqe, sizeof(*cqe));
+	io_op_stats_complete(ctx, req);
 	if (ctx->flags & IORING_SETUP_CQE32) {
 		memcpy(cqe->big_cqe, &req->big_cqe, sizeof(*cqe));
 		memset(&req->big_cqe, 0, sizeof(req->big_cqe));
@@ -399,7 +411,8 @@ static inline void io_req_complete_defer(struct io_kiocb *req)
 static inline void io_commit_cqring_flush(struct io_ring_ctx *ctx)
 {
 	if (unlikely(ctx->off_timeout_used || ctx->drain_active ||
-		     ctx->has_evfd || ctx->poll_activated))
+		     ctx->has_evfd || ctx->poll_activated ||
+		     ctx->coarse_timeouts))
 		__io_commit_cqring_flush(ctx);
 }
 
@@ -173,8 +173,47 @@ static void __user *io_ring_buffer_select(struct io_kiocb *req, size_t *len,
 	return ret;
 }
 
-void __user *io_buffer_select(struct io_kiocb *req, size_t *len,
-			      unsigned int issue_flags)
+static inline bool io_ring_buffers_avail(struct io_buffer_list *bl)
+{
+	return smp_load_acquire(&bl->buf_ring->tail) != bl->head;
+}
+
+/*
+ * Pick a ring from a size-class group. The smallest class that fits @hint
+ * and still has buffers wins. If none fit, use the largest non-empty class
+ * and let the transfer be split or truncated. No hint means we have no idea
+ * how much is coming, so go for the largest class. If all member rings are
+ * empty, return the first one and let selection fail as usual.
+ */
+static struct io_buffer_list *io_buffer_class_select(struct io_buffer_list *bl,
+						     size_t hint)
+{
+	struct io_buffer_list *cl = NULL;
+	int i;
+
+	for (i = 0; i < bl->nr_classes; i++) {
+		if (!io_ring_buffers_avail(bl->classes[i]))
+			continue;
+		cl = bl->classes[i];
+		if (hint && hint <= cl->class_size)
+			break;
+	}
+	return cl ?: bl->classes[0];
+}
+
+static struct io_buffer_list *io_buffer_select_list(struct io_ring_ctx *ctx,
+						    unsigned int bgid,
+						    size_t hint)
+{
+	struct io_buffer_list *bl = io_buffer_get_list(ctx, bgid);
+
+	if (bl && unlikely(bl->flags & IOBL_CLASSES))
+		return io_buffer_class_select(bl, hint);
+	return bl;
+}
+
+void __user *io_buffer_select_hint(struct io_kiocb *req, size_t *len,
+				   size_t hint, unsigned int issue_flags)
 {
 	struct io_ring_ctx *ctx = req->ctx;
 	struct io_buffer_list *bl;
@@ -182,7 +221,7 @@ void __user *io_buffer_select(struct io_kiocb *req, size_t *len,
 
 	io_ring_submit_lock(req->ctx, issue_flags);
 
-	bl = io_buffer_get_list(ctx, req->buf_index);
+	bl = io_buffer_select_list(ctx, req->buf_index, hint);
 	if (likely(bl)) {
 		if (bl->flags & IOBL_BUF_RING)
 			ret = io_ring_buffer_select(req, len, bl, issue_flags);
@@ -294,7 +333,8 @@ int io_buffers_select(struct io_kiocb *req, struct buf_sel_arg *arg,
 	int ret = -ENOENT;
 
 	io_ring_submit_lock(ctx, issue_flags);
-	bl = io_buffer_get_list(ctx, req->buf_index);
+	bl = io_buffer_select_list(ctx, req->buf_index,
+				   arg->hint ?: arg->max_len);
 	if (unlikely(!bl))
 		goto out_unlock;
 
@@ -327,7 +367,8 @@ int io_buffers_peek(struct io_kiocb *req, struct buf_sel_arg *arg)
 
 	lockdep_assert_held(&ctx->uring_lock);
 
-	bl = io_buffer_get_list(ctx, req->buf_index);
+	bl = io_buffer_select_list(ctx, req->buf_index,
+				   arg->hint ?: arg->max_len);
 	if (unlikely(!bl))
 		return -ENOENT;
 
@@ -378,7 +419,10 @@ static int __io_remove_buffers(struct io_ring_ctx *ctx,
 
 static void io_put_bl(struct io_ring_ctx *ctx, struct io_buffer_list *bl)
 {
-	__io_remove_buffers(ctx, bl, -1U);
+	if (bl->flags & IOBL_CLASSES)
+		kfree(bl->classes);
+	else
+		__io_remove_buffers(ctx, bl, -1U);
 	kfree(bl);
 }
 
@@ -455,7 +499,7 @@ int io_remove_buffers(struct io_kiocb *req, unsigned int issue_flags)
 	if (bl) {
 		ret = -EINVAL;
 		/* can't use provide/remove buffers command on mapped buffers */
-		if (!(bl->flags & IOBL_BUF_RING))
+		if (!(bl->flags & (IOBL_BUF_RING | IOBL_CLASSES)))
 			ret = __io_remove_buffers(ctx, bl, p->nbufs);
 	}
 	io_ring_submit_unlock(ctx, issue_flags);
@@ -598,7 +642,7 @@ int io_provide_buffers(struct io_kiocb *req, unsigned int issue_flags)
 		}
 	}
 	/* can't add buffers via this command for a mapped buffer ring */
-	if (bl->flags & IOBL_BUF_RING) {
+	if (bl->flags & (IOBL_BUF_RING | IOBL_CLASSES)) {
 		ret = -EINVAL;
 		goto err;
 	}
@@ -641,7 +685,8 @@ int io_register_pbuf_ring(struct io_ring_ctx *ctx, void __user *arg)
 	bl = io_buffer_get_list(ctx, reg.bgid);
 	if (bl) {
 		/* if mapped buffer ring OR classic exists, don't allow */
-		if (bl->flags & IOBL_BUF_RING || !list_empty(&bl->buf_list))
+		if (bl->flags & (IOBL_BUF_RING | IOBL_CLASSES) ||
+		    !list_empty(&bl->buf_list))
 			return -EEXIST;
 		io_destroy_bl(ctx, bl);
 	}
@@ -712,8 +757,19 @@ int io_unregister_pbuf_ring(struct io_ring_ctx *ctx, void __user *arg)
 	bl = io_buffer_get_list(ctx, reg.bgid);
 	if (!bl)
 		return -ENOENT;
-	if (!(bl->flags & IOBL_BUF_RING))
+	if (bl->flags & IOBL_CLASSES) {
+		int i;
+
+		for (i = 0; i < bl->nr_classes; i++) {
+			bl->classes[i]->group = NULL;
+			bl->classes[i]->class_size = 0;
+		}
+	} else if (!(bl->flags & IOBL_BUF_RING)) {
 		return -EINVAL;
+	} else if (bl->group) {
+		/* must unregister the size-class group first */
+		return -EBUSY;
+	}
 
 	scoped_guard(mutex, &ctx->mmap_lock)
 		xa_erase(&ctx->io_bl_xa, bl->bgid);
@@ -722,6 +778,88 @@ int io_unregister_pbuf_ring(struct io_ring_ctx *ctx, void __user *arg)
 	return 0;
 }
 
+int io_register_pbuf_classes(struct io_ring_ctx *ctx, void __user *arg)
+{
+	struct io_uring_buf_class __user *uclasses;
+	__u32 sizes[IORING_MAX_BUF_CLASSES];
+	struct io_uring_buf_classes_reg reg;
+	struct io_buffer_list *bl, **classes;
+	int i, j, ret;
+
+	lockdep_assert_held(&ctx->uring_lock);
+
+	if (copy_from_user(&reg, arg, sizeof(reg)))
+		return -EFAULT;
+	if (reg.flags || reg.resv[0] || reg.resv[1])
+		return -EINVAL;
+	if (!reg.nr_classes || reg.nr_classes > IORING_MAX_BUF_CLASSES)
+		return -EINVAL;
+
+	bl = io_buffer_get_list(ctx, reg.bgid);
+	if (bl) {
+		if (bl->flags & (IOBL_BUF_RING | IOBL_CLASSES) ||
+		    !list_empty(&bl->buf_list))
+			return -EEXIST;
+		io_destroy_bl(ctx, bl);
+	}
+
+	classes = kcalloc(reg.nr_classes, sizeof(*classes), GFP_KERNEL);
+	if (!classes)
+		return -ENOMEM;
+
+	uclasses = u64_to_user_ptr(reg.classes);
+	for (i = 0; i < reg.nr_classes; i++) {
+		struct io_uring_buf_class c;
+		struct io_buffer_list *cl;
+
+		ret = -EFAULT;
+		if (copy_from_user(&c, &uclasses[i], sizeof(c)))
+			goto err;
+		/* classes must be given smallest first */
+		ret = -EINVAL;
+		if (c.resv || !c.buf_size || (i && c.buf_size <= sizes[i - 1]))
+			goto err;
+		ret = -ENOENT;
+		cl = io_buffer_get_list(ctx, c.bgid);
+		if (!cl)
+			goto err;
+		ret = -EINVAL;
+		if (!(cl->flags & IOBL_BUF_RING))
+			goto err;
+		ret = -EBUSY;
+		if (cl->group)
+			goto err;
+		for (j = 0; j < i; j++)
+			if (classes[j] == cl)
+				goto err;
+		classes[i] = cl;
+		sizes[i] = c.buf_size;
+	}
+
+	ret = -ENOMEM;
+	bl = kzalloc(sizeof(*bl), GFP_KERNEL);
+	if (!bl)
+		goto err;
+	INIT_LIST_HEAD(&bl->buf_list);
+	bl->flags = IOBL_CLASSES;
+	bl->nr_classes = reg.nr_classes;
+	bl->classes = classes;
+	ret = io_buffer_add_list(ctx, bl, reg.bgid);
+	if (ret) {
+		kfree(bl);
+		goto err;
+	}
+
+	for (i = 0; i < reg.nr_classes; i++) {
+		classes[i]->class_size = sizes[i];
+		classes[i]->group = bl;
+	}
+	return 0;
+err:
+	kfree(classes);
+	return ret;
+}
+
 int io_register_pbuf_status(struct io_ring_ctx *ctx, void __user *arg)
 {
 	struct io_uring_buf_status buf_status;
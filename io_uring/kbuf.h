@@ -10,6 +10,8 @@ enum {
 	IOBL_BUF_RING	= 1,
 	/* buffers are consumed incrementally rather than always fully */
 	IOBL_INC	= 2,
+	/* group of ring mapped lists, one per buffer size class */
+	IOBL_CLASSES	= 4,
 };
 
 struct io_buffer_list {
@@ -31,6 +33,14 @@ struct io_buffer_list {
 
 	__u16 flags;
 
+	/* below is for size-class groups and their member rings */
+	__u16 nr_classes;
+	__u32 class_size;
+	/* IOBL_CLASSES: member rings, sorted by increasing ->class_size */
+	struct io_buffer_list **classes;
+	/* for a member ring, the group it belongs to */
+	struct io_buffer_list *group;
+
 	struct io_mapped_region region;
 };
 
@@ -53,12 +63,14 @@ struct buf_sel_arg {
 	struct iovec *iovs;
 	size_t out_len;
 	size_t max_len;
+	/* expected transfer size for size-class groups, ->max_len if unset */
+	size_t hint;
 	unsigned short nr_iovs;
 	unsigned short mode;
 };
 
-void __user *io_buffer_select(struct io_kiocb *req, size_t *len,
-			      unsigned int issue_flags);
+void __user *io_buffer_select_hint(struct io_kiocb *req, size_t *len,
+				   size_t hint, unsigned int issue_flags);
 int io_buffers_select(struct io_kiocb *req, struct buf_sel_arg *arg,
 		      unsigned int issue_flags);
 int io_buffers_peek(struct io_kiocb *req, struct buf_sel_arg *arg);
@@ -73,6 +85,7 @@ int io_provide_buffers(struct io_kiocb *req, unsigned int issue_flags);
 int io_register_pbuf_ring(struct io_ring_ctx *ctx, void __user *arg);
 int io_unregister_pbuf_ring(struct io_ring_ctx *ctx, void __user *arg);
 int io_register_pbuf_status(struct io_ring_ctx *ctx, void __user *arg);
+int io_register_pbuf_classes(struct io_ring_ctx *ctx, void __user *arg);
 
 void __io_put_kbuf(struct io_kiocb *req, int len, unsigned issue_flags);
 
@@ -81,6 +94,22 @@ bool io_kbuf_recycle_legacy(struct io_kiocb *req, unsigned issue_flags);
 struct io_mapped_region *io_pbuf_get_region(struct io_ring_ctx *ctx,
 					    unsigned int bgid);
 
+static inline void __user *io_buffer_select(struct io_kiocb *req, size_t *len,
+					    unsigned int issue_flags)
+{
+	return io_buffer_select_hint(req, len, *len, issue_flags);
+}
+
+/*
+ * Buffer group ID to restore in ->buf_index when a buffer is put back or
+ * consumed. Rings that are part of a size-class group return to the group,
+ * so the next selection gets to pick a class again.
+ */
+static inline unsigned int io_bl_bgid(struct io_buffer_list *bl)
+{
+	return bl->group ? bl->group->bgid : bl->bgid;
+}
+
 static inline bool io_kbuf_recycle_ring(struct io_kiocb *req)
 {
 	/*
@@ -91,7 +120,7 @@ static inline bool io_kbuf_recycle_ring(struct io_kiocb *req)
 	 * to monopolize the buffer.
 	 */
 	if (req->buf_list) {
-		req->buf_index = req->buf_list->bgid;
+		req->buf_index = io_bl_bgid(req->buf_list);
 		req->flags &= ~(REQ_F_BUFFER_RING|REQ_F_BUFFERS_COMMIT);
 		return true;
 	}
@@ -154,7 +183,7 @@ static inline bool __io_put_kbuf_ring(struct io_kiocb *req, int len, int nr)
 
 	if (bl) {
 		ret = io_kbuf_commit(req, bl, len, nr);
-		req->buf_index = bl->bgid;
+		req->buf_index = io_bl_bgid(bl);
 	}
 	req->flags &= ~REQ_F_BUFFER_RING;
 	return ret;
@@ -13,15 +13,32 @@
 #include "filetable.h"
 #include "alloc_cache.h"
 #include "msg_ring.h"
+#include "register.h"
 
 /* All valid masks for MSG_RING */
 #define IORING_MSG_RING_MASK		(IORING_MSG_RING_CQE_SKIP | \
-					IORING_MSG_RING_FLAGS_PASS)
+					IORING_MSG_RING_FLAGS_PASS | \
+					IORING_MSG_RING_MULTI | \
+					IORING_MSG_RING_MULTI_REG)
+
+/* max number of extra target rings for IORING_MSG_RING_MULTI */
+#define IO_MSG_RING_MAX_TARGETS		1024
 
 struct io_msg {
 	struct file			*file;
-	struct file			*src_file;
-	struct callback_head		tw;
+	union {
+		struct {
+			struct file		*src_file;
+			struct callback_head	tw;
+		};
+		/* IORING_MSG_RING_MULTI */
+		struct {
+			struct file		**targets;
+			u32			nr_targets;
+			/* rings posted to so far, including req->file */
+			u32			nr_done;
+		};
+	};
 	u64 user_data;
 	u32 len;
 	u32 cmd;
@@ -55,10 +72,25 @@ static int io_double_lock_ctx(struct io_ring_ctx *octx,
 	return 0;
 }
 
+static void io_msg_put_targets(struct io_msg *msg)
+{
+	unsigned int i;
+
+	for (i = 0; i < msg->nr_targets; i++)
+		fput(msg->targets[i]);
+	kfree(msg->targets);
+	msg->targets = NULL;
+	msg->nr_targets = 0;
+}
+
 void io_msg_ring_cleanup(struct io_kiocb *req)
 {
 	struct io_msg *msg = io_kiocb_to_cmd(req, struct io_msg);
 
+	if (msg->flags & IORING_MSG_RING_MULTI) {
+		io_msg_put_targets(msg);
+		return;
+	}
 	if (WARN_ON_ONCE(!msg->src_file))
 		return;
 
@@ -139,7 +171,9 @@ static int __io_msg_ring_data(struct io_ring_ctx *target_ctx,
 	u32 flags = 0;
 	int ret;
 
-	if (msg->src_fd || msg->flags & ~IORING_MSG_RING_FLAGS_PASS)
+	if (msg->src_fd || msg->flags & ~(IORING_MSG_RING_FLAGS_PASS |
+					  IORING_MSG_RING_MULTI |
+					  IORING_MSG_RING_MULTI_REG))
 		return -EINVAL;
 	if (!(msg->flags & IORING_MSG_RING_FLAGS_PASS) && msg->dst_fd)
 		return -EINVAL;
@@ -172,6 +206,37 @@ static int io_msg_ring_data(struct io_kiocb *req, unsigned int issue_flags)
 	return __io_msg_ring_data(target_ctx, msg, issue_flags);
 }
 
+/*
+ * Post the message to req->file, then to each of the extra targets. If the
+ * target lock can't be grabbed we return -EAGAIN and get retried from
+ * io-wq, ->nr_done ensures nobody gets the message twice. Remote posts use
+ * lazy wakeups, so several messages for the same task get batched.
+ */
+static int io_msg_ring_data_multi(struct io_kiocb *req,
+				  unsigned int issue_flags)
+{
+	struct io_msg *msg = io_kiocb_to_cmd(req, struct io_msg);
+	int ret = 0;
+
+	while (msg->nr_done <= msg->nr_targets) {
+		struct file *file = req->file;
+
+		if (msg->nr_done)
+			file = msg->targets[msg->nr_done - 1];
+		ret = __io_msg_ring_data(file->private_data, msg, issue_flags);
+		if (ret)
+			break;
+		msg->nr_done++;
+	}
+
+	if (ret == -EAGAIN || !msg->nr_done)
+		return ret;
+	/* partial delivery, return how far we got but break links */
+	if (ret)
+		req_set_fail(req);
+	return msg->nr_done;
+}
+
 static int io_msg_grab_file(struct io_kiocb *req, unsigned int issue_flags)
 {
 	struct io_msg *msg = io_kiocb_to_cmd(req, struct io_msg);
@@ -294,9 +359,54 @@ static int __io_msg_ring_prep(struct io_msg *msg, const struct io_uring_sqe *sqe
 	return 0;
 }
 
+static int io_msg_ring_prep_multi(struct io_kiocb *req, struct io_msg *msg,
+				  const struct io_uring_sqe *sqe)
+{
+	u32 __user *ufds = u64_to_user_ptr(READ_ONCE(sqe->addr3));
+	bool registered = msg->flags & IORING_MSG_RING_MULTI_REG;
+	unsigned int i, nr = READ_ONCE(sqe->ioprio);
+
+	if (msg->cmd != IORING_MSG_DATA)
+		return -EINVAL;
+	if (!nr || nr > IO_MSG_RING_MAX_TARGETS)
+		return -EINVAL;
+
+	/* ->src_fd aliases addr3, which holds the target array here */
+	msg->src_fd = 0;
+	msg->nr_targets = 0;
+	msg->nr_done = 0;
+	msg->targets = kcalloc(nr, sizeof(struct file *), GFP_KERNEL);
+	if (!msg->targets)
+		return -ENOMEM;
+	req->flags |= REQ_F_NEED_CLEANUP;
+
+	for (i = 0; i < nr; i++) {
+		struct file *file;
+		u32 fd;
+
+		if (get_user(fd, &ufds[i]))
+			return -EFAULT;
+		file = io_uring_register_get_file(fd, registered);
+		if (IS_ERR(file))
+			return PTR_ERR(file);
+		msg->targets[msg->nr_targets++] = file;
+	}
+	return 0;
+}
+
 int io_msg_ring_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe)
 {
-	return __io_msg_ring_prep(io_kiocb_to_cmd(req, struct io_msg), sqe);
+	struct io_msg *msg = io_kiocb_to_cmd(req, struct io_msg);
+	int ret;
+
+	ret = __io_msg_ring_prep(msg, sqe);
+	if (unlikely(ret))
+		return ret;
+	if (msg->flags & IORING_MSG_RING_MULTI)
+		return io_msg_ring_prep_multi(req, msg, sqe);
+	if (msg->flags & IORING_MSG_RING_MULTI_REG || READ_ONCE(sqe->ioprio))
+		return -EINVAL;
+	return 0;
 }
 
 int io_msg_ring(struct io_kiocb *req, unsigned int issue_flags)
@@ -310,7 +420,10 @@ int io_msg_ring(struct io_kiocb *req, unsigned int issue_flags)
 
 	switch (msg->cmd) {
 	case IORING_MSG_DATA:
-		ret = io_msg_ring_data(req, issue_flags);
+		if (msg->flags & IORING_MSG_RING_MULTI)
+			ret = io_msg_ring_data_multi(req, issue_flags);
+		else
+			ret = io_msg_ring_data(req, issue_flags);
 		break;
 	case IORING_MSG_SEND_FD:
 		ret = io_msg_send_fd(req, issue_flags);
@@ -345,6 +458,9 @@ int io_uring_sync_msg_ring(struct io_uring_sqe *sqe)
 	 */
 	if (io_msg.cmd != IORING_MSG_DATA)
 		return -EINVAL;
+	/* fan-out needs a request to track the target files */
+	if (io_msg.flags & (IORING_MSG_RING_MULTI | IORING_MSG_RING_MULTI_REG))
+		return -EINVAL;
 
 	CLASS(fd, f)(sqe->fd);
 	if (fd_empty(f))
@@ -8,6 +8,9 @@
 /* Timeout for cleanout of stale entries. */
 #define NAPI_TIMEOUT		(60 * SEC_CONVERSION)
 
+/* adaptive mode shrinks the busy poll window to at most 1/64th */
+#define NAPI_ADAPTIVE_MAX_BACKOFF	6
+
 struct io_napi_entry {
 	unsigned int		napi_id;
 	struct list_head	list;
@@ -157,6 +160,84 @@ static bool io_napi_busy_loop_should_end(void *data,
 	return false;
 }
 
+static void io_napi_suspend_irqs(struct io_ring_ctx *ctx, bool suspend)
+{
+	struct io_napi_entry *e;
+
+	if (ctx->napi_irqs_suspended == suspend)
+		return;
+	if (suspend && !READ_ONCE(ctx->napi_prefer_busy_poll))
+		return;
+	ctx->napi_irqs_suspended = suspend;
+
+	guard(rcu)();
+	list_for_each_entry_rcu(e, &ctx->napi_list, list) {
+		if (suspend)
+			napi_suspend_irqs(e->napi_id);
+		else
+			napi_resume_irqs(e->napi_id);
+	}
+}
+
+/*
+ * For IO_URING_NAPI_ADAPTIVE, busy poll for roughly two CQE intervals as
+ * seen recently, capped at the registered busy poll timeout. Every poll that
+ * ended without finding anything halves the window, until one finds work.
+ */
+static ktime_t io_napi_adaptive_dt(struct io_ring_ctx *ctx, ktime_t dt_max)
+{
+	unsigned int tail = READ_ONCE(ctx->rings->cq.tail);
+	ktime_t dt = dt_max;
+
+	if (tail != ctx->napi_last_cq_tail) {
+		ktime_t now = net_to_ktime(busy_loop_current_time());
+		u64 interval;
+
+		interval = div_u64(ktime_sub(now, ctx->napi_last_cqe_time),
+				   tail - ctx->napi_last_cq_tail);
+		if (ctx->napi_cqe_interval)
+			interval = (interval + 7 * ctx->napi_cqe_interval) >> 3;
+		ctx->napi_cqe_interval = interval;
+		ctx->napi_last_cq_tail = tail;
+		ctx->napi_last_cqe_time = now;
+	}
+
+	if (ctx->napi_cqe_interval)
+		dt = min_t(u64, dt, 2 * ctx->napi_cqe_interval);
+	return dt >> min_t(u8, ctx->napi_misses, NAPI_ADAPTIVE_MAX_BACKOFF);
+}
+
+/*
+ * Account the outcome of an adaptive busy poll. If it found work and CQEs
+ * arrive much faster than the busy poll timeout, the ring is considered
+ * saturated and device irqs are suspended, relying on busy polling alone
+ * until a poll comes up empty.
+ */
+static void io_napi_adaptive_end(struct io_ring_ctx *ctx,
+				 struct io_wait_queue *iowq, ktime_t dt_max)
+{
+	if (io_should_wake(iowq) || io_has_work(ctx)) {
+		ctx->napi_misses = 0;
+		if (ctx->napi_cqe_interval &&
+		    ctx->napi_cqe_interval <= dt_max / 4)
+			io_napi_suspend_irqs(ctx, true);
+	} else {
+		if (ctx->napi_misses < U8_MAX)
+			ctx->napi_misses++;
+		io_napi_suspend_irqs(ctx, false);
+	}
+}
+
+static void io_napi_adaptive_reset(struct io_ring_ctx *ctx, bool adaptive)
+{
+	io_napi_suspend_irqs(ctx, false);
+	ctx->napi_misses = 0;
+	ctx->napi_cqe_interval = 0;
+	ctx->napi_last_cq_tail = READ_ONCE(ctx->rings->cq.tail);
+	ctx->napi_last_cqe_time = net_to_ktime(busy_loop_current_time());
+	WRITE_ONCE(ctx->napi_adaptive, adaptive);
+}
+
 /*
  * never report stale entries
  */
@@ -255,6 +336,8 @@ void io_napi_free(struct io_ring_ctx *ctx)
 {
 	struct io_napi_entry *e;
 
+	io_napi_suspend_irqs(ctx, false);
+
 	guard(spinlock)(&ctx->napi_lock);
 	list_for_each_entry(e, &ctx->napi_list, list) {
 		hash_del_rcu(&e->node);
@@ -278,6 +361,7 @@ static int io_napi_register_napi(struct io_ring_ctx *ctx,
 	WRITE_ONCE(ctx->napi_track_mode, napi->op_param);
 	WRITE_ONCE(ctx->napi_busy_poll_dt, napi->busy_poll_to * NSEC_PER_USEC);
 	WRITE_ONCE(ctx->napi_prefer_busy_poll, !!napi->prefer_busy_poll);
+	io_napi_adaptive_reset(ctx, napi->flags & IO_URING_NAPI_ADAPTIVE);
 	return 0;
 }
 
@@ -293,7 +377,8 @@ int io_register_napi(struct io_ring_ctx *ctx, void __user *arg)
 	const struct io_uring_napi curr = {
 		.busy_poll_to 	  = ktime_to_us(ctx->napi_busy_poll_dt),
 		.prefer_busy_poll = ctx->napi_prefer_busy_poll,
-		.op_param	  = ctx->napi_track_mode
+		.op_param	  = ctx->napi_track_mode,
+		.flags		  = ctx->napi_adaptive ? IO_URING_NAPI_ADAPTIVE : 0,
 	};
 	struct io_uring_napi napi;
 
@@ -301,7 +386,11 @@ int io_register_napi(struct io_ring_ctx *ctx, void __user *arg)
 		return -EINVAL;
 	if (copy_from_user(&napi, arg, sizeof(napi)))
 		return -EFAULT;
-	if (napi.pad[0] || napi.pad[1] || napi.resv)
+	if (napi.pad[0] || napi.pad[1])
+		return -EINVAL;
+	if (napi.flags & ~IO_URING_NAPI_ADAPTIVE)
+		return -EINVAL;
+	if (napi.flags && napi.opcode != IO_URING_NAPI_REGISTER_OP)
 		return -EINVAL;
 
 	if (copy_to_user(arg, &curr, sizeof(curr)))
@@ -335,12 +424,14 @@ int io_unregister_napi(struct io_ring_ctx *ctx, void __user *arg)
 {
 	const struct io_uring_napi curr = {
 		.busy_poll_to 	  = ktime_to_us(ctx->napi_busy_poll_dt),
-		.prefer_busy_poll = ctx->napi_prefer_busy_poll
+		.prefer_busy_poll = ctx->napi_prefer_busy_poll,
+		.flags		  = ctx->napi_adaptive ? IO_URING_NAPI_ADAPTIVE : 0,
 	};
 
 	if (arg && copy_to_user(arg, &curr, sizeof(curr)))
 		return -EFAULT;
 
+	io_napi_adaptive_reset(ctx, false);
 	WRITE_ONCE(ctx->napi_busy_poll_dt, 0);
 	WRITE_ONCE(ctx->napi_prefer_busy_poll, false);
 	WRITE_ONCE(ctx->napi_track_mode, IO_URING_NAPI_TRACKING_INACTIVE);
@@ -356,10 +447,16 @@ int io_unregister_napi(struct io_ring_ctx *ctx, void __user *arg)
  */
 void __io_napi_busy_loop(struct io_ring_ctx *ctx, struct io_wait_queue *iowq)
 {
+	bool adaptive = READ_ONCE(ctx->napi_adaptive);
+	ktime_t dt_max;
+
 	if (ctx->flags & IORING_SETUP_SQPOLL)
 		return;
 
-	iowq->napi_busy_poll_dt = READ_ONCE(ctx->napi_busy_poll_dt);
+	dt_max = READ_ONCE(ctx->napi_busy_poll_dt);
+	iowq->napi_busy_poll_dt = dt_max;
+	if (adaptive)
+		iowq->napi_busy_poll_dt = io_napi_adaptive_dt(ctx, dt_max);
 	if (iowq->timeout != KTIME_MAX) {
 		ktime_t dt = ktime_sub(iowq->timeout, io_get_time(ctx));
 
@@ -368,6 +465,8 @@ void __io_napi_busy_loop(struct io_ring_ctx *ctx, struct io_wait_queue *iowq)
 
 	iowq->napi_prefer_busy_poll = READ_ONCE(ctx->napi_prefer_busy_poll);
 	io_napi_blocking_busy_loop(ctx, iowq);
+	if (adaptive)
+		io_napi_adaptive_end(ctx, iowq, dt_max);
 }
 
 /*
@@ -8,6 +8,8 @@ struct io_async_msghdr {
 	struct iovec			*free_iov;
 	/* points to an allocated iov, if NULL we use fast_iov instead */
 	int				free_iov_nr;
+	/* bvecs for vectored sends from registered buffers */
+	struct iou_vec			vec;
 	struct_group(clear,
 		int				namelen;
 		struct iovec			fast_iov;
@@ -59,6 +61,9 @@ int io_bind(struct io_kiocb *req, unsigned int issue_flags);
 int io_listen_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe);
 int io_listen(struct io_kiocb *req, unsigned int issue_flags);
 
+int io_recvzc(struct io_kiocb *req, unsigned int issue_flags);
+int io_recvzc_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe);
+
 void io_netmsg_cache_free(const void *entry);
 #else
 static inline void io_netmsg_cache_free(const void *entry)
@@ -0,0 +1,66 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Optional per-opcode completion latency and punt accounting, enabled with
+ * IORING_REGISTER_OP_STATS and shown in fdinfo.
+ */
+#include <linux/kernel.h>
+#include <linux/errno.h>
+#include <linux/slab.h>
+#include <linux/io_uring.h>
+
+#include <uapi/linux/io_uring.h>
+
+#include "io_uring.h"
+#include "opstats.h"
+
+void __io_op_stats_complete(struct io_op_stats *stats, struct io_kiocb *req)
+{
+	struct io_op_stat *s = &stats->op[req->opcode];
+	u64 lat = ktime_get_ns() - req->stats_ts;
+	unsigned int bucket;
+
+	bucket = min(fls64(lat / NSEC_PER_USEC), IO_OP_STATS_BUCKETS - 1);
+	atomic64_inc(&s->nr);
+	atomic64_add(lat, &s->lat_ns);
+	atomic64_inc(&s->lat[bucket]);
+	/* only account once, even if the CQE has to be posted again */
+	req->stats_ts = 0;
+}
+
+/*
+ * Turn accounting on or off. Enabling always starts from zeroed counters.
+ * The stats memory stays around until the ring goes away, as completions
+ * may be accounting against it from any context when it's turned off.
+ */
+int io_register_op_stats(struct io_ring_ctx *ctx, unsigned int enable)
+{
+	struct io_op_stats *stats = ctx->op_stats_alloc;
+
+	lockdep_assert_held(&ctx->uring_lock);
+
+	if (enable > 1)
+		return -EINVAL;
+	if (!enable) {
+		WRITE_ONCE(ctx->op_stats, NULL);
+		return 0;
+	}
+
+	if (!stats) {
+		stats = kvzalloc(sizeof(*stats), GFP_KERNEL_ACCOUNT);
+		if (!stats)
+			return -ENOMEM;
+		ctx->op_stats_alloc = stats;
+	} else {
+		WRITE_ONCE(ctx->op_stats, NULL);
+		memset(stats, 0, sizeof(*stats));
+	}
+	WRITE_ONCE(ctx->op_stats, stats);
+	return 0;
+}
+
+void io_op_stats_free(struct io_ring_ctx *ctx)
+{
+	kvfree(ctx->op_stats_alloc);
+	ctx->op_stats_alloc = NULL;
+	ctx->op_stats = NULL;
+}
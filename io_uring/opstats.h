@@ -0,0 +1,69 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef IOU_OPSTATS_H
+#define IOU_OPSTATS_H
+
+#include <linux/io_uring_types.h>
+#include <linux/timekeeping.h>
+
+/*
+ * Latency buckets are log2 of submit to complete time in usecs. Bucket 0 is
+ * below 1 usec, bucket N covers [2^(N-1), 2^N) usecs, and the last bucket
+ * takes everything beyond.
+ */
+#define IO_OP_STATS_BUCKETS	24
+
+struct io_op_stat {
+	atomic64_t		nr;
+	/* punted to io-wq */
+	atomic64_t		nr_iowq;
+	/* went through async poll arming */
+	atomic64_t		nr_poll;
+	atomic64_t		lat_ns;
+	atomic64_t		lat[IO_OP_STATS_BUCKETS];
+};
+
+struct io_op_stats {
+	struct io_op_stat	op[IORING_OP_LAST];
+};
+
+enum {
+	IO_OP_STAT_IOWQ,
+	IO_OP_STAT_POLL,
+};
+
+int io_register_op_stats(struct io_ring_ctx *ctx, unsigned int enable);
+void io_op_stats_free(struct io_ring_ctx *ctx);
+void __io_op_stats_complete(struct io_op_stats *stats, struct io_kiocb *req);
+
+static inline void io_op_stats_start(struct io_ring_ctx *ctx,
+				     struct io_kiocb *req)
+{
+	req->stats_ts = 0;
+	if (unlikely(READ_ONCE(ctx->op_stats)))
+		req->stats_ts = ktime_get_ns();
+}
+
+static inline void io_op_stats_complete(struct io_ring_ctx *ctx,
+					struct io_kiocb *req)
+{
+	struct io_op_stats *stats = READ_ONCE(ctx->op_stats);
+
+	if (unlikely(stats) && req->stats_ts)
+		__io_op_stats_complete(stats, req);
+}
+
+static inline void io_op_stats_account(struct io_kiocb *req, int what)
+{
+	struct io_op_stats *stats = READ_ONCE(req->ctx->op_stats);
+	struct io_op_stat *s;
+
+	if (likely(!stats))
+		return;
+	s = &stats->op[req->opcode];
+	if (what == IO_OP_STAT_IOWQ)
+		atomic64_inc(&s->nr_iowq);
+	else
+		atomic64_inc(&s->nr_poll);
+}
+
+#endif
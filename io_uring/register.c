@@ -30,6 +30,8 @@
 #include "eventfd.h"
 #include "msg_ring.h"
 #include "memmap.h"
+#include "zcrx.h"
+#include "opstats.h"
 
 #define IORING_MAX_RESTRICTIONS	(IORING_RESTRICTION_LAST + \
 				 IORING_REGISTER_LAST + IORING_OP_LAST)
@@ -789,6 +791,18 @@ static int __io_uring_register(struct io_ring_ctx *ctx, unsigned opcode,
 			break;
 		ret = io_register_pbuf_status(ctx, arg);
 		break;
+	case IORING_REGISTER_PBUF_CLASSES:
+		ret = -EINVAL;
+		if (!arg || nr_args != 1)
+			break;
+		ret = io_register_pbuf_classes(ctx, arg);
+		break;
+	case IORING_REGISTER_OP_STATS:
+		ret = -EINVAL;
+		if (arg)
+			break;
+		ret = io_register_op_stats(ctx, nr_args);
+		break;
 	case IORING_REGISTER_NAPI:
 		ret = -EINVAL;
 		if (!arg || nr_args != 1)
@@ -825,6 +839,18 @@ static int __io_uring_register(struct io_ring_ctx *ctx, unsigned opcode,
 			break;
 		ret = io_register_mem_region(ctx, arg);
 		break;
+	case IORING_REGISTER_ZCRX_IFQ:
+		ret = -EINVAL;
+		if (!arg || nr_args != 1)
+			break;
+		ret = io_register_zcrx_ifq(ctx, arg);
+		break;
+	case IORING_REGISTER_SQPOLL_WEIGHT:
+		ret = -EINVAL;
+		if (arg)
+			break;
+		ret = io_sqpoll_set_weight(ctx, nr_args);
+		break;
 	default:
 		ret = -EINVAL;
 		break;
@@ -9,6 +9,7 @@
 #include <linux/hugetlb.h>
 #include <linux/compat.h>
 #include <linux/io_uring.h>
+#include <linux/blk-mq.h>
 
 #include <uapi/linux/io_uring.h>
 
@@ -77,7 +78,7 @@ static int io_account_mem(struct io_ring_ctx *ctx, unsigned long nr_pages)
 	return 0;
 }
 
-static int io_buffer_validate(struct iovec *iov)
+int io_buffer_validate(struct iovec *iov)
 {
 	unsigned long tmp, acct_len = iov->iov_len + (PAGE_SIZE - 1);
 
@@ -110,10 +111,14 @@ static void io_buffer_unmap(struct io_ring_ctx *ctx, struct io_rsrc_node *node)
 
 		if (!refcount_dec_and_test(&imu->refs))
 			return;
-		for (i = 0; i < imu->nr_bvecs; i++)
-			unpin_user_page(imu->bvec[i].bv_page);
-		if (imu->acct_pages)
-			io_unaccount_mem(ctx, imu->acct_pages);
+		if (imu->is_kbuf) {
+			imu->release(imu->priv);
+		} else {
+			for (i = 0; i < imu->nr_bvecs; i++)
+				unpin_user_page(imu->bvec[i].bv_page);
+			if (imu->acct_pages)
+				io_unaccount_mem(ctx, imu->acct_pages);
+		}
 		kvfree(imu);
 	}
 }
@@ -578,7 +583,7 @@ static bool headpage_already_acct(struct io_ring_ctx *ctx, struct page **pages,
 		struct io_rsrc_node *node = ctx->buf_table.nodes[i];
 		struct io_mapped_ubuf *imu;
 
-		if (!node)
+		if (!node || node->buf->is_kbuf)
 			continue;
 		imu = node->buf;
 		for (j = 0; j < imu->nr_bvecs; j++) {
@@ -767,6 +772,10 @@ static struct io_rsrc_node *io_sqe_buffer_register(struct io_ring_ctx *ctx,
 	if (coalesced)
 		imu->folio_shift = data.folio_shift;
 	refcount_set(&imu->refs, 1);
+	imu->release = NULL;
+	imu->priv = NULL;
+	imu->is_kbuf = false;
+	imu->dir = IO_IMU_DEST | IO_IMU_SOURCE;
 	off = (unsigned long) iov->iov_base & ((1UL << imu->folio_shift) - 1);
 	node->buf = imu;
 	ret = 0;
@@ -860,19 +869,32 @@ int io_sqe_buffers_register(struct io_ring_ctx *ctx, void __user *arg,
 	return ret;
 }
 
+static int io_validate_fixed_range(u64 buf_addr, size_t len,
+				   const struct io_mapped_ubuf *imu)
+{
+	u64 buf_end;
+
+	if (unlikely(check_add_overflow(buf_addr, (u64)len, &buf_end)))
+		return -EFAULT;
+	/* not inside the mapped region */
+	if (unlikely(buf_addr < imu->ubuf || buf_end > (imu->ubuf + imu->len)))
+		return -EFAULT;
+	return 0;
+}
+
 int io_import_fixed(int ddir, struct iov_iter *iter,
 			   struct io_mapped_ubuf *imu,
 			   u64 buf_addr, size_t len)
 {
-	u64 buf_end;
 	size_t offset;
+	int ret;
 
 	if (WARN_ON_ONCE(!imu))
 		return -EFAULT;
-	if (unlikely(check_add_overflow(buf_addr, (u64)len, &buf_end)))
-		return -EFAULT;
-	/* not inside the mapped region */
-	if (unlikely(buf_addr < imu->ubuf || buf_end > (imu->ubuf + imu->len)))
+	ret = io_validate_fixed_range(buf_addr, len, imu);
+	if (unlikely(ret))
+		return ret;
+	if (!(imu->dir & (1 << ddir)))
 		return -EFAULT;
 
 	/*
@@ -882,7 +904,10 @@ int io_import_fixed(int ddir, struct iov_iter *iter,
 	offset = buf_addr - imu->ubuf;
 	iov_iter_bvec(iter, ddir, imu->bvec, imu->nr_bvecs, len);
 
-	if (offset) {
+	/* the bvecs of a kernel buffer can be of any size */
+	if (offset && imu->is_kbuf) {
+		iov_iter_advance(iter, offset);
+	} else if (offset) {
 		/*
 		 * Don't use iov_iter_advance() here, as it's really slow for
 		 * using the latter parts of a big fixed buffer - it iterates
@@ -919,6 +944,216 @@ int io_import_fixed(int ddir, struct iov_iter *iter,
 	return 0;
 }
 
+void io_vec_free(struct iou_vec *iv)
+{
+	kfree(iv->bvec);
+	iv->bvec = NULL;
+	iv->nr = 0;
+}
+
+static int io_vec_realloc(struct iou_vec *iv, unsigned nr_entries)
+{
+	struct bio_vec *bvec;
+
+	bvec = kmalloc_array(nr_entries, sizeof(*bvec), GFP_KERNEL);
+	if (!bvec)
+		return -ENOMEM;
+	io_vec_free(iv);
+	iv->bvec = bvec;
+	iv->nr = nr_entries;
+	return 0;
+}
+
+/*
+ * Vectored variant of io_import_fixed(). Every entry of @iov must fall inside
+ * @imu, the segments are translated into a bvec array stored in @vec, which
+ * is grown if needed and may be reused across requests by the caller.
+ */
+int io_import_reg_vec(int ddir, struct iov_iter *iter,
+		      struct io_mapped_ubuf *imu, const struct iovec *iov,
+		      unsigned nr_iovs, struct iou_vec *vec)
+{
+	unsigned long folio_size, folio_mask;
+	unsigned nr_bvecs = 0, bvec_idx = 0;
+	size_t total_len = 0;
+	u64 folio_addr;
+	unsigned i;
+	int ret;
+
+	if (WARN_ON_ONCE(!imu))
+		return -EFAULT;
+	/* kernel buffers don't have uniformly sized bvecs */
+	if (imu->is_kbuf)
+		return -EOPNOTSUPP;
+
+	for (i = 0; i < nr_iovs; i++) {
+		size_t len = iov[i].iov_len;
+
+		ret = io_validate_fixed_range((u64)(uintptr_t)iov[i].iov_base,
+					      len, imu);
+		if (unlikely(ret))
+			return ret;
+		total_len += len;
+		if (unlikely(total_len > MAX_RW_COUNT))
+			return -EINVAL;
+		/* a segment may straddle a partial head and tail folio */
+		nr_bvecs += (len >> imu->folio_shift) + 2;
+	}
+
+	if (vec->nr < nr_bvecs) {
+		ret = io_vec_realloc(vec, nr_bvecs);
+		if (unlikely(ret))
+			return ret;
+	}
+
+	folio_size = 1UL << imu->folio_shift;
+	folio_mask = folio_size - 1;
+	/*
+	 * Offsets are taken relative to the start of the folio the buffer
+	 * begins in, which accounts for the bv_offset of the first bvec.
+	 */
+	folio_addr = imu->ubuf & ~(u64)folio_mask;
+
+	for (i = 0; i < nr_iovs; i++) {
+		size_t len = iov[i].iov_len;
+		size_t offset = (u64)(uintptr_t)iov[i].iov_base - folio_addr;
+		const struct bio_vec *src;
+
+		src = imu->bvec + (offset >> imu->folio_shift);
+		offset &= folio_mask;
+
+		for (; len; offset = 0, src++) {
+			size_t seg = min_t(size_t, len, folio_size - offset);
+
+			bvec_set_page(&vec->bvec[bvec_idx++], src->bv_page,
+				      seg, offset);
+			len -= seg;
+		}
+	}
+
+	iov_iter_bvec(iter, ddir, vec->bvec, bvec_idx, total_len);
+	return 0;
+}
+
+/**
+ * io_buffer_register_bvec - register the pages of a request as a buffer
+ * @cmd: the uring_cmd doing the registration
+ * @rq: the request whose pages to register
+ * @release: called with @rq once the buffer isn't used any more
+ * @index: index in the registered buffer table of the ring of @cmd
+ * @issue_flags: issue flags of @cmd
+ *
+ * Make the data of @rq available to fixed buffer requests of the ring @cmd
+ * is issued on, at offset 0 of buffer @index, until it gets unregistered with
+ * io_buffer_unregister_bvec() and all the requests using it have completed.
+ * The buffer can only be used in the data direction of @rq: as destination
+ * for the data of a read request, and as source for that of a write.
+ *
+ * Return: 0 on success, -EBUSY if @index is in use or a negative errno.
+ */
+int io_buffer_register_bvec(struct io_uring_cmd *cmd, struct request *rq,
+			    void (*release)(void *), unsigned int index,
+			    unsigned int issue_flags)
+{
+	struct io_ring_ctx *ctx = cmd_to_io_kiocb(cmd)->ctx;
+	struct io_rsrc_data *data = &ctx->buf_table;
+	struct req_iterator rq_iter;
+	struct io_mapped_ubuf *imu;
+	struct io_rsrc_node *node;
+	unsigned int nr_bvecs = 0;
+	struct bio_vec bv, *bvec;
+	int ret = 0;
+
+	io_ring_submit_lock(ctx, issue_flags);
+	if (index >= data->nr) {
+		ret = -EINVAL;
+		goto unlock;
+	}
+	index = array_index_nospec(index, data->nr);
+
+	if (data->nodes[index]) {
+		ret = -EBUSY;
+		goto unlock;
+	}
+
+	node = io_rsrc_node_alloc(IORING_RSRC_BUFFER);
+	if (!node) {
+		ret = -ENOMEM;
+		goto unlock;
+	}
+
+	rq_for_each_bvec(bv, rq, rq_iter)
+		nr_bvecs++;
+
+	imu = kvmalloc(struct_size(imu, bvec, nr_bvecs), GFP_KERNEL);
+	if (!imu) {
+		kfree(node);
+		ret = -ENOMEM;
+		goto unlock;
+	}
+
+	imu->ubuf = 0;
+	imu->len = blk_rq_bytes(rq);
+	imu->nr_bvecs = nr_bvecs;
+	imu->folio_shift = PAGE_SHIFT;
+	refcount_set(&imu->refs, 1);
+	imu->acct_pages = 0;
+	imu->release = release;
+	imu->priv = rq;
+	imu->is_kbuf = true;
+	imu->dir = rq_data_dir(rq) == WRITE ? IO_IMU_SOURCE : IO_IMU_DEST;
+
+	bvec = imu->bvec;
+	rq_for_each_bvec(bv, rq, rq_iter)
+		*bvec++ = bv;
+
+	node->buf = imu;
+	data->nodes[index] = node;
+unlock:
+	io_ring_submit_unlock(ctx, issue_flags);
+	return ret;
+}
+EXPORT_SYMBOL_GPL(io_buffer_register_bvec);
+
+/**
+ * io_buffer_unregister_bvec - unregister a buffer added by
+ *	io_buffer_register_bvec()
+ * @cmd: a uring_cmd issued on the ring the buffer was registered on
+ * @index: index of the buffer
+ * @issue_flags: issue flags of @cmd
+ *
+ * The release callback of the buffer runs once the requests still using it
+ * have completed.
+ */
+int io_buffer_unregister_bvec(struct io_uring_cmd *cmd, unsigned int index,
+			      unsigned int issue_flags)
+{
+	struct io_ring_ctx *ctx = cmd_to_io_kiocb(cmd)->ctx;
+	struct io_rsrc_data *data = &ctx->buf_table;
+	struct io_rsrc_node *node;
+	int ret = 0;
+
+	io_ring_submit_lock(ctx, issue_flags);
+	if (index >= data->nr) {
+		ret = -EINVAL;
+		goto unlock;
+	}
+	index = array_index_nospec(index, data->nr);
+
+	node = data->nodes[index];
+	if (!node || !node->buf->is_kbuf) {
+		ret = -EINVAL;
+		goto unlock;
+	}
+
+	io_put_rsrc_node(ctx, node);
+	data->nodes[index] = NULL;
+unlock:
+	io_ring_submit_unlock(ctx, issue_flags);
+	return ret;
+}
+EXPORT_SYMBOL_GPL(io_buffer_unregister_bvec);
+
 /* Lock two rings at once. The rings must be different! */
 static void lock_two_rings(struct io_ring_ctx *ctx1, struct io_ring_ctx *ctx2)
 {
@@ -20,6 +20,11 @@ struct io_rsrc_node {
 	};
 };
 
+enum {
+	IO_IMU_DEST	= 1 << ITER_DEST,
+	IO_IMU_SOURCE	= 1 << ITER_SOURCE,
+};
+
 struct io_mapped_ubuf {
 	u64		ubuf;
 	unsigned int	len;
@@ -27,6 +32,12 @@ struct io_mapped_ubuf {
 	unsigned int    folio_shift;
 	refcount_t	refs;
 	unsigned long	acct_pages;
+	/* kernel buffers are given back with @release instead of unpinned */
+	void		(*release)(void *);
+	void		*priv;
+	bool		is_kbuf;
+	/* allowed directions, IO_IMU_* */
+	u8		dir;
 	struct bio_vec	bvec[] __counted_by(nr_bvecs);
 };
 
@@ -47,6 +58,10 @@ int io_rsrc_data_alloc(struct io_rsrc_data *data, unsigned nr);
 int io_import_fixed(int ddir, struct iov_iter *iter,
 			   struct io_mapped_ubuf *imu,
 			   u64 buf_addr, size_t len);
+int io_import_reg_vec(int ddir, struct iov_iter *iter,
+		      struct io_mapped_ubuf *imu, const struct iovec *iov,
+		      unsigned nr_iovs, struct iou_vec *vec);
+void io_vec_free(struct iou_vec *iv);
 
 int io_register_clone_buffers(struct io_ring_ctx *ctx, void __user *arg);
 int io_sqe_buffers_unregister(struct io_ring_ctx *ctx);
@@ -122,6 +137,7 @@ static inline void io_req_assign_buf_node(struct io_kiocb *req,
 int io_files_update(struct io_kiocb *req, unsigned int issue_flags);
 int io_files_update_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe);
 
+int io_buffer_validate(struct iovec *iov);
 int __io_account_mem(struct user_struct *user, unsigned long nr_pages);
 
 static inline void __io_unaccount_mem(struct user_struct *user,
@@ -149,6 +149,16 @@ static inline int io_import_iovec(int rw, struct io_kiocb *req,
 	return 0;
 }
 
+static void io_rw_iovec_free(struct io_async_rw *rw)
+{
+	if (rw->free_iovec) {
+		kfree(rw->free_iovec);
+		rw->free_iov_nr = 0;
+		rw->free_iovec = NULL;
+	}
+	io_vec_free(&rw->vec);
+}
+
 static void io_rw_recycle(struct io_kiocb *req, unsigned int issue_flags)
 {
 	struct io_async_rw *rw = req->async_data;
@@ -157,9 +167,14 @@ static void io_rw_recycle(struct io_kiocb *req, unsigned int issue_flags)
 		return;
 
 	io_alloc_cache_kasan(&rw->free_iovec, &rw->free_iov_nr);
+	if (IS_ENABLED(CONFIG_KASAN))
+		io_vec_free(&rw->vec);
 	if (io_alloc_cache_put(&req->ctx->rw_cache, rw)) {
 		req->async_data = NULL;
 		req->flags &= ~REQ_F_ASYNC_DATA;
+	} else {
+		/* async_data is freed as-is, don't leak the vectors */
+		io_rw_iovec_free(rw);
 	}
 }
 
@@ -206,7 +221,7 @@ static int io_rw_alloc_async(struct io_kiocb *req)
 	rw = io_uring_alloc_async_data(&ctx->rw_cache, req);
 	if (!rw)
 		return -ENOMEM;
-	if (rw->free_iovec)
+	if (rw->free_iovec || rw->vec.nr)
 		req->flags |= REQ_F_NEED_CLEANUP;
 	rw->bytes_done = 0;
 	return 0;
@@ -392,6 +407,53 @@ int io_prep_write_fixed(struct io_kiocb *req, const struct io_uring_sqe *sqe)
 	return io_prep_rw_fixed(req, sqe, ITER_SOURCE);
 }
 
+static int io_prep_rwv_fixed(struct io_kiocb *req,
+			     const struct io_uring_sqe *sqe, int ddir)
+{
+	struct io_rw *rw = io_kiocb_to_cmd(req, struct io_rw);
+	struct iovec iovstack[UIO_FASTIOV], *iov;
+	struct io_ring_ctx *ctx = req->ctx;
+	struct io_rsrc_node *node;
+	struct io_async_rw *io;
+	int ret;
+
+	ret = io_prep_rw(req, sqe, ddir, false);
+	if (unlikely(ret))
+		return ret;
+
+	node = io_rsrc_node_lookup(&ctx->buf_table, req->buf_index);
+	if (!node)
+		return -EFAULT;
+	io_req_assign_buf_node(req, node);
+
+	iov = iovec_from_user(u64_to_user_ptr(rw->addr), rw->len, UIO_FASTIOV,
+			      iovstack, ctx->compat);
+	if (IS_ERR(iov))
+		return PTR_ERR(iov);
+
+	io = req->async_data;
+	ret = io_import_reg_vec(ddir, &io->iter, node->buf, iov, rw->len,
+				&io->vec);
+	if (iov != iovstack)
+		kfree(iov);
+	if (io->vec.nr)
+		req->flags |= REQ_F_NEED_CLEANUP;
+	if (unlikely(ret))
+		return ret;
+	iov_iter_save_state(&io->iter, &io->iter_state);
+	return 0;
+}
+
+int io_prep_readv_fixed(struct io_kiocb *req, const struct io_uring_sqe *sqe)
+{
+	return io_prep_rwv_fixed(req, sqe, ITER_DEST);
+}
+
+int io_prep_writev_fixed(struct io_kiocb *req, const struct io_uring_sqe *sqe)
+{
+	return io_prep_rwv_fixed(req, sqe, ITER_SOURCE);
+}
+
 /*
  * Multishot read is prepared just like a normal read/write request, only
  * difference is that we set the MULTISHOT flag.
@@ -1311,7 +1373,6 @@ void io_rw_cache_free(const void *entry)
 {
 	struct io_async_rw *rw = (struct io_async_rw *) entry;
 
-	if (rw->free_iovec)
-		kfree(rw->free_iovec);
+	io_rw_iovec_free(rw);
 	kfree(rw);
 }
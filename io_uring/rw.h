@@ -10,6 +10,8 @@ struct io_meta_state {
 struct io_async_rw {
 	size_t				bytes_done;
 	struct iovec			*free_iovec;
+	/* bvecs for the registered buffer vectored variants */
+	struct iou_vec			vec;
 	struct_group(clear,
 		struct iov_iter			iter;
 		struct iov_iter_state		iter_state;
@@ -31,6 +33,8 @@ struct io_async_rw {
 
 int io_prep_read_fixed(struct io_kiocb *req, const struct io_uring_sqe *sqe);
 int io_prep_write_fixed(struct io_kiocb *req, const struct io_uring_sqe *sqe);
+int io_prep_readv_fixed(struct io_kiocb *req, const struct io_uring_sqe *sqe);
+int io_prep_writev_fixed(struct io_kiocb *req, const struct io_uring_sqe *sqe);
 int io_prep_readv(struct io_kiocb *req, const struct io_uring_sqe *sqe);
 int io_prep_writev(struct io_kiocb *req, const struct io_uring_sqe *sqe);
 int io_prep_read(struct io_kiocb *req, const struct io_uring_sqe *sqe);
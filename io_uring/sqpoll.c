@@ -11,6 +11,7 @@
 #include <linux/audit.h>
 #include <linux/security.h>
 #include <linux/cpuset.h>
+#include <linux/sched/clock.h>
 #include <linux/io_uring.h>
 
 #include <uapi/linux/io_uring.h>
@@ -20,6 +21,7 @@
 #include "sqpoll.h"
 
 #define IORING_SQPOLL_CAP_ENTRIES_VALUE 8
+#define IORING_SQPOLL_MAX_WEIGHT	64
 #define IORING_TW_CAP_ENTRIES_VALUE	8
 
 enum {
@@ -160,18 +162,37 @@ static inline bool io_sqd_events_pending(struct io_sq_data *sqd)
 	return READ_ONCE(sqd->state);
 }
 
+/*
+ * If we're handling multiple rings, cap the submit size for fairness. Rings
+ * are served deficit round robin: every round a backlogged ring earns a
+ * quantum scaled by its weight, and may carry up to one extra quantum over
+ * if it couldn't use it all. An idle ring forfeits its credit.
+ */
+static unsigned int io_sq_cap_entries(struct io_ring_ctx *ctx,
+				      unsigned int to_submit)
+{
+	unsigned int quantum = IORING_SQPOLL_CAP_ENTRIES_VALUE * ctx->sq_weight;
+
+	if (!to_submit) {
+		ctx->sq_deficit = 0;
+		return 0;
+	}
+	ctx->sq_deficit = min(ctx->sq_deficit + quantum, 2 * quantum);
+	return min(to_submit, ctx->sq_deficit);
+}
+
 static int __io_sq_thread(struct io_ring_ctx *ctx, bool cap_entries)
 {
 	unsigned int to_submit;
 	int ret = 0;
 
 	to_submit = io_sqring_entries(ctx);
-	/* if we're handling multiple rings, cap submit size for fairness */
-	if (cap_entries && to_submit > IORING_SQPOLL_CAP_ENTRIES_VALUE)
-		to_submit = IORING_SQPOLL_CAP_ENTRIES_VALUE;
+	if (cap_entries)
+		to_submit = io_sq_cap_entries(ctx, to_submit);
 
 	if (to_submit || !wq_list_empty(&ctx->iopoll_list)) {
 		const struct cred *creds = NULL;
+		u64 start = local_clock();
 
 		if (ctx->sq_creds != current_cred())
 			creds = override_creds(ctx->sq_creds);
@@ -193,6 +214,14 @@ static int __io_sq_thread(struct io_ring_ctx *ctx, bool cap_entries)
 			wake_up(&ctx->sqo_sq_wait);
 		if (creds)
 			revert_creds(creds);
+
+		if (ret > 0) {
+			ctx->sq_submitted += ret;
+			if (cap_entries)
+				ctx->sq_deficit -= min_t(unsigned int, ret,
+							 ctx->sq_deficit);
+		}
+		ctx->sq_busy_time += local_clock() - start;
 	}
 
 	return ret;
@@ -438,6 +467,7 @@ __cold int io_sq_offload_create(struct io_ring_ctx *ctx,
 
 		ctx->sq_creds = get_current_cred();
 		ctx->sq_data = sqd;
+		ctx->sq_weight = 1;
 		ctx->sq_thread_idle = msecs_to_jiffies(p->sq_thread_idle);
 		if (!ctx->sq_thread_idle)
 			ctx->sq_thread_idle = HZ;
@@ -524,3 +554,19 @@ __cold int io_sqpoll_wq_cpu_affinity(struct io_ring_ctx *ctx,
 
 	return ret;
 }
+
+__cold int io_sqpoll_set_weight(struct io_ring_ctx *ctx, unsigned int weight)
+{
+	struct io_sq_data *sqd = ctx->sq_data;
+
+	if (!sqd)
+		return -EINVAL;
+	if (!weight || weight > IORING_SQPOLL_MAX_WEIGHT)
+		return -EINVAL;
+
+	io_sq_thread_park(sqd);
+	ctx->sq_weight = weight;
+	ctx->sq_deficit = 0;
+	io_sq_thread_unpark(sqd);
+	return 0;
+}
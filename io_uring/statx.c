@@ -46,7 +46,12 @@ int io_statx_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe)
 	}
 
 	req->flags |= REQ_F_NEED_CLEANUP;
-	req->flags |= REQ_F_FORCE_ASYNC;
+	/*
+	 * With AT_STATX_DONT_SYNC the attributes come from the inode cache,
+	 * so try the lookup inline and only punt if it leaves the dcache.
+	 */
+	if (!(sx->flags & AT_STATX_DONT_SYNC))
+		req->flags |= REQ_F_FORCE_ASYNC;
 	return 0;
 }
 
@@ -55,9 +60,16 @@ int io_statx(struct io_kiocb *req, unsigned int issue_flags)
 	struct io_statx *sx = io_kiocb_to_cmd(req, struct io_statx);
 	int ret;
 
-	WARN_ON_ONCE(issue_flags & IO_URING_F_NONBLOCK);
-
-	ret = do_statx(sx->dfd, sx->filename, sx->flags, sx->mask, sx->buffer);
+	if (issue_flags & IO_URING_F_NONBLOCK) {
+		WARN_ON_ONCE(!(sx->flags & AT_STATX_DONT_SYNC));
+		ret = do_statx_cached(sx->dfd, sx->filename, sx->flags,
+				      sx->mask, sx->buffer);
+		if (ret == -EAGAIN)
+			return -EAGAIN;
+	} else {
+		ret = do_statx(sx->dfd, sx->filename, sx->flags, sx->mask,
+			       sx->buffer);
+	}
 	io_req_set_res(req, ret, 0);
 	return IOU_OK;
 }
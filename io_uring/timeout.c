@@ -64,6 +64,12 @@ static inline bool io_timeout_finish(struct io_timeout *timeout,
 }
 
 static enum hrtimer_restart io_timeout_fn(struct hrtimer *timer);
+static bool io_timeout_try_cancel(struct io_ring_ctx *ctx,
+				  struct io_timeout_data *data);
+static void io_timeout_start(struct io_ring_ctx *ctx,
+			     struct io_timeout_data *data,
+			     struct timespec64 *ts, enum hrtimer_mode mode,
+			     enum hrtimer_restart (*fn)(struct hrtimer *));
 
 static void io_timeout_complete(struct io_kiocb *req, struct io_tw_state *ts)
 {
@@ -76,7 +82,8 @@ static void io_timeout_complete(struct io_kiocb *req, struct io_tw_state *ts)
 			/* re-arm timer */
 			raw_spin_lock_irq(&ctx->timeout_lock);
 			list_add(&timeout->list, ctx->timeout_list.prev);
-			hrtimer_start(&data->timer, timespec64_to_ktime(data->ts), data->mode);
+			io_timeout_start(ctx, data, &data->ts, data->mode,
+					 io_timeout_fn);
 			raw_spin_unlock_irq(&ctx->timeout_lock);
 			return;
 		}
@@ -110,7 +117,7 @@ static void io_kill_timeout(struct io_kiocb *req, struct list_head *list)
 {
 	struct io_timeout_data *io = req->async_data;
 
-	if (hrtimer_try_to_cancel(&io->timer) != -1) {
+	if (io_timeout_try_cancel(req->ctx, io)) {
 		struct io_timeout *timeout = io_kiocb_to_cmd(req, struct io_timeout);
 
 		atomic_set(&req->ctx->cq_timeouts,
@@ -238,7 +245,7 @@ struct io_kiocb *__io_disarm_linked_timeout(struct io_kiocb *req,
 
 	io_remove_next_linked(req);
 	timeout->head = NULL;
-	if (hrtimer_try_to_cancel(&io->timer) != -1) {
+	if (io_timeout_try_cancel(req->ctx, io)) {
 		list_del(&timeout->list);
 		return link;
 	}
@@ -246,20 +253,19 @@ struct io_kiocb *__io_disarm_linked_timeout(struct io_kiocb *req,
 	return NULL;
 }
 
-static enum hrtimer_restart io_timeout_fn(struct hrtimer *timer)
+static void io_timeout_expire(struct io_kiocb *req)
+	__must_hold(&req->ctx->timeout_lock)
 {
-	struct io_timeout_data *data = container_of(timer,
-						struct io_timeout_data, timer);
-	struct io_kiocb *req = data->req;
 	struct io_timeout *timeout = io_kiocb_to_cmd(req, struct io_timeout);
-	struct io_ring_ctx *ctx = req->ctx;
-	unsigned long flags;
 
-	raw_spin_lock_irqsave(&ctx->timeout_lock, flags);
 	list_del_init(&timeout->list);
 	atomic_set(&req->ctx->cq_timeouts,
 		atomic_read(&req->ctx->cq_timeouts) + 1);
-	raw_spin_unlock_irqrestore(&ctx->timeout_lock, flags);
+}
+
+static void io_timeout_expire_tw(struct io_kiocb *req)
+{
+	struct io_timeout_data *data = req->async_data;
 
 	if (!(data->flags & IORING_TIMEOUT_ETIME_SUCCESS))
 		req_set_fail(req);
@@ -267,6 +273,21 @@ static enum hrtimer_restart io_timeout_fn(struct hrtimer *timer)
 	io_req_set_res(req, -ETIME, 0);
 	req->io_task_work.func = io_timeout_complete;
 	io_req_task_work_add(req);
+}
+
+static enum hrtimer_restart io_timeout_fn(struct hrtimer *timer)
+{
+	struct io_timeout_data *data = container_of(timer,
+						struct io_timeout_data, timer);
+	struct io_kiocb *req = data->req;
+	struct io_ring_ctx *ctx = req->ctx;
+	unsigned long flags;
+
+	raw_spin_lock_irqsave(&ctx->timeout_lock, flags);
+	io_timeout_expire(req);
+	raw_spin_unlock_irqrestore(&ctx->timeout_lock, flags);
+
+	io_timeout_expire_tw(req);
 	return HRTIMER_NORESTART;
 }
 
@@ -290,7 +311,7 @@ static struct io_kiocb *io_timeout_extract(struct io_ring_ctx *ctx,
 		return ERR_PTR(-ENOENT);
 
 	io = req->async_data;
-	if (hrtimer_try_to_cancel(&io->timer) == -1)
+	if (!io_timeout_try_cancel(ctx, io))
 		return ERR_PTR(-EALREADY);
 	timeout = io_kiocb_to_cmd(req, struct io_timeout);
 	list_del_init(&timeout->list);
@@ -338,16 +359,12 @@ static void io_req_task_link_timeout(struct io_kiocb *req, struct io_tw_state *t
 	}
 }
 
-static enum hrtimer_restart io_link_timeout_fn(struct hrtimer *timer)
+static void io_link_timeout_expire(struct io_kiocb *req)
+	__must_hold(&req->ctx->timeout_lock)
 {
-	struct io_timeout_data *data = container_of(timer,
-						struct io_timeout_data, timer);
-	struct io_kiocb *prev, *req = data->req;
 	struct io_timeout *timeout = io_kiocb_to_cmd(req, struct io_timeout);
-	struct io_ring_ctx *ctx = req->ctx;
-	unsigned long flags;
+	struct io_kiocb *prev;
 
-	raw_spin_lock_irqsave(&ctx->timeout_lock, flags);
 	prev = timeout->head;
 	timeout->head = NULL;
 
@@ -362,10 +379,27 @@ static enum hrtimer_restart io_link_timeout_fn(struct hrtimer *timer)
 	}
 	list_del(&timeout->list);
 	timeout->prev = prev;
-	raw_spin_unlock_irqrestore(&ctx->timeout_lock, flags);
+}
 
+static void io_link_timeout_expire_tw(struct io_kiocb *req)
+{
 	req->io_task_work.func = io_req_task_link_timeout;
 	io_req_task_work_add(req);
+}
+
+static enum hrtimer_restart io_link_timeout_fn(struct hrtimer *timer)
+{
+	struct io_timeout_data *data = container_of(timer,
+						struct io_timeout_data, timer);
+	struct io_kiocb *req = data->req;
+	struct io_ring_ctx *ctx = req->ctx;
+	unsigned long flags;
+
+	raw_spin_lock_irqsave(&ctx->timeout_lock, flags);
+	io_link_timeout_expire(req);
+	raw_spin_unlock_irqrestore(&ctx->timeout_lock, flags);
+
+	io_link_timeout_expire_tw(req);
 	return HRTIMER_NORESTART;
 }
 
@@ -385,6 +419,294 @@ static clockid_t io_timeout_get_clock(struct io_timeout_data *data)
 	}
 }
 
+/*
+ * With IORING_SETUP_COARSE_TIMEOUTS, relative CLOCK_MONOTONIC timeouts are
+ * kept on a per-ring two level timer wheel with jiffy resolution instead of
+ * each arming its own hrtimer. The first level has a slot per jiffy for the
+ * next IO_TW_L0_SIZE jiffies, the second a slot per IO_TW_L0_SIZE jiffies,
+ * and entries are cascaded down as the wheel turns. Anything further out is
+ * parked in the last second level slot and cascaded again until it's near
+ * enough. Everything is protected by ->timeout_lock. A single timer_list
+ * drives the wheel, and it's also advanced when completions are flushed so
+ * that busy rings expire timeouts in batches without waiting for the timer.
+ */
+#define IO_TW_L0_BITS		8
+#define IO_TW_L1_BITS		6
+#define IO_TW_L0_SIZE		(1UL << IO_TW_L0_BITS)
+#define IO_TW_L1_SIZE		(1UL << IO_TW_L1_BITS)
+#define IO_TW_L0_MASK		(IO_TW_L0_SIZE - 1)
+#define IO_TW_L1_MASK		(IO_TW_L1_SIZE - 1)
+#define IO_TW_MAX_DELTA		((IO_TW_L1_SIZE - 1) << IO_TW_L0_BITS)
+/* max timeouts expired per ->timeout_lock hold */
+#define IO_TW_BATCH		32
+
+enum {
+	IO_TW_IDLE,
+	IO_TW_L0,
+	IO_TW_L1,
+	/* taken off the wheel, expiry in progress */
+	IO_TW_FIRING,
+};
+
+struct io_timer_wheel {
+	struct io_ring_ctx	*ctx;
+	struct timer_list	timer;
+	/* next jiffy to expire */
+	unsigned long		clk;
+	unsigned int		nr_l0;
+	unsigned int		nr_l1;
+	struct list_head	l0[IO_TW_L0_SIZE];
+	struct list_head	l1[IO_TW_L1_SIZE];
+};
+
+static void io_wheel_insert(struct io_timer_wheel *wh,
+			    struct io_timeout_data *data)
+	__must_hold(&wh->ctx->timeout_lock)
+{
+	unsigned long expires = data->expires;
+	unsigned long delta;
+
+	if (time_before(expires, wh->clk))
+		expires = wh->clk;
+	delta = expires - wh->clk;
+
+	if (delta < IO_TW_L0_SIZE) {
+		list_add_tail(&data->wheel_node,
+			      &wh->l0[expires & IO_TW_L0_MASK]);
+		data->wheel_state = IO_TW_L0;
+		wh->nr_l0++;
+		return;
+	}
+	if (delta > IO_TW_MAX_DELTA)
+		expires = wh->clk + IO_TW_MAX_DELTA;
+	list_add_tail(&data->wheel_node,
+		      &wh->l1[(expires >> IO_TW_L0_BITS) & IO_TW_L1_MASK]);
+	data->wheel_state = IO_TW_L1;
+	wh->nr_l1++;
+}
+
+static void io_wheel_del(struct io_timer_wheel *wh,
+			 struct io_timeout_data *data)
+	__must_hold(&wh->ctx->timeout_lock)
+{
+	list_del(&data->wheel_node);
+	if (data->wheel_state == IO_TW_L0)
+		wh->nr_l0--;
+	else
+		wh->nr_l1--;
+}
+
+static void io_wheel_cascade(struct io_timer_wheel *wh)
+	__must_hold(&wh->ctx->timeout_lock)
+{
+	struct io_timeout_data *data, *tmp;
+	LIST_HEAD(list);
+
+	list_splice_init(&wh->l1[(wh->clk >> IO_TW_L0_BITS) & IO_TW_L1_MASK],
+			 &list);
+	list_for_each_entry_safe(data, tmp, &list, wheel_node) {
+		wh->nr_l1--;
+		io_wheel_insert(wh, data);
+	}
+}
+
+/*
+ * Take up to IO_TW_BATCH timeouts that are due by @now off the wheel and run
+ * the locked part of their expiry. Returns the number of entries in @batch.
+ */
+static unsigned int io_wheel_collect(struct io_timer_wheel *wh,
+				     unsigned long now,
+				     struct io_kiocb **batch)
+	__must_hold(&wh->ctx->timeout_lock)
+{
+	unsigned int nr = 0;
+
+	while (!time_after(wh->clk, now)) {
+		struct list_head *head = &wh->l0[wh->clk & IO_TW_L0_MASK];
+
+		if (!(wh->clk & IO_TW_L0_MASK) && wh->nr_l1)
+			io_wheel_cascade(wh);
+
+		while (!list_empty(head)) {
+			struct io_timeout_data *data;
+
+			if (nr == IO_TW_BATCH)
+				return nr;
+			data = list_first_entry(head, struct io_timeout_data,
+						wheel_node);
+			io_wheel_del(wh, data);
+			data->wheel_state = IO_TW_FIRING;
+			if (data->req->opcode == IORING_OP_LINK_TIMEOUT)
+				io_link_timeout_expire(data->req);
+			else
+				io_timeout_expire(data->req);
+			batch[nr++] = data->req;
+		}
+
+		/* nothing on the first level, skip ahead to the next cascade */
+		if (!wh->nr_l0) {
+			unsigned long next = (wh->clk | IO_TW_L0_MASK) + 1;
+
+			if (!wh->nr_l1 || time_after(next, now + 1))
+				next = now + 1;
+			wh->clk = next;
+			continue;
+		}
+		wh->clk++;
+	}
+	return nr;
+}
+
+static void io_wheel_rearm(struct io_timer_wheel *wh)
+	__must_hold(&wh->ctx->timeout_lock)
+{
+	unsigned long next;
+
+	if (wh->nr_l0) {
+		unsigned long i;
+
+		for (i = 0; i < IO_TW_L0_SIZE; i++) {
+			next = wh->clk + i;
+			if (!list_empty(&wh->l0[next & IO_TW_L0_MASK]))
+				break;
+		}
+	} else if (wh->nr_l1) {
+		next = (wh->clk | IO_TW_L0_MASK) + 1;
+	} else {
+		return;
+	}
+	timer_reduce(&wh->timer, next);
+}
+
+static void io_wheel_run(struct io_timer_wheel *wh)
+{
+	struct io_ring_ctx *ctx = wh->ctx;
+	struct io_kiocb *batch[IO_TW_BATCH];
+	unsigned int i, nr;
+	unsigned long flags;
+
+	do {
+		raw_spin_lock_irqsave(&ctx->timeout_lock, flags);
+		nr = io_wheel_collect(wh, jiffies, batch);
+		if (nr < IO_TW_BATCH)
+			io_wheel_rearm(wh);
+		raw_spin_unlock_irqrestore(&ctx->timeout_lock, flags);
+
+		for (i = 0; i < nr; i++) {
+			if (batch[i]->opcode == IORING_OP_LINK_TIMEOUT)
+				io_link_timeout_expire_tw(batch[i]);
+			else
+				io_timeout_expire_tw(batch[i]);
+		}
+	} while (nr == IO_TW_BATCH);
+}
+
+static void io_wheel_timer_fn(struct timer_list *timer)
+{
+	io_wheel_run(from_timer(wh, timer, timer));
+}
+
+void io_timeout_wheel_flush(struct io_ring_ctx *ctx)
+{
+	struct io_timer_wheel *wh = ctx->timer_wheel;
+
+	if (!time_after(data_race(wh->clk), jiffies))
+		io_wheel_run(wh);
+}
+
+int io_timeout_wheel_init(struct io_ring_ctx *ctx)
+{
+	struct io_timer_wheel *wh;
+	int i;
+
+	wh = kmalloc(sizeof(*wh), GFP_KERNEL_ACCOUNT);
+	if (!wh)
+		return -ENOMEM;
+	wh->ctx = ctx;
+	wh->clk = jiffies;
+	wh->nr_l0 = wh->nr_l1 = 0;
+	for (i = 0; i < IO_TW_L0_SIZE; i++)
+		INIT_LIST_HEAD(&wh->l0[i]);
+	for (i = 0; i < IO_TW_L1_SIZE; i++)
+		INIT_LIST_HEAD(&wh->l1[i]);
+	timer_setup(&wh->timer, io_wheel_timer_fn, 0);
+	ctx->timer_wheel = wh;
+	ctx->coarse_timeouts = 1;
+	return 0;
+}
+
+void io_timeout_wheel_free(struct io_ring_ctx *ctx)
+{
+	struct io_timer_wheel *wh = ctx->timer_wheel;
+
+	if (!wh)
+		return;
+	timer_shutdown_sync(&wh->timer);
+	WARN_ON_ONCE(wh->nr_l0 || wh->nr_l1);
+	kfree(wh);
+	ctx->timer_wheel = NULL;
+}
+
+static void io_timeout_init_timer(struct io_ring_ctx *ctx,
+				  struct io_timeout_data *data,
+				  enum hrtimer_mode mode)
+{
+	clockid_t clock = io_timeout_get_clock(data);
+
+	data->wheel = ctx->timer_wheel && mode == HRTIMER_MODE_REL &&
+			clock == CLOCK_MONOTONIC;
+	if (data->wheel)
+		data->wheel_state = IO_TW_IDLE;
+	else
+		hrtimer_init(&data->timer, clock, mode);
+}
+
+static void io_timeout_start(struct io_ring_ctx *ctx,
+			     struct io_timeout_data *data,
+			     struct timespec64 *ts, enum hrtimer_mode mode,
+			     enum hrtimer_restart (*fn)(struct hrtimer *))
+	__must_hold(&ctx->timeout_lock)
+{
+	struct io_timer_wheel *wh = ctx->timer_wheel;
+
+	if (!data->wheel) {
+		data->timer.function = fn;
+		hrtimer_start(&data->timer, timespec64_to_ktime(*ts), mode);
+		return;
+	}
+
+	/* an empty wheel may not have been turned in a while */
+	if (!wh->nr_l0 && !wh->nr_l1)
+		wh->clk = jiffies;
+	data->expires = jiffies + timespec64_to_jiffies(ts);
+	io_wheel_insert(wh, data);
+	timer_reduce(&wh->timer, max(data->expires, wh->clk));
+}
+
+/*
+ * Returns true if the timeout was stopped before its expiry ran, false if
+ * expiry is already in progress.
+ */
+static bool io_timeout_try_cancel(struct io_ring_ctx *ctx,
+				  struct io_timeout_data *data)
+	__must_hold(&ctx->timeout_lock)
+{
+	if (!data->wheel)
+		return hrtimer_try_to_cancel(&data->timer) != -1;
+
+	switch (data->wheel_state) {
+	case IO_TW_FIRING:
+		return false;
+	case IO_TW_L0:
+	case IO_TW_L1:
+		io_wheel_del(ctx->timer_wheel, data);
+		data->wheel_state = IO_TW_IDLE;
+		fallthrough;
+	default:
+		return true;
+	}
+}
+
 static int io_linked_timeout_update(struct io_ring_ctx *ctx, __u64 user_data,
 				    struct timespec64 *ts, enum hrtimer_mode mode)
 	__must_hold(&ctx->timeout_lock)
@@ -405,11 +727,10 @@ static int io_linked_timeout_update(struct io_ring_ctx *ctx, __u64 user_data,
 		return -ENOENT;
 
 	io = req->async_data;
-	if (hrtimer_try_to_cancel(&io->timer) == -1)
+	if (!io_timeout_try_cancel(ctx, io))
 		return -EALREADY;
-	hrtimer_init(&io->timer, io_timeout_get_clock(io), mode);
-	io->timer.function = io_link_timeout_fn;
-	hrtimer_start(&io->timer, timespec64_to_ktime(*ts), mode);
+	io_timeout_init_timer(ctx, io, mode);
+	io_timeout_start(ctx, io, ts, mode, io_link_timeout_fn);
 	return 0;
 }
 
@@ -430,9 +751,8 @@ static int io_timeout_update(struct io_ring_ctx *ctx, __u64 user_data,
 	data->ts = *ts;
 
 	list_add_tail(&timeout->list, &ctx->timeout_list);
-	hrtimer_init(&data->timer, io_timeout_get_clock(data), mode);
-	data->timer.function = io_timeout_fn;
-	hrtimer_start(&data->timer, timespec64_to_ktime(data->ts), mode);
+	io_timeout_init_timer(ctx, data, mode);
+	io_timeout_start(ctx, data, &data->ts, mode, io_timeout_fn);
 	return 0;
 }
 
@@ -557,7 +877,7 @@ static int __io_timeout_prep(struct io_kiocb *req,
 		return -EINVAL;
 
 	data->mode = io_translate_timeout_mode(flags);
-	hrtimer_init(&data->timer, io_timeout_get_clock(data), data->mode);
+	io_timeout_init_timer(req->ctx, data, data->mode);
 
 	if (is_timeout_link) {
 		struct io_submit_link *link = &req->ctx->submit_state.link;
@@ -627,8 +947,7 @@ int io_timeout(struct io_kiocb *req, unsigned int issue_flags)
 	}
 add:
 	list_add(&timeout->list, entry);
-	data->timer.function = io_timeout_fn;
-	hrtimer_start(&data->timer, timespec64_to_ktime(data->ts), data->mode);
+	io_timeout_start(ctx, data, &data->ts, data->mode, io_timeout_fn);
 	raw_spin_unlock_irq(&ctx->timeout_lock);
 	return IOU_ISSUE_SKIP_COMPLETE;
 }
@@ -646,9 +965,8 @@ void io_queue_linked_timeout(struct io_kiocb *req)
 	if (timeout->head) {
 		struct io_timeout_data *data = req->async_data;
 
-		data->timer.function = io_link_timeout_fn;
-		hrtimer_start(&data->timer, timespec64_to_ktime(data->ts),
-				data->mode);
+		io_timeout_start(ctx, data, &data->ts, data->mode,
+				 io_link_timeout_fn);
 		list_add_tail(&timeout->list, &ctx->ltimeout_list);
 	}
 	raw_spin_unlock_irq(&ctx->timeout_lock);
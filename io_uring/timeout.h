@@ -2,10 +2,20 @@
 
 struct io_timeout_data {
 	struct io_kiocb			*req;
-	struct hrtimer			timer;
+	union {
+		struct hrtimer		timer;
+		/* IORING_SETUP_COARSE_TIMEOUTS, see ->wheel */
+		struct {
+			struct list_head	wheel_node;
+			unsigned long		expires;
+			u8			wheel_state;
+		};
+	};
 	struct timespec64		ts;
 	enum hrtimer_mode		mode;
 	u32				flags;
+	/* armed on the ring's timer wheel rather than as an hrtimer */
+	bool				wheel;
 };
 
 struct io_kiocb *__io_disarm_linked_timeout(struct io_kiocb *req,
@@ -22,6 +32,9 @@ static inline struct io_kiocb *io_disarm_linked_timeout(struct io_kiocb *req)
 }
 
 __cold void io_flush_timeouts(struct io_ring_ctx *ctx);
+int io_timeout_wheel_init(struct io_ring_ctx *ctx);
+void io_timeout_wheel_free(struct io_ring_ctx *ctx);
+void io_timeout_wheel_flush(struct io_ring_ctx *ctx);
 struct io_cancel_data;
 int io_timeout_cancel(struct io_ring_ctx *ctx, struct io_cancel_data *cd);
 __cold bool io_kill_timeouts(struct io_ring_ctx *ctx, struct io_uring_task *tctx,
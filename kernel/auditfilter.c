@@ -896,6 +896,39 @@ struct audit_entry *audit_dupe_rule(struct audit_krule *old)
 	return entry;
 }
 
+#ifdef CONFIG_AUDITSYSCALL
+/* Add the syscalls of exit rule @r to audit_exit_mask. */
+static void audit_exit_mask_add(struct audit_krule *r)
+{
+	int i;
+
+	if (r->listnr != AUDIT_FILTER_EXIT)
+		return;
+
+	for (i = 0; i < AUDIT_BITMASK_SIZE; i++)
+		WRITE_ONCE(audit_exit_mask[i], audit_exit_mask[i] | r->mask[i]);
+}
+
+/*
+ * Rebuild audit_exit_mask from the remaining exit rules, which include
+ * the watch and inode rules hashed on audit_inode_hash.
+ * Caller must hold audit_filter_mutex.
+ */
+static void audit_exit_mask_rebuild(void)
+{
+	u32 mask[AUDIT_BITMASK_SIZE] = { 0 };
+	struct audit_krule *r;
+	int i;
+
+	list_for_each_entry(r, &audit_rules_list[AUDIT_FILTER_EXIT], list)
+		for (i = 0; i < AUDIT_BITMASK_SIZE; i++)
+			mask[i] |= r->mask[i];
+
+	for (i = 0; i < AUDIT_BITMASK_SIZE; i++)
+		WRITE_ONCE(audit_exit_mask[i], mask[i]);
+}
+#endif
+
 /* Find an existing audit rule.
  * Caller must hold audit_filter_mutex to prevent stale rule data. */
 static struct audit_entry *audit_find_rule(struct audit_entry *entry,
@@ -998,6 +1031,11 @@ static inline int audit_add_rule(struct audit_entry *entry)
 			entry->rule.prio = --prio_low;
 	}
 
+#ifdef CONFIG_AUDITSYSCALL
+	/* before the rule is visible to the exit filters */
+	audit_exit_mask_add(&entry->rule);
+#endif
+
 	if (entry->rule.flags & AUDIT_FILTER_PREPEND) {
 		list_add(&entry->rule.list,
 			 &audit_rules_list[entry->rule.listnr]);
@@ -1066,6 +1104,10 @@ int audit_del_rule(struct audit_entry *entry)
 	list_del_rcu(&e->list);
 	list_del(&e->rule.list);
 	call_rcu(&e->rcu, audit_free_rule_rcu);
+#ifdef CONFIG_AUDITSYSCALL
+	if (entry->rule.listnr == AUDIT_FILTER_EXIT)
+		audit_exit_mask_rebuild();
+#endif
 
 out:
 	mutex_unlock(&audit_filter_mutex);
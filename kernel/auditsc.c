@@ -86,6 +86,15 @@ int audit_n_rules;
 /* determines whether we collect data for signals sent */
 int audit_signals;
 
+/*
+ * Union of the syscall masks of all exit rules, including the watch and
+ * inode rules on audit_inode_hash.  A syscall outside of it can not match
+ * any exit rule, so the exit filters need not be walked for it.  Bits are
+ * set before a rule becomes visible and only cleared once it is gone,
+ * under audit_filter_mutex.
+ */
+u32 audit_exit_mask[AUDIT_BITMASK_SIZE];
+
 struct audit_aux_data {
 	struct audit_aux_data	*next;
 	int			type;
@@ -810,6 +819,21 @@ static int audit_in_mask(const struct audit_krule *rule, unsigned long val)
 	return rule->mask[word] & bit;
 }
 
+/* Whether any exit rule could match syscall @major, see audit_exit_mask */
+static bool audit_exit_may_match(unsigned long major)
+{
+	int word;
+
+	if (major > 0xffffffff)
+		return false;
+
+	word = AUDIT_WORD(major);
+	if (word >= AUDIT_BITMASK_SIZE)
+		return false;
+
+	return READ_ONCE(audit_exit_mask[word]) & AUDIT_BIT(major);
+}
+
 /**
  * __audit_filter_op - common filter helper for operations (syscall/uring/etc)
  * @tsk: associated task
@@ -2066,9 +2090,14 @@ void __audit_syscall_exit(int success, long return_code)
 		audit_kill_trees(context);
 
 	audit_return_fixup(context, success, return_code);
-	/* run through both filters to ensure we set the filterkey properly */
-	audit_filter_syscall(current, context);
-	audit_filter_inodes(current, context);
+	/*
+	 * Run through both filters to ensure we set the filterkey properly,
+	 * unless no exit rule covers this syscall at all.
+	 */
+	if (audit_exit_may_match(context->major)) {
+		audit_filter_syscall(current, context);
+		audit_filter_inodes(current, context);
+	}
 	if (context->current_state != AUDIT_STATE_RECORD)
 		goto out;
 
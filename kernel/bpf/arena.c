@@ -42,6 +42,9 @@
 #define GUARD_SZ round_up(1ull << sizeof_field(struct bpf_insn, off) * 8, PAGE_SIZE << 1)
 #define KERN_VM_SZ (SZ_4G + GUARD_SZ)
 
+/* freed pages kept for reuse by the next allocations, 2M worth on x86-64 */
+#define ARENA_PAGE_CACHE_MAX 512
+
 struct bpf_arena {
 	struct bpf_map map;
 	u64 user_vm_start;
@@ -50,6 +53,9 @@ struct bpf_arena {
 	struct range_tree rt;
 	struct list_head vma_list;
 	struct mutex lock;
+	/* protected by lock */
+	struct list_head page_cache;
+	long nr_cached_pages;
 };
 
 u64 bpf_arena_get_kern_vm_start(struct bpf_arena *arena)
@@ -136,6 +142,7 @@ static struct bpf_map *arena_map_alloc(union bpf_attr *attr)
 		arena->user_vm_end = arena->user_vm_start + vm_range;
 
 	INIT_LIST_HEAD(&arena->vma_list);
+	INIT_LIST_HEAD(&arena->page_cache);
 	bpf_map_init_from_attr(&arena->map, attr);
 	range_tree_init(&arena->rt);
 	err = range_tree_set(&arena->rt, 0, attr->max_entries);
@@ -151,6 +158,41 @@ static struct bpf_map *arena_map_alloc(union bpf_attr *attr)
 	return ERR_PTR(err);
 }
 
+/*
+ * Take up to @page_cnt pages from the page cache of the arena. They are
+ * still charged to the memcg of the arena and are zeroed here, as
+ * __GFP_ZERO would.
+ */
+static long arena_cache_get_pages(struct bpf_arena *arena, long page_cnt,
+				  struct page **pages)
+{
+	long i;
+
+	lockdep_assert_held(&arena->lock);
+
+	for (i = 0; i < page_cnt && !list_empty(&arena->page_cache); i++) {
+		pages[i] = list_first_entry(&arena->page_cache, struct page, lru);
+		list_del(&pages[i]->lru);
+		clear_highpage(pages[i]);
+	}
+	arena->nr_cached_pages -= i;
+	return i;
+}
+
+static void arena_cache_put_page(struct bpf_arena *arena, struct page *page)
+{
+	lockdep_assert_held(&arena->lock);
+
+	/* Only keep pages nobody else holds a reference to */
+	if (arena->nr_cached_pages >= ARENA_PAGE_CACHE_MAX ||
+	    page_count(page) != 1) {
+		__free_page(page);
+		return;
+	}
+	list_add(&page->lru, &arena->page_cache);
+	arena->nr_cached_pages++;
+}
+
 static int existing_page_cb(pte_t *ptep, unsigned long addr, void *data)
 {
 	struct page *page;
@@ -174,6 +216,7 @@ static int existing_page_cb(pte_t *ptep, unsigned long addr, void *data)
 static void arena_map_free(struct bpf_map *map)
 {
 	struct bpf_arena *arena = container_of(map, struct bpf_arena, map);
+	struct page *page, *tmp;
 
 	/*
 	 * Check that user vma-s are not around when bpf map is freed.
@@ -192,6 +235,8 @@ static void arena_map_free(struct bpf_map *map)
 	 */
 	apply_to_existing_page_range(&init_mm, bpf_arena_get_kern_vm_start(arena),
 				     KERN_VM_SZ - GUARD_SZ, existing_page_cb, NULL);
+	list_for_each_entry_safe(page, tmp, &arena->page_cache, lru)
+		__free_page(page);
 	free_vm_area(arena->kern_vm);
 	range_tree_destroy(&arena->rt);
 	bpf_map_area_free(arena);
@@ -265,7 +310,7 @@ static vm_fault_t arena_vm_fault(struct vm_fault *vmf)
 {
 	struct bpf_map *map = vmf->vma->vm_file->private_data;
 	struct bpf_arena *arena = container_of(map, struct bpf_arena, map);
-	struct page *page;
+	struct page *page = NULL;
 	long kbase, kaddr;
 	int ret;
 
@@ -287,10 +332,13 @@ static vm_fault_t arena_vm_fault(struct vm_fault *vmf)
 		return VM_FAULT_SIGSEGV;
 
 	/* Account into memcg of the process that created bpf_arena */
-	ret = bpf_map_alloc_pages(map, GFP_KERNEL | __GFP_ZERO, NUMA_NO_NODE, 1, &page);
-	if (ret) {
-		range_tree_set(&arena->rt, vmf->pgoff, 1);
-		return VM_FAULT_SIGSEGV;
+	if (!arena_cache_get_pages(arena, 1, &page)) {
+		ret = bpf_map_alloc_pages(map, GFP_KERNEL | __GFP_ZERO,
+					  NUMA_NO_NODE, 1, &page);
+		if (ret) {
+			range_tree_set(&arena->rt, vmf->pgoff, 1);
+			return VM_FAULT_SIGSEGV;
+		}
 	}
 
 	ret = vm_area_map_pages(arena->kern_vm, kaddr, kaddr + PAGE_SIZE, &page);
@@ -429,7 +477,7 @@ static long arena_alloc_pages(struct bpf_arena *arena, long uaddr, long page_cnt
 	long page_cnt_max = (arena->user_vm_end - arena->user_vm_start) >> PAGE_SHIFT;
 	u64 kern_vm_start = bpf_arena_get_kern_vm_start(arena);
 	struct page **pages;
-	long pgoff = 0;
+	long pgoff = 0, nr_cached = 0;
 	u32 uaddr32;
 	int ret, i;
 
@@ -465,10 +513,17 @@ static long arena_alloc_pages(struct bpf_arena *arena, long uaddr, long page_cnt
 	if (ret)
 		goto out_free_pages;
 
+	/* The cached pages can be on any node */
+	if (node_id == NUMA_NO_NODE)
+		nr_cached = arena_cache_get_pages(arena, page_cnt, pages);
+
 	ret = bpf_map_alloc_pages(&arena->map, GFP_KERNEL | __GFP_ZERO,
-				  node_id, page_cnt, pages);
-	if (ret)
+				  node_id, page_cnt - nr_cached, pages + nr_cached);
+	if (ret) {
+		for (i = 0; i < nr_cached; i++)
+			arena_cache_put_page(arena, pages[i]);
 		goto out;
+	}
 
 	uaddr32 = (u32)(arena->user_vm_start + pgoff * PAGE_SIZE);
 	/* Earlier checks made sure that uaddr32 + page_cnt * PAGE_SIZE - 1
@@ -547,7 +602,7 @@ static void arena_free_pages(struct bpf_arena *arena, long uaddr, long page_cnt)
 			 */
 			zap_pages(arena, full_uaddr, 1);
 		vm_area_unmap_pages(arena->kern_vm, kaddr, kaddr + PAGE_SIZE);
-		__free_page(page);
+		arena_cache_put_page(arena, page);
 	}
 }
 
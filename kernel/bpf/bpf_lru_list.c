@@ -4,6 +4,8 @@
 #include <linux/cpumask.h>
 #include <linux/spinlock.h>
 #include <linux/percpu.h>
+#include <linux/slab.h>
+#include <linux/topology.h>
 
 #include "bpf_lru_list.h"
 
@@ -27,6 +29,20 @@ static int get_next_cpu(int cpu)
 	return cpu;
 }
 
+static int bpf_lru_cpu_to_node(int cpu)
+{
+	int nid = cpu_to_node(cpu);
+
+	return nid == NUMA_NO_NODE ? 0 : nid;
+}
+
+/* The global LRU list of the NUMA node of @cpu */
+static struct bpf_lru_list *common_lru_list(struct bpf_common_lru *clru,
+					    int cpu)
+{
+	return &clru->lru_lists[bpf_lru_cpu_to_node(cpu)];
+}
+
 /* Local list helpers */
 static struct list_head *local_free_list(struct bpf_lru_locallist *loc_l)
 {
@@ -270,8 +286,10 @@ static unsigned int __bpf_lru_list_shrink(struct bpf_lru *lru,
 
 	nshrinked = __bpf_lru_list_shrink_inactive(lru, l, tgt_nshrink,
 						   free_list, tgt_free_type);
-	if (nshrinked)
+	if (nshrinked) {
+		l->nr_evictions += nshrinked;
 		return nshrinked;
+	}
 
 	/* Do a force shrink by ignoring the reference bit */
 	if (!list_empty(&l->lists[BPF_LRU_LIST_T_INACTIVE]))
@@ -284,6 +302,7 @@ static unsigned int __bpf_lru_list_shrink(struct bpf_lru *lru,
 		if (lru->del_from_htab(lru->del_arg, node)) {
 			__bpf_lru_node_move_to_free(l, node, free_list,
 						    tgt_free_type);
+			l->nr_evictions++;
 			return 1;
 		}
 	}
@@ -320,33 +339,78 @@ static void bpf_lru_list_push_free(struct bpf_lru_list *l,
 	raw_spin_unlock_irqrestore(&l->lock, flags);
 }
 
-static void bpf_lru_list_pop_free_to_local(struct bpf_lru *lru,
-					   struct bpf_lru_locallist *loc_l)
+static unsigned int __local_list_pop_free_from(struct bpf_lru_list *l,
+					       struct bpf_lru_locallist *loc_l,
+					       unsigned int tgt_nfree)
 {
-	struct bpf_lru_list *l = &lru->common_lru.lru_list;
 	struct bpf_lru_node *node, *tmp_node;
 	unsigned int nfree = 0;
 
+	list_for_each_entry_safe(node, tmp_node, &l->lists[BPF_LRU_LIST_T_FREE],
+				 list) {
+		if (nfree == tgt_nfree)
+			break;
+		__bpf_lru_node_move_to_free(l, node, local_free_list(loc_l),
+					    BPF_LRU_LOCAL_LIST_T_FREE);
+		nfree++;
+	}
+
+	return nfree;
+}
+
+/* Refill the local free list of @cpu from the global LRU lists.
+ *
+ * Only the list of the NUMA node of @cpu is flushed into and rotated. The
+ * free nodes of the other nodes' lists are used up before anything is
+ * evicted, and the other lists are only shrunk when the local one has
+ * nothing left to evict.
+ */
+static void bpf_lru_list_pop_free_to_local(struct bpf_lru *lru,
+					   struct bpf_lru_locallist *loc_l,
+					   int cpu)
+{
+	struct bpf_common_lru *clru = &lru->common_lru;
+	int home = bpf_lru_cpu_to_node(cpu), nid;
+	struct bpf_lru_list *l;
+	unsigned int nfree;
+
+	l = &clru->lru_lists[home];
 	raw_spin_lock(&l->lock);
 
 	__local_list_flush(l, loc_l);
 
 	__bpf_lru_list_rotate(lru, l);
 
-	list_for_each_entry_safe(node, tmp_node, &l->lists[BPF_LRU_LIST_T_FREE],
-				 list) {
-		__bpf_lru_node_move_to_free(l, node, local_free_list(loc_l),
-					    BPF_LRU_LOCAL_LIST_T_FREE);
-		if (++nfree == LOCAL_FREE_TARGET)
-			break;
+	nfree = __local_list_pop_free_from(l, loc_l, LOCAL_FREE_TARGET);
+
+	raw_spin_unlock(&l->lock);
+
+	for (nid = next_node_in(home, node_possible_map);
+	     nid != home && nfree < LOCAL_FREE_TARGET;
+	     nid = next_node_in(nid, node_possible_map)) {
+		l = &clru->lru_lists[nid];
+		if (list_empty_careful(&l->lists[BPF_LRU_LIST_T_FREE]))
+			continue;
+
+		raw_spin_lock(&l->lock);
+		nfree += __local_list_pop_free_from(l, loc_l,
+						    LOCAL_FREE_TARGET - nfree);
+		raw_spin_unlock(&l->lock);
 	}
 
-	if (nfree < LOCAL_FREE_TARGET)
-		__bpf_lru_list_shrink(lru, l, LOCAL_FREE_TARGET - nfree,
-				      local_free_list(loc_l),
-				      BPF_LRU_LOCAL_LIST_T_FREE);
+	if (nfree == LOCAL_FREE_TARGET)
+		return;
 
-	raw_spin_unlock(&l->lock);
+	nid = home;
+	do {
+		l = &clru->lru_lists[nid];
+		raw_spin_lock(&l->lock);
+		nfree += __bpf_lru_list_shrink(lru, l, LOCAL_FREE_TARGET - nfree,
+					       local_free_list(loc_l),
+					       BPF_LRU_LOCAL_LIST_T_FREE);
+		raw_spin_unlock(&l->lock);
+		nid = next_node_in(nid, node_possible_map);
+	} while (!nfree && nid != home);
 }
 
 static void __local_list_add_pending(struct bpf_lru *lru,
@@ -449,7 +513,7 @@ static struct bpf_lru_node *bpf_common_lru_pop_free(struct bpf_lru *lru,
 
 	node = __local_list_pop_free(loc_l);
 	if (!node) {
-		bpf_lru_list_pop_free_to_local(lru, loc_l);
+		bpf_lru_list_pop_free_to_local(lru, loc_l, cpu);
 		node = __local_list_pop_free(loc_l);
 	}
 
@@ -477,8 +541,11 @@ static struct bpf_lru_node *bpf_common_lru_pop_free(struct bpf_lru *lru,
 		raw_spin_lock_irqsave(&steal_loc_l->lock, flags);
 
 		node = __local_list_pop_free(steal_loc_l);
-		if (!node)
+		if (!node) {
 			node = __local_list_pop_pending(lru, steal_loc_l);
+			if (node)
+				steal_loc_l->nr_evictions++;
+		}
 
 		raw_spin_unlock_irqrestore(&steal_loc_l->lock, flags);
 
@@ -535,7 +602,8 @@ static void bpf_common_lru_push_free(struct bpf_lru *lru,
 	}
 
 check_lru_list:
-	bpf_lru_list_push_free(&lru->common_lru.lru_list, node);
+	bpf_lru_list_push_free(common_lru_list(&lru->common_lru, node->cpu),
+			       node);
 }
 
 static void bpf_percpu_lru_push_free(struct bpf_lru *lru,
@@ -565,17 +633,22 @@ static void bpf_common_lru_populate(struct bpf_lru *lru, void *buf,
 				    u32 node_offset, u32 elem_size,
 				    u32 nr_elems)
 {
-	struct bpf_lru_list *l = &lru->common_lru.lru_list;
+	int cpu = cpumask_first(cpu_possible_mask);
+	struct bpf_lru_list *l;
 	u32 i;
 
+	/* Spread the free nodes over the NUMA nodes by their CPU count */
 	for (i = 0; i < nr_elems; i++) {
 		struct bpf_lru_node *node;
 
+		l = common_lru_list(&lru->common_lru, cpu);
 		node = (struct bpf_lru_node *)(buf + node_offset);
+		node->cpu = cpu;
 		node->type = BPF_LRU_LIST_T_FREE;
 		bpf_lru_node_clear_ref(node);
 		list_add(&node->list, &l->lists[BPF_LRU_LIST_T_FREE]);
 		buf += elem_size;
+		cpu = get_next_cpu(cpu);
 	}
 }
 
@@ -629,6 +702,7 @@ static void bpf_lru_locallist_init(struct bpf_lru_locallist *loc_l, int cpu)
 		INIT_LIST_HEAD(&loc_l->lists[i]);
 
 	loc_l->next_steal = cpu;
+	loc_l->nr_evictions = 0;
 
 	raw_spin_lock_init(&loc_l->lock);
 }
@@ -644,6 +718,7 @@ static void bpf_lru_list_init(struct bpf_lru_list *l)
 		l->counts[i] = 0;
 
 	l->next_inactive_rotation = &l->lists[BPF_LRU_LIST_T_INACTIVE];
+	l->nr_evictions = 0;
 
 	raw_spin_lock_init(&l->lock);
 }
@@ -667,11 +742,20 @@ int bpf_lru_init(struct bpf_lru *lru, bool percpu, u32 hash_offset,
 		lru->nr_scans = PERCPU_NR_SCANS;
 	} else {
 		struct bpf_common_lru *clru = &lru->common_lru;
+		int nid;
 
 		clru->local_list = alloc_percpu(struct bpf_lru_locallist);
 		if (!clru->local_list)
 			return -ENOMEM;
 
+		clru->lru_lists = kcalloc(nr_node_ids,
+					  sizeof(struct bpf_lru_list),
+					  GFP_KERNEL);
+		if (!clru->lru_lists) {
+			free_percpu(clru->local_list);
+			return -ENOMEM;
+		}
+
 		for_each_possible_cpu(cpu) {
 			struct bpf_lru_locallist *loc_l;
 
@@ -679,7 +763,8 @@ int bpf_lru_init(struct bpf_lru *lru, bool percpu, u32 hash_offset,
 			bpf_lru_locallist_init(loc_l, cpu);
 		}
 
-		bpf_lru_list_init(&clru->lru_list);
+		for (nid = 0; nid < nr_node_ids; nid++)
+			bpf_lru_list_init(&clru->lru_lists[nid]);
 		lru->nr_scans = LOCAL_NR_SCANS;
 	}
 
@@ -693,8 +778,36 @@ int bpf_lru_init(struct bpf_lru *lru, bool percpu, u32 hash_offset,
 
 void bpf_lru_destroy(struct bpf_lru *lru)
 {
-	if (lru->percpu)
+	if (lru->percpu) {
 		free_percpu(lru->percpu_lru);
-	else
+	} else {
+		kfree(lru->common_lru.lru_lists);
 		free_percpu(lru->common_lru.local_list);
+	}
+}
+
+/* Number of nodes taken back from the hash table to make room */
+unsigned long bpf_lru_nr_evictions(struct bpf_lru *lru)
+{
+	struct bpf_common_lru *clru = &lru->common_lru;
+	unsigned long nr = 0;
+	int cpu, nid;
+
+	if (lru->percpu) {
+		for_each_possible_cpu(cpu) {
+			struct bpf_lru_list *l = per_cpu_ptr(lru->percpu_lru, cpu);
+
+			nr += READ_ONCE(l->nr_evictions);
+		}
+		return nr;
+	}
+
+	for (nid = 0; nid < nr_node_ids; nid++)
+		nr += READ_ONCE(clru->lru_lists[nid].nr_evictions);
+	for_each_possible_cpu(cpu) {
+		struct bpf_lru_locallist *loc_l = per_cpu_ptr(clru->local_list, cpu);
+
+		nr += READ_ONCE(loc_l->nr_evictions);
+	}
+	return nr;
 }
@@ -33,6 +33,7 @@ struct bpf_lru_list {
 	unsigned int counts[NR_BPF_LRU_LIST_COUNT];
 	/* The next inactive list rotation starts from here */
 	struct list_head *next_inactive_rotation;
+	unsigned long nr_evictions;
 
 	raw_spinlock_t lock ____cacheline_aligned_in_smp;
 };
@@ -40,11 +41,15 @@ struct bpf_lru_list {
 struct bpf_lru_locallist {
 	struct list_head lists[NR_BPF_LRU_LOCAL_LIST_T];
 	u16 next_steal;
+	unsigned long nr_evictions;
 	raw_spinlock_t lock;
 };
 
+/* The global LRU list is split into one list per NUMA node. A node on one
+ * of them always has @cpu set to a CPU of that NUMA node.
+ */
 struct bpf_common_lru {
-	struct bpf_lru_list lru_list;
+	struct bpf_lru_list *lru_lists;
 	struct bpf_lru_locallist __percpu *local_list;
 };
 
@@ -75,5 +80,6 @@ void bpf_lru_populate(struct bpf_lru *lru, void *buf, u32 node_offset,
 void bpf_lru_destroy(struct bpf_lru *lru);
 struct bpf_lru_node *bpf_lru_pop_free(struct bpf_lru *lru, u32 hash);
 void bpf_lru_push_free(struct bpf_lru *lru, struct bpf_lru_node *node);
+unsigned long bpf_lru_nr_evictions(struct bpf_lru *lru);
 
 #endif
@@ -41,6 +41,42 @@ static int __init cgroup_bpf_wq_init(void)
 }
 core_initcall(cgroup_bpf_wq_init);
 
+/* Progs attached to the per-packet cgroup_skb hooks are called through this
+ * dispatcher instead of an indirect call.
+ */
+DEFINE_BPF_DISPATCHER(cgroup_skb)
+
+static void cgroup_bpf_dispatcher_change(enum cgroup_bpf_attach_type atype,
+					 struct bpf_prog *from,
+					 struct bpf_prog *to)
+{
+	if (atype == CGROUP_INET_INGRESS || atype == CGROUP_INET_EGRESS)
+		bpf_dispatcher_change_prog(BPF_DISPATCHER_PTR(cgroup_skb),
+					   from, to);
+}
+
+/* __bpf_prog_run_save_cb() through the cgroup_skb dispatcher */
+static __always_inline u32 cgroup_skb_prog_run(const struct bpf_prog *prog,
+					       const void *ctx)
+{
+	const struct sk_buff *skb = ctx;
+	u8 *cb_data = bpf_skb_cb(skb);
+	u8 cb_saved[BPF_SKB_CB_LEN];
+	u32 res;
+
+	if (unlikely(prog->cb_access)) {
+		memcpy(cb_saved, cb_data, sizeof(cb_saved));
+		memset(cb_data, 0, sizeof(cb_saved));
+	}
+
+	res = __bpf_prog_run(prog, skb, BPF_DISPATCHER_FUNC(cgroup_skb));
+
+	if (unlikely(prog->cb_access))
+		memcpy(cb_data, cb_saved, sizeof(cb_saved));
+
+	return res;
+}
+
 /* __always_inline is necessary to prevent indirect call through run_prog
  * function pointer.
  */
@@ -284,6 +320,15 @@ static void bpf_cgroup_link_auto_detach(struct bpf_cgroup_link *link)
 	link->cgroup = NULL;
 }
 
+static struct bpf_prog *prog_list_prog(struct bpf_prog_list *pl)
+{
+	if (pl->prog)
+		return pl->prog;
+	if (pl->link)
+		return pl->link->link.prog;
+	return NULL;
+}
+
 /**
  * cgroup_bpf_release() - put references of all bpf programs and
  *                        release all cgroup bpf data
@@ -308,6 +353,10 @@ static void cgroup_bpf_release(struct work_struct *work)
 
 		hlist_for_each_entry_safe(pl, pltmp, progs, node) {
 			hlist_del(&pl->node);
+			if (prog_list_prog(pl))
+				cgroup_bpf_dispatcher_change(atype,
+							     prog_list_prog(pl),
+							     NULL);
 			if (pl->prog) {
 				if (pl->prog->expected_attach_type == BPF_LSM_CGROUP)
 					bpf_trampoline_unlink_cgroup_shim(pl->prog);
@@ -357,15 +406,6 @@ static void cgroup_bpf_release_fn(struct percpu_ref *ref)
 /* Get underlying bpf_prog of bpf_prog_list entry, regardless if it's through
  * link or direct prog.
  */
-static struct bpf_prog *prog_list_prog(struct bpf_prog_list *pl)
-{
-	if (pl->prog)
-		return pl->prog;
-	if (pl->link)
-		return pl->link->link.prog;
-	return NULL;
-}
-
 /* count number of elements in the list.
  * it's slow but the list cannot be long
  */
@@ -711,6 +751,7 @@ static int __cgroup_bpf_attach(struct cgroup *cgrp,
 	if (err)
 		goto cleanup_trampoline;
 
+	cgroup_bpf_dispatcher_change(atype, old_prog, new_prog);
 	if (old_prog) {
 		if (type == BPF_LSM_CGROUP)
 			bpf_trampoline_unlink_cgroup_shim(old_prog);
@@ -837,6 +878,7 @@ static int __cgroup_bpf_replace(struct cgroup *cgrp,
 
 	old_prog = xchg(&link->link.prog, new_prog);
 	replace_effective_prog(cgrp, atype, link);
+	cgroup_bpf_dispatcher_change(atype, old_prog, new_prog);
 	bpf_prog_put(old_prog);
 	return 0;
 }
@@ -968,7 +1010,7 @@ static int __cgroup_bpf_detach(struct cgroup *cgrp, struct bpf_prog *prog,
 			       struct bpf_cgroup_link *link, enum bpf_attach_type type)
 {
 	enum cgroup_bpf_attach_type atype;
-	struct bpf_prog *old_prog;
+	struct bpf_prog *old_prog, *detached;
 	struct bpf_prog_list *pl;
 	struct hlist_head *progs;
 	u32 attach_btf_id = 0;
@@ -994,6 +1036,8 @@ static int __cgroup_bpf_detach(struct cgroup *cgrp, struct bpf_prog *prog,
 	if (IS_ERR(pl))
 		return PTR_ERR(pl);
 
+	detached = prog_list_prog(pl);
+
 	/* mark it deleted, so it's ignored while recomputing effective */
 	old_prog = pl->prog;
 	pl->prog = NULL;
@@ -1008,6 +1052,7 @@ static int __cgroup_bpf_detach(struct cgroup *cgrp, struct bpf_prog *prog,
 
 	/* now can actually delete it from this cgroup list */
 	hlist_del(&pl->node);
+	cgroup_bpf_dispatcher_change(atype, detached, NULL);
 
 	kfree(pl);
 	if (hlist_empty(progs))
@@ -1397,7 +1442,7 @@ int __cgroup_bpf_run_filter_skb(struct sock *sk,
 		bool cn;
 
 		ret = bpf_prog_run_array_cg(&cgrp->bpf, atype, skb,
-					    __bpf_prog_run_save_cb, 0, &flags);
+					    cgroup_skb_prog_run, 0, &flags);
 
 		/* Return values of CGROUP EGRESS BPF programs are:
 		 *   0: drop packet
@@ -1423,7 +1468,7 @@ int __cgroup_bpf_run_filter_skb(struct sock *sk,
 			ret = (cn ? NET_XMIT_DROP : ret);
 	} else {
 		ret = bpf_prog_run_array_cg(&cgrp->bpf, atype,
-					    skb, __bpf_prog_run_save_cb, 0,
+					    skb, cgroup_skb_prog_run, 0,
 					    NULL);
 		if (ret && !IS_ERR_VALUE((long)ret))
 			ret = -EFAULT;
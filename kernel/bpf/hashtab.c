@@ -2308,6 +2308,15 @@ const struct bpf_map_ops htab_map_ops = {
 	.iter_seq_info = &iter_seq_info,
 };
 
+static void htab_lru_map_show_fdinfo(const struct bpf_map *map,
+				     struct seq_file *m)
+{
+	struct bpf_htab *htab = container_of(map, struct bpf_htab, map);
+
+	seq_printf(m, "lru_evictions:\t%lu\n",
+		   bpf_lru_nr_evictions(&htab->lru));
+}
+
 const struct bpf_map_ops htab_lru_map_ops = {
 	.map_meta_equal = bpf_map_meta_equal,
 	.map_alloc_check = htab_map_alloc_check,
@@ -2325,6 +2334,7 @@ const struct bpf_map_ops htab_lru_map_ops = {
 	.map_set_for_each_callback_args = map_set_for_each_callback_args,
 	.map_for_each_callback = bpf_for_each_hash_elem,
 	.map_mem_usage = htab_map_mem_usage,
+	.map_show_fdinfo = htab_lru_map_show_fdinfo,
 	BATCH_OPS(htab_lru),
 	.map_btf_id = &htab_map_btf_ids[0],
 	.iter_seq_info = &iter_seq_info,
@@ -2518,6 +2528,7 @@ const struct bpf_map_ops htab_lru_percpu_map_ops = {
 	.map_set_for_each_callback_args = map_set_for_each_callback_args,
 	.map_for_each_callback = bpf_for_each_hash_elem,
 	.map_mem_usage = htab_map_mem_usage,
+	.map_show_fdinfo = htab_lru_map_show_fdinfo,
 	BATCH_OPS(htab_lru_percpu),
 	.map_btf_id = &htab_map_btf_ids[0],
 	.iter_seq_info = &iter_seq_info,
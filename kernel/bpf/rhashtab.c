@@ -0,0 +1,366 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Resizable hash map
+ *
+ * BPF_MAP_TYPE_RHASH is a hash map backed by an rhashtable: its bucket array
+ * starts small, doubles once it is 75% full and halves again once it drops
+ * under 30%, up to a size derived from max_entries. Resizing runs from a
+ * worker and rehashes the elements into the new table one bucket at a time,
+ * while lookups keep walking both tables under RCU.
+ */
+#include <linux/bpf.h>
+#include <linux/btf_ids.h>
+#include <linux/rhashtable.h>
+#include <linux/seq_file.h>
+#include <linux/bpf_mem_alloc.h>
+
+#define RHTAB_CREATE_FLAG_MASK						\
+	(BPF_F_NO_PREALLOC | BPF_F_ACCESS_MASK)
+
+struct bpf_rhtab {
+	struct bpf_map map;
+	struct rhashtable ht;
+	struct rhashtable_params params;
+	struct bpf_mem_alloc ma;
+	atomic_t count;
+	u32 elem_size;
+	/* Resize statistics, sampled from update and delete */
+	unsigned int last_size;
+	atomic_long_t grows;
+	atomic_long_t shrinks;
+};
+
+struct rhtab_elem {
+	struct rhash_head node;
+	char key[] __aligned(8);
+};
+
+static inline void *rhtab_elem_value(struct rhtab_elem *l, u32 key_size)
+{
+	return l->key + round_up(key_size, 8);
+}
+
+static int rhtab_map_alloc_check(union bpf_attr *attr)
+{
+	/* The elements are always allocated on update */
+	if (!(attr->map_flags & BPF_F_NO_PREALLOC))
+		return -EINVAL;
+
+	if (attr->map_flags & ~RHTAB_CREATE_FLAG_MASK ||
+	    !bpf_map_flags_access_ok(attr->map_flags))
+		return -EINVAL;
+
+	if (attr->max_entries == 0 || attr->key_size == 0 ||
+	    attr->value_size == 0)
+		return -EINVAL;
+
+	/* rhashtable_params::key_len is a u16 */
+	if (attr->key_size > U16_MAX)
+		return -E2BIG;
+
+	if ((u64)attr->key_size + attr->value_size >= KMALLOC_MAX_SIZE -
+	    sizeof(struct rhtab_elem))
+		return -E2BIG;
+
+	return 0;
+}
+
+static struct bpf_map *rhtab_map_alloc(union bpf_attr *attr)
+{
+	struct bpf_rhtab *rh;
+	u32 max_size;
+	int err;
+
+	rh = bpf_map_area_alloc(sizeof(*rh), NUMA_NO_NODE);
+	if (!rh)
+		return ERR_PTR(-ENOMEM);
+
+	bpf_map_init_from_attr(&rh->map, attr);
+
+	rh->elem_size = sizeof(struct rhtab_elem) +
+			round_up(rh->map.key_size, 8) +
+			round_up(rh->map.value_size, 8);
+
+	/* Let the bucket array grow to one bucket per element, not beyond */
+	max_size = min_t(u32, rh->map.max_entries, 1U << 31);
+	rh->params = (struct rhashtable_params) {
+		.head_offset		= offsetof(struct rhtab_elem, node),
+		.key_offset		= offsetof(struct rhtab_elem, key),
+		.key_len		= rh->map.key_size,
+		.max_size		= roundup_pow_of_two(max_size),
+		.automatic_shrinking	= true,
+	};
+
+	err = rhashtable_init(&rh->ht, &rh->params);
+	if (err)
+		goto free_rh;
+
+	err = bpf_mem_alloc_init(&rh->ma, rh->elem_size, false);
+	if (err)
+		goto free_ht;
+
+	rh->last_size = rht_dereference(rh->ht.tbl, &rh->ht)->size;
+	atomic_set(&rh->count, 0);
+	atomic_long_set(&rh->grows, 0);
+	atomic_long_set(&rh->shrinks, 0);
+
+	return &rh->map;
+
+free_ht:
+	rhashtable_destroy(&rh->ht);
+free_rh:
+	bpf_map_area_free(rh);
+	return ERR_PTR(err);
+}
+
+static void rhtab_free_elem(void *ptr, void *arg)
+{
+	struct bpf_rhtab *rh = arg;
+
+	bpf_mem_cache_free(&rh->ma, ptr);
+}
+
+static void rhtab_map_free(struct bpf_map *map)
+{
+	struct bpf_rhtab *rh = container_of(map, struct bpf_rhtab, map);
+
+	/* No program or syscall can reach the map anymore */
+	rhashtable_free_and_destroy(&rh->ht, rhtab_free_elem, rh);
+	bpf_mem_alloc_destroy(&rh->ma);
+	bpf_map_area_free(rh);
+}
+
+static void *rhtab_map_lookup_elem(struct bpf_map *map, void *key)
+{
+	struct bpf_rhtab *rh = container_of(map, struct bpf_rhtab, map);
+	struct rhtab_elem *l;
+
+	WARN_ON_ONCE(!rcu_read_lock_held() && !rcu_read_lock_bh_held());
+
+	l = rhashtable_lookup(&rh->ht, key, rh->params);
+	return l ? rhtab_elem_value(l, map->key_size) : NULL;
+}
+
+/*
+ * Account for the bucket array having changed size since the last update or
+ * delete. Back to back resizes in between are only counted once.
+ */
+static void rhtab_note_resize(struct bpf_rhtab *rh)
+{
+	unsigned int size, last;
+
+	size = rht_dereference_rcu(rh->ht.tbl, &rh->ht)->size;
+	last = READ_ONCE(rh->last_size);
+	if (likely(size == last) || cmpxchg(&rh->last_size, last, size) != last)
+		return;
+
+	atomic_long_inc(size > last ? &rh->grows : &rh->shrinks);
+}
+
+static long rhtab_map_update_elem(struct bpf_map *map, void *key, void *value,
+				  u64 map_flags)
+{
+	struct bpf_rhtab *rh = container_of(map, struct bpf_rhtab, map);
+	struct rhtab_elem *l_new, *l_old;
+	long ret;
+
+	if (unlikely(map_flags > BPF_EXIST))
+		return -EINVAL;
+
+	/* The bucket locks are bit spinlocks taken with irqs disabled */
+	if (unlikely(in_nmi()))
+		return -EBUSY;
+
+	l_new = bpf_mem_cache_alloc(&rh->ma);
+	if (!l_new)
+		return -ENOMEM;
+	memcpy(l_new->key, key, map->key_size);
+	memcpy(rhtab_elem_value(l_new, map->key_size), value, map->value_size);
+
+	rcu_read_lock();
+	for (;;) {
+		l_old = rhashtable_lookup(&rh->ht, key, rh->params);
+		if (l_old) {
+			if (map_flags == BPF_NOEXIST) {
+				ret = -EEXIST;
+				break;
+			}
+			ret = rhashtable_replace_fast(&rh->ht, &l_old->node,
+						      &l_new->node, rh->params);
+			/* Deleted under us, insert instead */
+			if (ret == -ENOENT)
+				continue;
+			if (!ret) {
+				bpf_mem_cache_free_rcu(&rh->ma, l_old);
+				l_new = NULL;
+			}
+			break;
+		}
+
+		if (map_flags == BPF_EXIST) {
+			ret = -ENOENT;
+			break;
+		}
+
+		if (atomic_inc_return(&rh->count) > map->max_entries) {
+			atomic_dec(&rh->count);
+			ret = -E2BIG;
+			break;
+		}
+
+		l_old = rhashtable_lookup_get_insert_fast(&rh->ht, &l_new->node,
+							  rh->params);
+		if (!l_old) {
+			l_new = NULL;
+			ret = 0;
+			break;
+		}
+
+		atomic_dec(&rh->count);
+		if (IS_ERR(l_old)) {
+			ret = PTR_ERR(l_old);
+			break;
+		}
+		/* Lost a race with an insert of the same key, replace it */
+	}
+	rhtab_note_resize(rh);
+	rcu_read_unlock();
+
+	if (l_new)
+		bpf_mem_cache_free(&rh->ma, l_new);
+	return ret;
+}
+
+static long rhtab_map_delete_elem(struct bpf_map *map, void *key)
+{
+	struct bpf_rhtab *rh = container_of(map, struct bpf_rhtab, map);
+	struct rhtab_elem *l;
+	long ret = -ENOENT;
+
+	if (unlikely(in_nmi()))
+		return -EBUSY;
+
+	rcu_read_lock();
+	l = rhashtable_lookup(&rh->ht, key, rh->params);
+	if (l && !rhashtable_remove_fast(&rh->ht, &l->node, rh->params)) {
+		atomic_dec(&rh->count);
+		bpf_mem_cache_free_rcu(&rh->ma, l);
+		ret = 0;
+	}
+	rhtab_note_resize(rh);
+	rcu_read_unlock();
+
+	return ret;
+}
+
+/* First element at or after bucket @bkt of @tbl, then of the tables it is
+ * being rehashed into.
+ */
+static struct rhtab_elem *rhtab_first_elem(struct bpf_rhtab *rh,
+					   struct bucket_table *tbl,
+					   unsigned int bkt)
+{
+	struct rhash_head *pos;
+
+	for (; tbl; tbl = rht_dereference_rcu(tbl->future_tbl, &rh->ht), bkt = 0)
+		for (; bkt < tbl->size; bkt++)
+			rht_for_each_rcu(pos, tbl, bkt)
+				return container_of(pos, struct rhtab_elem, node);
+	return NULL;
+}
+
+/*
+ * Elements are walked in bucket order, so a walk that races with a resize
+ * can see entries twice or miss some, as one racing with updates already
+ * can for BPF_MAP_TYPE_HASH.
+ */
+static int rhtab_map_get_next_key(struct bpf_map *map, void *key,
+				  void *next_key)
+{
+	struct bpf_rhtab *rh = container_of(map, struct bpf_rhtab, map);
+	struct bucket_table *tbl, *first;
+	struct rhtab_elem *l = NULL;
+	struct rhash_head *pos;
+	unsigned int bkt;
+	bool found;
+
+	rcu_read_lock();
+	first = rht_dereference_rcu(rh->ht.tbl, &rh->ht);
+
+	if (!key)
+		goto find_first;
+
+	for (tbl = first; tbl;
+	     tbl = rht_dereference_rcu(tbl->future_tbl, &rh->ht)) {
+		bkt = rht_key_hashfn(&rh->ht, tbl, key, rh->params);
+		found = false;
+		rht_for_each_rcu(pos, tbl, bkt) {
+			l = container_of(pos, struct rhtab_elem, node);
+			if (found)
+				goto copy;
+			found = !memcmp(l->key, key, map->key_size);
+		}
+		if (found) {
+			l = rhtab_first_elem(rh, tbl, bkt + 1);
+			goto copy;
+		}
+	}
+
+find_first:
+	/* The key is gone, start over from the first element */
+	l = rhtab_first_elem(rh, first, 0);
+copy:
+	if (l)
+		memcpy(next_key, l->key, map->key_size);
+	rcu_read_unlock();
+
+	return l ? 0 : -ENOENT;
+}
+
+static u64 rhtab_map_mem_usage(const struct bpf_map *map)
+{
+	struct bpf_rhtab *rh = container_of(map, struct bpf_rhtab, map);
+	struct bucket_table *tbl;
+	u64 usage = sizeof(*rh);
+
+	usage += (u64)atomic_read(&rh->count) * rh->elem_size;
+
+	rcu_read_lock();
+	for (tbl = rht_dereference_rcu(rh->ht.tbl, &rh->ht); tbl;
+	     tbl = rht_dereference_rcu(tbl->future_tbl, &rh->ht))
+		usage += sizeof(*tbl) + (u64)tbl->size * sizeof(tbl->buckets[0]);
+	rcu_read_unlock();
+
+	return usage;
+}
+
+static void rhtab_map_show_fdinfo(const struct bpf_map *map,
+				  struct seq_file *m)
+{
+	struct bpf_rhtab *rh = container_of(map, struct bpf_rhtab, map);
+	unsigned int size;
+
+	rcu_read_lock();
+	size = rht_dereference_rcu(rh->ht.tbl, &rh->ht)->size;
+	rcu_read_unlock();
+
+	seq_printf(m, "nr_elems:\t%u\n", atomic_read(&rh->count));
+	seq_printf(m, "nr_buckets:\t%u\n", size);
+	seq_printf(m, "nr_grows:\t%lu\n", atomic_long_read(&rh->grows));
+	seq_printf(m, "nr_shrinks:\t%lu\n", atomic_long_read(&rh->shrinks));
+}
+
+BTF_ID_LIST_SINGLE(rhtab_map_btf_ids, struct, bpf_rhtab)
+const struct bpf_map_ops rhtab_map_ops = {
+	.map_meta_equal = bpf_map_meta_equal,
+	.map_alloc_check = rhtab_map_alloc_check,
+	.map_alloc = rhtab_map_alloc,
+	.map_free = rhtab_map_free,
+	.map_get_next_key = rhtab_map_get_next_key,
+	.map_lookup_elem = rhtab_map_lookup_elem,
+	.map_update_elem = rhtab_map_update_elem,
+	.map_delete_elem = rhtab_map_delete_elem,
+	.map_mem_usage = rhtab_map_mem_usage,
+	.map_show_fdinfo = rhtab_map_show_fdinfo,
+	.map_btf_id = &rhtab_map_btf_ids[0],
+};
@@ -80,6 +80,16 @@ struct bpf_ringbuf_map {
 	struct bpf_ringbuf *rb;
 };
 
+/* BPF_MAP_TYPE_PERCPU_RINGBUF: one ring of max_entries bytes per possible
+ * CPU, each allocated on the NUMA node of its CPU. Programs always reserve
+ * from the ring of the CPU they run on, so producers on different CPUs never
+ * share a lock or a producer position.
+ */
+struct bpf_percpu_ringbuf_map {
+	struct bpf_map map;
+	struct bpf_ringbuf *rbs[];
+};
+
 /* 8-byte ring buffer record header structure */
 struct bpf_ringbuf_hdr {
 	u32 len;
@@ -377,6 +387,143 @@ const struct bpf_map_ops user_ringbuf_map_ops = {
 	.map_btf_id = &user_ringbuf_map_btf_ids[0],
 };
 
+/* Pages of the mmap()'able part of one ring: consumer and producer pages,
+ * then the data pages mapped twice. The ring of CPU N starts at page
+ * N * percpu_ringbuf_map_stride() of the map's mmap() space.
+ */
+static unsigned long percpu_ringbuf_map_stride(const struct bpf_map *map)
+{
+	return RINGBUF_POS_PAGES + 2 * (map->max_entries >> PAGE_SHIFT);
+}
+
+static void percpu_ringbuf_map_free(struct bpf_map *map)
+{
+	struct bpf_percpu_ringbuf_map *rb_map;
+	int cpu;
+
+	rb_map = container_of(map, struct bpf_percpu_ringbuf_map, map);
+	for_each_possible_cpu(cpu)
+		if (rb_map->rbs[cpu])
+			bpf_ringbuf_free(rb_map->rbs[cpu]);
+	bpf_map_area_free(rb_map);
+}
+
+static struct bpf_map *percpu_ringbuf_map_alloc(union bpf_attr *attr)
+{
+	struct bpf_percpu_ringbuf_map *rb_map;
+	int cpu;
+
+	if (attr->map_flags)
+		return ERR_PTR(-EINVAL);
+
+	if (attr->key_size || attr->value_size ||
+	    !is_power_of_2(attr->max_entries) ||
+	    !PAGE_ALIGNED(attr->max_entries))
+		return ERR_PTR(-EINVAL);
+
+	rb_map = bpf_map_area_alloc(struct_size(rb_map, rbs, nr_cpu_ids),
+				    NUMA_NO_NODE);
+	if (!rb_map)
+		return ERR_PTR(-ENOMEM);
+
+	bpf_map_init_from_attr(&rb_map->map, attr);
+
+	for_each_possible_cpu(cpu) {
+		rb_map->rbs[cpu] = bpf_ringbuf_alloc(attr->max_entries,
+						     cpu_to_node(cpu));
+		if (!rb_map->rbs[cpu]) {
+			percpu_ringbuf_map_free(&rb_map->map);
+			return ERR_PTR(-ENOMEM);
+		}
+	}
+
+	return &rb_map->map;
+}
+
+static int percpu_ringbuf_map_mmap(struct bpf_map *map,
+				   struct vm_area_struct *vma)
+{
+	unsigned long stride = percpu_ringbuf_map_stride(map);
+	struct bpf_percpu_ringbuf_map *rb_map;
+	unsigned long cpu, pgoff;
+
+	rb_map = container_of(map, struct bpf_percpu_ringbuf_map, map);
+
+	cpu = vma->vm_pgoff / stride;
+	pgoff = vma->vm_pgoff % stride;
+	if (cpu >= nr_cpu_ids || !rb_map->rbs[cpu])
+		return -EINVAL;
+
+	if (vma->vm_flags & VM_WRITE) {
+		/* allow writable mapping for the consumer_pos only */
+		if (pgoff != 0 || vma->vm_end - vma->vm_start != PAGE_SIZE)
+			return -EPERM;
+	}
+	/* remap_vmalloc_range() keeps the mapping within this CPU's ring */
+	return remap_vmalloc_range(vma, rb_map->rbs[cpu], pgoff + RINGBUF_PGOFF);
+}
+
+/* Readable as soon as any of the rings has data, so one epoll on the map fd
+ * covers all CPUs.
+ */
+static __poll_t percpu_ringbuf_map_poll(struct bpf_map *map, struct file *filp,
+					struct poll_table_struct *pts)
+{
+	struct bpf_percpu_ringbuf_map *rb_map;
+	__poll_t mask = 0;
+	int cpu;
+
+	rb_map = container_of(map, struct bpf_percpu_ringbuf_map, map);
+	for_each_possible_cpu(cpu) {
+		poll_wait(filp, &rb_map->rbs[cpu]->waitq, pts);
+		if (ringbuf_avail_data_sz(rb_map->rbs[cpu]))
+			mask = EPOLLIN | EPOLLRDNORM;
+	}
+
+	return mask;
+}
+
+static u64 percpu_ringbuf_map_mem_usage(const struct bpf_map *map)
+{
+	struct bpf_percpu_ringbuf_map *rb_map;
+	u64 usage;
+	int cpu;
+
+	rb_map = container_of(map, struct bpf_percpu_ringbuf_map, map);
+	usage = struct_size(rb_map, rbs, nr_cpu_ids);
+	for_each_possible_cpu(cpu) {
+		usage += (u64)rb_map->rbs[cpu]->nr_pages << PAGE_SHIFT;
+		usage += (RINGBUF_NR_META_PAGES + 2 * (map->max_entries >> PAGE_SHIFT)) *
+			 sizeof(struct page *);
+	}
+	return usage;
+}
+
+BTF_ID_LIST_SINGLE(percpu_ringbuf_map_btf_ids, struct, bpf_percpu_ringbuf_map)
+const struct bpf_map_ops percpu_ringbuf_map_ops = {
+	.map_meta_equal = bpf_map_meta_equal,
+	.map_alloc = percpu_ringbuf_map_alloc,
+	.map_free = percpu_ringbuf_map_free,
+	.map_mmap = percpu_ringbuf_map_mmap,
+	.map_poll = percpu_ringbuf_map_poll,
+	.map_lookup_elem = ringbuf_map_lookup_elem,
+	.map_update_elem = ringbuf_map_update_elem,
+	.map_delete_elem = ringbuf_map_delete_elem,
+	.map_get_next_key = ringbuf_map_get_next_key,
+	.map_mem_usage = percpu_ringbuf_map_mem_usage,
+	.map_btf_id = &percpu_ringbuf_map_btf_ids[0],
+};
+
+/* The ring a program running on this CPU produces into */
+static struct bpf_ringbuf *bpf_ringbuf_from_map(struct bpf_map *map)
+{
+	if (map->map_type == BPF_MAP_TYPE_PERCPU_RINGBUF)
+		return container_of(map, struct bpf_percpu_ringbuf_map,
+				    map)->rbs[smp_processor_id()];
+
+	return container_of(map, struct bpf_ringbuf_map, map)->rb;
+}
+
 /* Given pointer to ring buffer record metadata and struct bpf_ringbuf itself,
  * calculate offset from record metadata to ring buffer in pages, rounded
  * down. This page offset is stored as part of record metadata and allows to
@@ -465,13 +612,11 @@ static void *__bpf_ringbuf_reserve(struct bpf_ringbuf *rb, u64 size)
 
 BPF_CALL_3(bpf_ringbuf_reserve, struct bpf_map *, map, u64, size, u64, flags)
 {
-	struct bpf_ringbuf_map *rb_map;
-
 	if (unlikely(flags))
 		return 0;
 
-	rb_map = container_of(map, struct bpf_ringbuf_map, map);
-	return (unsigned long)__bpf_ringbuf_reserve(rb_map->rb, size);
+	return (unsigned long)__bpf_ringbuf_reserve(bpf_ringbuf_from_map(map),
+						    size);
 }
 
 const struct bpf_func_proto bpf_ringbuf_reserve_proto = {
@@ -539,14 +684,12 @@ const struct bpf_func_proto bpf_ringbuf_discard_proto = {
 BPF_CALL_4(bpf_ringbuf_output, struct bpf_map *, map, void *, data, u64, size,
 	   u64, flags)
 {
-	struct bpf_ringbuf_map *rb_map;
 	void *rec;
 
 	if (unlikely(flags & ~(BPF_RB_NO_WAKEUP | BPF_RB_FORCE_WAKEUP)))
 		return -EINVAL;
 
-	rb_map = container_of(map, struct bpf_ringbuf_map, map);
-	rec = __bpf_ringbuf_reserve(rb_map->rb, size);
+	rec = __bpf_ringbuf_reserve(bpf_ringbuf_from_map(map), size);
 	if (!rec)
 		return -EAGAIN;
 
@@ -566,9 +709,7 @@ const struct bpf_func_proto bpf_ringbuf_output_proto = {
 
 BPF_CALL_2(bpf_ringbuf_query, struct bpf_map *, map, u64, flags)
 {
-	struct bpf_ringbuf *rb;
-
-	rb = container_of(map, struct bpf_ringbuf_map, map)->rb;
+	struct bpf_ringbuf *rb = bpf_ringbuf_from_map(map);
 
 	switch (flags) {
 	case BPF_RB_AVAIL_DATA:
@@ -594,7 +735,6 @@ const struct bpf_func_proto bpf_ringbuf_query_proto = {
 BPF_CALL_4(bpf_ringbuf_reserve_dynptr, struct bpf_map *, map, u32, size, u64, flags,
 	   struct bpf_dynptr_kern *, ptr)
 {
-	struct bpf_ringbuf_map *rb_map;
 	void *sample;
 	int err;
 
@@ -609,9 +749,7 @@ BPF_CALL_4(bpf_ringbuf_reserve_dynptr, struct bpf_map *, map, u32, size, u64, fl
 		return err;
 	}
 
-	rb_map = container_of(map, struct bpf_ringbuf_map, map);
-
-	sample = __bpf_ringbuf_reserve(rb_map->rb, size);
+	sample = __bpf_ringbuf_reserve(bpf_ringbuf_from_map(map), size);
 	if (!sample) {
 		bpf_dynptr_set_null(ptr);
 		return -EINVAL;
@@ -581,15 +581,24 @@ int bpf_map_alloc_pages(const struct bpf_map *map, gfp_t gfp, int nid,
 	memcg = bpf_map_get_memcg(map);
 	old_memcg = set_active_memcg(memcg);
 #endif
+	/* Take what the bulk allocator can give, then fill in the holes */
+	if (nr_pages > 1)
+		alloc_pages_bulk_node(gfp | __GFP_ACCOUNT, nid, nr_pages, pages);
+
 	for (i = 0; i < nr_pages; i++) {
-		pg = alloc_pages_node(nid, gfp | __GFP_ACCOUNT, 0);
+		if (pages[i])
+			continue;
 
+		pg = alloc_pages_node(nid, gfp | __GFP_ACCOUNT, 0);
 		if (pg) {
 			pages[i] = pg;
 			continue;
 		}
-		for (j = 0; j < i; j++)
-			__free_page(pages[j]);
+		for (j = 0; j < nr_pages; j++) {
+			if (pages[j])
+				__free_page(pages[j]);
+			pages[j] = NULL;
+		}
 		ret = -ENOMEM;
 		break;
 	}
@@ -988,6 +997,8 @@ static void bpf_map_show_fdinfo(struct seq_file *m, struct file *filp)
 		seq_printf(m, "owner_prog_type:\t%u\n", type);
 		seq_printf(m, "owner_jited:\t%u\n", jited);
 	}
+	if (map->ops->map_show_fdinfo)
+		map->ops->map_show_fdinfo(map, m);
 }
 #endif
 
@@ -1436,6 +1447,8 @@ static int map_create(union bpf_attr *attr)
 	case BPF_MAP_TYPE_STRUCT_OPS:
 	case BPF_MAP_TYPE_CPUMAP:
 	case BPF_MAP_TYPE_ARENA:
+	case BPF_MAP_TYPE_RHASH:
+	case BPF_MAP_TYPE_PERCPU_RINGBUF:
 		if (!bpf_token_capable(token, CAP_BPF))
 			goto put_token;
 		break;
@@ -2430,7 +2443,8 @@ static void bpf_prog_show_fdinfo(struct seq_file *m, struct file *filp)
 		   "run_time_ns:\t%llu\n"
 		   "run_cnt:\t%llu\n"
 		   "recursion_misses:\t%llu\n"
-		   "verified_insns:\t%u\n",
+		   "verified_insns:\t%u\n"
+		   "verification_time_ns:\t%llu\n",
 		   prog->type,
 		   prog->jited,
 		   prog_tag,
@@ -2439,7 +2453,8 @@ static void bpf_prog_show_fdinfo(struct seq_file *m, struct file *filp)
 		   stats.nsecs,
 		   stats.cnt,
 		   stats.misses,
-		   prog->aux->verified_insns);
+		   prog->aux->verified_insns,
+		   prog->aux->verification_time);
 }
 #endif
 
@@ -45,6 +45,7 @@ int tcx_prog_attach(const union bpf_attr *attr, struct bpf_prog *prog)
 			tcx_entry_sync();
 			tcx_skeys_inc(ingress);
 		}
+		tcx_dispatcher_change(replace_prog, prog);
 		bpf_mprog_commit(entry);
 	} else if (created) {
 		tcx_entry_free(entry);
@@ -83,6 +84,8 @@ int tcx_prog_detach(const union bpf_attr *attr, struct bpf_prog *prog)
 		tcx_entry_update(dev, entry_new, ingress);
 		tcx_entry_sync();
 		tcx_skeys_dec(ingress);
+		/* prog can be NULL here, the detached one is pending release */
+		tcx_dispatcher_change(entry->parent->ref, NULL);
 		bpf_mprog_commit(entry);
 		if (!entry_new)
 			tcx_entry_free(entry);
@@ -109,6 +112,7 @@ void tcx_uninstall(struct net_device *dev, bool ingress)
 	tcx_entry_update(dev, entry_new, ingress);
 	tcx_entry_sync();
 	bpf_mprog_foreach_tuple(entry, fp, cp, tuple) {
+		tcx_dispatcher_change(tuple.prog, NULL);
 		if (tuple.link)
 			tcx_link(tuple.link)->dev = NULL;
 		else
@@ -159,6 +163,7 @@ static int tcx_link_prog_attach(struct bpf_link *link, u32 flags, u32 id_or_fd,
 			tcx_entry_sync();
 			tcx_skeys_inc(ingress);
 		}
+		tcx_dispatcher_change(NULL, link->prog);
 		bpf_mprog_commit(entry);
 	} else if (created) {
 		tcx_entry_free(entry);
@@ -190,6 +195,7 @@ static void tcx_link_release(struct bpf_link *link)
 		tcx_entry_update(dev, entry_new, ingress);
 		tcx_entry_sync();
 		tcx_skeys_dec(ingress);
+		tcx_dispatcher_change(link->prog, NULL);
 		bpf_mprog_commit(entry);
 		if (!entry_new)
 			tcx_entry_free(entry);
@@ -234,6 +240,7 @@ static int tcx_link_update(struct bpf_link *link, struct bpf_prog *nprog,
 			       link->prog->aux->id, 0);
 	if (!ret) {
 		WARN_ON_ONCE(entry != entry_new);
+		tcx_dispatcher_change(oprog, nprog);
 		oprog = xchg(&link->prog, nprog);
 		bpf_prog_put(oprog);
 		bpf_mprog_commit(entry);
@@ -3940,6 +3940,48 @@ static ssize_t cgroup_pressure_write(struct kernfs_open_file *of,
 	return nbytes;
 }
 
+static int cgroup_pressure_aggregate_show(struct seq_file *seq, void *v)
+{
+	struct cgroup *cgrp = seq_css(seq)->cgroup;
+
+	seq_printf(seq, "%d\n", cgroup_psi(cgrp)->aggregate);
+
+	return 0;
+}
+
+static ssize_t cgroup_pressure_aggregate_write(struct kernfs_open_file *of,
+					       char *buf, size_t nbytes,
+					       loff_t off)
+{
+	struct cgroup *cgrp;
+	ssize_t ret;
+	int enable;
+
+	ret = kstrtoint(strstrip(buf), 0, &enable);
+	if (ret)
+		return ret;
+
+	if (enable < 0 || enable > 1)
+		return -ERANGE;
+
+	cgrp = cgroup_kn_lock_live(of->kn, false);
+	if (!cgrp)
+		return -ENOENT;
+
+	/* Task counts are not moved between groups, only relink empty ones */
+	ret = nbytes;
+	if (cgroup_psi(cgrp)->aggregate != enable) {
+		if (cgroup_is_populated(cgrp))
+			ret = -EBUSY;
+		else
+			psi_cgroup_set_aggregate(cgrp, enable);
+	}
+
+	cgroup_kn_unlock(of->kn);
+
+	return ret;
+}
+
 static __poll_t cgroup_pressure_poll(struct kernfs_open_file *of,
 					  poll_table *pt)
 {
@@ -5367,6 +5409,12 @@ static struct cftype cgroup_psi_files[] = {
 		.seq_show = cgroup_pressure_show,
 		.write = cgroup_pressure_write,
 	},
+	{
+		.name = "cgroup.pressure.aggregate",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.seq_show = cgroup_pressure_aggregate_show,
+		.write = cgroup_pressure_aggregate_write,
+	},
 #endif /* CONFIG_PSI */
 	{ }	/* terminate */
 };
@@ -840,20 +840,23 @@ static int generate_sched_domains(cpumask_var_t **domains,
 	if (root_load_balance && (csn == 1))
 		goto single_root_domain;
 
+	/*
+	 * Cgroup v2 partition roots are exclusive, so each of them makes its
+	 * own domain and there is nothing to merge.
+	 */
+	if (cgrpv2) {
+		ndoms = csn;
+		goto alloc_doms;
+	}
+
 	for (i = 0; i < csn; i++)
 		uf_node_init(&csa[i]->node);
 
 	/* Merge overlapping cpusets */
 	for (i = 0; i < csn; i++) {
 		for (j = i + 1; j < csn; j++) {
-			if (cpusets_overlap(csa[i], csa[j])) {
-				/*
-				 * Cgroup v2 shouldn't pass down overlapping
-				 * partition root cpusets.
-				 */
-				WARN_ON_ONCE(cgrpv2);
+			if (cpusets_overlap(csa[i], csa[j]))
 				uf_union(&csa[i]->node, &csa[j]->node);
-			}
 		}
 	}
 
@@ -863,6 +866,7 @@ static int generate_sched_domains(cpumask_var_t **domains,
 			ndoms++;
 	}
 
+alloc_doms:
 	/*
 	 * Now we know how many domains to create.
 	 * Convert <csn, csa> to <ndoms, doms> and populate cpu masks.
@@ -995,8 +999,8 @@ partition_and_rebuild_sched_domains(int ndoms_new, cpumask_var_t doms_new[],
 				    struct sched_domain_attr *dattr_new)
 {
 	mutex_lock(&sched_domains_mutex);
-	partition_sched_domains_locked(ndoms_new, doms_new, dattr_new);
-	dl_rebuild_rd_accounting();
+	if (partition_sched_domains_locked(ndoms_new, doms_new, dattr_new))
+		dl_rebuild_rd_accounting();
 	mutex_unlock(&sched_domains_mutex);
 }
 
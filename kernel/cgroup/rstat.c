@@ -303,6 +303,7 @@ static inline void __cgroup_rstat_unlock(struct cgroup *cgrp, int cpu_in_loop)
 static void cgroup_rstat_flush_locked(struct cgroup *cgrp)
 	__releases(&cgroup_rstat_lock) __acquires(&cgroup_rstat_lock)
 {
+	u64 start = ktime_get_ns();
 	int cpu;
 
 	lockdep_assert_held(&cgroup_rstat_lock);
@@ -331,6 +332,21 @@ static void cgroup_rstat_flush_locked(struct cgroup *cgrp)
 			__cgroup_rstat_lock(cgrp, cpu);
 		}
 	}
+
+	WRITE_ONCE(cgrp->rstat_flush_time, start);
+}
+
+/*
+ * Whether @cgrp's subtree was flushed, on its own or as part of one of its
+ * ancestors, by a flush that started at or after @since.
+ */
+static bool cgroup_rstat_flushed_since(struct cgroup *cgrp, u64 since)
+{
+	for (; cgrp; cgrp = cgroup_parent(cgrp))
+		if (READ_ONCE(cgrp->rstat_flush_time) >= since)
+			return true;
+
+	return false;
 }
 
 /**
@@ -355,6 +371,35 @@ __bpf_kfunc void cgroup_rstat_flush(struct cgroup *cgrp)
 	__cgroup_rstat_unlock(cgrp, -1);
 }
 
+/**
+ * cgroup_rstat_flush_stale - flush stats in @cgrp's subtree unless recent
+ * @cgrp: target cgroup
+ * @max_age_ns: how old the flushed stats are allowed to be
+ *
+ * Like cgroup_rstat_flush(), except that nothing is done if @cgrp's subtree
+ * was flushed less than @max_age_ns ago, on its own or along with one of its
+ * ancestors. Even with a zero @max_age_ns, a flush that started after this
+ * call, e.g. by a concurrent reader holding the lock, is reused instead of
+ * walking the subtree again.
+ *
+ * This function may block.
+ */
+void cgroup_rstat_flush_stale(struct cgroup *cgrp, u64 max_age_ns)
+{
+	u64 now = ktime_get_ns();
+	u64 since = max_age_ns < now ? now - max_age_ns : 1;
+
+	might_sleep();
+
+	if (cgroup_rstat_flushed_since(cgrp, since))
+		return;
+
+	__cgroup_rstat_lock(cgrp, -1);
+	if (!cgroup_rstat_flushed_since(cgrp, since))
+		cgroup_rstat_flush_locked(cgrp);
+	__cgroup_rstat_unlock(cgrp, -1);
+}
+
 /**
  * cgroup_rstat_flush_hold - flush stats in @cgrp's subtree and hold
  * @cgrp: target cgroup
@@ -198,6 +198,105 @@ void dma_unmap_page_attrs(struct device *dev, dma_addr_t addr, size_t size,
 }
 EXPORT_SYMBOL(dma_unmap_page_attrs);
 
+/**
+ * dma_map_pages_attrs - Map an array of whole pages for streaming DMA
+ * @dev: The device for which to perform the DMA operation
+ * @pages: The pages to map
+ * @nr: Number of pages in @pages
+ * @addrs: Returns the DMA address of each page
+ * @dir: DMA direction
+ * @attrs: Optional DMA attributes for the map operation
+ *
+ * Behind an IOMMU, the pages are mapped into a single contiguous IOVA range
+ * with one IOTLB sync for the whole batch, instead of an IOVA allocation and
+ * a sync per page.  @addrs must be passed unchanged to
+ * dma_unmap_pages_attrs().
+ *
+ * Return: 0 on success or -ENOMEM on failure, in which case none of the
+ * pages is mapped.
+ */
+int dma_map_pages_attrs(struct device *dev, struct page **pages,
+		unsigned int nr, dma_addr_t *addrs, enum dma_data_direction dir,
+		unsigned long attrs)
+{
+	const struct dma_map_ops *ops = get_dma_ops(dev);
+	unsigned int i;
+	int ret;
+
+	BUG_ON(!valid_dma_direction(dir));
+
+	if (WARN_ON_ONCE(!dev->dma_mask))
+		return -ENOMEM;
+
+	if (!nr)
+		return 0;
+
+	if (dma_map_direct(dev, ops) || !use_dma_iommu(dev)) {
+		for (i = 0; i < nr; i++) {
+			addrs[i] = dma_map_page_attrs(dev, pages[i], 0,
+						      PAGE_SIZE, dir, attrs);
+			if (dma_mapping_error(dev, addrs[i]))
+				goto out_unmap;
+		}
+		return 0;
+	}
+
+	ret = iommu_dma_map_pages(dev, pages, nr, addrs, dir, attrs);
+	if (ret)
+		return ret;
+
+	for (i = 0; i < nr; i++) {
+		kmsan_handle_dma(pages[i], 0, PAGE_SIZE, dir);
+		trace_dma_map_page(dev, page_to_phys(pages[i]), addrs[i],
+				   PAGE_SIZE, dir, attrs);
+		debug_dma_map_page(dev, pages[i], 0, PAGE_SIZE, dir, addrs[i],
+				   attrs);
+	}
+	return 0;
+
+out_unmap:
+	while (i--)
+		dma_unmap_page_attrs(dev, addrs[i], PAGE_SIZE, dir,
+				     attrs | DMA_ATTR_SKIP_CPU_SYNC);
+	return -ENOMEM;
+}
+EXPORT_SYMBOL_GPL(dma_map_pages_attrs);
+
+/**
+ * dma_unmap_pages_attrs - Unmap pages mapped by dma_map_pages_attrs()
+ * @dev: The device for which to perform the DMA operation
+ * @addrs: The DMA addresses returned by dma_map_pages_attrs()
+ * @nr: Number of pages, as passed to dma_map_pages_attrs()
+ * @dir: DMA direction
+ * @attrs: Optional DMA attributes for the unmap operation
+ */
+void dma_unmap_pages_attrs(struct device *dev, dma_addr_t *addrs,
+		unsigned int nr, enum dma_data_direction dir,
+		unsigned long attrs)
+{
+	const struct dma_map_ops *ops = get_dma_ops(dev);
+	unsigned int i;
+
+	BUG_ON(!valid_dma_direction(dir));
+
+	if (!nr)
+		return;
+
+	if (dma_map_direct(dev, ops) || !use_dma_iommu(dev)) {
+		for (i = 0; i < nr; i++)
+			dma_unmap_page_attrs(dev, addrs[i], PAGE_SIZE, dir,
+					     attrs);
+		return;
+	}
+
+	iommu_dma_unmap_pages(dev, addrs, nr, dir, attrs);
+	for (i = 0; i < nr; i++) {
+		trace_dma_unmap_page(dev, addrs[i], PAGE_SIZE, dir, attrs);
+		debug_dma_unmap_page(dev, addrs[i], PAGE_SIZE, dir);
+	}
+}
+EXPORT_SYMBOL_GPL(dma_unmap_pages_attrs);
+
 static int __dma_map_sg_attrs(struct device *dev, struct scatterlist *sg,
 	 int nents, enum dma_data_direction dir, unsigned long attrs)
 {
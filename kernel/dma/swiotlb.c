@@ -32,6 +32,7 @@
 #include <linux/io.h>
 #include <linux/iommu-helper.h>
 #include <linux/init.h>
+#include <linux/local_lock.h>
 #include <linux/memblock.h>
 #include <linux/mm.h>
 #include <linux/pfn.h>
@@ -63,6 +64,13 @@
 
 #define INVALID_PHYS_ADDR (~(phys_addr_t)0)
 
+/*
+ * Bounce copies to the device of at least this size use non-temporal stores:
+ * the CPU does not read the bounce buffer back, so there is no point in
+ * pulling it into the cache and evicting the working set.
+ */
+#define IO_TLB_NT_COPY_MIN	(4 * PAGE_SIZE)
+
 /**
  * struct io_tlb_slot - IO TLB slot descriptor
  * @orig_addr:	The original address corresponding to a mapped entry.
@@ -915,6 +923,14 @@ static void swiotlb_bounce(struct device *dev, phys_addr_t tlb_addr, size_t size
 			offset = 0;
 		}
 	} else if (dir == DMA_TO_DEVICE) {
+#ifdef __HAVE_ARCH_MEMCPY_FLUSHCACHE
+		if (size >= IO_TLB_NT_COPY_MIN) {
+			memcpy_flushcache(vaddr, phys_to_virt(orig_addr), size);
+			/* Order the non-temporal stores before starting the DMA */
+			wmb();
+			return;
+		}
+#endif
 		memcpy(vaddr, phys_to_virt(orig_addr), size);
 	} else {
 		memcpy(phys_to_virt(orig_addr), vaddr, size);
@@ -997,6 +1013,126 @@ static void dec_transient_used(struct io_tlb_mem *mem, unsigned int nslots)
 #endif /* CONFIG_DEBUG_FS */
 #endif /* CONFIG_SWIOTLB_DYNAMIC */
 
+/*
+ * Per-CPU caches of free slots of the default pool, for the two most common
+ * bounce sizes: a single slot, and a page-aligned page. Mappings of these
+ * sizes without alignment constraints are served from and released to the
+ * cache of the local CPU without going to the area lock and the free list.
+ * Cached slots stay accounted as used in their area.
+ */
+#define IO_TLB_PCP_CLASSES	2
+#define IO_TLB_PCP_NR		8
+
+struct io_tlb_pcp {
+	local_lock_t	lock;
+	unsigned int	nr[IO_TLB_PCP_CLASSES];
+	unsigned int	index[IO_TLB_PCP_CLASSES][IO_TLB_PCP_NR];
+};
+
+static DEFINE_PER_CPU(struct io_tlb_pcp, io_tlb_pcp) = {
+	.lock = INIT_LOCAL_LOCK(lock),
+};
+
+static bool io_tlb_pcp_enabled __read_mostly;
+
+static const unsigned int io_tlb_pcp_nslots[IO_TLB_PCP_CLASSES] = {
+	1, SLABS_PER_PAGE,
+};
+
+/*
+ * Only enable the caches when they can hold at most 1/16 of the default
+ * pool, so that slots parked on idle CPUs cannot starve the others.
+ */
+static int __init swiotlb_pcp_init(void)
+{
+	unsigned long cached = num_possible_cpus() * IO_TLB_PCP_NR *
+			       (1 + SLABS_PER_PAGE);
+
+	if (SLABS_PER_PAGE > 1 && io_tlb_default_mem.defpool.nslabs &&
+	    cached <= io_tlb_default_mem.defpool.nslabs / 16)
+		io_tlb_pcp_enabled = true;
+	return 0;
+}
+late_initcall(swiotlb_pcp_init);
+
+static int swiotlb_pcp_class(struct device *dev, size_t alloc_size,
+		unsigned int alloc_align_mask)
+{
+	if (!io_tlb_pcp_enabled || dev->dma_io_tlb_mem != &io_tlb_default_mem ||
+	    alloc_align_mask || dma_get_min_align_mask(dev))
+		return -1;
+	if (alloc_size <= IO_TLB_SIZE)
+		return 0;
+	if (alloc_size <= PAGE_SIZE && dma_get_seg_boundary(dev) >= PAGE_SIZE - 1)
+		return 1;
+	return -1;
+}
+
+/* Return: Index of the first slot taken from the local cache, or -1 */
+static int swiotlb_pcp_get(struct device *dev, size_t alloc_size,
+		unsigned int alloc_align_mask)
+{
+	struct io_tlb_pool *pool = &io_tlb_default_mem.defpool;
+	int class = swiotlb_pcp_class(dev, alloc_size, alloc_align_mask);
+	struct io_tlb_pcp *pcp;
+	unsigned long flags;
+	int index = -1;
+	unsigned int i;
+
+	if (class < 0)
+		return -1;
+
+	local_lock_irqsave(&io_tlb_pcp.lock, flags);
+	pcp = this_cpu_ptr(&io_tlb_pcp);
+	if (pcp->nr[class])
+		index = pcp->index[class][--pcp->nr[class]];
+	local_unlock_irqrestore(&io_tlb_pcp.lock, flags);
+
+	if (index < 0)
+		return -1;
+
+	for (i = 0; i < io_tlb_pcp_nslots[class]; i++)
+		pool->slots[index + i].alloc_size =
+			alloc_size - (i << IO_TLB_SHIFT);
+	return index;
+}
+
+/* Return: %true if the slots were parked in the local cache */
+static bool swiotlb_pcp_put(struct io_tlb_pool *pool, unsigned int index,
+		unsigned int nslots)
+{
+	struct io_tlb_pcp *pcp;
+	unsigned long flags;
+	bool cached = false;
+	int class;
+	unsigned int i;
+
+	if (!io_tlb_pcp_enabled || pool != &io_tlb_default_mem.defpool)
+		return false;
+	if (nslots == 1)
+		class = 0;
+	else if (nslots == SLABS_PER_PAGE && IS_ALIGNED(index, SLABS_PER_PAGE))
+		class = 1;
+	else
+		return false;
+
+	for (i = index; i < index + nslots; i++) {
+		pool->slots[i].orig_addr = INVALID_PHYS_ADDR;
+		pool->slots[i].alloc_size = 0;
+		pool->slots[i].pad_slots = 0;
+	}
+
+	local_lock_irqsave(&io_tlb_pcp.lock, flags);
+	pcp = this_cpu_ptr(&io_tlb_pcp);
+	if (pcp->nr[class] < IO_TLB_PCP_NR) {
+		pcp->index[class][pcp->nr[class]++] = index;
+		cached = true;
+	}
+	local_unlock_irqrestore(&io_tlb_pcp.lock, flags);
+
+	return cached;
+}
+
 /**
  * swiotlb_search_pool_area() - search one memory area in one pool
  * @dev:	Device which maps the buffer.
@@ -1058,6 +1194,10 @@ static int swiotlb_search_pool_area(struct device *dev, struct io_tlb_pool *pool
 	 */
 	stride = get_max_slots(max(alloc_align_mask, iotlb_align_mask));
 
+	/* Skip areas that are too full without bouncing their lock around */
+	if (unlikely(nslots > pool->area_nslabs - READ_ONCE(area->used)))
+		return -1;
+
 	spin_lock_irqsave(&area->lock, flags);
 	if (unlikely(nslots > pool->area_nslabs - area->used))
 		goto not_found;
@@ -1113,7 +1253,7 @@ static int swiotlb_search_pool_area(struct device *dev, struct io_tlb_pool *pool
 	 * Update the indices to avoid searching in the next round.
 	 */
 	area->index = wrap_area_index(pool, index + nslots);
-	area->used += nslots;
+	WRITE_ONCE(area->used, area->used + nslots);
 	spin_unlock_irqrestore(&area->lock, flags);
 
 	inc_used_and_hiwater(dev->dma_io_tlb_mem, nslots);
@@ -1193,6 +1333,12 @@ static int swiotlb_find_slots(struct device *dev, phys_addr_t orig_addr,
 	if (alloc_size > IO_TLB_SEGSIZE * IO_TLB_SIZE)
 		return -1;
 
+	index = swiotlb_pcp_get(dev, alloc_size, alloc_align_mask);
+	if (index >= 0) {
+		pool = &mem->defpool;
+		goto found;
+	}
+
 	cpu = raw_smp_processor_id();
 	for (i = 0; i < default_nareas; ++i) {
 		index = swiotlb_search_area(dev, cpu, i, orig_addr, alloc_size,
@@ -1263,6 +1409,10 @@ static int swiotlb_find_slots(struct device *dev, phys_addr_t orig_addr,
 	int index;
 
 	*retpool = pool = &dev->dma_io_tlb_mem->defpool;
+	index = swiotlb_pcp_get(dev, alloc_size, alloc_align_mask);
+	if (index >= 0)
+		return index;
+
 	i = start = raw_smp_processor_id() & (pool->nareas - 1);
 	do {
 		index = swiotlb_search_pool_area(dev, pool, i, orig_addr,
@@ -1452,6 +1602,9 @@ static void swiotlb_release_slots(struct device *dev, phys_addr_t tlb_addr,
 	index = (tlb_addr - offset - mem->start) >> IO_TLB_SHIFT;
 	index -= mem->slots[index].pad_slots;
 	nslots = nr_slots(mem->slots[index].alloc_size + offset);
+	if (swiotlb_pcp_put(mem, index, nslots))
+		return;
+
 	aindex = index / mem->area_nslabs;
 	area = &mem->areas[aindex];
 
@@ -1488,7 +1641,7 @@ static void swiotlb_release_slots(struct device *dev, phys_addr_t tlb_addr,
 	     io_tlb_offset(i) != IO_TLB_SEGSIZE - 1 && mem->slots[i].list;
 	     i--)
 		mem->slots[i].list = ++count;
-	area->used -= nslots;
+	WRITE_ONCE(area->used, area->used - nslots);
 	spin_unlock_irqrestore(&area->lock, flags);
 
 	dec_used(dev->dma_io_tlb_mem, nslots);
@@ -6788,6 +6788,14 @@ static int perf_mmap(struct file *file, struct vm_area_struct *vma)
 			goto unlock;
 		}
 
+		if (event->attr.callchain_delta) {
+			ret = rb_alloc_callchain_ref(rb, event);
+			if (ret) {
+				rb_free(rb);
+				goto unlock;
+			}
+		}
+
 		atomic_set(&rb->mmap_count, 1);
 		rb->mmap_user = get_current_user();
 		rb->mmap_locked = extra;
@@ -7563,9 +7571,18 @@ void perf_output_sample(struct perf_output_handle *handle,
 	if (sample_type & PERF_SAMPLE_CALLCHAIN) {
 		int size = 1;
 
-		size += data->callchain->nr;
-		size *= sizeof(u64);
-		__output_copy(handle, data->callchain, size);
+		if (event->attr.callchain_delta) {
+			u64 shared = data->callchain_shared & ~PERF_CALLCHAIN_SHARED_NOREF;
+
+			perf_output_put(handle, data->callchain->nr);
+			perf_output_put(handle, data->callchain_shared);
+			__output_copy(handle, data->callchain->ip,
+				      (data->callchain->nr - shared) * sizeof(u64));
+		} else {
+			size += data->callchain->nr;
+			size *= sizeof(u64);
+			__output_copy(handle, data->callchain, size);
+		}
 	}
 
 	if (sample_type & PERF_SAMPLE_RAW) {
@@ -8112,6 +8129,69 @@ static void perf_event_aux_pause(struct perf_event *event, bool pause)
 	ring_buffer_put(rb);
 }
 
+/*
+ * attr.callchain_delta: drop the root-side entries that the callchain of
+ * @data shares with the last one written to the buffer. Only one writer at a
+ * time owns the reference; nested writers, on overwrite buffers or with
+ * callchains too large for the reference, write the full callchain instead.
+ */
+static struct perf_buffer *
+perf_callchain_delta_begin(struct perf_event *event,
+			   struct perf_sample_data *data)
+{
+	struct perf_callchain_entry *ref, *entry = data->callchain;
+	struct perf_buffer *rb;
+	u64 shared = 0;
+
+	if (!event->attr.callchain_delta ||
+	    !(data->sample_flags & PERF_SAMPLE_CALLCHAIN))
+		return NULL;
+
+	if (event->parent)
+		event = event->parent;
+
+	rb = rcu_dereference(event->rb);
+	if (!rb || rb->overwrite || !rb->callchain_ref ||
+	    entry->nr > rb->callchain_ref_max)
+		return NULL;
+
+	if (atomic_cmpxchg(&rb->callchain_busy, 0, 1))
+		return NULL;
+
+	ref = rb->callchain_ref;
+	while (shared < entry->nr && shared < ref->nr &&
+	       entry->ip[entry->nr - shared - 1] == ref->ip[ref->nr - shared - 1])
+		shared++;
+
+	data->callchain_shared = shared;
+	data->dyn_size -= shared * sizeof(u64);
+
+	return rb;
+}
+
+static void perf_callchain_delta_end(struct perf_buffer *rb,
+				     struct perf_sample_data *data,
+				     bool written)
+{
+	struct perf_callchain_entry *ref, *entry = data->callchain;
+
+	if (!rb)
+		return;
+
+	if (written) {
+		ref = rb->callchain_ref;
+		/* Same length: the shared entries are already in place */
+		if (ref->nr == entry->nr)
+			memcpy(ref->ip, entry->ip,
+			       (entry->nr - data->callchain_shared) * sizeof(u64));
+		else
+			memcpy(ref->ip, entry->ip, entry->nr * sizeof(u64));
+		ref->nr = entry->nr;
+	}
+
+	atomic_set_release(&rb->callchain_busy, 0);
+}
+
 static __always_inline int
 __perf_event_output(struct perf_event *event,
 		    struct perf_sample_data *data,
@@ -8123,12 +8203,14 @@ __perf_event_output(struct perf_event *event,
 {
 	struct perf_output_handle handle;
 	struct perf_event_header header;
+	struct perf_buffer *delta_rb;
 	int err;
 
 	/* protect the callchain buffers */
 	rcu_read_lock();
 
 	perf_prepare_sample(data, event, regs);
+	delta_rb = perf_callchain_delta_begin(event, data);
 	perf_prepare_header(&header, data, event, regs);
 
 	err = output_begin(&handle, data, event, header.size);
@@ -8140,6 +8222,7 @@ __perf_event_output(struct perf_event *event,
 	perf_output_end(&handle);
 
 exit:
+	perf_callchain_delta_end(delta_rb, data, !err);
 	rcu_read_unlock();
 	return err;
 }
@@ -12245,6 +12328,9 @@ perf_event_alloc(struct perf_event_attr *attr, int cpu,
 		return ERR_PTR(-EINVAL);
 	}
 
+	if (attr->callchain_delta && cpu == -1)
+		return ERR_PTR(-EINVAL);
+
 	node = (cpu >= 0) ? cpu_to_node(cpu) : -1;
 	event = kmem_cache_alloc_node(perf_event_cache, GFP_KERNEL | __GFP_ZERO,
 				      node);
@@ -12591,6 +12677,12 @@ static int perf_copy_attr(struct perf_event_attr __user *uattr,
 	if (attr->sigtrap && !attr->remove_on_exec)
 		return -EINVAL;
 
+	/* The reference callchain is per buffer, and buffers per CPU */
+	if (attr->callchain_delta &&
+	    (attr->sample_type & (PERF_SAMPLE_CALLCHAIN | PERF_SAMPLE_CPU)) !=
+	    (PERF_SAMPLE_CALLCHAIN | PERF_SAMPLE_CPU))
+		return -EINVAL;
+
 out:
 	return ret;
 
@@ -56,6 +56,11 @@ struct perf_buffer {
 	void				**aux_pages;
 	void				*aux_priv;
 
+	/* attr.callchain_delta: last callchain written, and its writer */
+	struct perf_callchain_entry	*callchain_ref;
+	unsigned int			callchain_ref_max;
+	atomic_t			callchain_busy;
+
 	struct perf_event_mmap_page	*user_page;
 	void				*data_pages[];
 };
@@ -80,6 +85,8 @@ static inline void rb_toggle_paused(struct perf_buffer *rb, bool pause)
 
 extern struct perf_buffer *
 rb_alloc(int nr_pages, long watermark, int cpu, int flags);
+extern int rb_alloc_callchain_ref(struct perf_buffer *rb,
+				  struct perf_event *event);
 extern void perf_event_wakeup(struct perf_event *event);
 extern int rb_alloc_aux(struct perf_buffer *rb, struct perf_event *event,
 			pgoff_t pgoff, int nr_pages, long watermark, int flags);
@@ -874,6 +874,7 @@ void rb_free(struct perf_buffer *rb)
 	perf_mmap_free_page(rb->user_page);
 	for (i = 0; i < rb->nr_pages; i++)
 		perf_mmap_free_page(rb->data_pages[i]);
+	kfree(rb->callchain_ref);
 	kfree(rb);
 }
 
@@ -895,6 +896,7 @@ static void rb_free_work(struct work_struct *work)
 	rb = container_of(work, struct perf_buffer, work);
 
 	vfree(rb->user_page);
+	kfree(rb->callchain_ref);
 	kfree(rb);
 }
 
@@ -944,6 +946,26 @@ struct perf_buffer *rb_alloc(int nr_pages, long watermark, int cpu, int flags)
 
 #endif
 
+/*
+ * Room for the reference callchain of attr.callchain_delta; callchains of
+ * other events sharing the buffer that do not fit are written in full.
+ */
+int rb_alloc_callchain_ref(struct perf_buffer *rb, struct perf_event *event)
+{
+	unsigned int max = event->attr.sample_max_stack +
+			   sysctl_perf_event_max_contexts_per_stack;
+	int node = (event->cpu == -1) ? -1 : cpu_to_node(event->cpu);
+
+	rb->callchain_ref = kzalloc_node(struct_size(rb->callchain_ref, ip, max),
+					 GFP_KERNEL, node);
+	if (!rb->callchain_ref)
+		return -ENOMEM;
+
+	rb->callchain_ref_max = max;
+
+	return 0;
+}
+
 struct page *
 perf_mmap_to_page(struct perf_buffer *rb, unsigned long pgoff)
 {
@@ -636,6 +636,8 @@ static __latent_entropy int dup_mmap(struct mm_struct *mm,
 	struct vm_area_struct *mpnt, *tmp;
 	int retval;
 	unsigned long charge = 0;
+	struct vma_copy *deferred = NULL;
+	unsigned int nr_deferred = 0, nr_threads;
 	LIST_HEAD(uf);
 	VMA_ITERATOR(vmi, mm, 0);
 
@@ -661,6 +663,15 @@ static __latent_entropy int dup_mmap(struct mm_struct *mm,
 	if (unlikely(retval))
 		goto out;
 
+	/*
+	 * With PR_SET_FORK_COPY_THREADS, the page tables of large private
+	 * mappings are copied once all the vmas are set up, in parallel.
+	 */
+	nr_threads = READ_ONCE(oldmm->fork_copy_threads);
+	if (nr_threads > 1)
+		deferred = kvmalloc_array(oldmm->map_count, sizeof(*deferred),
+					  GFP_KERNEL);
+
 	mt_clear_in_rcu(vmi.mas.tree);
 	for_each_vma(vmi, mpnt) {
 		struct file *file;
@@ -744,17 +755,28 @@ static __latent_entropy int dup_mmap(struct mm_struct *mm,
 			i_mmap_unlock_write(mapping);
 		}
 
-		if (!(tmp->vm_flags & VM_WIPEONFORK))
-			retval = copy_page_range(tmp, mpnt);
+		if (!(tmp->vm_flags & VM_WIPEONFORK)) {
+			if (deferred && copy_page_range_can_defer(mpnt)) {
+				deferred[nr_deferred].dst_vma = tmp;
+				deferred[nr_deferred++].src_vma = mpnt;
+			} else {
+				retval = copy_page_range(tmp, mpnt);
+			}
+		}
 
 		if (retval) {
 			mpnt = vma_next(&vmi);
 			goto loop_out;
 		}
 	}
+	if (nr_deferred)
+		retval = copy_page_ranges_parallel(deferred, nr_deferred,
+						   nr_threads);
 	/* a new mm has just been created */
-	retval = arch_dup_mmap(oldmm, mm);
+	if (!retval)
+		retval = arch_dup_mmap(oldmm, mm);
 loop_out:
+	kvfree(deferred);
 	vma_iter_free(&vmi);
 	if (!retval) {
 		mt_set_in_rcu(vmi.mas.tree);
@@ -936,6 +958,7 @@ void __mmdrop(struct mm_struct *mm)
 	mm_pasid_drop(mm);
 	mm_destroy_cid(mm);
 	percpu_counter_destroy_many(mm->rss_stat, NR_MM_COUNTERS);
+	futex_hash_free(mm);
 
 	free_mm(mm);
 }
@@ -1260,6 +1283,7 @@ static void mm_init_uprobes_state(struct mm_struct *mm)
 {
 #ifdef CONFIG_UPROBES
 	mm->uprobes_state.xol_area = NULL;
+	INIT_HLIST_HEAD(&mm->uprobes_state.head_tramps);
 #endif
 }
 
@@ -1289,9 +1313,19 @@ static struct mm_struct *mm_init(struct mm_struct *mm, struct task_struct *p,
 	init_tlb_flush_pending(mm);
 #if defined(CONFIG_TRANSPARENT_HUGEPAGE) && !defined(CONFIG_SPLIT_PMD_PTLOCKS)
 	mm->pmd_huge_pte = NULL;
+#endif
+#ifdef CONFIG_TRANSPARENT_HUGEPAGE
+	atomic_set(&mm->mthp_anon_score, 0);
+	mm->mthp_anon_demote = 0;
 #endif
 	mm_init_uprobes_state(mm);
 	hugetlb_count_init(mm);
+#ifdef CONFIG_MEMBARRIER
+	mm->membarrier_seq = 0;
+#endif
+#ifdef CONFIG_FUTEX
+	mm->futex_phash = NULL;
+#endif
 
 	if (current->mm) {
 		mm->flags = mmf_init_flags(current->mm->flags);
@@ -1396,6 +1430,47 @@ void mmput_async(struct mm_struct *mm)
 	}
 }
 EXPORT_SYMBOL_GPL(mmput_async);
+
+static struct workqueue_struct *mm_reaper_wq __ro_after_init;
+
+/**
+ * mmput_exit - drop the reference an exiting task holds on its mm
+ * @mm: the mm the task just detached from
+ *
+ * With PR_SET_EXIT_MM_ASYNC, the last reference does not tear the address
+ * space down in the exiting task but queues that to a worker on the node
+ * the task ran on, so that the task can be reaped without waiting for all
+ * of its memory to be freed. The memory is uncharged from its memcg as the
+ * worker frees it.
+ */
+void mmput_exit(struct mm_struct *mm)
+{
+	might_sleep();
+
+	/*
+	 * The OOM killer waits for a victim to exit, not for its memory to be
+	 * freed, so victims keep tearing down their own mm.
+	 */
+	if (!READ_ONCE(mm->exit_mm_async) || !mm_reaper_wq ||
+	    tsk_is_oom_victim(current)) {
+		mmput(mm);
+		return;
+	}
+
+	if (atomic_dec_and_test(&mm->mm_users)) {
+		INIT_WORK(&mm->async_put_work, mmput_async_fn);
+		queue_work_node(numa_node_id(), mm_reaper_wq,
+				&mm->async_put_work);
+	}
+}
+
+static int __init mm_reaper_init(void)
+{
+	mm_reaper_wq = alloc_workqueue("mm_reaper",
+				       WQ_UNBOUND | WQ_MEM_RECLAIM, 0);
+	return 0;
+}
+subsys_initcall(mm_reaper_init);
 #endif
 
 /**
@@ -2973,7 +3048,9 @@ noinline static int copy_clone_args_from_user(struct kernel_clone_args *kargs,
 		     CLONE_ARGS_SIZE_VER1);
 	BUILD_BUG_ON(offsetofend(struct clone_args, cgroup) !=
 		     CLONE_ARGS_SIZE_VER2);
-	BUILD_BUG_ON(sizeof(struct clone_args) != CLONE_ARGS_SIZE_VER2);
+	BUILD_BUG_ON(offsetofend(struct clone_args, exec_envp) !=
+		     CLONE_ARGS_SIZE_VER3);
+	BUILD_BUG_ON(sizeof(struct clone_args) != CLONE_ARGS_SIZE_VER3);
 
 	if (unlikely(usize > PAGE_SIZE))
 		return -E2BIG;
@@ -3005,6 +3082,13 @@ noinline static int copy_clone_args_from_user(struct kernel_clone_args *kargs,
 	    (args.cgroup > INT_MAX || usize < CLONE_ARGS_SIZE_VER2))
 		return -EINVAL;
 
+	if (args.flags & CLONE_SPAWN) {
+		if (!args.exec_path || usize < CLONE_ARGS_SIZE_VER3)
+			return -EINVAL;
+	} else if (args.exec_path || args.exec_argv || args.exec_envp) {
+		return -EINVAL;
+	}
+
 	*kargs = (struct kernel_clone_args){
 		.flags		= args.flags,
 		.pidfd		= u64_to_user_ptr(args.pidfd),
@@ -3016,6 +3100,9 @@ noinline static int copy_clone_args_from_user(struct kernel_clone_args *kargs,
 		.tls		= args.tls,
 		.set_tid_size	= args.set_tid_size,
 		.cgroup		= args.cgroup,
+		.exec_path	= u64_to_user_ptr(args.exec_path),
+		.exec_argv	= u64_to_user_ptr(args.exec_argv),
+		.exec_envp	= u64_to_user_ptr(args.exec_envp),
 	};
 
 	if (args.set_tid &&
@@ -3060,7 +3147,8 @@ static bool clone3_args_valid(struct kernel_clone_args *kargs)
 {
 	/* Verify that no unknown flags are passed along. */
 	if (kargs->flags &
-	    ~(CLONE_LEGACY_FLAGS | CLONE_CLEAR_SIGHAND | CLONE_INTO_CGROUP))
+	    ~(CLONE_LEGACY_FLAGS | CLONE_CLEAR_SIGHAND | CLONE_INTO_CGROUP |
+	      CLONE_SPAWN))
 		return false;
 
 	/*
@@ -3081,9 +3169,83 @@ static bool clone3_args_valid(struct kernel_clone_args *kargs)
 	if (!clone3_stack_valid(kargs))
 		return false;
 
+	/*
+	 * A spawned child never runs user code before its exec, so it has no
+	 * use for a stack or TLS, and it must not share anything with the
+	 * parent but the mm it is about to replace.
+	 */
+	if ((kargs->flags & CLONE_SPAWN) &&
+	    ((kargs->flags & (CLONE_VM | CLONE_VFORK | CLONE_THREAD |
+			      CLONE_SIGHAND | CLONE_SETTLS |
+			      CLONE_CHILD_SETTID | CLONE_CHILD_CLEARTID)) ||
+	     kargs->stack))
+		return false;
+
 	return true;
 }
 
+struct clone_spawn {
+	const char __user *path;
+	const void __user *argv;
+	const void __user *envp;
+	bool compat;
+};
+
+static int clone_spawn_fn(void *arg)
+{
+	struct clone_spawn spawn = *(struct clone_spawn *)arg;
+
+	kfree(arg);
+	if (!spawn_execve(spawn.path, spawn.argv, spawn.envp, spawn.compat))
+		return 0;
+
+	/* Report a program that could not be executed the way shells do */
+	do_exit(127 << 8);
+}
+
+/*
+ * Create a child that shares the mm of the parent, as with vfork(), but runs
+ * nothing but the exec of the new program from the kernel. Nothing is copied
+ * for an address space that would be thrown away right away, and the parent
+ * is only held until the child has copied its arguments and dropped the mm.
+ */
+static pid_t clone3_spawn(struct kernel_clone_args *kargs)
+{
+	struct clone_spawn *spawn;
+	pid_t pid;
+
+	/*
+	 * The exec does not go through the syscall entry of the child, so a
+	 * seccomp filter would never get to see it.
+	 */
+#ifdef CONFIG_SECCOMP
+	if (READ_ONCE(current->seccomp.mode) != SECCOMP_MODE_DISABLED)
+		return -EPERM;
+#endif
+
+	spawn = kmalloc(sizeof(*spawn), GFP_KERNEL);
+	if (!spawn)
+		return -ENOMEM;
+
+	*spawn = (struct clone_spawn) {
+		.path	= kargs->exec_path,
+		.argv	= kargs->exec_argv,
+		.envp	= kargs->exec_envp,
+		.compat	= in_compat_syscall(),
+	};
+
+	kargs->flags = (kargs->flags & ~CLONE_SPAWN) | CLONE_VM | CLONE_VFORK;
+	kargs->fn = clone_spawn_fn;
+	kargs->fn_arg = spawn;
+
+	/* Once the child exists, it owns @spawn */
+	pid = kernel_clone(kargs);
+	if (pid < 0)
+		kfree(spawn);
+
+	return pid;
+}
+
 /**
  * sys_clone3 - create a new process with specific properties
  * @uargs: argument structure
@@ -3116,6 +3278,9 @@ SYSCALL_DEFINE2(clone3, struct clone_args __user *, uargs, size_t, size)
 	if (!clone3_args_valid(&kargs))
 		return -EINVAL;
 
+	if (kargs.flags & CLONE_SPAWN)
+		return clone3_spawn(&kargs);
+
 	return kernel_clone(&kargs);
 }
 
@@ -36,7 +36,8 @@
 #include <linux/pagemap.h>
 #include <linux/debugfs.h>
 #include <linux/plist.h>
-#include <linux/memblock.h>
+#include <linux/prctl.h>
+#include <linux/nodemask.h>
 #include <linux/fault-inject.h>
 #include <linux/slab.h>
 
@@ -44,16 +45,34 @@
 #include "../locking/rtmutex_common.h"
 
 /*
- * The base of the bucket array and its size are always used together
- * (after initialization only in futex_hash()), so ensure that they
- * reside in the same cacheline.
+ * The global hash is made of one bucket array per possible node, all of the
+ * same size and allocated on their node. FUTEX2_NUMA futexes are hashed into
+ * the array of the node stored next to their value, the others are spread
+ * over all of them.
+ *
+ * The size and the bucket arrays are always used together (after
+ * initialization only in futex_hash()), so keep them next to each other.
  */
 static struct {
-	struct futex_hash_bucket *queues;
 	unsigned long            hashsize;
+	unsigned int             hashshift;
+	struct futex_hash_bucket *queues[MAX_NUMNODES];
 } __futex_data __read_mostly __aligned(2*sizeof(long));
-#define futex_queues   (__futex_data.queues)
-#define futex_hashsize (__futex_data.hashsize)
+#define futex_queues    (__futex_data.queues)
+#define futex_hashsize  (__futex_data.hashsize)
+#define futex_hashshift (__futex_data.hashshift)
+
+/*
+ * Private futexes of a process can be hashed into a table of its own, see
+ * futex_hash_prctl(). The table is only ever installed or replaced while the
+ * process is single threaded and has no io_uring, so nobody can be waiting
+ * on it or looking it up at that time, and it stays put for as long as the
+ * mm has other users.
+ */
+struct futex_private_hash {
+	unsigned int             hashsize;
+	struct futex_hash_bucket queues[];
+};
 
 
 /*
@@ -108,18 +127,125 @@ late_initcall(fail_futex_debugfs);
 #endif /* CONFIG_FAIL_FUTEX */
 
 /**
- * futex_hash - Return the hash bucket in the global hash
+ * futex_hash - Return the hash bucket for a futex key
  * @key:	Pointer to the futex key for which the hash is calculated
  *
  * We hash on the keys returned from get_futex_key (see below) and return the
- * corresponding hash bucket in the global hash.
+ * corresponding hash bucket: in the per-node array of the global hash given
+ * by the key for FUTEX2_NUMA futexes, else in the private hash of the mm for
+ * private keys when it has one, else in the global hash.
  */
 struct futex_hash_bucket *futex_hash(union futex_key *key)
 {
 	u32 hash = jhash2((u32 *)key, offsetof(typeof(*key), both.offset) / 4,
 			  key->both.offset);
+	int node = key->both.node;
+
+	if (node != FUTEX_NO_NODE)
+		return &futex_queues[node][hash & (futex_hashsize - 1)];
+
+	if (!(key->both.offset & (FUT_OFF_INODE | FUT_OFF_MMSHARED)) &&
+	    key->private.mm) {
+		struct futex_private_hash *fph;
+
+		fph = READ_ONCE(key->private.mm->futex_phash);
+		if (fph)
+			return &fph->queues[hash & (fph->hashsize - 1)];
+	}
+
+	node = (hash >> futex_hashshift) % nr_node_ids;
+	if (!node_possible(node))
+		node = find_next_bit_wrap(node_possible_map.bits, nr_node_ids,
+					  node);
+
+	return &futex_queues[node][hash & (futex_hashsize - 1)];
+}
+
+static void futex_hash_bucket_init(struct futex_hash_bucket *hb)
+{
+	atomic_set(&hb->waiters, 0);
+	plist_head_init(&hb->chain);
+	spin_lock_init(&hb->lock);
+}
+
+void futex_hash_free(struct mm_struct *mm)
+{
+	kvfree(mm->futex_phash);
+}
+
+static int futex_hash_set_slots(unsigned int slots)
+{
+	struct mm_struct *mm = current->mm;
+	struct futex_private_hash *fph = NULL, *old;
+	unsigned int i;
+
+	if (slots && (!is_power_of_2(slots) || slots < 2 ||
+		      slots > futex_hashsize * num_possible_nodes()))
+		return -EINVAL;
+
+	/*
+	 * Waiters hashed into the current table would be lost by a switch, so
+	 * only allow it when the caller is the only one who could be waiting:
+	 * no other thread and no io_uring, which queues futex waits on behalf
+	 * of the task without it sleeping.
+	 */
+	if (atomic_read(&mm->mm_users) != 1)
+		return -EBUSY;
+#ifdef CONFIG_IO_URING
+	if (current->io_uring)
+		return -EBUSY;
+#endif
+
+	if (slots) {
+		fph = kvzalloc(struct_size(fph, queues, slots),
+			       GFP_KERNEL_ACCOUNT);
+		if (!fph)
+			return -ENOMEM;
 
-	return &futex_queues[hash & (futex_hashsize - 1)];
+		fph->hashsize = slots;
+		for (i = 0; i < slots; i++)
+			futex_hash_bucket_init(&fph->queues[i]);
+	}
+
+	old = mm->futex_phash;
+	WRITE_ONCE(mm->futex_phash, fph);
+	kvfree(old);
+
+	return 0;
+}
+
+/**
+ * futex_hash_prctl - PR_FUTEX_HASH handler
+ * @arg2:	PR_FUTEX_HASH_SET_SLOTS or PR_FUTEX_HASH_GET_SLOTS
+ * @arg3:	Number of slots for SET, a power of two no larger than the
+ *		global hash, or 0 to use the global hash again
+ * @arg4:	Must be 0
+ * @arg5:	Must be 0
+ *
+ * Return: 0 or the number of slots of the private hash (0 if there is none)
+ * on success, negative error code otherwise.
+ */
+int futex_hash_prctl(unsigned long arg2, unsigned long arg3,
+		     unsigned long arg4, unsigned long arg5)
+{
+	struct futex_private_hash *fph;
+
+	if (arg4 || arg5)
+		return -EINVAL;
+
+	switch (arg2) {
+	case PR_FUTEX_HASH_SET_SLOTS:
+		if (arg3 > UINT_MAX)
+			return -EINVAL;
+		return futex_hash_set_slots(arg3);
+	case PR_FUTEX_HASH_GET_SLOTS:
+		if (arg3)
+			return -EINVAL;
+		fph = READ_ONCE(current->mm->futex_phash);
+		return fph ? fph->hashsize : 0;
+	}
+
+	return -EINVAL;
 }
 
 
@@ -228,24 +354,53 @@ int get_futex_key(u32 __user *uaddr, unsigned int flags, union futex_key *key,
 	struct folio *folio;
 	struct address_space *mapping;
 	int err, ro = 0;
+	unsigned int size = sizeof(u32);
 	bool fshared;
 
 	fshared = flags & FLAGS_SHARED;
 
+	/* A FUTEX2_NUMA futex is followed by its node, as a word of same size */
+	if (flags & FLAGS_NUMA)
+		size *= 2;
+
 	/*
 	 * The futex address must be "naturally" aligned.
 	 */
 	key->both.offset = address % PAGE_SIZE;
-	if (unlikely((address % sizeof(u32)) != 0))
+	if (unlikely((address % size) != 0))
 		return -EINVAL;
 	address -= key->both.offset;
 
-	if (unlikely(!access_ok(uaddr, sizeof(u32))))
+	if (unlikely(!access_ok(uaddr, size)))
 		return -EFAULT;
 
 	if (unlikely(should_fail_futex(fshared)))
 		return -EFAULT;
 
+	key->both.node = FUTEX_NO_NODE;
+	if (flags & FLAGS_NUMA) {
+		u32 __user *naddr = uaddr + 1;
+		int node;
+
+		if (get_user(node, naddr))
+			return -EFAULT;
+
+		/*
+		 * Let the first user of the futex pick the local node; later
+		 * ones find it in the futex and queue up on the same node.
+		 */
+		if (node == FUTEX_NO_NODE) {
+			node = numa_node_id();
+			if (put_user(node, naddr))
+				return -EFAULT;
+		} else if (node < 0 || node >= MAX_NUMNODES ||
+			   !node_possible(node)) {
+			return -EINVAL;
+		}
+
+		key->both.node = node;
+	}
+
 	/*
 	 * PROCESS_PRIVATE futexes are fast.
 	 * As the mm cannot disappear under us and the 'key' only needs
@@ -1127,27 +1282,40 @@ void futex_exit_release(struct task_struct *tsk)
 
 static int __init futex_init(void)
 {
-	unsigned int futex_shift;
-	unsigned long i;
+	unsigned long hashsize, i;
+	size_t size;
+	int n;
 
 #ifdef CONFIG_BASE_SMALL
-	futex_hashsize = 16;
+	hashsize = 16;
 #else
-	futex_hashsize = roundup_pow_of_two(256 * num_possible_cpus());
+	hashsize = roundup_pow_of_two(256 * num_possible_cpus());
 #endif
+	hashsize = roundup_pow_of_two(DIV_ROUND_UP(hashsize,
+						   num_possible_nodes()));
+	hashsize = max(4UL, hashsize);
+	size = hashsize * sizeof(struct futex_hash_bucket);
+
+	for_each_node(n) {
+		struct futex_hash_bucket *table;
 
-	futex_queues = alloc_large_system_hash("futex", sizeof(*futex_queues),
-					       futex_hashsize, 0, 0,
-					       &futex_shift, NULL,
-					       futex_hashsize, futex_hashsize);
-	futex_hashsize = 1UL << futex_shift;
+		table = kvmalloc_node(size, GFP_KERNEL, n);
+		if (!table)
+			panic("futex: failed to allocate the hash table of node %d\n",
+			      n);
 
-	for (i = 0; i < futex_hashsize; i++) {
-		atomic_set(&futex_queues[i].waiters, 0);
-		plist_head_init(&futex_queues[i].chain);
-		spin_lock_init(&futex_queues[i].lock);
+		for (i = 0; i < hashsize; i++)
+			futex_hash_bucket_init(&table[i]);
+
+		futex_queues[n] = table;
 	}
 
+	futex_hashsize = hashsize;
+	futex_hashshift = ilog2(hashsize);
+
+	pr_info("futex hash table entries: %lu (%zu bytes on %d NUMA nodes)\n",
+		hashsize, size, num_possible_nodes());
+
 	return 0;
 }
 core_initcall(futex_init);
@@ -118,6 +118,8 @@ unsigned int irq_calc_affinity_vectors(unsigned int minvec, unsigned int maxvec,
 
 	if (affd->calc_sets) {
 		set_vecs = maxvec - resv;
+	} else if (affd->per_llc) {
+		set_vecs = group_cpus_nr_llcs();
 	} else {
 		cpus_read_lock();
 		set_vecs = cpumask_weight(cpu_possible_mask);
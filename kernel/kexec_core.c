@@ -136,6 +136,9 @@ int sanity_check_segment_list(struct kimage *image)
 			return -EADDRNOTAVAIL;
 		if (mend >= KEXEC_DESTINATION_MEMORY_LIMIT)
 			return -EADDRNOTAVAIL;
+		/* Don't overwrite memory handed over to the next kernel */
+		if (kexec_preserve_overlaps(mstart, mend - 1))
+			return -EADDRNOTAVAIL;
 	}
 
 	/* Verify our destination addresses do not overlap.
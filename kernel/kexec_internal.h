@@ -31,6 +31,21 @@ static inline void kexec_unlock(void)
 	atomic_set_release(&__kexec_lock, 0);
 }
 
+#ifdef CONFIG_KEXEC_PRESERVE
+bool kexec_preserve_overlaps(unsigned long start, unsigned long end);
+int kexec_preserve_add_buffer(struct kimage *image);
+#else
+static inline bool kexec_preserve_overlaps(unsigned long start,
+					   unsigned long end)
+{
+	return false;
+}
+static inline int kexec_preserve_add_buffer(struct kimage *image)
+{
+	return 0;
+}
+#endif
+
 #ifdef CONFIG_KEXEC_FILE
 #include <linux/purgatory.h>
 void kimage_file_post_load_cleanup(struct kimage *image);
@@ -0,0 +1,306 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Hand memory regions over to the next kernel across kexec.
+ *
+ * A subsystem whose memory should survive a kexec reboot (a hugetlb pool,
+ * guest memory, a cache) registers the physical range under a name with
+ * kexec_preserve_range(). kexec_file_load() writes the registered ranges
+ * into a descriptor segment and appends "kexec_preserve=<phys>" to the
+ * command line of the next kernel, while the segments of the new image
+ * are placed around the preserved ranges.
+ *
+ * Early in boot, the next kernel reserves the descriptor and every range
+ * in memblock, before anything can allocate from them. The new owner
+ * finds its memory again by name with kexec_preserved_range(), and hands
+ * it to the page allocator with kexec_preserved_release() once it has
+ * no more use for it. The contents of the ranges are the owner's own
+ * business; only location and size are carried over.
+ */
+
+#define pr_fmt(fmt)	"kexec_preserve: " fmt
+
+#include <linux/io.h>
+#include <linux/kexec.h>
+#include <linux/memblock.h>
+#include <linux/mm.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/string.h>
+
+#define KEXEC_PRESERVE_MAGIC	0x5350524bU	/* "KPRS" */
+#define KEXEC_PRESERVE_MAX	32
+
+struct kexec_preserve_entry {
+	char name[KEXEC_PRESERVE_NAME_LEN];
+	u64 start;
+	u64 size;
+};
+
+/* The descriptor segment, also passed as is to the next kernel */
+struct kexec_preserve_desc {
+	u32 magic;
+	u32 nr;
+	struct kexec_preserve_entry entries[KEXEC_PRESERVE_MAX];
+};
+
+static_assert(sizeof(struct kexec_preserve_desc) <= PAGE_SIZE);
+
+/* Ranges to hand over to the next kernel */
+static struct kexec_preserve_desc preserve_out;
+/* Ranges handed over by the previous kernel, until released */
+static struct kexec_preserve_desc preserve_in;
+static DEFINE_SPINLOCK(preserve_lock);
+
+static struct kexec_preserve_entry *
+find_entry(struct kexec_preserve_desc *desc, const char *name)
+{
+	unsigned int i;
+
+	for (i = 0; i < desc->nr; i++)
+		if (desc->entries[i].size &&
+		    !strncmp(desc->entries[i].name, name, KEXEC_PRESERVE_NAME_LEN))
+			return &desc->entries[i];
+	return NULL;
+}
+
+static bool desc_overlaps(struct kexec_preserve_desc *desc, u64 start, u64 end)
+{
+	unsigned int i;
+
+	for (i = 0; i < desc->nr; i++) {
+		struct kexec_preserve_entry *e = &desc->entries[i];
+
+		if (e->size && start < e->start + e->size && end > e->start)
+			return true;
+	}
+	return false;
+}
+
+/**
+ * kexec_preserve_range - hand a memory range over to the next kernel
+ * @name: name the next kernel will find the range under
+ * @start: physical start address, page aligned
+ * @size: size in bytes, page aligned
+ *
+ * The range must stay allocated and untouched by anything but its owner
+ * until the kexec. Ranges registered after kexec_file_load() are only
+ * passed on by the next load.
+ *
+ * Return: 0 on success, -EINVAL for a bad range or name, -EEXIST if the
+ * name or the memory is already registered, -ENOSPC if the descriptor
+ * is full.
+ */
+int kexec_preserve_range(const char *name, phys_addr_t start, size_t size)
+{
+	struct kexec_preserve_entry *e;
+	int ret = 0;
+
+	if (!size || !PAGE_ALIGNED(start) || !PAGE_ALIGNED(size) ||
+	    start + size < start || strlen(name) >= KEXEC_PRESERVE_NAME_LEN)
+		return -EINVAL;
+
+	spin_lock(&preserve_lock);
+	if (find_entry(&preserve_out, name) ||
+	    desc_overlaps(&preserve_out, start, start + size)) {
+		ret = -EEXIST;
+		goto out;
+	}
+
+	e = find_entry(&preserve_out, "");
+	if (!e) {
+		if (preserve_out.nr == KEXEC_PRESERVE_MAX) {
+			ret = -ENOSPC;
+			goto out;
+		}
+		e = &preserve_out.entries[preserve_out.nr++];
+	}
+	strscpy(e->name, name, KEXEC_PRESERVE_NAME_LEN);
+	e->start = start;
+	e->size = size;
+out:
+	spin_unlock(&preserve_lock);
+	return ret;
+}
+EXPORT_SYMBOL_GPL(kexec_preserve_range);
+
+/**
+ * kexec_unpreserve_range - stop handing a range over to the next kernel
+ * @name: name the range was registered under
+ */
+void kexec_unpreserve_range(const char *name)
+{
+	struct kexec_preserve_entry *e;
+
+	spin_lock(&preserve_lock);
+	e = find_entry(&preserve_out, name);
+	if (e)
+		memset(e, 0, sizeof(*e));
+	spin_unlock(&preserve_lock);
+}
+EXPORT_SYMBOL_GPL(kexec_unpreserve_range);
+
+/*
+ * Whether [start, end] holds memory that must outlive the kexec: either a
+ * range to hand over, or one received from the previous kernel that has
+ * not been released yet. Segments of a new image must avoid both.
+ */
+bool kexec_preserve_overlaps(unsigned long start, unsigned long end)
+{
+	bool ret;
+
+	spin_lock(&preserve_lock);
+	ret = desc_overlaps(&preserve_out, start, (u64)end + 1) ||
+	      desc_overlaps(&preserve_in, start, (u64)end + 1);
+	spin_unlock(&preserve_lock);
+	return ret;
+}
+
+/*
+ * Called by kexec_file_load() before the image loader runs: add the
+ * descriptor as a segment and point the next kernel's command line at it.
+ */
+int kexec_preserve_add_buffer(struct kimage *image)
+{
+	struct kexec_buf kbuf = { .image = image, .buf_align = PAGE_SIZE,
+				  .buf_min = 0, .buf_max = ULONG_MAX,
+				  .top_down = true };
+	struct kexec_preserve_desc *desc;
+	char *cmdline;
+	int ret;
+
+	if (image->type == KEXEC_TYPE_CRASH || !READ_ONCE(preserve_out.nr))
+		return 0;
+
+	desc = kzalloc(PAGE_SIZE, GFP_KERNEL);
+	if (!desc)
+		return -ENOMEM;
+
+	spin_lock(&preserve_lock);
+	*desc = preserve_out;
+	spin_unlock(&preserve_lock);
+	desc->magic = KEXEC_PRESERVE_MAGIC;
+
+	kbuf.buffer = desc;
+	kbuf.bufsz = PAGE_SIZE;
+	kbuf.memsz = PAGE_SIZE;
+	ret = kexec_add_buffer(&kbuf);
+	if (ret)
+		goto err;
+
+	cmdline = kasprintf(GFP_KERNEL, "%s%skexec_preserve=0x%lx",
+			    image->cmdline_buf ?: "",
+			    image->cmdline_buf ? " " : "", kbuf.mem);
+	if (!cmdline) {
+		ret = -ENOMEM;
+		goto err;
+	}
+	kfree(image->cmdline_buf);
+	image->cmdline_buf = cmdline;
+	image->cmdline_buf_len = strlen(cmdline) + 1;
+	image->preserve_buf = desc;
+
+	kexec_dprintk("%u preserved ranges, descriptor at 0x%lx\n",
+		      desc->nr, kbuf.mem);
+	return 0;
+
+err:
+	kfree(desc);
+	return ret;
+}
+
+static int __init kexec_preserve_setup(char *str)
+{
+	struct kexec_preserve_desc *desc;
+	unsigned long long phys;
+	unsigned int i;
+
+	if (!str || kstrtoull(str, 0, &phys) || !PAGE_ALIGNED(phys))
+		return -EINVAL;
+
+	desc = early_memremap(phys, sizeof(*desc));
+	if (!desc)
+		return -ENOMEM;
+
+	if (desc->magic != KEXEC_PRESERVE_MAGIC || desc->nr > KEXEC_PRESERVE_MAX) {
+		pr_warn("bad descriptor at 0x%llx, not preserving anything\n",
+			phys);
+		early_memunmap(desc, sizeof(*desc));
+		return -EINVAL;
+	}
+
+	preserve_in = *desc;
+	early_memunmap(desc, sizeof(*desc));
+
+	for (i = 0; i < preserve_in.nr; i++) {
+		struct kexec_preserve_entry *e = &preserve_in.entries[i];
+
+		if (!e->size)
+			continue;
+		e->name[KEXEC_PRESERVE_NAME_LEN - 1] = '\0';
+		memblock_reserve(e->start, e->size);
+	}
+	/* The descriptor has been copied, its page is free to use */
+
+	pr_info("received %u ranges from the previous kernel\n",
+		preserve_in.nr);
+	return 0;
+}
+early_param("kexec_preserve", kexec_preserve_setup);
+
+/**
+ * kexec_preserved_range - look up a range handed over by the previous kernel
+ * @name: name the range was registered under
+ * @start: returns the physical start address
+ * @size: returns the size in bytes
+ *
+ * Return: 0 if found, -ENOENT otherwise.
+ */
+int kexec_preserved_range(const char *name, phys_addr_t *start, size_t *size)
+{
+	struct kexec_preserve_entry *e;
+	int ret = -ENOENT;
+
+	spin_lock(&preserve_lock);
+	e = find_entry(&preserve_in, name);
+	if (e) {
+		*start = e->start;
+		*size = e->size;
+		ret = 0;
+	}
+	spin_unlock(&preserve_lock);
+	return ret;
+}
+EXPORT_SYMBOL_GPL(kexec_preserved_range);
+
+/**
+ * kexec_preserved_release - give a handed over range to the page allocator
+ * @name: name the range was registered under
+ *
+ * Owners that keep using the memory across the next kexec as well should
+ * register it again with kexec_preserve_range() instead.
+ */
+void kexec_preserved_release(const char *name)
+{
+	struct kexec_preserve_entry *e;
+	phys_addr_t start = 0;
+	size_t size = 0;
+
+	spin_lock(&preserve_lock);
+	e = find_entry(&preserve_in, name);
+	if (e) {
+		start = e->start;
+		size = e->size;
+		memset(e, 0, sizeof(*e));
+	}
+	spin_unlock(&preserve_lock);
+
+	if (!size)
+		return;
+
+	if (slab_is_available())
+		free_reserved_area(phys_to_virt(start),
+				   phys_to_virt(start + size), -1, NULL);
+	else
+		memblock_phys_free(start, size);
+}
+EXPORT_SYMBOL_GPL(kexec_preserved_release);
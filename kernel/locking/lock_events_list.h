@@ -47,8 +47,26 @@ LOCK_EVENT(lock_use_node2)	/* # of locking ops that use 2nd percpu node */
 LOCK_EVENT(lock_use_node3)	/* # of locking ops that use 3rd percpu node */
 LOCK_EVENT(lock_use_node4)	/* # of locking ops that use 4th percpu node */
 LOCK_EVENT(lock_no_node)	/* # of locking ops w/o using percpu node    */
+
+#ifdef CONFIG_NUMA_AWARE_SPINLOCKS
+/*
+ * Locking events for the NUMA-aware qspinlock (CNA).
+ */
+LOCK_EVENT(lock_cna_move)	/* # of waiter runs moved to the 2nd queue   */
+LOCK_EVENT(lock_cna_local)	/* # of hand-overs keeping the 2nd queue     */
+LOCK_EVENT(lock_cna_flush)	/* # of 2nd queues put back in front	     */
+LOCK_EVENT(lock_cna_splice)	/* # of 2nd queues becoming the main queue   */
+#endif /* CONFIG_NUMA_AWARE_SPINLOCKS */
 #endif /* CONFIG_QUEUED_SPINLOCKS */
 
+/*
+ * Locking events for optimistic spinning on mutex and rtmutex owners
+ */
+LOCK_EVENT(spin_owner_off_cpu)	/* # of spins stopped, owner not running  */
+LOCK_EVENT(spin_owner_preempt)	/* # of spins stopped, owner preempt due  */
+LOCK_EVENT(spin_owner_steal)	/* # of spins stopped, owner vCPU stolen  */
+LOCK_EVENT(spin_owner_nospin)	/* # of spins not started, preempt due    */
+
 /*
  * Locking events for rwsem
  */
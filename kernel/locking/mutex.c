@@ -35,6 +35,7 @@
 
 #ifndef CONFIG_PREEMPT_RT
 #include "mutex.h"
+#include "owner_spin.h"
 
 #ifdef CONFIG_DEBUG_MUTEXES
 # define MUTEX_WARN_ON(cond) DEBUG_LOCKS_WARN_ON(cond)
@@ -327,6 +328,7 @@ static noinline
 bool mutex_spin_on_owner(struct mutex *lock, struct task_struct *owner,
 			 struct ww_acquire_ctx *ww_ctx, struct mutex_waiter *waiter)
 {
+	struct owner_spin os = { .owner = NULL };
 	bool ret = true;
 
 	lockdep_assert_preemption_disabled();
@@ -342,10 +344,14 @@ bool mutex_spin_on_owner(struct mutex *lock, struct task_struct *owner,
 		 */
 		barrier();
 
+		if (!os.owner)
+			owner_spin_init(&os, owner);
+
 		/*
-		 * Use vcpu_is_preempted to detect lock holder preemption issue.
+		 * Stop when the owner is off CPU, its vCPU is preempted or
+		 * it is about to be preempted, see owner_spin_continue().
 		 */
-		if (!owner_on_cpu(owner) || need_resched()) {
+		if (need_resched() || !owner_spin_continue(&os)) {
 			ret = false;
 			break;
 		}
@@ -381,7 +387,7 @@ static inline int mutex_can_spin_on_owner(struct mutex *lock)
 	 */
 	owner = __mutex_owner(lock);
 	if (owner)
-		retval = owner_on_cpu(owner);
+		retval = owner_spin_worthwhile(owner);
 
 	/*
 	 * If lock->owner is not set, the mutex has been released. Return true
@@ -0,0 +1,88 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef __LOCKING_OWNER_SPIN_H
+#define __LOCKING_OWNER_SPIN_H
+
+#include <linux/sched.h>
+#include "lock_events.h"
+
+#ifdef CONFIG_SMP
+/*
+ * Optimistic spinning on a lock owner only pays off if the owner keeps
+ * running until it releases the lock. On top of owner_on_cpu(), give up
+ * when the scheduler is about to preempt the owner, or when the hypervisor
+ * took time away from the vCPU of the owner since the spinning started:
+ * the owner is then likely to be descheduled again before it is done.
+ *
+ * Those hints live in remote cachelines, so they are only checked every
+ * OWNER_SPIN_CHECK_INTERVAL iterations of the spin loop.
+ */
+#define OWNER_SPIN_CHECK_INTERVAL	64
+#define OWNER_SPIN_STEAL_NS		(10 * NSEC_PER_USEC)
+
+struct owner_spin {
+	struct task_struct	*owner;
+	u64			steal;
+	unsigned int		cpu;
+	unsigned int		loops;
+};
+
+static inline void owner_spin_init(struct owner_spin *os,
+				   struct task_struct *owner)
+{
+	os->owner = owner;
+	os->cpu = task_cpu(owner);
+	os->steal = sched_cpu_steal_clock(os->cpu);
+	os->loops = 0;
+}
+
+/*
+ * Return: true if spinning on the owner should go on. The owner must be
+ * kept from going away, as for owner_on_cpu().
+ */
+static inline bool owner_spin_continue(struct owner_spin *os)
+{
+	struct task_struct *owner = os->owner;
+	unsigned int cpu;
+
+	if (!owner_on_cpu(owner)) {
+		lockevent_inc(spin_owner_off_cpu);
+		return false;
+	}
+
+	if (++os->loops % OWNER_SPIN_CHECK_INTERVAL)
+		return true;
+
+	if (sched_task_preempt_pending(owner)) {
+		lockevent_inc(spin_owner_preempt);
+		return false;
+	}
+
+	cpu = task_cpu(owner);
+	if (cpu != os->cpu) {
+		os->cpu = cpu;
+		os->steal = sched_cpu_steal_clock(cpu);
+	} else if (sched_cpu_steal_clock(cpu) - os->steal >
+		   OWNER_SPIN_STEAL_NS) {
+		lockevent_inc(spin_owner_steal);
+		return false;
+	}
+
+	return true;
+}
+
+/* Whether it is worth starting to spin on @owner at all */
+static inline bool owner_spin_worthwhile(struct task_struct *owner)
+{
+	if (!owner_on_cpu(owner))
+		return false;
+
+	if (sched_task_preempt_pending(owner)) {
+		lockevent_inc(spin_owner_nospin);
+		return false;
+	}
+
+	return true;
+}
+#endif /* CONFIG_SMP */
+
+#endif /* __LOCKING_OWNER_SPIN_H */
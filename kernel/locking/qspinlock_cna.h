@@ -0,0 +1,291 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef _GEN_CNA_LOCK_SLOWPATH
+#error "do not include this file"
+#endif
+
+#include <linux/topology.h>
+#include <linux/moduleparam.h>
+#include <linux/sched/clock.h>
+#include <linux/sched/rt.h>
+
+/*
+ * Implement a NUMA-aware version of MCS (aka CNA, or compact NUMA-aware lock).
+ *
+ * In CNA, spinning threads are organized in two queues, a primary queue for
+ * threads running on the same NUMA node as the current lock holder, and a
+ * secondary queue for threads running on other nodes. Schematically, it
+ * looks like this:
+ *
+ *    cna_node
+ *   +----------+     +--------+         +--------+
+ *   |mcs:next  | --> |mcs:next| --> ... |mcs:next| --> NULL  [Primary queue]
+ *   |mcs:locked| -.  +--------+         +--------+
+ *   +----------+  |
+ *                 `----------------------.
+ *                                        v
+ *                 +--------+         +--------+
+ *                 |mcs:next| --> ... |mcs:next| --> NULL  [Secondary queue]
+ *                 |sec_tail| -.      +--------+
+ *                 +--------+  |          ^
+ *                             `----------'
+ *
+ * The primary queue is the regular MCS queue, ending at the lock tail. The
+ * secondary queue is only known to the queue head: its @mcs.locked holds the
+ * encoded tail of the first secondary waiter (any value > 1, as opposed to 0
+ * or 1 when there is no secondary queue), which itself points to the last
+ * one. Secondary waiters keep spinning on their own @mcs.locked and do not
+ * know that they have been moved.
+ *
+ * While waiting for the lock, the queue head looks for a waiter on its node
+ * in the primary queue and moves the waiters in front of it to the tail of
+ * the secondary queue. When releasing the MCS lock, the secondary queue is
+ * passed over to the successor along with the MCS lock.
+ *
+ * Once the lock has stayed on one node for longer than
+ * numa_spinlock_threshold_ns, or when there is nobody left to pass it to on
+ * that node, the secondary queue is put back in front of the primary one,
+ * which bounds the unfairness towards other nodes. When the primary queue
+ * empties while the secondary queue is not, the latter becomes the primary
+ * queue.
+ *
+ * Waiters in interrupt context and real-time tasks are never moved to the
+ * secondary queue, and receive the lock as if they ran on the node of the
+ * lock holder.
+ */
+
+#define CNA_PRIORITY_NODE	0xffff
+
+struct cna_node {
+	struct mcs_spinlock	mcs;
+	u16			numa_node;
+	u16			real_numa_node;
+	u32			encoded_tail;	/* of this node */
+	union {
+		u64		start_time;	/* primary queue head */
+		struct cna_node	*sec_tail;	/* secondary queue head */
+	};
+};
+
+static ulong numa_spinlock_threshold_ns = 1000000;	/* 1ms */
+module_param(numa_spinlock_threshold_ns, ulong, 0644);
+
+enum {
+	NUMA_LOCKS_OFF,
+	NUMA_LOCKS_ON,
+	NUMA_LOCKS_AUTO,
+};
+static int numa_spinlock_flag __initdata = NUMA_LOCKS_AUTO;
+
+static int __init numa_spinlock_setup(char *str)
+{
+	if (!strcmp(str, "auto"))
+		numa_spinlock_flag = NUMA_LOCKS_AUTO;
+	else if (!strcmp(str, "on"))
+		numa_spinlock_flag = NUMA_LOCKS_ON;
+	else if (!strcmp(str, "off"))
+		numa_spinlock_flag = NUMA_LOCKS_OFF;
+	else
+		return 0;
+
+	return 1;
+}
+__setup("numa_spinlock=", numa_spinlock_setup);
+
+static void __init cna_init_nodes_per_cpu(unsigned int cpu)
+{
+	struct mcs_spinlock *base = per_cpu_ptr(&qnodes[0].mcs, cpu);
+	int numa_node = cpu_to_node(cpu);
+	int i;
+
+	for (i = 0; i < MAX_NODES; i++) {
+		struct cna_node *cn = (struct cna_node *)grab_mcs_node(base, i);
+
+		cn->real_numa_node = numa_node;
+		cn->encoded_tail = encode_tail(cpu, i);
+		/*
+		 * Make sure @encoded_tail can not be confused with the other
+		 * values of @mcs.locked, 0 and 1.
+		 */
+		WARN_ON(cn->encoded_tail <= 1);
+	}
+}
+
+static inline bool cna_threshold_reached(struct cna_node *cn)
+{
+	return local_clock() - cn->start_time > numa_spinlock_threshold_ns;
+}
+
+/* Whether @cn would take the lock on the node of @holder */
+static inline bool cna_is_local(struct cna_node *holder, struct cna_node *cn)
+{
+	return cn->numa_node == CNA_PRIORITY_NODE ||
+	       cn->numa_node == holder->real_numa_node;
+}
+
+static __always_inline void cna_init_node(struct mcs_spinlock *node)
+{
+	struct cna_node *cn = (struct cna_node *)node;
+
+	if (!in_task() || rt_or_dl_task(current))
+		cn->numa_node = CNA_PRIORITY_NODE;
+	else
+		cn->numa_node = cn->real_numa_node;
+	cn->start_time = 0;
+}
+
+/*
+ * cna_splice_tail -- move the waiters @first to @last, which directly follow
+ * the queue head @cn in the primary queue, to the tail of the secondary queue.
+ */
+static void cna_splice_tail(struct cna_node *cn, struct cna_node *first,
+			    struct cna_node *last)
+{
+	/* Remove [first, last] from the primary queue */
+	WRITE_ONCE(cn->mcs.next, last->mcs.next);
+	last->mcs.next = NULL;
+
+	/* And append it to the secondary queue */
+	if (cn->mcs.locked <= 1) {
+		first->sec_tail = last;
+		cn->mcs.locked = first->encoded_tail;
+	} else {
+		struct cna_node *head_2nd;
+
+		head_2nd = (struct cna_node *)decode_tail(cn->mcs.locked);
+		head_2nd->sec_tail->mcs.next = &first->mcs;
+		head_2nd->sec_tail = last;
+	}
+
+	lockevent_inc(lock_cna_move);
+}
+
+/*
+ * cna_order_queue - make the first waiter on the node of the queue head @cn
+ * its successor, if there is one that is fully linked in the primary queue.
+ */
+static void cna_order_queue(struct cna_node *cn)
+{
+	struct cna_node *first = (struct cna_node *)READ_ONCE(cn->mcs.next);
+	struct cna_node *last;
+
+	if (!first || cna_is_local(cn, first))
+		return;
+
+	for (last = first; ; ) {
+		struct cna_node *next = (struct cna_node *)READ_ONCE(last->mcs.next);
+
+		/* The end of the queue, or a waiter still linking itself in */
+		if (!next)
+			return;
+
+		if (cna_is_local(cn, next)) {
+			cna_splice_tail(cn, first, last);
+			return;
+		}
+
+		last = next;
+	}
+}
+
+/* Called by the queue head once it owns the MCS lock */
+static __always_inline u32 cna_wait_head_or_lock(struct qspinlock *lock,
+						 struct mcs_spinlock *node)
+{
+	struct cna_node *cn = (struct cna_node *)node;
+
+	/* Start the stay of the lock on this node, unless inherited */
+	if (!cn->start_time)
+		cn->start_time = local_clock() ?: 1;
+
+	if (cn->numa_node != CNA_PRIORITY_NODE && !cna_threshold_reached(cn))
+		cna_order_queue(cn);
+
+	return 0; /* we did not grab the lock, the caller waits for it */
+}
+
+static __always_inline bool cna_try_clear_tail(struct qspinlock *lock, u32 val,
+					       struct mcs_spinlock *node)
+{
+	struct cna_node *head_2nd, *tail_2nd;
+	u32 new;
+
+	if (node->locked <= 1)
+		return __try_clear_tail(lock, val, node);
+
+	/*
+	 * The primary queue is empty but the secondary one is not: take the
+	 * lock and make the secondary queue the primary one.
+	 */
+	head_2nd = (struct cna_node *)decode_tail(node->locked);
+	tail_2nd = head_2nd->sec_tail;
+	new = tail_2nd->encoded_tail | _Q_LOCKED_VAL;
+	if (!atomic_try_cmpxchg_relaxed(&lock->val, &val, new))
+		return false;
+
+	head_2nd->start_time = 0;
+	arch_mcs_spin_unlock_contended(&head_2nd->mcs.locked);
+	lockevent_inc(lock_cna_splice);
+
+	return true;
+}
+
+static __always_inline void cna_pass_lock(struct mcs_spinlock *node,
+					  struct mcs_spinlock *next)
+{
+	struct cna_node *cn = (struct cna_node *)node;
+	struct cna_node *succ;
+	u32 val = 1;
+
+	/*
+	 * The caller's @next can be stale after cna_order_queue(), but
+	 * reordering only ever leaves a successor behind.
+	 */
+	succ = (struct cna_node *)READ_ONCE(node->next);
+
+	if (node->locked > 1) {
+		struct cna_node *head_2nd;
+
+		head_2nd = (struct cna_node *)decode_tail(node->locked);
+		if (!cna_is_local(cn, succ) || cna_threshold_reached(cn)) {
+			/* Put the secondary queue back in front */
+			head_2nd->sec_tail->mcs.next = &succ->mcs;
+			succ = head_2nd;
+			succ->start_time = 0;
+			lockevent_inc(lock_cna_flush);
+		} else {
+			/* Stay on this node, along with the secondary queue */
+			val = node->locked;
+			succ->start_time = cn->start_time;
+			lockevent_inc(lock_cna_local);
+		}
+	} else {
+		succ->start_time = cna_is_local(cn, succ) ? cn->start_time : 0;
+	}
+
+	smp_store_release(&succ->mcs.locked, val);
+}
+
+/*
+ * Switch to the NUMA-friendly slow path for spinlocks when we have
+ * multiple NUMA nodes in native environment, unless the user has
+ * overridden this default behavior by setting the numa_spinlock flag.
+ */
+void __init cna_configure_spin_lock_slowpath(void)
+{
+	unsigned int cpu;
+
+	BUILD_BUG_ON(sizeof(struct cna_node) > sizeof(struct qnode));
+
+	if (numa_spinlock_flag == NUMA_LOCKS_OFF ||
+	    (numa_spinlock_flag == NUMA_LOCKS_AUTO && nr_node_ids == 1) ||
+	    pv_ops.lock.queued_spin_lock_slowpath !=
+			native_queued_spin_lock_slowpath)
+		return;
+
+	for_each_possible_cpu(cpu)
+		cna_init_nodes_per_cpu(cpu);
+
+	pv_ops.lock.queued_spin_lock_slowpath = __cna_queued_spin_lock_slowpath;
+
+	pr_info("Enabling CNA spinlock\n");
+}
@@ -27,6 +27,7 @@
 #include <trace/events/lock.h>
 
 #include "rtmutex_common.h"
+#include "owner_spin.h"
 
 #ifndef WW_RT
 # define build_ww_mutex()	(false)
@@ -1481,6 +1482,7 @@ static bool rtmutex_spin_on_owner(struct rt_mutex_base *lock,
 				  struct rt_mutex_waiter *waiter,
 				  struct task_struct *owner)
 {
+	struct owner_spin os = { .owner = NULL };
 	bool res = true;
 
 	rcu_read_lock();
@@ -1495,15 +1497,19 @@ static bool rtmutex_spin_on_owner(struct rt_mutex_base *lock,
 		 * the rcu_read_lock() ensures the memory stays valid.
 		 */
 		barrier();
+		if (!os.owner)
+			owner_spin_init(&os, owner);
 		/*
 		 * Stop spinning when:
 		 *  - the lock owner has been scheduled out
 		 *  - current is not longer the top waiter
 		 *  - current is requested to reschedule (redundant
 		 *    for CONFIG_PREEMPT_RCU=y)
-		 *  - the VCPU on which owner runs is preempted
+		 *  - the VCPU on which owner runs is preempted, or has been
+		 *    for a while since we started spinning
+		 *  - the lock owner is about to be preempted
 		 */
-		if (!owner_on_cpu(owner) || need_resched() ||
+		if (need_resched() || !owner_spin_continue(&os) ||
 		    !rt_mutex_waiter_is_top_waiter(lock, waiter)) {
 			res = false;
 			break;
@@ -27,6 +27,9 @@
 #include <linux/export.h>
 #include <linux/rwsem.h>
 #include <linux/atomic.h>
+#include <linux/percpu.h>
+#include <linux/rcuwait.h>
+#include <linux/slab.h>
 #include <trace/events/lock.h>
 
 #ifndef CONFIG_PREEMPT_RT
@@ -325,6 +328,9 @@ void __init_rwsem(struct rw_semaphore *sem, const char *name,
 #ifdef CONFIG_RWSEM_SPIN_ON_OWNER
 	osq_lock_init(&sem->osq);
 #endif
+#ifdef CONFIG_RWSEM_PERCPU_READERS
+	sem->pcpu = NULL;
+#endif
 }
 EXPORT_SYMBOL(__init_rwsem);
 
@@ -1256,22 +1262,7 @@ static __always_inline int __down_read_common(struct rw_semaphore *sem, int stat
 	return ret;
 }
 
-static __always_inline void __down_read(struct rw_semaphore *sem)
-{
-	__down_read_common(sem, TASK_UNINTERRUPTIBLE);
-}
-
-static __always_inline int __down_read_interruptible(struct rw_semaphore *sem)
-{
-	return __down_read_common(sem, TASK_INTERRUPTIBLE);
-}
-
-static __always_inline int __down_read_killable(struct rw_semaphore *sem)
-{
-	return __down_read_common(sem, TASK_KILLABLE);
-}
-
-static inline int __down_read_trylock(struct rw_semaphore *sem)
+static inline int __down_read_trylock_common(struct rw_semaphore *sem)
 {
 	int ret = 0;
 	long tmp;
@@ -1308,17 +1299,7 @@ static __always_inline int __down_write_common(struct rw_semaphore *sem, int sta
 	return ret;
 }
 
-static __always_inline void __down_write(struct rw_semaphore *sem)
-{
-	__down_write_common(sem, TASK_UNINTERRUPTIBLE);
-}
-
-static __always_inline int __down_write_killable(struct rw_semaphore *sem)
-{
-	return __down_write_common(sem, TASK_KILLABLE);
-}
-
-static inline int __down_write_trylock(struct rw_semaphore *sem)
+static inline int __down_write_trylock_common(struct rw_semaphore *sem)
 {
 	int ret;
 
@@ -1333,7 +1314,7 @@ static inline int __down_write_trylock(struct rw_semaphore *sem)
 /*
  * unlock after reading
  */
-static inline void __up_read(struct rw_semaphore *sem)
+static inline void __up_read_common(struct rw_semaphore *sem)
 {
 	long tmp;
 
@@ -1355,7 +1336,7 @@ static inline void __up_read(struct rw_semaphore *sem)
 /*
  * unlock after writing
  */
-static inline void __up_write(struct rw_semaphore *sem)
+static inline void __up_write_common(struct rw_semaphore *sem)
 {
 	long tmp;
 
@@ -1378,7 +1359,7 @@ static inline void __up_write(struct rw_semaphore *sem)
 /*
  * downgrade write lock to read lock
  */
-static inline void __downgrade_write(struct rw_semaphore *sem)
+static inline void __downgrade_write_common(struct rw_semaphore *sem)
 {
 	long tmp;
 
@@ -1399,6 +1380,448 @@ static inline void __downgrade_write(struct rw_semaphore *sem)
 	preempt_enable();
 }
 
+#ifdef CONFIG_RWSEM_PERCPU_READERS
+/*
+ * Per-CPU reader counts.
+ *
+ * An rwsem that opted in with rwsem_enable_percpu_readers() counts its
+ * readers in per-CPU counters rather than in sem->count, so readers running
+ * on different CPUs do not write to a shared cacheline. sem->count is still
+ * used by writers to exclude each other, and by readers to wait for them.
+ *
+ * A writer first write-locks sem->count, then flags itself in pc->state and
+ * waits for the sum of the per-CPU counters to drop to zero. A reader
+ * increments its counter and then checks pc->state; both sides have a full
+ * barrier in between, so either the reader sees the writer and backs out,
+ * or the writer sees the reader and waits for it. Readers that back out
+ * read-lock sem->count, which makes them wait for the writer, and then swap
+ * that for a per-CPU count again.
+ *
+ * When writers come often, summing up the counters of all CPUs becomes more
+ * expensive than sharing the count word, and the rwsem falls back to plain
+ * sem->count reader counting (RWSEM_PCPU_CENTRAL) until a writer comes after
+ * a quiet period. pc->state only ever changes with sem->count write-locked,
+ * so it is stable for as long as a reader holds the lock in either mode.
+ */
+enum {
+	RWSEM_PCPU_READERS,	/* readers use the per-CPU counters */
+	RWSEM_PCPU_WRITER,	/* a writer owns or waits for the lock */
+	RWSEM_PCPU_CENTRAL,	/* readers use sem->count */
+};
+
+/* Writes closer than this to each other count as frequent */
+#define RWSEM_PCPU_WRITE_GAP		max(HZ / 100, 1)
+/* Number of frequent writes in a row that switch to sem->count */
+#define RWSEM_PCPU_WRITE_STREAK		8
+/* Idle time after which a writer switches back to per-CPU counts */
+#define RWSEM_PCPU_QUIET		HZ
+
+struct rwsem_pcpu {
+	unsigned int __percpu	*read_count;
+	struct rcuwait		writer;
+	int			state;
+	/* writer side only, serialized by sem->count */
+	int			next_state;
+	unsigned int		write_streak;
+	unsigned long		last_write;
+};
+
+static inline struct rwsem_pcpu *rwsem_pcpu(const struct rw_semaphore *sem)
+{
+	return sem->pcpu;
+}
+
+static bool rwsem_pcpu_readers_done(struct rwsem_pcpu *pc)
+{
+	unsigned int sum = 0;
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		sum += *per_cpu_ptr(pc->read_count, cpu);
+
+	return !sum;
+}
+
+static inline bool rwsem_pcpu_read_trylock(struct rwsem_pcpu *pc)
+{
+	this_cpu_inc(*pc->read_count);
+
+	/* Pairs with the barrier in rwsem_pcpu_writer_drain() */
+	smp_mb();
+
+	if (likely(READ_ONCE(pc->state) == RWSEM_PCPU_READERS))
+		return true;
+
+	this_cpu_dec(*pc->read_count);
+	rcuwait_wake_up(&pc->writer);
+	return false;
+}
+
+/*
+ * Called with sem->count read-locked, which keeps pc->state stable: keep it
+ * in central mode, otherwise trade it for a per-CPU count.
+ */
+static inline void rwsem_pcpu_read_switch(struct rw_semaphore *sem,
+					  struct rwsem_pcpu *pc)
+{
+	if (READ_ONCE(pc->state) == RWSEM_PCPU_CENTRAL)
+		return;
+
+	this_cpu_inc(*pc->read_count);
+	__up_read_common(sem);
+}
+
+static int rwsem_pcpu_down_read(struct rw_semaphore *sem,
+				struct rwsem_pcpu *pc, int state)
+{
+	int ret;
+
+	if (READ_ONCE(pc->state) == RWSEM_PCPU_READERS &&
+	    rwsem_pcpu_read_trylock(pc))
+		return 0;
+
+	ret = __down_read_common(sem, state);
+	if (!ret)
+		rwsem_pcpu_read_switch(sem, pc);
+
+	return ret;
+}
+
+static int rwsem_pcpu_down_read_trylock(struct rw_semaphore *sem,
+					struct rwsem_pcpu *pc)
+{
+	if (READ_ONCE(pc->state) == RWSEM_PCPU_READERS &&
+	    rwsem_pcpu_read_trylock(pc))
+		return 1;
+
+	if (!__down_read_trylock_common(sem))
+		return 0;
+
+	rwsem_pcpu_read_switch(sem, pc);
+	return 1;
+}
+
+static void rwsem_pcpu_up_read(struct rw_semaphore *sem, struct rwsem_pcpu *pc)
+{
+	if (READ_ONCE(pc->state) == RWSEM_PCPU_CENTRAL) {
+		__up_read_common(sem);
+		return;
+	}
+
+	/* Order the critical section before the decrement */
+	smp_mb();
+	this_cpu_dec(*pc->read_count);
+	/* Has the barrier pairing with the writer's set_current_state() */
+	rcuwait_wake_up(&pc->writer);
+}
+
+/* Pick the reader mode to leave behind, with sem->count write-locked */
+static void rwsem_pcpu_writer_account(struct rwsem_pcpu *pc)
+{
+	unsigned long now = jiffies;
+
+	if (time_before(now, pc->last_write + RWSEM_PCPU_WRITE_GAP)) {
+		if (pc->write_streak < RWSEM_PCPU_WRITE_STREAK)
+			pc->write_streak++;
+	} else {
+		pc->write_streak = 0;
+	}
+
+	if (pc->write_streak >= RWSEM_PCPU_WRITE_STREAK)
+		pc->next_state = RWSEM_PCPU_CENTRAL;
+	else if (pc->state != RWSEM_PCPU_CENTRAL ||
+		 time_after_eq(now, pc->last_write + RWSEM_PCPU_QUIET))
+		pc->next_state = RWSEM_PCPU_READERS;
+
+	pc->last_write = now;
+}
+
+/* Wait for the per-CPU readers, with sem->count write-locked */
+static int rwsem_pcpu_writer_drain(struct rwsem_pcpu *pc, int state)
+{
+	int ret;
+
+	if (pc->state == RWSEM_PCPU_CENTRAL)
+		return 0;
+
+	WRITE_ONCE(pc->state, RWSEM_PCPU_WRITER);
+	/* Pairs with the barrier in rwsem_pcpu_read_trylock() */
+	smp_mb();
+
+	ret = rcuwait_wait_event(&pc->writer, rwsem_pcpu_readers_done(pc),
+				 state);
+	if (ret)
+		return ret;
+
+	/* Order the readers' critical sections before ours */
+	smp_mb();
+	return 0;
+}
+
+static int rwsem_pcpu_down_write(struct rw_semaphore *sem,
+				 struct rwsem_pcpu *pc, int state)
+{
+	int ret;
+
+	ret = __down_write_common(sem, state);
+	if (ret)
+		return ret;
+
+	rwsem_pcpu_writer_account(pc);
+	ret = rwsem_pcpu_writer_drain(pc, state);
+	if (ret) {
+		smp_store_release(&pc->state, RWSEM_PCPU_READERS);
+		__up_write_common(sem);
+	}
+
+	return ret;
+}
+
+static int rwsem_pcpu_down_write_trylock(struct rw_semaphore *sem,
+					 struct rwsem_pcpu *pc)
+{
+	if (!__down_write_trylock_common(sem))
+		return 0;
+
+	if (pc->state == RWSEM_PCPU_CENTRAL) {
+		rwsem_pcpu_writer_account(pc);
+		return 1;
+	}
+
+	WRITE_ONCE(pc->state, RWSEM_PCPU_WRITER);
+	smp_mb();
+	if (!rwsem_pcpu_readers_done(pc)) {
+		smp_store_release(&pc->state, RWSEM_PCPU_READERS);
+		__up_write_common(sem);
+		return 0;
+	}
+	smp_mb();
+
+	rwsem_pcpu_writer_account(pc);
+	return 1;
+}
+
+static void rwsem_pcpu_up_write(struct rw_semaphore *sem, struct rwsem_pcpu *pc)
+{
+	/* Readers waiting on sem->count find the new state once they get it */
+	smp_store_release(&pc->state, pc->next_state);
+	__up_write_common(sem);
+}
+
+static void rwsem_pcpu_downgrade_write(struct rw_semaphore *sem,
+				       struct rwsem_pcpu *pc)
+{
+	if (pc->next_state == RWSEM_PCPU_CENTRAL) {
+		WRITE_ONCE(pc->state, RWSEM_PCPU_CENTRAL);
+		__downgrade_write_common(sem);
+		return;
+	}
+
+	/* Hold a per-CPU count before letting other readers in */
+	this_cpu_inc(*pc->read_count);
+	smp_store_release(&pc->state, RWSEM_PCPU_READERS);
+	__up_write_common(sem);
+}
+
+/**
+ * rwsem_enable_percpu_readers - count the readers of an rwsem per CPU
+ * @sem: the rwsem, initialized and neither locked nor used concurrently
+ *
+ * Meant for read-mostly rwsems whose readers run on many CPUs at once: they
+ * no longer share a cacheline, at the cost of writers having to look at the
+ * counters of all CPUs. The rwsem automatically falls back to shared reader
+ * counting while writers are frequent. rwsem_free_percpu_readers() must be
+ * called before the rwsem is freed.
+ *
+ * Return: 0 on success, -ENOMEM if the counters could not be allocated, in
+ * which case the rwsem keeps working as usual.
+ */
+int rwsem_enable_percpu_readers(struct rw_semaphore *sem)
+{
+	struct rwsem_pcpu *pc;
+
+	if (WARN_ON_ONCE(sem->pcpu || rwsem_is_locked(sem)))
+		return -EBUSY;
+
+	pc = kzalloc(sizeof(*pc), GFP_KERNEL);
+	if (!pc)
+		return -ENOMEM;
+
+	pc->read_count = alloc_percpu(unsigned int);
+	if (!pc->read_count) {
+		kfree(pc);
+		return -ENOMEM;
+	}
+
+	rcuwait_init(&pc->writer);
+	pc->state = RWSEM_PCPU_READERS;
+	pc->next_state = RWSEM_PCPU_READERS;
+	pc->last_write = jiffies - RWSEM_PCPU_QUIET;
+	sem->pcpu = pc;
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(rwsem_enable_percpu_readers);
+
+/**
+ * rwsem_free_percpu_readers - free the per-CPU reader counts of an rwsem
+ * @sem: the rwsem, unlocked and no longer used
+ */
+void rwsem_free_percpu_readers(struct rw_semaphore *sem)
+{
+	struct rwsem_pcpu *pc = sem->pcpu;
+
+	if (!pc)
+		return;
+
+	WARN_ON_ONCE(!rwsem_pcpu_readers_done(pc));
+	sem->pcpu = NULL;
+	free_percpu(pc->read_count);
+	kfree(pc);
+}
+EXPORT_SYMBOL_GPL(rwsem_free_percpu_readers);
+
+/* For lock assertions: whether readers hold the rwsem through counters */
+bool rwsem_percpu_read_locked(const struct rw_semaphore *sem)
+{
+	struct rwsem_pcpu *pc = rwsem_pcpu(sem);
+
+	return pc && !rwsem_pcpu_readers_done(pc);
+}
+EXPORT_SYMBOL_GPL(rwsem_percpu_read_locked);
+
+#else /* !CONFIG_RWSEM_PERCPU_READERS */
+static inline struct rwsem_pcpu *rwsem_pcpu(const struct rw_semaphore *sem)
+{
+	return NULL;
+}
+
+/* Never called, rwsem_pcpu() always returns NULL */
+static inline int rwsem_pcpu_down_read(struct rw_semaphore *sem,
+				       struct rwsem_pcpu *pc, int state)
+{
+	return 0;
+}
+static inline int rwsem_pcpu_down_read_trylock(struct rw_semaphore *sem,
+					       struct rwsem_pcpu *pc)
+{
+	return 0;
+}
+static inline void rwsem_pcpu_up_read(struct rw_semaphore *sem,
+				      struct rwsem_pcpu *pc) { }
+static inline int rwsem_pcpu_down_write(struct rw_semaphore *sem,
+					struct rwsem_pcpu *pc, int state)
+{
+	return 0;
+}
+static inline int rwsem_pcpu_down_write_trylock(struct rw_semaphore *sem,
+						struct rwsem_pcpu *pc)
+{
+	return 0;
+}
+static inline void rwsem_pcpu_up_write(struct rw_semaphore *sem,
+				       struct rwsem_pcpu *pc) { }
+static inline void rwsem_pcpu_downgrade_write(struct rw_semaphore *sem,
+					      struct rwsem_pcpu *pc) { }
+#endif /* CONFIG_RWSEM_PERCPU_READERS */
+
+static __always_inline int __down_read_state(struct rw_semaphore *sem,
+					     int state)
+{
+	struct rwsem_pcpu *pc = rwsem_pcpu(sem);
+
+	if (pc)
+		return rwsem_pcpu_down_read(sem, pc, state);
+
+	return __down_read_common(sem, state);
+}
+
+static __always_inline void __down_read(struct rw_semaphore *sem)
+{
+	__down_read_state(sem, TASK_UNINTERRUPTIBLE);
+}
+
+static __always_inline int __down_read_interruptible(struct rw_semaphore *sem)
+{
+	return __down_read_state(sem, TASK_INTERRUPTIBLE);
+}
+
+static __always_inline int __down_read_killable(struct rw_semaphore *sem)
+{
+	return __down_read_state(sem, TASK_KILLABLE);
+}
+
+static inline int __down_read_trylock(struct rw_semaphore *sem)
+{
+	struct rwsem_pcpu *pc = rwsem_pcpu(sem);
+
+	if (pc)
+		return rwsem_pcpu_down_read_trylock(sem, pc);
+
+	return __down_read_trylock_common(sem);
+}
+
+static __always_inline int __down_write_state(struct rw_semaphore *sem,
+					      int state)
+{
+	struct rwsem_pcpu *pc = rwsem_pcpu(sem);
+
+	if (pc)
+		return rwsem_pcpu_down_write(sem, pc, state);
+
+	return __down_write_common(sem, state);
+}
+
+static __always_inline void __down_write(struct rw_semaphore *sem)
+{
+	__down_write_state(sem, TASK_UNINTERRUPTIBLE);
+}
+
+static __always_inline int __down_write_killable(struct rw_semaphore *sem)
+{
+	return __down_write_state(sem, TASK_KILLABLE);
+}
+
+static inline int __down_write_trylock(struct rw_semaphore *sem)
+{
+	struct rwsem_pcpu *pc = rwsem_pcpu(sem);
+
+	if (pc)
+		return rwsem_pcpu_down_write_trylock(sem, pc);
+
+	return __down_write_trylock_common(sem);
+}
+
+static inline void __up_read(struct rw_semaphore *sem)
+{
+	struct rwsem_pcpu *pc = rwsem_pcpu(sem);
+
+	if (pc)
+		rwsem_pcpu_up_read(sem, pc);
+	else
+		__up_read_common(sem);
+}
+
+static inline void __up_write(struct rw_semaphore *sem)
+{
+	struct rwsem_pcpu *pc = rwsem_pcpu(sem);
+
+	if (pc)
+		rwsem_pcpu_up_write(sem, pc);
+	else
+		__up_write_common(sem);
+}
+
+static inline void __downgrade_write(struct rw_semaphore *sem)
+{
+	struct rwsem_pcpu *pc = rwsem_pcpu(sem);
+
+	if (pc)
+		rwsem_pcpu_downgrade_write(sem, pc);
+	else
+		__downgrade_write_common(sem);
+}
+
 #else /* !CONFIG_PREEMPT_RT */
 
 #define RT_MUTEX_BUILD_MUTEX
@@ -53,6 +53,8 @@
 #include <linux/jump_label.h>
 #include <linux/pfn.h>
 #include <linux/bsearch.h>
+#include <linux/hashtable.h>
+#include <linux/stringhash.h>
 #include <linux/dynamic_debug.h>
 #include <linux/audit.h>
 #include <linux/cfi.h>
@@ -329,6 +331,107 @@ static bool find_exported_symbol_in_section(const struct symsearch *syms,
 	return true;
 }
 
+/*
+ * Symbols exported by modules, hashed by name, so that resolving them does
+ * not have to search the tables of every loaded module in turn. vmlinux's
+ * own tables stay out of it: they are few, sorted at build time and never
+ * change. Entries are added under module_mutex and looked up under it or
+ * with preemption disabled, like the module list.
+ */
+#define MODULE_EXPORT_HASH_BITS	12
+
+struct module_export {
+	struct hlist_node node;
+	struct module *owner;
+	const struct kernel_symbol *sym;
+	const u32 *crc;
+	u32 hash;
+	enum mod_license license;
+};
+
+static DEFINE_HASHTABLE(module_export_hash, MODULE_EXPORT_HASH_BITS);
+
+static u32 module_export_hashfn(const char *name)
+{
+	return full_name_hash(NULL, name, strlen(name));
+}
+
+static bool find_module_export(struct find_symbol_arg *fsa)
+{
+	u32 hash = module_export_hashfn(fsa->name);
+	struct module_export *e;
+
+	hash_for_each_possible_rcu(module_export_hash, e, node, hash,
+				   lockdep_is_held(&module_mutex)) {
+		if (e->hash != hash || strcmp(kernel_symbol_name(e->sym), fsa->name))
+			continue;
+		if (e->owner->state == MODULE_STATE_UNFORMED)
+			continue;
+		if (!fsa->gplok && e->license == GPL_ONLY)
+			continue;
+
+		fsa->owner = e->owner;
+		fsa->crc = e->crc;
+		fsa->sym = e->sym;
+		fsa->license = e->license;
+		return true;
+	}
+	return false;
+}
+
+/* Must hold module_mutex. */
+static int module_export_hash_add(struct module *mod)
+{
+	unsigned int n = mod->num_syms + mod->num_gpl_syms;
+	struct module_export *e;
+	unsigned int i;
+
+	if (!n)
+		return 0;
+
+	e = kvcalloc(n, sizeof(*e), GFP_KERNEL);
+	if (!e)
+		return -ENOMEM;
+	mod->exports = e;
+
+	for (i = 0; i < n; i++, e++) {
+		bool gpl = i >= mod->num_syms;
+		unsigned int idx = gpl ? i - mod->num_syms : i;
+
+		e->owner = mod;
+		if (gpl) {
+			e->sym = &mod->gpl_syms[idx];
+			e->crc = symversion(mod->gpl_crcs, idx);
+			e->license = GPL_ONLY;
+		} else {
+			e->sym = &mod->syms[idx];
+			e->crc = symversion(mod->crcs, idx);
+			e->license = NOT_GPL_ONLY;
+		}
+		e->hash = module_export_hashfn(kernel_symbol_name(e->sym));
+		hash_add_rcu(module_export_hash, &e->node, e->hash);
+	}
+	return 0;
+}
+
+/* Must hold module_mutex; free with module_export_hash_free() after RCU. */
+static void module_export_hash_del(struct module *mod)
+{
+	unsigned int i;
+
+	if (!mod->exports)
+		return;
+
+	for (i = 0; i < mod->num_syms + mod->num_gpl_syms; i++)
+		hash_del_rcu(&mod->exports[i].node);
+}
+
+static void module_export_hash_free(struct module *mod)
+{
+	kvfree(mod->exports);
+	mod->exports = NULL;
+}
+
 /*
  * Find an exported symbol and return it, along with, (optional) crc and
  * (optional) module which owns it.  Needs preempt disabled or module_mutex.
@@ -342,7 +445,6 @@ bool find_symbol(struct find_symbol_arg *fsa)
 		  __start___kcrctab_gpl,
 		  GPL_ONLY },
 	};
-	struct module *mod;
 	unsigned int i;
 
 	module_assert_mutex_or_preempt();
@@ -351,23 +453,8 @@ bool find_symbol(struct find_symbol_arg *fsa)
 		if (find_exported_symbol_in_section(&arr[i], NULL, fsa))
 			return true;
 
-	list_for_each_entry_rcu(mod, &modules, list,
-				lockdep_is_held(&module_mutex)) {
-		struct symsearch arr[] = {
-			{ mod->syms, mod->syms + mod->num_syms, mod->crcs,
-			  NOT_GPL_ONLY },
-			{ mod->gpl_syms, mod->gpl_syms + mod->num_gpl_syms,
-			  mod->gpl_crcs,
-			  GPL_ONLY },
-		};
-
-		if (mod->state == MODULE_STATE_UNFORMED)
-			continue;
-
-		for (i = 0; i < ARRAY_SIZE(arr); i++)
-			if (find_exported_symbol_in_section(&arr[i], mod, fsa))
-				return true;
-	}
+	if (find_module_export(fsa))
+		return true;
 
 	pr_debug("Failed to find symbol %s\n", fsa->name);
 	return false;
@@ -1139,6 +1226,34 @@ static bool inherit_taint(struct module *mod, struct module *owner, const char *
 	return true;
 }
 
+/* Check that @mod may use the symbol found in @fsa and take a reference. */
+static const struct kernel_symbol *use_symbol(struct module *mod,
+					      const struct load_info *info,
+					      const char *name,
+					      struct find_symbol_arg *fsa)
+{
+	int err;
+
+	if (fsa->license == GPL_ONLY)
+		mod->using_gplonly_symbols = true;
+
+	if (!inherit_taint(mod, fsa->owner, name))
+		return NULL;
+
+	if (!check_version(info, name, mod, fsa->crc))
+		return ERR_PTR(-EINVAL);
+
+	err = verify_namespace_is_imported(info, fsa->sym, mod);
+	if (err)
+		return ERR_PTR(err);
+
+	err = ref_module(mod, fsa->owner);
+	if (err)
+		return ERR_PTR(err);
+
+	return fsa->sym;
+}
+
 /* Resolve a symbol for this module.  I.e. if we find one, record usage. */
 static const struct kernel_symbol *resolve_symbol(struct module *mod,
 						  const struct load_info *info,
@@ -1150,7 +1265,22 @@ static const struct kernel_symbol *resolve_symbol(struct module *mod,
 		.gplok	= !(mod->taints & (1 << TAINT_PROPRIETARY_MODULE)),
 		.warn	= true,
 	};
-	int err;
+	const struct kernel_symbol *sym = NULL;
+	bool found;
+
+	/*
+	 * Symbols exported by vmlinux never go away and need no reference,
+	 * so resolve those without module_mutex: modules loading in parallel
+	 * would otherwise take turns on it for each undefined symbol.
+	 */
+	preempt_disable();
+	found = find_symbol(&fsa);
+	preempt_enable();
+	if (found && !fsa.owner) {
+		sym = use_symbol(mod, info, name, &fsa);
+		strncpy(ownername, module_name(NULL), MODULE_NAME_LEN);
+		return sym;
+	}
 
 	/*
 	 * The module_mutex should not be a heavily contended lock;
@@ -1159,40 +1289,13 @@ static const struct kernel_symbol *resolve_symbol(struct module *mod,
 	 */
 	sched_annotate_sleep();
 	mutex_lock(&module_mutex);
-	if (!find_symbol(&fsa))
-		goto unlock;
-
-	if (fsa.license == GPL_ONLY)
-		mod->using_gplonly_symbols = true;
-
-	if (!inherit_taint(mod, fsa.owner, name)) {
-		fsa.sym = NULL;
-		goto getname;
+	if (find_symbol(&fsa)) {
+		sym = use_symbol(mod, info, name, &fsa);
+		/* We must make copy under the lock if we failed to get ref. */
+		strncpy(ownername, module_name(fsa.owner), MODULE_NAME_LEN);
 	}
-
-	if (!check_version(info, name, mod, fsa.crc)) {
-		fsa.sym = ERR_PTR(-EINVAL);
-		goto getname;
-	}
-
-	err = verify_namespace_is_imported(info, fsa.sym, mod);
-	if (err) {
-		fsa.sym = ERR_PTR(err);
-		goto getname;
-	}
-
-	err = ref_module(mod, fsa.owner);
-	if (err) {
-		fsa.sym = ERR_PTR(err);
-		goto getname;
-	}
-
-getname:
-	/* We must make copy under the lock if we failed to get ref. */
-	strncpy(ownername, module_name(fsa.owner), MODULE_NAME_LEN);
-unlock:
 	mutex_unlock(&module_mutex);
-	return fsa.sym;
+	return sym;
 }
 
 static const struct kernel_symbol *
@@ -1346,10 +1449,12 @@ static void free_module(struct module *mod)
 	/* Unlink carefully: kallsyms could be walking list. */
 	list_del_rcu(&mod->list);
 	mod_tree_remove(mod);
+	module_export_hash_del(mod);
 	/* Remove this module from bug list, this uses list_del_rcu */
 	module_bug_cleanup(mod);
 	/* Wait for RCU-sched synchronizing before releasing mod->list and buglist. */
 	synchronize_rcu();
+	module_export_hash_free(mod);
 	if (try_add_tainted_module(mod))
 		pr_err("%s: adding tainted module to the unloaded tainted modules list failed.\n",
 		       mod->name);
@@ -3196,6 +3301,10 @@ static int complete_formation(struct module *mod, struct load_info *info)
 	if (err < 0)
 		goto out;
 
+	err = module_export_hash_add(mod);
+	if (err)
+		goto out;
+
 	/* These rely on module_mutex for list integrity. */
 	module_bug_finalize(info->hdr, info->sechdrs, mod);
 	module_cfi_finalize(info->hdr, info->sechdrs, mod);
@@ -3487,9 +3596,11 @@ static int load_module(struct load_info *info, const char __user *uargs,
 	/* Unlink carefully: kallsyms could be walking list. */
 	list_del_rcu(&mod->list);
 	mod_tree_remove(mod);
+	module_export_hash_del(mod);
 	wake_up_all(&module_wq);
 	/* Wait for RCU-sched synchronizing before releasing mod->list. */
 	synchronize_rcu();
+	module_export_hash_free(mod);
 	mutex_unlock(&module_mutex);
  free_module:
 	mod_stat_bump_invalid(info, flags);
@@ -534,12 +534,39 @@ static int swap_writer_finish(struct swap_map_handle *handle,
 #define CMP_SIZE	(CMP_PAGES * PAGE_SIZE)
 
 /* Maximum number of threads for compression/decompression. */
-#define CMP_THREADS	3
+#define CMP_MAX_THREADS	64
 
 /* Minimum/maximum number of pages for read buffering. */
 #define CMP_MIN_RD_PAGES	1024
 #define CMP_MAX_RD_PAGES	8192
 
+/* Compressed blocks read ahead per decompression thread, at most. */
+#define CMP_RD_BLOCKS_PER_THREAD	64
+
+/*
+ * Number of compression/decompression threads, 0 to use one per online
+ * CPU besides the one doing the I/O. The image format does not depend on
+ * it, so an image can be resumed with any number of threads.
+ */
+static unsigned int hibernate_compression_threads;
+
+static int __init hibernate_compression_threads_setup(char *str)
+{
+	if (kstrtouint(str, 0, &hibernate_compression_threads))
+		pr_warn("hibernate_compression_threads: bad value '%s'\n", str);
+	return 1;
+}
+__setup("hibernate_compression_threads=", hibernate_compression_threads_setup);
+
+static unsigned int cmp_nr_threads(void)
+{
+	unsigned int nr = hibernate_compression_threads;
+
+	if (!nr)
+		nr = num_online_cpus() - 1;
+	return clamp_val(nr, 1, CMP_MAX_THREADS);
+}
+
 /**
  *	save_image - save the suspend image data
  */
@@ -599,10 +626,39 @@ struct crc_data {
 	wait_queue_head_t go;                     /* start crc update */
 	wait_queue_head_t done;                   /* crc update done */
 	u32 *crc32;                               /* points to handle's crc32 */
-	size_t *unc_len[CMP_THREADS];             /* uncompressed lengths */
-	unsigned char *unc[CMP_THREADS];          /* uncompressed data */
+	size_t **unc_len;                         /* uncompressed lengths */
+	unsigned char **unc;                      /* uncompressed data */
 };
 
+static void free_crc_data(struct crc_data *crc)
+{
+	if (!crc)
+		return;
+
+	if (crc->thr)
+		kthread_stop(crc->thr);
+	kfree(crc->unc_len);
+	kfree(crc->unc);
+	kfree(crc);
+}
+
+static struct crc_data *alloc_crc_data(unsigned int nr_threads)
+{
+	struct crc_data *crc;
+
+	crc = kzalloc(sizeof(*crc), GFP_KERNEL);
+	if (!crc)
+		return NULL;
+
+	crc->unc_len = kcalloc(nr_threads, sizeof(*crc->unc_len), GFP_KERNEL);
+	crc->unc = kcalloc(nr_threads, sizeof(*crc->unc), GFP_KERNEL);
+	if (!crc->unc_len || !crc->unc) {
+		free_crc_data(crc);
+		return NULL;
+	}
+	return crc;
+}
+
 /*
  * CRC32 update function that runs in its own thread.
  */
@@ -711,11 +767,10 @@ static int save_compressed_image(struct swap_map_handle *handle,
 	atomic_set(&compressed_size, 0);
 
 	/*
-	 * We'll limit the number of threads for compression to limit memory
-	 * footprint.
+	 * Each thread needs its own buffers, hence the upper limit of threads
+	 * to bound the memory footprint.
 	 */
-	nr_threads = num_online_cpus() - 1;
-	nr_threads = clamp_val(nr_threads, 1, CMP_THREADS);
+	nr_threads = cmp_nr_threads();
 
 	page = (void *)__get_free_page(GFP_NOIO | __GFP_HIGH);
 	if (!page) {
@@ -731,7 +786,7 @@ static int save_compressed_image(struct swap_map_handle *handle,
 		goto out_clean;
 	}
 
-	crc = kzalloc(sizeof(*crc), GFP_KERNEL);
+	crc = alloc_crc_data(nr_threads);
 	if (!crc) {
 		pr_err("Failed to allocate crc\n");
 		ret = -ENOMEM;
@@ -890,11 +945,7 @@ static int save_compressed_image(struct swap_map_handle *handle,
 
 out_clean:
 	hib_finish_batch(&hb);
-	if (crc) {
-		if (crc->thr)
-			kthread_stop(crc->thr);
-		kfree(crc);
-	}
+	free_crc_data(crc);
 	if (data) {
 		for (thr = 0; thr < nr_threads; thr++) {
 			if (data[thr].thr)
@@ -1210,7 +1261,7 @@ static int load_compressed_image(struct swap_map_handle *handle,
 	unsigned i, thr, run_threads, nr_threads;
 	unsigned ring = 0, pg = 0, ring_size = 0,
 	         have = 0, want, need, asked = 0;
-	unsigned long read_pages = 0;
+	unsigned long read_pages = 0, max_rd_pages;
 	unsigned char **page = NULL;
 	struct dec_data *data = NULL;
 	struct crc_data *crc = NULL;
@@ -1218,13 +1269,19 @@ static int load_compressed_image(struct swap_map_handle *handle,
 	hib_init_batch(&hb);
 
 	/*
-	 * We'll limit the number of threads for decompression to limit memory
-	 * footprint.
+	 * Each thread needs its own buffers, hence the upper limit of threads
+	 * to bound the memory footprint.
 	 */
-	nr_threads = num_online_cpus() - 1;
-	nr_threads = clamp_val(nr_threads, 1, CMP_THREADS);
+	nr_threads = cmp_nr_threads();
 
-	page = vmalloc(array_size(CMP_MAX_RD_PAGES, sizeof(*page)));
+	/*
+	 * Keep enough reads in flight for all threads to stay busy, so that
+	 * resume is bounded by the storage rather than by waiting on it.
+	 */
+	max_rd_pages = max_t(unsigned long, CMP_MAX_RD_PAGES,
+			     nr_threads * CMP_PAGES * CMP_RD_BLOCKS_PER_THREAD);
+
+	page = vmalloc(array_size(max_rd_pages, sizeof(*page)));
 	if (!page) {
 		pr_err("Failed to allocate %s page\n", hib_comp_algo);
 		ret = -ENOMEM;
@@ -1238,7 +1295,7 @@ static int load_compressed_image(struct swap_map_handle *handle,
 		goto out_clean;
 	}
 
-	crc = kzalloc(sizeof(*crc), GFP_KERNEL);
+	crc = alloc_crc_data(nr_threads);
 	if (!crc) {
 		pr_err("Failed to allocate crc\n");
 		ret = -ENOMEM;
@@ -1302,7 +1359,7 @@ static int load_compressed_image(struct swap_map_handle *handle,
 	 */
 	if (low_free_pages() > snapshot_get_image_size())
 		read_pages = (low_free_pages() - snapshot_get_image_size()) / 2;
-	read_pages = clamp_val(read_pages, CMP_MIN_RD_PAGES, CMP_MAX_RD_PAGES);
+	read_pages = clamp_val(read_pages, CMP_MIN_RD_PAGES, max_rd_pages);
 
 	for (i = 0; i < read_pages; i++) {
 		page[i] = (void *)__get_free_page(i < CMP_PAGES ?
@@ -1498,11 +1555,7 @@ static int load_compressed_image(struct swap_map_handle *handle,
 	hib_finish_batch(&hb);
 	for (i = 0; i < ring_size; i++)
 		free_page((unsigned long)page[i]);
-	if (crc) {
-		if (crc->thr)
-			kthread_stop(crc->thr);
-		kfree(crc);
-	}
+	free_crc_data(crc);
 	if (data) {
 		for (thr = 0; thr < nr_threads; thr++) {
 			if (data[thr].thr)
@@ -43,6 +43,7 @@
 #include <linux/rculist.h>
 #include <linux/poll.h>
 #include <linux/irq_work.h>
+#include <linux/hash.h>
 #include <linux/ctype.h>
 #include <linux/uio.h>
 #include <linux/sched/clock.h>
@@ -2237,6 +2238,349 @@ static u16 printk_sprint(char *text, u16 size, int facility,
 	return text_len;
 }
 
+/*
+ * Log storm staging.
+ *
+ * When one CPU logs faster than printk_storm_threshold messages per 10ms,
+ * its messages of KERN_ERR and below are formatted into a per-CPU staging
+ * buffer instead of being reserved one by one in the shared ringbuffer.
+ * An irq_work on that CPU then moves the staged records of all CPUs into
+ * the ringbuffer in one batch, merged by the timestamp taken when each
+ * message was logged. Messages logged in NMI, continuation lines and
+ * everything during a panic or an oops bypass the staging.
+ *
+ * Each CPU also counts its messages per format string while storming, and
+ * reports the busiest callsite once the storm has passed.
+ */
+#define PRINTK_STAGE_SIZE	8192
+#define PRINTK_STORM_WINDOW	max(HZ / 100, 1)
+#define PRINTK_STORM_CALLSITES	16
+#define PRINTK_STORM_FMT_LEN	48
+
+static unsigned int printk_storm_threshold __ro_after_init;
+module_param_named(storm_threshold, printk_storm_threshold, uint, 0444);
+MODULE_PARM_DESC(storm_threshold,
+		 "messages per 10ms on a CPU that start staging them (0 = never)");
+
+struct printk_stage_rec {
+	u64 ts_nsec;
+	u32 caller_id;
+	u16 text_len;
+	u8 facility;
+	u8 level;
+	u8 flags;
+	bool has_dev_info;
+	/* followed by struct dev_printk_info if has_dev_info, then text */
+};
+
+struct printk_stage_buf {
+	unsigned int len;
+	unsigned int pos;	/* merge cursor */
+	u8 data[PRINTK_STAGE_SIZE];
+};
+
+struct printk_storm_callsite {
+	const char *fmt;
+	unsigned int count;
+	char text[PRINTK_STORM_FMT_LEN];
+};
+
+struct printk_stage {
+	raw_spinlock_t lock;
+	struct printk_stage_buf *active;
+	struct printk_stage_buf bufs[2];
+	struct irq_work work;
+
+	/* Only touched by the owning CPU, with interrupts disabled */
+	unsigned long window_start;
+	unsigned int window_count;
+	bool storming;
+	bool report;
+	unsigned int storm_count;
+	struct printk_storm_callsite callsites[PRINTK_STORM_CALLSITES];
+};
+
+static DEFINE_PER_CPU(struct printk_stage *, printk_stage);
+static DEFINE_RAW_SPINLOCK(printk_stage_flush_lock);
+static struct printk_stage_buf **printk_stage_flush_bufs;
+
+static inline struct printk_stage_rec *stage_rec(struct printk_stage_buf *b)
+{
+	return (struct printk_stage_rec *)&b->data[b->pos];
+}
+
+static inline unsigned int stage_rec_size(bool has_dev_info, u16 text_len)
+{
+	return ALIGN(sizeof(struct printk_stage_rec) +
+		     (has_dev_info ? sizeof(struct dev_printk_info) : 0) +
+		     text_len, sizeof(u64));
+}
+
+static inline char *stage_rec_text(struct printk_stage_rec *rec)
+{
+	char *p = (char *)(rec + 1);
+
+	return rec->has_dev_info ? p + sizeof(struct dev_printk_info) : p;
+}
+
+/* Move one staged record into the ringbuffer */
+static void printk_stage_store(struct printk_stage_rec *rec)
+{
+	struct prb_reserved_entry e;
+	struct printk_record r;
+
+	prb_rec_init_wr(&r, rec->text_len);
+	if (!prb_reserve(&e, prb, &r))
+		return;
+
+	memcpy(&r.text_buf[0], stage_rec_text(rec), rec->text_len);
+	r.info->text_len = rec->text_len;
+	r.info->facility = rec->facility;
+	r.info->level = rec->level;
+	r.info->flags = rec->flags;
+	r.info->ts_nsec = rec->ts_nsec;
+	r.info->caller_id = rec->caller_id;
+	if (rec->has_dev_info)
+		memcpy(&r.info->dev_info, rec + 1, sizeof(r.info->dev_info));
+
+	prb_final_commit(&e);
+}
+
+/*
+ * Move the records staged on all CPUs into the ringbuffer, oldest first.
+ * Each CPU's filled buffer is swapped for its empty one under its lock, so
+ * the CPUs can keep staging while the merge runs. With @panic, locks are
+ * only tried, as their owners may have been stopped.
+ */
+static void printk_stage_flush(bool panic)
+{
+	struct printk_stage_buf **bufs = printk_stage_flush_bufs;
+	unsigned long irqflags;
+	unsigned int cpu;
+
+	if (!bufs)
+		return;
+
+	if (panic) {
+		local_irq_save(irqflags);
+		if (!raw_spin_trylock(&printk_stage_flush_lock)) {
+			local_irq_restore(irqflags);
+			return;
+		}
+	} else {
+		raw_spin_lock_irqsave(&printk_stage_flush_lock, irqflags);
+	}
+
+	for_each_possible_cpu(cpu) {
+		struct printk_stage *s = per_cpu(printk_stage, cpu);
+		struct printk_stage_buf *b = NULL;
+
+		bufs[cpu] = NULL;
+		if (!s || !READ_ONCE(s->active->len))
+			continue;
+		if (panic) {
+			if (!raw_spin_trylock(&s->lock))
+				continue;
+		} else {
+			raw_spin_lock(&s->lock);
+		}
+		if (s->active->len) {
+			b = s->active;
+			s->active = (b == &s->bufs[0]) ? &s->bufs[1] : &s->bufs[0];
+		}
+		raw_spin_unlock(&s->lock);
+		bufs[cpu] = b;
+	}
+
+	for (;;) {
+		struct printk_stage_buf *oldest = NULL;
+		struct printk_stage_rec *rec;
+
+		for_each_possible_cpu(cpu) {
+			struct printk_stage_buf *b = bufs[cpu];
+
+			if (!b || b->pos >= b->len)
+				continue;
+			if (!oldest ||
+			    stage_rec(b)->ts_nsec < stage_rec(oldest)->ts_nsec)
+				oldest = b;
+		}
+		if (!oldest)
+			break;
+
+		rec = stage_rec(oldest);
+		printk_stage_store(rec);
+		oldest->pos += stage_rec_size(rec->has_dev_info, rec->text_len);
+	}
+
+	for_each_possible_cpu(cpu) {
+		if (bufs[cpu]) {
+			bufs[cpu]->len = 0;
+			bufs[cpu]->pos = 0;
+		}
+	}
+
+	raw_spin_unlock_irqrestore(&printk_stage_flush_lock, irqflags);
+}
+
+static void printk_storm_report(struct printk_stage *s)
+{
+	struct printk_storm_callsite *top = &s->callsites[0];
+	unsigned int i;
+
+	for (i = 1; i < PRINTK_STORM_CALLSITES; i++)
+		if (s->callsites[i].count > top->count)
+			top = &s->callsites[i];
+
+	pr_info("log storm on CPU%d: %u messages, busiest callsite \"%s\" (%u)\n",
+		smp_processor_id(), s->storm_count, top->text, top->count);
+
+	memset(s->callsites, 0, sizeof(s->callsites));
+	s->storm_count = 0;
+}
+
+static void printk_stage_work_func(struct irq_work *work)
+{
+	struct printk_stage *s = container_of(work, struct printk_stage, work);
+	unsigned long irqflags;
+
+	printk_stage_flush(false);
+	nbcon_kthreads_wake();
+	defer_console_output();
+
+	/* The callsite table is only updated with interrupts disabled */
+	local_irq_save(irqflags);
+	if (s->report) {
+		s->report = false;
+		printk_storm_report(s);
+	}
+	local_irq_restore(irqflags);
+}
+
+/* Account @fmt on this CPU, and tell whether the CPU is in a log storm */
+static bool printk_storm_account(struct printk_stage *s, const char *fmt)
+{
+	struct printk_storm_callsite *cs;
+	unsigned long now = jiffies;
+
+	if (time_after_eq(now, s->window_start + PRINTK_STORM_WINDOW)) {
+		if (s->storming && s->window_count < printk_storm_threshold) {
+			s->storming = false;
+			s->report = true;
+			irq_work_queue(&s->work);
+		}
+		s->window_start = now;
+		s->window_count = 0;
+	}
+	if (++s->window_count >= printk_storm_threshold)
+		s->storming = true;
+	if (!s->storming || s->report)
+		return s->storming;
+
+	s->storm_count++;
+	cs = &s->callsites[hash_ptr(fmt, ilog2(PRINTK_STORM_CALLSITES))];
+	if (cs->fmt != fmt) {
+		/* Lossy: a busier callsite wins the slot over time */
+		if (cs->count > 1) {
+			cs->count--;
+			return true;
+		}
+		cs->fmt = fmt;
+		cs->count = 0;
+		strscpy(cs->text, printk_skip_headers(fmt), sizeof(cs->text));
+		strreplace(cs->text, '\n', ' ');
+	}
+	cs->count++;
+	return true;
+}
+
+/*
+ * Stage the message on this CPU if it is in a log storm. Called with
+ * interrupts disabled. Returns the length of the staged text, or -1 if
+ * the message must go to the ringbuffer directly.
+ */
+__printf(6, 0)
+static int printk_stage_message(int facility, int level,
+				enum printk_info_flags flags,
+				const struct dev_printk_info *dev_info,
+				u16 reserve_size, const char *fmt, va_list args)
+{
+	struct printk_stage *s = NULL;
+	struct printk_stage_rec *rec;
+	struct printk_stage_buf *b;
+	unsigned int size;
+	u16 text_len;
+
+	if (printk_storm_threshold)
+		s = this_cpu_read(printk_stage);
+	if (!s || in_nmi() || (flags & LOG_CONT) || level <= LOGLEVEL_CRIT ||
+	    panic_in_progress() || oops_in_progress)
+		return -1;
+	if (!printk_storm_account(s, fmt))
+		return -1;
+
+	size = stage_rec_size(dev_info, reserve_size);
+	if (size > PRINTK_STAGE_SIZE)
+		return -1;
+
+	raw_spin_lock(&s->lock);
+	b = s->active;
+	if (b->len + size > PRINTK_STAGE_SIZE) {
+		raw_spin_unlock(&s->lock);
+		printk_stage_flush(false);
+		raw_spin_lock(&s->lock);
+		b = s->active;
+	}
+
+	rec = (struct printk_stage_rec *)&b->data[b->len];
+	rec->ts_nsec = local_clock();
+	rec->caller_id = printk_caller_id();
+	rec->facility = facility;
+	rec->level = level & 7;
+	rec->has_dev_info = dev_info;
+	if (dev_info)
+		memcpy(rec + 1, dev_info, sizeof(*dev_info));
+	text_len = printk_sprint(stage_rec_text(rec), reserve_size, facility,
+				 &flags, fmt, args);
+	rec->text_len = text_len;
+	/* Nothing can be appended to a staged record, end the line */
+	rec->flags = (flags | LOG_NEWLINE) & 0x1f;
+	b->len += stage_rec_size(dev_info, text_len);
+	raw_spin_unlock(&s->lock);
+
+	irq_work_queue(&s->work);
+	return text_len;
+}
+
+static int __init printk_stage_init(void)
+{
+	unsigned int cpu;
+
+	if (!printk_storm_threshold)
+		return 0;
+
+	printk_stage_flush_bufs = kcalloc(nr_cpu_ids,
+					  sizeof(*printk_stage_flush_bufs),
+					  GFP_KERNEL);
+	if (!printk_stage_flush_bufs)
+		return -ENOMEM;
+
+	for_each_possible_cpu(cpu) {
+		struct printk_stage *s;
+
+		s = kzalloc_node(sizeof(*s), GFP_KERNEL, cpu_to_node(cpu));
+		if (!s)
+			continue;
+		raw_spin_lock_init(&s->lock);
+		s->active = &s->bufs[0];
+		init_irq_work(&s->work, printk_stage_work_func);
+		s->window_start = jiffies;
+		per_cpu(printk_stage, cpu) = s;
+	}
+	return 0;
+}
+early_initcall(printk_stage_init);
+
 __printf(4, 0)
 int vprintk_store(int facility, int level,
 		  const struct dev_printk_info *dev_info,
@@ -2295,6 +2639,12 @@ int vprintk_store(int facility, int level,
 	if (is_printk_force_console())
 		flags |= LOG_FORCE_CON;
 
+	ret = printk_stage_message(facility, level, flags, dev_info,
+				   reserve_size, fmt, args);
+	if (ret >= 0)
+		goto out;
+	ret = 0;
+
 	if (flags & LOG_CONT) {
 		prb_rec_init_wr(&r, reserve_size);
 		if (prb_reserve_in_last(&e, prb, &r, caller_id, PRINTKRB_RECORD_MAX)) {
@@ -2476,6 +2826,7 @@ static u64 syslog_seq;
 
 static bool pr_flush(int timeout_ms, bool reset_on_progress) { return true; }
 static bool __pr_flush(struct console *con, int timeout_ms, bool reset_on_progress) { return true; }
+static void printk_stage_flush(bool panic) { }
 
 #endif /* CONFIG_PRINTK */
 
@@ -3436,6 +3787,9 @@ void console_flush_on_panic(enum con_flush_mode mode)
 	bool handover;
 	u64 next_seq;
 
+	/* Don't leave records of a log storm behind in the staging buffers */
+	printk_stage_flush(true);
+
 	/*
 	 * Ignore the console lock and flush out the messages. Attempting a
 	 * trylock would not be useful because:
@@ -526,6 +526,13 @@ SYSCALL_DEFINE4(rseq, struct rseq __user *, rseq, u32, rseq_len,
 	current->rseq_len = rseq_len;
 	current->rseq_sig = sig;
 
+	/*
+	 * Order the registration before any critical section the thread
+	 * enters, pairs with the barrier at the start of the membarrier
+	 * RSEQ command, which skips threads without an rseq area.
+	 */
+	smp_mb();
+
 	/*
 	 * If rseq was previously inactive, and has just been
 	 * registered, ensure the cpu_id_start and cpu_id fields
@@ -3475,6 +3475,45 @@ void kick_process(struct task_struct *p)
 }
 EXPORT_SYMBOL_GPL(kick_process);
 
+/**
+ * sched_task_preempt_pending - whether a running task is about to lose its CPU
+ * @p: the task, speculatively running on another CPU
+ *
+ * True if @p was already asked to reschedule, or is a fair task that used up
+ * its slice while other tasks are waiting for its CPU. Meant for optimistic
+ * spinners deciding whether a lock owner will release the lock before being
+ * preempted; lockless, so only a hint.
+ */
+bool sched_task_preempt_pending(struct task_struct *p)
+{
+	struct sched_entity *se = &p->se;
+
+	if (test_tsk_need_resched(p))
+		return true;
+
+	if (READ_ONCE(p->sched_class) != &fair_sched_class ||
+	    READ_ONCE(task_rq(p)->nr_running) <= 1)
+		return false;
+
+	return READ_ONCE(se->sum_exec_runtime) -
+	       READ_ONCE(se->prev_sum_exec_runtime) >= READ_ONCE(se->slice);
+}
+
+/**
+ * sched_cpu_steal_clock - time the hypervisor did not run the vCPU of @cpu
+ * @cpu: the CPU
+ *
+ * Return: the steal time of @cpu in nanoseconds, 0 when it is not known.
+ */
+u64 sched_cpu_steal_clock(int cpu)
+{
+#ifdef CONFIG_PARAVIRT
+	if (static_key_false(&paravirt_steal_enabled))
+		return paravirt_steal_clock(cpu);
+#endif
+	return 0;
+}
+
 /*
  * ->cpus_ptr is protected by both rq->lock and p->pi_lock
  *
@@ -4552,6 +4591,10 @@ void set_numabalancing_state(bool enabled)
 }
 
 #ifdef CONFIG_PROC_SYSCTL
+static const int numa_balancing_mode_max = NUMA_BALANCING_NORMAL |
+					   NUMA_BALANCING_MEMORY_TIERING |
+					   NUMA_BALANCING_ACCESS_BIT;
+
 static void reset_memory_tiering(void)
 {
 	struct pglist_data *pgdat;
@@ -4579,6 +4622,10 @@ static int sysctl_numa_balancing(const struct ctl_table *table, int write,
 	if (err < 0)
 		return err;
 	if (write) {
+		/* Promotion relies on the hint fault latency of slow memory */
+		if ((state & NUMA_BALANCING_ACCESS_BIT) &&
+		    (state & NUMA_BALANCING_MEMORY_TIERING))
+			return -EINVAL;
 		if (!(sysctl_numa_balancing_mode & NUMA_BALANCING_MEMORY_TIERING) &&
 		    (state & NUMA_BALANCING_MEMORY_TIERING))
 			reset_memory_tiering();
@@ -4654,6 +4701,36 @@ static int sysctl_schedstats(const struct ctl_table *table, int write, void *buf
 #endif /* CONFIG_PROC_SYSCTL */
 #endif /* CONFIG_SCHEDSTATS */
 
+#ifdef CONFIG_SCHED_LATENCY_HIST
+DEFINE_STATIC_KEY_FALSE(sched_lat_hist);
+
+#ifdef CONFIG_PROC_SYSCTL
+static int sysctl_sched_lat_hist(const struct ctl_table *table, int write,
+				 void *buffer, size_t *lenp, loff_t *ppos)
+{
+	struct ctl_table t;
+	int err;
+	int state = static_branch_likely(&sched_lat_hist);
+
+	if (write && !capable(CAP_SYS_ADMIN))
+		return -EPERM;
+
+	t = *table;
+	t.data = &state;
+	err = proc_dointvec_minmax(&t, write, buffer, lenp, ppos);
+	if (err < 0)
+		return err;
+	if (write) {
+		if (state)
+			static_branch_enable(&sched_lat_hist);
+		else
+			static_branch_disable(&sched_lat_hist);
+	}
+	return err;
+}
+#endif /* CONFIG_PROC_SYSCTL */
+#endif /* CONFIG_SCHED_LATENCY_HIST */
+
 #ifdef CONFIG_SYSCTL
 static const struct ctl_table sched_core_sysctls[] = {
 #ifdef CONFIG_SCHEDSTATS
@@ -4667,6 +4744,17 @@ static const struct ctl_table sched_core_sysctls[] = {
 		.extra2         = SYSCTL_ONE,
 	},
 #endif /* CONFIG_SCHEDSTATS */
+#ifdef CONFIG_SCHED_LATENCY_HIST
+	{
+		.procname       = "sched_latency_hist",
+		.data           = NULL,
+		.maxlen         = sizeof(unsigned int),
+		.mode           = 0644,
+		.proc_handler   = sysctl_sched_lat_hist,
+		.extra1         = SYSCTL_ZERO,
+		.extra2         = SYSCTL_ONE,
+	},
+#endif /* CONFIG_SCHED_LATENCY_HIST */
 #ifdef CONFIG_UCLAMP_TASK
 	{
 		.procname       = "sched_util_clamp_min",
@@ -4698,7 +4786,7 @@ static const struct ctl_table sched_core_sysctls[] = {
 		.mode		= 0644,
 		.proc_handler	= sysctl_numa_balancing,
 		.extra1		= SYSCTL_ZERO,
-		.extra2		= SYSCTL_FOUR,
+		.extra2		= (void *)&numa_balancing_mode_max,
 	},
 #endif /* CONFIG_NUMA_BALANCING */
 };
@@ -8918,6 +9006,9 @@ static void sched_free_group(struct task_group *tg)
 	free_fair_sched_group(tg);
 	free_rt_sched_group(tg);
 	autogroup_free(tg);
+#ifdef CONFIG_SCHED_LATENCY_HIST
+	free_percpu(tg->lat_hist);
+#endif
 	kmem_cache_free(task_group_cache, tg);
 }
 
@@ -8952,6 +9043,13 @@ struct task_group *sched_create_group(struct task_group *parent)
 	if (!alloc_rt_sched_group(tg, parent))
 		goto err;
 
+#ifdef CONFIG_SCHED_LATENCY_HIST
+	tg->lat_hist = __alloc_percpu(SCHED_LAT_NR_BUCKETS * sizeof(u64),
+				      __alignof__(u64));
+	if (!tg->lat_hist)
+		goto err;
+#endif
+
 	scx_group_set_weight(tg, CGROUP_WEIGHT_DFL);
 	alloc_uclamp_sched_group(tg, parent);
 
@@ -9787,6 +9885,23 @@ static int cpu_idle_write_s64(struct cgroup_subsys_state *css,
 }
 #endif
 
+#ifdef CONFIG_FAIR_GROUP_SCHED
+static u64 cpu_slice_read_u64(struct cgroup_subsys_state *css,
+			      struct cftype *cft)
+{
+	return div_u64(css_tg(css)->slice_req, NSEC_PER_USEC);
+}
+
+static int cpu_slice_write_u64(struct cgroup_subsys_state *css,
+			       struct cftype *cft, u64 slice_us)
+{
+	if (slice_us > U64_MAX / NSEC_PER_USEC)
+		return -EINVAL;
+
+	return sched_group_set_slice(css_tg(css), slice_us * NSEC_PER_USEC);
+}
+#endif
+
 static struct cftype cpu_legacy_files[] = {
 #ifdef CONFIG_GROUP_SCHED_WEIGHT
 	{
@@ -9898,6 +10013,40 @@ static int cpu_local_stat_show(struct seq_file *sf,
 	return 0;
 }
 
+#ifdef CONFIG_SCHED_LATENCY_HIST
+static int cpu_latency_show(struct seq_file *sf, void *v)
+{
+	struct cgroup_subsys_state *css;
+	u64 *hist;
+	int cpu, i;
+
+	hist = kcalloc(SCHED_LAT_NR_BUCKETS, sizeof(*hist), GFP_KERNEL);
+	if (!hist)
+		return -ENOMEM;
+
+	rcu_read_lock();
+	css_for_each_descendant_pre(css, seq_css(sf)) {
+		struct task_group *tg = css_tg(css);
+
+		if (!tg->lat_hist)
+			continue;
+
+		for_each_possible_cpu(cpu) {
+			u64 *h = per_cpu_ptr(tg->lat_hist, cpu);
+
+			for (i = 0; i < SCHED_LAT_NR_BUCKETS; i++)
+				hist[i] += READ_ONCE(h[i]);
+		}
+	}
+	rcu_read_unlock();
+
+	sched_lat_hist_seq_show(sf, hist);
+	kfree(hist);
+
+	return 0;
+}
+#endif
+
 #ifdef CONFIG_GROUP_SCHED_WEIGHT
 
 static u64 cpu_weight_read_u64(struct cgroup_subsys_state *css,
@@ -10040,6 +10189,14 @@ static struct cftype cpu_files[] = {
 		.write_s64 = cpu_idle_write_s64,
 	},
 #endif
+#ifdef CONFIG_FAIR_GROUP_SCHED
+	{
+		.name = "slice",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.read_u64 = cpu_slice_read_u64,
+		.write_u64 = cpu_slice_write_u64,
+	},
+#endif
 #ifdef CONFIG_CFS_BANDWIDTH
 	{
 		.name = "max",
@@ -10067,6 +10224,13 @@ static struct cftype cpu_files[] = {
 		.seq_show = cpu_uclamp_max_show,
 		.write = cpu_uclamp_max_write,
 	},
+#endif
+#ifdef CONFIG_SCHED_LATENCY_HIST
+	{
+		.name = "latency",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.seq_show = cpu_latency_show,
+	},
 #endif
 	{ }	/* terminate */
 };
@@ -150,7 +150,11 @@ int cpupri_find_fitness(struct cpupri *cp, struct task_struct *p,
 
 	WARN_ON_ONCE(task_pri >= CPUPRI_NR_PRIORITIES);
 
-	for (idx = 0; idx < task_pri; idx++) {
+	/*
+	 * Only visit the vectors that have CPUs in them, which with a
+	 * hundred priority levels is usually a small fraction of them.
+	 */
+	for_each_set_bit(idx, cp->pri_active, task_pri) {
 
 		if (!__cpupri_find(cp, p, lowest_mask, idx))
 			continue;
@@ -236,7 +240,8 @@ void cpupri_set(struct cpupri *cp, int cpu, int newpri)
 		 * make sure the vector is visible when count is set.
 		 */
 		smp_mb__before_atomic();
-		atomic_inc(&(vec)->count);
+		if (atomic_inc_return(&(vec)->count) == 1)
+			set_bit(newpri, cp->pri_active);
 		do_mb = 1;
 	}
 	if (likely(oldpri != CPUPRI_INVALID)) {
@@ -261,7 +266,18 @@ void cpupri_set(struct cpupri *cp, int cpu, int newpri)
 		 * When removing from the vector, we decrement the counter first
 		 * do a memory barrier and then clear the mask.
 		 */
-		atomic_dec(&(vec)->count);
+		if (atomic_dec_and_test(&(vec)->count)) {
+			/*
+			 * Clearing the hint races with another CPU adding
+			 * itself to the vector and setting it: the count is
+			 * incremented before the bit is set, so look at it
+			 * again once the bit is cleared and undo if needed.
+			 */
+			clear_bit(oldpri, cp->pri_active);
+			smp_mb__after_atomic();
+			if (atomic_read(&(vec)->count))
+				set_bit(oldpri, cp->pri_active);
+		}
 		smp_mb__after_atomic();
 		cpumask_clear_cpu(cpu, vec->mask);
 	}
@@ -287,6 +303,8 @@ int cpupri_init(struct cpupri *cp)
 			goto cleanup;
 	}
 
+	bitmap_zero(cp->pri_active, CPUPRI_NR_PRIORITIES);
+
 	cp->cpu_to_pri = kcalloc(nr_cpu_ids, sizeof(int), GFP_KERNEL);
 	if (!cp->cpu_to_pri)
 		goto cleanup;
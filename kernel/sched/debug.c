@@ -580,6 +580,10 @@ static void register_sd(struct sched_domain *sd, struct dentry *parent)
 	SDM(u32,   0644, imbalance_pct);
 	SDM(u32,   0644, cache_nice_tries);
 	SDM(str,   0444, name);
+#ifdef CONFIG_SCHEDSTATS
+	SDM(u32,   0444, newidle_lb_skipped);
+	SDM(u64,   0444, newidle_lb_cost);
+#endif
 
 #undef SDM
 
@@ -135,6 +135,17 @@ enum scx_ops_flags {
 	 */
 	SCX_OPS_ENQ_MIGRATION_DISABLED = 1LLU << 4,
 
+	/*
+	 * If set, the built-in idle tracking keeps a pair of idle cpumasks per
+	 * NUMA node instead of system-wide ones, so that idle state updates
+	 * and idle CPU searches stay within the node's cachelines. The
+	 * system-wide idle cpumask kfuncs can't be used in this mode, use the
+	 * _node variants instead.
+	 *
+	 * Requires the built-in idle tracking, see %SCX_OPS_KEEP_BUILTIN_IDLE.
+	 */
+	SCX_OPS_BUILTIN_IDLE_PER_NODE = 1LLU << 5,
+
 	/*
 	 * CPU cgroup support flags
 	 */
@@ -145,6 +156,7 @@ enum scx_ops_flags {
 				  SCX_OPS_ENQ_EXITING |
 				  SCX_OPS_ENQ_MIGRATION_DISABLED |
 				  SCX_OPS_SWITCH_PARTIAL |
+				  SCX_OPS_BUILTIN_IDLE_PER_NODE |
 				  SCX_OPS_HAS_CGROUP_WEIGHT,
 };
 
@@ -779,6 +791,7 @@ enum scx_deq_flags {
 
 enum scx_pick_idle_cpu_flags {
 	SCX_PICK_IDLE_CORE	= 1LLU << 0,	/* pick a CPU whose SMT siblings are also idle */
+	SCX_PICK_IDLE_IN_NODE	= 1LLU << 1,	/* don't look beyond the given node */
 };
 
 enum scx_kick_flags {
@@ -899,6 +912,7 @@ static DEFINE_STATIC_KEY_FALSE(scx_ops_enq_exiting);
 static DEFINE_STATIC_KEY_FALSE(scx_ops_enq_migration_disabled);
 static DEFINE_STATIC_KEY_FALSE(scx_ops_cpu_preempt);
 static DEFINE_STATIC_KEY_FALSE(scx_builtin_idle_enabled);
+static DEFINE_STATIC_KEY_FALSE(scx_builtin_idle_per_node);
 
 #ifdef CONFIG_SMP
 static DEFINE_STATIC_KEY_FALSE(scx_selcpu_topo_llc);
@@ -946,10 +960,16 @@ static struct delayed_work scx_watchdog_work;
 #define CL_ALIGNED_IF_ONSTACK __cacheline_aligned_in_smp
 #endif
 
-static struct {
+struct idle_cpus {
 	cpumask_var_t cpu;
 	cpumask_var_t smt;
-} idle_masks CL_ALIGNED_IF_ONSTACK;
+};
+
+/* system-wide masks, unless %SCX_OPS_BUILTIN_IDLE_PER_NODE */
+static struct idle_cpus idle_masks CL_ALIGNED_IF_ONSTACK;
+
+/* per-node masks for %SCX_OPS_BUILTIN_IDLE_PER_NODE, allocated on each node */
+static struct idle_cpus **idle_node_masks;
 
 #endif	/* CONFIG_SMP */
 
@@ -3220,8 +3240,26 @@ bool scx_prio_less(const struct task_struct *a, const struct task_struct *b,
 
 #ifdef CONFIG_SMP
 
+static bool idle_per_node(void)
+{
+	return static_branch_maybe(CONFIG_NUMA, &scx_builtin_idle_per_node);
+}
+
+/* the node whose idle masks track @cpu, %NUMA_NO_NODE for the global ones */
+static int idle_cpu_to_node(int cpu)
+{
+	return idle_per_node() ? cpu_to_node(cpu) : NUMA_NO_NODE;
+}
+
+static struct idle_cpus *idle_cpumasks(int node)
+{
+	return node == NUMA_NO_NODE ? &idle_masks : idle_node_masks[node];
+}
+
 static bool test_and_clear_cpu_idle(int cpu)
 {
+	struct idle_cpus *idle = idle_cpumasks(idle_cpu_to_node(cpu));
+
 #ifdef CONFIG_SCHED_SMT
 	/*
 	 * SMT mask should be cleared whether we can claim @cpu or not. The SMT
@@ -3234,29 +3272,31 @@ static bool test_and_clear_cpu_idle(int cpu)
 		/*
 		 * If offline, @cpu is not its own sibling and
 		 * scx_pick_idle_cpu() can get caught in an infinite loop as
-		 * @cpu is never cleared from idle_masks.smt. Ensure that @cpu
-		 * is eventually cleared.
+		 * @cpu is never cleared from idle->smt. Ensure that @cpu is
+		 * eventually cleared.
 		 *
 		 * NOTE: Use cpumask_intersects() and cpumask_test_cpu() to
 		 * reduce memory writes, which may help alleviate cache
 		 * coherence pressure.
 		 */
-		if (cpumask_intersects(smt, idle_masks.smt))
-			cpumask_andnot(idle_masks.smt, idle_masks.smt, smt);
-		else if (cpumask_test_cpu(cpu, idle_masks.smt))
-			__cpumask_clear_cpu(cpu, idle_masks.smt);
+		if (cpumask_intersects(smt, idle->smt))
+			cpumask_andnot(idle->smt, idle->smt, smt);
+		else if (cpumask_test_cpu(cpu, idle->smt))
+			__cpumask_clear_cpu(cpu, idle->smt);
 	}
 #endif
-	return cpumask_test_and_clear_cpu(cpu, idle_masks.cpu);
+	return cpumask_test_and_clear_cpu(cpu, idle->cpu);
 }
 
-static s32 scx_pick_idle_cpu(const struct cpumask *cpus_allowed, u64 flags)
+static s32 pick_idle_cpu_from(const struct cpumask *cpus_allowed, int node,
+			      u64 flags)
 {
+	struct idle_cpus *idle = idle_cpumasks(node);
 	int cpu;
 
 retry:
 	if (sched_smt_active()) {
-		cpu = cpumask_any_and_distribute(idle_masks.smt, cpus_allowed);
+		cpu = cpumask_any_and_distribute(idle->smt, cpus_allowed);
 		if (cpu < nr_cpu_ids)
 			goto found;
 
@@ -3264,7 +3304,7 @@ static s32 scx_pick_idle_cpu(const struct cpumask *cpus_allowed, u64 flags)
 			return -EBUSY;
 	}
 
-	cpu = cpumask_any_and_distribute(idle_masks.cpu, cpus_allowed);
+	cpu = cpumask_any_and_distribute(idle->cpu, cpus_allowed);
 	if (cpu >= nr_cpu_ids)
 		return -EBUSY;
 
@@ -3275,6 +3315,39 @@ static s32 scx_pick_idle_cpu(const struct cpumask *cpus_allowed, u64 flags)
 		goto retry;
 }
 
+/*
+ * Pick and claim an idle CPU in @cpus_allowed. With per-node idle tracking,
+ * @node is searched first (the current node if %NUMA_NO_NODE) and then, unless
+ * %SCX_PICK_IDLE_IN_NODE, the other nodes with CPUs. @node is ignored
+ * otherwise.
+ */
+static s32 scx_pick_idle_cpu(const struct cpumask *cpus_allowed, int node,
+			     u64 flags)
+{
+	s32 cpu;
+	int n;
+
+	if (!idle_per_node())
+		return pick_idle_cpu_from(cpus_allowed, NUMA_NO_NODE, flags);
+
+	if (node == NUMA_NO_NODE)
+		node = numa_node_id();
+
+	cpu = pick_idle_cpu_from(cpus_allowed, node, flags);
+	if (cpu >= 0 || (flags & SCX_PICK_IDLE_IN_NODE))
+		return cpu;
+
+	for_each_node_state(n, N_CPU) {
+		if (n == node)
+			continue;
+		cpu = pick_idle_cpu_from(cpus_allowed, n, flags);
+		if (cpu >= 0)
+			return cpu;
+	}
+
+	return -EBUSY;
+}
+
 /*
  * Return the amount of CPUs in the same LLC domain of @cpu (or zero if the LLC
  * domain is not defined).
@@ -3482,6 +3555,7 @@ static s32 scx_select_cpu_dfl(struct task_struct *p, s32 prev_cpu,
 {
 	const struct cpumask *llc_cpus = NULL;
 	const struct cpumask *numa_cpus = NULL;
+	int node = idle_cpu_to_node(prev_cpu);
 	s32 cpu;
 
 	*found = false;
@@ -3539,7 +3613,7 @@ static s32 scx_select_cpu_dfl(struct task_struct *p, s32 prev_cpu,
 		 * piled up on it even if there is an idle core elsewhere on
 		 * the system.
 		 */
-		if (!cpumask_empty(idle_masks.cpu) &&
+		if (!cpumask_empty(idle_cpumasks(idle_cpu_to_node(cpu))->cpu) &&
 		    !(current->flags & PF_EXITING) &&
 		    cpu_rq(cpu)->scx.local_dsq.nr == 0) {
 			if (cpumask_test_cpu(cpu, p->cpus_ptr))
@@ -3555,7 +3629,7 @@ static s32 scx_select_cpu_dfl(struct task_struct *p, s32 prev_cpu,
 		/*
 		 * Keep using @prev_cpu if it's part of a fully idle core.
 		 */
-		if (cpumask_test_cpu(prev_cpu, idle_masks.smt) &&
+		if (cpumask_test_cpu(prev_cpu, idle_cpumasks(node)->smt) &&
 		    test_and_clear_cpu_idle(prev_cpu)) {
 			cpu = prev_cpu;
 			goto cpu_found;
@@ -3565,7 +3639,8 @@ static s32 scx_select_cpu_dfl(struct task_struct *p, s32 prev_cpu,
 		 * Search for any fully idle core in the same LLC domain.
 		 */
 		if (llc_cpus) {
-			cpu = scx_pick_idle_cpu(llc_cpus, SCX_PICK_IDLE_CORE);
+			cpu = scx_pick_idle_cpu(llc_cpus, node,
+						SCX_PICK_IDLE_CORE | SCX_PICK_IDLE_IN_NODE);
 			if (cpu >= 0)
 				goto cpu_found;
 		}
@@ -3574,7 +3649,8 @@ static s32 scx_select_cpu_dfl(struct task_struct *p, s32 prev_cpu,
 		 * Search for any fully idle core in the same NUMA node.
 		 */
 		if (numa_cpus) {
-			cpu = scx_pick_idle_cpu(numa_cpus, SCX_PICK_IDLE_CORE);
+			cpu = scx_pick_idle_cpu(numa_cpus, node,
+						SCX_PICK_IDLE_CORE | SCX_PICK_IDLE_IN_NODE);
 			if (cpu >= 0)
 				goto cpu_found;
 		}
@@ -3582,7 +3658,7 @@ static s32 scx_select_cpu_dfl(struct task_struct *p, s32 prev_cpu,
 		/*
 		 * Search for any full idle core usable by the task.
 		 */
-		cpu = scx_pick_idle_cpu(p->cpus_ptr, SCX_PICK_IDLE_CORE);
+		cpu = scx_pick_idle_cpu(p->cpus_ptr, node, SCX_PICK_IDLE_CORE);
 		if (cpu >= 0)
 			goto cpu_found;
 	}
@@ -3599,7 +3675,7 @@ static s32 scx_select_cpu_dfl(struct task_struct *p, s32 prev_cpu,
 	 * Search for any idle CPU in the same LLC domain.
 	 */
 	if (llc_cpus) {
-		cpu = scx_pick_idle_cpu(llc_cpus, 0);
+		cpu = scx_pick_idle_cpu(llc_cpus, node, SCX_PICK_IDLE_IN_NODE);
 		if (cpu >= 0)
 			goto cpu_found;
 	}
@@ -3608,7 +3684,7 @@ static s32 scx_select_cpu_dfl(struct task_struct *p, s32 prev_cpu,
 	 * Search for any idle CPU in the same NUMA node.
 	 */
 	if (numa_cpus) {
-		cpu = scx_pick_idle_cpu(numa_cpus, 0);
+		cpu = scx_pick_idle_cpu(numa_cpus, node, SCX_PICK_IDLE_IN_NODE);
 		if (cpu >= 0)
 			goto cpu_found;
 	}
@@ -3616,7 +3692,7 @@ static s32 scx_select_cpu_dfl(struct task_struct *p, s32 prev_cpu,
 	/*
 	 * Search for any idle CPU usable by the task.
 	 */
-	cpu = scx_pick_idle_cpu(p->cpus_ptr, 0);
+	cpu = scx_pick_idle_cpu(p->cpus_ptr, node, 0);
 	if (cpu >= 0)
 		goto cpu_found;
 
@@ -3698,17 +3774,31 @@ static void set_cpus_allowed_scx(struct task_struct *p,
 
 static void reset_idle_masks(void)
 {
+	int node;
+
 	/*
 	 * Consider all online cpus idle. Should converge to the actual state
 	 * quickly.
 	 */
-	cpumask_copy(idle_masks.cpu, cpu_online_mask);
-	cpumask_copy(idle_masks.smt, cpu_online_mask);
+	if (!idle_per_node()) {
+		cpumask_copy(idle_masks.cpu, cpu_online_mask);
+		cpumask_copy(idle_masks.smt, cpu_online_mask);
+		return;
+	}
+
+	for_each_node(node) {
+		const struct cpumask *node_mask = cpumask_of_node(node);
+
+		cpumask_and(idle_node_masks[node]->cpu, cpu_online_mask, node_mask);
+		cpumask_and(idle_node_masks[node]->smt, cpu_online_mask, node_mask);
+	}
 }
 
 static void update_builtin_idle(int cpu, bool idle)
 {
-	assign_cpu(cpu, idle_masks.cpu, idle);
+	struct idle_cpus *masks = idle_cpumasks(idle_cpu_to_node(cpu));
+
+	assign_cpu(cpu, masks->cpu, idle);
 
 #ifdef CONFIG_SCHED_SMT
 	if (sched_smt_active()) {
@@ -3716,14 +3806,14 @@ static void update_builtin_idle(int cpu, bool idle)
 
 		if (idle) {
 			/*
-			 * idle_masks.smt handling is racy but that's fine as
-			 * it's only for optimization and self-correcting.
+			 * masks->smt handling is racy but that's fine as it's
+			 * only for optimization and self-correcting.
 			 */
-			if (!cpumask_subset(smt, idle_masks.cpu))
+			if (!cpumask_subset(smt, masks->cpu))
 				return;
-			cpumask_or(idle_masks.smt, idle_masks.smt, smt);
+			cpumask_or(masks->smt, masks->smt, smt);
 		} else {
-			cpumask_andnot(idle_masks.smt, idle_masks.smt, smt);
+			cpumask_andnot(masks->smt, masks->smt, smt);
 		}
 	}
 #endif
@@ -3822,7 +3912,7 @@ static void rq_offline_scx(struct rq *rq)
 #else	/* CONFIG_SMP */
 
 static bool test_and_clear_cpu_idle(int cpu) { return false; }
-static s32 scx_pick_idle_cpu(const struct cpumask *cpus_allowed, u64 flags) { return -EBUSY; }
+static s32 scx_pick_idle_cpu(const struct cpumask *cpus_allowed, int node, u64 flags) { return -EBUSY; }
 static void reset_idle_masks(void) {}
 
 #endif	/* CONFIG_SMP */
@@ -5100,6 +5190,7 @@ static void scx_ops_disable_workfn(struct kthread_work *work)
 	static_branch_disable(&scx_ops_enq_migration_disabled);
 	static_branch_disable(&scx_ops_cpu_preempt);
 	static_branch_disable(&scx_builtin_idle_enabled);
+	static_branch_disable(&scx_builtin_idle_per_node);
 	synchronize_rcu();
 
 	if (ei->kind >= SCX_EXIT_ERROR) {
@@ -5546,6 +5637,17 @@ static int validate_ops(const struct sched_ext_ops *ops)
 		return -EINVAL;
 	}
 
+	/*
+	 * Per-node idle masks are part of the built-in idle tracking, which is
+	 * disabled when ops.update_idle() is implemented without
+	 * SCX_OPS_KEEP_BUILTIN_IDLE.
+	 */
+	if ((ops->flags & SCX_OPS_BUILTIN_IDLE_PER_NODE) && ops->update_idle &&
+	    !(ops->flags & SCX_OPS_KEEP_BUILTIN_IDLE)) {
+		scx_ops_error("SCX_OPS_BUILTIN_IDLE_PER_NODE requires built-in idle tracking");
+		return -EINVAL;
+	}
+
 	return 0;
 }
 
@@ -5713,10 +5815,15 @@ static int scx_ops_enable(struct sched_ext_ops *ops, struct bpf_link *link)
 		static_branch_enable(&scx_ops_cpu_preempt);
 
 	if (!ops->update_idle || (ops->flags & SCX_OPS_KEEP_BUILTIN_IDLE)) {
+		if (ops->flags & SCX_OPS_BUILTIN_IDLE_PER_NODE)
+			static_branch_enable(&scx_builtin_idle_per_node);
+		else
+			static_branch_disable(&scx_builtin_idle_per_node);
 		reset_idle_masks();
 		static_branch_enable(&scx_builtin_idle_enabled);
 	} else {
 		static_branch_disable(&scx_builtin_idle_enabled);
+		static_branch_disable(&scx_builtin_idle_per_node);
 	}
 
 	/*
@@ -6359,6 +6466,19 @@ void __init init_sched_ext_class(void)
 #ifdef CONFIG_SMP
 	BUG_ON(!alloc_cpumask_var(&idle_masks.cpu, GFP_KERNEL));
 	BUG_ON(!alloc_cpumask_var(&idle_masks.smt, GFP_KERNEL));
+
+	idle_node_masks = kcalloc(nr_node_ids, sizeof(*idle_node_masks),
+				  GFP_KERNEL);
+	BUG_ON(!idle_node_masks);
+	for_each_node(v) {
+		idle_node_masks[v] = kzalloc_node(sizeof(**idle_node_masks),
+						  GFP_KERNEL, v);
+		BUG_ON(!idle_node_masks[v]);
+		BUG_ON(!alloc_cpumask_var_node(&idle_node_masks[v]->cpu,
+					       GFP_KERNEL, v));
+		BUG_ON(!alloc_cpumask_var_node(&idle_node_masks[v]->smt,
+					       GFP_KERNEL, v));
+	}
 #endif
 	scx_kick_cpus_pnt_seqs =
 		__alloc_percpu(sizeof(scx_kick_cpus_pnt_seqs[0]) * nr_cpu_ids,
@@ -6405,6 +6525,37 @@ static bool check_builtin_idle_enabled(void)
 	return false;
 }
 
+/* The system-wide idle cpumasks aren't maintained in per-node mode */
+static bool check_builtin_idle_global(void)
+{
+	if (!check_builtin_idle_enabled())
+		return false;
+
+	if (!static_branch_maybe(CONFIG_NUMA, &scx_builtin_idle_per_node))
+		return true;
+
+	scx_ops_error("SCX_OPS_BUILTIN_IDLE_PER_NODE is set, use the _node kfuncs");
+	return false;
+}
+
+static bool check_builtin_idle_node(int node)
+{
+	if (!check_builtin_idle_enabled())
+		return false;
+
+	if (!static_branch_maybe(CONFIG_NUMA, &scx_builtin_idle_per_node)) {
+		scx_ops_error("SCX_OPS_BUILTIN_IDLE_PER_NODE is not set");
+		return false;
+	}
+
+	if (node < 0 || node >= nr_node_ids || !node_possible(node)) {
+		scx_ops_error("invalid node %d", node);
+		return false;
+	}
+
+	return true;
+}
+
 /**
  * scx_bpf_select_cpu_dfl - The default implementation of ops.select_cpu()
  * @p: task_struct to select a CPU for
@@ -7514,7 +7665,7 @@ __bpf_kfunc void scx_bpf_put_cpumask(const struct cpumask *cpumask)
  */
 __bpf_kfunc const struct cpumask *scx_bpf_get_idle_cpumask(void)
 {
-	if (!check_builtin_idle_enabled())
+	if (!check_builtin_idle_global())
 		return cpu_none_mask;
 
 #ifdef CONFIG_SMP
@@ -7533,7 +7684,7 @@ __bpf_kfunc const struct cpumask *scx_bpf_get_idle_cpumask(void)
  */
 __bpf_kfunc const struct cpumask *scx_bpf_get_idle_smtmask(void)
 {
-	if (!check_builtin_idle_enabled())
+	if (!check_builtin_idle_global())
 		return cpu_none_mask;
 
 #ifdef CONFIG_SMP
@@ -7546,6 +7697,49 @@ __bpf_kfunc const struct cpumask *scx_bpf_get_idle_smtmask(void)
 #endif
 }
 
+/**
+ * scx_bpf_get_idle_cpumask_node - Get a referenced kptr to the idle-tracking
+ * per-CPU cpumask of a NUMA node.
+ * @node: target NUMA node
+ *
+ * Returns an empty cpumask if per-node idle tracking is not enabled, @node is
+ * invalid, or running on a UP kernel.
+ */
+__bpf_kfunc const struct cpumask *scx_bpf_get_idle_cpumask_node(int node)
+{
+	if (!check_builtin_idle_node(node))
+		return cpu_none_mask;
+
+#ifdef CONFIG_SMP
+	return idle_node_masks[node]->cpu;
+#else
+	return cpu_none_mask;
+#endif
+}
+
+/**
+ * scx_bpf_get_idle_smtmask_node - Get a referenced kptr to the idle-tracking,
+ * per-physical-core cpumask of a NUMA node.
+ * @node: target NUMA node
+ *
+ * Returns an empty cpumask if per-node idle tracking is not enabled, @node is
+ * invalid, or running on a UP kernel.
+ */
+__bpf_kfunc const struct cpumask *scx_bpf_get_idle_smtmask_node(int node)
+{
+	if (!check_builtin_idle_node(node))
+		return cpu_none_mask;
+
+#ifdef CONFIG_SMP
+	if (sched_smt_active())
+		return idle_node_masks[node]->smt;
+	else
+		return idle_node_masks[node]->cpu;
+#else
+	return cpu_none_mask;
+#endif
+}
+
 /**
  * scx_bpf_put_idle_cpumask - Release a previously acquired referenced kptr to
  * either the percpu, or SMT idle-tracking cpumask.
@@ -7607,7 +7801,26 @@ __bpf_kfunc s32 scx_bpf_pick_idle_cpu(const struct cpumask *cpus_allowed,
 	if (!check_builtin_idle_enabled())
 		return -EBUSY;
 
-	return scx_pick_idle_cpu(cpus_allowed, flags);
+	return scx_pick_idle_cpu(cpus_allowed, NUMA_NO_NODE, flags);
+}
+
+/**
+ * scx_bpf_pick_idle_cpu_node - Pick and claim an idle cpu, starting from a node
+ * @cpus_allowed: Allowed cpumask
+ * @node: NUMA node to search first
+ * @flags: %SCX_PICK_IDLE_CPU_* flags
+ *
+ * Like scx_bpf_pick_idle_cpu() but, with %SCX_OPS_BUILTIN_IDLE_PER_NODE, look
+ * in @node before the other nodes. With %SCX_PICK_IDLE_IN_NODE, only @node is
+ * searched.
+ */
+__bpf_kfunc s32 scx_bpf_pick_idle_cpu_node(const struct cpumask *cpus_allowed,
+					   int node, u64 flags)
+{
+	if (!check_builtin_idle_node(node))
+		return -EBUSY;
+
+	return scx_pick_idle_cpu(cpus_allowed, node, flags);
 }
 
 /**
@@ -7630,7 +7843,7 @@ __bpf_kfunc s32 scx_bpf_pick_any_cpu(const struct cpumask *cpus_allowed,
 	s32 cpu;
 
 	if (static_branch_likely(&scx_builtin_idle_enabled)) {
-		cpu = scx_pick_idle_cpu(cpus_allowed, flags);
+		cpu = scx_pick_idle_cpu(cpus_allowed, NUMA_NO_NODE, flags);
 		if (cpu >= 0)
 			return cpu;
 	}
@@ -7642,6 +7855,60 @@ __bpf_kfunc s32 scx_bpf_pick_any_cpu(const struct cpumask *cpus_allowed,
 		return -EBUSY;
 }
 
+/**
+ * scx_bpf_pick_any_cpu_node - Pick and claim an idle cpu if available, starting
+ * from a node, or pick any CPU
+ * @cpus_allowed: Allowed cpumask
+ * @node: NUMA node to search first
+ * @flags: %SCX_PICK_IDLE_CPU_* flags
+ *
+ * Like scx_bpf_pick_any_cpu() but looks for idle CPUs as
+ * scx_bpf_pick_idle_cpu_node() does. If none is found, a CPU of @node in
+ * @cpus_allowed is preferred, falling back to any CPU in @cpus_allowed unless
+ * %SCX_PICK_IDLE_IN_NODE is set.
+ */
+__bpf_kfunc s32 scx_bpf_pick_any_cpu_node(const struct cpumask *cpus_allowed,
+					  int node, u64 flags)
+{
+	s32 cpu;
+
+	if (node < 0 || node >= nr_node_ids || !node_possible(node)) {
+		scx_ops_error("invalid node %d", node);
+		return -EBUSY;
+	}
+
+	if (static_branch_likely(&scx_builtin_idle_enabled)) {
+		cpu = scx_pick_idle_cpu(cpus_allowed, node, flags);
+		if (cpu >= 0)
+			return cpu;
+	}
+
+	cpu = cpumask_any_and_distribute(cpumask_of_node(node), cpus_allowed);
+	if (cpu < nr_cpu_ids)
+		return cpu;
+
+	if (flags & SCX_PICK_IDLE_IN_NODE)
+		return -EBUSY;
+
+	cpu = cpumask_any_distribute(cpus_allowed);
+	if (cpu < nr_cpu_ids)
+		return cpu;
+	else
+		return -EBUSY;
+}
+
+/**
+ * scx_bpf_cpu_node - Return the NUMA node of a CPU
+ * @cpu: target CPU
+ */
+__bpf_kfunc int scx_bpf_cpu_node(s32 cpu)
+{
+	if (!ops_cpu_valid(cpu, NULL))
+		return NUMA_NO_NODE;
+
+	return cpu_to_node(cpu);
+}
+
 /**
  * scx_bpf_task_running - Is task currently running?
  * @p: task of interest
@@ -7783,10 +8050,15 @@ BTF_ID_FLAGS(func, scx_bpf_get_online_cpumask, KF_ACQUIRE)
 BTF_ID_FLAGS(func, scx_bpf_put_cpumask, KF_RELEASE)
 BTF_ID_FLAGS(func, scx_bpf_get_idle_cpumask, KF_ACQUIRE)
 BTF_ID_FLAGS(func, scx_bpf_get_idle_smtmask, KF_ACQUIRE)
+BTF_ID_FLAGS(func, scx_bpf_get_idle_cpumask_node, KF_ACQUIRE)
+BTF_ID_FLAGS(func, scx_bpf_get_idle_smtmask_node, KF_ACQUIRE)
 BTF_ID_FLAGS(func, scx_bpf_put_idle_cpumask, KF_RELEASE)
 BTF_ID_FLAGS(func, scx_bpf_test_and_clear_cpu_idle)
 BTF_ID_FLAGS(func, scx_bpf_pick_idle_cpu, KF_RCU)
+BTF_ID_FLAGS(func, scx_bpf_pick_idle_cpu_node, KF_RCU)
 BTF_ID_FLAGS(func, scx_bpf_pick_any_cpu, KF_RCU)
+BTF_ID_FLAGS(func, scx_bpf_pick_any_cpu_node, KF_RCU)
+BTF_ID_FLAGS(func, scx_bpf_cpu_node)
 BTF_ID_FLAGS(func, scx_bpf_task_running, KF_RCU)
 BTF_ID_FLAGS(func, scx_bpf_task_cpu, KF_RCU)
 BTF_ID_FLAGS(func, scx_bpf_cpu_rq)
@@ -129,7 +129,7 @@ static unsigned int sysctl_sched_cfs_bandwidth_slice		= 5000UL;
 
 #ifdef CONFIG_NUMA_BALANCING
 /* Restrict the NUMA promotion throughput (MB/s) for each target node. */
-static unsigned int sysctl_numa_balancing_promote_rate_limit = 65536;
+unsigned int sysctl_numa_balancing_promote_rate_limit = 65536;
 #endif
 
 #ifdef CONFIG_SYSCTL
@@ -998,6 +998,21 @@ int sched_update_scaling(void)
 
 static void clear_buddies(struct cfs_rq *cfs_rq, struct sched_entity *se);
 
+/*
+ * The request size of entities on @cfs_rq that didn't ask for one: the
+ * cpu.slice of the closest task group setting it, or sysctl_sched_base_slice.
+ */
+static inline u64 cfs_rq_default_slice(struct cfs_rq *cfs_rq)
+{
+#ifdef CONFIG_FAIR_GROUP_SCHED
+	u64 slice = READ_ONCE(cfs_rq->tg->slice);
+
+	if (slice)
+		return slice;
+#endif
+	return sysctl_sched_base_slice;
+}
+
 /*
  * XXX: strictly: vd_i += N*r_i/w_i such that: vd_i > ve_i
  * this is probably good enough.
@@ -1010,10 +1025,10 @@ static bool update_deadline(struct cfs_rq *cfs_rq, struct sched_entity *se)
 	/*
 	 * For EEVDF the virtual time slope is determined by w_i (iow.
 	 * nice) while the request time r_i is determined by
-	 * sysctl_sched_base_slice.
+	 * sysctl_sched_base_slice, or the group's cpu.slice.
 	 */
 	if (!se->custom_slice)
-		se->slice = sysctl_sched_base_slice;
+		se->slice = cfs_rq_default_slice(cfs_rq);
 
 	/*
 	 * EEVDF: vd_i = ve_i + r_i / w_i
@@ -3468,7 +3483,10 @@ static void task_numa_work(struct callback_head *work)
 			start = max(start, vma->vm_start);
 			end = ALIGN(start + (pages << PAGE_SHIFT), HPAGE_SIZE);
 			end = min(end, vma->vm_end);
-			nr_pte_updates = change_prot_numa(vma, start, end);
+			if (sysctl_numa_balancing_mode & NUMA_BALANCING_ACCESS_BIT)
+				nr_pte_updates = numa_scan_young(vma, start, end);
+			else
+				nr_pte_updates = change_prot_numa(vma, start, end);
 
 			/*
 			 * Try to scan sysctl_numa_balancing_size worth of
@@ -5188,7 +5206,7 @@ place_entity(struct cfs_rq *cfs_rq, struct sched_entity *se, int flags)
 	s64 lag = 0;
 
 	if (!se->custom_slice)
-		se->slice = sysctl_sched_base_slice;
+		se->slice = cfs_rq_default_slice(cfs_rq);
 	vslice = calc_delta_fair(se->slice, se);
 
 	/*
@@ -7543,13 +7561,23 @@ static inline int __select_idle_cpu(int cpu, struct task_struct *p)
 DEFINE_STATIC_KEY_FALSE(sched_smt_present);
 EXPORT_SYMBOL_GPL(sched_smt_present);
 
-static inline void set_idle_cores(int cpu, int val)
+/*
+ * Mark @core, named by any of its SMT siblings, as wholly idle or not in its
+ * LLC's idle core mask. Test first to keep the shared cachelines clean.
+ */
+static inline void set_idle_core(int core, bool idle)
 {
 	struct sched_domain_shared *sds;
+	int first = cpumask_first(cpu_smt_mask(core));
 
-	sds = rcu_dereference(per_cpu(sd_llc_shared, cpu));
-	if (sds)
-		WRITE_ONCE(sds->has_idle_cores, val);
+	sds = rcu_dereference(per_cpu(sd_llc_shared, core));
+	if (!sds || cpumask_test_cpu(first, sds_idle_cores(sds)) == idle)
+		return;
+
+	if (idle)
+		cpumask_set_cpu(first, sds_idle_cores(sds));
+	else
+		cpumask_clear_cpu(first, sds_idle_cores(sds));
 }
 
 static inline bool test_idle_cores(int cpu)
@@ -7558,14 +7586,14 @@ static inline bool test_idle_cores(int cpu)
 
 	sds = rcu_dereference(per_cpu(sd_llc_shared, cpu));
 	if (sds)
-		return READ_ONCE(sds->has_idle_cores);
+		return !cpumask_empty(sds_idle_cores(sds));
 
 	return false;
 }
 
 /*
  * Scans the local SMT mask to see if the entire core is idle, and records this
- * information in sd_llc_shared->has_idle_cores.
+ * information in sd_llc_shared->idle_cores.
  *
  * Since SMT siblings share all cache levels, inspecting this limited remote
  * state should be fairly cheap.
@@ -7576,9 +7604,6 @@ void __update_idle_core(struct rq *rq)
 	int cpu;
 
 	rcu_read_lock();
-	if (test_idle_cores(core))
-		goto unlock;
-
 	for_each_cpu(cpu, cpu_smt_mask(core)) {
 		if (cpu == core)
 			continue;
@@ -7587,15 +7612,23 @@ void __update_idle_core(struct rq *rq)
 			goto unlock;
 	}
 
-	set_idle_cores(core, 1);
+	set_idle_core(core, true);
 unlock:
 	rcu_read_unlock();
 }
 
+/* The core stops being wholly idle when any of its siblings leaves idle. */
+void __update_idle_core_exit(struct rq *rq)
+{
+	rcu_read_lock();
+	set_idle_core(cpu_of(rq), false);
+	rcu_read_unlock();
+}
+
 /*
  * Scan the entire LLC domain for idle cores; this dynamically switches off if
  * there are no idle cores left in the system; tracked through
- * sd_llc->shared->has_idle_cores and enabled through update_idle_core() above.
+ * sd_llc->shared->idle_cores and enabled through update_idle_core() above.
  */
 static int select_idle_core(struct task_struct *p, int core, struct cpumask *cpus, int *idle_cpu)
 {
@@ -7625,6 +7658,30 @@ static int select_idle_core(struct task_struct *p, int core, struct cpumask *cpu
 	return -1;
 }
 
+/*
+ * Visit the cores listed in the LLC's idle core mask, starting next to
+ * @target, and drop the entries that turn out stale.
+ */
+static int select_idle_cores(struct task_struct *p, struct sched_domain_shared *sds,
+			     struct cpumask *cpus, int target, int *idle_cpu)
+{
+	int core, cpu;
+
+	for_each_cpu_wrap(core, sds_idle_cores(sds), target + 1) {
+		cpu = cpumask_first_and(cpu_smt_mask(core), cpus);
+		if (cpu >= nr_cpumask_bits)
+			continue;
+
+		cpu = select_idle_core(p, cpu, cpus, idle_cpu);
+		if ((unsigned int)cpu < nr_cpumask_bits)
+			return cpu;
+
+		set_idle_core(core, false);
+	}
+
+	return -1;
+}
+
 /*
  * Scan the local SMT mask for idle CPUs.
  */
@@ -7650,10 +7707,16 @@ static int select_idle_smt(struct task_struct *p, struct sched_domain *sd, int t
 
 #else /* CONFIG_SCHED_SMT */
 
-static inline void set_idle_cores(int cpu, int val)
+static inline void set_idle_core(int core, bool idle)
 {
 }
 
+static inline int select_idle_cores(struct task_struct *p, struct sched_domain_shared *sds,
+				    struct cpumask *cpus, int target, int *idle_cpu)
+{
+	return -1;
+}
+
 static inline bool test_idle_cores(int cpu)
 {
 	return false;
@@ -7683,9 +7746,9 @@ static int select_idle_cpu(struct task_struct *p, struct sched_domain *sd, bool
 	struct sched_domain_shared *sd_share;
 
 	cpumask_and(cpus, sched_domain_span(sd), p->cpus_ptr);
+	sd_share = rcu_dereference(per_cpu(sd_llc_shared, target));
 
 	if (sched_feat(SIS_UTIL)) {
-		sd_share = rcu_dereference(per_cpu(sd_llc_shared, target));
 		if (sd_share) {
 			/* because !--nr is the condition to stop scan */
 			nr = READ_ONCE(sd_share->nr_idle_scan) + 1;
@@ -7695,6 +7758,23 @@ static int select_idle_cpu(struct task_struct *p, struct sched_domain *sd, bool
 		}
 	}
 
+	/*
+	 * Only visit the cores the LLC's idle core mask lists instead of
+	 * scanning the whole span. If none of them is idle anymore, fall back
+	 * to the regular scan for an idle CPU.
+	 */
+	if (has_idle_core && sd_share) {
+		i = select_idle_cores(p, sd_share, cpus, target, &idle_cpu);
+		if ((unsigned int)i < nr_cpumask_bits)
+			return i;
+
+		if ((unsigned int)idle_cpu < nr_cpumask_bits)
+			return idle_cpu;
+
+		has_idle_core = false;
+		cpumask_and(cpus, sched_domain_span(sd), p->cpus_ptr);
+	}
+
 	if (static_branch_unlikely(&sched_cluster_active)) {
 		struct sched_group *sg = sd->groups;
 
@@ -7734,9 +7814,6 @@ static int select_idle_cpu(struct task_struct *p, struct sched_domain *sd, bool
 		}
 	}
 
-	if (has_idle_core)
-		set_idle_cores(target, false);
-
 	return idle_cpu;
 }
 
@@ -11747,6 +11824,14 @@ static int sched_balance_rq(int this_cpu, struct rq *this_rq,
 	group = sched_balance_find_src_group(&env);
 	if (!group) {
 		schedstat_inc(sd->lb_nobusyg[idle]);
+		/*
+		 * The group statistics just computed say there is nothing to
+		 * pull, which won't change much before the next short idle.
+		 */
+		if (idle == CPU_NEWLY_IDLE)
+			WRITE_ONCE(sd->newidle_balanced_until,
+				   sched_clock_cpu(this_cpu) +
+				   (sysctl_sched_migration_cost >> 1));
 		goto out_balanced;
 	}
 
@@ -12824,6 +12909,15 @@ static int sched_balance_newidle(struct rq *this_rq, struct rq_flags *rf)
 			break;
 
 		if (sd->flags & SD_BALANCE_NEWIDLE) {
+			/*
+			 * Recently found balanced, don't recompute the group
+			 * statistics of the whole domain yet.
+			 */
+			if (sched_feat(NEWIDLE_CACHE) &&
+			    (s64)(t0 - READ_ONCE(sd->newidle_balanced_until)) < 0) {
+				schedstat_inc(sd->newidle_lb_skipped);
+				continue;
+			}
 
 			pulled_task = sched_balance_rq(this_cpu, this_rq,
 						   sd, CPU_NEWLY_IDLE,
@@ -12832,6 +12926,7 @@ static int sched_balance_newidle(struct rq *this_rq, struct rq_flags *rf)
 			t1 = sched_clock_cpu(this_cpu);
 			domain_cost = t1 - t0;
 			update_newidle_cost(sd, domain_cost);
+			schedstat_add(sd->newidle_lb_cost, domain_cost);
 
 			curr_cost += domain_cost;
 			t0 = t1;
@@ -13344,6 +13439,7 @@ int alloc_fair_sched_group(struct task_group *tg, struct task_group *parent)
 		goto err;
 
 	tg->shares = NICE_0_LOAD;
+	tg->slice = parent->slice;
 
 	init_cfs_bandwidth(tg_cfs_bandwidth(tg), tg_cfs_bandwidth(parent));
 
@@ -13571,6 +13667,36 @@ int sched_group_set_idle(struct task_group *tg, long idle)
 	return 0;
 }
 
+static int tg_set_slice_down(struct task_group *tg, void *data)
+{
+	WRITE_ONCE(tg->slice, tg->slice_req ?: tg->parent->slice);
+	return 0;
+}
+
+/*
+ * Set the default slice of @tg's tasks, zero to inherit the parent's. It is
+ * picked up at their next deadline update, tasks with a sched_attr slice keep
+ * theirs.
+ */
+int sched_group_set_slice(struct task_group *tg, u64 slice)
+{
+	if (tg == &root_task_group)
+		return -EINVAL;
+
+	/* Same bounds as sched_attr::sched_runtime, see __setparam_fair() */
+	if (slice && (slice < NSEC_PER_MSEC / 10 || slice > NSEC_PER_MSEC * 100))
+		return -EINVAL;
+
+	mutex_lock(&shares_mutex);
+	tg->slice_req = slice;
+	rcu_read_lock();
+	walk_tg_tree_from(tg, tg_set_slice_down, tg_nop, NULL);
+	rcu_read_unlock();
+	mutex_unlock(&shares_mutex);
+
+	return 0;
+}
+
 #endif /* CONFIG_FAIR_GROUP_SCHED */
 
 
@@ -109,6 +109,12 @@ SCHED_FEAT(RT_PUSH_IPI, true)
 
 SCHED_FEAT(RT_RUNTIME_SHARE, false)
 SCHED_FEAT(LB_MIN, false)
+
+/*
+ * Skip newidle balancing of a domain for half of sysctl_sched_migration_cost
+ * after it last found no busier group to pull from.
+ */
+SCHED_FEAT(NEWIDLE_CACHE, true)
 SCHED_FEAT(ATTACH_AGE_LOAD, true)
 
 SCHED_FEAT(WA_IDLE, true)
@@ -311,8 +311,56 @@ static int membarrier_global_expedited(void)
 	return 0;
 }
 
+/*
+ * Concurrent MEMBARRIER_CMD_PRIVATE_EXPEDITED callers on a mm are batched on
+ * @mm->membarrier_seq, in the manner of RCU grace-period sequences: a caller
+ * takes a snapshot after its entry barrier, and once it holds the IPI mutex,
+ * it is done if a whole round started after that snapshot has completed in
+ * the meantime. With many threads issuing membarriers at once, each of them
+ * thus waits for at most two rounds instead of all the queued ones.
+ */
+static unsigned long membarrier_seq_snap(struct mm_struct *mm)
+{
+	return (READ_ONCE(mm->membarrier_seq) + 3) & ~1UL;
+}
+
+static bool membarrier_seq_done(struct mm_struct *mm, unsigned long snap)
+{
+	return (long)(READ_ONCE(mm->membarrier_seq) - snap) >= 0;
+}
+
+static void membarrier_seq_start(struct mm_struct *mm)
+{
+	WRITE_ONCE(mm->membarrier_seq, mm->membarrier_seq + 1);
+	/* Order the start of the round before reading rq->curr. */
+	smp_mb();
+}
+
+static void membarrier_seq_end(struct mm_struct *mm)
+{
+	/* Order the completed IPIs before the end of the round. */
+	smp_mb();
+	WRITE_ONCE(mm->membarrier_seq, mm->membarrier_seq + 1);
+}
+
+/*
+ * Threads without a registered rseq area cannot be in a critical section, so
+ * the RSEQ command leaves their CPUs alone. The registration is ordered
+ * before any critical section by sys_rseq().
+ */
+static bool membarrier_rseq_target(struct task_struct *p)
+{
+#ifdef CONFIG_RSEQ
+	return READ_ONCE(p->rseq);
+#else
+	return true;
+#endif
+}
+
 static int membarrier_private_expedited(int flags, int cpu_id)
 {
+	bool batch = !flags && cpu_id < 0;
+	unsigned long snap = 0;
 	cpumask_var_t tmpmask;
 	struct mm_struct *mm = current->mm;
 	smp_call_func_t ipi_func = ipi_mb;
@@ -353,10 +401,21 @@ static int membarrier_private_expedited(int flags, int cpu_id)
 	 */
 	smp_mb();	/* system call entry is not a mb. */
 
+	if (batch)
+		snap = membarrier_seq_snap(mm);
+
 	if (cpu_id < 0 && !zalloc_cpumask_var(&tmpmask, GFP_KERNEL))
 		return -ENOMEM;
 
 	SERIALIZE_IPI();
+	if (batch) {
+		if (membarrier_seq_done(mm, snap)) {
+			free_cpumask_var(tmpmask);
+			smp_mb();	/* exit from system call is not a mb */
+			return 0;
+		}
+		membarrier_seq_start(mm);
+	}
 	cpus_read_lock();
 
 	if (cpu_id >= 0) {
@@ -379,8 +438,12 @@ static int membarrier_private_expedited(int flags, int cpu_id)
 			struct task_struct *p;
 
 			p = rcu_dereference(cpu_rq(cpu)->curr);
-			if (p && p->mm == mm)
-				__cpumask_set_cpu(cpu, tmpmask);
+			if (!p || p->mm != mm)
+				continue;
+			if (flags == MEMBARRIER_FLAG_RSEQ &&
+			    !membarrier_rseq_target(p))
+				continue;
+			__cpumask_set_cpu(cpu, tmpmask);
 		}
 		rcu_read_unlock();
 	}
@@ -422,6 +485,8 @@ static int membarrier_private_expedited(int flags, int cpu_id)
 	if (cpu_id < 0)
 		free_cpumask_var(tmpmask);
 	cpus_read_unlock();
+	if (batch)
+		membarrier_seq_end(mm);
 
 	/*
 	 * Memory barrier on the caller thread _after_ we finished
@@ -181,6 +181,7 @@ static void group_init(struct psi_group *group)
 	int cpu;
 
 	group->enabled = true;
+	group->aggregate = true;
 	for_each_possible_cpu(cpu)
 		seqcount_init(&per_cpu_ptr(group->pcpu, cpu)->seq);
 	group->avg_last_update = sched_clock();
@@ -1100,6 +1101,14 @@ void psi_memstall_leave(unsigned long *flags)
 EXPORT_SYMBOL_GPL(psi_memstall_leave);
 
 #ifdef CONFIG_CGROUPS
+/* The group the children of @cgrp account into */
+static struct psi_group *psi_aggregate_group(struct cgroup *cgrp)
+{
+	struct psi_group *group = cgroup_psi(cgrp);
+
+	return group->aggregate ? group : group->parent;
+}
+
 int psi_cgroup_alloc(struct cgroup *cgroup)
 {
 	if (!static_branch_likely(&psi_cgroups_enabled))
@@ -1115,7 +1124,7 @@ int psi_cgroup_alloc(struct cgroup *cgroup)
 		return -ENOMEM;
 	}
 	group_init(cgroup->psi);
-	cgroup->psi->parent = cgroup_psi(cgroup_parent(cgroup));
+	cgroup->psi->parent = psi_aggregate_group(cgroup_parent(cgroup));
 	return 0;
 }
 
@@ -1229,6 +1238,36 @@ void psi_cgroup_restart(struct psi_group *group)
 		rq_unlock_irq(rq, &rf);
 	}
 }
+
+/**
+ * psi_cgroup_set_aggregate - account descendants of a cgroup in its PSI or not
+ * @cgrp: the cgroup
+ * @aggregate: whether descendants should be accounted in @cgrp
+ *
+ * Relink the PSI groups of the descendants of @cgrp to @cgrp or past it.
+ * The caller must hold cgroup_mutex and make sure that @cgrp has no
+ * task, so that no task counts need to be moved between groups.
+ */
+void psi_cgroup_set_aggregate(struct cgroup *cgrp, bool aggregate)
+{
+	struct cgroup_subsys_state *css;
+
+	lockdep_assert_held(&cgroup_mutex);
+
+	if (!static_branch_likely(&psi_cgroups_enabled))
+		return;
+
+	cgroup_psi(cgrp)->aggregate = aggregate;
+
+	rcu_read_lock();
+	css_for_each_descendant_pre(css, &cgrp->self) {
+		if (css == &cgrp->self)
+			continue;
+		WRITE_ONCE(css->cgroup->psi->parent,
+			   psi_aggregate_group(cgroup_parent(css->cgroup)));
+	}
+	rcu_read_unlock();
+}
 #endif /* CONFIG_CGROUPS */
 
 int psi_show(struct seq_file *m, struct psi_group *group, enum psi_res res)
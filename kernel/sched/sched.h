@@ -437,6 +437,11 @@ struct cfs_bandwidth {
 struct task_group {
 	struct cgroup_subsys_state css;
 
+#ifdef CONFIG_SCHED_LATENCY_HIST
+	/* per-CPU runqueue latency histogram, NULL for the root group */
+	u64 __percpu		*lat_hist;
+#endif
+
 #ifdef CONFIG_GROUP_SCHED_WEIGHT
 	/* A positive value indicates that this is a SCHED_IDLE group. */
 	int			idle;
@@ -448,6 +453,13 @@ struct task_group {
 	/* runqueue "owned" by this group on each CPU */
 	struct cfs_rq		**cfs_rq;
 	unsigned long		shares;
+	/*
+	 * Default request size of the group's tasks: slice_req as set through
+	 * cpu.slice, zero to inherit, and the effective value, zero for
+	 * sysctl_sched_base_slice.
+	 */
+	u64			slice_req;
+	u64			slice;
 #ifdef	CONFIG_SMP
 	/*
 	 * load_avg can be heavily contended at clock tick time, so put
@@ -579,6 +591,8 @@ extern int sched_group_set_shares(struct task_group *tg, unsigned long shares);
 
 extern int sched_group_set_idle(struct task_group *tg, long idle);
 
+extern int sched_group_set_slice(struct task_group *tg, u64 slice);
+
 #ifdef CONFIG_SMP
 extern void set_task_rq_fair(struct sched_entity *se,
 			     struct cfs_rq *prev, struct cfs_rq *next);
@@ -589,6 +603,7 @@ static inline void set_task_rq_fair(struct sched_entity *se,
 #else /* !CONFIG_FAIR_GROUP_SCHED */
 static inline int sched_group_set_shares(struct task_group *tg, unsigned long shares) { return 0; }
 static inline int sched_group_set_idle(struct task_group *tg, long idle) { return 0; }
+static inline int sched_group_set_slice(struct task_group *tg, u64 slice) { return 0; }
 #endif /* CONFIG_FAIR_GROUP_SCHED */
 
 #else /* CONFIG_CGROUP_SCHED */
@@ -1556,6 +1571,7 @@ do {						\
 
 #ifdef CONFIG_SCHED_SMT
 extern void __update_idle_core(struct rq *rq);
+extern void __update_idle_core_exit(struct rq *rq);
 
 static inline void update_idle_core(struct rq *rq)
 {
@@ -1563,8 +1579,15 @@ static inline void update_idle_core(struct rq *rq)
 		__update_idle_core(rq);
 }
 
+static inline void update_idle_core_exit(struct rq *rq)
+{
+	if (static_branch_unlikely(&sched_smt_present))
+		__update_idle_core_exit(rq);
+}
+
 #else
 static inline void update_idle_core(struct rq *rq) { }
+static inline void update_idle_core_exit(struct rq *rq) { }
 #endif
 
 #ifdef CONFIG_FAIR_GROUP_SCHED
@@ -2266,6 +2289,7 @@ static const_debug __maybe_unused unsigned int sysctl_sched_features =
 
 extern struct static_key_false sched_numa_balancing;
 extern struct static_key_false sched_schedstats;
+extern struct static_key_false sched_lat_hist;
 
 static inline u64 global_rt_period(void)
 {
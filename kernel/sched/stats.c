@@ -97,6 +97,112 @@ void __update_stats_enqueue_sleeper(struct rq *rq, struct task_struct *p,
 	}
 }
 
+#ifdef CONFIG_SCHED_LATENCY_HIST
+/*
+ * Runqueue latencies are counted in log-linear buckets of 1024ns units: the
+ * first 8 buckets are one unit wide, then each power of two is split into
+ * SCHED_LAT_SUB buckets, which bounds the error of a reported percentile to
+ * 25%. Everything above the range lands in the last bucket.
+ */
+#define SCHED_LAT_UNIT_SHIFT	10
+#define SCHED_LAT_SUB_BITS	2
+#define SCHED_LAT_SUB		(1U << SCHED_LAT_SUB_BITS)
+
+static unsigned int sched_lat_bucket(u64 delta)
+{
+	u64 v = delta >> SCHED_LAT_UNIT_SHIFT;
+	unsigned int shift, idx;
+
+	if (v < 2 * SCHED_LAT_SUB)
+		return v;
+
+	shift = fls64(v) - 1 - SCHED_LAT_SUB_BITS;
+	idx = (shift + 1) * SCHED_LAT_SUB + (v >> shift) - SCHED_LAT_SUB;
+
+	return min(idx, SCHED_LAT_NR_BUCKETS - 1);
+}
+
+/* Lowest latency, in ns, counted by bucket @idx */
+static u64 sched_lat_bucket_start(unsigned int idx)
+{
+	u64 v = idx;
+
+	if (idx >= 2 * SCHED_LAT_SUB) {
+		unsigned int shift = idx / SCHED_LAT_SUB - 1;
+
+		v = (u64)(SCHED_LAT_SUB + idx % SCHED_LAT_SUB) << shift;
+	}
+
+	return v << SCHED_LAT_UNIT_SHIFT;
+}
+
+/*
+ * Called with the rq lock held as @t gets on the CPU. Only the group @t
+ * directly belongs to is accounted, readers sum up the descendants.
+ */
+void __sched_lat_hist_account(struct task_struct *t, u64 delta)
+{
+	unsigned int idx = sched_lat_bucket(delta);
+#ifdef CONFIG_CGROUP_SCHED
+	struct task_group *tg = task_group(t);
+
+	if (tg->lat_hist)
+		__this_cpu_inc(tg->lat_hist[idx]);
+#endif
+	t->sched_info.run_delay_hist[idx]++;
+}
+
+/*
+ * Print the number of samples, a few percentiles as the upper bound of the
+ * bucket they fall in, and the non-empty buckets as "<start ns> <count>".
+ */
+void sched_lat_hist_seq_show(struct seq_file *m, const u64 *hist)
+{
+	static const unsigned int permille[] = { 500, 900, 990, 999 };
+	static const char * const names[] = { "p50", "p90", "p99", "p999" };
+	u64 total = 0, sum = 0;
+	unsigned int i, p = 0;
+
+	for (i = 0; i < SCHED_LAT_NR_BUCKETS; i++)
+		total += hist[i];
+
+	seq_printf(m, "count %llu\n", total);
+
+	for (i = 0; i < SCHED_LAT_NR_BUCKETS && p < ARRAY_SIZE(permille); i++) {
+		sum += hist[i];
+		while (total && p < ARRAY_SIZE(permille) &&
+		       sum * 1000 >= total * permille[p]) {
+			seq_printf(m, "%s_ns %llu\n", names[p],
+				   sched_lat_bucket_start(min(i + 1, SCHED_LAT_NR_BUCKETS - 1)));
+			p++;
+		}
+	}
+	for (; p < ARRAY_SIZE(permille); p++)
+		seq_printf(m, "%s_ns 0\n", names[p]);
+
+	for (i = 0; i < SCHED_LAT_NR_BUCKETS; i++) {
+		if (hist[i])
+			seq_printf(m, "%llu %llu\n", sched_lat_bucket_start(i), hist[i]);
+	}
+}
+
+void proc_sched_lat_show_task(struct task_struct *p, struct seq_file *m)
+{
+	u64 *hist;
+	int i;
+
+	hist = kcalloc(SCHED_LAT_NR_BUCKETS, sizeof(*hist), GFP_KERNEL);
+	if (!hist)
+		return;
+
+	for (i = 0; i < SCHED_LAT_NR_BUCKETS; i++)
+		hist[i] = READ_ONCE(p->sched_info.run_delay_hist[i]);
+
+	sched_lat_hist_seq_show(m, hist);
+	kfree(hist);
+}
+#endif /* CONFIG_SCHED_LATENCY_HIST */
+
 /*
  * Current schedstat API version.
  *
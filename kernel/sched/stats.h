@@ -255,6 +255,19 @@ static inline void sched_info_dequeue(struct rq *rq, struct task_struct *t)
 	rq_sched_info_dequeue(rq, delta);
 }
 
+#ifdef CONFIG_SCHED_LATENCY_HIST
+extern void __sched_lat_hist_account(struct task_struct *t, u64 delta);
+extern void sched_lat_hist_seq_show(struct seq_file *m, const u64 *hist);
+
+static inline void sched_lat_hist_account(struct task_struct *t, u64 delta)
+{
+	if (static_branch_unlikely(&sched_lat_hist))
+		__sched_lat_hist_account(t, delta);
+}
+#else
+static inline void sched_lat_hist_account(struct task_struct *t, u64 delta) { }
+#endif
+
 /*
  * Called when a task finally hits the CPU.  We can now calculate how
  * long it was waiting to run.  We also note when it began so that we
@@ -278,6 +291,7 @@ static void sched_info_arrive(struct rq *rq, struct task_struct *t)
 	if (delta && (!t->sched_info.min_run_delay || delta < t->sched_info.min_run_delay))
 		t->sched_info.min_run_delay = delta;
 
+	sched_lat_hist_account(t, delta);
 	rq_sched_info_arrive(rq, delta);
 }
 
@@ -2254,7 +2254,7 @@ static int __sdt_alloc(const struct cpumask *cpu_map)
 
 			*per_cpu_ptr(sdd->sd, j) = sd;
 
-			sds = kzalloc_node(sizeof(struct sched_domain_shared),
+			sds = kzalloc_node(sizeof(struct sched_domain_shared) + cpumask_size(),
 					GFP_KERNEL, cpu_to_node(j));
 			if (!sds)
 				return -ENOMEM;
@@ -2654,6 +2654,35 @@ static int dattrs_equal(struct sched_domain_attr *cur, int idx_cur,
 			sizeof(struct sched_domain_attr));
 }
 
+/* Whether doms_new[] describes the current partitioning */
+static bool doms_unchanged(int ndoms_new, cpumask_var_t doms_new[],
+			   struct sched_domain_attr *dattr_new)
+{
+	int i, j;
+
+	if (!doms_new || ndoms_new != ndoms_cur)
+		return false;
+
+#if defined(CONFIG_ENERGY_MODEL) && defined(CONFIG_CPU_FREQ_GOV_SCHEDUTIL)
+	if (sched_energy_update)
+		return false;
+#endif
+
+	/* The masks don't overlap, so matching each new one is enough */
+	for (i = 0; i < ndoms_new; i++) {
+		for (j = 0; j < ndoms_cur; j++) {
+			if (cpumask_equal(doms_new[i], doms_cur[j]) &&
+			    dattrs_equal(dattr_new, i, dattr_cur, j))
+				goto match;
+		}
+		return false;
+match:
+		;
+	}
+
+	return true;
+}
+
 /*
  * Partition sched domains as specified by the 'ndoms_new'
  * cpumasks in the array doms_new[] of cpumasks. This compares
@@ -2678,9 +2707,12 @@ static int dattrs_equal(struct sched_domain_attr *cur, int idx_cur,
  * ndoms_new == 0 is a special case for destroying existing domains,
  * and it will not create the default domain.
  *
+ * Returns false if doms_new[] matches the current partitioning and nothing
+ * was done at all, so that callers can skip their own accounting rebuild.
+ *
  * Call with hotplug lock and sched_domains_mutex held
  */
-void partition_sched_domains_locked(int ndoms_new, cpumask_var_t doms_new[],
+bool partition_sched_domains_locked(int ndoms_new, cpumask_var_t doms_new[],
 				    struct sched_domain_attr *dattr_new)
 {
 	bool __maybe_unused has_eas = false;
@@ -2695,6 +2727,12 @@ void partition_sched_domains_locked(int ndoms_new, cpumask_var_t doms_new[],
 	if (new_topology)
 		asym_cpu_capacity_scan();
 
+	if (!new_topology && doms_unchanged(ndoms_new, doms_new, dattr_new)) {
+		free_sched_domains(doms_new, ndoms_new);
+		kfree(dattr_new);
+		return false;
+	}
+
 	if (!doms_new) {
 		WARN_ON_ONCE(dattr_new);
 		n = 0;
@@ -2783,6 +2821,8 @@ void partition_sched_domains_locked(int ndoms_new, cpumask_var_t doms_new[],
 	ndoms_cur = ndoms_new;
 
 	update_sched_domain_debugfs();
+
+	return true;
 }
 
 /*
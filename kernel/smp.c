@@ -26,6 +26,9 @@
 #include <linux/sched/debug.h>
 #include <linux/jump_label.h>
 #include <linux/string_choices.h>
+#include <linux/debugfs.h>
+#include <linux/hash.h>
+#include <linux/seq_file.h>
 
 #include <trace/events/ipi.h>
 #define CREATE_TRACE_POINTS
@@ -41,6 +44,7 @@ struct call_function_data {
 	call_single_data_t	__percpu *csd;
 	cpumask_var_t		cpumask;
 	cpumask_var_t		cpumask_ipi;
+	cpumask_var_t		cpumask_batch;
 };
 
 static DEFINE_PER_CPU_ALIGNED(struct call_function_data, cfd_data);
@@ -63,10 +67,17 @@ int smpcfd_prepare_cpu(unsigned int cpu)
 		free_cpumask_var(cfd->cpumask);
 		return -ENOMEM;
 	}
+	if (!zalloc_cpumask_var_node(&cfd->cpumask_batch, GFP_KERNEL,
+				     cpu_to_node(cpu))) {
+		free_cpumask_var(cfd->cpumask);
+		free_cpumask_var(cfd->cpumask_ipi);
+		return -ENOMEM;
+	}
 	cfd->csd = alloc_percpu(call_single_data_t);
 	if (!cfd->csd) {
 		free_cpumask_var(cfd->cpumask);
 		free_cpumask_var(cfd->cpumask_ipi);
+		free_cpumask_var(cfd->cpumask_batch);
 		return -ENOMEM;
 	}
 
@@ -79,6 +90,7 @@ int smpcfd_dead_cpu(unsigned int cpu)
 
 	free_cpumask_var(cfd->cpumask);
 	free_cpumask_var(cfd->cpumask_ipi);
+	free_cpumask_var(cfd->cpumask_batch);
 	free_percpu(cfd->csd);
 	return 0;
 }
@@ -773,6 +785,75 @@ int smp_call_function_any(const struct cpumask *mask,
 }
 EXPORT_SYMBOL_GPL(smp_call_function_any);
 
+#ifdef CONFIG_SMP_CALL_STATS
+/*
+ * Cross-CPU function calls and the number of CPUs interrupted for them,
+ * accounted per calling site in an open-addressed hash table, to find the
+ * noisiest senders of IPIs. Entries are never removed.
+ */
+#define SMP_CALL_STATS_BITS	8
+
+struct smp_call_stat {
+	unsigned long	caller;
+	atomic_long_t	calls;
+	atomic_long_t	cpus;
+};
+
+static struct smp_call_stat smp_call_stats[1 << SMP_CALL_STATS_BITS];
+static atomic_long_t smp_call_stats_dropped;
+
+static void smp_call_account(unsigned long caller, unsigned int nr_cpus)
+{
+	unsigned int i, hash = hash_long(caller, SMP_CALL_STATS_BITS);
+
+	for (i = 0; i < ARRAY_SIZE(smp_call_stats); i++) {
+		struct smp_call_stat *stat;
+		unsigned long old;
+
+		stat = &smp_call_stats[(hash + i) & (ARRAY_SIZE(smp_call_stats) - 1)];
+		old = READ_ONCE(stat->caller);
+		if (!old)
+			old = cmpxchg(&stat->caller, 0, caller) ?: caller;
+		if (old != caller)
+			continue;
+
+		atomic_long_inc(&stat->calls);
+		atomic_long_add(nr_cpus, &stat->cpus);
+		return;
+	}
+	atomic_long_inc(&smp_call_stats_dropped);
+}
+
+static int smp_call_stats_show(struct seq_file *m, void *v)
+{
+	unsigned int i;
+
+	seq_puts(m, "calls cpus caller\n");
+	for (i = 0; i < ARRAY_SIZE(smp_call_stats); i++) {
+		struct smp_call_stat *stat = &smp_call_stats[i];
+		unsigned long caller = READ_ONCE(stat->caller);
+
+		if (!caller)
+			continue;
+		seq_printf(m, "%ld %ld %pS\n", atomic_long_read(&stat->calls),
+			   atomic_long_read(&stat->cpus), (void *)caller);
+	}
+	seq_printf(m, "dropped: %ld\n", atomic_long_read(&smp_call_stats_dropped));
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(smp_call_stats);
+
+static int __init smp_call_stats_init(void)
+{
+	debugfs_create_file("smp_call_stats", 0400, NULL, NULL,
+			    &smp_call_stats_fops);
+	return 0;
+}
+late_initcall(smp_call_stats_init);
+#else
+static inline void smp_call_account(unsigned long caller, unsigned int nr_cpus) { }
+#endif
+
 /*
  * Flags to be used as scf_flags argument of smp_call_function_many_cond().
  *
@@ -785,7 +866,8 @@ EXPORT_SYMBOL_GPL(smp_call_function_any);
 static void smp_call_function_many_cond(const struct cpumask *mask,
 					smp_call_func_t func, void *info,
 					unsigned int scf_flags,
-					smp_cond_func_t cond_func)
+					smp_cond_func_t cond_func,
+					unsigned long caller)
 {
 	int cpu, last_cpu, this_cpu = smp_processor_id();
 	struct call_function_data *cfd;
@@ -867,6 +949,8 @@ static void smp_call_function_many_cond(const struct cpumask *mask,
 			send_call_function_single_ipi(last_cpu);
 		else if (likely(nr_cpus > 1))
 			send_call_function_ipi_mask(cfd->cpumask_ipi);
+
+		smp_call_account(caller, nr_cpus);
 	}
 
 	if (run_local) {
@@ -906,7 +990,8 @@ static void smp_call_function_many_cond(const struct cpumask *mask,
 void smp_call_function_many(const struct cpumask *mask,
 			    smp_call_func_t func, void *info, bool wait)
 {
-	smp_call_function_many_cond(mask, func, info, wait * SCF_WAIT, NULL);
+	smp_call_function_many_cond(mask, func, info, wait * SCF_WAIT, NULL,
+				    _RET_IP_);
 }
 EXPORT_SYMBOL(smp_call_function_many);
 
@@ -1049,11 +1134,101 @@ void on_each_cpu_cond_mask(smp_cond_func_t cond_func, smp_call_func_t func,
 		scf_flags |= SCF_WAIT;
 
 	preempt_disable();
-	smp_call_function_many_cond(mask, func, info, scf_flags, cond_func);
+	smp_call_function_many_cond(mask, func, info, scf_flags, cond_func,
+				    _RET_IP_);
 	preempt_enable();
 }
 EXPORT_SYMBOL(on_each_cpu_cond_mask);
 
+static void smp_call_batch_func(void *info)
+{
+	struct smp_call_batch *batch = info;
+	int cpu = smp_processor_id();
+	unsigned int i;
+
+	for (i = 0; i < batch->nr; i++) {
+		if (cpumask_test_cpu(cpu, batch->calls[i].mask))
+			batch->calls[i].func(batch->calls[i].info);
+	}
+}
+
+static void __on_each_cpu_batch_flush(struct smp_call_batch *batch,
+				      unsigned long caller)
+{
+	struct call_function_data *cfd;
+	unsigned int i;
+
+	if (!batch->nr)
+		return;
+
+	preempt_disable();
+	if (batch->nr == 1) {
+		smp_call_function_many_cond(batch->calls[0].mask,
+					    batch->calls[0].func,
+					    batch->calls[0].info,
+					    SCF_WAIT | SCF_RUN_LOCAL, NULL, caller);
+	} else {
+		cfd = this_cpu_ptr(&cfd_data);
+		cpumask_copy(cfd->cpumask_batch, batch->calls[0].mask);
+		for (i = 1; i < batch->nr; i++)
+			cpumask_or(cfd->cpumask_batch, cfd->cpumask_batch,
+				   batch->calls[i].mask);
+
+		smp_call_function_many_cond(cfd->cpumask_batch,
+					    smp_call_batch_func, batch,
+					    SCF_WAIT | SCF_RUN_LOCAL, NULL, caller);
+	}
+	preempt_enable();
+
+	batch->nr = 0;
+}
+
+/**
+ * on_each_cpu_batch_add(): Add a function call to a batch of cross calls.
+ * @batch: The batch, see DEFINE_SMP_CALL_BATCH().
+ * @mask: The set of cpus to run on (only runs on online subset).
+ * @func: The function to run. This must be fast and non-blocking.
+ * @info: An arbitrary pointer to pass to the function.
+ *
+ * Like on_each_cpu_mask() with @wait set, except that the call is only made
+ * by on_each_cpu_batch_flush(), along with the other calls of @batch. Until
+ * then, @mask and @info must stay valid. A full batch is flushed here.
+ *
+ * You must not call this function with disabled interrupts or from a
+ * hardware interrupt handler or from a bottom half handler.
+ */
+void on_each_cpu_batch_add(struct smp_call_batch *batch,
+			   const struct cpumask *mask,
+			   smp_call_func_t func, void *info)
+{
+	if (batch->nr == SMP_CALL_BATCH_MAX)
+		__on_each_cpu_batch_flush(batch, _RET_IP_);
+
+	batch->calls[batch->nr].func = func;
+	batch->calls[batch->nr].info = info;
+	batch->calls[batch->nr].mask = mask;
+	batch->nr++;
+}
+EXPORT_SYMBOL(on_each_cpu_batch_add);
+
+/**
+ * on_each_cpu_batch_flush(): Make the cross calls of a batch.
+ * @batch: The batch to flush.
+ *
+ * Every CPU in the union of the masks of the calls added to @batch is sent
+ * a single IPI, and runs the calls it is targeted by, in the order they
+ * were added. Returns once all of them have completed, and the batch is
+ * empty again.
+ *
+ * You must not call this function with disabled interrupts or from a
+ * hardware interrupt handler or from a bottom half handler.
+ */
+void on_each_cpu_batch_flush(struct smp_call_batch *batch)
+{
+	__on_each_cpu_batch_flush(batch, _RET_IP_);
+}
+EXPORT_SYMBOL(on_each_cpu_batch_flush);
+
 static void do_nothing(void *unused)
 {
 }
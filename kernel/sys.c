@@ -45,6 +45,7 @@
 #include <linux/version.h>
 #include <linux/ctype.h>
 #include <linux/syscall_user_dispatch.h>
+#include <linux/futex.h>
 
 #include <linux/compat.h>
 #include <linux/syscalls.h>
@@ -2811,6 +2812,48 @@ SYSCALL_DEFINE5(prctl, int, option, unsigned long, arg2, unsigned long, arg3,
 			return -EINVAL;
 		error = arch_lock_shadow_stack_status(me, arg2);
 		break;
+	case PR_SET_FORK_COPY_THREADS:
+		if (arg3 || arg4 || arg5)
+			return -EINVAL;
+		if (arg2 > num_possible_cpus())
+			return -EINVAL;
+		WRITE_ONCE(me->mm->fork_copy_threads, arg2);
+		break;
+	case PR_GET_FORK_COPY_THREADS:
+		if (arg2 || arg3 || arg4 || arg5)
+			return -EINVAL;
+		error = READ_ONCE(me->mm->fork_copy_threads);
+		break;
+	case PR_SET_EXIT_MM_ASYNC:
+		if (arg3 || arg4 || arg5)
+			return -EINVAL;
+		if (!IS_ENABLED(CONFIG_MMU) || arg2 > 1)
+			return -EINVAL;
+		WRITE_ONCE(me->mm->exit_mm_async, arg2);
+		break;
+	case PR_GET_EXIT_MM_ASYNC:
+		if (arg2 || arg3 || arg4 || arg5)
+			return -EINVAL;
+		error = READ_ONCE(me->mm->exit_mm_async);
+		break;
+	case PR_FUTEX_HASH:
+		error = futex_hash_prctl(arg2, arg3, arg4, arg5);
+		break;
+	case PR_SET_EXEC_HUGE_TEXT:
+		if (arg3 || arg4 || arg5)
+			return -EINVAL;
+		if (!IS_ENABLED(CONFIG_TRANSPARENT_HUGEPAGE) || arg2 > 1)
+			return -EINVAL;
+		if (arg2)
+			task_set_exec_huge_text(me);
+		else
+			task_clear_exec_huge_text(me);
+		break;
+	case PR_GET_EXEC_HUGE_TEXT:
+		if (arg2 || arg3 || arg4 || arg5)
+			return -EINVAL;
+		error = task_exec_huge_text(me);
+		break;
 	default:
 		trace_task_prctl_unknown(option, arg2, arg3, arg4, arg5);
 		error = -EINVAL;
@@ -562,6 +562,68 @@ static int taskstats_user_cmd(struct sk_buff *skb, struct genl_info *info)
 		return -EINVAL;
 }
 
+static int taskstats_dump_one(struct sk_buff *skb, struct netlink_callback *cb,
+			      struct task_struct *tsk, u32 pid)
+{
+	struct taskstats *stats;
+	void *reply;
+
+	reply = genlmsg_put(skb, NETLINK_CB(cb->skb).portid,
+			    cb->nlh->nlmsg_seq, &family, NLM_F_MULTI,
+			    TASKSTATS_CMD_NEW);
+	if (!reply)
+		return -EMSGSIZE;
+
+	stats = mk_reply(skb, TASKSTATS_TYPE_PID, pid);
+	if (!stats) {
+		genlmsg_cancel(skb, reply);
+		return -EMSGSIZE;
+	}
+	fill_stats(current_user_ns(), task_active_pid_ns(current), tsk, stats);
+	genlmsg_end(skb, reply);
+	return 0;
+}
+
+/*
+ * Dump the per-task stats of every task in the caller's pid namespace, or
+ * only of the threads of TASKSTATS_CMD_ATTR_TGID if given, in pid order.
+ * The pids are walked under RCU and cb->args[0] holds the next one to
+ * look at.
+ */
+static int taskstats_user_dump(struct sk_buff *skb, struct netlink_callback *cb)
+{
+	const struct genl_info *info = genl_info_dump(cb);
+	struct pid_namespace *ns = task_active_pid_ns(current);
+	struct task_struct *tsk;
+	u32 nr = cb->args[0];
+	struct pid *pid;
+	u32 tgid = 0;
+	int rc;
+
+	if (info->attrs[TASKSTATS_CMD_ATTR_TGID])
+		tgid = nla_get_u32(info->attrs[TASKSTATS_CMD_ATTR_TGID]);
+
+	rcu_read_lock();
+	while ((pid = find_ge_pid(nr, ns))) {
+		nr = pid_nr_ns(pid, ns);
+		tsk = pid_task(pid, PIDTYPE_PID);
+		if (tsk && (!tgid || task_tgid_nr_ns(tsk, ns) == tgid)) {
+			get_task_struct(tsk);
+			rcu_read_unlock();
+			rc = taskstats_dump_one(skb, cb, tsk, nr);
+			put_task_struct(tsk);
+			if (rc)
+				goto out;
+			rcu_read_lock();
+		}
+		nr++;
+	}
+	rcu_read_unlock();
+out:
+	cb->args[0] = nr;
+	return skb->len;
+}
+
 static struct taskstats *taskstats_tgid_alloc(struct task_struct *tsk)
 {
 	struct signal_struct *sig = tsk->signal;
@@ -662,6 +724,7 @@ static const struct genl_ops taskstats_ops[] = {
 		.cmd		= TASKSTATS_CMD_GET,
 		.validate = GENL_DONT_VALIDATE_STRICT | GENL_DONT_VALIDATE_DUMP,
 		.doit		= taskstats_user_cmd,
+		.dumpit		= taskstats_user_dump,
 		.policy		= taskstats_cmd_get_policy,
 		.maxattr	= ARRAY_SIZE(taskstats_cmd_get_policy) - 1,
 		.flags		= GENL_ADMIN_PERM,
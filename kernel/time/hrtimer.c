@@ -1830,6 +1830,37 @@ static void __run_hrtimer(struct hrtimer_cpu_base *cpu_base,
 	base->running = NULL;
 }
 
+/*
+ * Number of timers right-of the first not yet expired one which are
+ * looked at for an expired soft expiry time.
+ */
+#define HRTIMER_BATCH_LOOKAHEAD	8
+
+/*
+ * Find a timer whose soft expiry time has passed among the few which
+ * follow @node, the first not yet expired timer of its clock base, so
+ * that it is expired in the same batch instead of being left for the
+ * hard expiry time of @node or later.
+ */
+static struct hrtimer *hrtimer_batch_next(struct timerqueue_node *node,
+					  ktime_t basenow)
+{
+	int i;
+
+	for (i = 0; i < HRTIMER_BATCH_LOOKAHEAD; i++) {
+		struct hrtimer *timer;
+
+		node = timerqueue_iterate_next(node);
+		if (!node)
+			break;
+
+		timer = container_of(node, struct hrtimer, node);
+		if (basenow >= hrtimer_get_softexpires_tv64(timer))
+			return timer;
+	}
+	return NULL;
+}
+
 static void __hrtimer_run_queues(struct hrtimer_cpu_base *cpu_base, ktime_t now,
 				 unsigned long flags, unsigned int active_mask)
 {
@@ -1855,13 +1886,20 @@ static void __hrtimer_run_queues(struct hrtimer_cpu_base *cpu_base, ktime_t now,
 			 * Tree, which can answer a stabbing query for
 			 * overlapping intervals and instead use the simple
 			 * BST we already have.
-			 * We don't add extra wakeups by delaying timers that
-			 * are right-of a not yet expired timer, because that
-			 * timer will have to trigger a wakeup anyway.
+			 * Timers right-of a not yet expired timer would
+			 * not add extra wakeups when delayed, if that timer
+			 * was sure to trigger a wakeup. But timeouts are
+			 * mostly canceled before they expire, so take the
+			 * soft expired ones among the next few as well.
 			 */
-			if (basenow < hrtimer_get_softexpires_tv64(timer))
-				break;
-
+			if (basenow < hrtimer_get_softexpires_tv64(timer)) {
+				timer = hrtimer_batch_next(node, basenow);
+				if (!timer)
+					break;
+				cpu_base->nr_batched++;
+			}
+
+			cpu_base->nr_expired++;
 			__run_hrtimer(cpu_base, base, timer, &basenow, flags);
 			if (active_mask == HRTIMER_ACTIVE_SOFT)
 				hrtimer_sync_wait_running(cpu_base, flags);
@@ -9,6 +9,7 @@
 #include <linux/smp.h>
 #include <linux/spinlock.h>
 #include <linux/timerqueue.h>
+#include <linux/topology.h>
 #include <trace/events/ipi.h>
 
 #include "timer_migration.h"
@@ -36,6 +37,11 @@
  * LVL 0  [GRP0:0]  [GRP0:1]  [GRP0:2]  [GRP0:3]  [GRP0:4]  [GRP0:5]
  * CPUS     0-7       8-15      16-23     24-31     32-39     40-47
  *
+ * Where the topology of the CPUs is known before they are brought up, the
+ * lowest level groups are further kept per cluster (a set of CPUs sharing
+ * a cache), so that the global timers of an idle CPU are preferably
+ * handled by an awake CPU sharing that cache, see tmigr_cpu_domain().
+ *
  * The groups hold a timer queue of events sorted by expiry time. These
  * queues are updated when CPUs go in idle. When they come out of idle
  * ignore flag of events is set.
@@ -1484,8 +1490,26 @@ static int tmigr_cpu_online(unsigned int cpu)
 	return 0;
 }
 
+/*
+ * Return the topology domain of @cpu, which lowest level groups do not
+ * cross, or -1 when it is not known.
+ *
+ * The hierarchy is set up in the prepare step, when the target CPU did
+ * not run yet and thus has not enumerated its topology and caches. Only
+ * with GENERIC_ARCH_TOPOLOGY is the cluster of all possible CPUs parsed
+ * from firmware tables before they are brought up.
+ */
+static int tmigr_cpu_domain(unsigned int cpu)
+{
+#ifdef CONFIG_GENERIC_ARCH_TOPOLOGY
+	return topology_cluster_id(cpu);
+#else
+	return -1;
+#endif
+}
+
 static void tmigr_init_group(struct tmigr_group *group, unsigned int lvl,
-			     int node)
+			     int node, int domain)
 {
 	union tmigr_state s;
 
@@ -1493,6 +1517,7 @@ static void tmigr_init_group(struct tmigr_group *group, unsigned int lvl,
 
 	group->level = lvl;
 	group->numa_node = lvl < tmigr_crossnode_level ? node : NUMA_NO_NODE;
+	group->domain = lvl ? -1 : domain;
 
 	group->num_children = 0;
 
@@ -1527,6 +1552,7 @@ static struct tmigr_group *tmigr_get_group(unsigned int cpu, int node,
 					   unsigned int lvl)
 {
 	struct tmigr_group *tmp, *group = NULL;
+	int domain = tmigr_cpu_domain(cpu);
 
 	lockdep_assert_held(&tmigr_mutex);
 
@@ -1539,17 +1565,17 @@ static struct tmigr_group *tmigr_get_group(unsigned int cpu, int node,
 		if (lvl < tmigr_crossnode_level && tmp->numa_node != node)
 			continue;
 
+		/*
+		 * The lowest level groups only contain CPUs of the same
+		 * topology domain.
+		 */
+		if (!lvl && tmp->domain != domain)
+			continue;
+
 		/* Capacity left? */
 		if (tmp->num_children >= TMIGR_CHILDREN_PER_GROUP)
 			continue;
 
-		/*
-		 * TODO: A possible further improvement: Make sure that all CPU
-		 * siblings end up in the same group of the lowest level of the
-		 * hierarchy. Rely on the topology sibling mask would be a
-		 * reasonable solution.
-		 */
-
 		group = tmp;
 		break;
 	}
@@ -1562,7 +1588,7 @@ static struct tmigr_group *tmigr_get_group(unsigned int cpu, int node,
 	if (!group)
 		return ERR_PTR(-ENOMEM);
 
-	tmigr_init_group(group, lvl, node);
+	tmigr_init_group(group, lvl, node, domain);
 
 	/* Setup successful. Add it to the hierarchy */
 	list_add(&group->list, &tmigr_level_list[lvl]);
@@ -1788,9 +1814,48 @@ static int tmigr_cpu_prepare(unsigned int cpu)
 	return ret;
 }
 
+/*
+ * Return the maximum number of lowest level groups a NUMA node needs when
+ * they are split by topology domain, or 0 when no domains are known.
+ */
+static unsigned int __init tmigr_lvl0_groups_per_node(void)
+{
+	unsigned int cpu, sibling, max_groups = 0;
+	int node;
+
+	if (!IS_ENABLED(CONFIG_GENERIC_ARCH_TOPOLOGY))
+		return 0;
+
+	for_each_node(node) {
+		unsigned int groups = 0;
+
+		for_each_possible_cpu(cpu) {
+			unsigned int nr = 0;
+
+			if (cpu_to_node(cpu) != node)
+				continue;
+
+			/* Count the preceding CPUs which share a group */
+			for_each_possible_cpu(sibling) {
+				if (sibling == cpu)
+					break;
+				if (cpu_to_node(sibling) == node &&
+				    tmigr_cpu_domain(sibling) == tmigr_cpu_domain(cpu))
+					nr++;
+			}
+
+			if (!(nr % TMIGR_CHILDREN_PER_GROUP))
+				groups++;
+		}
+		max_groups = max(max_groups, groups);
+	}
+
+	return max_groups;
+}
+
 static int __init tmigr_init(void)
 {
-	unsigned int cpulvl, nodelvl, cpus_per_node, i;
+	unsigned int cpulvl, nodelvl, cpus_per_node, lvl0_groups, i;
 	unsigned int nnodes = num_possible_nodes();
 	unsigned int ncpus = num_possible_cpus();
 	int ret = -ENOMEM;
@@ -1817,6 +1882,16 @@ static int __init tmigr_init(void)
 	cpulvl = DIV_ROUND_UP(order_base_2(cpus_per_node),
 			      ilog2(TMIGR_CHILDREN_PER_GROUP));
 
+	/*
+	 * Lowest level groups split by topology domain are not necessarily
+	 * full, which might require more levels.
+	 */
+	lvl0_groups = tmigr_lvl0_groups_per_node();
+	if (lvl0_groups > 1) {
+		cpulvl = max(cpulvl, 1 + DIV_ROUND_UP(order_base_2(lvl0_groups),
+						      ilog2(TMIGR_CHILDREN_PER_GROUP)));
+	}
+
 	/* Calculate the extra levels to connect all nodes */
 	nodelvl = DIV_ROUND_UP(order_base_2(nnodes),
 			       ilog2(TMIGR_CHILDREN_PER_GROUP));
@@ -48,6 +48,10 @@ struct tmigr_event {
  *			as long as the group level is per NUMA node (level <
  *			tmigr_crossnode_level); otherwise it is set to
  *			NUMA_NO_NODE
+ * @domain:		Required for setup only to make sure the CPUs of lowest
+ *			level groups share a topology domain (see
+ *			tmigr_cpu_domain()); It is set to -1 for the other
+ *			levels or when the domain is not known
  * @num_children:	Counter of group children to make sure the group is only
  *			filled with TMIGR_CHILDREN_PER_GROUP; Required for setup
  *			only
@@ -67,6 +71,7 @@ struct tmigr_group {
 	atomic_t		migr_state;
 	unsigned int		level;
 	int			numa_node;
+	int			domain;
 	unsigned int		num_children;
 	u8			groupmask;
 	struct list_head	list;
@@ -13,6 +13,8 @@
 #include <linux/ftrace.h>
 #include <linux/static_call.h>
 #include <linux/slab.h>
+#include <linux/hash.h>
+#include <linux/vmalloc.h>
 
 #include <trace/events/sched.h>
 
@@ -647,6 +649,175 @@ ftrace_push_return_trace(unsigned long ret, unsigned long func,
 # define MCOUNT_INSN_SIZE 0
 #endif
 
+#ifdef CONFIG_DYNAMIC_FTRACE
+/*
+ * With several fgraph_ops registered, testing the filter hashes of each
+ * of them on every traced function gets expensive. Instead, keep a
+ * table of the functions to trace with the mask of the fgraph_array
+ * indexes that want each of them, rebuilt whenever an fgraph_ops is
+ * added or removed, or its filters change. fgraph_ops that trace all
+ * functions are in all_mask; the ones with a notrace hash or that need
+ * regs still go through ftrace_ops_test() and are in test_mask.
+ */
+struct fgraph_filter_ent {
+	struct hlist_node	node;
+	unsigned long		ip;
+	unsigned long		mask;
+};
+
+struct fgraph_filter {
+	unsigned long			all_mask;
+	unsigned long			test_mask;
+	unsigned int			hash_bits;
+	struct hlist_head		*heads;
+	struct fgraph_filter_ent	ents[];
+};
+
+static struct fgraph_filter __rcu *fgraph_filter;
+
+static struct fgraph_filter_ent *
+fgraph_filter_find(struct fgraph_filter *filter, unsigned long ip)
+{
+	struct fgraph_filter_ent *ent;
+
+	hlist_for_each_entry(ent, &filter->heads[hash_long(ip, filter->hash_bits)],
+			     node) {
+		if (ent->ip == ip)
+			return ent;
+	}
+	return NULL;
+}
+
+static void fgraph_filter_free(struct fgraph_filter *filter)
+{
+	if (!filter)
+		return;
+	kvfree(filter->heads);
+	kvfree(filter);
+}
+
+static struct fgraph_filter *fgraph_filter_build(void)
+{
+	struct fgraph_filter *filter;
+	struct fgraph_filter_ent *ent;
+	struct ftrace_func_entry *fent;
+	struct ftrace_hash *hash;
+	unsigned long nr = 0;
+	unsigned int n = 0;
+	int i, b;
+
+	for_each_set_bit(i, &fgraph_array_bitmask, FGRAPH_ARRAY_SIZE) {
+		if (fgraph_array[i] == &fgraph_stub)
+			continue;
+		nr += fgraph_array[i]->ops.func_hash->filter_hash ?
+			fgraph_array[i]->ops.func_hash->filter_hash->count : 0;
+	}
+
+	filter = kvzalloc(struct_size(filter, ents, nr), GFP_KERNEL);
+	if (!filter)
+		return NULL;
+
+	filter->hash_bits = max(ilog2(roundup_pow_of_two(nr ?: 1)), 1);
+	filter->heads = kvcalloc(1U << filter->hash_bits,
+				 sizeof(*filter->heads), GFP_KERNEL);
+	if (!filter->heads) {
+		kvfree(filter);
+		return NULL;
+	}
+
+	for_each_set_bit(i, &fgraph_array_bitmask, FGRAPH_ARRAY_SIZE) {
+		struct fgraph_ops *gops = fgraph_array[i];
+
+		if (gops == &fgraph_stub)
+			continue;
+
+		if (!ftrace_hash_empty(gops->ops.func_hash->notrace_hash) ||
+		    (gops->ops.flags & FTRACE_OPS_FL_SAVE_REGS)) {
+			filter->test_mask |= BIT(i);
+			continue;
+		}
+
+		hash = gops->ops.func_hash->filter_hash;
+		if (ftrace_hash_empty(hash)) {
+			filter->all_mask |= BIT(i);
+			continue;
+		}
+
+		for (b = 0; b < 1 << hash->size_bits; b++) {
+			hlist_for_each_entry(fent, &hash->buckets[b], hlist) {
+				ent = fgraph_filter_find(filter, fent->ip);
+				if (!ent) {
+					ent = &filter->ents[n++];
+					ent->ip = fent->ip;
+					hlist_add_head(&ent->node,
+						       &filter->heads[hash_long(ent->ip,
+										filter->hash_bits)]);
+				}
+				ent->mask |= BIT(i);
+			}
+		}
+	}
+
+	return filter;
+}
+
+/*
+ * Called with ftrace_lock held. On allocation failure, the filter
+ * table is dropped and every fgraph_ops gets tested on each call.
+ * The old table is freed synchronously, so that an fgraph_array index
+ * released by unregister_ftrace_graph() can not be found in it by the
+ * time the index is handed out again.
+ */
+static void fgraph_filter_rebuild(void)
+{
+	struct fgraph_filter *old, *new = NULL;
+
+	lockdep_assert_held(&ftrace_lock);
+
+	if (ftrace_graph_active > 1)
+		new = fgraph_filter_build();
+
+	old = rcu_dereference_protected(fgraph_filter,
+					lockdep_is_held(&ftrace_lock));
+	rcu_assign_pointer(fgraph_filter, new);
+	if (old) {
+		synchronize_rcu();
+		fgraph_filter_free(old);
+	}
+}
+
+/* Returns the fgraph_array indexes that may want @ip, and the ones to test */
+static __always_inline unsigned long
+fgraph_filter_mask(unsigned long ip, unsigned long *test_mask)
+{
+	struct fgraph_filter *filter;
+	struct fgraph_filter_ent *ent;
+	unsigned long mask;
+
+	filter = rcu_dereference_raw_check(fgraph_filter);
+	if (unlikely(!filter)) {
+		*test_mask = fgraph_array_bitmask;
+		return fgraph_array_bitmask;
+	}
+
+	*test_mask = filter->test_mask;
+	mask = filter->all_mask | filter->test_mask;
+	ent = fgraph_filter_find(filter, ip);
+	if (ent)
+		mask |= ent->mask;
+	return mask;
+}
+#else
+static inline void fgraph_filter_rebuild(void) { }
+
+static __always_inline unsigned long
+fgraph_filter_mask(unsigned long ip, unsigned long *test_mask)
+{
+	*test_mask = fgraph_array_bitmask;
+	return fgraph_array_bitmask;
+}
+#endif /* CONFIG_DYNAMIC_FTRACE */
+
 /* If the caller does not use ftrace, call this function. */
 int function_graph_enter_regs(unsigned long ret, unsigned long func,
 			      unsigned long frame_pointer, unsigned long *retp,
@@ -681,8 +852,10 @@ int function_graph_enter_regs(unsigned long ret, unsigned long func,
 	} else
 #endif
 	{
-		for_each_set_bit(i, &fgraph_array_bitmask,
-					 sizeof(fgraph_array_bitmask) * BITS_PER_BYTE) {
+		unsigned long mask, test_mask;
+
+		mask = fgraph_filter_mask(func, &test_mask);
+		for_each_set_bit(i, &mask, sizeof(mask) * BITS_PER_BYTE) {
 			struct fgraph_ops *gops = READ_ONCE(fgraph_array[i]);
 			int save_curr_ret_stack;
 
@@ -690,7 +863,8 @@ int function_graph_enter_regs(unsigned long ret, unsigned long func,
 				continue;
 
 			save_curr_ret_stack = current->curr_ret_stack;
-			if (ftrace_ops_test(&gops->ops, func, NULL) &&
+			if ((!(test_mask & BIT(i)) ||
+			     ftrace_ops_test(&gops->ops, func, NULL)) &&
 			    gops->entryfunc(&trace, gops, fregs))
 				bitmap |= BIT(i);
 			else
@@ -1221,6 +1395,13 @@ void fgraph_update_pid_func(void)
 		}
 	}
 }
+
+/* The filters of @ops, or of one of its subops, changed */
+void fgraph_update_filter(struct ftrace_ops *ops)
+{
+	if (ops == &graph_ops)
+		fgraph_filter_rebuild();
+}
 #endif
 
 /* Allocate a return stack for each task */
@@ -1383,8 +1564,10 @@ int register_ftrace_graph(struct fgraph_ops *gops)
 	gops->saved_func = gops->entryfunc;
 
 	ret = ftrace_startup_subops(&graph_ops, &gops->ops, command);
-	if (!ret)
+	if (!ret) {
 		fgraph_array[i] = gops;
+		fgraph_filter_rebuild();
+	}
 
 error:
 	if (ret) {
@@ -1419,6 +1602,7 @@ void unregister_ftrace_graph(struct fgraph_ops *gops)
 		command = FTRACE_STOP_FUNC_RET;
 
 	ftrace_shutdown_subops(&graph_ops, &gops->ops, command);
+	fgraph_filter_rebuild();
 
 	if (ftrace_graph_active == 1)
 		ftrace_graph_enable_direct(true, NULL);
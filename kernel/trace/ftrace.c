@@ -3667,6 +3667,7 @@ static int ftrace_hash_move_and_update_subops(struct ftrace_ops *subops,
 		*orig_subhash = save_hash;
 	} else {
 		free_ftrace_hash_rcu(save_hash);
+		fgraph_update_filter(ops);
 	}
 	return ret;
 }
@@ -54,12 +54,15 @@ static inline int ftrace_shutdown_subops(struct ftrace_ops *ops, struct ftrace_o
 extern int ftrace_graph_active;
 # ifdef CONFIG_DYNAMIC_FTRACE
 extern void fgraph_update_pid_func(void);
+extern void fgraph_update_filter(struct ftrace_ops *ops);
 # else
 static inline void fgraph_update_pid_func(void) {}
+static inline void fgraph_update_filter(struct ftrace_ops *ops) {}
 # endif
 #else /* !CONFIG_FUNCTION_GRAPH_TRACER */
 # define ftrace_graph_active 0
 static inline void fgraph_update_pid_func(void) {}
+static inline void fgraph_update_filter(struct ftrace_ops *ops) {}
 #endif /* CONFIG_FUNCTION_GRAPH_TRACER */
 
 #else /* !CONFIG_FUNCTION_TRACER */
@@ -415,6 +415,16 @@ struct rb_irq_work {
 	bool				wakeup_full;
 };
 
+/*
+ * Events reserved together by ring_buffer_lock_reserve_batch().
+ */
+struct rb_batch {
+	const unsigned long		*lengths;	/* data lengths */
+	struct ring_buffer_event	**events;
+	unsigned int			nr;
+	unsigned long			length;		/* of all events */
+};
+
 /*
  * Structure to hold event state and handle nested events.
  */
@@ -425,6 +435,7 @@ struct rb_event_info {
 	u64			after;
 	unsigned long		length;
 	struct buffer_page	*tail_page;
+	struct rb_batch		*batch;
 	int			add_timestamp;
 };
 
@@ -3590,6 +3601,44 @@ static void rb_add_timestamp(struct ring_buffer_per_cpu *cpu_buffer,
 	*delta = 0;
 }
 
+static __always_inline void
+rb_set_event_header(struct ring_buffer_event *event, u64 delta,
+		    unsigned length)
+{
+	event->time_delta = delta;
+	length -= RB_EVNT_HDR_SIZE;
+	if (length > RB_MAX_SMALL_DATA || RB_FORCE_8BYTE_ALIGNMENT) {
+		event->type_len = 0;
+		event->array[0] = length;
+	} else
+		event->type_len = DIV_ROUND_UP(length, RB_ALIGNMENT);
+}
+
+static unsigned rb_calculate_event_length(unsigned length);
+
+/*
+ * Lay out the events of a batch back to back. Only the first one
+ * carries the time delta, the others have the same timestamp.
+ */
+static void rb_update_batch(struct ring_buffer_event *event, u64 delta,
+			    struct rb_batch *batch)
+{
+	unsigned int i, length;
+
+	for (i = 0; i < batch->nr; i++) {
+		length = rb_calculate_event_length(batch->lengths[i]);
+		rb_set_event_header(event, delta, length);
+		batch->events[i] = event;
+		event = (void *)event + length;
+		delta = 0;
+	}
+}
+
+static __always_inline unsigned int rb_info_nr_events(struct rb_event_info *info)
+{
+	return unlikely(info->batch) ? info->batch->nr : 1;
+}
+
 /**
  * rb_update_event - update event type and data
  * @cpu_buffer: The per cpu buffer of the @event
@@ -3620,13 +3669,12 @@ rb_update_event(struct ring_buffer_per_cpu *cpu_buffer,
 	if (unlikely(info->add_timestamp))
 		rb_add_timestamp(cpu_buffer, &event, info, &delta, &length);
 
-	event->time_delta = delta;
-	length -= RB_EVNT_HDR_SIZE;
-	if (length > RB_MAX_SMALL_DATA || RB_FORCE_8BYTE_ALIGNMENT) {
-		event->type_len = 0;
-		event->array[0] = length;
-	} else
-		event->type_len = DIV_ROUND_UP(length, RB_ALIGNMENT);
+	if (unlikely(info->batch)) {
+		rb_update_batch(event, delta, info->batch);
+		return;
+	}
+
+	rb_set_event_header(event, delta, length);
 }
 
 static unsigned rb_calculate_event_length(unsigned length)
@@ -3839,9 +3887,10 @@ static inline void rb_event_discard(struct ring_buffer_event *event)
 		event->time_delta = 1;
 }
 
-static void rb_commit(struct ring_buffer_per_cpu *cpu_buffer)
+static void rb_commit(struct ring_buffer_per_cpu *cpu_buffer,
+		      unsigned int nr_events)
 {
-	local_inc(&cpu_buffer->entries);
+	local_add(nr_events, &cpu_buffer->entries);
 	rb_end_commit(cpu_buffer);
 }
 
@@ -4041,13 +4090,29 @@ void ring_buffer_nest_end(struct trace_buffer *buffer)
  * Must be paired with ring_buffer_lock_reserve.
  */
 int ring_buffer_unlock_commit(struct trace_buffer *buffer)
+{
+	return ring_buffer_unlock_commit_batch(buffer, 1);
+}
+EXPORT_SYMBOL_GPL(ring_buffer_unlock_commit);
+
+/**
+ * ring_buffer_unlock_commit_batch - commit a reserved batch of events
+ * @buffer: The buffer to commit to
+ * @nr: The number of events of the batch
+ *
+ * This commits all the events of the batch at once, and releases any
+ * locks held.
+ *
+ * Must be paired with ring_buffer_lock_reserve_batch, with the same @nr.
+ */
+int ring_buffer_unlock_commit_batch(struct trace_buffer *buffer, unsigned int nr)
 {
 	struct ring_buffer_per_cpu *cpu_buffer;
 	int cpu = raw_smp_processor_id();
 
 	cpu_buffer = buffer->buffers[cpu];
 
-	rb_commit(cpu_buffer);
+	rb_commit(cpu_buffer, nr);
 
 	rb_wakeups(buffer, cpu_buffer);
 
@@ -4057,7 +4122,7 @@ int ring_buffer_unlock_commit(struct trace_buffer *buffer)
 
 	return 0;
 }
-EXPORT_SYMBOL_GPL(ring_buffer_unlock_commit);
+EXPORT_SYMBOL_GPL(ring_buffer_unlock_commit_batch);
 
 /* Special value to validate all deltas on a page. */
 #define CHECK_FULL_PAGE		1L
@@ -4396,7 +4461,7 @@ __rb_reserve_next(struct ring_buffer_per_cpu *cpu_buffer,
 	event = __rb_page_index(tail_page, tail);
 	rb_update_event(cpu_buffer, event, info);
 
-	local_inc(&tail_page->entries);
+	local_add(rb_info_nr_events(info), &tail_page->entries);
 
 	/*
 	 * If this is the first commit on the page, then update
@@ -4414,7 +4479,7 @@ __rb_reserve_next(struct ring_buffer_per_cpu *cpu_buffer,
 static __always_inline struct ring_buffer_event *
 rb_reserve_next_event(struct trace_buffer *buffer,
 		      struct ring_buffer_per_cpu *cpu_buffer,
-		      unsigned long length)
+		      unsigned long length, struct rb_batch *batch)
 {
 	struct ring_buffer_event *event;
 	struct rb_event_info info;
@@ -4450,7 +4515,11 @@ rb_reserve_next_event(struct trace_buffer *buffer,
 	}
 #endif
 
-	info.length = rb_calculate_event_length(length);
+	info.batch = batch;
+	if (batch)
+		info.length = batch->length;
+	else
+		info.length = rb_calculate_event_length(length);
 
 	if (ring_buffer_time_stamp_abs(cpu_buffer->buffer)) {
 		add_ts_default = RB_ADD_STAMP_ABSOLUTE;
@@ -4536,7 +4605,7 @@ ring_buffer_lock_reserve(struct trace_buffer *buffer, unsigned long length)
 	if (unlikely(trace_recursive_lock(cpu_buffer)))
 		goto out;
 
-	event = rb_reserve_next_event(buffer, cpu_buffer, length);
+	event = rb_reserve_next_event(buffer, cpu_buffer, length, NULL);
 	if (!event)
 		goto out_unlock;
 
@@ -4550,6 +4619,83 @@ ring_buffer_lock_reserve(struct trace_buffer *buffer, unsigned long length)
 }
 EXPORT_SYMBOL_GPL(ring_buffer_lock_reserve);
 
+/**
+ * ring_buffer_lock_reserve_batch - reserve several events at once
+ * @buffer: the ring buffer to reserve from
+ * @lengths: the data lengths of the events (excluding event headers)
+ * @events: filled with the reserved events
+ * @nr: the number of events to reserve
+ *
+ * Reserves @nr events laid out back to back on the ring buffer, for
+ * the cost of a single reservation: the recursion checks, the
+ * timestamp update and the write to the sub-buffer are done once for
+ * the whole batch. Only the first event carries a time delta, all
+ * the events get the same timestamp. The batch has to fit in a
+ * single sub-buffer.
+ *
+ * Returns 0 on success, in which case it must be paired with
+ * ring_buffer_unlock_commit_batch with the same @nr. The events of a
+ * batch can not be passed to ring_buffer_discard_commit.
+ * Returns -EINVAL if the batch does not fit, or -EBUSY if the buffer
+ * can not be written to right now. Then nothing has been allocated
+ * or locked.
+ */
+int ring_buffer_lock_reserve_batch(struct trace_buffer *buffer,
+				   const unsigned long *lengths,
+				   struct ring_buffer_event **events,
+				   unsigned int nr)
+{
+	struct ring_buffer_per_cpu *cpu_buffer;
+	struct rb_batch batch = {
+		.lengths	= lengths,
+		.events		= events,
+		.nr		= nr,
+	};
+	unsigned int i;
+	int cpu;
+
+	if (unlikely(!nr))
+		return -EINVAL;
+
+	for (i = 0; i < nr; i++) {
+		if (unlikely(lengths[i] > buffer->max_data_size))
+			return -EINVAL;
+		batch.length += rb_calculate_event_length(lengths[i]);
+	}
+	if (unlikely(batch.length > buffer->max_data_size))
+		return -EINVAL;
+
+	preempt_disable_notrace();
+
+	if (unlikely(atomic_read(&buffer->record_disabled)))
+		goto out;
+
+	cpu = raw_smp_processor_id();
+
+	if (unlikely(!cpumask_test_cpu(cpu, buffer->cpumask)))
+		goto out;
+
+	cpu_buffer = buffer->buffers[cpu];
+
+	if (unlikely(atomic_read(&cpu_buffer->record_disabled)))
+		goto out;
+
+	if (unlikely(trace_recursive_lock(cpu_buffer)))
+		goto out;
+
+	if (!rb_reserve_next_event(buffer, cpu_buffer, 0, &batch))
+		goto out_unlock;
+
+	return 0;
+
+ out_unlock:
+	trace_recursive_unlock(cpu_buffer);
+ out:
+	preempt_enable_notrace();
+	return -EBUSY;
+}
+EXPORT_SYMBOL_GPL(ring_buffer_lock_reserve_batch);
+
 /*
  * Decrement the entries to the page that an event is on.
  * The event does not even need to exist, only the pointer
@@ -4686,7 +4832,7 @@ int ring_buffer_write(struct trace_buffer *buffer,
 	if (unlikely(trace_recursive_lock(cpu_buffer)))
 		goto out;
 
-	event = rb_reserve_next_event(buffer, cpu_buffer, length);
+	event = rb_reserve_next_event(buffer, cpu_buffer, length, NULL);
 	if (!event)
 		goto out_unlock;
 
@@ -4694,7 +4840,7 @@ int ring_buffer_write(struct trace_buffer *buffer,
 
 	memcpy(body, data, length);
 
-	rb_commit(cpu_buffer);
+	rb_commit(cpu_buffer, 1);
 
 	rb_wakeups(buffer, cpu_buffer);
 
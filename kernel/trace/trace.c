@@ -5573,6 +5573,7 @@ static const char readme_msg[] =
 	"\t            [:pause][:continue][:clear]\n"
 	"\t            [:name=histname1]\n"
 	"\t            [:nohitcount]\n"
+	"\t            [:percpu]\n"
 	"\t            [:<handler>.<action>]\n"
 	"\t            [if <filter>]\n\n"
 	"\t    Note, special fields can be used as well:\n"
@@ -5631,6 +5632,9 @@ static const char readme_msg[] =
 	"\t    unchanged.\n\n"
 	"\t    The 'nohitcount' (or NOHC) parameter will suppress display of\n"
 	"\t    raw hitcount in the histogram.\n\n"
+	"\t    The 'percpu' parameter keeps the hitcount and values of each\n"
+	"\t    entry per CPU, which is cheaper for hot events with few keys\n"
+	"\t    but uses more memory.\n\n"
 	"\t    The enable_hist and disable_hist triggers can be used to\n"
 	"\t    have one event conditionally start and stop another event's\n"
 	"\t    already-attached hist trigger.  The syntax is analogous to\n"
@@ -38,7 +38,10 @@
  */
 void tracing_map_update_sum(struct tracing_map_elt *elt, unsigned int i, u64 n)
 {
-	atomic64_add(n, &elt->fields[i].sum);
+	if (elt->pcpu_sums)
+		this_cpu_add(elt->pcpu_sums[i], n);
+	else
+		atomic64_add(n, &elt->fields[i].sum);
 }
 
 /**
@@ -55,7 +58,61 @@ void tracing_map_update_sum(struct tracing_map_elt *elt, unsigned int i, u64 n)
  */
 u64 tracing_map_read_sum(struct tracing_map_elt *elt, unsigned int i)
 {
-	return (u64)atomic64_read(&elt->fields[i].sum);
+	u64 sum = 0;
+	int cpu;
+
+	if (!elt->pcpu_sums)
+		return (u64)atomic64_read(&elt->fields[i].sum);
+
+	for_each_possible_cpu(cpu)
+		sum += per_cpu_ptr(elt->pcpu_sums, cpu)[i];
+
+	return sum;
+}
+
+/**
+ * tracing_map_set_percpu - Keep the sums of a tracing_map per CPU
+ * @map: The tracing_map
+ *
+ * Instead of one atomic counter shared by all CPUs, give each sum
+ * field of each tracing_map_elt, as well as the map's hit counter, a
+ * counter per CPU. Updating them no longer bounces cache lines
+ * between CPUs hitting the same keys, at the cost of memory and of
+ * adding up the per-CPU counters when reading them.
+ *
+ * Must be called before tracing_map_init().
+ */
+void tracing_map_set_percpu(struct tracing_map *map)
+{
+	map->percpu = true;
+}
+
+/**
+ * tracing_map_read_hits - Return the number of hits of a tracing_map
+ * @map: The tracing_map
+ *
+ * Return: The number of times an element was inserted or retrieved.
+ */
+u64 tracing_map_read_hits(struct tracing_map *map)
+{
+	u64 hits = 0;
+	int cpu;
+
+	if (!map->pcpu_hits)
+		return (u64)atomic64_read(&map->hits);
+
+	for_each_possible_cpu(cpu)
+		hits += *per_cpu_ptr(map->pcpu_hits, cpu);
+
+	return hits;
+}
+
+static inline void tracing_map_inc_hits(struct tracing_map *map)
+{
+	if (map->pcpu_hits)
+		this_cpu_inc(*map->pcpu_hits);
+	else
+		atomic64_inc(&map->hits);
 }
 
 /**
@@ -358,11 +415,18 @@ static struct tracing_map_array *tracing_map_array_alloc(unsigned int n_elts,
 static void tracing_map_elt_clear(struct tracing_map_elt *elt)
 {
 	unsigned i;
+	int cpu;
 
 	for (i = 0; i < elt->map->n_fields; i++)
 		if (elt->fields[i].cmp_fn == tracing_map_cmp_atomic64)
 			atomic64_set(&elt->fields[i].sum, 0);
 
+	if (elt->pcpu_sums) {
+		for_each_possible_cpu(cpu)
+			memset(per_cpu_ptr(elt->pcpu_sums, cpu), 0,
+			       elt->map->n_fields * sizeof(u64));
+	}
+
 	for (i = 0; i < elt->map->n_vars; i++) {
 		atomic64_set(&elt->vars[i], 0);
 		elt->var_set[i] = false;
@@ -397,6 +461,7 @@ static void tracing_map_elt_free(struct tracing_map_elt *elt)
 	kfree(elt->vars);
 	kfree(elt->var_set);
 	kfree(elt->key);
+	free_percpu(elt->pcpu_sums);
 	kfree(elt);
 }
 
@@ -435,6 +500,15 @@ static struct tracing_map_elt *tracing_map_elt_alloc(struct tracing_map *map)
 		goto free;
 	}
 
+	if (map->percpu) {
+		elt->pcpu_sums = __alloc_percpu(map->n_fields * sizeof(u64),
+						sizeof(u64));
+		if (!elt->pcpu_sums) {
+			err = -ENOMEM;
+			goto free;
+		}
+	}
+
 	tracing_map_elt_init_fields(elt);
 
 	if (map->ops && map->ops->elt_alloc) {
@@ -535,7 +609,7 @@ __tracing_map_insert(struct tracing_map *map, void *key, bool lookup_only)
 			if (val &&
 			    keys_match(key, val->key, map->key_size)) {
 				if (!lookup_only)
-					atomic64_inc(&map->hits);
+					tracing_map_inc_hits(map);
 				return val;
 			} else if (unlikely(!val)) {
 				/*
@@ -580,7 +654,7 @@ __tracing_map_insert(struct tracing_map *map, void *key, bool lookup_only)
 				 */
 				smp_wmb();
 				WRITE_ONCE(entry->val, elt);
-				atomic64_inc(&map->hits);
+				tracing_map_inc_hits(map);
 
 				return entry->val;
 			} else {
@@ -681,6 +755,7 @@ void tracing_map_destroy(struct tracing_map *map)
 	tracing_map_free_elts(map);
 
 	tracing_map_array_free(map->map);
+	free_percpu(map->pcpu_hits);
 	kfree(map);
 }
 
@@ -698,11 +773,17 @@ void tracing_map_destroy(struct tracing_map *map)
 void tracing_map_clear(struct tracing_map *map)
 {
 	unsigned int i;
+	int cpu;
 
 	atomic_set(&map->next_elt, 0);
 	atomic64_set(&map->hits, 0);
 	atomic64_set(&map->drops, 0);
 
+	if (map->pcpu_hits) {
+		for_each_possible_cpu(cpu)
+			*per_cpu_ptr(map->pcpu_hits, cpu) = 0;
+	}
+
 	tracing_map_array_clear(map->map);
 
 	for (i = 0; i < map->max_elts; i++)
@@ -833,6 +914,12 @@ int tracing_map_init(struct tracing_map *map)
 	if (map->n_fields < 2)
 		return -EINVAL; /* need at least 1 key and 1 val */
 
+	if (map->percpu) {
+		map->pcpu_hits = alloc_percpu(u64);
+		if (!map->pcpu_hits)
+			return -ENOMEM;
+	}
+
 	err = tracing_map_alloc_elts(map);
 	if (err)
 		return err;
@@ -873,10 +960,20 @@ static int cmp_entries_sum(const void *A, const void *B)
 	field = &elt_a->fields[sort_key->field_idx];
 	cmp_fn = field->cmp_fn;
 
-	val_a = &elt_a->fields[sort_key->field_idx].sum;
-	val_b = &elt_b->fields[sort_key->field_idx].sum;
+	if (elt_a->pcpu_sums) {
+		u64 sum_a, sum_b;
 
-	ret = cmp_fn(val_a, val_b);
+		sum_a = tracing_map_read_sum((struct tracing_map_elt *)elt_a,
+					     sort_key->field_idx);
+		sum_b = tracing_map_read_sum((struct tracing_map_elt *)elt_b,
+					     sort_key->field_idx);
+		ret = (sum_a > sum_b) ? 1 : ((sum_a < sum_b) ? -1 : 0);
+	} else {
+		val_a = &elt_a->fields[sort_key->field_idx].sum;
+		val_b = &elt_b->fields[sort_key->field_idx].sum;
+
+		ret = cmp_fn(val_a, val_b);
+	}
 	if (sort_key->descending)
 		ret = -ret;
 
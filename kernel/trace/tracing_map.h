@@ -142,6 +142,7 @@ struct tracing_map_elt {
 	bool				*var_set;
 	void				*key;
 	void				*private_data;
+	u64 __percpu			*pcpu_sums;
 };
 
 struct tracing_map_entry {
@@ -198,6 +199,8 @@ struct tracing_map {
 	unsigned int			n_vars;
 	atomic64_t			hits;
 	atomic64_t			drops;
+	bool				percpu;
+	u64 __percpu			*pcpu_hits;
 };
 
 /**
@@ -271,6 +274,8 @@ extern bool tracing_map_var_set(struct tracing_map_elt *elt, unsigned int i);
 extern u64 tracing_map_read_sum(struct tracing_map_elt *elt, unsigned int i);
 extern u64 tracing_map_read_var(struct tracing_map_elt *elt, unsigned int i);
 extern u64 tracing_map_read_var_once(struct tracing_map_elt *elt, unsigned int i);
+extern void tracing_map_set_percpu(struct tracing_map *map);
+extern u64 tracing_map_read_hits(struct tracing_map *map);
 
 extern int
 tracing_map_sort_entries(struct tracing_map *map,
@@ -55,6 +55,31 @@ void on_each_cpu_cond_mask(smp_cond_func_t cond_func, smp_call_func_t func,
 }
 EXPORT_SYMBOL(on_each_cpu_cond_mask);
 
+void on_each_cpu_batch_add(struct smp_call_batch *batch,
+			   const struct cpumask *mask,
+			   smp_call_func_t func, void *info)
+{
+	if (batch->nr == SMP_CALL_BATCH_MAX)
+		on_each_cpu_batch_flush(batch);
+
+	batch->calls[batch->nr].func = func;
+	batch->calls[batch->nr].info = info;
+	batch->calls[batch->nr].mask = mask;
+	batch->nr++;
+}
+EXPORT_SYMBOL(on_each_cpu_batch_add);
+
+void on_each_cpu_batch_flush(struct smp_call_batch *batch)
+{
+	unsigned int i;
+
+	for (i = 0; i < batch->nr; i++)
+		on_each_cpu_mask(batch->calls[i].mask, batch->calls[i].func,
+				 batch->calls[i].info, true);
+	batch->nr = 0;
+}
+EXPORT_SYMBOL(on_each_cpu_batch_flush);
+
 int smp_call_on_cpu(unsigned int cpu, int (*func)(void *), void *par, bool phys)
 {
 	int ret;
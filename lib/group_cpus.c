@@ -11,19 +11,40 @@
 
 #ifdef CONFIG_SMP
 
+/* CPUs sharing the last level cache with @cpu, as far as it is known */
+static const struct cpumask *grp_llc_mask(unsigned int cpu)
+{
+#ifdef CONFIG_SCHED_MC
+	return cpu_coregroup_mask(cpu);
+#else
+	return cpumask_of_node(cpu_to_node(cpu));
+#endif
+}
+
+/*
+ * Fill @irqmsk with @cpus_per_grp CPUs from @nmsk, taking whole cores and
+ * staying within the LLC of the previously picked CPU @last as long as it
+ * has CPUs left, so that groups only straddle LLCs when they have to.
+ */
 static void grp_spread_init_one(struct cpumask *irqmsk, struct cpumask *nmsk,
-				unsigned int cpus_per_grp)
+				unsigned int cpus_per_grp, int *last)
 {
 	const struct cpumask *siblmsk;
 	int cpu, sibl;
 
 	for ( ; cpus_per_grp > 0; ) {
-		cpu = cpumask_first(nmsk);
+		cpu = nr_cpu_ids;
+		if (*last >= 0)
+			cpu = cpumask_first_and(nmsk, grp_llc_mask(*last));
+		if (cpu >= nr_cpu_ids)
+			cpu = cpumask_first(nmsk);
 
 		/* Should not happen, but I'm too lazy to think about it */
 		if (cpu >= nr_cpu_ids)
 			return;
 
+		*last = cpu;
+
 		cpumask_clear_cpu(cpu, nmsk);
 		cpumask_set_cpu(cpu, irqmsk);
 		cpus_per_grp--;
@@ -256,6 +277,7 @@ static int __group_cpus_evenly(unsigned int startgrp, unsigned int numgrps,
 	unsigned int curgrp = startgrp;
 	nodemask_t nodemsk = NODE_MASK_NONE;
 	struct node_groups *node_groups;
+	int last;
 
 	if (cpumask_empty(cpu_mask))
 		return 0;
@@ -305,6 +327,7 @@ static int __group_cpus_evenly(unsigned int startgrp, unsigned int numgrps,
 		extra_grps = ncpus - nv->ngroups * (ncpus / nv->ngroups);
 
 		/* Spread allocated groups on CPUs of the current node */
+		last = -1;
 		for (v = 0; v < nv->ngroups; v++, curgrp++) {
 			cpus_per_grp = ncpus / nv->ngroups;
 
@@ -321,7 +344,7 @@ static int __group_cpus_evenly(unsigned int startgrp, unsigned int numgrps,
 			if (curgrp >= last_grp)
 				curgrp = 0;
 			grp_spread_init_one(&masks[curgrp], nmsk,
-						cpus_per_grp);
+						cpus_per_grp, &last);
 		}
 		done += nv->ngroups;
 	}
@@ -423,6 +446,35 @@ struct cpumask *group_cpus_evenly(unsigned int numgrps)
 	}
 	return masks;
 }
+
+/**
+ * group_cpus_nr_llcs - Count the last level caches of the online CPUs
+ *
+ * Return: the number of groups group_cpus_evenly() should be asked for to
+ * get one group per LLC, falling back to one per node when the LLC layout
+ * is not known.
+ */
+unsigned int group_cpus_nr_llcs(void)
+{
+	unsigned int cpu, nr = 0;
+	cpumask_var_t seen;
+
+	if (!zalloc_cpumask_var(&seen, GFP_KERNEL))
+		return num_online_nodes();
+
+	cpus_read_lock();
+	for_each_online_cpu(cpu) {
+		if (cpumask_test_cpu(cpu, seen))
+			continue;
+		cpumask_or(seen, seen, grp_llc_mask(cpu));
+		cpumask_set_cpu(cpu, seen);
+		nr++;
+	}
+	cpus_read_unlock();
+
+	free_cpumask_var(seen);
+	return nr;
+}
 #else /* CONFIG_SMP */
 struct cpumask *group_cpus_evenly(unsigned int numgrps)
 {
@@ -435,5 +487,11 @@ struct cpumask *group_cpus_evenly(unsigned int numgrps)
 	cpumask_copy(&masks[0], cpu_possible_mask);
 	return masks;
 }
+
+unsigned int group_cpus_nr_llcs(void)
+{
+	return 1;
+}
 #endif /* CONFIG_SMP */
 EXPORT_SYMBOL_GPL(group_cpus_evenly);
+EXPORT_SYMBOL_GPL(group_cpus_nr_llcs);
@@ -9,6 +9,8 @@
 #include <linux/cpu.h>
 #include <linux/module.h>
 #include <linux/debugobjects.h>
+#include <linux/slab.h>
+#include <linux/topology.h>
 
 #ifdef CONFIG_HOTPLUG_CPU
 static LIST_HEAD(percpu_counters);
@@ -57,6 +59,151 @@ static inline void debug_percpu_counter_deactivate(struct percpu_counter *fbc)
 { }
 #endif	/* CONFIG_DEBUG_OBJECTS_PERCPU_COUNTER */
 
+#ifdef CONFIG_NUMA
+/*
+ * Per-node sums of a percpu_counter.
+ *
+ * With percpu_counter_enable_node_sums(), a per cpu count which reaches the
+ * batch is folded into the sum of the node of its CPU, under a lock of that
+ * node, instead of into fbc->count under fbc->lock. Both are node-local, so
+ * are not bounced between all the CPUs of a big machine. fbc->count still
+ * receives the counts of dead CPUs and percpu_counter_set().
+ *
+ * percpu_counter_read() then adds up fbc->count and the node sums, which
+ * costs O(nodes) and has the usual precision of batch * num_online_cpus().
+ * percpu_counter_sum() still needs to walk all the CPUs, but only takes the
+ * lock of a node while adding up that node.
+ *
+ * The lock order is fbc->lock, then the lock of a node.
+ */
+struct percpu_counter_node {
+	raw_spinlock_t lock;
+	s64 count;
+} ____cacheline_aligned_in_smp;
+
+#define percpu_counter_has_nodes(fbc)		unlikely((fbc)->nodes)
+
+static void percpu_counter_free_nodes(struct percpu_counter *fbc)
+{
+	int node;
+
+	if (!fbc->nodes)
+		return;
+
+	for_each_node(node)
+		kfree(fbc->nodes[node]);
+	kfree(fbc->nodes);
+	fbc->nodes = NULL;
+}
+
+/**
+ * percpu_counter_enable_node_sums - fold a percpu_counter per node
+ * @fbc: an initialized percpu_counter, not yet in concurrent use
+ * @gfp: allocation mask
+ *
+ * Make @fbc fold its per cpu counts into per-node sums, for counters which
+ * are both updated and read frequently on machines with many CPUs. Not to
+ * be used with percpu_counter_limited_add(). Returns 0 or -ENOMEM, in which
+ * case @fbc keeps working as before.
+ */
+int percpu_counter_enable_node_sums(struct percpu_counter *fbc, gfp_t gfp)
+{
+	struct percpu_counter_node **nodes;
+	int node;
+
+	if (num_possible_nodes() == 1)
+		return 0;
+
+	nodes = kcalloc(nr_node_ids, sizeof(*nodes), gfp);
+	if (!nodes)
+		return -ENOMEM;
+	fbc->nodes = nodes;
+
+	for_each_node(node) {
+		nodes[node] = kzalloc_node(sizeof(**nodes), gfp, node);
+		if (!nodes[node]) {
+			percpu_counter_free_nodes(fbc);
+			return -ENOMEM;
+		}
+		raw_spin_lock_init(&nodes[node]->lock);
+	}
+
+	return 0;
+}
+EXPORT_SYMBOL(percpu_counter_enable_node_sums);
+
+s64 __percpu_counter_read_nodes(struct percpu_counter *fbc)
+{
+	s64 ret = READ_ONCE(fbc->count);
+	int node;
+
+	for_each_node(node)
+		ret += READ_ONCE(fbc->nodes[node]->count);
+	return ret;
+}
+EXPORT_SYMBOL(__percpu_counter_read_nodes);
+
+/* Fold this CPU's count and @amount into the sum of its node. */
+static void percpu_counter_fold_node(struct percpu_counter *fbc, s64 amount)
+{
+	struct percpu_counter_node *pcn;
+	unsigned long flags;
+	s64 count;
+
+	local_irq_save(flags);
+	pcn = fbc->nodes[numa_node_id()];
+	raw_spin_lock(&pcn->lock);
+	count = __this_cpu_read(*fbc->counters);
+	WRITE_ONCE(pcn->count, pcn->count + count + amount);
+	__this_cpu_sub(*fbc->counters, count);
+	raw_spin_unlock(&pcn->lock);
+	local_irq_restore(flags);
+}
+
+/* Add up the node sums and per cpu counts, with fbc->lock held. */
+static s64 percpu_counter_sum_nodes(struct percpu_counter *fbc)
+{
+	s64 ret = fbc->count;
+	int node, cpu;
+
+	for_each_node(node) {
+		struct percpu_counter_node *pcn = fbc->nodes[node];
+
+		raw_spin_lock(&pcn->lock);
+		ret += pcn->count;
+		for_each_cpu_or(cpu, cpu_online_mask, cpu_dying_mask) {
+			if (cpu_to_node(cpu) == node)
+				ret += *per_cpu_ptr(fbc->counters, cpu);
+		}
+		raw_spin_unlock(&pcn->lock);
+	}
+	return ret;
+}
+
+static void percpu_counter_set_nodes(struct percpu_counter *fbc)
+{
+	int node;
+
+	for_each_node(node) {
+		struct percpu_counter_node *pcn = fbc->nodes[node];
+
+		raw_spin_lock(&pcn->lock);
+		WRITE_ONCE(pcn->count, 0);
+		raw_spin_unlock(&pcn->lock);
+	}
+}
+#else
+#define percpu_counter_has_nodes(fbc)		false
+static inline void percpu_counter_free_nodes(struct percpu_counter *fbc) { }
+static inline void percpu_counter_fold_node(struct percpu_counter *fbc,
+					    s64 amount) { }
+static inline s64 percpu_counter_sum_nodes(struct percpu_counter *fbc)
+{
+	return 0;
+}
+static inline void percpu_counter_set_nodes(struct percpu_counter *fbc) { }
+#endif
+
 void percpu_counter_set(struct percpu_counter *fbc, s64 amount)
 {
 	int cpu;
@@ -67,6 +214,8 @@ void percpu_counter_set(struct percpu_counter *fbc, s64 amount)
 		s32 *pcount = per_cpu_ptr(fbc->counters, cpu);
 		*pcount = 0;
 	}
+	if (percpu_counter_has_nodes(fbc))
+		percpu_counter_set_nodes(fbc);
 	fbc->count = amount;
 	raw_spin_unlock_irqrestore(&fbc->lock, flags);
 }
@@ -98,6 +247,10 @@ void percpu_counter_add_batch(struct percpu_counter *fbc, s64 amount, s32 batch)
 	count = this_cpu_read(*fbc->counters);
 	do {
 		if (unlikely(abs(count + amount) >= batch)) {
+			if (percpu_counter_has_nodes(fbc)) {
+				percpu_counter_fold_node(fbc, amount);
+				return;
+			}
 			raw_spin_lock_irqsave(&fbc->lock, flags);
 			/*
 			 * Note: by now we might have migrated to another CPU
@@ -124,7 +277,9 @@ void percpu_counter_add_batch(struct percpu_counter *fbc, s64 amount, s32 batch)
 
 	local_irq_save(flags);
 	count = __this_cpu_read(*fbc->counters) + amount;
-	if (abs(count) >= batch) {
+	if (abs(count) >= batch && percpu_counter_has_nodes(fbc)) {
+		percpu_counter_fold_node(fbc, amount);
+	} else if (abs(count) >= batch) {
 		raw_spin_lock(&fbc->lock);
 		fbc->count += count;
 		__this_cpu_sub(*fbc->counters, count - amount);
@@ -148,6 +303,11 @@ void percpu_counter_sync(struct percpu_counter *fbc)
 	unsigned long flags;
 	s64 count;
 
+	if (percpu_counter_has_nodes(fbc)) {
+		percpu_counter_fold_node(fbc, 0);
+		return;
+	}
+
 	raw_spin_lock_irqsave(&fbc->lock, flags);
 	count = __this_cpu_read(*fbc->counters);
 	fbc->count += count;
@@ -175,6 +335,11 @@ s64 __percpu_counter_sum(struct percpu_counter *fbc)
 	unsigned long flags;
 
 	raw_spin_lock_irqsave(&fbc->lock, flags);
+	if (percpu_counter_has_nodes(fbc)) {
+		ret = percpu_counter_sum_nodes(fbc);
+		raw_spin_unlock_irqrestore(&fbc->lock, flags);
+		return ret;
+	}
 	ret = fbc->count;
 	for_each_cpu_or(cpu, cpu_online_mask, cpu_dying_mask) {
 		s32 *pcount = per_cpu_ptr(fbc->counters, cpu);
@@ -210,6 +375,9 @@ int __percpu_counter_init_many(struct percpu_counter *fbc, s64 amount,
 #endif
 		fbc[i].count = amount;
 		fbc[i].counters = (void __percpu *)counters + i * counter_size;
+#ifdef CONFIG_NUMA
+		fbc[i].nodes = NULL;
+#endif
 
 		debug_percpu_counter_activate(&fbc[i]);
 	}
@@ -235,8 +403,10 @@ void percpu_counter_destroy_many(struct percpu_counter *fbc, u32 nr_counters)
 	if (!fbc[0].counters)
 		return;
 
-	for (i = 0; i < nr_counters; i++)
+	for (i = 0; i < nr_counters; i++) {
 		debug_percpu_counter_deactivate(&fbc[i]);
+		percpu_counter_free_nodes(&fbc[i]);
+	}
 
 #ifdef CONFIG_HOTPLUG_CPU
 	spin_lock_irqsave(&percpu_counters_lock, flags);
@@ -335,6 +505,9 @@ bool __percpu_counter_limited_add(struct percpu_counter *fbc,
 	if (amount == 0)
 		return true;
 
+	/* The checks below ignore the node sums */
+	WARN_ON_ONCE(percpu_counter_has_nodes(fbc));
+
 	local_irq_save(flags);
 	unknown = batch * num_online_cpus();
 	count = __this_cpu_read(*fbc->counters);
@@ -446,6 +446,7 @@ int sbitmap_queue_init_node(struct sbitmap_queue *sbq, unsigned int depth,
 	atomic_set(&sbq->ws_active, 0);
 	atomic_set(&sbq->completion_cnt, 0);
 	atomic_set(&sbq->wakeup_cnt, 0);
+	sbq->cache = NULL;
 
 	sbq->ws = kzalloc_node(SBQ_WAIT_QUEUES * sizeof(*sbq->ws), flags, node);
 	if (!sbq->ws) {
@@ -490,8 +491,176 @@ void sbitmap_queue_resize(struct sbitmap_queue *sbq, unsigned int depth)
 }
 EXPORT_SYMBOL_GPL(sbitmap_queue_resize);
 
+/*
+ * A per-cpu cache of free bits. Bits are taken from the bitmap SBQ_CACHE_BATCH
+ * at a time when the cache is empty, and put back SBQ_CACHE_BATCH at a time
+ * when it is full. The lock is only contended when a CPU steals from the cache
+ * of another one, as the bitmap ran out of free bits.
+ */
+#define SBQ_CACHE_SIZE		8
+#define SBQ_CACHE_BATCH		(SBQ_CACHE_SIZE / 2)
+
+struct sbq_cache {
+	spinlock_t lock;
+	unsigned int nr;
+	unsigned int bits[SBQ_CACHE_SIZE];
+};
+
+int sbitmap_queue_enable_cache(struct sbitmap_queue *sbq, gfp_t flags)
+{
+	struct sbq_cache __percpu *cache;
+	int cpu;
+
+	if (sbq->sb.round_robin)
+		return 0;
+
+	cache = alloc_percpu_gfp(struct sbq_cache, flags);
+	if (!cache)
+		return -ENOMEM;
+
+	for_each_possible_cpu(cpu)
+		spin_lock_init(&per_cpu_ptr(cache, cpu)->lock);
+	sbq->cache = cache;
+	return 0;
+}
+EXPORT_SYMBOL_GPL(sbitmap_queue_enable_cache);
+
+/* Put back @nr bits from the bottom of @c to the bitmap, with @c->lock held. */
+static void sbq_cache_flush(struct sbitmap_queue *sbq, struct sbq_cache *c,
+			    unsigned int nr)
+{
+	unsigned int i;
+
+	/* See sbitmap_queue_clear() */
+	smp_mb__before_atomic();
+	for (i = 0; i < nr; i++)
+		sbitmap_deferred_clear_bit(&sbq->sb, c->bits[i]);
+	c->nr -= nr;
+	memmove(c->bits, c->bits + nr, c->nr * sizeof(c->bits[0]));
+	smp_mb__after_atomic();
+	sbitmap_queue_wake_up(sbq, nr);
+}
+
+/* Take a bit from @c, dropping those beyond a shrunk depth. */
+static int sbq_cache_pop(struct sbitmap_queue *sbq, struct sbq_cache *c)
+{
+	unsigned int depth = READ_ONCE(sbq->sb.depth);
+
+	while (c->nr) {
+		unsigned int nr = c->bits[--c->nr];
+
+		if (likely(nr < depth))
+			return nr;
+		sbitmap_deferred_clear_bit(&sbq->sb, nr);
+	}
+	return -1;
+}
+
+/* The bitmap ran out of free bits, look for one in the other caches. */
+static int sbq_cache_steal(struct sbitmap_queue *sbq)
+{
+	unsigned long flags;
+	int cpu, nr = -1;
+
+	for_each_possible_cpu(cpu) {
+		struct sbq_cache *c = per_cpu_ptr(sbq->cache, cpu);
+
+		if (!READ_ONCE(c->nr))
+			continue;
+
+		spin_lock_irqsave(&c->lock, flags);
+		nr = sbq_cache_pop(sbq, c);
+		spin_unlock_irqrestore(&c->lock, flags);
+		if (nr >= 0)
+			break;
+	}
+	return nr;
+}
+
+static int sbq_cache_get(struct sbitmap_queue *sbq)
+{
+	/* Any cache will do after a migration, the lock protects it */
+	struct sbq_cache *c = raw_cpu_ptr(sbq->cache);
+	unsigned long flags, mask;
+	unsigned int offset;
+	int nr;
+
+	spin_lock_irqsave(&c->lock, flags);
+	nr = sbq_cache_pop(sbq, c);
+	if (nr >= 0)
+		goto out;
+
+	/* Keep the first bit of a batch, and cache the others */
+	mask = __sbitmap_queue_get_batch(sbq, SBQ_CACHE_BATCH, &offset);
+	if (mask) {
+		nr = offset + __ffs(mask);
+		mask &= mask - 1;
+		while (mask) {
+			c->bits[c->nr++] = offset + __ffs(mask);
+			mask &= mask - 1;
+		}
+		goto out;
+	}
+
+	nr = sbitmap_get(&sbq->sb);
+	spin_unlock_irqrestore(&c->lock, flags);
+	if (nr < 0)
+		nr = sbq_cache_steal(sbq);
+	return nr;
+out:
+	spin_unlock_irqrestore(&c->lock, flags);
+	return nr;
+}
+
+static void sbq_cache_put(struct sbitmap_queue *sbq, unsigned int nr)
+{
+	struct sbq_cache *c = raw_cpu_ptr(sbq->cache);
+	unsigned long flags;
+
+	spin_lock_irqsave(&c->lock, flags);
+	if (c->nr == SBQ_CACHE_SIZE)
+		sbq_cache_flush(sbq, c, SBQ_CACHE_BATCH);
+	c->bits[c->nr++] = nr;
+
+	/*
+	 * Pairs with the memory barrier in sbitmap_prepare_to_wait(): either
+	 * the waiter finds the bit when stealing it before going to sleep, or
+	 * we see the waiter and make the bits of this cache available to it.
+	 */
+	smp_mb();
+	if (atomic_read(&sbq->ws_active))
+		sbq_cache_flush(sbq, c, c->nr);
+
+	spin_unlock_irqrestore(&c->lock, flags);
+}
+
+void sbitmap_queue_flush_cache(struct sbitmap_queue *sbq)
+{
+	unsigned long flags;
+	int cpu;
+
+	if (!sbq->cache)
+		return;
+
+	for_each_possible_cpu(cpu) {
+		struct sbq_cache *c = per_cpu_ptr(sbq->cache, cpu);
+
+		if (!READ_ONCE(c->nr))
+			continue;
+
+		spin_lock_irqsave(&c->lock, flags);
+		if (c->nr)
+			sbq_cache_flush(sbq, c, c->nr);
+		spin_unlock_irqrestore(&c->lock, flags);
+	}
+}
+EXPORT_SYMBOL_GPL(sbitmap_queue_flush_cache);
+
 int __sbitmap_queue_get(struct sbitmap_queue *sbq)
 {
+	if (sbq->cache)
+		return sbq_cache_get(sbq);
+
 	return sbitmap_get(&sbq->sb);
 }
 EXPORT_SYMBOL_GPL(__sbitmap_queue_get);
@@ -670,6 +839,11 @@ void sbitmap_queue_clear(struct sbitmap_queue *sbq, unsigned int nr,
 	 * One invariant is that the clear bit has to be zero when the bit
 	 * is in use.
 	 */
+	if (sbq->cache && likely(nr < READ_ONCE(sbq->sb.depth))) {
+		sbq_cache_put(sbq, nr);
+		return;
+	}
+
 	smp_mb__before_atomic();
 	sbitmap_deferred_clear_bit(&sbq->sb, nr);
 
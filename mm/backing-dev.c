@@ -456,6 +456,57 @@ static ssize_t strict_limit_show(struct device *dev,
 }
 static DEVICE_ATTR_RW(strict_limit);
 
+static ssize_t writeback_threads_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct backing_dev_info *bdi = dev_get_drvdata(dev);
+	unsigned int threads;
+	ssize_t ret;
+
+	ret = kstrtouint(buf, 10, &threads);
+	if (ret < 0)
+		return ret;
+	if (!threads || threads > BDI_MAX_WB_THREADS)
+		return -EINVAL;
+
+	WRITE_ONCE(bdi->wb_threads, threads);
+	return count;
+}
+
+static ssize_t writeback_threads_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct backing_dev_info *bdi = dev_get_drvdata(dev);
+
+	return sysfs_emit(buf, "%u\n", READ_ONCE(bdi->wb_threads));
+}
+static DEVICE_ATTR_RW(writeback_threads);
+
+static ssize_t read_ahead_history_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct backing_dev_info *bdi = dev_get_drvdata(dev);
+	bool enable;
+	ssize_t ret;
+
+	ret = kstrtobool(buf, &enable);
+	if (ret < 0)
+		return ret;
+
+	WRITE_ONCE(bdi->ra_history, enable);
+
+	return count;
+}
+
+static ssize_t read_ahead_history_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct backing_dev_info *bdi = dev_get_drvdata(dev);
+
+	return sysfs_emit(buf, "%d\n", READ_ONCE(bdi->ra_history));
+}
+static DEVICE_ATTR_RW(read_ahead_history);
+
 static struct attribute *bdi_dev_attrs[] = {
 	&dev_attr_read_ahead_kb.attr,
 	&dev_attr_min_ratio.attr,
@@ -466,6 +517,8 @@ static struct attribute *bdi_dev_attrs[] = {
 	&dev_attr_max_bytes.attr,
 	&dev_attr_stable_pages_required.attr,
 	&dev_attr_strict_limit.attr,
+	&dev_attr_read_ahead_history.attr,
+	&dev_attr_writeback_threads.attr,
 	NULL,
 };
 ATTRIBUTE_GROUPS(bdi_dev);
@@ -574,6 +627,8 @@ static void wb_shutdown(struct bdi_writeback *wb)
 	mod_delayed_work(bdi_wq, &wb->dwork, 0);
 	flush_delayed_work(&wb->dwork);
 	WARN_ON(!list_empty(&wb->work_list));
+	wait_var_event(&wb->nr_flush_helpers,
+		       !atomic_read(&wb->nr_flush_helpers));
 	flush_delayed_work(&wb->bw_dwork);
 }
 
@@ -1006,6 +1061,7 @@ int bdi_init(struct backing_dev_info *bdi)
 	bdi->min_ratio = 0;
 	bdi->max_ratio = 100 * BDI_RATIO_SCALE;
 	bdi->max_prop_frac = FPROP_FRAC_BASE;
+	bdi->wb_threads = 1;
 	INIT_LIST_HEAD(&bdi->bdi_list);
 	INIT_LIST_HEAD(&bdi->wb_list);
 	init_waitqueue_head(&bdi->wb_waitq);
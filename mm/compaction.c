@@ -1924,6 +1924,13 @@ static int sysctl_compact_unevictable_allowed __read_mostly = CONFIG_COMPACT_UNE
  * background. It takes values in the range [0, 100].
  */
 static unsigned int __read_mostly sysctl_compaction_proactiveness = 20;
+/*
+ * Alternatively or in addition, kcompactd keeps compacting proactively until
+ * each node has at least sysctl_compaction_target_blocks free blocks of
+ * sysctl_compaction_target_order. Zero blocks disables the target.
+ */
+static int __read_mostly sysctl_compaction_target_order = COMPACTION_HPAGE_ORDER;
+static unsigned long __read_mostly sysctl_compaction_target_blocks;
 static int sysctl_extfrag_threshold = 500;
 static int __read_mostly sysctl_compact_memory;
 
@@ -2260,11 +2267,52 @@ static unsigned int fragmentation_score_wmark(bool low)
 	return low ? wmark_low : min(wmark_low + 10, 100U);
 }
 
+/*
+ * Number of free blocks of the target order the node could hand out right
+ * now, counting higher order free pages as several blocks.
+ */
+static unsigned long node_free_target_blocks(pg_data_t *pgdat)
+{
+	int order = READ_ONCE(sysctl_compaction_target_order);
+	unsigned long blocks = 0;
+	int zoneid, o;
+
+	for (zoneid = 0; zoneid < MAX_NR_ZONES; zoneid++) {
+		struct zone *zone = &pgdat->node_zones[zoneid];
+
+		if (!populated_zone(zone))
+			continue;
+		for (o = order; o < NR_PAGE_ORDERS; o++)
+			blocks += data_race(zone->free_area[o].nr_free) << (o - order);
+	}
+
+	return blocks;
+}
+
+static bool compaction_target_unmet(pg_data_t *pgdat)
+{
+	unsigned long target = READ_ONCE(sysctl_compaction_target_blocks);
+
+	return target && node_free_target_blocks(pgdat) < target;
+}
+
+static bool proactive_compaction_enabled(void)
+{
+	return sysctl_compaction_proactiveness ||
+	       READ_ONCE(sysctl_compaction_target_blocks);
+}
+
 static bool should_proactive_compact_node(pg_data_t *pgdat)
 {
 	int wmark_high;
 
-	if (!sysctl_compaction_proactiveness || kswapd_is_running(pgdat))
+	if (!proactive_compaction_enabled() || kswapd_is_running(pgdat))
+		return false;
+
+	if (compaction_target_unmet(pgdat))
+		return true;
+
+	if (!sysctl_compaction_proactiveness)
 		return false;
 
 	wmark_high = fragmentation_score_wmark(false);
@@ -2308,7 +2356,8 @@ static enum compact_result __compact_finished(struct compact_control *cc)
 		score = fragmentation_score_zone(cc->zone);
 		wmark_low = fragmentation_score_wmark(true);
 
-		if (score > wmark_low)
+		if ((sysctl_compaction_proactiveness && score > wmark_low) ||
+		    compaction_target_unmet(pgdat))
 			ret = COMPACT_CONTINUE;
 		else
 			ret = COMPACT_SUCCESS;
@@ -2959,28 +3008,49 @@ static int compact_nodes(void)
 	return 0;
 }
 
+static void trigger_proactive_compaction(void)
+{
+	int nid;
+
+	for_each_online_node(nid) {
+		pg_data_t *pgdat = NODE_DATA(nid);
+
+		if (pgdat->proactive_compact_trigger)
+			continue;
+
+		pgdat->proactive_compact_trigger = true;
+		trace_mm_compaction_wakeup_kcompactd(pgdat->node_id, -1,
+						     pgdat->nr_zones - 1);
+		wake_up_interruptible(&pgdat->kcompactd_wait);
+	}
+}
+
 static int compaction_proactiveness_sysctl_handler(const struct ctl_table *table, int write,
 		void *buffer, size_t *length, loff_t *ppos)
 {
-	int rc, nid;
+	int rc;
 
 	rc = proc_dointvec_minmax(table, write, buffer, length, ppos);
 	if (rc)
 		return rc;
 
-	if (write && sysctl_compaction_proactiveness) {
-		for_each_online_node(nid) {
-			pg_data_t *pgdat = NODE_DATA(nid);
+	if (write && sysctl_compaction_proactiveness)
+		trigger_proactive_compaction();
 
-			if (pgdat->proactive_compact_trigger)
-				continue;
+	return 0;
+}
 
-			pgdat->proactive_compact_trigger = true;
-			trace_mm_compaction_wakeup_kcompactd(pgdat->node_id, -1,
-							     pgdat->nr_zones - 1);
-			wake_up_interruptible(&pgdat->kcompactd_wait);
-		}
-	}
+static int compaction_target_sysctl_handler(const struct ctl_table *table, int write,
+		void *buffer, size_t *length, loff_t *ppos)
+{
+	int rc;
+
+	rc = proc_doulongvec_minmax(table, write, buffer, length, ppos);
+	if (rc)
+		return rc;
+
+	if (write && sysctl_compaction_target_blocks)
+		trigger_proactive_compaction();
 
 	return 0;
 }
@@ -3193,7 +3263,7 @@ static int kcompactd(void *p)
 		 * Avoid the unnecessary wakeup for proactive compaction
 		 * when it is disabled.
 		 */
-		if (!sysctl_compaction_proactiveness)
+		if (!proactive_compaction_enabled())
 			timeout = MAX_SCHEDULE_TIMEOUT;
 		trace_mm_compaction_kcompactd_sleep(pgdat->node_id);
 		if (wait_event_freezable_timeout(pgdat->kcompactd_wait,
@@ -3221,15 +3291,23 @@ static int kcompactd(void *p)
 		timeout = default_timeout;
 		if (should_proactive_compact_node(pgdat)) {
 			unsigned int prev_score, score;
+			unsigned long prev_blocks, start;
 
 			prev_score = fragmentation_score_node(pgdat);
+			prev_blocks = node_free_target_blocks(pgdat);
+			start = jiffies;
 			compact_node(pgdat, true);
+			count_vm_event(KCOMPACTD_PROACTIVE);
+			count_vm_events(KCOMPACTD_PROACTIVE_MS,
+					jiffies_to_msecs(jiffies - start));
 			score = fragmentation_score_node(pgdat);
 			/*
-			 * Defer proactive compaction if the fragmentation
-			 * score did not go down i.e. no progress made.
+			 * Defer proactive compaction if neither the
+			 * fragmentation score went down nor free blocks of the
+			 * target order were gained i.e. no progress made.
 			 */
-			if (unlikely(score >= prev_score))
+			if (unlikely(score >= prev_score &&
+				     node_free_target_blocks(pgdat) <= prev_blocks))
 				timeout =
 				   default_timeout << COMPACT_MAX_DEFER_SHIFT;
 		}
@@ -3293,6 +3371,8 @@ static int proc_dointvec_minmax_warn_RT_change(const struct ctl_table *table,
 	return ret;
 }
 
+static const int page_order_max = MAX_PAGE_ORDER;
+
 static const struct ctl_table vm_compaction[] = {
 	{
 		.procname	= "compact_memory",
@@ -3310,6 +3390,22 @@ static const struct ctl_table vm_compaction[] = {
 		.extra1		= SYSCTL_ZERO,
 		.extra2		= SYSCTL_ONE_HUNDRED,
 	},
+	{
+		.procname	= "compaction_target_order",
+		.data		= &sysctl_compaction_target_order,
+		.maxlen		= sizeof(sysctl_compaction_target_order),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= SYSCTL_ZERO,
+		.extra2		= (void *)&page_order_max,
+	},
+	{
+		.procname	= "compaction_target_blocks",
+		.data		= &sysctl_compaction_target_blocks,
+		.maxlen		= sizeof(sysctl_compaction_target_blocks),
+		.mode		= 0644,
+		.proc_handler	= compaction_target_sysctl_handler,
+	},
 	{
 		.procname	= "extfrag_threshold",
 		.data		= &sysctl_extfrag_threshold,
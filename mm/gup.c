@@ -30,6 +30,7 @@
 struct follow_page_context {
 	struct dev_pagemap *pgmap;
 	unsigned int page_mask;
+	unsigned int nr_ptes;	/* PTEs mapping the same folio, see follow_pte_batch() */
 };
 
 static inline void sanity_check_pinned_pages(struct page **pages,
@@ -836,9 +837,40 @@ static inline bool can_follow_write_pte(pte_t pte, struct page *page,
 	return !userfaultfd_pte_wp(vma, pte);
 }
 
+/*
+ * Count how many of the PTEs from @ptep on map the following pages of the
+ * large folio @page belongs to and can be followed with @flags just like
+ * the first one. The caller takes the extra references of the whole batch
+ * once, as for a PMD-mapped folio.
+ */
+static unsigned int follow_pte_batch(struct vm_area_struct *vma,
+		unsigned long address, pte_t *ptep, pte_t pte,
+		struct page *page, unsigned int flags)
+{
+	struct folio *folio = page_folio(page);
+	unsigned long end = pmd_addr_end(address, vma->vm_end);
+	unsigned int max_nr, nr;
+
+	max_nr = min_t(unsigned long, (end - address) >> PAGE_SHIFT,
+		       folio_nr_pages(folio) - folio_page_idx(folio, page));
+
+	for (nr = 1; nr < max_nr; nr++) {
+		pte_t ptent = ptep_get(ptep + nr);
+
+		if (!pte_present(ptent) || pte_protnone(ptent) ||
+		    pte_pfn(ptent) != pte_pfn(pte) + nr)
+			break;
+		if (!pte_write(ptent) &&
+		    ((flags & FOLL_WRITE) ||
+		     gup_must_unshare(vma, flags, nth_page(page, nr))))
+			break;
+	}
+	return nr;
+}
+
 static struct page *follow_page_pte(struct vm_area_struct *vma,
 		unsigned long address, pmd_t *pmd, unsigned int flags,
-		struct dev_pagemap **pgmap)
+		struct follow_page_context *ctx)
 {
 	struct mm_struct *mm = vma->vm_mm;
 	struct folio *folio;
@@ -879,8 +911,8 @@ static struct page *follow_page_pte(struct vm_area_struct *vma,
 		 * case since they are only valid while holding the pgmap
 		 * reference.
 		 */
-		*pgmap = get_dev_pagemap(pte_pfn(pte), *pgmap);
-		if (*pgmap)
+		ctx->pgmap = get_dev_pagemap(pte_pfn(pte), ctx->pgmap);
+		if (ctx->pgmap)
 			page = pte_page(pte);
 		else
 			goto no_page;
@@ -929,6 +961,10 @@ static struct page *follow_page_pte(struct vm_area_struct *vma,
 			goto out;
 		}
 	}
+	if (folio_test_large(folio) && !pte_devmap(pte) &&
+	    (flags & (FOLL_GET | FOLL_PIN)))
+		ctx->nr_ptes = follow_pte_batch(vma, address, ptep, pte,
+						page, flags);
 	if (flags & FOLL_TOUCH) {
 		if ((flags & FOLL_WRITE) &&
 		    !pte_dirty(pte) && !folio_test_dirty(folio))
@@ -975,7 +1011,7 @@ static struct page *follow_pmd_mask(struct vm_area_struct *vma,
 		return no_page_table(vma, flags, address);
 	}
 	if (likely(!pmd_leaf(pmdval)))
-		return follow_page_pte(vma, address, pmd, flags, &ctx->pgmap);
+		return follow_page_pte(vma, address, pmd, flags, ctx);
 
 	if (pmd_protnone(pmdval) && !gup_can_follow_protnone(vma, flags))
 		return no_page_table(vma, flags, address);
@@ -988,14 +1024,14 @@ static struct page *follow_pmd_mask(struct vm_area_struct *vma,
 	}
 	if (unlikely(!pmd_leaf(pmdval))) {
 		spin_unlock(ptl);
-		return follow_page_pte(vma, address, pmd, flags, &ctx->pgmap);
+		return follow_page_pte(vma, address, pmd, flags, ctx);
 	}
 	if (pmd_trans_huge(pmdval) && (flags & FOLL_SPLIT_PMD)) {
 		spin_unlock(ptl);
 		split_huge_pmd(vma, pmd, address);
 		/* If pmd was left empty, stuff a page table in there quickly */
 		return pte_alloc(mm, pmd) ? ERR_PTR(-ENOMEM) :
-			follow_page_pte(vma, address, pmd, flags, &ctx->pgmap);
+			follow_page_pte(vma, address, pmd, flags, ctx);
 	}
 	page = follow_huge_pmd(vma, address, pmd, flags, ctx);
 	spin_unlock(ptl);
@@ -1082,6 +1118,7 @@ static struct page *follow_page_mask(struct vm_area_struct *vma,
 	vma_pgtable_walk_begin(vma);
 
 	ctx->page_mask = 0;
+	ctx->nr_ptes = 0;
 	pgd = pgd_offset(mm, address);
 
 	if (pgd_none(*pgd) || unlikely(pgd_bad(*pgd)))
@@ -1464,6 +1501,7 @@ static long __get_user_pages(struct mm_struct *mm,
 				if (ret)
 					goto out;
 				ctx.page_mask = 0;
+				ctx.nr_ptes = 0;
 				goto next_page;
 			}
 
@@ -1519,7 +1557,10 @@ static long __get_user_pages(struct mm_struct *mm,
 			goto out;
 		}
 next_page:
-		page_increm = 1 + (~(start >> PAGE_SHIFT) & ctx.page_mask);
+		if (ctx.nr_ptes > 1)
+			page_increm = ctx.nr_ptes;
+		else
+			page_increm = 1 + (~(start >> PAGE_SHIFT) & ctx.page_mask);
 		if (page_increm > nr_pages)
 			page_increm = nr_pages;
 
@@ -1535,7 +1576,8 @@ static long __get_user_pages(struct mm_struct *mm,
 			 * NOTE: here the page may not be the head page
 			 * e.g. when start addr is not thp-size aligned.
 			 * try_grab_folio() should have taken care of tail
-			 * pages.
+			 * pages. The folio may also be mapped by a batch of
+			 * PTEs, see follow_pte_batch().
 			 */
 			if (page_increm > 1) {
 				struct folio *folio = page_folio(page);
@@ -2371,7 +2413,7 @@ migrate_longterm_unpinnable_folios(struct list_head *movable_folio_list,
 				   struct pages_or_folios *pofs)
 {
 	int ret;
-	unsigned long i;
+	unsigned long i, j;
 
 	for (i = 0; i < pofs->nr_entries; i++) {
 		struct folio *folio = pofs_get_folio(pofs, i);
@@ -2399,10 +2441,14 @@ migrate_longterm_unpinnable_folios(struct list_head *movable_folio_list,
 		 * the reference obtained by __get_user_pages_locked().
 		 * Migrating folios have been added to movable_folio_list after
 		 * calling folio_isolate_lru() which takes a reference so the
-		 * folio won't be freed if it's migrating.
+		 * folio won't be freed if it's migrating. The pins of the
+		 * consecutive entries of a large folio go in one go.
 		 */
-		unpin_folio(folio);
-		pofs_clear_entry(pofs, i);
+		for (j = i; j < pofs->nr_entries &&
+			    pofs_get_folio(pofs, j) == folio; j++)
+			pofs_clear_entry(pofs, j);
+		gup_put_folio(folio, j - i, FOLL_PIN);
+		i = j - 1;
 	}
 
 	if (!list_empty(movable_folio_list)) {
@@ -208,6 +208,72 @@ unsigned long __thp_vma_allowable_orders(struct vm_area_struct *vma,
 	return orders;
 }
 
+/*
+ * Number of consistent samples after which the anonymous fault order of an mm
+ * is stepped down, or back up, by one enabled order.
+ */
+#define MTHP_ANON_ADAPT_SAMPLES	16
+
+/**
+ * mthp_anon_record_access - feed back how much of an anonymous mTHP is used
+ * @mm: mm mapping the folio
+ * @folio: PTE-mapped large anonymous folio
+ * @young: number of its pages found mapped young in @mm
+ *
+ * Called from the rmap walk of reclaim, before the access bits are cleared.
+ * Folios mostly accessed are a hit, folios mostly left untouched or unmapped
+ * are a waste, and the balance of the two drives mthp_anon_adapt_orders().
+ */
+void mthp_anon_record_access(struct mm_struct *mm, struct folio *folio,
+			     unsigned int young)
+{
+	unsigned int nr = folio_nr_pages(folio);
+	unsigned int demote;
+	int score;
+
+	if (young * 4 >= nr * 3) {
+		count_mthp_stat(folio_order(folio), MTHP_STAT_ANON_ACCESS_HIT);
+		score = atomic_inc_return(&mm->mthp_anon_score);
+		if (score < MTHP_ANON_ADAPT_SAMPLES)
+			return;
+
+		atomic_set(&mm->mthp_anon_score, 0);
+		demote = READ_ONCE(mm->mthp_anon_demote);
+		if (demote)
+			WRITE_ONCE(mm->mthp_anon_demote, demote - 1);
+	} else if (young * 4 < nr) {
+		count_mthp_stat(folio_order(folio), MTHP_STAT_ANON_ACCESS_WASTE);
+		score = atomic_dec_return(&mm->mthp_anon_score);
+		if (score > -MTHP_ANON_ADAPT_SAMPLES)
+			return;
+
+		atomic_set(&mm->mthp_anon_score, 0);
+		demote = READ_ONCE(mm->mthp_anon_demote);
+		if (demote < PMD_ORDER)
+			WRITE_ONCE(mm->mthp_anon_demote, demote + 1);
+	}
+}
+
+/*
+ * Drop the highest of the enabled anonymous fault @orders that the access
+ * feedback of @mm found to be mostly wasted.
+ */
+unsigned long mthp_anon_adapt_orders(struct mm_struct *mm,
+				     unsigned long orders)
+{
+	unsigned int demote = READ_ONCE(mm->mthp_anon_demote);
+	int order;
+
+	if (!demote || !transparent_hugepage_anon_adaptive())
+		return orders;
+
+	order = highest_order(orders);
+	while (orders && demote--)
+		order = next_order(&orders, order);
+
+	return orders;
+}
+
 static bool get_huge_zero_page(void)
 {
 	struct folio *zero_folio;
@@ -438,6 +504,20 @@ static ssize_t use_zero_page_store(struct kobject *kobj,
 }
 static struct kobj_attribute use_zero_page_attr = __ATTR_RW(use_zero_page);
 
+static ssize_t anon_adaptive_show(struct kobject *kobj,
+				  struct kobj_attribute *attr, char *buf)
+{
+	return single_hugepage_flag_show(kobj, attr, buf,
+					 TRANSPARENT_HUGEPAGE_ANON_ADAPTIVE_FLAG);
+}
+static ssize_t anon_adaptive_store(struct kobject *kobj,
+		struct kobj_attribute *attr, const char *buf, size_t count)
+{
+	return single_hugepage_flag_store(kobj, attr, buf, count,
+				 TRANSPARENT_HUGEPAGE_ANON_ADAPTIVE_FLAG);
+}
+static struct kobj_attribute anon_adaptive_attr = __ATTR_RW(anon_adaptive);
+
 static ssize_t hpage_pmd_size_show(struct kobject *kobj,
 				   struct kobj_attribute *attr, char *buf)
 {
@@ -471,6 +551,7 @@ static struct attribute *hugepage_attr[] = {
 	&enabled_attr.attr,
 	&defrag_attr.attr,
 	&use_zero_page_attr.attr,
+	&anon_adaptive_attr.attr,
 	&hpage_pmd_size_attr.attr,
 #ifdef CONFIG_SHMEM
 	&shmem_enabled_attr.attr,
@@ -625,12 +706,18 @@ DEFINE_MTHP_STAT_ATTR(swpout_fallback, MTHP_STAT_SWPOUT_FALLBACK);
 DEFINE_MTHP_STAT_ATTR(shmem_alloc, MTHP_STAT_SHMEM_ALLOC);
 DEFINE_MTHP_STAT_ATTR(shmem_fallback, MTHP_STAT_SHMEM_FALLBACK);
 DEFINE_MTHP_STAT_ATTR(shmem_fallback_charge, MTHP_STAT_SHMEM_FALLBACK_CHARGE);
+DEFINE_MTHP_STAT_ATTR(shmem_swpin, MTHP_STAT_SHMEM_SWPIN);
+DEFINE_MTHP_STAT_ATTR(shmem_swpin_fallback, MTHP_STAT_SHMEM_SWPIN_FALLBACK);
+DEFINE_MTHP_STAT_ATTR(shmem_swpout, MTHP_STAT_SHMEM_SWPOUT);
+DEFINE_MTHP_STAT_ATTR(shmem_swpout_fallback, MTHP_STAT_SHMEM_SWPOUT_FALLBACK);
 #endif
 DEFINE_MTHP_STAT_ATTR(split, MTHP_STAT_SPLIT);
 DEFINE_MTHP_STAT_ATTR(split_failed, MTHP_STAT_SPLIT_FAILED);
 DEFINE_MTHP_STAT_ATTR(split_deferred, MTHP_STAT_SPLIT_DEFERRED);
 DEFINE_MTHP_STAT_ATTR(nr_anon, MTHP_STAT_NR_ANON);
 DEFINE_MTHP_STAT_ATTR(nr_anon_partially_mapped, MTHP_STAT_NR_ANON_PARTIALLY_MAPPED);
+DEFINE_MTHP_STAT_ATTR(anon_access_hit, MTHP_STAT_ANON_ACCESS_HIT);
+DEFINE_MTHP_STAT_ATTR(anon_access_waste, MTHP_STAT_ANON_ACCESS_WASTE);
 
 static struct attribute *anon_stats_attrs[] = {
 	&anon_fault_alloc_attr.attr,
@@ -647,6 +734,8 @@ static struct attribute *anon_stats_attrs[] = {
 	&split_deferred_attr.attr,
 	&nr_anon_attr.attr,
 	&nr_anon_partially_mapped_attr.attr,
+	&anon_access_hit_attr.attr,
+	&anon_access_waste_attr.attr,
 	NULL,
 };
 
@@ -660,6 +749,10 @@ static struct attribute *file_stats_attrs[] = {
 	&shmem_alloc_attr.attr,
 	&shmem_fallback_attr.attr,
 	&shmem_fallback_charge_attr.attr,
+	&shmem_swpin_attr.attr,
+	&shmem_swpin_fallback_attr.attr,
+	&shmem_swpout_attr.attr,
+	&shmem_swpout_fallback_attr.attr,
 #endif
 	NULL,
 };
@@ -82,6 +82,10 @@ __cacheline_aligned_in_smp DEFINE_SPINLOCK(hugetlb_lock);
 static int num_fault_mutexes __ro_after_init;
 struct mutex *hugetlb_fault_mutex_table __ro_after_init;
 
+/* Threads and non-temporal stores to zero gigantic folios with at fault */
+static unsigned int sysctl_hugetlb_zero_threads __read_mostly = 1;
+static bool sysctl_hugetlb_zero_nocache __read_mostly;
+
 /* Forward declaration */
 static int hugetlb_acct_memory(struct hstate *h, long delta);
 static void hugetlb_vma_lock_free(struct vm_area_struct *vma);
@@ -4898,6 +4902,21 @@ static const struct ctl_table hugetlb_table[] = {
 		.mode		= 0644,
 		.proc_handler	= hugetlb_overcommit_handler,
 	},
+	{
+		.procname	= "hugetlb_zero_threads",
+		.data		= &sysctl_hugetlb_zero_threads,
+		.maxlen		= sizeof(unsigned int),
+		.mode		= 0644,
+		.proc_handler	= proc_douintvec_minmax,
+		.extra1		= SYSCTL_ONE,
+	},
+	{
+		.procname	= "hugetlb_zero_nocache",
+		.data		= &sysctl_hugetlb_zero_nocache,
+		.maxlen		= sizeof(bool),
+		.mode		= 0644,
+		.proc_handler	= proc_dobool,
+	},
 };
 
 static void hugetlb_sysctl_init(void)
@@ -6091,6 +6110,108 @@ static bool hugetlb_pte_stable(struct hstate *h, struct mm_struct *mm, unsigned
 	return same;
 }
 
+/*
+ * Gigantic folios take long enough to zero at fault time that it is worth
+ * splitting the work in MAX_ORDER_NR_PAGES chunks among several threads,
+ * and optionally bypassing the caches, which zeroing a whole gigantic folio
+ * would otherwise flush.
+ */
+struct hugetlb_zero_control {
+	struct folio *folio;
+	unsigned long addr;
+	unsigned int nr_chunks;
+	atomic_t next_chunk;
+	bool nocache;
+};
+
+struct hugetlb_zero_work {
+	struct work_struct work;
+	struct hugetlb_zero_control *ctl;
+};
+
+static void hugetlb_zero_chunks(struct hugetlb_zero_control *ctl)
+{
+	unsigned int chunk;
+
+	while ((chunk = atomic_fetch_inc(&ctl->next_chunk)) < ctl->nr_chunks) {
+		unsigned long i = chunk * MAX_ORDER_NR_PAGES;
+		unsigned long end = i + MAX_ORDER_NR_PAGES;
+
+		for (; i < end; i++) {
+			struct page *page = folio_page(ctl->folio, i);
+			unsigned long addr = ctl->addr + i * PAGE_SIZE;
+
+			if (ctl->nocache)
+				clear_user_highpage_nocache(page, addr);
+			else
+				clear_user_highpage(page, addr);
+			cond_resched();
+		}
+	}
+
+	/* Order the non-temporal stores before the folio is mapped */
+	if (ctl->nocache)
+		wmb();
+}
+
+static void hugetlb_zero_workfn(struct work_struct *work)
+{
+	struct hugetlb_zero_work *w;
+
+	w = container_of(work, struct hugetlb_zero_work, work);
+	hugetlb_zero_chunks(w->ctl);
+}
+
+/**
+ * hugetlb_zero_folio - zero a hugetlb folio which will be mapped to userspace
+ * @folio: the folio to zero
+ * @addr_hint: the address that will be accessed, as for folio_zero_user()
+ *
+ * Gigantic folios are zeroed as set up with the vm.hugetlb_zero_threads and
+ * vm.hugetlb_zero_nocache sysctls, the others with folio_zero_user().
+ */
+void hugetlb_zero_folio(struct folio *folio, unsigned long addr_hint)
+{
+	unsigned int nr_threads = READ_ONCE(sysctl_hugetlb_zero_threads);
+	struct hugetlb_zero_control ctl = {
+		.folio = folio,
+		.addr = ALIGN_DOWN(addr_hint, folio_size(folio)),
+		.nr_chunks = folio_nr_pages(folio) / MAX_ORDER_NR_PAGES,
+		.next_chunk = ATOMIC_INIT(0),
+		.nocache = READ_ONCE(sysctl_hugetlb_zero_nocache),
+	};
+	struct hugetlb_zero_work *works = NULL;
+	unsigned int i, nr_works;
+
+	if (folio_nr_pages(folio) <= MAX_ORDER_NR_PAGES ||
+	    (nr_threads < 2 && !ctl.nocache)) {
+		folio_zero_user(folio, addr_hint);
+		return;
+	}
+
+	might_sleep();
+
+	nr_works = min3(nr_threads, ctl.nr_chunks, num_online_cpus()) - 1;
+	if (nr_works)
+		works = kcalloc(nr_works, sizeof(*works), GFP_KERNEL);
+	if (!works)
+		nr_works = 0;
+
+	for (i = 0; i < nr_works; i++) {
+		works[i].ctl = &ctl;
+		INIT_WORK(&works[i].work, hugetlb_zero_workfn);
+		queue_work(system_unbound_wq, &works[i].work);
+	}
+
+	hugetlb_zero_chunks(&ctl);
+
+	/* All chunks are taken, drop the helpers that did not start yet */
+	for (i = 0; i < nr_works; i++)
+		cancel_work_sync(&works[i].work);
+
+	kfree(works);
+}
+
 static vm_fault_t hugetlb_no_page(struct address_space *mapping,
 			struct vm_fault *vmf)
 {
@@ -6181,7 +6302,7 @@ static vm_fault_t hugetlb_no_page(struct address_space *mapping,
 				ret = 0;
 			goto out;
 		}
-		folio_zero_user(folio, vmf->real_address);
+		hugetlb_zero_folio(folio, vmf->real_address);
 		__folio_mark_uptodate(folio);
 		new_folio = true;
 
@@ -7,6 +7,15 @@
  *     Author: Muchun Song <songmuchun@bytedance.com>
  *
  * See Documentation/mm/vmemmap_dedup.rst
+ *
+ * Only HugeTLB folios are optimized here: once such a folio is set up its
+ * tail struct pages are not written to, and the vmemmap can be restored with
+ * a sleeping allocation before the folio is freed, demoted or poisoned. The
+ * tail pages of a THP carry the per-page mapcounts once it is PTE-mapped,
+ * which happens, like splitting it, under page table locks, so they cannot
+ * be shared read-only. ZONE_DEVICE memory with a compound dev_pagemap gets
+ * the same sharing when its vmemmap is populated, see
+ * vmemmap_populate_compound_pages().
  */
 #define pr_fmt(fmt)	"HugeTLB: " fmt
 
@@ -765,6 +765,7 @@ extern void zone_pcp_reset(struct zone *zone);
 extern void zone_pcp_disable(struct zone *zone);
 extern void zone_pcp_enable(struct zone *zone);
 extern void zone_pcp_init(struct zone *zone);
+extern unsigned int zone_shard_cpus;
 
 extern void *memmap_alloc(phys_addr_t size, phys_addr_t align,
 			  phys_addr_t min_addr,
@@ -1051,6 +1052,7 @@ static inline void vunmap_range_noflush(unsigned long start, unsigned long end)
 DECLARE_STATIC_KEY_TRUE(deferred_pages);
 
 bool __init deferred_grow_zone(struct zone *zone, unsigned int order);
+bool __init deferred_init_wait(void);
 #endif /* CONFIG_DEFERRED_STRUCT_PAGE_INIT */
 
 enum mminit_level {
@@ -1274,6 +1276,7 @@ void __vunmap_range_noflush(unsigned long start, unsigned long end);
 int numa_migrate_check(struct folio *folio, struct vm_fault *vmf,
 		      unsigned long addr, int *flags, bool writable,
 		      int *last_cpupid);
+void numa_promote_work(struct work_struct *work);
 
 void free_zone_device_folio(struct folio *folio);
 int migrate_device_coherent_folio(struct folio *folio);
@@ -65,7 +65,6 @@ enum scan_result {
 #define CREATE_TRACE_POINTS
 #include <trace/events/huge_memory.h>
 
-static struct task_struct *khugepaged_thread __read_mostly;
 static DEFINE_MUTEX(khugepaged_mutex);
 
 /* default scan 8*512 pte (or vmas) every 30 second */
@@ -107,29 +106,47 @@ struct collapse_control {
 /**
  * struct khugepaged_mm_slot - khugepaged information per mm that is being scanned
  * @slot: hash lookup from mm to mm_slot
+ * @busy: a khugepaged worker is scanning this mm, or will next
+ * @hot: the mm is on khugepaged_hot_head, see khugepaged_mm_hot()
  */
 struct khugepaged_mm_slot {
 	struct mm_slot slot;
+	bool busy;
+	bool hot;
 };
 
 /**
  * struct khugepaged_scan - cursor for scanning
- * @mm_head: the head of the mm list to scan
  * @mm_slot: the current mm_slot we are scanning
+ * @resume: the mm_slot to go back to after scanning a hot mm
  * @address: the next address inside that to be scanned
  *
- * There is only the one khugepaged_scan instance of this cursor structure.
+ * There is one khugepaged_scan instance of this cursor structure per
+ * khugepaged worker. They all walk khugepaged_mm_head, after the mms of
+ * khugepaged_hot_head, and skip the mm_slots marked busy by another worker.
  */
 struct khugepaged_scan {
-	struct list_head mm_head;
 	struct khugepaged_mm_slot *mm_slot;
+	struct khugepaged_mm_slot *resume;
 	unsigned long address;
 };
 
-static struct khugepaged_scan khugepaged_scan = {
-	.mm_head = LIST_HEAD_INIT(khugepaged_scan.mm_head),
+static LIST_HEAD(khugepaged_mm_head);
+static LIST_HEAD(khugepaged_hot_head);
+
+/*
+ * There is one khugepaged worker per node with memory, so that collapse
+ * keeps up with the amount of memory to scan.
+ */
+struct khugepaged_worker {
+	struct task_struct *thread;
+	struct khugepaged_scan scan;
+	struct collapse_control cc;
 };
 
+static struct khugepaged_worker *khugepaged_workers[MAX_NUMNODES];
+static unsigned int khugepaged_nr_workers;
+
 #ifdef CONFIG_SYSFS
 static ssize_t scan_sleep_millisecs_show(struct kobject *kobj,
 					 struct kobj_attribute *attr,
@@ -460,8 +477,8 @@ void __khugepaged_enter(struct mm_struct *mm)
 	 * Insert just behind the scanning cursor, to let the area settle
 	 * down a little.
 	 */
-	wakeup = list_empty(&khugepaged_scan.mm_head);
-	list_add_tail(&slot->mm_node, &khugepaged_scan.mm_head);
+	wakeup = list_empty(&khugepaged_mm_head);
+	list_add_tail(&slot->mm_node, &khugepaged_mm_head);
 	spin_unlock(&khugepaged_mm_lock);
 
 	mmgrab(mm);
@@ -489,7 +506,7 @@ void __khugepaged_exit(struct mm_struct *mm)
 	spin_lock(&khugepaged_mm_lock);
 	slot = mm_slot_lookup(mm_slots_hash, mm);
 	mm_slot = mm_slot_entry(slot, struct khugepaged_mm_slot, slot);
-	if (mm_slot && khugepaged_scan.mm_slot != mm_slot) {
+	if (mm_slot && !mm_slot->busy) {
 		hash_del(&slot->hash);
 		list_del(&slot->mm_node);
 		free = 1;
@@ -847,10 +864,6 @@ static void khugepaged_alloc_sleep(void)
 	remove_wait_queue(&khugepaged_wait, &wait);
 }
 
-struct collapse_control khugepaged_collapse_control = {
-	.is_khugepaged = true,
-};
-
 static bool hpage_collapse_scan_abort(int nid, struct collapse_control *cc)
 {
 	int i;
@@ -2365,11 +2378,116 @@ static int hpage_collapse_scan_file(struct mm_struct *mm, unsigned long addr,
 }
 #endif
 
-static unsigned int khugepaged_scan_mm_slot(unsigned int pages, int *result,
-					    struct collapse_control *cc)
+/*
+ * Find the first mm_slot no other worker is scanning on @head, after @pos.
+ */
+static struct khugepaged_mm_slot *khugepaged_idle_mm_slot(struct list_head *head,
+							  struct list_head *pos)
+{
+	lockdep_assert_held(&khugepaged_mm_lock);
+
+	for (pos = pos->next; pos != head; pos = pos->next) {
+		struct mm_slot *slot = list_entry(pos, struct mm_slot, mm_node);
+		struct khugepaged_mm_slot *mm_slot;
+
+		mm_slot = mm_slot_entry(slot, struct khugepaged_mm_slot, slot);
+		if (!mm_slot->busy)
+			return mm_slot;
+	}
+
+	return NULL;
+}
+
+/*
+ * Move the cursor on from @mm_slot, or from the head of the list if NULL:
+ * to a hot mm if there is one, else to the next mm in round-robin order.
+ * Returns false at the end of a full scan.
+ */
+static bool khugepaged_next_mm_slot(struct khugepaged_scan *scan,
+				    struct khugepaged_mm_slot *mm_slot)
+{
+	struct khugepaged_mm_slot *next = NULL, *hot;
+
+	lockdep_assert_held(&khugepaged_mm_lock);
+
+	if (!mm_slot)
+		next = khugepaged_idle_mm_slot(&khugepaged_mm_head,
+					       &khugepaged_mm_head);
+	else if (!mm_slot->hot)
+		next = khugepaged_idle_mm_slot(&khugepaged_mm_head,
+					       &mm_slot->slot.mm_node);
+
+	if (!next) {
+		next = scan->resume;
+		scan->resume = NULL;
+	}
+
+	hot = khugepaged_idle_mm_slot(&khugepaged_hot_head,
+				      &khugepaged_hot_head);
+	if (hot) {
+		/* Keep our place in the round-robin order */
+		if (next)
+			next->busy = true;
+		scan->resume = next;
+		next = hot;
+	}
+
+	scan->mm_slot = next;
+	scan->address = 0;
+	if (!next)
+		return false;
+
+	next->busy = true;
+	return true;
+}
+
+static void khugepaged_put_mm_slot(struct khugepaged_mm_slot *mm_slot)
+{
+	lockdep_assert_held(&khugepaged_mm_lock);
+
+	mm_slot->busy = false;
+	if (mm_slot->hot) {
+		mm_slot->hot = false;
+		list_move_tail(&mm_slot->slot.mm_node, &khugepaged_mm_head);
+	}
+	collect_mm_slot(mm_slot);
+}
+
+/**
+ * khugepaged_mm_hot - have khugepaged scan an mm ahead of the others
+ * @mm: mm whose page tables were just walked
+ * @nr_young: number of young PTEs and PMDs the walk found
+ *
+ * Called by the MGLRU aging after its page table walk of @mm. If @mm used at
+ * least a huge page worth of memory since the last walk, move it ahead, so
+ * that collapse reaches the hot mms first instead of waiting for its
+ * round-robin pass over all of them.
+ */
+void khugepaged_mm_hot(struct mm_struct *mm, unsigned long nr_young)
+{
+	struct khugepaged_mm_slot *mm_slot;
+	struct mm_slot *slot;
+
+	if (nr_young < HPAGE_PMD_NR || !test_bit(MMF_VM_HUGEPAGE, &mm->flags))
+		return;
+
+	spin_lock(&khugepaged_mm_lock);
+	slot = mm_slot_lookup(mm_slots_hash, mm);
+	mm_slot = mm_slot_entry(slot, struct khugepaged_mm_slot, slot);
+	if (mm_slot && !mm_slot->busy && !mm_slot->hot) {
+		mm_slot->hot = true;
+		list_move_tail(&slot->mm_node, &khugepaged_hot_head);
+	}
+	spin_unlock(&khugepaged_mm_lock);
+}
+
+static unsigned int khugepaged_scan_mm_slot(struct khugepaged_worker *worker,
+					    unsigned int pages, int *result)
 	__releases(&khugepaged_mm_lock)
 	__acquires(&khugepaged_mm_lock)
 {
+	struct khugepaged_scan *scan = &worker->scan;
+	struct collapse_control *cc = &worker->cc;
 	struct vma_iterator vmi;
 	struct khugepaged_mm_slot *mm_slot;
 	struct mm_slot *slot;
@@ -2381,16 +2499,12 @@ static unsigned int khugepaged_scan_mm_slot(unsigned int pages, int *result,
 	lockdep_assert_held(&khugepaged_mm_lock);
 	*result = SCAN_FAIL;
 
-	if (khugepaged_scan.mm_slot) {
-		mm_slot = khugepaged_scan.mm_slot;
-		slot = &mm_slot->slot;
-	} else {
-		slot = list_entry(khugepaged_scan.mm_head.next,
-				     struct mm_slot, mm_node);
-		mm_slot = mm_slot_entry(slot, struct khugepaged_mm_slot, slot);
-		khugepaged_scan.address = 0;
-		khugepaged_scan.mm_slot = mm_slot;
-	}
+	/* All the mms may be taken by other workers */
+	if (!scan->mm_slot && !khugepaged_next_mm_slot(scan, NULL))
+		return pages;
+
+	mm_slot = scan->mm_slot;
+	slot = &mm_slot->slot;
 	spin_unlock(&khugepaged_mm_lock);
 
 	mm = slot->mm;
@@ -2406,7 +2520,7 @@ static unsigned int khugepaged_scan_mm_slot(unsigned int pages, int *result,
 	if (unlikely(hpage_collapse_test_exit_or_disable(mm)))
 		goto breakouterloop;
 
-	vma_iter_init(&vmi, mm, khugepaged_scan.address);
+	vma_iter_init(&vmi, mm, scan->address);
 	for_each_vma(vmi, vma) {
 		unsigned long hstart, hend;
 
@@ -2423,52 +2537,52 @@ static unsigned int khugepaged_scan_mm_slot(unsigned int pages, int *result,
 		}
 		hstart = round_up(vma->vm_start, HPAGE_PMD_SIZE);
 		hend = round_down(vma->vm_end, HPAGE_PMD_SIZE);
-		if (khugepaged_scan.address > hend)
+		if (scan->address > hend)
 			goto skip;
-		if (khugepaged_scan.address < hstart)
-			khugepaged_scan.address = hstart;
-		VM_BUG_ON(khugepaged_scan.address & ~HPAGE_PMD_MASK);
+		if (scan->address < hstart)
+			scan->address = hstart;
+		VM_BUG_ON(scan->address & ~HPAGE_PMD_MASK);
 
-		while (khugepaged_scan.address < hend) {
+		while (scan->address < hend) {
 			bool mmap_locked = true;
 
 			cond_resched();
 			if (unlikely(hpage_collapse_test_exit_or_disable(mm)))
 				goto breakouterloop;
 
-			VM_BUG_ON(khugepaged_scan.address < hstart ||
-				  khugepaged_scan.address + HPAGE_PMD_SIZE >
+			VM_BUG_ON(scan->address < hstart ||
+				  scan->address + HPAGE_PMD_SIZE >
 				  hend);
 			if (IS_ENABLED(CONFIG_SHMEM) && !vma_is_anonymous(vma)) {
 				struct file *file = get_file(vma->vm_file);
 				pgoff_t pgoff = linear_page_index(vma,
-						khugepaged_scan.address);
+						scan->address);
 
 				mmap_read_unlock(mm);
 				mmap_locked = false;
 				*result = hpage_collapse_scan_file(mm,
-					khugepaged_scan.address, file, pgoff, cc);
+					scan->address, file, pgoff, cc);
 				fput(file);
 				if (*result == SCAN_PTE_MAPPED_HUGEPAGE) {
 					mmap_read_lock(mm);
 					if (hpage_collapse_test_exit_or_disable(mm))
 						goto breakouterloop;
 					*result = collapse_pte_mapped_thp(mm,
-						khugepaged_scan.address, false);
+						scan->address, false);
 					if (*result == SCAN_PMD_MAPPED)
 						*result = SCAN_SUCCEED;
 					mmap_read_unlock(mm);
 				}
 			} else {
 				*result = hpage_collapse_scan_pmd(mm, vma,
-					khugepaged_scan.address, &mmap_locked, cc);
+					scan->address, &mmap_locked, cc);
 			}
 
 			if (*result == SCAN_SUCCEED)
 				++khugepaged_pages_collapsed;
 
 			/* move to next address */
-			khugepaged_scan.address += HPAGE_PMD_SIZE;
+			scan->address += HPAGE_PMD_SIZE;
 			progress += HPAGE_PMD_NR;
 			if (!mmap_locked)
 				/*
@@ -2488,7 +2602,7 @@ static unsigned int khugepaged_scan_mm_slot(unsigned int pages, int *result,
 breakouterloop_mmap_lock:
 
 	spin_lock(&khugepaged_mm_lock);
-	VM_BUG_ON(khugepaged_scan.mm_slot != mm_slot);
+	VM_BUG_ON(scan->mm_slot != mm_slot);
 	/*
 	 * Release the current mm_slot if this mm is about to die, or
 	 * if we scanned all vmas of this mm.
@@ -2497,20 +2611,12 @@ static unsigned int khugepaged_scan_mm_slot(unsigned int pages, int *result,
 		/*
 		 * Make sure that if mm_users is reaching zero while
 		 * khugepaged runs here, khugepaged_exit will find
-		 * mm_slot not pointing to the exiting mm.
+		 * mm_slot not busy.
 		 */
-		if (slot->mm_node.next != &khugepaged_scan.mm_head) {
-			slot = list_entry(slot->mm_node.next,
-					  struct mm_slot, mm_node);
-			khugepaged_scan.mm_slot =
-				mm_slot_entry(slot, struct khugepaged_mm_slot, slot);
-			khugepaged_scan.address = 0;
-		} else {
-			khugepaged_scan.mm_slot = NULL;
+		if (!khugepaged_next_mm_slot(scan, mm_slot))
 			khugepaged_full_scans++;
-		}
 
-		collect_mm_slot(mm_slot);
+		khugepaged_put_mm_slot(mm_slot);
 	}
 
 	return progress;
@@ -2518,16 +2624,18 @@ static unsigned int khugepaged_scan_mm_slot(unsigned int pages, int *result,
 
 static int khugepaged_has_work(void)
 {
-	return !list_empty(&khugepaged_scan.mm_head) && hugepage_pmd_enabled();
+	return (!list_empty(&khugepaged_mm_head) ||
+		!list_empty(&khugepaged_hot_head)) && hugepage_pmd_enabled();
 }
 
 static int khugepaged_wait_event(void)
 {
-	return !list_empty(&khugepaged_scan.mm_head) ||
+	return !list_empty(&khugepaged_mm_head) ||
+		!list_empty(&khugepaged_hot_head) ||
 		kthread_should_stop();
 }
 
-static void khugepaged_do_scan(struct collapse_control *cc)
+static void khugepaged_do_scan(struct khugepaged_worker *worker)
 {
 	unsigned int progress = 0, pass_through_head = 0;
 	unsigned int pages = READ_ONCE(khugepaged_pages_to_scan);
@@ -2543,12 +2651,13 @@ static void khugepaged_do_scan(struct collapse_control *cc)
 			break;
 
 		spin_lock(&khugepaged_mm_lock);
-		if (!khugepaged_scan.mm_slot)
+		if (!worker->scan.mm_slot)
 			pass_through_head++;
 		if (khugepaged_has_work() &&
 		    pass_through_head < 2)
-			progress += khugepaged_scan_mm_slot(pages - progress,
-							    &result, cc);
+			progress += khugepaged_scan_mm_slot(worker,
+							    pages - progress,
+							    &result);
 		else
 			progress = pages;
 		spin_unlock(&khugepaged_mm_lock);
@@ -2595,27 +2704,83 @@ static void khugepaged_wait_work(void)
 		wait_event_freezable(khugepaged_wait, khugepaged_wait_event());
 }
 
-static int khugepaged(void *none)
+static int khugepaged(void *data)
 {
-	struct khugepaged_mm_slot *mm_slot;
+	struct khugepaged_worker *worker = data;
+	struct khugepaged_scan *scan = &worker->scan;
 
 	set_freezable();
 	set_user_nice(current, MAX_NICE);
 
 	while (!kthread_should_stop()) {
-		khugepaged_do_scan(&khugepaged_collapse_control);
+		khugepaged_do_scan(worker);
 		khugepaged_wait_work();
 	}
 
 	spin_lock(&khugepaged_mm_lock);
-	mm_slot = khugepaged_scan.mm_slot;
-	khugepaged_scan.mm_slot = NULL;
-	if (mm_slot)
-		collect_mm_slot(mm_slot);
+	if (scan->mm_slot)
+		khugepaged_put_mm_slot(scan->mm_slot);
+	if (scan->resume)
+		khugepaged_put_mm_slot(scan->resume);
+	scan->mm_slot = NULL;
+	scan->resume = NULL;
 	spin_unlock(&khugepaged_mm_lock);
 	return 0;
 }
 
+static int khugepaged_start_worker(int nid)
+{
+	struct khugepaged_worker *worker = khugepaged_workers[nid];
+	const struct cpumask *cpumask = cpumask_of_node(nid);
+	struct task_struct *thread;
+
+	if (worker && worker->thread)
+		return 0;
+
+	if (!worker) {
+		worker = kzalloc_node(sizeof(*worker), GFP_KERNEL, nid);
+		if (!worker)
+			return -ENOMEM;
+		worker->cc.is_khugepaged = true;
+		khugepaged_workers[nid] = worker;
+	}
+
+	/* The first worker keeps the name userspace knows khugepaged by */
+	if (!khugepaged_nr_workers)
+		thread = kthread_create_on_node(khugepaged, worker, nid,
+						"khugepaged");
+	else
+		thread = kthread_create_on_node(khugepaged, worker, nid,
+						"khugepaged%d", nid);
+	if (IS_ERR(thread))
+		return PTR_ERR(thread);
+
+	if (!cpumask_empty(cpumask))
+		set_cpus_allowed_ptr(thread, cpumask);
+
+	worker->thread = thread;
+	khugepaged_nr_workers++;
+	wake_up_process(thread);
+
+	return 0;
+}
+
+static void khugepaged_stop_workers(void)
+{
+	int nid;
+
+	for (nid = 0; nid < MAX_NUMNODES; nid++) {
+		struct khugepaged_worker *worker = khugepaged_workers[nid];
+
+		if (!worker || !worker->thread)
+			continue;
+
+		kthread_stop(worker->thread);
+		worker->thread = NULL;
+		khugepaged_nr_workers--;
+	}
+}
+
 static void set_recommended_min_free_kbytes(void)
 {
 	struct zone *zone;
@@ -2673,21 +2838,23 @@ int start_stop_khugepaged(void)
 
 	mutex_lock(&khugepaged_mutex);
 	if (hugepage_pmd_enabled()) {
-		if (!khugepaged_thread)
-			khugepaged_thread = kthread_run(khugepaged, NULL,
-							"khugepaged");
-		if (IS_ERR(khugepaged_thread)) {
+		int nid;
+
+		for_each_node_state(nid, N_MEMORY) {
+			err = khugepaged_start_worker(nid);
+			if (err)
+				break;
+		}
+		if (err && !khugepaged_nr_workers) {
 			pr_err("khugepaged: kthread_run(khugepaged) failed\n");
-			err = PTR_ERR(khugepaged_thread);
-			khugepaged_thread = NULL;
 			goto fail;
 		}
+		err = 0;
 
-		if (!list_empty(&khugepaged_scan.mm_head))
+		if (!list_empty(&khugepaged_mm_head))
 			wake_up_interruptible(&khugepaged_wait);
-	} else if (khugepaged_thread) {
-		kthread_stop(khugepaged_thread);
-		khugepaged_thread = NULL;
+	} else if (khugepaged_nr_workers) {
+		khugepaged_stop_workers();
 	}
 	set_recommended_min_free_kbytes();
 fail:
@@ -2698,7 +2865,7 @@ int start_stop_khugepaged(void)
 void khugepaged_min_free_kbytes_update(void)
 {
 	mutex_lock(&khugepaged_mutex);
-	if (hugepage_pmd_enabled() && khugepaged_thread)
+	if (hugepage_pmd_enabled() && khugepaged_nr_workers)
 		set_recommended_min_free_kbytes();
 	mutex_unlock(&khugepaged_mutex);
 }
@@ -154,6 +154,7 @@ struct ksm_scan {
  * @kpfn: page frame number of this ksm page (perhaps temporarily on wrong nid)
  * @chain_prune_time: time of the last full garbage collection
  * @rmap_hlist_len: number of rmap_item entries in hlist or STABLE_NODE_CHAIN
+ * @checksum: checksum of the ksm page, accounted in ksm_stable_filter
  * @nid: NUMA node id of stable tree in which linked (may not match kpfn)
  */
 struct ksm_stable_node {
@@ -179,6 +180,7 @@ struct ksm_stable_node {
 	 */
 #define STABLE_NODE_CHAIN -1024
 	int rmap_hlist_len;
+	unsigned int checksum;	/* when not STABLE_NODE_CHAIN */
 #ifdef CONFIG_NUMA
 	int nid;
 #endif
@@ -300,6 +302,17 @@ atomic_long_t ksm_zero_pages = ATOMIC_LONG_INIT(0);
 /* The number of pages that have been skipped due to "smart scanning" */
 static unsigned long ksm_pages_skipped;
 
+/*
+ * Counting filter of the checksums of the pages in the stable trees: a page
+ * whose checksum has no stable node cannot have an identical ksm page, so its
+ * stable tree search is skipped. Counters that saturate stay so for good.
+ */
+static u16 *ksm_stable_filter;
+static unsigned int ksm_stable_filter_mask;
+
+/* The number of stable tree searches avoided by ksm_stable_filter */
+static unsigned long ksm_pages_filtered;
+
 /* Don't scan more than max pages per batch. */
 static unsigned long ksm_advisor_max_pages_to_scan = 30000;
 
@@ -587,10 +600,42 @@ static inline struct ksm_stable_node *alloc_stable_node(void)
 	return kmem_cache_alloc(stable_node_cache, GFP_KERNEL | __GFP_HIGH);
 }
 
+static inline u16 *stable_filter_slot(unsigned int checksum)
+{
+	if (!ksm_stable_filter)
+		return NULL;
+	return &ksm_stable_filter[hash_32(checksum, 32) & ksm_stable_filter_mask];
+}
+
+static void stable_filter_add(unsigned int checksum)
+{
+	u16 *slot = stable_filter_slot(checksum);
+
+	if (slot && *slot != U16_MAX)
+		(*slot)++;
+}
+
+static void stable_filter_del(unsigned int checksum)
+{
+	u16 *slot = stable_filter_slot(checksum);
+
+	if (slot && *slot != U16_MAX)
+		(*slot)--;
+}
+
+static bool stable_filter_test(unsigned int checksum)
+{
+	u16 *slot = stable_filter_slot(checksum);
+
+	return !slot || *slot;
+}
+
 static inline void free_stable_node(struct ksm_stable_node *stable_node)
 {
 	VM_BUG_ON(stable_node->rmap_hlist_len &&
 		  !is_stable_node_chain(stable_node));
+	if (!is_stable_node_chain(stable_node))
+		stable_filter_del(stable_node->checksum);
 	kmem_cache_free(stable_node_cache, stable_node);
 }
 
@@ -2061,6 +2106,9 @@ static struct ksm_stable_node *stable_tree_insert(struct folio *kfolio)
 	INIT_HLIST_HEAD(&stable_node_dup->hlist);
 	stable_node_dup->kpfn = kpfn;
 	stable_node_dup->rmap_hlist_len = 0;
+	/* Write protected by now, the contents cannot change */
+	stable_node_dup->checksum = calc_checksum(&kfolio->page);
+	stable_filter_add(stable_node_dup->checksum);
 	DO_NUMA(stable_node_dup->nid = nid);
 	if (!need_chain) {
 		rb_link_node(&stable_node_dup->node, parent, new);
@@ -2221,6 +2269,7 @@ static void cmp_and_merge_page(struct page *page, struct ksm_rmap_item *rmap_ite
 	unsigned int checksum;
 	int err;
 	bool max_page_sharing_bypass = false;
+	bool filtered = false;
 
 	stable_node = page_stable_node(page);
 	if (stable_node) {
@@ -2257,10 +2306,17 @@ static void cmp_and_merge_page(struct page *page, struct ksm_rmap_item *rmap_ite
 
 		if (!try_to_merge_with_zero_page(rmap_item, page))
 			return;
+
+		filtered = !stable_filter_test(checksum);
 	}
 
 	/* Start by searching for the folio in the stable tree */
-	kfolio = stable_tree_search(page);
+	if (filtered) {
+		ksm_pages_filtered++;
+		kfolio = NULL;
+	} else {
+		kfolio = stable_tree_search(page);
+	}
 	if (&kfolio->page == page && rmap_item->head == stable_node) {
 		folio_put(kfolio);
 		return;
@@ -3569,6 +3625,13 @@ static ssize_t pages_skipped_show(struct kobject *kobj,
 }
 KSM_ATTR_RO(pages_skipped);
 
+static ssize_t pages_filtered_show(struct kobject *kobj,
+				   struct kobj_attribute *attr, char *buf)
+{
+	return sysfs_emit(buf, "%lu\n", ksm_pages_filtered);
+}
+KSM_ATTR_RO(pages_filtered);
+
 static ssize_t ksm_zero_pages_show(struct kobject *kobj,
 				struct kobj_attribute *attr, char *buf)
 {
@@ -3791,6 +3854,7 @@ static struct attribute *ksm_attrs[] = {
 	&pages_unshared_attr.attr,
 	&pages_volatile_attr.attr,
 	&pages_skipped_attr.attr,
+	&pages_filtered_attr.attr,
 	&ksm_zero_pages_attr.attr,
 	&full_scans_attr.attr,
 #ifdef CONFIG_NUMA
@@ -3817,6 +3881,18 @@ static const struct attribute_group ksm_attr_group = {
 };
 #endif /* CONFIG_SYSFS */
 
+static void __init ksm_stable_filter_init(void)
+{
+	unsigned long nr = roundup_pow_of_two(totalram_pages() >> 5);
+
+	nr = clamp(nr, 1UL << 12, 1UL << 28);
+	ksm_stable_filter = kvcalloc(nr, sizeof(*ksm_stable_filter), GFP_KERNEL);
+	if (ksm_stable_filter)
+		ksm_stable_filter_mask = nr - 1;
+	else
+		pr_warn("ksm: no memory for the stable tree filter\n");
+}
+
 static int __init ksm_init(void)
 {
 	struct task_struct *ksm_thread;
@@ -3831,6 +3907,8 @@ static int __init ksm_init(void)
 	if (err)
 		goto out;
 
+	ksm_stable_filter_init();
+
 	ksm_thread = kthread_run(ksm_scan_thread, NULL, "ksmd");
 	if (IS_ERR(ksm_thread)) {
 		pr_err("ksm: creating kthread failed\n");
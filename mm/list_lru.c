@@ -272,6 +272,9 @@ unsigned long list_lru_count_node(struct list_lru *lru, int nid)
 }
 EXPORT_SYMBOL_GPL(list_lru_count_node);
 
+/* Items isolated under the lru lock before it is dropped for waiters */
+#define LIST_LRU_WALK_BATCH	32
+
 static unsigned long
 __list_lru_walk_one(struct list_lru *lru, int nid, struct mem_cgroup *memcg,
 		    list_lru_walk_cb isolate, void *cb_arg,
@@ -281,14 +284,29 @@ __list_lru_walk_one(struct list_lru *lru, int nid, struct mem_cgroup *memcg,
 	struct list_lru_one *l = NULL;
 	struct list_head *item, *n;
 	unsigned long isolated = 0;
+	unsigned int batch;
 
 restart:
 	l = lock_list_lru_of_memcg(lru, nid, memcg, irq_off, true);
 	if (!l)
 		return isolated;
+	batch = 0;
 	list_for_each_safe(item, n, &l->list) {
 		enum lru_status ret;
 
+		/*
+		 * Don't make list_lru_add() callers, such as d_alloc() putting
+		 * dentries on the LRU, wait for the whole walk: once a batch
+		 * has been processed, let them in and restart from the head.
+		 * Rotated and removed items are gone from the head, and
+		 * nr_to_walk still bounds the walk.
+		 */
+		if (++batch > LIST_LRU_WALK_BATCH && spin_is_contended(&l->lock)) {
+			unlock_list_lru(l, irq_off);
+			cpu_relax();
+			goto restart;
+		}
+
 		/*
 		 * decrement nr_to_walk first so that we don't livelock if we
 		 * get stuck on large numbers of LRU_RETRY items
@@ -789,17 +789,17 @@ static int madvise_free_pte_range(pmd_t *pmd, unsigned long addr,
 	return 0;
 }
 
-static const struct mm_walk_ops madvise_free_walk_ops = {
-	.pmd_entry		= madvise_free_pte_range,
-	.walk_lock		= PGWALK_RDLOCK,
-};
-
 static int madvise_free_single_vma(struct vm_area_struct *vma,
-			unsigned long start_addr, unsigned long end_addr)
+			unsigned long start_addr, unsigned long end_addr,
+			enum page_walk_lock walk_lock)
 {
 	struct mm_struct *mm = vma->vm_mm;
 	struct mmu_notifier_range range;
 	struct mmu_gather tlb;
+	struct mm_walk_ops walk_ops = {
+		.pmd_entry	= madvise_free_pte_range,
+		.walk_lock	= walk_lock,
+	};
 
 	/* MADV_FREE works for only anon vma at the moment */
 	if (!vma_is_anonymous(vma))
@@ -820,8 +820,7 @@ static int madvise_free_single_vma(struct vm_area_struct *vma,
 
 	mmu_notifier_invalidate_range_start(&range);
 	tlb_start_vma(&tlb, vma);
-	walk_page_range(vma->vm_mm, range.start, range.end,
-			&madvise_free_walk_ops, &tlb);
+	walk_page_range_vma(vma, range.start, range.end, &walk_ops, &tlb);
 	tlb_end_vma(&tlb, vma);
 	mmu_notifier_invalidate_range_end(&range);
 	tlb_finish_mmu(&tlb);
@@ -948,11 +947,61 @@ static long madvise_dontneed_free(struct vm_area_struct *vma,
 	if (behavior == MADV_DONTNEED || behavior == MADV_DONTNEED_LOCKED)
 		return madvise_dontneed_single_vma(vma, start, end);
 	else if (behavior == MADV_FREE)
-		return madvise_free_single_vma(vma, start, end);
+		return madvise_free_single_vma(vma, start, end, PGWALK_RDLOCK);
 	else
 		return -EINVAL;
 }
 
+/*
+ * MADV_DONTNEED and MADV_FREE only zap page table entries and never modify the
+ * VMA, so a range that lies within a single VMA can be handled under the
+ * per-VMA lock instead of mmap_lock, without stalling mmap()/brk() callers of
+ * other threads. Returns false if the caller has to go the mmap_lock way.
+ */
+static bool madvise_dontneed_free_vma_locked(struct mm_struct *mm,
+					     unsigned long start, size_t len,
+					     int behavior, int *error)
+{
+	struct vm_area_struct *vma;
+	unsigned long end;
+
+	if (behavior != MADV_DONTNEED && behavior != MADV_DONTNEED_LOCKED &&
+	    behavior != MADV_FREE)
+		return false;
+
+	/* untagged_addr_remote() needs mmap_lock */
+	if (mm != current->mm)
+		return false;
+
+	start = untagged_addr(start);
+	end = start + len;
+
+	vma = lock_vma_under_rcu(mm, start);
+	if (!vma)
+		return false;
+
+	/* userfaultfd_remove() would drop mmap_lock */
+	if (end > vma->vm_end || userfaultfd_armed(vma)) {
+		vma_end_read(vma);
+		return false;
+	}
+
+	if (unlikely(!can_modify_vma_madv(vma, behavior)))
+		*error = -EPERM;
+	else if (!madvise_dontneed_free_valid_vma(vma, start, &end, behavior))
+		*error = -EINVAL;
+	else if (start == end)
+		*error = 0;
+	else if (behavior == MADV_FREE)
+		*error = madvise_free_single_vma(vma, start, end,
+						 PGWALK_VMA_RDLOCK_VERIFY);
+	else
+		*error = madvise_dontneed_single_vma(vma, start, end);
+
+	vma_end_read(vma);
+	return true;
+}
+
 static long madvise_populate(struct mm_struct *mm, unsigned long start,
 		unsigned long end, int behavior)
 {
@@ -1677,6 +1726,9 @@ int do_madvise(struct mm_struct *mm, unsigned long start, size_t len_in, int beh
 		return madvise_inject_error(behavior, start, start + len_in);
 #endif
 
+	if (madvise_dontneed_free_vma_locked(mm, start, len, behavior, &error))
+		return error;
+
 	write = madvise_need_mmap_write(behavior);
 	if (write) {
 		if (mmap_write_lock_killable(mm))
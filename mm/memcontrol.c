@@ -63,6 +63,7 @@
 #include <linux/seq_buf.h>
 #include <linux/sched/isolation.h>
 #include <linux/kmemleak.h>
+#include <linux/moduleparam.h>
 #include "internal.h"
 #include <net/sock.h>
 #include <net/ip.h>
@@ -441,6 +442,8 @@ static const unsigned int memcg_vm_event_stat[] = {
 	PGDEACTIVATE,
 	PGLAZYFREE,
 	PGLAZYFREED,
+	DIRTY_THROTTLE,
+	DIRTY_THROTTLE_MS,
 #ifdef CONFIG_SWAP
 	SWPIN_ZERO,
 	SWPOUT_ZERO,
@@ -541,6 +544,13 @@ static u64 flush_last_time;
 
 #define FLUSH_TIME (2UL*HZ)
 
+/*
+ * How old, in milliseconds, the stats seen by a reader that does not force a
+ * flush are allowed to be before it flushes them itself.
+ */
+static unsigned int stats_staleness_ms __read_mostly;
+module_param(stats_staleness_ms, uint, 0644);
+
 /*
  * Accessors to ensure that preemption is disabled on PREEMPT_RT because it can
  * not rely on this as part of an acquired spinlock_t lock. These functions are
@@ -611,7 +621,11 @@ static void __mem_cgroup_flush_stats(struct mem_cgroup *memcg, bool force)
 	if (mem_cgroup_is_root(memcg))
 		WRITE_ONCE(flush_last_time, jiffies_64);
 
-	cgroup_rstat_flush(memcg->css.cgroup);
+	if (force)
+		cgroup_rstat_flush(memcg->css.cgroup);
+	else
+		cgroup_rstat_flush_stale(memcg->css.cgroup,
+			(u64)READ_ONCE(stats_staleness_ms) * NSEC_PER_MSEC);
 }
 
 /*
@@ -1738,10 +1752,12 @@ void mem_cgroup_print_oom_group(struct mem_cgroup *memcg)
 	pr_cont(" are going to be killed due to memory.oom.group set\n");
 }
 
+#define NR_MEMCG_STOCK 7
 struct memcg_stock_pcp {
 	local_lock_t stock_lock;
-	struct mem_cgroup *cached; /* this never be root cgroup */
-	unsigned int nr_pages;
+	/* most recently used first, these are never the root cgroup */
+	struct mem_cgroup *cached[NR_MEMCG_STOCK];
+	unsigned int nr_pages[NR_MEMCG_STOCK];
 
 	struct obj_cgroup *cached_objcg;
 	struct pglist_data *cached_pgdat;
@@ -1762,13 +1778,30 @@ static struct obj_cgroup *drain_obj_stock(struct memcg_stock_pcp *stock);
 static bool obj_stock_flush_required(struct memcg_stock_pcp *stock,
 				     struct mem_cgroup *root_memcg);
 
+/*
+ * Move the stock at @i to the front of the cache, so that the least
+ * recently used memcg is the one replaced when the cache is full.
+ */
+static void promote_stock(struct memcg_stock_pcp *stock, int i)
+{
+	struct mem_cgroup *memcg = stock->cached[i];
+	unsigned int nr_pages = stock->nr_pages[i];
+
+	for (; i > 0; i--) {
+		WRITE_ONCE(stock->cached[i], stock->cached[i - 1]);
+		WRITE_ONCE(stock->nr_pages[i], stock->nr_pages[i - 1]);
+	}
+	WRITE_ONCE(stock->cached[0], memcg);
+	WRITE_ONCE(stock->nr_pages[0], nr_pages);
+}
+
 /**
  * consume_stock: Try to consume stocked charge on this cpu.
  * @memcg: memcg to consume from.
  * @nr_pages: how many pages to charge.
  *
- * The charges will only happen if @memcg matches the current cpu's memcg
- * stock, and at least @nr_pages are available in that stock.  Failure to
+ * The charges will only happen if @memcg is one of the current cpu's memcg
+ * stocks, and at least @nr_pages are available in that stock.  Failure to
  * service an allocation will refill the stock.
  *
  * returns true if successful, false otherwise.
@@ -1779,6 +1812,7 @@ static bool consume_stock(struct mem_cgroup *memcg, unsigned int nr_pages)
 	unsigned int stock_pages;
 	unsigned long flags;
 	bool ret = false;
+	int i;
 
 	if (nr_pages > MEMCG_CHARGE_BATCH)
 		return ret;
@@ -1786,11 +1820,20 @@ static bool consume_stock(struct mem_cgroup *memcg, unsigned int nr_pages)
 	local_lock_irqsave(&memcg_stock.stock_lock, flags);
 
 	stock = this_cpu_ptr(&memcg_stock);
-	stock_pages = READ_ONCE(stock->nr_pages);
-	if (memcg == READ_ONCE(stock->cached) && stock_pages >= nr_pages) {
-		WRITE_ONCE(stock->nr_pages, stock_pages - nr_pages);
-		ret = true;
+	for (i = 0; i < NR_MEMCG_STOCK; i++) {
+		if (memcg != READ_ONCE(stock->cached[i]))
+			continue;
+
+		stock_pages = READ_ONCE(stock->nr_pages[i]);
+		if (stock_pages >= nr_pages) {
+			WRITE_ONCE(stock->nr_pages[i], stock_pages - nr_pages);
+			if (i)
+				promote_stock(stock, i);
+			ret = true;
+		}
+		break;
 	}
+	__count_vm_event(ret ? MEMCG_STOCK_HIT : MEMCG_STOCK_MISS);
 
 	local_unlock_irqrestore(&memcg_stock.stock_lock, flags);
 
@@ -1798,12 +1841,13 @@ static bool consume_stock(struct mem_cgroup *memcg, unsigned int nr_pages)
 }
 
 /*
- * Returns stocks cached in percpu and reset cached information.
+ * Returns the charges of stock @i cached in percpu and reset its cached
+ * information.
  */
-static void drain_stock(struct memcg_stock_pcp *stock)
+static void drain_stock(struct memcg_stock_pcp *stock, int i)
 {
-	unsigned int stock_pages = READ_ONCE(stock->nr_pages);
-	struct mem_cgroup *old = READ_ONCE(stock->cached);
+	unsigned int stock_pages = READ_ONCE(stock->nr_pages[i]);
+	struct mem_cgroup *old = READ_ONCE(stock->cached[i]);
 
 	if (!old)
 		return;
@@ -1813,11 +1857,19 @@ static void drain_stock(struct memcg_stock_pcp *stock)
 		if (do_memsw_account())
 			page_counter_uncharge(&old->memsw, stock_pages);
 
-		WRITE_ONCE(stock->nr_pages, 0);
+		WRITE_ONCE(stock->nr_pages[i], 0);
 	}
 
 	css_put(&old->css);
-	WRITE_ONCE(stock->cached, NULL);
+	WRITE_ONCE(stock->cached[i], NULL);
+}
+
+static void drain_stock_fully(struct memcg_stock_pcp *stock)
+{
+	int i;
+
+	for (i = 0; i < NR_MEMCG_STOCK; i++)
+		drain_stock(stock, i);
 }
 
 static void drain_local_stock(struct work_struct *dummy)
@@ -1835,7 +1887,7 @@ static void drain_local_stock(struct work_struct *dummy)
 
 	stock = this_cpu_ptr(&memcg_stock);
 	old = drain_obj_stock(stock);
-	drain_stock(stock);
+	drain_stock_fully(stock);
 	clear_bit(FLUSHING_CACHED_CHARGE, &stock->flags);
 
 	local_unlock_irqrestore(&memcg_stock.stock_lock, flags);
@@ -1849,19 +1901,37 @@ static void drain_local_stock(struct work_struct *dummy)
 static void __refill_stock(struct mem_cgroup *memcg, unsigned int nr_pages)
 {
 	struct memcg_stock_pcp *stock;
+	struct mem_cgroup *cached;
 	unsigned int stock_pages;
+	int i, empty = -1;
 
 	stock = this_cpu_ptr(&memcg_stock);
-	if (READ_ONCE(stock->cached) != memcg) { /* reset if necessary */
-		drain_stock(stock);
+	for (i = 0; i < NR_MEMCG_STOCK; i++) {
+		cached = READ_ONCE(stock->cached[i]);
+		if (cached == memcg)
+			break;
+		if (!cached && empty < 0)
+			empty = i;
+	}
+
+	if (i == NR_MEMCG_STOCK) {
+		/* take a free slot, or replace the least recently used */
+		if (empty < 0) {
+			i = NR_MEMCG_STOCK - 1;
+			drain_stock(stock, i);
+		} else {
+			i = empty;
+		}
 		css_get(&memcg->css);
-		WRITE_ONCE(stock->cached, memcg);
+		WRITE_ONCE(stock->cached[i], memcg);
 	}
-	stock_pages = READ_ONCE(stock->nr_pages) + nr_pages;
-	WRITE_ONCE(stock->nr_pages, stock_pages);
+	stock_pages = READ_ONCE(stock->nr_pages[i]) + nr_pages;
+	WRITE_ONCE(stock->nr_pages[i], stock_pages);
 
 	if (stock_pages > MEMCG_CHARGE_BATCH)
-		drain_stock(stock);
+		drain_stock(stock, i);
+	else if (i)
+		promote_stock(stock, i);
 }
 
 static void refill_stock(struct mem_cgroup *memcg, unsigned int nr_pages)
@@ -1896,13 +1966,18 @@ void drain_all_stock(struct mem_cgroup *root_memcg)
 		struct memcg_stock_pcp *stock = &per_cpu(memcg_stock, cpu);
 		struct mem_cgroup *memcg;
 		bool flush = false;
+		int i;
 
 		rcu_read_lock();
-		memcg = READ_ONCE(stock->cached);
-		if (memcg && READ_ONCE(stock->nr_pages) &&
-		    mem_cgroup_is_descendant(memcg, root_memcg))
-			flush = true;
-		else if (obj_stock_flush_required(stock, root_memcg))
+		for (i = 0; i < NR_MEMCG_STOCK; i++) {
+			memcg = READ_ONCE(stock->cached[i]);
+			if (memcg && READ_ONCE(stock->nr_pages[i]) &&
+			    mem_cgroup_is_descendant(memcg, root_memcg)) {
+				flush = true;
+				break;
+			}
+		}
+		if (!flush && obj_stock_flush_required(stock, root_memcg))
 			flush = true;
 		rcu_read_unlock();
 
@@ -1923,7 +1998,7 @@ static int memcg_hotplug_cpu_dead(unsigned int cpu)
 	struct memcg_stock_pcp *stock;
 
 	stock = &per_cpu(memcg_stock, cpu);
-	drain_stock(stock);
+	drain_stock_fully(stock);
 
 	return 0;
 }
@@ -4205,6 +4280,37 @@ static int memory_events_local_show(struct seq_file *m, void *v)
 	return 0;
 }
 
+#ifdef CONFIG_MEMCG_REFAULT_HISTOGRAM
+/*
+ * Account a refault at @distance pages from eviction to @memcg, where the
+ * eviction happened, and to its ancestors sharing the memory pressure.
+ */
+void mem_cgroup_record_refault(struct mem_cgroup *memcg,
+			       unsigned long distance)
+{
+	int bucket = min_t(int, fls_long(distance),
+			   MEMCG_NR_REFAULT_BUCKETS - 1);
+
+	for (; memcg && !mem_cgroup_is_root(memcg);
+	     memcg = parent_mem_cgroup(memcg))
+		atomic_long_inc(&memcg->refault_distance[bucket]);
+}
+
+static int memory_refault_distance_show(struct seq_file *m, void *v)
+{
+	struct mem_cgroup *memcg = mem_cgroup_from_seq(m);
+	int i;
+
+	/* Each line: refaults below that many bytes of extra memory */
+	for (i = 0; i < MEMCG_NR_REFAULT_BUCKETS - 1; i++)
+		seq_printf(m, "%lu %lu\n", PAGE_SIZE << i,
+			   atomic_long_read(&memcg->refault_distance[i]));
+	seq_printf(m, "max %lu\n",
+		   atomic_long_read(&memcg->refault_distance[i]));
+	return 0;
+}
+#endif
+
 int memory_stat_show(struct seq_file *m, void *v)
 {
 	struct mem_cgroup *memcg = mem_cgroup_from_seq(m);
@@ -4419,6 +4525,13 @@ static struct cftype memory_files[] = {
 		.name = "stat",
 		.seq_show = memory_stat_show,
 	},
+#ifdef CONFIG_MEMCG_REFAULT_HISTOGRAM
+	{
+		.name = "refault_distance",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.seq_show = memory_refault_distance_show,
+	},
+#endif
 #ifdef CONFIG_NUMA
 	{
 		.name = "numa_stat",
@@ -960,8 +960,39 @@ static ssize_t demotion_enabled_store(struct kobject *kobj,
 static struct kobj_attribute numa_demotion_enabled_attr =
 	__ATTR_RW(demotion_enabled);
 
+/*
+ * Pages to collect per node before promoting them together, 0 to promote
+ * each folio from its hint fault.
+ */
+unsigned int numa_promotion_batch;
+
+static ssize_t promotion_batch_show(struct kobject *kobj,
+				    struct kobj_attribute *attr, char *buf)
+{
+	return sysfs_emit(buf, "%u\n", READ_ONCE(numa_promotion_batch));
+}
+
+static ssize_t promotion_batch_store(struct kobject *kobj,
+				     struct kobj_attribute *attr,
+				     const char *buf, size_t count)
+{
+	unsigned int batch;
+	ssize_t ret;
+
+	ret = kstrtouint(buf, 0, &batch);
+	if (ret)
+		return ret;
+
+	WRITE_ONCE(numa_promotion_batch, batch);
+	return count;
+}
+
+static struct kobj_attribute numa_promotion_batch_attr =
+	__ATTR_RW(promotion_batch);
+
 static struct attribute *numa_attrs[] = {
 	&numa_demotion_enabled_attr.attr,
+	&numa_promotion_batch_attr.attr,
 	NULL,
 };
 
@@ -77,6 +77,7 @@
 #include <linux/vmalloc.h>
 #include <linux/sched/sysctl.h>
 #include <linux/fsnotify.h>
+#include <linux/workqueue.h>
 
 #include <trace/events/kmem.h>
 
@@ -1359,11 +1360,30 @@ vma_needs_copy(struct vm_area_struct *dst_vma, struct vm_area_struct *src_vma)
 	return false;
 }
 
-int
-copy_page_range(struct vm_area_struct *dst_vma, struct vm_area_struct *src_vma)
+static int copy_pgd_range(struct vm_area_struct *dst_vma,
+			  struct vm_area_struct *src_vma,
+			  unsigned long addr, unsigned long end)
 {
 	pgd_t *src_pgd, *dst_pgd;
 	unsigned long next;
+
+	dst_pgd = pgd_offset(dst_vma->vm_mm, addr);
+	src_pgd = pgd_offset(src_vma->vm_mm, addr);
+	do {
+		next = pgd_addr_end(addr, end);
+		if (pgd_none_or_clear_bad(src_pgd))
+			continue;
+		if (unlikely(copy_p4d_range(dst_vma, src_vma, dst_pgd, src_pgd,
+					    addr, next)))
+			return -ENOMEM;
+	} while (dst_pgd++, src_pgd++, addr = next, addr != end);
+
+	return 0;
+}
+
+int
+copy_page_range(struct vm_area_struct *dst_vma, struct vm_area_struct *src_vma)
+{
 	unsigned long addr = src_vma->vm_start;
 	unsigned long end = src_vma->vm_end;
 	struct mm_struct *dst_mm = dst_vma->vm_mm;
@@ -1411,20 +1431,9 @@ copy_page_range(struct vm_area_struct *dst_vma, struct vm_area_struct *src_vma)
 		raw_write_seqcount_begin(&src_mm->write_protect_seq);
 	}
 
-	ret = 0;
-	dst_pgd = pgd_offset(dst_mm, addr);
-	src_pgd = pgd_offset(src_mm, addr);
-	do {
-		next = pgd_addr_end(addr, end);
-		if (pgd_none_or_clear_bad(src_pgd))
-			continue;
-		if (unlikely(copy_p4d_range(dst_vma, src_vma, dst_pgd, src_pgd,
-					    addr, next))) {
-			untrack_pfn_clear(dst_vma);
-			ret = -ENOMEM;
-			break;
-		}
-	} while (dst_pgd++, src_pgd++, addr = next, addr != end);
+	ret = copy_pgd_range(dst_vma, src_vma, addr, end);
+	if (ret)
+		untrack_pfn_clear(dst_vma);
 
 	if (is_cow) {
 		raw_write_seqcount_end(&src_mm->write_protect_seq);
@@ -1433,6 +1442,175 @@ copy_page_range(struct vm_area_struct *dst_vma, struct vm_area_struct *src_vma)
 	return ret;
 }
 
+/*
+ * Page tables of large private VMAs can be copied at fork by several
+ * threads, when the process asked for it with PR_SET_FORK_COPY_THREADS.
+ * Each thread copies one chunk of a VMA at a time.
+ */
+#define COPY_PAGE_RANGE_CHUNK	SZ_1G
+
+struct copy_page_range_control {
+	struct vma_copy *vmas;
+	unsigned int nr;
+	struct mem_cgroup *memcg;
+
+	/* Next chunk to copy, and the first error */
+	spinlock_t lock;
+	unsigned int idx;
+	unsigned long addr;
+	int err;
+};
+
+struct copy_page_range_work {
+	struct work_struct work;
+	struct copy_page_range_control *ctl;
+};
+
+/**
+ * copy_page_range_can_defer - check that a VMA can be given to
+ * copy_page_ranges_parallel()
+ * @src_vma: the parent VMA
+ *
+ * Only large private anonymous mappings are worth splitting up, and they
+ * have none of the hugetlb or PFN tracking that copy_page_range() handles.
+ */
+bool copy_page_range_can_defer(struct vm_area_struct *src_vma)
+{
+	return is_cow_mapping(src_vma->vm_flags) && src_vma->anon_vma &&
+	       !is_vm_hugetlb_page(src_vma) &&
+	       !(src_vma->vm_flags & (VM_PFNMAP | VM_MIXEDMAP)) &&
+	       src_vma->vm_end - src_vma->vm_start >= COPY_PAGE_RANGE_CHUNK;
+}
+
+static bool copy_page_range_next(struct copy_page_range_control *ctl,
+				 struct vma_copy **vc, unsigned long *addr,
+				 unsigned long *end)
+{
+	bool found = false;
+
+	spin_lock(&ctl->lock);
+	if (!ctl->err && ctl->idx < ctl->nr) {
+		struct vm_area_struct *src_vma = ctl->vmas[ctl->idx].src_vma;
+
+		*vc = &ctl->vmas[ctl->idx];
+		*addr = ctl->addr;
+		*end = min(ALIGN(*addr + 1, COPY_PAGE_RANGE_CHUNK),
+			   src_vma->vm_end);
+		if (*end == src_vma->vm_end) {
+			if (++ctl->idx < ctl->nr)
+				ctl->addr = ctl->vmas[ctl->idx].src_vma->vm_start;
+		} else {
+			ctl->addr = *end;
+		}
+		found = true;
+	}
+	spin_unlock(&ctl->lock);
+
+	return found;
+}
+
+static void copy_page_range_chunks(struct copy_page_range_control *ctl)
+{
+	struct mem_cgroup *old_memcg = set_active_memcg(ctl->memcg);
+	unsigned long addr, end;
+	struct vma_copy *vc;
+
+	while (copy_page_range_next(ctl, &vc, &addr, &end)) {
+		struct mmu_notifier_range range;
+		int ret;
+
+		mmu_notifier_range_init(&range, MMU_NOTIFY_PROTECTION_PAGE,
+					0, vc->src_vma->vm_mm, addr, end);
+		mmu_notifier_invalidate_range_start(&range);
+		ret = copy_pgd_range(vc->dst_vma, vc->src_vma, addr, end);
+		mmu_notifier_invalidate_range_end(&range);
+
+		if (ret) {
+			spin_lock(&ctl->lock);
+			if (!ctl->err)
+				ctl->err = ret;
+			spin_unlock(&ctl->lock);
+		}
+		cond_resched();
+	}
+
+	set_active_memcg(old_memcg);
+}
+
+static void copy_page_range_workfn(struct work_struct *work)
+{
+	struct copy_page_range_work *w;
+
+	w = container_of(work, struct copy_page_range_work, work);
+	copy_page_range_chunks(w->ctl);
+}
+
+/**
+ * copy_page_ranges_parallel - copy_page_range() for several VMAs at once
+ * @vmas: pairs of child and parent VMAs, all from the same two mms
+ * @nr: number of pairs
+ * @nr_threads: maximum number of threads to use, including the caller
+ *
+ * Each parent VMA must have passed copy_page_range_can_defer(). The caller
+ * holds the mmap_lock of both mms for writing, as for copy_page_range(),
+ * and helps with the copy until all of it is done.
+ *
+ * Return: 0 on success, -ENOMEM if a page table could not be allocated.
+ * On failure the page tables of the child VMAs are partially copied, and
+ * the caller tears down the child mm.
+ */
+int copy_page_ranges_parallel(struct vma_copy *vmas, unsigned int nr,
+			      unsigned int nr_threads)
+{
+	struct mm_struct *src_mm = vmas[0].src_vma->vm_mm;
+	struct copy_page_range_control ctl = {
+		.vmas = vmas,
+		.nr = nr,
+		.addr = vmas[0].src_vma->vm_start,
+	};
+	struct copy_page_range_work *works = NULL;
+	unsigned long chunks = 0;
+	unsigned int i, nr_works;
+
+	for (i = 0; i < nr; i++)
+		chunks += DIV_ROUND_UP(vmas[i].src_vma->vm_end -
+				       vmas[i].src_vma->vm_start,
+				       COPY_PAGE_RANGE_CHUNK);
+
+	nr_works = min3((unsigned long)nr_threads, chunks,
+			(unsigned long)num_online_cpus()) - 1;
+	if (nr_works)
+		works = kcalloc(nr_works, sizeof(*works), GFP_KERNEL);
+	if (!works)
+		nr_works = 0;
+
+	/* Charge the page tables to the forking task, as the serial copy does */
+	ctl.memcg = get_mem_cgroup_from_current();
+	spin_lock_init(&ctl.lock);
+
+	/* Held across all the chunks, see copy_page_range() */
+	raw_write_seqcount_begin(&src_mm->write_protect_seq);
+
+	for (i = 0; i < nr_works; i++) {
+		works[i].ctl = &ctl;
+		INIT_WORK(&works[i].work, copy_page_range_workfn);
+		queue_work(system_unbound_wq, &works[i].work);
+	}
+
+	copy_page_range_chunks(&ctl);
+
+	/* Nothing is left to copy, drop the helpers that did not start yet */
+	for (i = 0; i < nr_works; i++)
+		cancel_work_sync(&works[i].work);
+
+	raw_write_seqcount_end(&src_mm->write_protect_seq);
+
+	mem_cgroup_put(ctl.memcg);
+	kfree(works);
+
+	return ctl.err;
+}
+
 /* Whether we should zap all COWed (private) pages too */
 static inline bool should_zap_cows(struct zap_details *details)
 {
@@ -4199,7 +4377,11 @@ static inline unsigned long thp_swap_suitable_orders(pgoff_t swp_offset,
 	return orders;
 }
 
-static struct folio *alloc_swap_folio(struct vm_fault *vmf)
+/*
+ * Allocate and charge a large folio covering the faulting swap entry if the
+ * whole aligned range can be swapped in at once, NULL otherwise.
+ */
+static struct folio *alloc_swap_large_folio(struct vm_fault *vmf)
 {
 	struct vm_area_struct *vma = vmf->vma;
 	unsigned long orders;
@@ -4276,15 +4458,47 @@ static struct folio *alloc_swap_folio(struct vm_fault *vmf)
 	}
 
 fallback:
-	return __alloc_swap_folio(vmf);
+	return NULL;
 }
 #else /* !CONFIG_TRANSPARENT_HUGEPAGE */
-static struct folio *alloc_swap_folio(struct vm_fault *vmf)
+static struct folio *alloc_swap_large_folio(struct vm_fault *vmf)
 {
-	return __alloc_swap_folio(vmf);
+	return NULL;
 }
 #endif /* CONFIG_TRANSPARENT_HUGEPAGE */
 
+static struct folio *alloc_swap_folio(struct vm_fault *vmf)
+{
+	struct folio *folio = alloc_swap_large_folio(vmf);
+
+	return folio ? folio : __alloc_swap_folio(vmf);
+}
+
+/*
+ * Swap in a large folio through the swap cache, for devices that can't skip
+ * it. The range was swapped out as a whole, so read it back as a whole rather
+ * than faulting it in page by page.
+ */
+static struct folio *swapin_large_folio(struct vm_fault *vmf,
+					swp_entry_t entry)
+{
+	struct folio *folio = alloc_swap_large_folio(vmf);
+
+	if (!folio)
+		return NULL;
+
+	entry.val = ALIGN_DOWN(entry.val, folio_nr_pages(folio));
+	if (!swap_cache_add_large_folio(folio, entry,
+					 GFP_HIGHUSER_MOVABLE)) {
+		count_mthp_stat(folio_order(folio), MTHP_STAT_SWPIN_FALLBACK);
+		folio_put(folio);
+		return NULL;
+	}
+
+	swap_read_folio(folio, NULL);
+	return folio;
+}
+
 static DECLARE_WAIT_QUEUE_HEAD(swapcache_wq);
 
 /*
@@ -4419,8 +4633,10 @@ vm_fault_t do_swap_page(struct vm_fault *vmf)
 				folio->private = NULL;
 			}
 		} else {
-			folio = swapin_readahead(entry, GFP_HIGHUSER_MOVABLE,
-						vmf);
+			folio = swapin_large_folio(vmf, entry);
+			if (!folio)
+				folio = swapin_readahead(entry,
+						GFP_HIGHUSER_MOVABLE, vmf);
 			swapcache = folio;
 		}
 
@@ -4774,6 +4990,8 @@ static struct folio *alloc_anon_folio(struct vm_fault *vmf)
 	orders = thp_vma_allowable_orders(vma, vma->vm_flags,
 			TVA_IN_PF | TVA_ENFORCE_SYSFS, BIT(PMD_ORDER) - 1);
 	orders = thp_vma_suitable_orders(vma, vmf->address, orders);
+	/* Step down from the orders this mm was found to mostly waste. */
+	orders = mthp_anon_adapt_orders(vma->vm_mm, orders);
 
 	if (!orders)
 		goto fallback;
@@ -5660,6 +5878,7 @@ static vm_fault_t do_numa_page(struct vm_fault *vmf)
 	int target_nid;
 	pte_t pte, old_pte;
 	int flags = 0, nr_pages;
+	unsigned int latency = 0;
 
 	/*
 	 * The pte cannot be used safely until we verify, while holding the page
@@ -5692,6 +5911,10 @@ static vm_fault_t do_numa_page(struct vm_fault *vmf)
 	nid = folio_nid(folio);
 	nr_pages = folio_nr_pages(folio);
 
+	/* Ranks batched promotions, numa_migrate_check() resets the time */
+	if (folio_use_access_time(folio))
+		latency = folio_access_latency(folio, jiffies_to_msecs(jiffies));
+
 	target_nid = numa_migrate_check(folio, vmf, vmf->address, &flags,
 					writable, &last_cpupid);
 	if (target_nid == NUMA_NO_NODE)
@@ -5701,6 +5924,12 @@ static vm_fault_t do_numa_page(struct vm_fault *vmf)
 		goto out_map;
 	}
 	/* The folio is isolated and isolation code holds a folio reference. */
+	if (numa_promotion_batch && folio_use_access_time(folio) &&
+	    node_is_toptier(target_nid)) {
+		/* Promoted later on with other folios, it stays mapped till then */
+		migrate_misplaced_folio_queue(folio, target_nid, latency);
+		goto out_map;
+	}
 	pte_unmap_unlock(vmf->pte, vmf->ptl);
 	writable = false;
 	ignore_writable = true;
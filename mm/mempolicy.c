@@ -685,6 +685,156 @@ unsigned long change_prot_numa(struct vm_area_struct *vma,
 
 	return nr_updated;
 }
+
+/*
+ * With NUMA_BALANCING_ACCESS_BIT, the NUMA scanner samples and clears the
+ * accessed bits of a range instead of making it PROT_NONE. Each young entry
+ * is then accounted, and its folio migrated if misplaced, as if it had taken
+ * a hinting fault, once the page table lock is dropped.
+ */
+struct numa_young_sample {
+	struct folio *folio;	/* isolated for migration to target_nid */
+	int target_nid;
+	int last_cpupid;
+	int nid;
+	int nr_pages;
+	int flags;
+};
+
+struct numa_young_walk {
+	struct numa_young_sample *samples;
+	unsigned int nr;
+	unsigned long nr_young;
+};
+
+static void numa_young_sample(struct numa_young_walk *nyw,
+			      struct folio *folio, struct vm_fault *vmf,
+			      unsigned long addr, bool writable, int nr_pages)
+{
+	struct numa_young_sample *prev = nyw->nr ? &nyw->samples[nyw->nr - 1] : NULL;
+	struct numa_young_sample *s = &nyw->samples[nyw->nr++];
+
+	s->folio = NULL;
+	s->flags = 0;
+	s->nid = folio_nid(folio);
+	s->nr_pages = nr_pages;
+	s->target_nid = numa_migrate_check(folio, vmf, addr, &s->flags,
+					   writable, &s->last_cpupid);
+	nyw->nr_young += nr_pages;
+
+	/* The other PTEs of a large folio already being migrated */
+	if (s->target_nid == NUMA_NO_NODE || (prev && prev->folio == folio))
+		return;
+
+	if (!migrate_misplaced_folio_prepare(folio, vmf->vma, s->target_nid))
+		s->folio = folio;
+	else
+		s->flags |= TNF_MIGRATE_FAIL;
+}
+
+static void numa_young_flush(struct numa_young_walk *nyw)
+{
+	unsigned int i;
+
+	for (i = 0; i < nyw->nr; i++) {
+		struct numa_young_sample *s = &nyw->samples[i];
+		int nid = s->nid;
+
+		if (s->folio) {
+			if (!migrate_misplaced_folio(s->folio, s->target_nid)) {
+				nid = s->target_nid;
+				s->flags |= TNF_MIGRATED;
+			} else {
+				s->flags |= TNF_MIGRATE_FAIL;
+			}
+		}
+		task_numa_fault(s->last_cpupid, nid, s->nr_pages, s->flags);
+	}
+	nyw->nr = 0;
+}
+
+static int numa_young_pmd_entry(pmd_t *pmd, unsigned long addr,
+				unsigned long end, struct mm_walk *walk)
+{
+	struct numa_young_walk *nyw = walk->private;
+	struct vm_area_struct *vma = walk->vma;
+	struct vm_fault vmf = { .vma = vma };
+	pte_t *start_pte, *pte;
+	struct folio *folio;
+
+	vmf.ptl = pmd_trans_huge_lock(pmd, vma);
+	if (vmf.ptl) {
+		pmd_t pmdval = pmdp_get(pmd);
+
+		if (pmd_trans_huge(pmdval) && pmd_young(pmdval) &&
+		    !is_huge_zero_pmd(pmdval)) {
+			folio = pmd_folio(pmdval);
+			if (pmdp_test_and_clear_young(vma, addr, pmd))
+				numa_young_sample(nyw, folio, &vmf, addr,
+						  pmd_write(pmdval),
+						  folio_nr_pages(folio));
+		}
+		spin_unlock(vmf.ptl);
+		numa_young_flush(nyw);
+		return 0;
+	}
+
+	start_pte = pte = pte_offset_map_lock(walk->mm, pmd, addr, &vmf.ptl);
+	if (!pte) {
+		walk->action = ACTION_AGAIN;
+		return 0;
+	}
+	for (; addr != end; pte++, addr += PAGE_SIZE) {
+		pte_t ptent = ptep_get(pte);
+
+		if (!pte_present(ptent) || pte_protnone(ptent) ||
+		    !pte_young(ptent))
+			continue;
+
+		folio = vm_normal_folio(vma, addr, ptent);
+		if (!folio || folio_is_zone_device(folio))
+			continue;
+
+		if (ptep_test_and_clear_young(vma, addr, pte))
+			numa_young_sample(nyw, folio, &vmf, addr,
+					  pte_write(ptent), 1);
+	}
+	pte_unmap_unlock(start_pte, vmf.ptl);
+	numa_young_flush(nyw);
+	cond_resched();
+
+	return 0;
+}
+
+static const struct mm_walk_ops numa_young_walk_ops = {
+	.pmd_entry		= numa_young_pmd_entry,
+	.walk_lock		= PGWALK_RDLOCK,
+};
+
+/**
+ * numa_scan_young - sample the accessed bits of a range for NUMA balancing
+ * @vma: the VMA to scan, with the mmap_lock held for reading
+ * @addr: start of the range
+ * @end: end of the range
+ *
+ * Return: the number of pages found young, and now accounted as NUMA
+ * hinting faults of the current task.
+ */
+unsigned long numa_scan_young(struct vm_area_struct *vma,
+			      unsigned long addr, unsigned long end)
+{
+	struct numa_young_walk nyw = {};
+
+	nyw.samples = kmalloc_array(PTRS_PER_PTE, sizeof(*nyw.samples),
+				    GFP_KERNEL);
+	if (!nyw.samples)
+		return 0;
+
+	walk_page_range_vma(vma, addr, end, &numa_young_walk_ops, &nyw);
+	kfree(nyw.samples);
+
+	return nyw.nr_young;
+}
 #endif /* CONFIG_NUMA_BALANCING */
 
 static int queue_pages_test_walk(unsigned long start, unsigned long end,
@@ -2734,5 +2734,125 @@ int migrate_misplaced_folio(struct folio *folio, int node)
 	BUG_ON(!list_empty(&migratepages));
 	return nr_remaining ? -EAGAIN : 0;
 }
+
+/* How long a folio may wait on a promotion batch that is not full */
+#define NUMA_PROMOTE_DELAY	msecs_to_jiffies(10)
+
+/**
+ * migrate_misplaced_folio_queue - add a folio to the promotion batch of a node
+ * @folio: folio isolated with migrate_misplaced_folio_prepare()
+ * @node: the top tier node to promote the folio to
+ * @latency: hint fault latency of the folio in ms
+ *
+ * Instead of migrating the folio from the fault, leave it mapped and let
+ * numa_promote_work() migrate it along with the other candidates for @node,
+ * hottest first. Can be called under the page table lock.
+ */
+void migrate_misplaced_folio_queue(struct folio *folio, int node,
+				   unsigned int latency)
+{
+	pg_data_t *pgdat = NODE_DATA(node);
+	unsigned int bucket;
+	unsigned long nr;
+
+	bucket = min_t(unsigned int, ilog2(latency + 1),
+		       NUMA_PROMOTE_BUCKETS - 1);
+
+	spin_lock(&pgdat->promote_lock);
+	list_add_tail(&folio->lru, &pgdat->promote_lists[bucket]);
+	pgdat->nr_promote += folio_nr_pages(folio);
+	nr = pgdat->nr_promote;
+	spin_unlock(&pgdat->promote_lock);
+
+	if (nr >= READ_ONCE(numa_promotion_batch))
+		mod_delayed_work(system_unbound_wq, &pgdat->promote_work, 0);
+	else
+		queue_delayed_work(system_unbound_wq, &pgdat->promote_work,
+				   NUMA_PROMOTE_DELAY);
+}
+
+/*
+ * Promote a list of folios to @pgdat, a run of folios of the same memcg at
+ * a time, so that the promotions are accounted to the right memcg.
+ */
+static void numa_promote_folios(pg_data_t *pgdat, struct list_head *folios)
+{
+	while (!list_empty(folios)) {
+		struct folio *folio = list_first_entry(folios, struct folio, lru);
+		struct mem_cgroup *memcg = get_mem_cgroup_from_folio(folio);
+		struct mem_cgroup *run = folio_memcg(folio);
+		unsigned int nr_succeeded = 0;
+		struct folio *next;
+		LIST_HEAD(batch);
+
+		list_for_each_entry_safe(folio, next, folios, lru) {
+			if (folio_memcg(folio) != run)
+				break;
+			list_move_tail(&folio->lru, &batch);
+		}
+
+		migrate_pages(&batch, alloc_misplaced_dst_folio, NULL,
+			      pgdat->node_id, MIGRATE_ASYNC, MR_NUMA_MISPLACED,
+			      &nr_succeeded);
+		if (!list_empty(&batch))
+			putback_movable_pages(&batch);
+
+		if (nr_succeeded) {
+			count_vm_numa_events(NUMA_PAGE_MIGRATE, nr_succeeded);
+			count_memcg_events(memcg, NUMA_PAGE_MIGRATE, nr_succeeded);
+			mod_lruvec_state(mem_cgroup_lruvec(memcg, pgdat),
+					 PGPROMOTE_SUCCESS, nr_succeeded);
+		}
+		mem_cgroup_put(memcg);
+	}
+}
+
+/*
+ * Migrate the promotion batch of a node, from the hottest folios to the
+ * coldest, within the promotion rate limit of the node. Folios beyond the
+ * limit are put back where they are.
+ */
+void numa_promote_work(struct work_struct *work)
+{
+	pg_data_t *pgdat = container_of(to_delayed_work(work), pg_data_t,
+					promote_work);
+	unsigned long rate_limit, budget;
+	struct folio *folio, *next;
+	LIST_HEAD(folios);
+	LIST_HEAD(skipped);
+	unsigned int now;
+	int i;
+
+	rate_limit = READ_ONCE(sysctl_numa_balancing_promote_rate_limit) <<
+		     (20 - PAGE_SHIFT);
+	now = jiffies_to_msecs(jiffies);
+	if (now - pgdat->promote_bw_start > MSEC_PER_SEC) {
+		pgdat->promote_bw_start = now;
+		pgdat->promote_bw_nr = 0;
+	}
+	budget = rate_limit - min(rate_limit, pgdat->promote_bw_nr);
+
+	spin_lock(&pgdat->promote_lock);
+	for (i = 0; i < NUMA_PROMOTE_BUCKETS; i++) {
+		list_for_each_entry_safe(folio, next, &pgdat->promote_lists[i],
+					 lru) {
+			unsigned long nr = folio_nr_pages(folio);
+
+			if (nr <= budget) {
+				budget -= nr;
+				pgdat->promote_bw_nr += nr;
+				list_move_tail(&folio->lru, &folios);
+			} else {
+				list_move_tail(&folio->lru, &skipped);
+			}
+		}
+	}
+	pgdat->nr_promote = 0;
+	spin_unlock(&pgdat->promote_lock);
+
+	if (!list_empty(&skipped))
+		putback_movable_pages(&skipped);
+	numa_promote_folios(pgdat, &folios);
+}
 #endif /* CONFIG_NUMA_BALANCING */
 #endif /* CONFIG_NUMA */
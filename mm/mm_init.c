@@ -30,6 +30,7 @@
 #include <linux/crash_dump.h>
 #include <linux/execmem.h>
 #include <linux/vmstat.h>
+#include <linux/async.h>
 #include "internal.h"
 #include "slab.h"
 #include "shuffle.h"
@@ -1353,6 +1354,21 @@ static void pgdat_init_split_queue(struct pglist_data *pgdat)
 static void pgdat_init_split_queue(struct pglist_data *pgdat) {}
 #endif
 
+#ifdef CONFIG_NUMA_BALANCING
+static void pgdat_init_promote(struct pglist_data *pgdat)
+{
+	int i;
+
+	spin_lock_init(&pgdat->promote_lock);
+	for (i = 0; i < NUMA_PROMOTE_BUCKETS; i++)
+		INIT_LIST_HEAD(&pgdat->promote_lists[i]);
+	pgdat->nr_promote = 0;
+	INIT_DELAYED_WORK(&pgdat->promote_work, numa_promote_work);
+}
+#else
+static void pgdat_init_promote(struct pglist_data *pgdat) {}
+#endif
+
 #ifdef CONFIG_COMPACTION
 static void pgdat_init_kcompactd(struct pglist_data *pgdat)
 {
@@ -1371,6 +1387,7 @@ static void __meminit pgdat_init_internals(struct pglist_data *pgdat)
 
 	pgdat_init_split_queue(pgdat);
 	pgdat_init_kcompactd(pgdat);
+	pgdat_init_promote(pgdat);
 
 	init_waitqueue_head(&pgdat->kswapd_wait);
 	init_waitqueue_head(&pgdat->pfmemalloc_wait);
@@ -1955,7 +1972,35 @@ static __initdata DECLARE_COMPLETION(pgdat_init_all_done_comp);
 static inline void __init pgdat_init_report_one_done(void)
 {
 	if (atomic_dec_and_test(&pgdat_init_n_undone))
-		complete(&pgdat_init_all_done_comp);
+		complete_all(&pgdat_init_all_done_comp);
+}
+
+/*
+ * With deferred_init_async, boot goes on through the initcalls while the
+ * pgdatinit threads are running, and only waits for them before the init
+ * sections are freed.
+ */
+static bool deferred_init_async __initdata;
+
+static int __init early_deferred_init_async(char *buf)
+{
+	return kstrtobool(buf, &deferred_init_async);
+}
+early_param("deferred_init_async", early_deferred_init_async);
+
+/*
+ * Called by allocations that would otherwise have to reclaim while the
+ * deferred pages are not all initialised. Return true if it had to wait.
+ */
+bool __init deferred_init_wait(void)
+{
+	/* Not from the kthreads the initialisation itself may depend on */
+	if (!deferred_init_async || (current->flags & PF_KTHREAD) ||
+	    completion_done(&pgdat_init_all_done_comp))
+		return false;
+
+	wait_for_completion(&pgdat_init_all_done_comp);
+	return true;
 }
 
 /*
@@ -2276,19 +2321,12 @@ void set_zone_contiguous(struct zone *zone)
 }
 
 static void __init mem_init_print_info(void);
-void __init page_alloc_init_late(void)
+static void __init page_alloc_init_late_done(void *data, async_cookie_t cookie)
 {
 	struct zone *zone;
 	int nid;
 
 #ifdef CONFIG_DEFERRED_STRUCT_PAGE_INIT
-
-	/* There will be num_node_state(N_MEMORY) threads */
-	atomic_set(&pgdat_init_n_undone, num_node_state(N_MEMORY));
-	for_each_node_state(nid, N_MEMORY) {
-		kthread_run(deferred_init_memmap, NODE_DATA(nid), "pgdatinit%d", nid);
-	}
-
 	/* Block until all are initialised */
 	wait_for_completion(&pgdat_init_all_done_comp);
 
@@ -2304,7 +2342,6 @@ void __init page_alloc_init_late(void)
 
 	/* Accounting of total+free memory is stable at this point. */
 	mem_init_print_info();
-	buffer_init();
 
 	/* Discard memblock private memory */
 	memblock_discard();
@@ -2322,6 +2359,32 @@ void __init page_alloc_init_late(void)
 	page_alloc_sysctl_init();
 }
 
+void __init page_alloc_init_late(void)
+{
+#ifdef CONFIG_DEFERRED_STRUCT_PAGE_INIT
+	int nid;
+
+	/* There will be num_node_state(N_MEMORY) threads */
+	atomic_set(&pgdat_init_n_undone, num_node_state(N_MEMORY));
+	for_each_node_state(nid, N_MEMORY) {
+		kthread_run(deferred_init_memmap, NODE_DATA(nid), "pgdatinit%d", nid);
+	}
+
+	if (deferred_init_async) {
+		/*
+		 * The initcalls may need buffer heads, size them from the
+		 * memory initialised so far. kernel_init() synchronizes with
+		 * the rest before freeing the init sections.
+		 */
+		async_schedule(page_alloc_init_late_done, NULL);
+		buffer_init();
+		return;
+	}
+#endif
+	page_alloc_init_late_done(NULL, 0);
+	buffer_init();
+}
+
 /*
  * Adaptive scale is meant to reduce sizes of hash tables on large memory
  * machines. As memory size is increased the scale is also increased but at
@@ -1824,6 +1824,19 @@ static void balance_wb_limits(struct dirty_throttle_control *dtc,
 	wb_position_ratio(dtc);
 }
 
+/* Account a throttling pause to the system and to the dirtier's memcg */
+static void count_dirty_throttle(long pause)
+{
+	unsigned int ms = jiffies_to_msecs(pause);
+
+	count_vm_event(DIRTY_THROTTLE);
+	count_vm_events(DIRTY_THROTTLE_MS, ms);
+	if (current->mm) {
+		count_memcg_event_mm(current->mm, DIRTY_THROTTLE);
+		count_memcg_events_mm(current->mm, DIRTY_THROTTLE_MS, ms);
+	}
+}
+
 /*
  * balance_dirty_pages() must be called by processes which are generating dirty
  * data.  It looks at the number of dirty pages in the machine and will force
@@ -2006,6 +2019,7 @@ static int balance_dirty_pages(struct bdi_writeback *wb,
 			ret = -EAGAIN;
 			break;
 		}
+		count_dirty_throttle(pause);
 		__set_current_state(TASK_KILLABLE);
 		bdi->last_bdp_sleep = jiffies;
 		io_schedule_timeout(pause);
@@ -92,6 +92,15 @@ typedef int __bitwise fpi_t;
 static DEFINE_MUTEX(pcp_batch_high_lock);
 #define MIN_PERCPU_PAGELIST_HIGH_FRACTION (8)
 
+/* Number of CPUs sharing a zone shard, 0 disables the shards */
+unsigned int zone_shard_cpus __read_mostly = 16;
+
+static int __init zone_shard_cpus_setup(char *buf)
+{
+	return kstrtouint(buf, 0, &zone_shard_cpus);
+}
+early_param("zone_shard_cpus", zone_shard_cpus_setup);
+
 #if defined(CONFIG_SMP) || defined(CONFIG_PREEMPT_RT)
 /*
  * On SMP, spin_trylock is sufficient protection.
@@ -315,6 +324,12 @@ _deferred_grow_zone(struct zone *zone, unsigned int order)
 {
 	return deferred_grow_zone(zone, order);
 }
+
+/* Same as above, for deferred_init_wait() */
+static bool __ref _deferred_init_wait(void)
+{
+	return deferred_init_wait();
+}
 #else
 static inline bool deferred_pages_enabled(void)
 {
@@ -325,6 +340,11 @@ static inline bool _deferred_grow_zone(struct zone *zone, unsigned int order)
 {
 	return false;
 }
+
+static inline bool _deferred_init_wait(void)
+{
+	return false;
+}
 #endif /* CONFIG_DEFERRED_STRUCT_PAGE_INIT */
 
 /* Return a pointer to the bitmap storing bits affecting a block of pages */
@@ -2295,9 +2315,128 @@ __rmqueue(struct zone *zone, unsigned int order, int migratetype,
 	return page;
 }
 
+static inline struct zone_shard *zone_cpu_shard(struct zone *zone)
+{
+	if (!zone->shards)
+		return NULL;
+
+	return &zone->shards[raw_smp_processor_id() / zone_shard_cpus];
+}
+
+/*
+ * Take up to @count blocks of @order for the pcp list of @migratetype from
+ * the shard of the local CPU group. Returns the number of blocks placed at
+ * the tail of @list.
+ */
+static int zone_shard_refill(struct zone *zone, unsigned int order,
+			     unsigned long count, struct list_head *list,
+			     int migratetype)
+{
+	struct zone_shard *shard = zone_cpu_shard(zone);
+	struct list_head *slist;
+	unsigned long flags;
+	int i = 0;
+
+	if (!shard || !data_race(shard->nr_free[order]))
+		return 0;
+
+	spin_lock_irqsave(&shard->lock, flags);
+	slist = &shard->lists[order_to_pindex(migratetype, order)];
+	while (i < count && !list_empty(slist)) {
+		list_move_tail(slist->next, list);
+		i++;
+	}
+	shard->count -= i << order;
+	shard->nr_free[order] -= i;
+	spin_unlock_irqrestore(&shard->lock, flags);
+
+	return i;
+}
+
+/*
+ * Move up to @count pages from the tail of the pcp list at @pindex to the
+ * shard of the local CPU group, as long as the shard has room for them.
+ * Returns the number of pages moved, the caller frees the rest to the buddy
+ * allocator.
+ */
+static int zone_shard_spill(struct zone *zone, struct per_cpu_pages *pcp,
+			    int count, int pindex)
+{
+	struct zone_shard *shard = zone_cpu_shard(zone);
+	struct list_head *list = &pcp->lists[pindex];
+	unsigned int order = pindex_to_order(pindex);
+	int nr_pages = 1 << order;
+	unsigned long flags;
+	int moved = 0;
+
+	if (!shard || data_race(shard->count) + nr_pages > READ_ONCE(shard->high))
+		return 0;
+
+	spin_lock_irqsave(&shard->lock, flags);
+	while (moved + nr_pages <= count && !list_empty(list) &&
+	       shard->count + nr_pages <= shard->high) {
+		struct page *page = list_last_entry(list, struct page, pcp_list);
+
+		/* Pages of isolated pageblocks go back to the buddy lists */
+		if (unlikely(is_migrate_isolate_page(page)))
+			break;
+
+		list_move(&page->pcp_list, &shard->lists[pindex]);
+		shard->count += nr_pages;
+		shard->nr_free[order]++;
+		pcp->count -= nr_pages;
+		moved += nr_pages;
+	}
+	spin_unlock_irqrestore(&shard->lock, flags);
+
+	return moved;
+}
+
 /*
- * Obtain a specified number of elements from the buddy allocator, all under
- * a single hold of the lock, for efficiency.  Add them to the supplied list.
+ * Return the pages held by the shards of @zone to the buddy allocator.
+ */
+static void drain_zone_shards(struct zone *zone)
+{
+	int i;
+
+	for (i = 0; i < zone->nr_shards; i++) {
+		struct zone_shard *shard = &zone->shards[i];
+		unsigned long flags;
+		int pindex;
+
+		if (!data_race(shard->count))
+			continue;
+
+		spin_lock_irqsave(&shard->lock, flags);
+		spin_lock(&zone->lock);
+		for (pindex = 0; pindex < NR_PCP_LISTS; pindex++) {
+			struct list_head *list = &shard->lists[pindex];
+			unsigned int order = pindex_to_order(pindex);
+
+			while (!list_empty(list)) {
+				struct page *page;
+				unsigned long pfn;
+				int mt;
+
+				page = list_last_entry(list, struct page, pcp_list);
+				pfn = page_to_pfn(page);
+				mt = get_pfnblock_migratetype(page, pfn);
+
+				list_del(&page->pcp_list);
+				__free_one_page(page, pfn, zone, order, mt, FPI_NONE);
+			}
+		}
+		shard->count = 0;
+		memset(shard->nr_free, 0, sizeof(shard->nr_free));
+		spin_unlock(&zone->lock);
+		spin_unlock_irqrestore(&shard->lock, flags);
+	}
+}
+
+/*
+ * Obtain a specified number of elements from the local zone shard, then from
+ * the buddy allocator, all under a single hold of the lock, for efficiency.
+ * Add them to the supplied list.
  * Returns the number of new pages which were placed at *list.
  */
 static int rmqueue_bulk(struct zone *zone, unsigned int order,
@@ -2307,8 +2446,12 @@ static int rmqueue_bulk(struct zone *zone, unsigned int order,
 	unsigned long flags;
 	int i;
 
+	i = zone_shard_refill(zone, order, count, list, migratetype);
+	if (i == count)
+		return i;
+
 	spin_lock_irqsave(&zone->lock, flags);
-	for (i = 0; i < count; ++i) {
+	for (; i < count; ++i) {
 		struct page *page = __rmqueue(zone, order, migratetype,
 								alloc_flags);
 		if (unlikely(page == NULL))
@@ -2507,6 +2650,15 @@ static void __drain_all_pages(struct zone *zone, bool force_all_cpus)
 			drain_pages(cpu);
 	}
 
+	if (zone) {
+		drain_zone_shards(zone);
+	} else {
+		struct zone *z;
+
+		for_each_populated_zone(z)
+			drain_zone_shards(z);
+	}
+
 	mutex_unlock(&pcpu_drain_mutex);
 }
 
@@ -2632,8 +2784,17 @@ static void free_frozen_page_commit(struct zone *zone,
 		pcp->free_count += (1 << order);
 	high = nr_pcp_high(pcp, zone, batch, free_high);
 	if (pcp->count >= high) {
-		free_pcppages_bulk(zone, nr_pcp_free(pcp, batch, high, free_high),
-				   pcp, pindex);
+		int to_free = nr_pcp_free(pcp, batch, high, free_high);
+
+		/*
+		 * Park the batch in the shard of this CPU group, unless the
+		 * pages are freed to limit fragmentation or for reclaim, which
+		 * both want them merged in the buddy lists.
+		 */
+		if (!free_high && !test_bit(ZONE_RECLAIM_ACTIVE, &zone->flags))
+			to_free -= zone_shard_spill(zone, pcp, to_free, pindex);
+		if (to_free > 0)
+			free_pcppages_bulk(zone, to_free, pcp, pindex);
 		if (test_bit(ZONE_BELOW_HIGH, &zone->flags) &&
 		    zone_watermark_ok(zone, 0, high_wmark_pages(zone),
 				      ZONE_MOVABLE, 0))
@@ -4289,6 +4450,14 @@ __alloc_pages_slowpath(gfp_t gfp_mask, unsigned int order,
 	if (page)
 		goto got_pg;
 
+	/*
+	 * The deferred struct pages may still be initialised in the background
+	 * while boot goes on: rather wait for that memory than reclaim.
+	 */
+	if (deferred_pages_enabled() && can_direct_reclaim &&
+	    _deferred_init_wait())
+		goto restart;
+
 	/*
 	 * For costly allocations, try direct compaction first, as it's likely
 	 * that we have enough base pages and don't need to reclaim. For non-
@@ -5527,12 +5696,44 @@ static void __zone_set_pageset_high_and_batch(struct zone *zone, unsigned long h
 					      unsigned long high_max, unsigned long batch)
 {
 	struct per_cpu_pages *pcp;
-	int cpu;
+	int cpu, i;
 
 	for_each_possible_cpu(cpu) {
 		pcp = per_cpu_ptr(zone->per_cpu_pageset, cpu);
 		pageset_update(pcp, high_min, high_max, batch);
 	}
+
+	/* A shard holds what a drain of one full pcp batch would free */
+	for (i = 0; i < zone->nr_shards; i++)
+		WRITE_ONCE(zone->shards[i].high,
+			   high_max ? batch << CONFIG_PCP_BATCH_SCALE_MAX : 0);
+}
+
+static void zone_shards_init(struct zone *zone)
+{
+	struct zone_shard *shards;
+	int nr_shards, i, pindex;
+
+	if (!zone_shard_cpus)
+		return;
+
+	nr_shards = DIV_ROUND_UP(nr_cpu_ids, zone_shard_cpus);
+	if (nr_shards < 2)
+		return;
+
+	shards = kcalloc_node(nr_shards, sizeof(*shards), GFP_KERNEL,
+			      zone_to_nid(zone));
+	if (!shards)
+		return;
+
+	for (i = 0; i < nr_shards; i++) {
+		spin_lock_init(&shards[i].lock);
+		for (pindex = 0; pindex < NR_PCP_LISTS; pindex++)
+			INIT_LIST_HEAD(&shards[i].lists[pindex]);
+	}
+
+	zone->nr_shards = nr_shards;
+	zone->shards = shards;
 }
 
 /*
@@ -5589,6 +5790,7 @@ void __meminit setup_zone_pageset(struct zone *zone)
 		per_cpu_pages_init(pcp, pzstats);
 	}
 
+	zone_shards_init(zone);
 	zone_set_pageset_high_and_batch(zone, 0);
 }
 
@@ -6715,6 +6917,10 @@ void zone_pcp_reset(struct zone *zone)
 		}
 		free_percpu(zone->per_cpu_pageset);
 		zone->per_cpu_pageset = &boot_pageset;
+		drain_zone_shards(zone);
+		kfree(zone->shards);
+		zone->shards = NULL;
+		zone->nr_shards = 0;
 		if (zone->per_cpu_zonestats != &boot_zonestats) {
 			free_percpu(zone->per_cpu_zonestats);
 			zone->per_cpu_zonestats = &boot_zonestats;
@@ -48,6 +48,8 @@ MODULE_PARM_DESC(page_reporting_order, "Set page reporting order");
 EXPORT_SYMBOL_GPL(page_reporting_order);
 
 #define PAGE_REPORTING_DELAY	(2 * HZ)
+#define PAGE_REPORTING_DELAY_MIN	(HZ / 8)
+#define PAGE_REPORTING_BUDGET_SHIFT_MAX	4
 static struct page_reporting_dev_info __rcu *pr_dev_info __read_mostly;
 
 enum {
@@ -80,7 +82,7 @@ __page_reporting_request(struct page_reporting_dev_info *prdev)
 	 * now we are limiting this to running no more than once every
 	 * couple of seconds.
 	 */
-	schedule_delayed_work(&prdev->work, PAGE_REPORTING_DELAY);
+	schedule_delayed_work(&prdev->work, prdev->delay);
 }
 
 /* notify prdev of free page reporting request */
@@ -174,10 +176,15 @@ page_reporting_cycle(struct page_reporting_dev_info *prdev, struct zone *zone,
 	 * list processed. This should result in us reporting all pages on
 	 * an idle system in about 30 seconds.
 	 *
+	 * While passes keep running out of budget, memory is being freed
+	 * faster than we report it, so page_reporting_process() raises
+	 * budget_shift to allow up to the whole list per pass.
+	 *
 	 * The division here should be cheap since PAGE_REPORTING_CAPACITY
 	 * should always be a power of 2.
 	 */
-	budget = DIV_ROUND_UP(area->nr_free, PAGE_REPORTING_CAPACITY * 16);
+	budget = DIV_ROUND_UP(area->nr_free, PAGE_REPORTING_CAPACITY *
+			      (16 >> prdev->budget_shift));
 
 	/* loop through free list adding unreported pages to sg list */
 	list_for_each_entry_safe(page, next, list, lru) {
@@ -191,6 +198,7 @@ page_reporting_cycle(struct page_reporting_dev_info *prdev, struct zone *zone,
 		 * processing and exit this list.
 		 */
 		if (budget < 0) {
+			prdev->budget_exhausted = true;
 			atomic_set(&prdev->state, PAGE_REPORTING_REQUESTED);
 			next = page;
 			break;
@@ -320,6 +328,7 @@ static void page_reporting_process(struct work_struct *work)
 	 * to idle and quit scheduling reporting runs.
 	 */
 	atomic_set(&prdev->state, state);
+	prdev->budget_exhausted = false;
 
 	/* allocate scatterlist to store pages being reported on */
 	sgl = kmalloc_array(PAGE_REPORTING_CAPACITY, sizeof(*sgl), GFP_KERNEL);
@@ -336,14 +345,29 @@ static void page_reporting_process(struct work_struct *work)
 
 	kfree(sgl);
 err_out:
+	/*
+	 * Scale the batch with the rate pages are freed at: a pass that ran
+	 * out of budget left a backlog, so come back sooner with a larger
+	 * budget. Otherwise fall back to the defaults.
+	 */
+	if (prdev->budget_exhausted && !err) {
+		if (prdev->budget_shift < PAGE_REPORTING_BUDGET_SHIFT_MAX)
+			prdev->budget_shift++;
+		prdev->delay = max_t(unsigned long, prdev->delay / 2,
+				     PAGE_REPORTING_DELAY_MIN);
+	} else {
+		prdev->budget_shift = 0;
+		prdev->delay = PAGE_REPORTING_DELAY;
+	}
+
 	/*
 	 * If the state has reverted back to requested then there may be
-	 * additional pages to be processed. We will defer for 2s to allow
-	 * more pages to accumulate.
+	 * additional pages to be processed. We will defer to allow more
+	 * pages to accumulate.
 	 */
 	state = atomic_cmpxchg(&prdev->state, state, PAGE_REPORTING_IDLE);
 	if (state == PAGE_REPORTING_REQUESTED)
-		schedule_delayed_work(&prdev->work, PAGE_REPORTING_DELAY);
+		schedule_delayed_work(&prdev->work, prdev->delay);
 }
 
 static DEFINE_MUTEX(page_reporting_mutex);
@@ -378,6 +402,8 @@ int page_reporting_register(struct page_reporting_dev_info *prdev)
 
 	/* initialize state and work structures */
 	atomic_set(&prdev->state, PAGE_REPORTING_IDLE);
+	prdev->delay = PAGE_REPORTING_DELAY;
+	prdev->budget_shift = 0;
 	INIT_DELAYED_WORK(&prdev->work, &page_reporting_process);
 
 	/* Begin initial flush of zones */
@@ -164,6 +164,7 @@ static inline size_t pcpu_obj_full_size(size_t size)
 
 #ifdef CONFIG_PERCPU_STATS
 
+#include <linux/sched/clock.h>
 #include <linux/spinlock.h>
 
 struct percpu_stats {
@@ -175,6 +176,9 @@ struct percpu_stats {
 	u32 nr_max_chunks;	/* max # of live chunks */
 	size_t min_alloc_size;	/* min allocation size */
 	size_t max_alloc_size;	/* max allocation size */
+	u64 nr_alloc_locked;	/* # of allocations under pcpu_alloc_mutex */
+	u64 alloc_time_ns;	/* total time spent allocating */
+	u64 max_alloc_time_ns;	/* max time spent on one allocation */
 };
 
 extern struct percpu_stats pcpu_stats;
@@ -261,12 +265,47 @@ static inline void pcpu_stats_chunk_dealloc(void)
 	spin_unlock_irqrestore(&pcpu_lock, flags);
 }
 
+static inline u64 pcpu_stats_clock(void)
+{
+	return local_clock();
+}
+
+/*
+ * pcpu_stats_alloc_time - account the latency of a successful allocation
+ * @start: pcpu_stats_clock() value at the start of the allocation
+ * @locked: whether the allocation had to take pcpu_alloc_mutex
+ */
+static inline void pcpu_stats_alloc_time(u64 start, bool locked)
+{
+	u64 delta = local_clock() - start;
+	unsigned long flags;
+
+	spin_lock_irqsave(&pcpu_lock, flags);
+
+	if (locked)
+		pcpu_stats.nr_alloc_locked++;
+	pcpu_stats.alloc_time_ns += delta;
+	pcpu_stats.max_alloc_time_ns =
+		max(pcpu_stats.max_alloc_time_ns, delta);
+
+	spin_unlock_irqrestore(&pcpu_lock, flags);
+}
+
 #else
 
 static inline void pcpu_stats_save_ai(const struct pcpu_alloc_info *ai)
 {
 }
 
+static inline u64 pcpu_stats_clock(void)
+{
+	return 0;
+}
+
+static inline void pcpu_stats_alloc_time(u64 start, bool locked)
+{
+}
+
 static inline void pcpu_stats_area_alloc(struct pcpu_chunk *chunk, size_t size)
 {
 }
@@ -188,6 +188,9 @@ static int percpu_stats_show(struct seq_file *m, void *v)
 	PU(nr_max_chunks);
 	PU(min_alloc_size);
 	PU(max_alloc_size);
+	PU(nr_alloc_locked);
+	PU(alloc_time_ns);
+	PU(max_alloc_time_ns);
 	P("empty_pop_pages", pcpu_nr_empty_pop_pages);
 	seq_putc(m, '\n');
 
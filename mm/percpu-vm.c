@@ -84,24 +84,36 @@ static int pcpu_alloc_pages(struct pcpu_chunk *chunk,
 			    gfp_t gfp)
 {
 	unsigned int cpu, tcpu;
-	int i;
+	int i, nr = page_end - page_start;
 
 	gfp |= __GFP_HIGHMEM;
 
 	for_each_possible_cpu(cpu) {
-		for (i = page_start; i < page_end; i++) {
-			struct page **pagep = &pages[pcpu_page_idx(cpu, i)];
-
-			*pagep = alloc_pages_node(cpu_to_node(cpu), gfp, 0);
-			if (!*pagep)
+		struct page **pagep = &pages[pcpu_page_idx(cpu, page_start)];
+
+		/*
+		 * The pages of a unit are consecutive in @pages, grab them
+		 * from the unit's node in one go and fall back to single
+		 * page allocations for whatever the bulk allocator left.
+		 */
+		memset(pagep, 0, nr * sizeof(*pagep));
+		if (alloc_pages_bulk_node(gfp, cpu_to_node(cpu), nr, pagep) == nr)
+			continue;
+
+		for (i = 0; i < nr; i++) {
+			if (pagep[i])
+				continue;
+			pagep[i] = alloc_pages_node(cpu_to_node(cpu), gfp, 0);
+			if (!pagep[i])
 				goto err;
 		}
 	}
 	return 0;
 
 err:
-	while (--i >= page_start)
-		__free_page(pages[pcpu_page_idx(cpu, i)]);
+	for (i = 0; i < nr; i++)
+		if (pages[pcpu_page_idx(cpu, page_start + i)])
+			__free_page(pages[pcpu_page_idx(cpu, page_start + i)]);
 
 	for_each_possible_cpu(tcpu) {
 		if (tcpu == cpu)
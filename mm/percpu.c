@@ -1712,6 +1712,48 @@ static void pcpu_alloc_tag_free_hook(struct pcpu_chunk *chunk, int off, size_t s
 }
 #endif
 
+/**
+ * pcpu_alloc_populated - allocate an area in populated pages
+ * @chunkp: out param for the chunk the area was allocated in
+ * @size: size of area to allocate in bytes
+ * @bits: size of area to allocate in allocation units
+ * @bit_align: alignment of area (max PAGE_SIZE) in allocation units
+ *
+ * Look for room for the area in the populated pages of the normal chunks,
+ * as an atomic allocation does, so that no population is needed.
+ *
+ * CONTEXT:
+ * pcpu_lock.
+ *
+ * RETURNS:
+ * Allocated offset in *@chunkp on success, -ENOSPC if there is no room.
+ */
+static int pcpu_alloc_populated(struct pcpu_chunk **chunkp, size_t size,
+				int bits, int bit_align)
+{
+	struct pcpu_chunk *chunk;
+	int slot, off;
+
+	lockdep_assert_held(&pcpu_lock);
+
+	for (slot = pcpu_size_to_slot(size); slot <= pcpu_free_slot; slot++) {
+		list_for_each_entry(chunk, &pcpu_chunk_lists[slot], list) {
+			off = pcpu_find_block_fit(chunk, bits, bit_align, true);
+			if (off < 0)
+				continue;
+
+			off = pcpu_alloc_area(chunk, bits, bit_align, off);
+			if (off >= 0) {
+				pcpu_reintegrate_chunk(chunk);
+				*chunkp = chunk;
+				return off;
+			}
+		}
+	}
+
+	return -ENOSPC;
+}
+
 /**
  * pcpu_alloc - the percpu allocator
  * @size: size of area to allocate in bytes
@@ -1741,6 +1783,8 @@ void __percpu *pcpu_alloc_noprof(size_t size, size_t align, bool reserved,
 	unsigned long flags;
 	void __percpu *ptr;
 	size_t bits, bit_align;
+	bool locked = false;
+	u64 start;
 
 	gfp = current_gfp_context(gfp);
 	/* whitelisted flags that can be passed to the backing allocators */
@@ -1771,6 +1815,24 @@ void __percpu *pcpu_alloc_noprof(size_t size, size_t align, bool reserved,
 	if (unlikely(!pcpu_memcg_pre_alloc_hook(size, gfp, &objcg)))
 		return NULL;
 
+	start = pcpu_stats_clock();
+
+	if (!is_atomic && !reserved) {
+		/*
+		 * Serve the allocation from already populated pages if
+		 * possible, without serializing on pcpu_alloc_mutex. Leave
+		 * the empty populated pages to atomic allocations if they
+		 * are running low.
+		 */
+		spin_lock_irqsave(&pcpu_lock, flags);
+		if (pcpu_nr_empty_pop_pages >= PCPU_EMPTY_POP_PAGES_LOW) {
+			off = pcpu_alloc_populated(&chunk, size, bits, bit_align);
+			if (off >= 0)
+				goto area_found;
+		}
+		spin_unlock_irqrestore(&pcpu_lock, flags);
+	}
+
 	if (!is_atomic) {
 		/*
 		 * pcpu_balance_workfn() allocates memory under this mutex,
@@ -1783,6 +1845,7 @@ void __percpu *pcpu_alloc_noprof(size_t size, size_t align, bool reserved,
 			pcpu_memcg_post_alloc_hook(objcg, NULL, 0, size);
 			return NULL;
 		}
+		locked = true;
 	}
 
 	spin_lock_irqsave(&pcpu_lock, flags);
@@ -1858,7 +1921,7 @@ void __percpu *pcpu_alloc_noprof(size_t size, size_t align, bool reserved,
 	spin_unlock_irqrestore(&pcpu_lock, flags);
 
 	/* populate if not all pages are already there */
-	if (!is_atomic) {
+	if (locked) {
 		unsigned int page_end, rs, re;
 
 		rs = PFN_DOWN(off);
@@ -1897,6 +1960,8 @@ void __percpu *pcpu_alloc_noprof(size_t size, size_t align, bool reserved,
 
 	pcpu_alloc_tag_alloc_hook(chunk, off, size);
 
+	pcpu_stats_alloc_time(start, locked);
+
 	return ptr;
 
 fail_unlock:
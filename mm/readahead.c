@@ -130,6 +130,8 @@
 #include <linux/sched/mm.h>
 #include <linux/fsnotify.h>
 
+#include <trace/events/filemap.h>
+
 #include "internal.h"
 
 /*
@@ -534,6 +536,79 @@ void page_cache_ra_order(struct readahead_control *ractl,
 				 ra->async_size);
 }
 
+/*
+ * With read_ahead_history set on the bdi, a mapping remembers the last
+ * window of its sequential readers, so that a new open which starts where
+ * previous ones streamed from does not have to ramp up again.
+ */
+#define RA_HISTORY_CONFIDENT	2
+
+static bool ra_history_enabled(struct address_space *mapping)
+{
+	return READ_ONCE(inode_to_bdi(mapping->host)->ra_history);
+}
+
+static void ra_history_update(struct readahead_control *ractl,
+		struct file_ra_state *ra, unsigned int order, bool sequential)
+{
+	struct address_space *mapping = ractl->mapping;
+	unsigned int old, new, conf;
+
+	if (!ra_history_enabled(mapping))
+		return;
+
+	old = READ_ONCE(mapping->ra_history);
+	conf = FIELD_GET(RA_HISTORY_CONF, old);
+	if (sequential) {
+		conf = min_t(unsigned int, conf + 1,
+			     FIELD_MAX(RA_HISTORY_CONF));
+		new = FIELD_PREP(RA_HISTORY_CONF, conf) |
+		      FIELD_PREP(RA_HISTORY_ORDER,
+				 min_t(unsigned int, order,
+				       FIELD_MAX(RA_HISTORY_ORDER))) |
+		      FIELD_PREP(RA_HISTORY_SIZE,
+				 min_t(unsigned int, ra->size,
+				       FIELD_MAX(RA_HISTORY_SIZE)));
+	} else {
+		if (!conf)
+			return;
+		new = old & ~RA_HISTORY_CONF;
+	}
+
+	if (new != old) {
+		/* Racing updates from other opens are fine, it is a hint */
+		WRITE_ONCE(mapping->ra_history, new);
+		trace_mm_filemap_ra_history(mapping, readahead_index(ractl), new);
+	}
+}
+
+/*
+ * On the first read of a struct file, start with the window the mapping's
+ * previous sequential readers had ramped up to. Return the folio order to
+ * read with, or -1 to go through the normal ramp up.
+ */
+static int ra_history_inherit(struct readahead_control *ractl,
+		struct file_ra_state *ra, unsigned long req_count,
+		unsigned long max_pages)
+{
+	struct address_space *mapping = ractl->mapping;
+	unsigned int history;
+
+	if (ra->prev_pos != -1 || !ra_history_enabled(mapping))
+		return -1;
+
+	history = READ_ONCE(mapping->ra_history);
+	if (FIELD_GET(RA_HISTORY_CONF, history) < RA_HISTORY_CONFIDENT)
+		return -1;
+
+	ra->start = readahead_index(ractl);
+	ra->size = clamp_t(unsigned long, FIELD_GET(RA_HISTORY_SIZE, history),
+			   req_count, max_pages);
+	ra->async_size = ra->size > req_count ? ra->size - req_count :
+						ra->size >> 1;
+	return FIELD_GET(RA_HISTORY_ORDER, history);
+}
+
 static unsigned long ractl_max_pages(struct readahead_control *ractl,
 		unsigned long req_size)
 {
@@ -557,6 +632,7 @@ void page_cache_sync_ra(struct readahead_control *ractl,
 	struct file_ra_state *ra = ractl->ra;
 	unsigned long max_pages, contig_count;
 	pgoff_t prev_index, miss;
+	int order;
 
 	/*
 	 * If we have pre-content watches we need to disable readahead to make
@@ -587,6 +663,15 @@ void page_cache_sync_ra(struct readahead_control *ractl,
 	}
 
 	max_pages = ractl_max_pages(ractl, req_count);
+	if (req_count <= max_pages) {
+		order = ra_history_inherit(ractl, ra, req_count, max_pages);
+		if (order >= 0) {
+			ractl->_index = ra->start;
+			page_cache_ra_order(ractl, ra, order);
+			return;
+		}
+	}
+
 	prev_index = (unsigned long long)ra->prev_pos >> PAGE_SHIFT;
 	/*
 	 * A start of file, oversized read, or sequential cache miss:
@@ -614,6 +699,7 @@ void page_cache_sync_ra(struct readahead_control *ractl,
 	 * readahead state.
 	 */
 	if (contig_count <= req_count) {
+		ra_history_update(ractl, ra, 0, false);
 		do_page_cache_ra(ractl, req_count, 0);
 		return;
 	}
@@ -675,6 +761,7 @@ void page_cache_async_ra(struct readahead_control *ractl,
 		 */
 		ra->size = max(ra->size, get_next_ra_size(ra, max_pages));
 		ra->async_size = ra->size;
+		ra_history_update(ractl, ra, order, true);
 		goto readit;
 	}
 
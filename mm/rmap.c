@@ -846,6 +846,30 @@ struct folio_referenced_arg {
 /*
  * arg: folio_referenced_arg will be passed
  */
+/*
+ * Count the pages of @folio mapped young from @pvmw->pte on, within the same
+ * page table, before the walk clears the access bits.
+ */
+static unsigned int folio_young_ptes(struct folio *folio,
+				     struct page_vma_mapped_walk *pvmw)
+{
+	unsigned long addr = pvmw->address;
+	unsigned long end = pmd_addr_end(addr, pvmw->vma->vm_end);
+	unsigned long pfn = pte_pfn(ptep_get(pvmw->pte));
+	unsigned long end_pfn = folio_pfn(folio) + folio_nr_pages(folio);
+	unsigned int young = 0;
+	pte_t *ptep = pvmw->pte;
+
+	for (; addr < end && pfn < end_pfn; addr += PAGE_SIZE, pfn++, ptep++) {
+		pte_t pte = ptep_get(ptep);
+
+		if (pte_present(pte) && pte_pfn(pte) == pfn && pte_young(pte))
+			young++;
+	}
+
+	return young;
+}
+
 static bool folio_referenced_one(struct folio *folio,
 		struct vm_area_struct *vma, unsigned long address, void *arg)
 {
@@ -853,6 +877,9 @@ static bool folio_referenced_one(struct folio *folio,
 	DEFINE_FOLIO_VMA_WALK(pvmw, folio, vma, address, 0);
 	int referenced = 0;
 	unsigned long start = address, ptes = 0;
+	bool sample = transparent_hugepage_anon_adaptive() &&
+		      folio_test_anon(folio) && folio_test_large(folio) &&
+		      !folio_test_pmd_mappable(folio);
 
 	while (page_vma_mapped_walk(&pvmw)) {
 		address = pvmw.address;
@@ -895,6 +922,13 @@ static bool folio_referenced_one(struct folio *folio,
 			return false;
 		}
 
+		/* Sample the use of mTHPs by this mm for anonymous faults */
+		if (sample && pvmw.pte) {
+			mthp_anon_record_access(vma->vm_mm, folio,
+						folio_young_ptes(folio, &pvmw));
+			sample = false;
+		}
+
 		if (lru_gen_enabled() && pvmw.pte) {
 			if (lru_gen_look_around(&pvmw))
 				referenced++;
@@ -1617,8 +1617,11 @@ static int shmem_writepage(struct page *page, struct writeback_control *wbc)
 
 	swap = folio_alloc_swap(folio);
 	if (!swap.val) {
-		if (nr_pages > 1)
+		if (nr_pages > 1) {
+			count_mthp_stat(folio_order(folio),
+					MTHP_STAT_SHMEM_SWPOUT_FALLBACK);
 			goto try_split;
+		}
 
 		goto redirty;
 	}
@@ -1641,6 +1644,7 @@ static int shmem_writepage(struct page *page, struct writeback_control *wbc)
 		shmem_recalc_inode(inode, 0, nr_pages);
 		swap_shmem_alloc(swap, nr_pages);
 		shmem_delete_from_page_cache(folio, swp_to_radix_entry(swap));
+		count_mthp_stat(folio_order(folio), MTHP_STAT_SHMEM_SWPOUT);
 
 		mutex_unlock(&shmem_swaplist_mutex);
 		BUG_ON(folio_mapped(folio));
@@ -2026,6 +2030,36 @@ static struct folio *shmem_swap_alloc_folio(struct inode *inode,
 	return new;
 }
 
+/*
+ * Swap in a large swap entry as a whole through the swap cache, for devices
+ * where it can't be skipped: the range was swapped out as one folio, so read
+ * it back as one rather than splitting the entry.
+ */
+static struct folio *shmem_swapin_large_folio(struct inode *inode,
+		struct vm_area_struct *vma, pgoff_t index,
+		swp_entry_t entry, int order, gfp_t gfp)
+{
+	struct shmem_inode_info *info = SHMEM_I(inode);
+	struct folio *new;
+
+	gfp &= ~GFP_CONSTRAINT_MASK;
+	gfp = limit_gfp_mask(vma_thp_gfp_mask(vma), gfp);
+
+	new = shmem_alloc_folio(gfp, order, info, index);
+	if (!new)
+		return NULL;
+
+	if (mem_cgroup_swapin_charge_folio(new, vma ? vma->vm_mm : NULL,
+					   gfp, entry) ||
+	    !swap_cache_add_large_folio(new, entry, gfp)) {
+		folio_put(new);
+		return NULL;
+	}
+
+	swap_read_folio(new, NULL);
+	return new;
+}
+
 /*
  * When a page is moved from swapcache to shmem filecache (either by the
  * usual swapin of shmem_get_folio_gfp(), or by the less common swapoff of
@@ -2309,6 +2343,12 @@ static int shmem_swapin_folio(struct inode *inode, pgoff_t index,
 			folio = NULL;
 			if (error == -EEXIST)
 				goto failed;
+		} else if (IS_ENABLED(CONFIG_THP_SWAP) && !fallback_order0 &&
+			   order > 0) {
+			folio = shmem_swapin_large_folio(inode, vma, index, swap,
+							 order, gfp);
+			if (folio)
+				goto alloced;
 		}
 
 		/*
@@ -2321,6 +2361,8 @@ static int shmem_swapin_folio(struct inode *inode, pgoff_t index,
 			error = split_order;
 			goto failed;
 		}
+		if (split_order > 0)
+			count_mthp_stat(split_order, MTHP_STAT_SHMEM_SWPIN_FALLBACK);
 
 		/*
 		 * If the large swap entry has already been split, it is
@@ -2376,6 +2418,8 @@ static int shmem_swapin_folio(struct inode *inode, pgoff_t index,
 		goto failed;
 
 	shmem_recalc_inode(inode, 0, -nr_pages);
+	if (nr_pages > 1)
+		count_mthp_stat(folio_order(folio), MTHP_STAT_SHMEM_SWPIN);
 
 	if (sgp == SGP_WRITE)
 		folio_mark_accessed(folio);
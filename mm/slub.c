@@ -371,6 +371,18 @@ enum stat_item {
 	CPU_PARTIAL_FREE,	/* Refill cpu partial on free */
 	CPU_PARTIAL_NODE,	/* Refill cpu partial from node partial */
 	CPU_PARTIAL_DRAIN,	/* Drain cpu partial to node partial */
+	ALLOC_PCS,		/* Allocation from percpu sheaf */
+	ALLOC_PCS_MISS,		/* Percpu sheaves could not serve allocation */
+	FREE_PCS,		/* Free to percpu sheaf */
+	FREE_PCS_MISS,		/* Percpu sheaves could not take free */
+	SHEAF_FLUSH,		/* Objects flushed from a sheaf to slabs */
+	SHEAF_REFILL,		/* Objects refilled to a sheaf from slabs */
+	SHEAF_ALLOC,		/* Allocation of an empty sheaf */
+	SHEAF_FREE,		/* Freeing of an empty sheaf */
+	BARN_GET,		/* Got full or empty sheaf from barn */
+	BARN_GET_FAIL,		/* Barn had no sheaf of the needed kind */
+	BARN_PUT,		/* Put full or empty sheaf to barn */
+	BARN_PUT_FAIL,		/* Barn had no room for the sheaf */
 	NR_SLUB_STAT_ITEMS
 };
 
@@ -396,6 +408,30 @@ struct kmem_cache_cpu {
 	unsigned int stat[NR_SLUB_STAT_ITEMS];
 #endif
 };
+
+/*
+ * Opt-in percpu arrays of objects, see &kmem_cache_args.sheaf_capacity.
+ */
+struct slab_sheaf {
+	struct list_head barn_list;
+	unsigned int size;
+	void *objects[];
+};
+
+struct slub_percpu_sheaves {
+	local_lock_t lock;
+	struct slab_sheaf *main;	/* never NULL when unlocked */
+	struct slab_sheaf *spare;	/* empty or full, may be NULL */
+};
+
+/* Per-node stock of full and empty sheaves shared by all cpus */
+struct node_barn {
+	spinlock_t lock;
+	struct list_head sheaves_full;
+	struct list_head sheaves_empty;
+	unsigned int nr_full;
+	unsigned int nr_empty;
+};
 #endif /* CONFIG_SLUB_TINY */
 
 static inline void stat(const struct kmem_cache *s, enum stat_item si)
@@ -429,6 +465,9 @@ struct kmem_cache_node {
 	atomic_long_t total_objects;
 	struct list_head full;
 #endif
+#ifndef CONFIG_SLUB_TINY
+	struct node_barn barn;
+#endif
 };
 
 static inline struct kmem_cache_node *get_node(struct kmem_cache *s, int node)
@@ -3279,6 +3318,424 @@ static inline void __flush_cpu_slab(struct kmem_cache *s, int cpu)
 	put_partials_cpu(s, c);
 }
 
+/*
+ * Percpu sheaves
+ *
+ * A sheaf is an array of objects that were allocated from slabs in bulk, or
+ * that will be freed to slabs in bulk. Caches created with a sheaf_capacity
+ * have a main sheaf per cpu that allocations take objects from and frees put
+ * objects to, under the local lock only, and possibly a spare sheaf which is
+ * either empty or full. When neither can serve the request, the empty or full
+ * main sheaf is exchanged for a full or empty one in the barn of the local
+ * node. Only when that fails is a sheaf refilled from or flushed to slabs.
+ *
+ * Objects in sheaves have already been through the free hooks and still need
+ * to go through the alloc hooks, like objects on the slab freelists.
+ */
+#define MAX_FULL_SHEAVES	10
+#define MAX_EMPTY_SHEAVES	10
+#define PCS_BATCH_MAX		32U
+
+/* Sheaves are not accounted, not reclaimable and not needed for progress */
+#define SHEAF_GFP_CLEAR_MASK	(__GFP_DMA | __GFP_DMA32 | __GFP_HIGHMEM | \
+				 __GFP_RECLAIMABLE | __GFP_ACCOUNT | \
+				 __GFP_NOFAIL | __GFP_ZERO | __GFP_COMP)
+
+static int __kmem_cache_alloc_bulk(struct kmem_cache *s, gfp_t flags,
+				   size_t size, void **p);
+static void __kmem_cache_free_bulk(struct kmem_cache *s, size_t size, void **p);
+
+static inline struct node_barn *get_barn(struct kmem_cache *s)
+{
+	struct kmem_cache_node *n = get_node(s, numa_mem_id());
+
+	return n ? &n->barn : NULL;
+}
+
+static struct slab_sheaf *alloc_empty_sheaf(struct kmem_cache *s, gfp_t gfp)
+{
+	struct slab_sheaf *sheaf;
+
+	gfp &= ~SHEAF_GFP_CLEAR_MASK;
+	sheaf = kzalloc(struct_size(sheaf, objects, s->sheaf_capacity),
+			gfp | __GFP_NOWARN);
+	if (sheaf)
+		stat(s, SHEAF_ALLOC);
+
+	return sheaf;
+}
+
+static void free_empty_sheaf(struct kmem_cache *s, struct slab_sheaf *sheaf)
+{
+	kfree(sheaf);
+	stat(s, SHEAF_FREE);
+}
+
+static int refill_sheaf(struct kmem_cache *s, struct slab_sheaf *sheaf,
+			gfp_t gfp)
+{
+	int to_fill = s->sheaf_capacity - sheaf->size;
+
+	if (!to_fill)
+		return 0;
+
+	/*
+	 * Memory reserves are only for those who need them right now, objects
+	 * from pfmemalloc slabs must not be cached for everybody else.
+	 */
+	if (!__kmem_cache_alloc_bulk(s, gfp | __GFP_NOMEMALLOC, to_fill,
+				     &sheaf->objects[sheaf->size]))
+		return -ENOMEM;
+
+	sheaf->size = s->sheaf_capacity;
+	stat_add(s, SHEAF_REFILL, to_fill);
+
+	return 0;
+}
+
+static void sheaf_flush(struct kmem_cache *s, struct slab_sheaf *sheaf)
+{
+	if (!sheaf->size)
+		return;
+
+	__kmem_cache_free_bulk(s, sheaf->size, sheaf->objects);
+	stat_add(s, SHEAF_FLUSH, sheaf->size);
+	sheaf->size = 0;
+}
+
+static struct slab_sheaf *barn_get(struct kmem_cache *s,
+				   struct node_barn *barn, bool full)
+{
+	struct slab_sheaf *sheaf = NULL;
+	struct list_head *list;
+	unsigned long flags;
+
+	if (!barn)
+		return NULL;
+
+	list = full ? &barn->sheaves_full : &barn->sheaves_empty;
+	if (list_empty_careful(list)) {
+		stat(s, BARN_GET_FAIL);
+		return NULL;
+	}
+
+	spin_lock_irqsave(&barn->lock, flags);
+	sheaf = list_first_entry_or_null(list, struct slab_sheaf, barn_list);
+	if (sheaf) {
+		list_del(&sheaf->barn_list);
+		if (full)
+			barn->nr_full--;
+		else
+			barn->nr_empty--;
+	}
+	spin_unlock_irqrestore(&barn->lock, flags);
+
+	stat(s, sheaf ? BARN_GET : BARN_GET_FAIL);
+
+	return sheaf;
+}
+
+static bool barn_put(struct kmem_cache *s, struct node_barn *barn,
+		     struct slab_sheaf *sheaf)
+{
+	bool full = sheaf->size;
+	unsigned long flags;
+	bool ret = false;
+
+	if (!barn)
+		goto out;
+
+	spin_lock_irqsave(&barn->lock, flags);
+	if (full && barn->nr_full < MAX_FULL_SHEAVES) {
+		list_add(&sheaf->barn_list, &barn->sheaves_full);
+		barn->nr_full++;
+		ret = true;
+	} else if (!full && barn->nr_empty < MAX_EMPTY_SHEAVES) {
+		list_add(&sheaf->barn_list, &barn->sheaves_empty);
+		barn->nr_empty++;
+		ret = true;
+	}
+	spin_unlock_irqrestore(&barn->lock, flags);
+out:
+	stat(s, ret ? BARN_PUT : BARN_PUT_FAIL);
+
+	return ret;
+}
+
+/* Stash a sheaf that is no longer main, or get rid of it */
+static void sheaf_retire(struct kmem_cache *s, struct slab_sheaf *sheaf)
+{
+	if (barn_put(s, get_barn(s), sheaf))
+		return;
+
+	sheaf_flush(s, sheaf);
+	free_empty_sheaf(s, sheaf);
+}
+
+/*
+ * Make the main sheaf of @pcs, which is empty, one with objects, if the spare
+ * or the barn can provide it. Called with the local lock held. The previous
+ * main sheaf is passed back in @retired if it could not be kept as spare.
+ */
+static bool pcs_swap_empty_main(struct kmem_cache *s,
+				struct slub_percpu_sheaves *pcs,
+				struct slab_sheaf **retired)
+{
+	struct slab_sheaf *full;
+
+	if (pcs->spare && pcs->spare->size) {
+		swap(pcs->main, pcs->spare);
+		return true;
+	}
+
+	full = barn_get(s, get_barn(s), true);
+	if (!full)
+		return false;
+
+	if (!pcs->spare)
+		pcs->spare = pcs->main;
+	else
+		*retired = pcs->main;
+	pcs->main = full;
+
+	return true;
+}
+
+static void *alloc_from_pcs(struct kmem_cache *s, gfp_t gfp)
+{
+	struct slab_sheaf *retired = NULL, *full;
+	struct slub_percpu_sheaves *pcs;
+	unsigned long flags;
+	void *object;
+
+	local_lock_irqsave(&s->cpu_sheaves->lock, flags);
+	pcs = this_cpu_ptr(s->cpu_sheaves);
+
+	if (likely(pcs->main->size) || pcs_swap_empty_main(s, pcs, &retired))
+		goto out;
+
+	local_unlock_irqrestore(&s->cpu_sheaves->lock, flags);
+
+	/* Refill without the local lock, slab allocation might sleep */
+	full = barn_get(s, get_barn(s), false);
+	if (!full)
+		full = alloc_empty_sheaf(s, gfp);
+	if (!full)
+		goto miss;
+
+	if (refill_sheaf(s, full, gfp)) {
+		sheaf_retire(s, full);
+		goto miss;
+	}
+
+	local_lock_irqsave(&s->cpu_sheaves->lock, flags);
+	pcs = this_cpu_ptr(s->cpu_sheaves);
+
+	if (pcs->main->size) {
+		retired = full;
+	} else {
+		if (!pcs->spare)
+			pcs->spare = pcs->main;
+		else
+			retired = pcs->main;
+		pcs->main = full;
+	}
+out:
+	object = pcs->main->objects[--pcs->main->size];
+	local_unlock_irqrestore(&s->cpu_sheaves->lock, flags);
+
+	if (retired)
+		sheaf_retire(s, retired);
+
+	stat(s, ALLOC_PCS);
+	return object;
+miss:
+	stat(s, ALLOC_PCS_MISS);
+	return NULL;
+}
+
+/* As pcs_swap_empty_main(), for a full main sheaf on free */
+static bool pcs_swap_full_main(struct kmem_cache *s,
+			       struct slub_percpu_sheaves *pcs,
+			       struct slab_sheaf **retired)
+{
+	struct slab_sheaf *empty;
+
+	if (pcs->spare && !pcs->spare->size) {
+		swap(pcs->main, pcs->spare);
+		return true;
+	}
+
+	empty = barn_get(s, get_barn(s), false);
+	if (!empty)
+		return false;
+
+	if (!pcs->spare)
+		pcs->spare = pcs->main;
+	else
+		*retired = pcs->main;
+	pcs->main = empty;
+
+	return true;
+}
+
+static bool free_to_pcs(struct kmem_cache *s, void *object)
+{
+	struct slab_sheaf *retired = NULL, *empty;
+	struct slub_percpu_sheaves *pcs;
+	unsigned long flags;
+
+	local_lock_irqsave(&s->cpu_sheaves->lock, flags);
+	pcs = this_cpu_ptr(s->cpu_sheaves);
+
+	if (likely(pcs->main->size < s->sheaf_capacity) ||
+	    pcs_swap_full_main(s, pcs, &retired))
+		goto out;
+
+	local_unlock_irqrestore(&s->cpu_sheaves->lock, flags);
+
+	empty = alloc_empty_sheaf(s, GFP_NOWAIT);
+	if (!empty) {
+		stat(s, FREE_PCS_MISS);
+		return false;
+	}
+
+	local_lock_irqsave(&s->cpu_sheaves->lock, flags);
+	pcs = this_cpu_ptr(s->cpu_sheaves);
+
+	if (pcs->main->size < s->sheaf_capacity) {
+		retired = empty;
+	} else {
+		if (!pcs->spare)
+			pcs->spare = pcs->main;
+		else
+			retired = pcs->main;
+		pcs->main = empty;
+	}
+out:
+	pcs->main->objects[pcs->main->size++] = object;
+	local_unlock_irqrestore(&s->cpu_sheaves->lock, flags);
+
+	if (retired)
+		sheaf_retire(s, retired);
+
+	stat(s, FREE_PCS);
+	return true;
+}
+
+/*
+ * Return the objects of the local cpu's sheaves to slabs. The main sheaf is
+ * flushed in batches so that interrupts are not disabled for long.
+ */
+static void pcs_flush_all(struct kmem_cache *s)
+{
+	struct slub_percpu_sheaves *pcs;
+	void *objects[PCS_BATCH_MAX];
+	struct slab_sheaf *spare;
+	unsigned long flags;
+	unsigned int batch;
+
+	local_lock_irqsave(&s->cpu_sheaves->lock, flags);
+	pcs = this_cpu_ptr(s->cpu_sheaves);
+	spare = pcs->spare;
+	pcs->spare = NULL;
+	local_unlock_irqrestore(&s->cpu_sheaves->lock, flags);
+
+	if (spare) {
+		sheaf_flush(s, spare);
+		free_empty_sheaf(s, spare);
+	}
+
+	do {
+		local_lock_irqsave(&s->cpu_sheaves->lock, flags);
+		pcs = this_cpu_ptr(s->cpu_sheaves);
+		batch = min(pcs->main->size, PCS_BATCH_MAX);
+		pcs->main->size -= batch;
+		memcpy(objects, &pcs->main->objects[pcs->main->size],
+		       batch * sizeof(void *));
+		local_unlock_irqrestore(&s->cpu_sheaves->lock, flags);
+
+		__kmem_cache_free_bulk(s, batch, objects);
+		stat_add(s, SHEAF_FLUSH, batch);
+	} while (batch == PCS_BATCH_MAX);
+}
+
+/* For a cpu that is dead, so that nothing else can access its sheaves */
+static void __pcs_flush_all_cpu(struct kmem_cache *s, unsigned int cpu)
+{
+	struct slub_percpu_sheaves *pcs = per_cpu_ptr(s->cpu_sheaves, cpu);
+
+	if (pcs->spare) {
+		sheaf_flush(s, pcs->spare);
+		free_empty_sheaf(s, pcs->spare);
+		pcs->spare = NULL;
+	}
+
+	sheaf_flush(s, pcs->main);
+}
+
+static void barn_shrink(struct kmem_cache *s, struct node_barn *barn)
+{
+	struct slab_sheaf *sheaf, *tmp;
+	unsigned long flags;
+	LIST_HEAD(full);
+	LIST_HEAD(empty);
+
+	spin_lock_irqsave(&barn->lock, flags);
+	list_splice_init(&barn->sheaves_full, &full);
+	list_splice_init(&barn->sheaves_empty, &empty);
+	barn->nr_full = 0;
+	barn->nr_empty = 0;
+	spin_unlock_irqrestore(&barn->lock, flags);
+
+	list_for_each_entry_safe(sheaf, tmp, &full, barn_list) {
+		sheaf_flush(s, sheaf);
+		free_empty_sheaf(s, sheaf);
+	}
+
+	list_for_each_entry_safe(sheaf, tmp, &empty, barn_list)
+		free_empty_sheaf(s, sheaf);
+}
+
+static int init_percpu_sheaves(struct kmem_cache *s)
+{
+	int cpu;
+
+	s->cpu_sheaves = alloc_percpu(struct slub_percpu_sheaves);
+	if (!s->cpu_sheaves)
+		return -ENOMEM;
+
+	for_each_possible_cpu(cpu) {
+		struct slub_percpu_sheaves *pcs = per_cpu_ptr(s->cpu_sheaves, cpu);
+
+		local_lock_init(&pcs->lock);
+		pcs->main = alloc_empty_sheaf(s, GFP_KERNEL);
+		if (!pcs->main)
+			return -ENOMEM;
+	}
+
+	return 0;
+}
+
+static void free_percpu_sheaves(struct kmem_cache *s)
+{
+	int cpu;
+
+	if (!s->cpu_sheaves)
+		return;
+
+	for_each_possible_cpu(cpu) {
+		struct slub_percpu_sheaves *pcs = per_cpu_ptr(s->cpu_sheaves, cpu);
+
+		/* all sheaves have been flushed by now */
+		kfree(pcs->main);
+		kfree(pcs->spare);
+	}
+
+	free_percpu(s->cpu_sheaves);
+	s->cpu_sheaves = NULL;
+}
+
 struct slub_flush_work {
 	struct work_struct work;
 	struct kmem_cache *s;
@@ -3299,6 +3756,10 @@ static void flush_cpu_slab(struct work_struct *w)
 	sfw = container_of(w, struct slub_flush_work, work);
 
 	s = sfw->s;
+
+	if (s->cpu_sheaves)
+		pcs_flush_all(s);
+
 	c = this_cpu_ptr(s->cpu_slab);
 
 	if (c->slab)
@@ -3310,6 +3771,13 @@ static void flush_cpu_slab(struct work_struct *w)
 static bool has_cpu_slab(int cpu, struct kmem_cache *s)
 {
 	struct kmem_cache_cpu *c = per_cpu_ptr(s->cpu_slab, cpu);
+	struct slub_percpu_sheaves *pcs;
+
+	if (s->cpu_sheaves) {
+		pcs = per_cpu_ptr(s->cpu_sheaves, cpu);
+		if (READ_ONCE(pcs->main->size) || READ_ONCE(pcs->spare))
+			return true;
+	}
 
 	return c->slab || slub_percpu_partial(c);
 }
@@ -3320,9 +3788,18 @@ static DEFINE_PER_CPU(struct slub_flush_work, slub_flush);
 static void flush_all_cpus_locked(struct kmem_cache *s)
 {
 	struct slub_flush_work *sfw;
+	struct kmem_cache_node *n;
 	unsigned int cpu;
+	int node;
 
 	lockdep_assert_cpus_held();
+
+	/* before the cpu slabs, which the flushed objects may go to */
+	if (s->cpu_sheaves) {
+		for_each_kmem_cache_node(s, node, n)
+			barn_shrink(s, &n->barn);
+	}
+
 	mutex_lock(&flush_lock);
 
 	for_each_online_cpu(cpu) {
@@ -3363,13 +3840,26 @@ static int slub_cpu_dead(unsigned int cpu)
 	struct kmem_cache *s;
 
 	mutex_lock(&slab_mutex);
-	list_for_each_entry(s, &slab_caches, list)
+	list_for_each_entry(s, &slab_caches, list) {
+		if (s->cpu_sheaves)
+			__pcs_flush_all_cpu(s, cpu);
 		__flush_cpu_slab(s, cpu);
+	}
 	mutex_unlock(&slab_mutex);
 	return 0;
 }
 
 #else /* CONFIG_SLUB_TINY */
+static inline void *alloc_from_pcs(struct kmem_cache *s, gfp_t gfp)
+{
+	return NULL;
+}
+static inline bool free_to_pcs(struct kmem_cache *s, void *object)
+{
+	return false;
+}
+static inline int init_percpu_sheaves(struct kmem_cache *s) { return 0; }
+static inline void free_percpu_sheaves(struct kmem_cache *s) { }
 static inline void flush_all_cpus_locked(struct kmem_cache *s) { }
 static inline void flush_all(struct kmem_cache *s) { }
 static inline void __flush_cpu_slab(struct kmem_cache *s, int cpu) { }
@@ -4149,7 +4639,11 @@ static __fastpath_inline void *slab_alloc_node(struct kmem_cache *s, struct list
 	if (unlikely(object))
 		goto out;
 
-	object = __slab_alloc_node(s, gfpflags, node, addr, orig_size);
+	if (s->cpu_sheaves && node == NUMA_NO_NODE)
+		object = alloc_from_pcs(s, gfpflags);
+
+	if (!object)
+		object = __slab_alloc_node(s, gfpflags, node, addr, orig_size);
 
 	maybe_wipe_obj_freeptr(s, object);
 	init = slab_want_init_on_alloc(gfpflags, s);
@@ -4606,8 +5100,19 @@ void slab_free(struct kmem_cache *s, struct slab *slab, void *object,
 	memcg_slab_free_hook(s, slab, &object, 1);
 	alloc_tagging_slab_free_hook(s, slab, &object, 1);
 
-	if (likely(slab_free_hook(s, object, slab_want_init_on_free(s), false)))
-		do_slab_free(s, slab, object, object, 1, addr);
+	if (unlikely(!slab_free_hook(s, object, slab_want_init_on_free(s), false)))
+		return;
+
+	/*
+	 * Only cache objects of the local node, and not those from memory
+	 * reserves or kfence, which must go back where they came from.
+	 */
+	if (s->cpu_sheaves && likely(slab_nid(slab) == numa_mem_id()) &&
+	    likely(!slab_test_pfmemalloc(slab)) &&
+	    likely(!is_kfence_address(object)) && free_to_pcs(s, object))
+		return;
+
+	do_slab_free(s, slab, object, object, 1, addr);
 }
 
 #ifdef CONFIG_MEMCG
@@ -5274,6 +5779,13 @@ init_kmem_cache_node(struct kmem_cache_node *n)
 	atomic_long_set(&n->total_objects, 0);
 	INIT_LIST_HEAD(&n->full);
 #endif
+#ifndef CONFIG_SLUB_TINY
+	spin_lock_init(&n->barn.lock);
+	INIT_LIST_HEAD(&n->barn.sheaves_full);
+	INIT_LIST_HEAD(&n->barn.sheaves_empty);
+	n->barn.nr_full = 0;
+	n->barn.nr_empty = 0;
+#endif
 }
 
 #ifndef CONFIG_SLUB_TINY
@@ -5363,6 +5875,7 @@ static void free_kmem_cache_nodes(struct kmem_cache *s)
 void __kmem_cache_release(struct kmem_cache *s)
 {
 	cache_random_seq_destroy(s);
+	free_percpu_sheaves(s);
 #ifndef CONFIG_SLUB_TINY
 	free_percpu(s->cpu_slab);
 #endif
@@ -6210,6 +6723,14 @@ int do_kmem_cache_create(struct kmem_cache *s, const char *name,
 	if (!alloc_kmem_cache_cpus(s))
 		goto out;
 
+	/* Sheaves would hide objects from the debugging checks */
+	if (args->sheaf_capacity && !kmem_cache_debug(s) &&
+	    slab_state >= UP) {
+		s->sheaf_capacity = args->sheaf_capacity;
+		if (init_percpu_sheaves(s))
+			goto out;
+	}
+
 	err = 0;
 
 	/* Mutex is not taken during early boot */
@@ -6710,6 +7231,12 @@ static ssize_t cpu_partial_store(struct kmem_cache *s, const char *buf,
 }
 SLAB_ATTR(cpu_partial);
 
+static ssize_t sheaf_capacity_show(struct kmem_cache *s, char *buf)
+{
+	return sysfs_emit(buf, "%u\n", s->cpu_sheaves ? s->sheaf_capacity : 0);
+}
+SLAB_ATTR_RO(sheaf_capacity);
+
 static ssize_t ctor_show(struct kmem_cache *s, char *buf)
 {
 	if (!s->ctor)
@@ -7035,6 +7562,18 @@ STAT_ATTR(CPU_PARTIAL_ALLOC, cpu_partial_alloc);
 STAT_ATTR(CPU_PARTIAL_FREE, cpu_partial_free);
 STAT_ATTR(CPU_PARTIAL_NODE, cpu_partial_node);
 STAT_ATTR(CPU_PARTIAL_DRAIN, cpu_partial_drain);
+STAT_ATTR(ALLOC_PCS, alloc_cpu_sheaf);
+STAT_ATTR(ALLOC_PCS_MISS, alloc_cpu_sheaf_miss);
+STAT_ATTR(FREE_PCS, free_cpu_sheaf);
+STAT_ATTR(FREE_PCS_MISS, free_cpu_sheaf_miss);
+STAT_ATTR(SHEAF_FLUSH, sheaf_flush);
+STAT_ATTR(SHEAF_REFILL, sheaf_refill);
+STAT_ATTR(SHEAF_ALLOC, sheaf_alloc);
+STAT_ATTR(SHEAF_FREE, sheaf_free);
+STAT_ATTR(BARN_GET, barn_get);
+STAT_ATTR(BARN_GET_FAIL, barn_get_fail);
+STAT_ATTR(BARN_PUT, barn_put);
+STAT_ATTR(BARN_PUT_FAIL, barn_put_fail);
 #endif	/* CONFIG_SLUB_STATS */
 
 #ifdef CONFIG_KFENCE
@@ -7067,6 +7606,7 @@ static struct attribute *slab_attrs[] = {
 	&order_attr.attr,
 	&min_partial_attr.attr,
 	&cpu_partial_attr.attr,
+	&sheaf_capacity_attr.attr,
 	&objects_partial_attr.attr,
 	&partial_attr.attr,
 	&cpu_slabs_attr.attr,
@@ -7122,6 +7662,18 @@ static struct attribute *slab_attrs[] = {
 	&cpu_partial_free_attr.attr,
 	&cpu_partial_node_attr.attr,
 	&cpu_partial_drain_attr.attr,
+	&alloc_cpu_sheaf_attr.attr,
+	&alloc_cpu_sheaf_miss_attr.attr,
+	&free_cpu_sheaf_attr.attr,
+	&free_cpu_sheaf_miss_attr.attr,
+	&sheaf_flush_attr.attr,
+	&sheaf_refill_attr.attr,
+	&sheaf_alloc_attr.attr,
+	&sheaf_free_attr.attr,
+	&barn_get_attr.attr,
+	&barn_get_fail_attr.attr,
+	&barn_put_attr.attr,
+	&barn_put_fail_attr.attr,
 #endif
 #ifdef CONFIG_FAILSLAB
 	&failslab_attr.attr,
@@ -544,6 +544,47 @@ struct folio *__read_swap_cache_async(swp_entry_t entry, gfp_t gfp_mask,
 	return result;
 }
 
+/**
+ * swap_cache_add_large_folio - add a new large folio to the swap cache
+ * @folio: folio allocated and charged by the caller
+ * @entry: first swap entry of the range, aligned to the folio size
+ * @gfp_mask: allocation mask for the swap cache
+ *
+ * Claims all the swap entries of the range at once: this fails if any of
+ * them is already in the swap cache or being added to it, in which case the
+ * caller should fall back to order-0 swapin. On success, the folio is
+ * locked, in the swap cache and on the LRU, and the caller is to start the
+ * read into it.
+ */
+bool swap_cache_add_large_folio(struct folio *folio, swp_entry_t entry,
+				gfp_t gfp_mask)
+{
+	int nr = folio_nr_pages(folio);
+	void *shadow = NULL;
+
+	if (swapcache_prepare(entry, nr))
+		return false;
+
+	__folio_set_locked(folio);
+	__folio_set_swapbacked(folio);
+
+	/* May fail (-ENOMEM) if XArray node allocation failed. */
+	if (add_to_swap_cache(folio, entry, gfp_mask & GFP_RECLAIM_MASK, &shadow)) {
+		put_swap_folio(folio, entry);
+		__folio_clear_swapbacked(folio);
+		folio_unlock(folio);
+		return false;
+	}
+
+	mem_cgroup_swapin_uncharge_swap(entry, nr);
+
+	if (shadow)
+		workingset_refault(folio, shadow);
+
+	folio_add_lru(folio);
+	return true;
+}
+
 /*
  * Locate a page of swap in physical memory, reserving swap cache space
  * and reading the disk if it is not already cached.
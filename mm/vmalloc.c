@@ -860,8 +860,16 @@ struct rb_list {
  * A fast size storage contains VAs up to 1M size. A pool consists
  * of linked between each other ready to go VAs of certain sizes.
  * An index in the pool-array corresponds to number of pages + 1.
+ *
+ * Bigger VAs, up to 8M, are kept in a few power of two size classes
+ * above that, which have to be searched for an exact size.
  */
 #define MAX_VA_SIZE_PAGES 256
+#define NR_VA_LARGE_POOLS 3
+#define NR_VA_POOLS (MAX_VA_SIZE_PAGES + NR_VA_LARGE_POOLS)
+
+/* How many VAs of a size class are looked at for an exact match. */
+#define VA_LARGE_POOL_SCAN 8
 
 struct vmap_pool {
 	struct list_head head;
@@ -875,7 +883,7 @@ struct vmap_pool {
  */
 static struct vmap_node {
 	/* Simple size segregated storage. */
-	struct vmap_pool pool[MAX_VA_SIZE_PAGES];
+	struct vmap_pool pool[NR_VA_POOLS];
 	spinlock_t pool_lock;
 	bool skip_populate;
 
@@ -1845,6 +1853,30 @@ size_to_va_pool(struct vmap_node *vn, unsigned long size)
 	if (idx < MAX_VA_SIZE_PAGES)
 		return &vn->pool[idx];
 
+	idx = MAX_VA_SIZE_PAGES + ilog2(idx / MAX_VA_SIZE_PAGES);
+	if (idx < NR_VA_POOLS)
+		return &vn->pool[idx];
+
+	return NULL;
+}
+
+static struct vmap_area *
+large_pool_find_va(struct vmap_pool *vp, unsigned long size,
+		unsigned long align, unsigned long vstart,
+		unsigned long vend)
+{
+	struct vmap_area *va;
+	int scanned = 0;
+
+	list_for_each_entry(va, &vp->head, list) {
+		if (va_size(va) == size && IS_ALIGNED(va->va_start, align) &&
+				va->va_start >= vstart && va->va_end <= vend)
+			return va;
+
+		if (++scanned == VA_LARGE_POOL_SCAN)
+			break;
+	}
+
 	return NULL;
 }
 
@@ -1879,7 +1911,13 @@ node_pool_del_va(struct vmap_node *vn, unsigned long size,
 		return NULL;
 
 	spin_lock(&vn->pool_lock);
-	if (!list_empty(&vp->head)) {
+	if (vp >= &vn->pool[MAX_VA_SIZE_PAGES]) {
+		va = large_pool_find_va(vp, size, align, vstart, vend);
+		if (va) {
+			list_del_init(&va->list);
+			WRITE_ONCE(vp->len, vp->len - 1);
+		}
+	} else if (!list_empty(&vp->head)) {
 		va = list_first_entry(&vp->head, struct vmap_area, list);
 
 		if (IS_ALIGNED(va->va_start, align)) {
@@ -2137,7 +2175,7 @@ decay_va_pool_node(struct vmap_node *vn, bool full_decay)
 	unsigned long n_decay;
 	int i;
 
-	for (i = 0; i < MAX_VA_SIZE_PAGES; i++) {
+	for (i = 0; i < NR_VA_POOLS; i++) {
 		LIST_HEAD(tmp_list);
 
 		if (list_empty(&vn->pool[i].head))
@@ -2849,16 +2887,41 @@ static void vb_free(unsigned long addr, unsigned long size)
 		spin_unlock(&vb->lock);
 }
 
+/*
+ * Number of completed _vm_unmap_aliases() passes, protected by
+ * vmap_purge_lock.
+ */
+static unsigned long vmap_unmap_seq;
+
 static void _vm_unmap_aliases(unsigned long start, unsigned long end, int flush)
 {
 	LIST_HEAD(purge_list);
+	unsigned long seq;
 	int cpu;
 
 	if (unlikely(!vmap_initialized))
 		return;
 
+	/* Order the caller's unmaps before sampling the sequence. */
+	smp_mb();
+	seq = READ_ONCE(vmap_unmap_seq);
+
 	mutex_lock(&vmap_purge_lock);
 
+	/*
+	 * If a whole pass started and completed while waiting for the lock,
+	 * it has flushed every alias the caller may have left behind. Only
+	 * the caller's own range, if any, still needs a flush. This turns a
+	 * burst of concurrent callers, e.g. of vfree() on VM_FLUSH_RESET_PERMS
+	 * areas, into one purge.
+	 */
+	if (vmap_unmap_seq - seq >= 2) {
+		if (flush)
+			flush_tlb_kernel_range(start, end);
+		mutex_unlock(&vmap_purge_lock);
+		return;
+	}
+
 	for_each_possible_cpu(cpu) {
 		struct vmap_block_queue *vbq = &per_cpu(vmap_block_queue, cpu);
 		struct vmap_block *vb;
@@ -2898,6 +2961,7 @@ static void _vm_unmap_aliases(unsigned long start, unsigned long end, int flush)
 
 	if (!__purge_vmap_area_lazy(start, end, false) && flush)
 		flush_tlb_kernel_range(start, end);
+	WRITE_ONCE(vmap_unmap_seq, vmap_unmap_seq + 1);
 	mutex_unlock(&vmap_purge_lock);
 }
 
@@ -5133,7 +5197,7 @@ static void vmap_init_nodes(void)
 		INIT_LIST_HEAD(&vn->lazy.head);
 		spin_lock_init(&vn->lazy.lock);
 
-		for (i = 0; i < MAX_VA_SIZE_PAGES; i++) {
+		for (i = 0; i < NR_VA_POOLS; i++) {
 			INIT_LIST_HEAD(&vn->pool[i].head);
 			WRITE_ONCE(vn->pool[i].len, 0);
 		}
@@ -5152,7 +5216,7 @@ vmap_node_shrink_count(struct shrinker *shrink, struct shrink_control *sc)
 	for (count = 0, i = 0; i < nr_vmap_nodes; i++) {
 		vn = &vmap_nodes[i];
 
-		for (j = 0; j < MAX_VA_SIZE_PAGES; j++)
+		for (j = 0; j < NR_VA_POOLS; j++)
 			count += READ_ONCE(vn->pool[j].len);
 	}
 
@@ -424,21 +424,80 @@ static unsigned long drop_slab_node(int nid)
 	return freed;
 }
 
+struct drop_slab_work {
+	struct work_struct work;
+	int nid;
+	unsigned long freed;
+};
+
+static void drop_slab_workfn(struct work_struct *work)
+{
+	struct drop_slab_work *dw = container_of(work, struct drop_slab_work,
+						 work);
+
+	dw->freed = drop_slab_node(dw->nid);
+}
+
+/*
+ * Shrink the other nodes from workers running on them, so that their slab
+ * caches are walked in parallel and by CPUs local to the objects.  The
+ * caller takes the first online node itself.
+ */
+static unsigned long drop_slab_nodes(struct drop_slab_work *works)
+{
+	nodemask_t queued = NODE_MASK_NONE;
+	unsigned long freed = 0;
+	int nid, first = first_online_node;
+
+	for_each_online_node(nid) {
+		if (nid == first)
+			continue;
+		node_set(nid, queued);
+		works[nid].nid = nid;
+		works[nid].freed = 0;
+		INIT_WORK(&works[nid].work, drop_slab_workfn);
+		queue_work_node(nid, system_unbound_wq, &works[nid].work);
+	}
+
+	freed += drop_slab_node(first);
+
+	for_each_node_mask(nid, queued) {
+		flush_work(&works[nid].work);
+		freed += works[nid].freed;
+	}
+
+	return freed;
+}
+
 void drop_slab(void)
 {
+	struct drop_slab_work *works = NULL;
 	int nid;
 	int shift = 0;
 	unsigned long freed;
 
+	if (num_online_nodes() > 1)
+		works = kcalloc(nr_node_ids, sizeof(*works), GFP_KERNEL);
+
 	do {
+		if (fatal_signal_pending(current))
+			break;
+
+		if (works) {
+			freed = drop_slab_nodes(works);
+			continue;
+		}
+
 		freed = 0;
 		for_each_online_node(nid) {
 			if (fatal_signal_pending(current))
-				return;
+				goto out;
 
 			freed += drop_slab_node(nid);
 		}
 	} while ((freed >> shift++) > 1);
+out:
+	kfree(works);
 }
 
 static int reclaimer_offset(void)
@@ -4006,8 +4065,11 @@ static bool try_to_inc_max_seq(struct lruvec *lruvec, unsigned long seq,
 
 	do {
 		success = iterate_mm_list(walk, &mm);
-		if (mm)
+		if (mm) {
 			walk_mm(mm, walk);
+			/* the stats are only reset by the next iterate_mm_list() */
+			khugepaged_mm_hot(mm, walk->mm_stats[MM_LEAF_YOUNG]);
+		}
 	} while (mm);
 done:
 	if (success) {
@@ -4745,11 +4807,70 @@ static bool should_run_aging(struct lruvec *lruvec, unsigned long max_seq,
 	return evictable_min_seq(min_seq, swappiness) + MIN_NR_GENS == max_seq;
 }
 
+static struct workqueue_struct *lru_gen_aging_wq __read_mostly;
+static bool lru_gen_async_aging __read_mostly;
+
 /*
- * For future optimizations:
- * 1. Defer try_to_inc_max_seq() to workqueues to reduce latency for memcg
- *    reclaim.
+ * Ask the background aging of the node to age this lruvec, so that direct
+ * reclaimers don't have to walk page tables themselves. kswapd keeps aging
+ * synchronously, it is a background worker already.
  */
+static bool lru_gen_queue_aging(struct lruvec *lruvec)
+{
+	struct pglist_data *pgdat = lruvec_pgdat(lruvec);
+
+	if (!READ_ONCE(lru_gen_async_aging) || current_is_kswapd())
+		return false;
+
+	if (!READ_ONCE(lruvec->lrugen.aging_pending))
+		WRITE_ONCE(lruvec->lrugen.aging_pending, true);
+
+	queue_work_node(pgdat->node_id, lru_gen_aging_wq, &pgdat->lru_gen_aging);
+
+	return true;
+}
+
+static void lru_gen_aging_work(struct work_struct *work)
+{
+	unsigned int flags;
+	struct mem_cgroup *memcg;
+	struct pglist_data *pgdat = container_of(work, struct pglist_data,
+						 lru_gen_aging);
+	struct scan_control sc = {
+		.may_writepage = true,
+		.may_unmap = true,
+		.may_swap = true,
+		.reclaim_idx = MAX_NR_ZONES - 1,
+		.gfp_mask = GFP_KERNEL,
+	};
+
+	set_task_reclaim_state(current, &sc.reclaim_state);
+	flags = memalloc_noreclaim_save();
+
+	memcg = mem_cgroup_iter(NULL, NULL, NULL);
+	do {
+		struct lruvec *lruvec = mem_cgroup_lruvec(memcg, pgdat);
+		unsigned long nr_to_scan;
+		int swappiness;
+		DEFINE_MAX_SEQ(lruvec);
+
+		if (!READ_ONCE(lruvec->lrugen.aging_pending))
+			continue;
+
+		WRITE_ONCE(lruvec->lrugen.aging_pending, false);
+
+		swappiness = get_swappiness(lruvec, &sc);
+		if (should_run_aging(lruvec, max_seq, swappiness, &nr_to_scan))
+			try_to_inc_max_seq(lruvec, max_seq, swappiness, false);
+
+		cond_resched();
+	} while ((memcg = mem_cgroup_iter(NULL, memcg, NULL)));
+
+	clear_mm_walk();
+	memalloc_noreclaim_restore(flags);
+	set_task_reclaim_state(current, NULL);
+}
+
 static long get_nr_to_scan(struct lruvec *lruvec, struct scan_control *sc, int swappiness)
 {
 	bool success;
@@ -4766,6 +4887,10 @@ static long get_nr_to_scan(struct lruvec *lruvec, struct scan_control *sc, int s
 	if (nr_to_scan && !mem_cgroup_online(memcg))
 		return nr_to_scan;
 
+	/* leave the aging to the background while eviction is still possible */
+	if (success && lru_gen_queue_aging(lruvec) && nr_to_scan)
+		return nr_to_scan >> sc->priority;
+
 	/* try to get away with not aging at the default priority */
 	if (!success || sc->priority == DEF_PRIORITY)
 		return nr_to_scan >> sc->priority;
@@ -5180,6 +5305,29 @@ static ssize_t min_ttl_ms_store(struct kobject *kobj, struct kobj_attribute *att
 
 static struct kobj_attribute lru_gen_min_ttl_attr = __ATTR_RW(min_ttl_ms);
 
+static ssize_t async_aging_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf)
+{
+	return sysfs_emit(buf, "%d\n", READ_ONCE(lru_gen_async_aging));
+}
+
+static ssize_t async_aging_store(struct kobject *kobj, struct kobj_attribute *attr,
+				 const char *buf, size_t len)
+{
+	bool enabled;
+
+	if (kstrtobool(buf, &enabled))
+		return -EINVAL;
+
+	if (!lru_gen_aging_wq)
+		return -ENOMEM;
+
+	WRITE_ONCE(lru_gen_async_aging, enabled);
+
+	return len;
+}
+
+static struct kobj_attribute lru_gen_async_aging_attr = __ATTR_RW(async_aging);
+
 static ssize_t enabled_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf)
 {
 	unsigned int caps = 0;
@@ -5228,6 +5376,7 @@ static struct kobj_attribute lru_gen_enabled_attr = __ATTR_RW(enabled);
 
 static struct attribute *lru_gen_attrs[] = {
 	&lru_gen_min_ttl_attr.attr,
+	&lru_gen_async_aging_attr.attr,
 	&lru_gen_enabled_attr.attr,
 	NULL
 };
@@ -5602,6 +5751,8 @@ void lru_gen_init_pgdat(struct pglist_data *pgdat)
 		for (j = 0; j < MEMCG_NR_BINS; j++)
 			INIT_HLIST_NULLS_HEAD(&pgdat->memcg_lru.fifo[i][j], i);
 	}
+
+	INIT_WORK(&pgdat->lru_gen_aging, lru_gen_aging_work);
 }
 
 void lru_gen_init_lruvec(struct lruvec *lruvec)
@@ -5671,6 +5822,10 @@ static int __init init_lru_gen(void)
 	BUILD_BUG_ON(MIN_NR_GENS + 1 >= MAX_NR_GENS);
 	BUILD_BUG_ON(BIT(LRU_GEN_WIDTH) <= MAX_NR_GENS);
 
+	lru_gen_aging_wq = alloc_workqueue("lru_gen_aging", WQ_UNBOUND | WQ_MEM_RECLAIM, 0);
+	if (!lru_gen_aging_wq)
+		pr_err("lru_gen: failed to create aging workqueue\n");
+
 	if (sysfs_create_group(mm_kobj, &lru_gen_attr_group))
 		pr_err("lru_gen: failed to create sysfs group\n");
 
@@ -1304,6 +1304,8 @@ const char * const vmstat_text[] = {
 
 	"pgrefill",
 	"pgreuse",
+	"dirty_throttle",
+	"dirty_throttle_ms",
 	"pgsteal_kswapd",
 	"pgsteal_direct",
 	"pgsteal_khugepaged",
@@ -1357,6 +1359,8 @@ const char * const vmstat_text[] = {
 	"compact_daemon_wake",
 	"compact_daemon_migrate_scanned",
 	"compact_daemon_free_scanned",
+	"compact_daemon_proactive",
+	"compact_daemon_proactive_ms",
 #endif
 
 #ifdef CONFIG_HUGETLB_PAGE
@@ -1432,6 +1436,10 @@ const char * const vmstat_text[] = {
 	"zswpout",
 	"zswpwb",
 #endif
+#ifdef CONFIG_MEMCG
+	"memcg_stock_hit",
+	"memcg_stock_miss",
+#endif
 #ifdef CONFIG_X86
 	"direct_map_level2_splits",
 	"direct_map_level3_splits",
@@ -1814,6 +1822,23 @@ static void zoneinfo_show_print(struct seq_file *m, pg_data_t *pgdat,
 				pzstats->stat_threshold);
 #endif
 	}
+	for (i = 0; i < zone->nr_shards; i++) {
+		struct zone_shard *shard = &zone->shards[i];
+		unsigned int first = i * zone_shard_cpus;
+		int order;
+
+		seq_printf(m,
+			   "\n  shard: %i cpus: %u-%u"
+			   "\n              count:    %i"
+			   "\n              high:     %i"
+			   "\n              free:    ",
+			   i, first,
+			   min(first + zone_shard_cpus, nr_cpu_ids) - 1,
+			   data_race(shard->count),
+			   READ_ONCE(shard->high));
+		for (order = 0; order < NR_PAGE_ORDERS; ++order)
+			seq_printf(m, " %u", data_race(shard->nr_free[order]));
+	}
 	seq_printf(m,
 		   "\n  node_unreclaimable:  %u"
 		   "\n  start_pfn:           %lu",
@@ -403,20 +403,9 @@ void *workingset_eviction(struct folio *folio, struct mem_cgroup *target_memcg)
 				folio_test_workingset(folio));
 }
 
-/**
- * workingset_test_recent - tests if the shadow entry is for a folio that was
- * recently evicted. Also fills in @workingset with the value unpacked from
- * shadow.
- * @shadow: the shadow entry to be tested.
- * @file: whether the corresponding folio is from the file lru.
- * @workingset: where the workingset value unpacked from shadow should
- * be stored.
- * @flush: whether to flush cgroup rstat.
- *
- * Return: true if the shadow is for a recently evicted folio; false otherwise.
- */
-bool workingset_test_recent(void *shadow, bool file, bool *workingset,
-				bool flush)
+/* @refault: account the distance of an actual refault to the memcg */
+static bool __workingset_test_recent(void *shadow, bool file,
+				    bool *workingset, bool flush, bool refault)
 {
 	struct mem_cgroup *eviction_memcg;
 	struct lruvec *eviction_lruvec;
@@ -518,10 +507,31 @@ bool workingset_test_recent(void *shadow, bool file, bool *workingset,
 		}
 	}
 
+	if (refault)
+		mem_cgroup_record_refault(eviction_memcg, refault_distance);
+
 	mem_cgroup_put(eviction_memcg);
 	return refault_distance <= workingset_size;
 }
 
+/**
+ * workingset_test_recent - tests if the shadow entry is for a folio that was
+ * recently evicted. Also fills in @workingset with the value unpacked from
+ * shadow.
+ * @shadow: the shadow entry to be tested.
+ * @file: whether the corresponding folio is from the file lru.
+ * @workingset: where the workingset value unpacked from shadow should
+ * be stored.
+ * @flush: whether to flush cgroup rstat.
+ *
+ * Return: true if the shadow is for a recently evicted folio; false otherwise.
+ */
+bool workingset_test_recent(void *shadow, bool file, bool *workingset,
+				bool flush)
+{
+	return __workingset_test_recent(shadow, file, workingset, flush, false);
+}
+
 /**
  * workingset_refault - Evaluate the refault of a previously evicted folio.
  * @folio: The freshly allocated replacement folio.
@@ -563,7 +573,7 @@ void workingset_refault(struct folio *folio, void *shadow)
 
 	mod_lruvec_state(lruvec, WORKINGSET_REFAULT_BASE + file, nr);
 
-	if (!workingset_test_recent(shadow, file, &workingset, true))
+	if (!__workingset_test_recent(shadow, file, &workingset, true, true))
 		return;
 
 	folio_set_active(folio);
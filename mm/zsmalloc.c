@@ -181,6 +181,12 @@ struct size_class {
 
 	unsigned int index;
 	struct zs_size_stat stats;
+	/*
+	 * Set while __zs_compact() moves objects out of this class without
+	 * pool->migrate_lock: zspages emptied meanwhile may still be looked
+	 * up through stale handles, so their freeing is deferred.
+	 */
+	bool compacting;
 };
 
 /*
@@ -365,7 +371,7 @@ static void cache_free_zspage(struct zs_pool *pool, struct zspage *zspage)
 /* class->lock(which owns the handle) synchronizes races */
 static void record_obj(unsigned long handle, unsigned long obj)
 {
-	*(unsigned long *)handle = obj;
+	WRITE_ONCE(*(unsigned long *)handle, obj);
 }
 
 /* zpool driver */
@@ -797,7 +803,7 @@ static unsigned long location_to_obj(struct zpdesc *zpdesc, unsigned int obj_idx
 
 static unsigned long handle_to_obj(unsigned long handle)
 {
-	return *(unsigned long *)handle;
+	return READ_ONCE(*(unsigned long *)handle);
 }
 
 static inline bool obj_allocated(struct zpdesc *zpdesc, void *obj,
@@ -1207,6 +1213,7 @@ void *zs_map_object(struct zs_pool *pool, unsigned long handle,
 
 	/* It guarantees it can get zspage from handle safely */
 	read_lock(&pool->migrate_lock);
+again:
 	obj = handle_to_obj(handle);
 	obj_to_location(obj, &zpdesc, &obj_idx);
 	zspage = get_zspage(zpdesc);
@@ -1216,8 +1223,15 @@ void *zs_map_object(struct zs_pool *pool, unsigned long handle,
 	 * is too heavy since callers would take some time until they calls
 	 * zs_unmap_object API so delegate the locking from class to zspage
 	 * which is smaller granularity.
+	 *
+	 * Compaction moves objects under class->lock only, so the object may
+	 * have left the zspage before we got its lock: look it up again.
 	 */
 	migrate_read_lock(zspage);
+	if (unlikely(handle_to_obj(handle) != obj)) {
+		migrate_read_unlock(zspage);
+		goto again;
+	}
 	read_unlock(&pool->migrate_lock);
 
 	class = zspage_class(pool, zspage);
@@ -1461,12 +1475,24 @@ void zs_free(struct zs_pool *pool, unsigned long handle)
 	spin_lock(&class->lock);
 	read_unlock(&pool->migrate_lock);
 
+	/*
+	 * Compaction may have moved the object before we got class->lock,
+	 * but it can't anymore.
+	 */
+	obj = handle_to_obj(handle);
+	obj_to_zpdesc(obj, &f_zpdesc);
+	zspage = get_zspage(f_zpdesc);
+
 	class_stat_sub(class, ZS_OBJS_INUSE, 1);
 	obj_free(class->size, obj);
 
 	fullness = fix_fullness_group(class, zspage);
-	if (fullness == ZS_INUSE_RATIO_0)
-		free_zspage(pool, class, zspage);
+	if (fullness == ZS_INUSE_RATIO_0) {
+		if (class->compacting)
+			kick_deferred_free(pool);
+		else
+			free_zspage(pool, class, zspage);
+	}
 
 	spin_unlock(&class->lock);
 	cache_free_handle(pool, handle);
@@ -1884,6 +1910,14 @@ static void async_free_zspage(struct work_struct *work)
 		spin_unlock(&class->lock);
 	}
 
+	/*
+	 * Objects may have been moved out of these zspages by compaction
+	 * while lookups of their handles were in flight. Wait for those to
+	 * finish before freeing anything.
+	 */
+	write_lock(&pool->migrate_lock);
+	write_unlock(&pool->migrate_lock);
+
 	list_for_each_entry_safe(zspage, tmp, &free_pages, list) {
 		list_del(&zspage->list);
 		lock_zspage(zspage);
@@ -1950,14 +1984,19 @@ static unsigned long __zs_compact(struct zs_pool *pool,
 {
 	struct zspage *src_zspage = NULL;
 	struct zspage *dst_zspage = NULL;
+	struct zspage *zspage, *tmp;
 	unsigned long pages_freed = 0;
 
 	/*
-	 * protect the race between zpage migration and zs_free
-	 * as well as zpage allocation/free
+	 * Objects are moved under class->lock alone, so that compaction
+	 * doesn't stall zs_map_object() and zs_free() on other classes.
+	 * Those revalidate the handle once they hold class->lock or the
+	 * zspage lock; what remains is that they may still be dereferencing
+	 * a zspage we emptied, so empty zspages are only freed after a pass
+	 * through pool->migrate_lock.
 	 */
-	write_lock(&pool->migrate_lock);
 	spin_lock(&class->lock);
+	class->compacting = true;
 	while (zs_can_compact(class)) {
 		int fg;
 
@@ -1976,21 +2015,17 @@ static unsigned long __zs_compact(struct zs_pool *pool,
 		migrate_write_unlock(src_zspage);
 
 		fg = putback_zspage(class, src_zspage);
-		if (fg == ZS_INUSE_RATIO_0) {
-			free_zspage(pool, class, src_zspage);
+		if (fg == ZS_INUSE_RATIO_0)
 			pages_freed += class->pages_per_zspage;
-		}
 		src_zspage = NULL;
 
 		if (get_fullness_group(class, dst_zspage) == ZS_INUSE_RATIO_100
-		    || rwlock_is_contended(&pool->migrate_lock)) {
+		    || spin_is_contended(&class->lock)) {
 			putback_zspage(class, dst_zspage);
 			dst_zspage = NULL;
 
 			spin_unlock(&class->lock);
-			write_unlock(&pool->migrate_lock);
 			cond_resched();
-			write_lock(&pool->migrate_lock);
 			spin_lock(&class->lock);
 		}
 	}
@@ -2002,6 +2037,15 @@ static unsigned long __zs_compact(struct zs_pool *pool,
 		putback_zspage(class, dst_zspage);
 
 	spin_unlock(&class->lock);
+
+	/* No lookup can see a stale object location past this point */
+	write_lock(&pool->migrate_lock);
+	spin_lock(&class->lock);
+	class->compacting = false;
+	list_for_each_entry_safe(zspage, tmp,
+				 &class->fullness_list[ZS_INUSE_RATIO_0], list)
+		free_zspage(pool, class, zspage);
+	spin_unlock(&class->lock);
 	write_unlock(&pool->migrate_lock);
 
 	return pages_freed;
@@ -2014,10 +2058,10 @@ unsigned long zs_compact(struct zs_pool *pool)
 	unsigned long pages_freed = 0;
 
 	/*
-	 * Pool compaction is performed under pool->migrate_lock so it is basically
-	 * single-threaded. Having more than one thread in __zs_compact()
-	 * will increase pool->migrate_lock contention, which will impact other
-	 * zsmalloc operations that need pool->migrate_lock.
+	 * Pool compaction is basically single-threaded. Having more than one
+	 * thread in __zs_compact() would only add class->lock contention and
+	 * more passes through pool->migrate_lock, which other zsmalloc
+	 * operations need.
 	 */
 	if (atomic_xchg(&pool->compaction_in_progress, 1))
 		return 0;
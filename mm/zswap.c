@@ -141,11 +141,16 @@ bool zswap_never_enabled(void)
 * data structures
 **********************************/
 
+/* Max number of pages of a large folio compressed at once */
+#define ZSWAP_MAX_BATCH_SIZE 8U
+
 struct crypto_acomp_ctx {
 	struct crypto_acomp *acomp;
-	struct acomp_req *req;
-	struct crypto_wait wait;
-	u8 *buffer;
+	/* one request per batch slot for async compressors, else just one */
+	struct acomp_req *reqs[ZSWAP_MAX_BATCH_SIZE];
+	struct crypto_wait waits[ZSWAP_MAX_BATCH_SIZE];
+	u8 *buffers[ZSWAP_MAX_BATCH_SIZE];
+	unsigned int nr_reqs;
 	struct mutex mutex;
 	bool is_sleepable;
 };
@@ -820,31 +825,39 @@ static int zswap_cpu_comp_prepare(unsigned int cpu, struct hlist_node *node)
 {
 	struct zswap_pool *pool = hlist_entry(node, struct zswap_pool, node);
 	struct crypto_acomp_ctx *acomp_ctx = per_cpu_ptr(pool->acomp_ctx, cpu);
-	struct crypto_acomp *acomp = NULL;
-	struct acomp_req *req = NULL;
-	u8 *buffer = NULL;
+	struct acomp_req *reqs[ZSWAP_MAX_BATCH_SIZE] = { };
+	u8 *buffers[ZSWAP_MAX_BATCH_SIZE] = { };
+	struct crypto_acomp *acomp;
+	unsigned int nr_reqs, i;
 	int ret;
 
-	buffer = kmalloc_node(PAGE_SIZE * 2, GFP_KERNEL, cpu_to_node(cpu));
-	if (!buffer) {
-		ret = -ENOMEM;
-		goto fail;
-	}
-
 	acomp = crypto_alloc_acomp_node(pool->tfm_name, 0, 0, cpu_to_node(cpu));
 	if (IS_ERR(acomp)) {
 		pr_err("could not alloc crypto acomp %s : %ld\n",
 				pool->tfm_name, PTR_ERR(acomp));
-		ret = PTR_ERR(acomp);
-		goto fail;
+		return PTR_ERR(acomp);
 	}
 
-	req = acomp_request_alloc(acomp);
-	if (!req) {
-		pr_err("could not alloc crypto acomp_request %s\n",
-		       pool->tfm_name);
-		ret = -ENOMEM;
-		goto fail;
+	/*
+	 * An async compressor can work on several pages at once, give it a
+	 * request and a buffer for each page of a batch.
+	 */
+	nr_reqs = acomp_is_async(acomp) ? ZSWAP_MAX_BATCH_SIZE : 1;
+	for (i = 0; i < nr_reqs; i++) {
+		buffers[i] = kmalloc_node(PAGE_SIZE * 2, GFP_KERNEL,
+					  cpu_to_node(cpu));
+		if (!buffers[i]) {
+			ret = -ENOMEM;
+			goto fail;
+		}
+
+		reqs[i] = acomp_request_alloc(acomp);
+		if (!reqs[i]) {
+			pr_err("could not alloc crypto acomp_request %s\n",
+			       pool->tfm_name);
+			ret = -ENOMEM;
+			goto fail;
+		}
 	}
 
 	/*
@@ -853,27 +866,34 @@ static int zswap_cpu_comp_prepare(unsigned int cpu, struct hlist_node *node)
 	 * again resulting in a deadlock.
 	 */
 	mutex_lock(&acomp_ctx->mutex);
-	crypto_init_wait(&acomp_ctx->wait);
+	for (i = 0; i < nr_reqs; i++) {
+		crypto_init_wait(&acomp_ctx->waits[i]);
 
-	/*
-	 * if the backend of acomp is async zip, crypto_req_done() will wakeup
-	 * crypto_wait_req(); if the backend of acomp is scomp, the callback
-	 * won't be called, crypto_wait_req() will return without blocking.
-	 */
-	acomp_request_set_callback(req, CRYPTO_TFM_REQ_MAY_BACKLOG,
-				   crypto_req_done, &acomp_ctx->wait);
+		/*
+		 * if the backend of acomp is async zip, crypto_req_done() will
+		 * wakeup crypto_wait_req(); if the backend of acomp is scomp,
+		 * the callback won't be called, crypto_wait_req() will return
+		 * without blocking.
+		 */
+		acomp_request_set_callback(reqs[i], CRYPTO_TFM_REQ_MAY_BACKLOG,
+					   crypto_req_done, &acomp_ctx->waits[i]);
 
-	acomp_ctx->buffer = buffer;
+		acomp_ctx->buffers[i] = buffers[i];
+		acomp_ctx->reqs[i] = reqs[i];
+	}
+	acomp_ctx->nr_reqs = nr_reqs;
 	acomp_ctx->acomp = acomp;
 	acomp_ctx->is_sleepable = acomp_is_async(acomp);
-	acomp_ctx->req = req;
 	mutex_unlock(&acomp_ctx->mutex);
 	return 0;
 
 fail:
-	if (acomp)
-		crypto_free_acomp(acomp);
-	kfree(buffer);
+	for (i = 0; i < nr_reqs; i++) {
+		if (reqs[i])
+			acomp_request_free(reqs[i]);
+		kfree(buffers[i]);
+	}
+	crypto_free_acomp(acomp);
 	return ret;
 }
 
@@ -881,15 +901,19 @@ static int zswap_cpu_comp_dead(unsigned int cpu, struct hlist_node *node)
 {
 	struct zswap_pool *pool = hlist_entry(node, struct zswap_pool, node);
 	struct crypto_acomp_ctx *acomp_ctx = per_cpu_ptr(pool->acomp_ctx, cpu);
+	unsigned int i;
 
 	mutex_lock(&acomp_ctx->mutex);
 	if (!IS_ERR_OR_NULL(acomp_ctx)) {
-		if (!IS_ERR_OR_NULL(acomp_ctx->req))
-			acomp_request_free(acomp_ctx->req);
-		acomp_ctx->req = NULL;
+		for (i = 0; i < acomp_ctx->nr_reqs; i++) {
+			if (!IS_ERR_OR_NULL(acomp_ctx->reqs[i]))
+				acomp_request_free(acomp_ctx->reqs[i]);
+			acomp_ctx->reqs[i] = NULL;
+			kfree(acomp_ctx->buffers[i]);
+			acomp_ctx->buffers[i] = NULL;
+		}
 		if (!IS_ERR_OR_NULL(acomp_ctx->acomp))
 			crypto_free_acomp(acomp_ctx->acomp);
-		kfree(acomp_ctx->buffer);
 	}
 	mutex_unlock(&acomp_ctx->mutex);
 
@@ -903,13 +927,13 @@ static struct crypto_acomp_ctx *acomp_ctx_get_cpu_lock(struct zswap_pool *pool)
 	for (;;) {
 		acomp_ctx = raw_cpu_ptr(pool->acomp_ctx);
 		mutex_lock(&acomp_ctx->mutex);
-		if (likely(acomp_ctx->req))
+		if (likely(acomp_ctx->reqs[0]))
 			return acomp_ctx;
 		/*
 		 * It is possible that we were migrated to a different CPU after
 		 * getting the per-CPU ctx but before the mutex was acquired. If
 		 * the old CPU got offlined, zswap_cpu_comp_dead() could have
-		 * already freed ctx->req (among other things) and set it to
+		 * already freed ctx->reqs (among other things) and set them to
 		 * NULL. Just try again on the new CPU that we ended up on.
 		 */
 		mutex_unlock(&acomp_ctx->mutex);
@@ -921,74 +945,95 @@ static void acomp_ctx_put_unlock(struct crypto_acomp_ctx *acomp_ctx)
 	mutex_unlock(&acomp_ctx->mutex);
 }
 
-static bool zswap_compress(struct page *page, struct zswap_entry *entry,
-			   struct zswap_pool *pool)
+/*
+ * Compress @nr pages, at most ZSWAP_MAX_BATCH_SIZE, and copy the results to
+ * the zpool, filling in the handle and length of the matching @entries.
+ *
+ * With an async compressor, all the requests of the batch are submitted
+ * before waiting for the first one, so that the hardware can work on them in
+ * parallel. A synchronous compressor has a single request and goes through
+ * the pages one by one.
+ *
+ * Returns the number of leading entries that were filled in, the remaining
+ * ones have no zpool allocation.
+ */
+static unsigned int zswap_compress(struct page **pages,
+				   struct zswap_entry **entries,
+				   unsigned int nr, struct zswap_pool *pool)
 {
+	struct scatterlist inputs[ZSWAP_MAX_BATCH_SIZE];
+	struct scatterlist outputs[ZSWAP_MAX_BATCH_SIZE];
+	int comp_rets[ZSWAP_MAX_BATCH_SIZE];
 	struct crypto_acomp_ctx *acomp_ctx;
-	struct scatterlist input, output;
-	int comp_ret = 0, alloc_ret = 0;
-	unsigned int dlen = PAGE_SIZE;
+	struct zpool *zpool = pool->zpool;
+	unsigned int start, end, i, j;
+	unsigned int stored = 0;
+	int comp_ret, alloc_ret;
+	unsigned int dlen;
 	unsigned long handle;
-	struct zpool *zpool;
 	char *buf;
 	gfp_t gfp;
-	u8 *dst;
-
-	acomp_ctx = acomp_ctx_get_cpu_lock(pool);
-	dst = acomp_ctx->buffer;
-	sg_init_table(&input, 1);
-	sg_set_page(&input, page, PAGE_SIZE, 0);
 
-	/*
-	 * We need PAGE_SIZE * 2 here since there maybe over-compression case,
-	 * and hardware-accelerators may won't check the dst buffer size, so
-	 * giving the dst buffer with enough length to avoid buffer overflow.
-	 */
-	sg_init_one(&output, dst, PAGE_SIZE * 2);
-	acomp_request_set_params(acomp_ctx->req, &input, &output, PAGE_SIZE, dlen);
-
-	/*
-	 * it maybe looks a little bit silly that we send an asynchronous request,
-	 * then wait for its completion synchronously. This makes the process look
-	 * synchronous in fact.
-	 * Theoretically, acomp supports users send multiple acomp requests in one
-	 * acomp instance, then get those requests done simultaneously. but in this
-	 * case, zswap actually does store and load page by page, there is no
-	 * existing method to send the second page before the first page is done
-	 * in one thread doing zwap.
-	 * but in different threads running on different cpu, we have different
-	 * acomp instance, so multiple threads can do (de)compression in parallel.
-	 */
-	comp_ret = crypto_wait_req(crypto_acomp_compress(acomp_ctx->req), &acomp_ctx->wait);
-	dlen = acomp_ctx->req->dlen;
-	if (comp_ret)
-		goto unlock;
-
-	zpool = pool->zpool;
 	gfp = __GFP_NORETRY | __GFP_NOWARN | __GFP_KSWAPD_RECLAIM;
 	if (zpool_malloc_support_movable(zpool))
 		gfp |= __GFP_HIGHMEM | __GFP_MOVABLE;
-	alloc_ret = zpool_malloc(zpool, dlen, gfp, &handle);
-	if (alloc_ret)
-		goto unlock;
 
-	buf = zpool_map_handle(zpool, handle, ZPOOL_MM_WO);
-	memcpy(buf, dst, dlen);
-	zpool_unmap_handle(zpool, handle);
+	acomp_ctx = acomp_ctx_get_cpu_lock(pool);
+	for (start = 0; start < nr; start = end) {
+		end = min(nr, start + acomp_ctx->nr_reqs);
 
-	entry->handle = handle;
-	entry->length = dlen;
+		for (i = start, j = 0; i < end; i++, j++) {
+			sg_init_table(&inputs[j], 1);
+			sg_set_page(&inputs[j], pages[i], PAGE_SIZE, 0);
 
-unlock:
-	if (comp_ret == -ENOSPC || alloc_ret == -ENOSPC)
-		zswap_reject_compress_poor++;
-	else if (comp_ret)
-		zswap_reject_compress_fail++;
-	else if (alloc_ret)
-		zswap_reject_alloc_fail++;
+			/*
+			 * We need PAGE_SIZE * 2 here since there maybe
+			 * over-compression case, and hardware-accelerators may
+			 * won't check the dst buffer size, so giving the dst
+			 * buffer with enough length to avoid buffer overflow.
+			 */
+			sg_init_one(&outputs[j], acomp_ctx->buffers[j],
+				    PAGE_SIZE * 2);
+			acomp_request_set_params(acomp_ctx->reqs[j], &inputs[j],
+						 &outputs[j], PAGE_SIZE, PAGE_SIZE);
+			comp_rets[j] = crypto_acomp_compress(acomp_ctx->reqs[j]);
+		}
+
+		/* All submitted requests have to complete before bailing out */
+		for (j = 0; j < end - start; j++)
+			comp_rets[j] = crypto_wait_req(comp_rets[j],
+						       &acomp_ctx->waits[j]);
+
+		for (i = start, j = 0; i < end; i++, j++) {
+			comp_ret = comp_rets[j];
+			alloc_ret = 0;
+			dlen = acomp_ctx->reqs[j]->dlen;
+			if (!comp_ret)
+				alloc_ret = zpool_malloc(zpool, dlen, gfp, &handle);
+
+			if (comp_ret || alloc_ret) {
+				if (comp_ret == -ENOSPC || alloc_ret == -ENOSPC)
+					zswap_reject_compress_poor++;
+				else if (comp_ret)
+					zswap_reject_compress_fail++;
+				else
+					zswap_reject_alloc_fail++;
+				goto unlock;
+			}
+
+			buf = zpool_map_handle(zpool, handle, ZPOOL_MM_WO);
+			memcpy(buf, acomp_ctx->buffers[j], dlen);
+			zpool_unmap_handle(zpool, handle);
+
+			entries[i]->handle = handle;
+			entries[i]->length = dlen;
+			stored++;
+		}
+	}
 
+unlock:
 	acomp_ctx_put_unlock(acomp_ctx);
-	return comp_ret == 0 && alloc_ret == 0;
+	return stored;
 }
 
 static void zswap_decompress(struct zswap_entry *entry, struct folio *folio)
@@ -1011,19 +1056,19 @@ static void zswap_decompress(struct zswap_entry *entry, struct folio *folio)
 	 */
 	if ((acomp_ctx->is_sleepable && !zpool_can_sleep_mapped(zpool)) ||
 	    !virt_addr_valid(src)) {
-		memcpy(acomp_ctx->buffer, src, entry->length);
-		src = acomp_ctx->buffer;
+		memcpy(acomp_ctx->buffers[0], src, entry->length);
+		src = acomp_ctx->buffers[0];
 		zpool_unmap_handle(zpool, entry->handle);
 	}
 
 	sg_init_one(&input, src, entry->length);
 	sg_init_table(&output, 1);
 	sg_set_folio(&output, folio, PAGE_SIZE, 0);
-	acomp_request_set_params(acomp_ctx->req, &input, &output, entry->length, PAGE_SIZE);
-	BUG_ON(crypto_wait_req(crypto_acomp_decompress(acomp_ctx->req), &acomp_ctx->wait));
-	BUG_ON(acomp_ctx->req->dlen != PAGE_SIZE);
+	acomp_request_set_params(acomp_ctx->reqs[0], &input, &output, entry->length, PAGE_SIZE);
+	BUG_ON(crypto_wait_req(crypto_acomp_decompress(acomp_ctx->reqs[0]), &acomp_ctx->waits[0]));
+	BUG_ON(acomp_ctx->reqs[0]->dlen != PAGE_SIZE);
 
-	if (src != acomp_ctx->buffer)
+	if (src != acomp_ctx->buffers[0])
 		zpool_unmap_handle(zpool, entry->handle);
 	acomp_ctx_put_unlock(acomp_ctx);
 }
@@ -1445,81 +1490,125 @@ static void shrink_worker(struct work_struct *w)
 * main API
 **********************************/
 
-static bool zswap_store_page(struct page *page,
-			     struct obj_cgroup *objcg,
-			     struct zswap_pool *pool)
+/*
+ * Allocate @nr entries for pages on node @nid, in bulk when the node is the
+ * local one.
+ */
+static bool zswap_entries_alloc(struct zswap_entry **entries, unsigned int nr,
+				int nid)
+{
+	unsigned int i;
+
+	if (nid == numa_node_id())
+		return kmem_cache_alloc_bulk(zswap_entry_cache, GFP_KERNEL, nr,
+					     (void **)entries) == nr;
+
+	for (i = 0; i < nr; i++) {
+		entries[i] = zswap_entry_cache_alloc(GFP_KERNEL, nid);
+		if (!entries[i]) {
+			kmem_cache_free_bulk(zswap_entry_cache, i,
+					     (void **)entries);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool zswap_store_pages(struct folio *folio, long start,
+			      unsigned int nr, struct obj_cgroup *objcg,
+			      struct zswap_pool *pool)
 {
-	swp_entry_t page_swpentry = page_swap_entry(page);
-	struct zswap_entry *entry, *old;
+	struct zswap_entry *entries[ZSWAP_MAX_BATCH_SIZE];
+	struct page *pages[ZSWAP_MAX_BATCH_SIZE];
+	unsigned int i, compressed;
 
-	/* allocate entry */
-	entry = zswap_entry_cache_alloc(GFP_KERNEL, page_to_nid(page));
-	if (!entry) {
+	for (i = 0; i < nr; i++)
+		pages[i] = folio_page(folio, start + i);
+
+	/* allocate entries */
+	if (!zswap_entries_alloc(entries, nr, folio_nid(folio))) {
 		zswap_reject_kmemcache_fail++;
 		return false;
 	}
 
-	if (!zswap_compress(page, entry, pool))
-		goto compress_failed;
-
-	old = xa_store(swap_zswap_tree(page_swpentry),
-		       swp_offset(page_swpentry),
-		       entry, GFP_KERNEL);
-	if (xa_is_err(old)) {
-		int err = xa_err(old);
-
-		WARN_ONCE(err != -ENOMEM, "unexpected xarray error: %d\n", err);
-		zswap_reject_alloc_fail++;
+	compressed = zswap_compress(pages, entries, nr, pool);
+	if (compressed < nr) {
+		i = 0;
 		goto store_failed;
 	}
 
-	/*
-	 * We may have had an existing entry that became stale when
-	 * the folio was redirtied and now the new version is being
-	 * swapped out. Get rid of the old.
-	 */
-	if (old)
-		zswap_entry_free(old);
+	for (i = 0; i < nr; i++) {
+		swp_entry_t page_swpentry = page_swap_entry(pages[i]);
+		struct zswap_entry *entry = entries[i], *old;
 
-	/*
-	 * The entry is successfully compressed and stored in the tree, there is
-	 * no further possibility of failure. Grab refs to the pool and objcg,
-	 * charge zswap memory, and increment zswap_stored_pages.
-	 * The opposite actions will be performed by zswap_entry_free()
-	 * when the entry is removed from the tree.
-	 */
-	zswap_pool_get(pool);
-	if (objcg) {
-		obj_cgroup_get(objcg);
-		obj_cgroup_charge_zswap(objcg, entry->length);
-	}
-	atomic_long_inc(&zswap_stored_pages);
+		old = xa_store(swap_zswap_tree(page_swpentry),
+			       swp_offset(page_swpentry),
+			       entry, GFP_KERNEL);
+		if (xa_is_err(old)) {
+			int err = xa_err(old);
 
-	/*
-	 * We finish initializing the entry while it's already in xarray.
-	 * This is safe because:
-	 *
-	 * 1. Concurrent stores and invalidations are excluded by folio lock.
-	 *
-	 * 2. Writeback is excluded by the entry not being on the LRU yet.
-	 *    The publishing order matters to prevent writeback from seeing
-	 *    an incoherent entry.
-	 */
-	entry->pool = pool;
-	entry->swpentry = page_swpentry;
-	entry->objcg = objcg;
-	entry->referenced = true;
-	if (entry->length) {
-		INIT_LIST_HEAD(&entry->lru);
-		zswap_lru_add(&zswap_list_lru, entry);
+			WARN_ONCE(err != -ENOMEM, "unexpected xarray error: %d\n", err);
+			zswap_reject_alloc_fail++;
+			goto store_failed;
+		}
+
+		/*
+		 * We may have had an existing entry that became stale when
+		 * the folio was redirtied and now the new version is being
+		 * swapped out. Get rid of the old.
+		 */
+		if (old)
+			zswap_entry_free(old);
+
+		/*
+		 * The entry is successfully compressed and stored in the tree,
+		 * there is no further possibility of failure. Grab refs to the
+		 * pool and objcg, charge zswap memory, and increment
+		 * zswap_stored_pages. The opposite actions will be performed
+		 * by zswap_entry_free() when the entry is removed from the
+		 * tree.
+		 */
+		zswap_pool_get(pool);
+		if (objcg) {
+			obj_cgroup_get(objcg);
+			obj_cgroup_charge_zswap(objcg, entry->length);
+		}
+		atomic_long_inc(&zswap_stored_pages);
+
+		/*
+		 * We finish initializing the entry while it's already in
+		 * xarray. This is safe because:
+		 *
+		 * 1. Concurrent stores and invalidations are excluded by folio
+		 *    lock.
+		 *
+		 * 2. Writeback is excluded by the entry not being on the LRU
+		 *    yet. The publishing order matters to prevent writeback
+		 *    from seeing an incoherent entry.
+		 */
+		entry->pool = pool;
+		entry->swpentry = page_swpentry;
+		entry->objcg = objcg;
+		entry->referenced = true;
+		if (entry->length) {
+			INIT_LIST_HEAD(&entry->lru);
+			zswap_lru_add(&zswap_list_lru, entry);
+		}
 	}
 
 	return true;
 
 store_failed:
-	zpool_free(pool->zpool, entry->handle);
-compress_failed:
-	zswap_entry_cache_free(entry);
+	/*
+	 * Entries before @i are owned by the tree now and are cleaned up by
+	 * the caller, free the compressed data and the rest of the entries.
+	 */
+	for (; i < nr; i++) {
+		if (i < compressed)
+			zpool_free(pool->zpool, entries[i]->handle);
+		zswap_entry_cache_free(entries[i]);
+	}
 	return false;
 }
 
@@ -1565,10 +1654,11 @@ bool zswap_store(struct folio *folio)
 		mem_cgroup_put(memcg);
 	}
 
-	for (index = 0; index < nr_pages; ++index) {
-		struct page *page = folio_page(folio, index);
+	for (index = 0; index < nr_pages; index += ZSWAP_MAX_BATCH_SIZE) {
+		unsigned int nr = min_t(long, nr_pages - index,
+					ZSWAP_MAX_BATCH_SIZE);
 
-		if (!zswap_store_page(page, objcg, pool))
+		if (!zswap_store_pages(folio, index, nr, objcg, pool))
 			goto put_pool;
 	}
 
@@ -1857,15 +1857,46 @@ static int prepare_read_control_remainder(struct ceph_connection *con)
 	return 0;
 }
 
-static int prepare_read_data(struct ceph_connection *con)
+/*
+ * Set up the next pieces of plain data for recvmsg, so that a large
+ * message isn't received one page per call.  in_cursor is advanced past
+ * them right away and the pieces are kept in in_data_bvecs until they
+ * are checksummed.  With rxbounce, each piece is received into
+ * bounce_page on its own and then copied where it belongs.
+ */
+static void set_in_data_bvecs(struct ceph_connection *con)
 {
-	struct bio_vec bv;
+	struct ceph_msg_data_cursor *cursor = &con->v2.in_cursor;
+	bool bounce = ceph_test_opt(from_msgr(con->msgr), RXBOUNCE);
+	struct bio_vec *bvecs = con->v2.in_data_bvecs;
+	size_t len = 0;
+	int i = 0;
+
+	WARN_ON(iov_iter_count(&con->v2.in_iter));
+
+	do {
+		get_bvec_at(cursor, &bvecs[i]);
+		ceph_msg_data_advance(cursor, bvecs[i].bv_len);
+		len += bvecs[i++].bv_len;
+	} while (!bounce && i < ARRAY_SIZE(con->v2.in_data_bvecs) &&
+		 cursor->total_resid);
+	con->v2.in_data_bvec_cnt = i;
+
+	if (bounce) {
+		bvec_set_page(&con->v2.in_bvec, con->bounce_page, len, 0);
+		iov_iter_bvec(&con->v2.in_iter, ITER_DEST, &con->v2.in_bvec,
+			      1, len);
+	} else {
+		iov_iter_bvec(&con->v2.in_iter, ITER_DEST, bvecs, i, len);
+	}
+}
 
+static int prepare_read_data(struct ceph_connection *con)
+{
 	con->in_data_crc = -1;
 	ceph_msg_data_cursor_init(&con->v2.in_cursor, con->in_msg,
 				  data_len(con->in_msg));
 
-	get_bvec_at(&con->v2.in_cursor, &bv);
 	if (ceph_test_opt(from_msgr(con->msgr), RXBOUNCE)) {
 		if (unlikely(!con->bounce_page)) {
 			con->bounce_page = alloc_page(GFP_NOIO);
@@ -1874,43 +1905,36 @@ static int prepare_read_data(struct ceph_connection *con)
 				return -ENOMEM;
 			}
 		}
-
-		bv.bv_page = con->bounce_page;
-		bv.bv_offset = 0;
 	}
-	set_in_bvec(con, &bv);
+	set_in_data_bvecs(con);
 	con->v2.in_state = IN_S_PREPARE_READ_DATA_CONT;
 	return 0;
 }
 
 static void prepare_read_data_cont(struct ceph_connection *con)
 {
-	struct bio_vec bv;
+	struct bio_vec *bv;
+	int i;
 
-	if (ceph_test_opt(from_msgr(con->msgr), RXBOUNCE)) {
-		con->in_data_crc = crc32c(con->in_data_crc,
-					  page_address(con->bounce_page),
-					  con->v2.in_bvec.bv_len);
-
-		get_bvec_at(&con->v2.in_cursor, &bv);
-		memcpy_to_page(bv.bv_page, bv.bv_offset,
-			       page_address(con->bounce_page),
-			       con->v2.in_bvec.bv_len);
-	} else {
-		con->in_data_crc = ceph_crc32c_page(con->in_data_crc,
-						    con->v2.in_bvec.bv_page,
-						    con->v2.in_bvec.bv_offset,
-						    con->v2.in_bvec.bv_len);
+	for (i = 0; i < con->v2.in_data_bvec_cnt; i++) {
+		bv = &con->v2.in_data_bvecs[i];
+		if (ceph_test_opt(from_msgr(con->msgr), RXBOUNCE)) {
+			con->in_data_crc = crc32c(con->in_data_crc,
+						  page_address(con->bounce_page),
+						  bv->bv_len);
+			memcpy_to_page(bv->bv_page, bv->bv_offset,
+				       page_address(con->bounce_page),
+				       bv->bv_len);
+		} else {
+			con->in_data_crc = ceph_crc32c_page(con->in_data_crc,
+							    bv->bv_page,
+							    bv->bv_offset,
+							    bv->bv_len);
+		}
 	}
 
-	ceph_msg_data_advance(&con->v2.in_cursor, con->v2.in_bvec.bv_len);
 	if (con->v2.in_cursor.total_resid) {
-		get_bvec_at(&con->v2.in_cursor, &bv);
-		if (ceph_test_opt(from_msgr(con->msgr), RXBOUNCE)) {
-			bv.bv_page = con->bounce_page;
-			bv.bv_offset = 0;
-		}
-		set_in_bvec(con, &bv);
+		set_in_data_bvecs(con);
 		WARN_ON(con->v2.in_state != IN_S_PREPARE_READ_DATA_CONT);
 		return;
 	}
@@ -3677,26 +3701,22 @@ static void revoke_at_prepare_read_data(struct ceph_connection *con)
 
 static void revoke_at_prepare_read_data_cont(struct ceph_connection *con)
 {
-	int recved, resid;  /* current piece of data */
+	int resid;  /* current pieces of data */
 	int remaining;
 
 	WARN_ON(con_secure(con));
 	WARN_ON(!data_len(con->in_msg));
 	WARN_ON(!iov_iter_is_bvec(&con->v2.in_iter));
 	resid = iov_iter_count(&con->v2.in_iter);
-	WARN_ON(!resid || resid > con->v2.in_bvec.bv_len);
-	recved = con->v2.in_bvec.bv_len - resid;
-	dout("%s con %p recved %d resid %d\n", __func__, con, recved, resid);
-
-	if (recved)
-		ceph_msg_data_advance(&con->v2.in_cursor, recved);
-	WARN_ON(resid > con->v2.in_cursor.total_resid);
+	WARN_ON(!resid);
+	dout("%s con %p resid %d\n", __func__, con, resid);
 
+	/* in_cursor is already past the pieces being received */
 	remaining = CEPH_EPILOGUE_PLAIN_LEN;
 	dout("%s con %p total_resid %zu remaining %d\n", __func__, con,
 	     con->v2.in_cursor.total_resid, remaining);
 	con->v2.in_iter.count -= resid;
-	set_in_skip(con, con->v2.in_cursor.total_resid + remaining);
+	set_in_skip(con, resid + con->v2.in_cursor.total_resid + remaining);
 	con->v2.in_state = IN_S_FINISH_SKIP;
 }
 
@@ -159,6 +159,7 @@
 #include <net/netdev_rx_queue.h>
 #include <net/page_pool/types.h>
 #include <net/page_pool/helpers.h>
+#include <net/page_pool/memory_provider.h>
 #include <net/rps.h>
 #include <linux/phy_link_topology.h>
 
@@ -3868,10 +3869,51 @@ int skb_csum_hwoffload_help(struct sk_buff *skb,
 }
 EXPORT_SYMBOL(skb_csum_hwoffload_help);
 
+/* Unreadable frags can only be sent by a device that handles net_iovs, and,
+ * for dma-buf ones, only by the device the dma-buf was bound to, e.g. not
+ * after a route change.
+ */
+static struct sk_buff *validate_xmit_unreadable_skb(struct sk_buff *skb,
+						    struct net_device *dev)
+{
+	struct skb_shared_info *shinfo;
+	struct net_iov *niov;
+	int i;
+
+	if (likely(skb_frags_readable(skb)))
+		goto out;
+
+	if (!dev->netmem_tx)
+		goto out_free;
+
+	shinfo = skb_shinfo(skb);
+
+	for (i = 0; i < shinfo->nr_frags; i++) {
+		if (!skb_frag_is_net_iov(&shinfo->frags[i]))
+			continue;
+
+		niov = netmem_to_net_iov(skb_frag_netmem(&shinfo->frags[i]));
+		if (net_is_devmem_iov(niov) &&
+		    net_devmem_iov_binding(niov)->dev != dev)
+			goto out_free;
+	}
+
+out:
+	return skb;
+
+out_free:
+	kfree_skb(skb);
+	return NULL;
+}
+
 static struct sk_buff *validate_xmit_skb(struct sk_buff *skb, struct net_device *dev, bool *again)
 {
 	netdev_features_t features;
 
+	skb = validate_xmit_unreadable_skb(skb, dev);
+	if (unlikely(!skb))
+		goto out_null;
+
 	features = netif_skb_features(skb);
 	skb = validate_xmit_vlan(skb, features);
 	if (unlikely(!skb))
@@ -4008,6 +4050,77 @@ static int dev_qdisc_enqueue(struct sk_buff *skb, struct Qdisc *q,
 	return rc;
 }
 
+/* Slow path of __dev_xmit_skb() for TCQ_F_DEFER_ENQUEUE qdiscs: senders push
+ * their skb on q->defer_list without taking any lock. Only the sender finding
+ * the list empty takes the root lock, then enqueues whatever was pushed in
+ * the meantime in one go and runs the qdisc.
+ */
+static int __dev_xmit_skb_deferred(struct sk_buff *skb, struct Qdisc *q,
+				   struct net_device *dev,
+				   struct netdev_queue *txq)
+{
+	spinlock_t *root_lock = qdisc_lock(q);
+	struct sk_buff *next, *to_free = NULL;
+	struct llist_node *first_n, *ll_list;
+	long defer_count = 0;
+	int rc = NET_XMIT_SUCCESS;
+	int count = 0;
+
+	/* Open coded llist_add(), so that defer_count is incremented at most
+	 * once, and only when the list is not empty.
+	 */
+	first_n = READ_ONCE(q->defer_list.first);
+	do {
+		if (first_n && !defer_count) {
+			defer_count = atomic_long_inc_return(&q->defer_count);
+			if (unlikely(defer_count > READ_ONCE(q->limit))) {
+				kfree_skb_reason(skb, SKB_DROP_REASON_QDISC_DROP);
+				return NET_XMIT_DROP;
+			}
+		}
+		skb->ll_node.next = first_n;
+	} while (!try_cmpxchg(&q->defer_list.first, &first_n, &skb->ll_node));
+
+	/* The sender which found the list empty will enqueue our skb. */
+	if (first_n)
+		return NET_XMIT_SUCCESS;
+
+	spin_lock(root_lock);
+
+	ll_list = llist_del_all(&q->defer_list);
+	/* Not atomic with llist_del_all(), defer_list may briefly grow a
+	 * bit over q->limit.
+	 */
+	atomic_long_set(&q->defer_count, 0);
+	ll_list = llist_reverse_order(ll_list);
+
+	if (unlikely(test_bit(__QDISC_STATE_DEACTIVATED, &q->state))) {
+		llist_for_each_entry_safe(skb, next, ll_list, ll_node)
+			__qdisc_drop(skb, &to_free);
+		rc = NET_XMIT_DROP;
+		goto unlock;
+	}
+
+	WRITE_ONCE(q->owner, smp_processor_id());
+	llist_for_each_entry_safe(skb, next, ll_list, ll_node) {
+		prefetch(next);
+		skb_mark_not_on_list(skb);
+		rc = dev_qdisc_enqueue(skb, q, &to_free, txq);
+		count++;
+	}
+	WRITE_ONCE(q->owner, -1);
+	qdisc_run(q);
+	/* Only report the verdict when it was about our own skb. */
+	if (count != 1)
+		rc = NET_XMIT_SUCCESS;
+unlock:
+	spin_unlock(root_lock);
+	if (unlikely(to_free))
+		kfree_skb_list_reason(to_free,
+				      tcf_get_drop_reason(to_free));
+	return rc;
+}
+
 static inline int __dev_xmit_skb(struct sk_buff *skb, struct Qdisc *q,
 				 struct net_device *dev,
 				 struct netdev_queue *txq)
@@ -4058,6 +4171,10 @@ static inline int __dev_xmit_skb(struct sk_buff *skb, struct Qdisc *q,
 		kfree_skb_reason(skb, SKB_DROP_REASON_TC_RECLASSIFY_LOOP);
 		return NET_XMIT_DROP;
 	}
+
+	if (q->flags & TCQ_F_DEFER_ENQUEUE)
+		return __dev_xmit_skb_deferred(skb, q, dev, txq);
+
 	/*
 	 * Heuristic to force contended enqueues to serialize on a
 	 * separate lock before trying to get qdisc main lock.
@@ -4251,6 +4368,8 @@ void tcx_dec(void)
 	static_branch_dec(&tcx_needed_key);
 }
 
+DEFINE_BPF_DISPATCHER(tcx)
+
 static __always_inline enum tcx_action_base
 tcx_run(const struct bpf_mprog_entry *entry, struct sk_buff *skb,
 	const bool needs_mac)
@@ -4263,7 +4382,7 @@ tcx_run(const struct bpf_mprog_entry *entry, struct sk_buff *skb,
 		__skb_push(skb, skb->mac_len);
 	bpf_mprog_foreach_prog(entry, fp, prog) {
 		bpf_compute_data_pointers(skb);
-		ret = bpf_prog_run(prog, skb);
+		ret = __bpf_prog_run(prog, skb, BPF_DISPATCHER_FUNC(tcx));
 		if (ret != TCX_NEXT)
 			break;
 	}
@@ -4715,6 +4834,52 @@ int __dev_direct_xmit(struct sk_buff *skb, u16 queue_id)
 }
 EXPORT_SYMBOL(__dev_direct_xmit);
 
+/**
+ * __dev_direct_xmit_bulk - transmit a batch of skbs on a given TX queue
+ * @skbs: skbs to transmit, for the same device, validated already
+ * @n: number of skbs
+ * @queue_id: TX queue to use
+ *
+ * Like __dev_direct_xmit(), for several skbs at once: the TX queue lock is
+ * only taken once, and the driver is told more packets are coming for all
+ * skbs but the last one, so that it can defer its doorbell.
+ *
+ * Return: number of skbs consumed by the driver from the start of @skbs, the
+ * remaining ones are left to the caller, or -ENETDOWN.
+ */
+int __dev_direct_xmit_bulk(struct sk_buff **skbs, int n, u16 queue_id)
+{
+	struct net_device *dev = skbs[0]->dev;
+	struct netdev_queue *txq;
+	int i;
+
+	if (unlikely(!netif_running(dev) ||
+		     !netif_carrier_ok(dev)))
+		return -ENETDOWN;
+
+	for (i = 0; i < n; i++)
+		skb_set_queue_mapping(skbs[i], queue_id);
+	txq = skb_get_tx_queue(dev, skbs[0]);
+
+	local_bh_disable();
+
+	dev_xmit_recursion_inc();
+	HARD_TX_LOCK(dev, txq, smp_processor_id());
+	for (i = 0; i < n; i++) {
+		if (netif_xmit_frozen_or_drv_stopped(txq))
+			break;
+		if (!dev_xmit_complete(netdev_start_xmit(skbs[i], dev, txq,
+							 i + 1 < n)))
+			break;
+	}
+	HARD_TX_UNLOCK(dev, txq);
+	dev_xmit_recursion_dec();
+
+	local_bh_enable();
+	return i;
+}
+EXPORT_SYMBOL(__dev_direct_xmit_bulk);
+
 /*************************************************************************
  *			Receiver routines
  *************************************************************************/
@@ -4813,6 +4978,28 @@ set_rps_cpu(struct net_device *dev, struct sk_buff *skb,
 	return rflow;
 }
 
+/* Returns the CPU recorded for @hash, or RPS_NO_CPU if the flow is unknown */
+static u32 rps_sock_flow_lookup(const struct rps_sock_flow_table *table,
+				u32 hash)
+{
+	const u32 *bucket = &table->ents[(hash & table->mask) *
+					 RPS_SOCK_FLOW_WAYS];
+	u32 tag = rps_sock_flow_tag(table, hash);
+	u32 ident;
+	int i;
+
+	for (i = 0; i < RPS_SOCK_FLOW_WAYS; i++) {
+		/* This READ_ONCE() pairs with WRITE_ONCE() from
+		 * rps_record_sock_flow().
+		 */
+		ident = READ_ONCE(bucket[i]);
+		if ((ident & ~net_hotdata.rps_cpu_mask) == tag &&
+		    ident != RPS_NO_CPU)
+			return ident & net_hotdata.rps_cpu_mask;
+	}
+	return RPS_NO_CPU;
+}
+
 /*
  * get_rps_cpu is called from netif_receive_skb and returns the target
  * CPU from the RPS map of the receiving queue for a given skb.
@@ -4858,16 +5045,14 @@ static int get_rps_cpu(struct net_device *dev, struct sk_buff *skb,
 	if (flow_table && sock_flow_table) {
 		struct rps_dev_flow *rflow;
 		u32 next_cpu;
-		u32 ident;
 
-		/* First check into global flow table if there is a match.
-		 * This READ_ONCE() pairs with WRITE_ONCE() from rps_record_sock_flow().
-		 */
-		ident = READ_ONCE(sock_flow_table->ents[hash & sock_flow_table->mask]);
-		if ((ident ^ hash) & ~net_hotdata.rps_cpu_mask)
+		/* First check into global flow table if there is a match. */
+		next_cpu = rps_sock_flow_lookup(sock_flow_table, hash);
+		if (next_cpu == RPS_NO_CPU) {
+			this_cpu_inc(softnet_data.rfs_miss);
 			goto try_rps;
-
-		next_cpu = ident & net_hotdata.rps_cpu_mask;
+		}
+		this_cpu_inc(softnet_data.rfs_hit);
 
 		/* OK, now we know there is a match,
 		 * we can look at the local (per receive queue) flow table
@@ -6846,10 +7031,71 @@ static void init_gro_hash(struct napi_struct *napi)
 	int i;
 
 	for (i = 0; i < GRO_HASH_BUCKETS; i++) {
-		INIT_LIST_HEAD(&napi->gro_hash[i].list);
-		napi->gro_hash[i].count = 0;
+		INIT_LIST_HEAD(&napi->gro_hash_inline[i].list);
+		napi->gro_hash_inline[i].count = 0;
 	}
+	napi->gro_hash = napi->gro_hash_inline;
+	napi->gro_active_inline = 0;
+	napi->gro_active = &napi->gro_active_inline;
+	napi->gro_hash_mask = GRO_HASH_BUCKETS - 1;
 	napi->gro_bitmask = 0;
+	napi->gro_count = 0;
+	u64_stats_init(&napi->gro_stats.syncp);
+}
+
+static void free_gro_hash(struct napi_struct *napi)
+{
+	if (napi->gro_hash == napi->gro_hash_inline)
+		return;
+	kvfree(napi->gro_hash);
+	bitmap_free(napi->gro_active);
+}
+
+/* Called with the NAPI disabled, switch to the gro hash size requested
+ * through napi->gro_buckets. Packets still held are completed first.
+ */
+static void napi_resize_gro_hash(struct napi_struct *n)
+{
+	u32 i, buckets = n->gro_buckets ?: GRO_HASH_BUCKETS;
+	unsigned long *active;
+	struct gro_list *hash;
+
+	if (buckets == n->gro_hash_mask + 1)
+		return;
+
+	if (buckets == GRO_HASH_BUCKETS) {
+		hash = n->gro_hash_inline;
+		active = &n->gro_active_inline;
+		*active = 0;
+	} else {
+		hash = kvcalloc(buckets, sizeof(*hash), GFP_KERNEL);
+		active = bitmap_zalloc(buckets, GFP_KERNEL);
+		if (!hash || !active) {
+			kvfree(hash);
+			bitmap_free(active);
+			netdev_warn(n->dev, "failed to resize gro hash to %u buckets\n",
+				    buckets);
+			return;
+		}
+	}
+	for (i = 0; i < buckets; i++) {
+		INIT_LIST_HEAD(&hash[i].list);
+		hash[i].count = 0;
+	}
+
+	if (n->gro_bitmask) {
+		local_bh_disable();
+		napi_gro_flush(n, false);
+		gro_normal_list(n);
+		local_bh_enable();
+	}
+	free_gro_hash(n);
+
+	n->gro_hash = hash;
+	n->gro_active = active;
+	n->gro_hash_mask = buckets - 1;
+	n->gro_bitmask = 0;
+	n->gro_count = 0;
 }
 
 int dev_set_threaded(struct net_device *dev, bool threaded)
@@ -6876,6 +7122,12 @@ int dev_set_threaded(struct net_device *dev, bool threaded)
 
 	WRITE_ONCE(dev->threaded, threaded);
 
+	list_for_each_entry(napi, &dev->napi_list, dev_list) {
+		napi->threaded = threaded ? NETDEV_NAPI_THREADED_ENABLED :
+					    NETDEV_NAPI_THREADED_DISABLED;
+		clear_bit(NAPI_STATE_THREADED_ADAPTIVE, &napi->state);
+	}
+
 	/* Make sure kthread is created before THREADED bit
 	 * is set.
 	 */
@@ -6894,6 +7146,43 @@ int dev_set_threaded(struct net_device *dev, bool threaded)
 }
 EXPORT_SYMBOL(dev_set_threaded);
 
+/**
+ * napi_set_threaded() - set the threaded mode of a single NAPI instance
+ * @n: NAPI context
+ * @threaded: new mode
+ *
+ * In adaptive mode the instance starts out in softirq context and is moved
+ * to its kthread, and back, by napi_poll() and napi_threaded_poll_loop().
+ * As with dev_set_threaded() the change may only take effect from the next
+ * napi_schedule() on.
+ *
+ * Return: 0 on success, negative error if the kthread could not be created.
+ */
+int napi_set_threaded(struct napi_struct *n,
+		      enum netdev_napi_threaded threaded)
+{
+	int err;
+
+	netdev_assert_locked(n->dev);
+
+	if (threaded != NETDEV_NAPI_THREADED_DISABLED && !n->thread) {
+		err = napi_kthread_create(n);
+		if (err)
+			return err;
+	}
+
+	n->threaded = threaded;
+	assign_bit(NAPI_STATE_THREADED_ADAPTIVE, &n->state,
+		   threaded == NETDEV_NAPI_THREADED_ADAPTIVE);
+
+	/* Make sure kthread is created before THREADED bit is set. */
+	smp_mb__before_atomic();
+	assign_bit(NAPI_STATE_THREADED, &n->state,
+		   threaded == NETDEV_NAPI_THREADED_ENABLED);
+
+	return 0;
+}
+
 /**
  * netif_queue_set_napi - Associate queue with the napi
  * @dev: device to which NAPI and queue belong
@@ -6936,6 +7225,8 @@ static void napi_restore_config(struct napi_struct *n)
 	n->defer_hard_irqs = n->config->defer_hard_irqs;
 	n->gro_flush_timeout = n->config->gro_flush_timeout;
 	n->irq_suspend_timeout = n->config->irq_suspend_timeout;
+	n->gro_buckets = n->config->gro_buckets;
+	n->gro_flow_limit = n->config->gro_flow_limit;
 	/* a NAPI ID might be stored in the config, if so use it. if not, use
 	 * napi_hash_add to generate one for us.
 	 */
@@ -6952,6 +7243,8 @@ static void napi_save_config(struct napi_struct *n)
 	n->config->defer_hard_irqs = n->defer_hard_irqs;
 	n->config->gro_flush_timeout = n->gro_flush_timeout;
 	n->config->irq_suspend_timeout = n->irq_suspend_timeout;
+	n->config->gro_buckets = n->gro_buckets;
+	n->config->gro_flow_limit = n->gro_flow_limit;
 	napi_hash_del(n);
 }
 
@@ -7029,6 +7322,8 @@ void netif_napi_add_weight_locked(struct net_device *dev,
 	napi->poll_owner = -1;
 #endif
 	napi->list_owner = -1;
+	u64_stats_init(&napi->poll_stats.syncp);
+	napi->adaptive_count = 0;
 	set_bit(NAPI_STATE_SCHED, &napi->state);
 	set_bit(NAPI_STATE_NPSVC, &napi->state);
 	netif_napi_dev_list_add(dev, napi);
@@ -7046,6 +7341,8 @@ void netif_napi_add_weight_locked(struct net_device *dev,
 	 */
 	if (dev->threaded && napi_kthread_create(napi))
 		dev->threaded = false;
+	napi->threaded = dev->threaded ? NETDEV_NAPI_THREADED_ENABLED :
+					 NETDEV_NAPI_THREADED_DISABLED;
 	netif_napi_set_irq_locked(napi, -1);
 }
 EXPORT_SYMBOL(netif_napi_add_weight_locked);
@@ -7106,11 +7403,13 @@ void napi_enable_locked(struct napi_struct *n)
 	else
 		napi_hash_add(n);
 
+	napi_resize_gro_hash(n);
+
 	do {
 		BUG_ON(!test_bit(NAPI_STATE_SCHED, &val));
 
 		new = val & ~(NAPIF_STATE_SCHED | NAPIF_STATE_NPSVC);
-		if (n->dev->threaded && n->thread)
+		if (n->threaded == NETDEV_NAPI_THREADED_ENABLED && n->thread)
 			new |= NAPIF_STATE_THREADED;
 	} while (!try_cmpxchg(&n->state, &val, new));
 }
@@ -7136,13 +7435,14 @@ static void flush_gro_hash(struct napi_struct *napi)
 {
 	int i;
 
-	for (i = 0; i < GRO_HASH_BUCKETS; i++) {
+	for (i = 0; i <= napi->gro_hash_mask; i++) {
 		struct sk_buff *skb, *n;
 
 		list_for_each_entry_safe(skb, n, &napi->gro_hash[i].list, list)
 			kfree_skb(skb);
 		napi->gro_hash[i].count = 0;
 	}
+	napi->gro_count = 0;
 }
 
 /* Must be called in process context */
@@ -7162,7 +7462,8 @@ void __netif_napi_del_locked(struct napi_struct *napi)
 	napi_free_frags(napi);
 
 	flush_gro_hash(napi);
-	napi->gro_bitmask = 0;
+	free_gro_hash(napi);
+	init_gro_hash(napi);
 
 	if (napi->thread) {
 		kthread_stop(napi->thread);
@@ -7244,17 +7545,91 @@ static int __napi_poll(struct napi_struct *n, bool *repoll)
 	return work;
 }
 
+static u64 napi_poll_account(struct napi_struct *n, u64_stats_t *stat,
+			     u64 start)
+{
+	u64 delta = local_clock() - start;
+
+	u64_stats_update_begin(&n->poll_stats.syncp);
+	u64_stats_add(stat, delta);
+	u64_stats_update_end(&n->poll_stats.syncp);
+
+	return delta;
+}
+
+/* In adaptive threaded mode a NAPI instance whose polls keep exhausting the
+ * budget, or keep running long, in softirq context is handed over to its
+ * kthread, where the scheduler can balance it against application threads.
+ * The kthread gives it back to softirq, which has lower latency, once enough
+ * consecutive polls complete quickly and within budget.
+ */
+#define NAPI_ADAPTIVE_BUSY_POLLS	16
+#define NAPI_ADAPTIVE_IDLE_POLLS	64
+#define NAPI_ADAPTIVE_POLL_NS		(200 * NSEC_PER_USEC)
+
+static bool napi_poll_busy(const struct napi_struct *n, int work, u64 delta)
+{
+	return work >= n->weight || delta >= NAPI_ADAPTIVE_POLL_NS;
+}
+
+/* Called by the softirq owner of a NAPI instance to be repolled */
+static bool napi_adaptive_to_thread(struct napi_struct *n, int work, u64 delta)
+{
+	struct task_struct *thread;
+
+	if (!napi_poll_busy(n, work, delta)) {
+		n->adaptive_count = 0;
+		return false;
+	}
+
+	if (++n->adaptive_count < NAPI_ADAPTIVE_BUSY_POLLS)
+		return false;
+
+	thread = READ_ONCE(n->thread);
+	if (!thread)
+		return false;
+
+	n->adaptive_count = 0;
+	set_bit(NAPI_STATE_THREADED, &n->state);
+	set_bit(NAPI_STATE_SCHED_THREADED, &n->state);
+	wake_up_process(thread);
+
+	return true;
+}
+
+static void napi_adaptive_to_softirq(struct napi_struct *n, int work,
+				     u64 delta, bool repoll)
+{
+	if (repoll || napi_poll_busy(n, work, delta)) {
+		n->adaptive_count = 0;
+		return;
+	}
+
+	if (++n->adaptive_count < NAPI_ADAPTIVE_IDLE_POLLS)
+		return;
+
+	n->adaptive_count = 0;
+	clear_bit(NAPI_STATE_THREADED, &n->state);
+}
+
 static int napi_poll(struct napi_struct *n, struct list_head *repoll)
 {
 	bool do_repoll = false;
 	void *have;
+	u64 delta;
 	int work;
 
 	list_del_init(&n->poll_list);
 
 	have = netpoll_poll_lock(n);
 
+	delta = local_clock();
 	work = __napi_poll(n, &do_repoll);
+	delta = napi_poll_account(n, &n->poll_stats.softirq_ns, delta);
+
+	if (do_repoll && test_bit(NAPI_STATE_THREADED_ADAPTIVE, &n->state) &&
+	    napi_adaptive_to_thread(n, work, delta))
+		do_repoll = false;
 
 	if (do_repoll)
 		list_add_tail(&n->poll_list, repoll);
@@ -7297,6 +7672,8 @@ static void napi_threaded_poll_loop(struct napi_struct *napi)
 	for (;;) {
 		bool repoll = false;
 		void *have;
+		u64 delta;
+		int work;
 
 		local_bh_disable();
 		bpf_net_ctx = bpf_net_ctx_set(&__bpf_net_ctx);
@@ -7305,7 +7682,12 @@ static void napi_threaded_poll_loop(struct napi_struct *napi)
 		sd->in_napi_threaded_poll = true;
 
 		have = netpoll_poll_lock(napi);
-		__napi_poll(napi, &repoll);
+		delta = local_clock();
+		work = __napi_poll(napi, &repoll);
+		delta = napi_poll_account(napi, &napi->poll_stats.threaded_ns,
+					  delta);
+		if (test_bit(NAPI_STATE_THREADED_ADAPTIVE, &napi->state))
+			napi_adaptive_to_softirq(napi, work, delta, repoll);
 		netpoll_poll_unlock(have);
 
 		sd->in_napi_threaded_poll = false;
@@ -10293,7 +10675,7 @@ u32 dev_get_min_mp_channel_count(const struct net_device *dev)
 	ASSERT_RTNL();
 
 	for (i = dev->real_num_rx_queues - 1; i >= 0; i--)
-		if (dev->_rx[i].mp_params.mp_priv)
+		if (dev->_rx[i].mp_params.mp_ops)
 			/* The channel count is the idx plus 1. */
 			return i + 1;
 
@@ -11820,6 +12202,19 @@ void unregister_netdevice_queue(struct net_device *dev, struct list_head *head)
 }
 EXPORT_SYMBOL(unregister_netdevice_queue);
 
+static void dev_memory_provider_uninstall(struct net_device *dev)
+{
+	unsigned int i;
+
+	for (i = 0; i < dev->real_num_rx_queues; i++) {
+		struct netdev_rx_queue *rxq = &dev->_rx[i];
+		struct pp_memory_provider_params *p = &rxq->mp_params;
+
+		if (p->mp_ops && p->mp_ops->uninstall)
+			p->mp_ops->uninstall(rxq->mp_params.mp_priv, rxq);
+	}
+}
+
 void unregister_netdevice_many_notify(struct list_head *head,
 				      u32 portid, const struct nlmsghdr *nlh)
 {
@@ -11874,7 +12269,7 @@ void unregister_netdevice_many_notify(struct list_head *head,
 		dev_tcx_uninstall(dev);
 		dev_xdp_uninstall(dev);
 		bpf_dev_bound_netdev_unregister(dev);
-		dev_dmabuf_uninstall(dev);
+		dev_memory_provider_uninstall(dev);
 
 		netdev_offload_xstats_disable_all(dev);
 
@@ -12242,7 +12637,9 @@ static struct hlist_head * __net_init netdev_create_hash(void)
 /* Initialize per network namespace state */
 static int __net_init netdev_init(struct net *net)
 {
-	BUILD_BUG_ON(GRO_HASH_BUCKETS >
+	BUILD_BUG_ON(GRO_HASH_BUCKETS > GRO_HASH_BUCKETS_MAX);
+	BUILD_BUG_ON(!is_power_of_2(GRO_HASH_BUCKETS_MAX));
+	BUILD_BUG_ON(GRO_HASH_BUCKETS_MAX / BITS_PER_LONG >
 		     8 * sizeof_field(struct napi_struct, gro_bitmask));
 
 	INIT_LIST_HEAD(&net->dev_base_head);
@@ -12609,6 +13006,7 @@ static int __init net_dev_init(void)
 		spin_lock_init(&sd->defer_lock);
 
 		init_gro_hash(&sd->backlog);
+		u64_stats_init(&sd->backlog.poll_stats.syncp);
 		sd->backlog.poll = process_backlog;
 		sd->backlog.weight = weight_p;
 		INIT_LIST_HEAD(&sd->backlog.poll_list);
@@ -291,6 +291,57 @@ static inline void napi_set_irq_suspend_timeout(struct napi_struct *n,
 	WRITE_ONCE(n->irq_suspend_timeout, timeout);
 }
 
+/**
+ * napi_get_gro_flow_limit - get the gro_flow_limit
+ * @n: napi struct to get the gro_flow_limit from
+ *
+ * Return: the per-NAPI value of the gro_flow_limit field.
+ */
+static inline u32 napi_get_gro_flow_limit(const struct napi_struct *n)
+{
+	return READ_ONCE(n->gro_flow_limit);
+}
+
+/**
+ * napi_set_gro_flow_limit - set the gro_flow_limit for a napi
+ * @n: napi struct to set the gro_flow_limit
+ * @limit: maximum number of skbs held by GRO, 0 for no limit
+ *
+ * napi_set_gro_flow_limit sets the per-NAPI gro_flow_limit
+ */
+static inline void napi_set_gro_flow_limit(struct napi_struct *n, u32 limit)
+{
+	WRITE_ONCE(n->gro_flow_limit, limit);
+}
+
+/**
+ * napi_set_gro_buckets - set the gro hash size for a napi
+ * @n: napi struct to set the gro hash size
+ * @buckets: power of two number of buckets, 0 for the default
+ *
+ * The new size takes effect the next time the NAPI is enabled.
+ */
+static inline void napi_set_gro_buckets(struct napi_struct *n, u32 buckets)
+{
+	n->gro_buckets = buckets;
+}
+
+/**
+ * napi_get_threaded - get the threaded mode of a napi
+ * @n: napi struct to get the threaded mode from
+ *
+ * Return: enum netdev_napi_threaded value of the napi.
+ */
+static inline u32 napi_get_threaded(const struct napi_struct *n)
+{
+	if (test_bit(NAPI_STATE_THREADED_ADAPTIVE, &n->state))
+		return NETDEV_NAPI_THREADED_ADAPTIVE;
+	return n->threaded;
+}
+
+int napi_set_threaded(struct napi_struct *n,
+		      enum netdev_napi_threaded threaded);
+
 int rps_cpumask_housekeeping(struct cpumask *mask);
 
 #if defined(CONFIG_DEBUG_NET) && defined(CONFIG_BPF_SYSCALL)
@@ -287,6 +287,26 @@ static void napi_gro_complete(struct napi_struct *napi, struct sk_buff *skb)
 	gro_normal_one(napi, skb, NAPI_GRO_CB(skb)->count);
 }
 
+static void gro_set_active(struct napi_struct *napi, u32 index)
+{
+	__set_bit(index, napi->gro_active);
+	__set_bit(BIT_WORD(index), &napi->gro_bitmask);
+}
+
+static void gro_clear_active(struct napi_struct *napi, u32 index)
+{
+	__clear_bit(index, napi->gro_active);
+	if (!napi->gro_active[BIT_WORD(index)])
+		__clear_bit(BIT_WORD(index), &napi->gro_bitmask);
+}
+
+static void gro_stat_inc(struct napi_struct *napi, u64_stats_t *stat)
+{
+	u64_stats_update_begin(&napi->gro_stats.syncp);
+	u64_stats_inc(stat);
+	u64_stats_update_end(&napi->gro_stats.syncp);
+}
+
 static void __napi_gro_flush_chain(struct napi_struct *napi, u32 index,
 				   bool flush_old)
 {
@@ -299,10 +319,11 @@ static void __napi_gro_flush_chain(struct napi_struct *napi, u32 index,
 		skb_list_del_init(skb);
 		napi_gro_complete(napi, skb);
 		napi->gro_hash[index].count--;
+		napi->gro_count--;
 	}
 
 	if (!napi->gro_hash[index].count)
-		__clear_bit(index, &napi->gro_bitmask);
+		gro_clear_active(napi, index);
 }
 
 /* napi->gro_hash[].list contains packets ordered by age.
@@ -311,13 +332,15 @@ static void __napi_gro_flush_chain(struct napi_struct *napi, u32 index,
  */
 void napi_gro_flush(struct napi_struct *napi, bool flush_old)
 {
-	unsigned long bitmask = napi->gro_bitmask;
-	unsigned int i, base = ~0U;
+	unsigned long words = napi->gro_bitmask;
+	unsigned int w, i;
 
-	while ((i = ffs(bitmask)) != 0) {
-		bitmask >>= i;
-		base += i;
-		__napi_gro_flush_chain(napi, base, flush_old);
+	for_each_set_bit(w, &words, BITS_PER_LONG) {
+		unsigned long active = napi->gro_active[w];
+
+		for_each_set_bit(i, &active, BITS_PER_LONG)
+			__napi_gro_flush_chain(napi, w * BITS_PER_LONG + i,
+					       flush_old);
 	}
 }
 EXPORT_SYMBOL(napi_gro_flush);
@@ -460,8 +483,9 @@ static void gro_flush_oldest(struct napi_struct *napi, struct list_head *head)
 
 static enum gro_result dev_gro_receive(struct napi_struct *napi, struct sk_buff *skb)
 {
-	u32 bucket = skb_get_hash_raw(skb) & (GRO_HASH_BUCKETS - 1);
+	u32 bucket = skb_get_hash_raw(skb) & napi->gro_hash_mask;
 	struct gro_list *gro_list = &napi->gro_hash[bucket];
+	u32 flow_limit;
 	struct list_head *head = &net_hotdata.offload_base;
 	struct packet_offload *ptype;
 	__be16 type = skb->protocol;
@@ -516,6 +540,8 @@ static enum gro_result dev_gro_receive(struct napi_struct *napi, struct sk_buff
 
 	rcu_read_unlock();
 
+	gro_stat_inc(napi, &napi->gro_stats.packets);
+
 	if (PTR_ERR(pp) == -EINPROGRESS) {
 		ret = GRO_CONSUMED;
 		goto ok;
@@ -528,18 +554,33 @@ static enum gro_result dev_gro_receive(struct napi_struct *napi, struct sk_buff
 		skb_list_del_init(pp);
 		napi_gro_complete(napi, pp);
 		gro_list->count--;
+		napi->gro_count--;
 	}
 
-	if (same_flow)
+	if (same_flow) {
+		gro_stat_inc(napi, &napi->gro_stats.merged);
 		goto ok;
+	}
 
 	if (NAPI_GRO_CB(skb)->flush)
 		goto normal;
 
-	if (unlikely(gro_list->count >= MAX_GRO_SKBS))
+	if (unlikely(gro_list->count >= MAX_GRO_SKBS)) {
 		gro_flush_oldest(napi, &gro_list->list);
-	else
+		gro_stat_inc(napi, &napi->gro_stats.evicted);
+	} else {
+		/* Once the NAPI holds gro_flow_limit skbs, pass packets of
+		 * new flows up right away rather than starting to hold them,
+		 * so that flows already being aggregated are not pushed out.
+		 */
+		flow_limit = READ_ONCE(napi->gro_flow_limit);
+		if (unlikely(flow_limit && napi->gro_count >= flow_limit)) {
+			gro_stat_inc(napi, &napi->gro_stats.overlimit);
+			goto normal;
+		}
 		gro_list->count++;
+		napi->gro_count++;
+	}
 
 	/* Must be called before setting NAPI_GRO_CB(skb)->{age|last} */
 	gro_try_pull_from_frag0(skb);
@@ -551,10 +592,10 @@ static enum gro_result dev_gro_receive(struct napi_struct *napi, struct sk_buff
 	ret = GRO_HELD;
 ok:
 	if (gro_list->count) {
-		if (!test_bit(bucket, &napi->gro_bitmask))
-			__set_bit(bucket, &napi->gro_bitmask);
-	} else if (test_bit(bucket, &napi->gro_bitmask)) {
-		__clear_bit(bucket, &napi->gro_bitmask);
+		if (!test_bit(bucket, napi->gro_active))
+			gro_set_active(napi, bucket);
+	} else if (test_bit(bucket, napi->gro_active)) {
+		gro_clear_active(napi, bucket);
 	}
 
 	return ret;
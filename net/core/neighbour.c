@@ -901,16 +901,26 @@ static void neigh_connect(struct neighbour *neigh)
 	WRITE_ONCE(neigh->output, neigh->ops->connected_output);
 }
 
+/* Hash buckets walked by one run of the periodic GC */
+#define NEIGH_GC_BUCKETS	256
+
 static void neigh_periodic_work(struct work_struct *work)
 {
 	struct neigh_table *tbl = container_of(work, struct neigh_table, gc_work.work);
 	struct neigh_hash_table *nht;
+	unsigned int i, end, nbuckets;
 	struct hlist_node *tmp;
+	unsigned long delay;
 	struct neighbour *n;
-	unsigned int i;
 
 	NEIGH_CACHE_STAT_INC(tbl, periodic_gc_runs);
 
+	/* Cycle through all hash buckets every BASE_REACHABLE_TIME/2 ticks.
+	 * ARP entry timeouts range from 1/2 BASE_REACHABLE_TIME to 3/2
+	 * BASE_REACHABLE_TIME.
+	 */
+	delay = NEIGH_VAR(&tbl->parms, BASE_REACHABLE_TIME) >> 1;
+
 	write_lock_bh(&tbl->lock);
 	nht = rcu_dereference_protected(tbl->nht,
 					lockdep_is_held(&tbl->lock));
@@ -928,10 +938,22 @@ static void neigh_periodic_work(struct work_struct *work)
 				neigh_rand_reach_time(NEIGH_VAR(p, BASE_REACHABLE_TIME));
 	}
 
-	if (atomic_read(&tbl->entries) < READ_ONCE(tbl->gc_thresh1))
+	if (atomic_read(&tbl->entries) < READ_ONCE(tbl->gc_thresh1)) {
+		tbl->gc_bucket = 0;
 		goto out;
+	}
 
-	for (i = 0 ; i < (1 << nht->hash_shift); i++) {
+	/* Walk a slice of the table per run, so that the cost of a run does
+	 * not grow with the table. The hash table only ever grows, so the
+	 * slice stays valid if it is resized while the lock is dropped.
+	 */
+	nbuckets = 1 << nht->hash_shift;
+	if (tbl->gc_bucket >= nbuckets)
+		tbl->gc_bucket = 0;
+	i = tbl->gc_bucket;
+	end = min(i + NEIGH_GC_BUCKETS, nbuckets);
+
+	for (; i < end; i++) {
 		neigh_for_each_in_bucket_safe(n, tmp, &nht->hash_heads[i]) {
 			unsigned int state;
 
@@ -971,13 +993,11 @@ static void neigh_periodic_work(struct work_struct *work)
 		nht = rcu_dereference_protected(tbl->nht,
 						lockdep_is_held(&tbl->lock));
 	}
+	tbl->gc_bucket = end;
+
+	delay = max(delay / DIV_ROUND_UP(nbuckets, NEIGH_GC_BUCKETS), 1UL);
 out:
-	/* Cycle through all hash buckets every BASE_REACHABLE_TIME/2 ticks.
-	 * ARP entry timeouts range from 1/2 BASE_REACHABLE_TIME to 3/2
-	 * BASE_REACHABLE_TIME.
-	 */
-	queue_delayed_work(system_power_efficient_wq, &tbl->gc_work,
-			      NEIGH_VAR(&tbl->parms, BASE_REACHABLE_TIME) >> 1);
+	queue_delayed_work(system_power_efficient_wq, &tbl->gc_work, delay);
 	write_unlock_bh(&tbl->lock);
 }
 
@@ -1007,9 +1027,12 @@ static void neigh_invalidate(struct neighbour *neigh)
 	while (neigh->nud_state == NUD_FAILED &&
 	       (skb = __skb_dequeue(&neigh->arp_queue)) != NULL) {
 		write_unlock(&neigh->lock);
+		NEIGH_CACHE_STAT_INC(neigh->tbl, unres_failed);
 		neigh->ops->error_report(neigh, skb);
 		write_lock(&neigh->lock);
 	}
+	NEIGH_CACHE_STAT_ADD(neigh->tbl, unres_failed,
+			     skb_queue_len(&neigh->arp_queue));
 	__skb_queue_purge(&neigh->arp_queue);
 	neigh->arp_queue_len_bytes = 0;
 }
@@ -1157,6 +1180,8 @@ int __neigh_event_send(struct neighbour *neigh, struct sk_buff *skb,
 			neigh->updated = jiffies;
 			write_unlock_bh(&neigh->lock);
 
+			if (skb)
+				NEIGH_CACHE_STAT_INC(neigh->tbl, unres_failed);
 			kfree_skb_reason(skb, SKB_DROP_REASON_NEIGH_FAILED);
 			return 1;
 		}
@@ -2184,6 +2209,8 @@ static int neightbl_fill_info(struct sk_buff *skb, struct neigh_table *tbl,
 			ndst.ndts_periodic_gc_runs	+= READ_ONCE(st->periodic_gc_runs);
 			ndst.ndts_forced_gc_runs	+= READ_ONCE(st->forced_gc_runs);
 			ndst.ndts_table_fulls		+= READ_ONCE(st->table_fulls);
+			ndst.ndts_unres_discards	+= READ_ONCE(st->unres_discards);
+			ndst.ndts_unres_failed		+= READ_ONCE(st->unres_failed);
 		}
 
 		if (nla_put_64bit(skb, NDTA_STATS, sizeof(ndst), &ndst,
@@ -3406,13 +3433,13 @@ static int neigh_stat_seq_show(struct seq_file *seq, void *v)
 	struct neigh_statistics *st = v;
 
 	if (v == SEQ_START_TOKEN) {
-		seq_puts(seq, "entries  allocs   destroys hash_grows lookups  hits     res_failed rcv_probes_mcast rcv_probes_ucast periodic_gc_runs forced_gc_runs unresolved_discards table_fulls\n");
+		seq_puts(seq, "entries  allocs   destroys hash_grows lookups  hits     res_failed rcv_probes_mcast rcv_probes_ucast periodic_gc_runs forced_gc_runs unresolved_discards table_fulls unresolved_failed\n");
 		return 0;
 	}
 
 	seq_printf(seq, "%08x %08lx %08lx %08lx   %08lx %08lx %08lx   "
 			"%08lx         %08lx         %08lx         "
-			"%08lx       %08lx            %08lx\n",
+			"%08lx       %08lx            %08lx    %08lx\n",
 		   atomic_read(&tbl->entries),
 
 		   st->allocs,
@@ -3430,7 +3457,8 @@ static int neigh_stat_seq_show(struct seq_file *seq, void *v)
 		   st->periodic_gc_runs,
 		   st->forced_gc_runs,
 		   st->unres_discards,
-		   st->table_fulls
+		   st->table_fulls,
+		   st->unres_failed
 		   );
 
 	return 0;
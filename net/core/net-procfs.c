@@ -126,7 +126,13 @@ static int softnet_seq_show(struct seq_file *seq, void *v)
 	u32 input_qlen = softnet_input_pkt_queue_len(sd);
 	u32 process_qlen = softnet_process_queue_len(sd);
 	unsigned int flow_limit_count = 0;
+	unsigned int rfs_hit = 0, rfs_miss = 0, rfs_collision = 0;
 
+#ifdef CONFIG_RPS
+	rfs_hit = sd->rfs_hit;
+	rfs_miss = sd->rfs_miss;
+	rfs_collision = sd->rfs_collision;
+#endif
 #ifdef CONFIG_NET_FLOW_LIMIT
 	struct sd_flow_limit *fl;
 
@@ -143,14 +149,15 @@ static int softnet_seq_show(struct seq_file *seq, void *v)
 	 */
 	seq_printf(seq,
 		   "%08x %08x %08x %08x %08x %08x %08x %08x %08x %08x %08x %08x %08x "
-		   "%08x %08x\n",
+		   "%08x %08x %08x %08x %08x\n",
 		   sd->processed, atomic_read(&sd->dropped),
 		   sd->time_squeeze, 0,
 		   0, 0, 0, 0, /* was fastroute */
 		   0,	/* was cpu_collision */
 		   sd->received_rps, flow_limit_count,
 		   input_qlen + process_qlen, (int)seq->index,
-		   input_qlen, process_qlen);
+		   input_qlen, process_qlen,
+		   rfs_hit, rfs_miss, rfs_collision);
 	return 0;
 }
 
@@ -7,6 +7,7 @@
 #include <net/net_namespace.h>
 #include <net/netdev_queues.h>
 #include <net/netdev_rx_queue.h>
+#include <net/page_pool/memory_provider.h>
 #include <net/sock.h>
 #include <net/xdp.h>
 #include <net/xdp_sock.h>
@@ -157,6 +158,53 @@ int netdev_nl_dev_get_dumpit(struct sk_buff *skb, struct netlink_callback *cb)
 	return err;
 }
 
+static int
+netdev_nl_napi_fill_gro(struct sk_buff *rsp, struct napi_struct *napi)
+{
+	const struct napi_gro_stats *stats = &napi->gro_stats;
+	u64 packets, merged, evicted, overlimit;
+	unsigned int start;
+
+	do {
+		start = u64_stats_fetch_begin(&stats->syncp);
+		packets = u64_stats_read(&stats->packets);
+		merged = u64_stats_read(&stats->merged);
+		evicted = u64_stats_read(&stats->evicted);
+		overlimit = u64_stats_read(&stats->overlimit);
+	} while (u64_stats_fetch_retry(&stats->syncp, start));
+
+	if (nla_put_u32(rsp, NETDEV_A_NAPI_GRO_BUCKETS,
+			READ_ONCE(napi->gro_hash_mask) + 1) ||
+	    nla_put_u32(rsp, NETDEV_A_NAPI_GRO_FLOW_LIMIT,
+			napi_get_gro_flow_limit(napi)) ||
+	    nla_put_uint(rsp, NETDEV_A_NAPI_GRO_PACKETS, packets) ||
+	    nla_put_uint(rsp, NETDEV_A_NAPI_GRO_MERGED, merged) ||
+	    nla_put_uint(rsp, NETDEV_A_NAPI_GRO_EVICTED, evicted) ||
+	    nla_put_uint(rsp, NETDEV_A_NAPI_GRO_OVERLIMIT, overlimit))
+		return -EMSGSIZE;
+	return 0;
+}
+
+static int
+netdev_nl_napi_fill_poll(struct sk_buff *rsp, struct napi_struct *napi)
+{
+	const struct napi_poll_stats *stats = &napi->poll_stats;
+	u64 softirq_ns, threaded_ns;
+	unsigned int start;
+
+	do {
+		start = u64_stats_fetch_begin(&stats->syncp);
+		softirq_ns = u64_stats_read(&stats->softirq_ns);
+		threaded_ns = u64_stats_read(&stats->threaded_ns);
+	} while (u64_stats_fetch_retry(&stats->syncp, start));
+
+	if (nla_put_u32(rsp, NETDEV_A_NAPI_THREADED, napi_get_threaded(napi)) ||
+	    nla_put_uint(rsp, NETDEV_A_NAPI_POLL_TIME_SOFTIRQ, softirq_ns) ||
+	    nla_put_uint(rsp, NETDEV_A_NAPI_POLL_TIME_THREADED, threaded_ns))
+		return -EMSGSIZE;
+	return 0;
+}
+
 static int
 netdev_nl_napi_fill_one(struct sk_buff *rsp, struct napi_struct *napi,
 			const struct genl_info *info)
@@ -204,6 +252,12 @@ netdev_nl_napi_fill_one(struct sk_buff *rsp, struct napi_struct *napi,
 			 gro_flush_timeout))
 		goto nla_put_failure;
 
+	if (netdev_nl_napi_fill_gro(rsp, napi))
+		goto nla_put_failure;
+
+	if (netdev_nl_napi_fill_poll(rsp, napi))
+		goto nla_put_failure;
+
 	genlmsg_end(rsp, hdr);
 
 	return 0;
@@ -323,6 +377,19 @@ netdev_nl_napi_set_config(struct napi_struct *napi, struct genl_info *info)
 	u64 gro_flush_timeout = 0;
 	u32 defer = 0;
 
+	if (info->attrs[NETDEV_A_NAPI_GRO_BUCKETS]) {
+		u32 buckets = nla_get_u32(info->attrs[NETDEV_A_NAPI_GRO_BUCKETS]);
+
+		if (buckets && (!is_power_of_2(buckets) ||
+				buckets < GRO_HASH_BUCKETS)) {
+			NL_SET_ERR_MSG_ATTR(info->extack,
+					    info->attrs[NETDEV_A_NAPI_GRO_BUCKETS],
+					    "gro-buckets must be a power of two");
+			return -EINVAL;
+		}
+		napi_set_gro_buckets(napi, buckets);
+	}
+
 	if (info->attrs[NETDEV_A_NAPI_DEFER_HARD_IRQS]) {
 		defer = nla_get_u32(info->attrs[NETDEV_A_NAPI_DEFER_HARD_IRQS]);
 		napi_set_defer_hard_irqs(napi, defer);
@@ -338,6 +405,23 @@ netdev_nl_napi_set_config(struct napi_struct *napi, struct genl_info *info)
 		napi_set_gro_flush_timeout(napi, gro_flush_timeout);
 	}
 
+	if (info->attrs[NETDEV_A_NAPI_GRO_FLOW_LIMIT])
+		napi_set_gro_flow_limit(napi,
+					nla_get_u32(info->attrs[NETDEV_A_NAPI_GRO_FLOW_LIMIT]));
+
+	if (info->attrs[NETDEV_A_NAPI_THREADED]) {
+		u32 threaded = nla_get_u32(info->attrs[NETDEV_A_NAPI_THREADED]);
+		int err;
+
+		err = napi_set_threaded(napi, threaded);
+		if (err) {
+			NL_SET_ERR_MSG_ATTR(info->extack,
+					    info->attrs[NETDEV_A_NAPI_THREADED],
+					    "failed to create NAPI kthread");
+			return err;
+		}
+	}
+
 	return 0;
 }
 
@@ -368,7 +452,7 @@ static int
 netdev_nl_queue_fill_one(struct sk_buff *rsp, struct net_device *netdev,
 			 u32 q_idx, u32 q_type, const struct genl_info *info)
 {
-	struct net_devmem_dmabuf_binding *binding;
+	struct pp_memory_provider_params *params;
 	struct netdev_rx_queue *rxq;
 	struct netdev_queue *txq;
 	void *hdr;
@@ -389,9 +473,9 @@ netdev_nl_queue_fill_one(struct sk_buff *rsp, struct net_device *netdev,
 					     rxq->napi->napi_id))
 			goto nla_put_failure;
 
-		binding = rxq->mp_params.mp_priv;
-		if (binding &&
-		    nla_put_u32(rsp, NETDEV_A_QUEUE_DMABUF, binding->id))
+		params = &rxq->mp_params;
+		if (params->mp_ops && params->mp_ops->nl_fill &&
+		    params->mp_ops->nl_fill(params->mp_priv, rsp, rxq))
 			goto nla_put_failure;
 
 		break;
@@ -854,7 +938,8 @@ int netdev_nl_bind_rx_doit(struct sk_buff *skb, struct genl_info *info)
 		goto err_unlock;
 	}
 
-	binding = net_devmem_bind_dmabuf(netdev, dmabuf_fd, info->extack);
+	binding = net_devmem_bind_dmabuf(netdev, DMA_FROM_DEVICE, dmabuf_fd,
+					 info->extack);
 	if (IS_ERR(binding)) {
 		err = PTR_ERR(binding);
 		goto err_unlock;
@@ -911,6 +996,138 @@ int netdev_nl_bind_rx_doit(struct sk_buff *skb, struct genl_info *info)
 	return err;
 }
 
+int netdev_nl_bind_tx_doit(struct sk_buff *skb, struct genl_info *info)
+{
+	struct net_devmem_dmabuf_binding *binding;
+	struct list_head *sock_binding_list;
+	struct net_device *netdev;
+	u32 ifindex, dmabuf_fd;
+	struct sk_buff *rsp;
+	int err = 0;
+	void *hdr;
+
+	if (GENL_REQ_ATTR_CHECK(info, NETDEV_A_DEV_IFINDEX) ||
+	    GENL_REQ_ATTR_CHECK(info, NETDEV_A_DMABUF_FD))
+		return -EINVAL;
+
+	ifindex = nla_get_u32(info->attrs[NETDEV_A_DEV_IFINDEX]);
+	dmabuf_fd = nla_get_u32(info->attrs[NETDEV_A_DMABUF_FD]);
+
+	sock_binding_list = genl_sk_priv_get(&netdev_nl_family,
+					     NETLINK_CB(skb).sk);
+	if (IS_ERR(sock_binding_list))
+		return PTR_ERR(sock_binding_list);
+
+	rsp = genlmsg_new(GENLMSG_DEFAULT_SIZE, GFP_KERNEL);
+	if (!rsp)
+		return -ENOMEM;
+
+	hdr = genlmsg_iput(rsp, info);
+	if (!hdr) {
+		err = -EMSGSIZE;
+		goto err_genlmsg_free;
+	}
+
+	rtnl_lock();
+
+	netdev = __dev_get_by_index(genl_info_net(info), ifindex);
+	if (!netdev || !netif_device_present(netdev)) {
+		err = -ENODEV;
+		goto err_unlock;
+	}
+
+	if (!netdev->netmem_tx) {
+		NL_SET_ERR_MSG(info->extack,
+			       "Driver does not support netmem TX");
+		err = -EOPNOTSUPP;
+		goto err_unlock;
+	}
+
+	binding = net_devmem_bind_dmabuf(netdev, DMA_TO_DEVICE, dmabuf_fd,
+					 info->extack);
+	if (IS_ERR(binding)) {
+		err = PTR_ERR(binding);
+		goto err_unlock;
+	}
+
+	list_add(&binding->list, sock_binding_list);
+
+	nla_put_u32(rsp, NETDEV_A_DMABUF_ID, binding->id);
+	genlmsg_end(rsp, hdr);
+
+	rtnl_unlock();
+
+	return genlmsg_reply(rsp, info);
+
+err_unlock:
+	rtnl_unlock();
+err_genlmsg_free:
+	nlmsg_free(rsp);
+	return err;
+}
+
+int netdev_nl_dmabuf_get_doit(struct sk_buff *skb, struct genl_info *info)
+{
+	struct net_devmem_dmabuf_binding *binding;
+	struct sk_buff *rsp;
+	int err = 0;
+	void *hdr;
+	u32 id;
+
+	if (GENL_REQ_ATTR_CHECK(info, NETDEV_A_DMABUF_ID))
+		return -EINVAL;
+
+	id = nla_get_u32(info->attrs[NETDEV_A_DMABUF_ID]);
+
+	rsp = genlmsg_new(GENLMSG_DEFAULT_SIZE, GFP_KERNEL);
+	if (!rsp)
+		return -ENOMEM;
+
+	hdr = genlmsg_iput(rsp, info);
+	if (!hdr) {
+		err = -EMSGSIZE;
+		goto err_genlmsg_free;
+	}
+
+	rtnl_lock();
+
+	binding = net_devmem_lookup_dmabuf(id);
+	if (!binding) {
+		err = -ENOENT;
+		goto err_unlock;
+	}
+
+	if (!net_eq(dev_net(binding->dev), genl_info_net(info))) {
+		err = -ENOENT;
+		goto err_put_binding;
+	}
+
+	if (nla_put_u32(rsp, NETDEV_A_DMABUF_ID, binding->id) ||
+	    nla_put_u32(rsp, NETDEV_A_DMABUF_IFINDEX, binding->dev->ifindex) ||
+	    nla_put_uint(rsp, NETDEV_A_DMABUF_TX_BYTES,
+			 atomic64_read(&binding->tx_bytes)) ||
+	    nla_put_uint(rsp, NETDEV_A_DMABUF_TX_INFLIGHT,
+			 atomic_long_read(&binding->tx_inflight))) {
+		err = -EMSGSIZE;
+		goto err_put_binding;
+	}
+
+	net_devmem_dmabuf_binding_put(binding);
+	rtnl_unlock();
+
+	genlmsg_end(rsp, hdr);
+
+	return genlmsg_reply(rsp, info);
+
+err_put_binding:
+	net_devmem_dmabuf_binding_put(binding);
+err_unlock:
+	rtnl_unlock();
+err_genlmsg_free:
+	nlmsg_free(rsp);
+	return err;
+}
+
 void netdev_nl_sock_priv_init(struct list_head *priv)
 {
 	INIT_LIST_HEAD(priv);
@@ -8,6 +8,7 @@
  */
 
 #include <linux/module.h>
+#include <linux/percpu.h>
 #include <linux/random.h>
 #include <linux/slab.h>
 #include <linux/string.h>
@@ -31,14 +32,147 @@
  * Note : Dont forget somaxconn that may limit backlog too.
  */
 
-void reqsk_queue_alloc(struct request_sock_queue *queue)
+int reqsk_queue_alloc(struct request_sock_queue *queue)
 {
 	queue->fastopenq.rskq_rst_head = NULL;
 	queue->fastopenq.rskq_rst_tail = NULL;
 	queue->fastopenq.qlen = 0;
 
 	queue->rskq_accept_head = NULL;
+
+	if (READ_ONCE(queue->rskq_pcpu_accept)) {
+		struct request_sock_pcpu *pcpu;
+		int cpu;
+
+		pcpu = kmalloc(sizeof(*pcpu), GFP_KERNEL);
+		if (!pcpu)
+			return -ENOMEM;
+
+		pcpu->q = alloc_percpu(struct request_sock_pcpu_queue);
+		if (!pcpu->q) {
+			kfree(pcpu);
+			return -ENOMEM;
+		}
+
+		for_each_possible_cpu(cpu)
+			spin_lock_init(&per_cpu_ptr(pcpu->q, cpu)->lock);
+
+		atomic_set(&queue->rskq_pcpu_len, 0);
+		rcu_assign_pointer(queue->rskq_pcpu, pcpu);
+	}
+
+	return 0;
+}
+
+static void reqsk_queue_pcpu_free_rcu(struct rcu_head *head)
+{
+	struct request_sock_pcpu *pcpu;
+
+	pcpu = container_of(head, struct request_sock_pcpu, rcu);
+	free_percpu(pcpu->q);
+	kfree(pcpu);
+}
+
+/*
+ * Move the children left on the per-CPU accept queues to the shared one and
+ * release the per-CPU queues. Called once the listener left TCP_LISTEN: as
+ * each per-CPU lock is taken here, later inet_csk_reqsk_queue_add() calls
+ * holding that lock see the new state and do not queue anything anymore.
+ */
+void reqsk_queue_free(struct request_sock_queue *queue)
+{
+	struct request_sock_pcpu *pcpu;
+	int cpu;
+
+	pcpu = rcu_replace_pointer(queue->rskq_pcpu, NULL, true);
+	if (!pcpu)
+		return;
+
+	for_each_possible_cpu(cpu) {
+		struct request_sock_pcpu_queue *q = per_cpu_ptr(pcpu->q, cpu);
+		struct request_sock *req;
+		int n = 0;
+
+		spin_lock_bh(&q->lock);
+		for (req = q->head; req; req = req->dl_next)
+			n++;
+		if (q->head) {
+			spin_lock(&queue->rskq_lock);
+			if (queue->rskq_accept_head == NULL)
+				WRITE_ONCE(queue->rskq_accept_head, q->head);
+			else
+				queue->rskq_accept_tail->dl_next = q->head;
+			queue->rskq_accept_tail = q->tail;
+			spin_unlock(&queue->rskq_lock);
+			WRITE_ONCE(q->head, NULL);
+			q->tail = NULL;
+			atomic_sub(n, &queue->rskq_pcpu_len);
+		}
+		spin_unlock_bh(&q->lock);
+	}
+
+	call_rcu(&pcpu->rcu, reqsk_queue_pcpu_free_rcu);
+}
+
+static struct request_sock *
+reqsk_queue_pcpu_pop(struct request_sock_queue *queue,
+		     struct request_sock_pcpu_queue *q, struct sock *parent)
+{
+	struct request_sock *req;
+
+	if (!READ_ONCE(q->head))
+		return NULL;
+
+	spin_lock_bh(&q->lock);
+	req = q->head;
+	if (req) {
+		WRITE_ONCE(q->head, req->dl_next);
+		if (q->head == NULL)
+			q->tail = NULL;
+		atomic_dec(&queue->rskq_pcpu_len);
+		sk_acceptq_update_atomic(parent, -1);
+	}
+	spin_unlock_bh(&q->lock);
+
+	return req;
+}
+
+/*
+ * Dequeue a child from the per-CPU accept queues, preferring the local CPU.
+ * Does not need the listener lock, so may race with other accept() calls and
+ * return NULL even though reqsk_queue_empty() was false.
+ */
+struct request_sock *reqsk_queue_pcpu_remove(struct request_sock_queue *queue,
+					     struct sock *parent)
+{
+	struct request_sock_pcpu *pcpu;
+	struct request_sock *req = NULL;
+	int this_cpu, cpu;
+
+	rcu_read_lock();
+	pcpu = rcu_dereference(queue->rskq_pcpu);
+	if (!pcpu || !atomic_read(&queue->rskq_pcpu_len))
+		goto out;
+
+	this_cpu = raw_smp_processor_id();
+	req = reqsk_queue_pcpu_pop(queue, per_cpu_ptr(pcpu->q, this_cpu),
+				   parent);
+	if (req)
+		goto out;
+
+	for_each_cpu_wrap(cpu, cpu_possible_mask, this_cpu + 1) {
+		if (cpu == this_cpu)
+			continue;
+		req = reqsk_queue_pcpu_pop(queue, per_cpu_ptr(pcpu->q, cpu),
+					   parent);
+		if (req)
+			break;
+	}
+out:
+	rcu_read_unlock();
+	return req;
 }
+EXPORT_SYMBOL(reqsk_queue_pcpu_remove);
 
 /*
  * This function is called to set a Fast Open socket's "fastopen_rsk" field
@@ -9,12 +9,25 @@
 #include <net/ip.h>
 #include <net/sock_reuseport.h>
 #include <linux/bpf.h>
+#include <linux/hash.h>
 #include <linux/idr.h>
 #include <linux/filter.h>
 #include <linux/rcupdate.h>
 
 #define INIT_SOCKS 128
 
+/* Load of a socket as seen by reuseport_select_sock_by_load(): how full its
+ * accept or receive queue is, on a REUSEPORT_LOAD_MAX scale, plus a penalty
+ * if the CPU it was last used on is busy.
+ */
+#define REUSEPORT_LOAD_SHIFT	10
+#define REUSEPORT_LOAD_MAX	(1U << REUSEPORT_LOAD_SHIFT)
+#define REUSEPORT_LOAD_CPU_BUSY	(REUSEPORT_LOAD_MAX / 4)
+/* Below this, stick to the socket picked by hash */
+#define REUSEPORT_LOAD_STICKY	(REUSEPORT_LOAD_MAX / 2)
+/* Alternatives considered for an overloaded socket */
+#define REUSEPORT_LOAD_PROBES	2
+
 DEFINE_SPINLOCK(reuseport_lock);
 
 static DEFINE_IDA(reuseport_ida);
@@ -555,6 +568,74 @@ static struct sock *reuseport_select_sock_by_hash(struct sock_reuseport *reuse,
 	return first_valid_sk;
 }
 
+static unsigned int reuseport_sock_load(const struct sock *sk)
+{
+	unsigned int cur, limit, load;
+	int cpu;
+
+	if (sk->sk_state == TCP_LISTEN) {
+		cur = READ_ONCE(sk->sk_ack_backlog);
+		limit = READ_ONCE(sk->sk_max_ack_backlog);
+	} else {
+		cur = atomic_read(&sk->sk_rmem_alloc);
+		limit = READ_ONCE(sk->sk_rcvbuf);
+	}
+
+	if (!limit || cur >= limit)
+		load = REUSEPORT_LOAD_MAX;
+	else
+		load = div_u64((u64)cur << REUSEPORT_LOAD_SHIFT, limit);
+
+	/* Paired with WRITE_ONCE() in reuseport_update_incoming_cpu(). */
+	cpu = READ_ONCE(sk->sk_incoming_cpu);
+	if (cpu >= 0 && cpu < nr_cpu_ids && !idle_cpu(cpu))
+		load += REUSEPORT_LOAD_CPU_BUSY;
+
+	return load;
+}
+
+/* Keep the socket selected by hash unless it's overloaded, so that flows
+ * stick to their socket as long as possible. Otherwise pick the least loaded
+ * of a few alternatives derived from the hash, the power of two choices
+ * being enough to even out load across the group.
+ */
+static struct sock *reuseport_select_sock_by_load(struct sock_reuseport *reuse,
+						  struct sock *sk, u32 hash,
+						  u16 num_socks)
+{
+	unsigned int load = reuseport_sock_load(sk);
+	struct sock *best = sk;
+	int n;
+
+	if (load < REUSEPORT_LOAD_STICKY) {
+		NET_INC_STATS(sock_net(sk), LINUX_MIB_REUSEPORTLOADKEEP);
+		return sk;
+	}
+
+	for (n = 1; n <= REUSEPORT_LOAD_PROBES; n++) {
+		struct sock *sk2;
+		unsigned int load2;
+
+		sk2 = reuse->socks[reciprocal_scale(hash_32(hash + n, 32),
+						    num_socks)];
+		if (sk2 == best || sk2->sk_state == TCP_ESTABLISHED)
+			continue;
+
+		load2 = reuseport_sock_load(sk2);
+		if (load2 < load) {
+			best = sk2;
+			load = load2;
+		}
+	}
+
+	if (best != sk)
+		NET_INC_STATS(sock_net(sk), LINUX_MIB_REUSEPORTLOADDIVERT);
+	else
+		NET_INC_STATS(sock_net(sk), LINUX_MIB_REUSEPORTLOADOVERLOAD);
+
+	return best;
+}
+
 /**
  *  reuseport_select_sock - Select a socket from an SO_REUSEPORT group.
  *  @sk: First socket in the group.
@@ -598,8 +679,13 @@ struct sock *reuseport_select_sock(struct sock *sk,
 
 select_by_hash:
 		/* no bpf or invalid bpf result: fall back to hash usage */
-		if (!sk2)
+		if (!sk2) {
 			sk2 = reuseport_select_sock_by_hash(reuse, hash, socks);
+			if (sk2 &&
+			    READ_ONCE(sock_net(sk)->core.sysctl_reuseport_load))
+				sk2 = reuseport_select_sock_by_load(reuse, sk2,
+								    hash, socks);
+		}
 	}
 
 out:
@@ -161,7 +161,8 @@ static int rps_sock_flow_sysctl(const struct ctl_table *table, int write,
 	orig_sock_table = rcu_dereference_protected(
 					net_hotdata.rps_sock_flow_table,
 					lockdep_is_held(&sock_flow_mutex));
-	size = orig_size = orig_sock_table ? orig_sock_table->mask + 1 : 0;
+	size = orig_size = orig_sock_table ?
+		(orig_sock_table->mask + 1) * RPS_SOCK_FLOW_WAYS : 0;
 
 	ret = proc_dointvec(&tmp, write, buffer, lenp, ppos);
 
@@ -172,8 +173,10 @@ static int rps_sock_flow_sysctl(const struct ctl_table *table, int write,
 				mutex_unlock(&sock_flow_mutex);
 				return -EINVAL;
 			}
-			size = roundup_pow_of_two(size);
+			size = roundup_pow_of_two(max(size, RPS_SOCK_FLOW_WAYS));
 			if (size != orig_size) {
+				unsigned int buckets = size / RPS_SOCK_FLOW_WAYS;
+
 				sock_table =
 				    vmalloc(RPS_SOCK_FLOW_TABLE_SIZE(size));
 				if (!sock_table) {
@@ -182,7 +185,10 @@ static int rps_sock_flow_sysctl(const struct ctl_table *table, int write,
 				}
 				net_hotdata.rps_cpu_mask =
 					roundup_pow_of_two(nr_cpu_ids) - 1;
-				sock_table->mask = size - 1;
+				sock_table->mask = buckets - 1;
+				sock_table->hash_shift = ilog2(buckets);
+				sock_table->cpu_bits =
+					ilog2(net_hotdata.rps_cpu_mask + 1);
 			} else
 				sock_table = orig_sock_table;
 
@@ -676,6 +682,15 @@ static struct ctl_table netns_core_table[] = {
 		.extra2		= SYSCTL_ONE,
 		.proc_handler	= proc_dou8vec_minmax,
 	},
+	{
+		.procname	= "reuseport_load",
+		.data		= &init_net.core.sysctl_reuseport_load,
+		.maxlen		= sizeof(u8),
+		.mode		= 0644,
+		.extra1		= SYSCTL_ZERO,
+		.extra2		= SYSCTL_ONE,
+		.proc_handler	= proc_dou8vec_minmax,
+	},
 	{
 		.procname	= "tstamp_allow_data",
 		.data		= &init_net.core.sysctl_tstamp_allow_data,
@@ -0,0 +1,403 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * IPv4 FIB: DIR-24-8 lookup accelerator.
+ *
+ * This keeps a two level array representation of the prefixes stored in a
+ * FIB trie, as described in:
+ *
+ * Routing Lookups in Hardware at Memory Access Speeds. Pankaj Gupta, Steven
+ * Lin, Nick McKeown. Proceedings of IEEE INFOCOM '98, April 1998.
+ *
+ * The first level table has an entry for each /24 network: if no prefix
+ * longer than 24 bits covers a part of it, the entry directly refers to the
+ * longest matching prefix, otherwise it refers to a second level group of 256
+ * entries, one for each address. A lookup is then one or two accesses to the
+ * table, plus one to the slot array mapping identifiers to user pointers.
+ *
+ * The trie stays the authoritative copy of the routing table: it's up to the
+ * user to insert and remove prefixes as they appear and disappear there, and
+ * to provide, on removal, the longest shorter prefix covering the removed one.
+ * Updates are done in place, under RTNL, while lookups run locklessly, so they
+ * can observe a mix of old and new entries: lookup results need validation.
+ *
+ * Each entry records the prefix length it was derived from, so that updates
+ * only touch entries belonging to the prefix being added or removed, or to
+ * shorter ones, in any insertion order.
+ */
+
+#include <linux/kernel.h>
+#include <linux/mm.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include <linux/rtnetlink.h>
+#include <linux/sched.h>
+
+#include "fib_dir.h"
+
+#define FIB_DIR_KEYLENGTH		32
+#define FIB_DIR_TBL8_CHUNK_GROUPS	(1U << FIB_DIR_TBL8_CHUNK_BITS)
+#define FIB_DIR_SLOT_CHUNK_SLOTS	(1U << FIB_DIR_SLOT_CHUNK_BITS)
+
+struct fib_dir_retired {
+	struct list_head	list;
+	unsigned long		cookie;
+	u32			group;
+};
+
+static u32 fib_dir_entry(u32 id, u8 plen)
+{
+	return FIB_DIR_VALID | (plen << FIB_DIR_PLEN_SHIFT) | id;
+}
+
+static u8 fib_dir_plen(u32 e)
+{
+	return (e >> FIB_DIR_PLEN_SHIFT) & FIB_DIR_PLEN_MASK;
+}
+
+static u32 *fib_dir_group(struct fib_dir *dir, u32 group)
+{
+	u32 *tbl8 = dir->tbl8[group >> FIB_DIR_TBL8_CHUNK_BITS];
+
+	group &= FIB_DIR_TBL8_CHUNK_GROUPS - 1;
+
+	return tbl8 + (group << FIB_DIR_TBL8_BITS);
+}
+
+struct fib_dir *fib_dir_alloc(void)
+{
+	struct fib_dir *dir;
+
+	dir = kvzalloc(sizeof(*dir), GFP_KERNEL_ACCOUNT);
+	if (!dir)
+		return NULL;
+
+	dir->tbl24 = kvcalloc(1U << FIB_DIR_TBL24_BITS, sizeof(u32),
+			      GFP_KERNEL_ACCOUNT);
+	if (!dir->tbl24) {
+		kvfree(dir);
+		return NULL;
+	}
+
+	ida_init(&dir->tbl8_ida);
+	ida_init(&dir->slot_ida);
+	INIT_LIST_HEAD(&dir->tbl8_retired);
+
+	return dir;
+}
+
+/* Free table right away: no lookups must be running on it */
+void fib_dir_free(struct fib_dir *dir)
+{
+	struct fib_dir_retired *r, *tmp;
+	int i;
+
+	list_for_each_entry_safe(r, tmp, &dir->tbl8_retired, list)
+		kfree(r);
+
+	for (i = 0; i < FIB_DIR_CHUNKS; i++) {
+		kvfree(dir->tbl8[i]);
+		kvfree(dir->slot[i]);
+	}
+
+	ida_destroy(&dir->tbl8_ida);
+	ida_destroy(&dir->slot_ida);
+	kvfree(dir->tbl24);
+	kvfree(dir);
+}
+
+static void fib_dir_free_rcu(struct rcu_head *head)
+{
+	fib_dir_free(container_of(head, struct fib_dir, rcu));
+}
+
+/* Free table after a grace period, once unpublished */
+void fib_dir_release(struct fib_dir *dir)
+{
+	call_rcu(&dir->rcu, fib_dir_free_rcu);
+}
+
+/**
+ * fib_dir_slot_alloc() - Get an identifier for a pointer to be stored
+ * @dir:	Lookup table
+ * @ptr:	Pointer returned by lookups for prefixes using this slot
+ *
+ * Slot 0 is never used, so that users can keep zero as "no slot" marker.
+ *
+ * Return: slot identifier, always greater than zero, or negative error.
+ */
+int fib_dir_slot_alloc(struct fib_dir *dir, void *ptr)
+{
+	void __rcu **chunk;
+	int id;
+
+	ASSERT_RTNL();
+
+	id = ida_alloc_range(&dir->slot_ida, 1, FIB_DIR_SLOT_MAX - 1,
+			     GFP_KERNEL);
+	if (id < 0)
+		return id;
+
+	chunk = dir->slot[id >> FIB_DIR_SLOT_CHUNK_BITS];
+	if (!chunk) {
+		chunk = kvcalloc(FIB_DIR_SLOT_CHUNK_SLOTS, sizeof(*chunk),
+				 GFP_KERNEL_ACCOUNT);
+		if (!chunk) {
+			ida_free(&dir->slot_ida, id);
+			return -ENOMEM;
+		}
+
+		/* Paired with READ_ONCE() in fib_dir_lookup() */
+		smp_store_release(&dir->slot[id >> FIB_DIR_SLOT_CHUNK_BITS],
+				  chunk);
+	}
+
+	rcu_assign_pointer(chunk[id & (FIB_DIR_SLOT_CHUNK_SLOTS - 1)], ptr);
+	dir->slots++;
+
+	return id;
+}
+
+/* Lookups running concurrently can still return the old pointer, so it must
+ * only be freed after a grace period. The identifier itself can be reused
+ * right away, as lookup results are validated by users anyway.
+ */
+void fib_dir_slot_free(struct fib_dir *dir, u32 id)
+{
+	void __rcu **chunk = dir->slot[id >> FIB_DIR_SLOT_CHUNK_BITS];
+
+	ASSERT_RTNL();
+
+	RCU_INIT_POINTER(chunk[id & (FIB_DIR_SLOT_CHUNK_SLOTS - 1)], NULL);
+	ida_free(&dir->slot_ida, id);
+	dir->slots--;
+}
+
+/* Unlike slots, groups can't be reused before lookups that might still see
+ * the first level entry referring to them are done: they would otherwise find
+ * entries for a different /24, which might pass validation. Keep them aside
+ * until a grace period elapsed.
+ */
+static void fib_dir_group_reclaim(struct fib_dir *dir)
+{
+	struct fib_dir_retired *r, *tmp;
+
+	list_for_each_entry_safe(r, tmp, &dir->tbl8_retired, list) {
+		if (!poll_state_synchronize_rcu(r->cookie))
+			break;
+
+		ida_free(&dir->tbl8_ida, r->group);
+		list_del(&r->list);
+		kfree(r);
+	}
+}
+
+static void fib_dir_group_free(struct fib_dir *dir, u32 group)
+{
+	struct fib_dir_retired *r;
+
+	dir->tbl8_groups--;
+
+	r = kmalloc(sizeof(*r), GFP_KERNEL);
+	if (!r) {
+		synchronize_rcu();
+		ida_free(&dir->tbl8_ida, group);
+		return;
+	}
+
+	r->group = group;
+	r->cookie = get_state_synchronize_rcu();
+	list_add_tail(&r->list, &dir->tbl8_retired);
+}
+
+static int fib_dir_group_alloc(struct fib_dir *dir, u32 fill, u32 *group)
+{
+	u32 *tbl8, *g;
+	int id, i;
+
+	fib_dir_group_reclaim(dir);
+
+	id = ida_alloc_max(&dir->tbl8_ida, FIB_DIR_TBL8_MAX - 1, GFP_KERNEL);
+	if (id < 0)
+		return id;
+
+	tbl8 = dir->tbl8[id >> FIB_DIR_TBL8_CHUNK_BITS];
+	if (!tbl8) {
+		tbl8 = kvcalloc(FIB_DIR_TBL8_CHUNK_GROUPS * FIB_DIR_TBL8_SIZE,
+				sizeof(u32), GFP_KERNEL_ACCOUNT);
+		if (!tbl8) {
+			ida_free(&dir->tbl8_ida, id);
+			return -ENOMEM;
+		}
+
+		/* Paired with READ_ONCE() in fib_dir_lookup() */
+		smp_store_release(&dir->tbl8[id >> FIB_DIR_TBL8_CHUNK_BITS],
+				  tbl8);
+	}
+
+	g = fib_dir_group(dir, id);
+	for (i = 0; i < FIB_DIR_TBL8_SIZE; i++)
+		WRITE_ONCE(g[i], fill);
+
+	dir->tbl8_groups++;
+	*group = id;
+
+	return 0;
+}
+
+/* Write @new in group entries in [@start, @start + @n) with a prefix length
+ * not longer than @plen, or, if @match, equal to @plen.
+ */
+static void fib_dir_group_update(u32 *g, u32 start, u32 n, u32 new, u8 plen,
+				 bool match)
+{
+	u32 i;
+
+	for (i = start; i < start + n; i++) {
+		u32 e = g[i];
+
+		if (match) {
+			if ((e & FIB_DIR_VALID) && fib_dir_plen(e) == plen)
+				WRITE_ONCE(g[i], new);
+		} else if (!(e & FIB_DIR_VALID) || fib_dir_plen(e) <= plen) {
+			WRITE_ONCE(g[i], new);
+		}
+	}
+}
+
+/**
+ * fib_dir_insert() - Add prefix to table
+ * @dir:	Lookup table
+ * @key:	Prefix, host byte order
+ * @plen:	Prefix length
+ * @id:		Slot identifier, as returned by fib_dir_slot_alloc()
+ *
+ * Return: 0 on success, negative error if a second level group was needed and
+ * couldn't be allocated: the table is then inconsistent and must be dropped.
+ */
+int fib_dir_insert(struct fib_dir *dir, u32 key, u8 plen, u32 id)
+{
+	u32 new = fib_dir_entry(id, plen), i, n, e, start, group;
+	u32 *g;
+	int err;
+
+	ASSERT_RTNL();
+
+	if (plen <= FIB_DIR_TBL24_BITS) {
+		n = 1U << (FIB_DIR_TBL24_BITS - plen);
+
+		for (i = key >> FIB_DIR_TBL8_BITS; n--; i++) {
+			e = dir->tbl24[i];
+
+			if (e & FIB_DIR_EXT) {
+				g = fib_dir_group(dir, e & FIB_DIR_ID_MASK);
+				fib_dir_group_update(g, 0, FIB_DIR_TBL8_SIZE,
+						     new, plen, false);
+			} else if (!(e & FIB_DIR_VALID) || fib_dir_plen(e) <= plen) {
+				WRITE_ONCE(dir->tbl24[i], new);
+			}
+
+			/* up to 2^24 entries for a default route */
+			if (!(i & 0xffff))
+				cond_resched();
+		}
+
+		return 0;
+	}
+
+	i = key >> FIB_DIR_TBL8_BITS;
+	e = dir->tbl24[i];
+
+	start = key & (FIB_DIR_TBL8_SIZE - 1);
+	n = 1U << (FIB_DIR_KEYLENGTH - plen);
+
+	if (e & FIB_DIR_EXT) {
+		g = fib_dir_group(dir, e & FIB_DIR_ID_MASK);
+		fib_dir_group_update(g, start, n, new, plen, false);
+		return 0;
+	}
+
+	err = fib_dir_group_alloc(dir, e, &group);
+	if (err)
+		return err;
+
+	g = fib_dir_group(dir, group);
+	fib_dir_group_update(g, start, n, new, plen, false);
+
+	/* Group contents need to be visible before the group is */
+	smp_wmb();
+	WRITE_ONCE(dir->tbl24[i], FIB_DIR_VALID | FIB_DIR_EXT | group);
+
+	return 0;
+}
+
+/* Fold a group back into its first level entry if all the addresses it covers
+ * resolve to the same prefix, not longer than 24 bits.
+ */
+static void fib_dir_group_collapse(struct fib_dir *dir, u32 i)
+{
+	u32 group = dir->tbl24[i] & FIB_DIR_ID_MASK;
+	u32 *g = fib_dir_group(dir, group);
+	u32 e = g[0];
+	int j;
+
+	if ((e & FIB_DIR_VALID) && fib_dir_plen(e) > FIB_DIR_TBL24_BITS)
+		return;
+
+	for (j = 1; j < FIB_DIR_TBL8_SIZE; j++) {
+		if (g[j] != e)
+			return;
+	}
+
+	WRITE_ONCE(dir->tbl24[i], e);
+	fib_dir_group_free(dir, group);
+}
+
+/**
+ * fib_dir_remove() - Remove prefix from table
+ * @dir:	Lookup table
+ * @key:	Prefix, host byte order
+ * @plen:	Prefix length
+ * @new_id:	Slot identifier for the longest prefix covering the removed one
+ * @new_plen:	Prefix length for @new_id, negative if there's no such prefix
+ */
+void fib_dir_remove(struct fib_dir *dir, u32 key, u8 plen,
+		    u32 new_id, int new_plen)
+{
+	u32 new = new_plen >= 0 ? fib_dir_entry(new_id, new_plen) : 0, i, e;
+	u32 *g;
+
+	ASSERT_RTNL();
+
+	if (plen <= FIB_DIR_TBL24_BITS) {
+		u32 n = 1U << (FIB_DIR_TBL24_BITS - plen);
+
+		for (i = key >> FIB_DIR_TBL8_BITS; n--; i++) {
+			e = dir->tbl24[i];
+
+			if (e & FIB_DIR_EXT) {
+				g = fib_dir_group(dir, e & FIB_DIR_ID_MASK);
+				fib_dir_group_update(g, 0, FIB_DIR_TBL8_SIZE,
+						     new, plen, true);
+			} else if ((e & FIB_DIR_VALID) &&
+				   fib_dir_plen(e) == plen) {
+				WRITE_ONCE(dir->tbl24[i], new);
+			}
+
+			/* up to 2^24 entries for a default route */
+			if (!(i & 0xffff))
+				cond_resched();
+		}
+
+		return;
+	}
+
+	i = key >> FIB_DIR_TBL8_BITS;
+	e = dir->tbl24[i];
+	if (!(e & FIB_DIR_EXT))
+		return;
+
+	g = fib_dir_group(dir, e & FIB_DIR_ID_MASK);
+	fib_dir_group_update(g, key & (FIB_DIR_TBL8_SIZE - 1),
+			     1U << (FIB_DIR_KEYLENGTH - plen), new, plen, true);
+	fib_dir_group_collapse(dir, i);
+}
@@ -0,0 +1,109 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef _FIB_DIR_H
+#define _FIB_DIR_H
+
+#include <linux/types.h>
+#include <linux/bits.h>
+#include <linux/idr.h>
+#include <linux/list.h>
+#include <linux/rcupdate.h>
+
+/* DIR-24-8 lookup table, see fib_dir.c.
+ *
+ * Entries of both the 2^24 first level table and of the 256 entries second
+ * level groups are 32-bit words: the valid bit, the extension bit (first level
+ * only: the entry refers to a second level group), the prefix length of the
+ * route the entry was derived from, and a 24-bit identifier, of a second level
+ * group, or of a slot holding the pointer given by the user for that prefix.
+ */
+#define FIB_DIR_VALID		BIT(31)
+#define FIB_DIR_EXT		BIT(30)
+#define FIB_DIR_PLEN_SHIFT	24
+#define FIB_DIR_PLEN_MASK	0x3f
+#define FIB_DIR_ID_MASK		GENMASK(23, 0)
+
+#define FIB_DIR_TBL24_BITS	24
+#define FIB_DIR_TBL8_BITS	8
+#define FIB_DIR_TBL8_SIZE	(1U << FIB_DIR_TBL8_BITS)
+
+/* Second level groups and slots are allocated in chunks that are never
+ * released before the whole table is, so that lookups only need to check
+ * that the chunk is there.
+ */
+#define FIB_DIR_CHUNKS		4096
+#define FIB_DIR_TBL8_CHUNK_BITS	8	/* 256 groups, 256 KiB */
+#define FIB_DIR_SLOT_CHUNK_BITS	12	/* 4096 slots, 32 KiB */
+#define FIB_DIR_TBL8_MAX	(FIB_DIR_CHUNKS << FIB_DIR_TBL8_CHUNK_BITS)
+#define FIB_DIR_SLOT_MAX	(FIB_DIR_CHUNKS << FIB_DIR_SLOT_CHUNK_BITS)
+
+struct fib_dir {
+	u32			*tbl24;
+	u32			*tbl8[FIB_DIR_CHUNKS];
+	void __rcu		**slot[FIB_DIR_CHUNKS];
+
+	/* Control path only, protected by RTNL */
+	struct ida		tbl8_ida;
+	struct ida		slot_ida;
+	struct list_head	tbl8_retired;
+	unsigned int		tbl8_groups;
+	unsigned int		slots;
+	struct rcu_head		rcu;
+};
+
+struct fib_dir *fib_dir_alloc(void);
+void fib_dir_free(struct fib_dir *dir);
+void fib_dir_release(struct fib_dir *dir);
+
+int fib_dir_slot_alloc(struct fib_dir *dir, void *ptr);
+void fib_dir_slot_free(struct fib_dir *dir, u32 id);
+
+int fib_dir_insert(struct fib_dir *dir, u32 key, u8 plen, u32 id);
+void fib_dir_remove(struct fib_dir *dir, u32 key, u8 plen,
+		    u32 new_id, int new_plen);
+
+/**
+ * fib_dir_lookup() - Find pointer stored for the longest prefix matching key
+ * @dir:	Lookup table
+ * @key:	Address, host byte order
+ * @plen:	Prefix length of the match, filled on success
+ *
+ * Must be called under rcu_read_lock(). The result can be stale with respect
+ * to concurrent updates, so callers need to check that the returned object
+ * still covers @key with the given prefix length.
+ *
+ * Return: pointer given to fib_dir_slot_alloc(), or NULL if none.
+ */
+static inline void *fib_dir_lookup(const struct fib_dir *dir, u32 key,
+				   u8 *plen)
+{
+	u32 e = READ_ONCE(dir->tbl24[key >> FIB_DIR_TBL8_BITS]);
+	void __rcu **chunk;
+	u32 id;
+
+	if (e & FIB_DIR_EXT) {
+		u32 *tbl8;
+
+		id = e & FIB_DIR_ID_MASK;
+		tbl8 = READ_ONCE(dir->tbl8[id >> FIB_DIR_TBL8_CHUNK_BITS]);
+		if (unlikely(!tbl8))
+			return NULL;
+
+		id &= (1U << FIB_DIR_TBL8_CHUNK_BITS) - 1;
+		e = READ_ONCE(tbl8[(id << FIB_DIR_TBL8_BITS) |
+				   (key & (FIB_DIR_TBL8_SIZE - 1))]);
+	}
+
+	if (!(e & FIB_DIR_VALID))
+		return NULL;
+
+	id = e & FIB_DIR_ID_MASK;
+	chunk = READ_ONCE(dir->slot[id >> FIB_DIR_SLOT_CHUNK_BITS]);
+	if (unlikely(!chunk))
+		return NULL;
+
+	*plen = (e >> FIB_DIR_PLEN_SHIFT) & FIB_DIR_PLEN_MASK;
+
+	return rcu_dereference(chunk[id & ((1U << FIB_DIR_SLOT_CHUNK_BITS) - 1)]);
+}
+
+#endif /* _FIB_DIR_H */
@@ -72,6 +72,7 @@
 #include <net/fib_notifier.h>
 #include <trace/events/fib.h>
 #include "fib_lookup.h"
+#include "fib_dir.h"
 
 static int call_fib_entry_notifier(struct notifier_block *nb,
 				   enum fib_event_type event_type, u32 dst,
@@ -134,7 +135,10 @@ struct key_vector {
 struct tnode {
 	struct rcu_head rcu;
 	t_key empty_children;		/* KEYLENGTH bits needed */
-	t_key full_children;		/* KEYLENGTH bits needed */
+	union {
+		t_key full_children;	/* KEYLENGTH bits needed */
+		u32 dir_slot;		/* leaves only: slot in DIR-24-8 table */
+	};
 	struct key_vector __rcu *parent;
 	struct key_vector kv[1];
 #define tn_bits kv[0].bits
@@ -151,6 +155,8 @@ struct trie_use_stats {
 	unsigned int semantic_match_miss;
 	unsigned int null_node_hit;
 	unsigned int resize_node_skipped;
+	unsigned int dir_hit;
+	unsigned int dir_miss;
 };
 #endif
 
@@ -169,6 +175,9 @@ struct trie {
 #ifdef CONFIG_IP_FIB_TRIE_STATS
 	struct trie_use_stats __percpu *stats;
 #endif
+#ifdef CONFIG_IP_FIB_DIR24_8
+	struct fib_dir __rcu *dir;
+#endif
 };
 
 static struct key_vector *resize(struct trie *t, struct key_vector *tn);
@@ -360,6 +369,7 @@ static struct key_vector *leaf_new(t_key key, struct fib_alias *fa)
 	l->pos = 0;
 	l->bits = 0;
 	l->slen = fa->fa_slen;
+	kv->dir_slot = 0;
 
 	/* link leaf to fib alias */
 	INIT_HLIST_HEAD(&l->leaf);
@@ -1095,6 +1105,130 @@ void fib_alias_hw_flags_set(struct net *net, const struct fib_rt_info *fri)
 }
 EXPORT_SYMBOL_GPL(fib_alias_hw_flags_set);
 
+#ifdef CONFIG_IP_FIB_DIR24_8
+/* The DIR-24-8 table, if enabled, mirrors the set of prefixes in the trie:
+ * each leaf holding aliases gets a slot, and each distinct suffix length among
+ * its aliases is a prefix in the table. Lookups find the leaf and prefix
+ * length there, and only need to select an alias. Failing to update the table
+ * would make it inconsistent, so drop it in that case, lookups then fall back
+ * to the trie.
+ */
+static void trie_dir_drop(struct trie *t)
+{
+	struct fib_dir *dir = rtnl_dereference(t->dir);
+
+	pr_warn("IPv4: FIB DIR-24-8 table update failed, disabling\n");
+
+	RCU_INIT_POINTER(t->dir, NULL);
+	fib_dir_release(dir);
+}
+
+static bool leaf_has_slen(struct key_vector *l, u8 slen,
+			  struct fib_alias *skip)
+{
+	struct fib_alias *fa;
+
+	hlist_for_each_entry(fa, &l->leaf, fa_list) {
+		if (fa != skip && fa->fa_slen == slen)
+			return true;
+	}
+
+	return false;
+}
+
+static u32 trie_dir_slot(struct fib_dir *dir, struct key_vector *l)
+{
+	struct tnode *kv = tn_info(l);
+	int id;
+
+	if (kv->dir_slot)
+		return kv->dir_slot;
+
+	id = fib_dir_slot_alloc(dir, l);
+	if (id < 0)
+		return 0;
+
+	kv->dir_slot = id;
+
+	return id;
+}
+
+/* Alias @fa was inserted in leaf @l */
+static void trie_dir_add(struct trie *t, struct key_vector *l,
+			 struct fib_alias *fa)
+{
+	struct fib_dir *dir = rtnl_dereference(t->dir);
+	u32 id;
+
+	if (!dir || leaf_has_slen(l, fa->fa_slen, fa))
+		return;
+
+	id = trie_dir_slot(dir, l);
+	if (!id || fib_dir_insert(dir, l->key, KEYLENGTH - fa->fa_slen, id))
+		trie_dir_drop(t);
+}
+
+/* An alias with suffix length @slen was removed from leaf @l */
+static void trie_dir_del(struct trie *t, struct key_vector *l, u8 slen)
+{
+	struct fib_dir *dir = rtnl_dereference(t->dir);
+	struct key_vector *n = NULL, *tp;
+	int plen;
+	u32 id;
+
+	if (!dir || leaf_has_slen(l, slen, NULL))
+		return;
+
+	/* Entries for the prefix now resolve to the longest shorter one */
+	for (plen = KEYLENGTH - slen - 1; plen >= 0; plen--) {
+		t_key key = plen ? l->key & (KEY_MAX << (KEYLENGTH - plen)) : 0;
+
+		n = fib_find_node(t, &tp, key);
+		if (n && leaf_has_slen(n, KEYLENGTH - plen, NULL))
+			break;
+	}
+
+	if (plen < 0) {
+		fib_dir_remove(dir, l->key, KEYLENGTH - slen, 0, -1);
+		return;
+	}
+
+	id = trie_dir_slot(dir, n);
+	if (!id) {
+		trie_dir_drop(t);
+		return;
+	}
+
+	fib_dir_remove(dir, l->key, KEYLENGTH - slen, id, plen);
+}
+
+/* Leaf @l is going to be freed, after a grace period */
+static void trie_dir_leaf_free(struct trie *t, struct key_vector *l)
+{
+	struct fib_dir *dir = rtnl_dereference(t->dir);
+	struct tnode *kv = tn_info(l);
+
+	if (dir && kv->dir_slot)
+		fib_dir_slot_free(dir, kv->dir_slot);
+
+	kv->dir_slot = 0;
+}
+#else
+static inline void trie_dir_add(struct trie *t, struct key_vector *l,
+				struct fib_alias *fa)
+{
+}
+
+static inline void trie_dir_del(struct trie *t, struct key_vector *l,
+				u8 slen)
+{
+}
+
+static inline void trie_dir_leaf_free(struct trie *t, struct key_vector *l)
+{
+}
+#endif /* CONFIG_IP_FIB_DIR24_8 */
+
 static void trie_rebalance(struct trie *t, struct key_vector *tn)
 {
 	while (!IS_TRIE(tn))
@@ -1144,6 +1278,8 @@ static int fib_insert_node(struct trie *t, struct key_vector *tp,
 	put_child_root(tp, key, l);
 	trie_rebalance(t, tp);
 
+	trie_dir_add(t, l, new);
+
 	return 0;
 notnode:
 	node_free(l);
@@ -1184,6 +1320,8 @@ static int fib_insert_alias(struct trie *t, struct key_vector *tp,
 		node_push_suffix(tp, new->fa_slen);
 	}
 
+	trie_dir_add(t, l, new);
+
 	return 0;
 }
 
@@ -1435,6 +1573,104 @@ bool fib_lookup_good_nhc(const struct fib_nh_common *nhc, int fib_flags,
 	return true;
 }
 
+/* Select an alias from leaf @n matching @key, only considering aliases with
+ * suffix length @slen, unless negative.
+ *
+ * Return: 0 or error from route type if an alias was found, 1 otherwise.
+ */
+static __always_inline int fib_leaf_lookup(struct fib_table *tb,
+					   struct key_vector *n, t_key key,
+					   const struct flowi4 *flp,
+					   struct fib_result *res,
+					   int fib_flags, int slen)
+{
+#ifdef CONFIG_IP_FIB_TRIE_STATS
+	struct trie *t = (struct trie *)tb->tb_data;
+	struct trie_use_stats __percpu *stats = t->stats;
+#endif
+	/* this line carries forward the xor from earlier in the function */
+	unsigned long index = key ^ n->key;
+	struct fib_alias *fa;
+
+	hlist_for_each_entry_rcu(fa, &n->leaf, fa_list) {
+		struct fib_info *fi = fa->fa_info;
+		struct fib_nh_common *nhc;
+		int nhsel, err;
+
+		if (slen >= 0 && fa->fa_slen != slen) {
+			/* aliases are sorted by suffix length */
+			if (fa->fa_slen > slen)
+				break;
+			continue;
+		}
+		if ((BITS_PER_LONG > KEYLENGTH) || (fa->fa_slen < KEYLENGTH)) {
+			if (index >= (1ul << fa->fa_slen))
+				continue;
+		}
+		if (fa->fa_dscp && !fib_dscp_masked_match(fa->fa_dscp, flp))
+			continue;
+		/* Paired with WRITE_ONCE() in fib_release_info() */
+		if (READ_ONCE(fi->fib_dead))
+			continue;
+		if (fa->fa_info->fib_scope < flp->flowi4_scope)
+			continue;
+		fib_alias_accessed(fa);
+		err = fib_props[fa->fa_type].error;
+		if (unlikely(err < 0)) {
+out_reject:
+#ifdef CONFIG_IP_FIB_TRIE_STATS
+			this_cpu_inc(stats->semantic_match_passed);
+#endif
+			trace_fib_table_lookup(tb->tb_id, flp, NULL, err);
+			return err;
+		}
+		if (fi->fib_flags & RTNH_F_DEAD)
+			continue;
+
+		if (unlikely(fi->nh)) {
+			if (nexthop_is_blackhole(fi->nh)) {
+				err = fib_props[RTN_BLACKHOLE].error;
+				goto out_reject;
+			}
+
+			nhc = nexthop_get_nhc_lookup(fi->nh, fib_flags, flp,
+						     &nhsel);
+			if (nhc)
+				goto set_result;
+			return 1;
+		}
+
+		for (nhsel = 0; nhsel < fib_info_num_path(fi); nhsel++) {
+			nhc = fib_info_nhc(fi, nhsel);
+
+			if (!fib_lookup_good_nhc(nhc, fib_flags, flp))
+				continue;
+set_result:
+			if (!(fib_flags & FIB_LOOKUP_NOREF))
+				refcount_inc(&fi->fib_clntref);
+
+			res->prefix = htonl(n->key);
+			res->prefixlen = KEYLENGTH - fa->fa_slen;
+			res->nh_sel = nhsel;
+			res->nhc = nhc;
+			res->type = fa->fa_type;
+			res->scope = fi->fib_scope;
+			res->dscp = fa->fa_dscp;
+			res->fi = fi;
+			res->table = tb;
+			res->fa_head = &n->leaf;
+#ifdef CONFIG_IP_FIB_TRIE_STATS
+			this_cpu_inc(stats->semantic_match_passed);
+#endif
+			trace_fib_table_lookup(tb->tb_id, flp, nhc, err);
+
+			return err;
+		}
+	}
+
+	return 1;
+}
+
 /* should be called with rcu_read_lock */
 int fib_table_lookup(struct fib_table *tb, const struct flowi4 *flp,
 		     struct fib_result *res, int fib_flags)
@@ -1444,10 +1680,13 @@ int fib_table_lookup(struct fib_table *tb, const struct flowi4 *flp,
 	struct trie_use_stats __percpu *stats = t->stats;
 #endif
 	const t_key key = ntohl(flp->daddr);
+#ifdef CONFIG_IP_FIB_DIR24_8
+	struct fib_dir *dir;
+#endif
 	struct key_vector *n, *pn;
-	struct fib_alias *fa;
 	unsigned long index;
 	t_key cindex;
+	int err;
 
 	pn = t->kv;
 	cindex = 0;
@@ -1462,6 +1701,33 @@ int fib_table_lookup(struct fib_table *tb, const struct flowi4 *flp,
 	this_cpu_inc(stats->gets);
 #endif
 
+#ifdef CONFIG_IP_FIB_DIR24_8
+	/* Step 0: the DIR-24-8 table directly gives us the leaf holding the
+	 * longest prefix match. If no alias with that prefix length fits, we
+	 * need to go through the trie to look for shorter ones.
+	 */
+	dir = rcu_dereference(t->dir);
+	if (dir) {
+		struct key_vector *l;
+		u8 plen;
+
+		l = fib_dir_lookup(dir, key, &plen);
+		if (l) {
+			err = fib_leaf_lookup(tb, l, key, flp, res, fib_flags,
+					      KEYLENGTH - plen);
+			if (err <= 0) {
+#ifdef CONFIG_IP_FIB_TRIE_STATS
+				this_cpu_inc(stats->dir_hit);
+#endif
+				return err;
+			}
+		}
+#ifdef CONFIG_IP_FIB_TRIE_STATS
+		this_cpu_inc(stats->dir_miss);
+#endif
+	}
+#endif
+
 	/* Step 1: Travel to the longest prefix match in the trie */
 	for (;;) {
 		index = get_cindex(key, n);
@@ -1561,80 +1827,10 @@ int fib_table_lookup(struct fib_table *tb, const struct flowi4 *flp,
 	}
 
 found:
-	/* this line carries forward the xor from earlier in the function */
-	index = key ^ n->key;
-
 	/* Step 3: Process the leaf, if that fails fall back to backtracing */
-	hlist_for_each_entry_rcu(fa, &n->leaf, fa_list) {
-		struct fib_info *fi = fa->fa_info;
-		struct fib_nh_common *nhc;
-		int nhsel, err;
-
-		if ((BITS_PER_LONG > KEYLENGTH) || (fa->fa_slen < KEYLENGTH)) {
-			if (index >= (1ul << fa->fa_slen))
-				continue;
-		}
-		if (fa->fa_dscp && !fib_dscp_masked_match(fa->fa_dscp, flp))
-			continue;
-		/* Paired with WRITE_ONCE() in fib_release_info() */
-		if (READ_ONCE(fi->fib_dead))
-			continue;
-		if (fa->fa_info->fib_scope < flp->flowi4_scope)
-			continue;
-		fib_alias_accessed(fa);
-		err = fib_props[fa->fa_type].error;
-		if (unlikely(err < 0)) {
-out_reject:
-#ifdef CONFIG_IP_FIB_TRIE_STATS
-			this_cpu_inc(stats->semantic_match_passed);
-#endif
-			trace_fib_table_lookup(tb->tb_id, flp, NULL, err);
-			return err;
-		}
-		if (fi->fib_flags & RTNH_F_DEAD)
-			continue;
-
-		if (unlikely(fi->nh)) {
-			if (nexthop_is_blackhole(fi->nh)) {
-				err = fib_props[RTN_BLACKHOLE].error;
-				goto out_reject;
-			}
-
-			nhc = nexthop_get_nhc_lookup(fi->nh, fib_flags, flp,
-						     &nhsel);
-			if (nhc)
-				goto set_result;
-			goto miss;
-		}
-
-		for (nhsel = 0; nhsel < fib_info_num_path(fi); nhsel++) {
-			nhc = fib_info_nhc(fi, nhsel);
-
-			if (!fib_lookup_good_nhc(nhc, fib_flags, flp))
-				continue;
-set_result:
-			if (!(fib_flags & FIB_LOOKUP_NOREF))
-				refcount_inc(&fi->fib_clntref);
-
-			res->prefix = htonl(n->key);
-			res->prefixlen = KEYLENGTH - fa->fa_slen;
-			res->nh_sel = nhsel;
-			res->nhc = nhc;
-			res->type = fa->fa_type;
-			res->scope = fi->fib_scope;
-			res->dscp = fa->fa_dscp;
-			res->fi = fi;
-			res->table = tb;
-			res->fa_head = &n->leaf;
-#ifdef CONFIG_IP_FIB_TRIE_STATS
-			this_cpu_inc(stats->semantic_match_passed);
-#endif
-			trace_fib_table_lookup(tb->tb_id, flp, nhc, err);
-
-			return err;
-		}
-	}
-miss:
+	err = fib_leaf_lookup(tb, n, key, flp, res, fib_flags, -1);
+	if (err <= 0)
+		return err;
 #ifdef CONFIG_IP_FIB_TRIE_STATS
 	this_cpu_inc(stats->semantic_match_miss);
 #endif
@@ -1651,6 +1847,7 @@ static void fib_remove_alias(struct trie *t, struct key_vector *tp,
 
 	/* remove the fib_alias from the list */
 	hlist_del_rcu(&old->fa_list);
+	trie_dir_del(t, l, old->fa_slen);
 
 	/* if we emptied the list this leaf will be freed and we can sort
 	 * out parent suffix lengths as a part of trie_rebalance
@@ -1659,6 +1856,7 @@ static void fib_remove_alias(struct trie *t, struct key_vector *tp,
 		if (tp->slen == l->slen)
 			node_pull_suffix(tp, tp->pos);
 		put_child_root(tp, l->key, NULL);
+		trie_dir_leaf_free(t, l);
 		node_free(l);
 		trie_rebalance(t, tp);
 		return;
@@ -2000,6 +2198,7 @@ void fib_table_flush_external(struct fib_table *tb)
 			 */
 			if (tb->tb_id != fa->tb_id) {
 				hlist_del_rcu(&fa->fa_list);
+				trie_dir_del(t, n, fa->fa_slen);
 				alias_free_mem_rcu(fa);
 				continue;
 			}
@@ -2013,6 +2212,7 @@ void fib_table_flush_external(struct fib_table *tb)
 
 		if (hlist_empty(&n->leaf)) {
 			put_child_root(pn, n->key, NULL);
+			trie_dir_leaf_free(t, n);
 			node_free(n);
 		}
 	}
@@ -2089,6 +2289,7 @@ int fib_table_flush(struct net *net, struct fib_table *tb, bool flush_all)
 				rtmsg_fib(RTM_DELROUTE, htonl(n->key), fa,
 					  KEYLENGTH - fa->fa_slen, tb->tb_id, &info, 0);
 			hlist_del_rcu(&fa->fa_list);
+			trie_dir_del(t, n, fa->fa_slen);
 			fib_release_info(fa->fa_info);
 			alias_free_mem_rcu(fa);
 			found++;
@@ -2099,6 +2300,7 @@ int fib_table_flush(struct net *net, struct fib_table *tb, bool flush_all)
 
 		if (hlist_empty(&n->leaf)) {
 			put_child_root(pn, n->key, NULL);
+			trie_dir_leaf_free(t, n);
 			node_free(n);
 		}
 	}
@@ -2107,6 +2309,67 @@ int fib_table_flush(struct net *net, struct fib_table *tb, bool flush_all)
 	return found;
 }
 
+#ifdef CONFIG_IP_FIB_DIR24_8
+/* Caller must hold RTNL. */
+int fib_table_dir_set(struct fib_table *tb, bool enable)
+{
+	struct trie *t = (struct trie *)tb->tb_data;
+	struct fib_dir *dir = rtnl_dereference(t->dir);
+	struct key_vector *l, *tp = t->kv;
+	t_key key = 0;
+
+	if (!enable) {
+		if (dir) {
+			RCU_INIT_POINTER(t->dir, NULL);
+			fib_dir_release(dir);
+		}
+		return 0;
+	}
+
+	if (dir)
+		return 0;
+
+	dir = fib_dir_alloc();
+	if (!dir)
+		return -ENOMEM;
+
+	/* Populate the table before publishing it: no lookups yet */
+	while ((l = leaf_walk_rcu(&tp, key)) != NULL) {
+		struct fib_alias *fa;
+		int slen = -1;
+		u32 id;
+
+		tn_info(l)->dir_slot = 0;
+		id = trie_dir_slot(dir, l);
+		if (!id)
+			goto err;
+
+		hlist_for_each_entry(fa, &l->leaf, fa_list) {
+			if (fa->fa_slen == slen)
+				continue;
+
+			slen = fa->fa_slen;
+			if (fib_dir_insert(dir, l->key, KEYLENGTH - slen, id))
+				goto err;
+		}
+
+		/* stop loop if key wrapped back to 0 */
+		key = l->key + 1;
+		if (key < l->key)
+			break;
+
+		cond_resched();
+	}
+
+	rcu_assign_pointer(t->dir, dir);
+
+	return 0;
+err:
+	fib_dir_free(dir);
+	return -ENOMEM;
+}
+#endif /* CONFIG_IP_FIB_DIR24_8 */
+
 /* derived from fib_trie_free */
 static void __fib_info_notify_update(struct net *net, struct fib_table *tb,
 				     struct nl_info *info)
@@ -2246,12 +2509,19 @@ int fib_notify(struct net *net, struct notifier_block *nb,
 static void __trie_free_rcu(struct rcu_head *head)
 {
 	struct fib_table *tb = container_of(head, struct fib_table, rcu);
-#ifdef CONFIG_IP_FIB_TRIE_STATS
+#if defined(CONFIG_IP_FIB_TRIE_STATS) || defined(CONFIG_IP_FIB_DIR24_8)
 	struct trie *t = (struct trie *)tb->tb_data;
 
-	if (tb->tb_data == tb->__data)
+	if (tb->tb_data == tb->__data) {
+#ifdef CONFIG_IP_FIB_TRIE_STATS
 		free_percpu(t->stats);
-#endif /* CONFIG_IP_FIB_TRIE_STATS */
+#endif
+#ifdef CONFIG_IP_FIB_DIR24_8
+		if (rcu_access_pointer(t->dir))
+			fib_dir_free(rcu_dereference_protected(t->dir, 1));
+#endif
+	}
+#endif
 	kfree(tb);
 }
 
@@ -2604,6 +2874,8 @@ static void trie_show_usage(struct seq_file *seq,
 		s.semantic_match_miss += pcpu->semantic_match_miss;
 		s.null_node_hit += pcpu->null_node_hit;
 		s.resize_node_skipped += pcpu->resize_node_skipped;
+		s.dir_hit += pcpu->dir_hit;
+		s.dir_miss += pcpu->dir_miss;
 	}
 
 	seq_printf(seq, "\nCounters:\n---------\n");
@@ -2613,10 +2885,23 @@ static void trie_show_usage(struct seq_file *seq,
 		   s.semantic_match_passed);
 	seq_printf(seq, "semantic match miss = %u\n", s.semantic_match_miss);
 	seq_printf(seq, "null node hit= %u\n", s.null_node_hit);
-	seq_printf(seq, "skipped node resize = %u\n\n", s.resize_node_skipped);
+	seq_printf(seq, "skipped node resize = %u\n", s.resize_node_skipped);
+	seq_printf(seq, "dir hits = %u\n", s.dir_hit);
+	seq_printf(seq, "dir misses = %u\n\n", s.dir_miss);
 }
 #endif /*  CONFIG_IP_FIB_TRIE_STATS */
 
+#ifdef CONFIG_IP_FIB_DIR24_8
+static void trie_show_dir(struct seq_file *seq, const struct fib_dir *dir)
+{
+	if (!dir)
+		return;
+
+	seq_printf(seq, "\tDIR-24-8 groups: %u slots: %u\n",
+		   READ_ONCE(dir->tbl8_groups), READ_ONCE(dir->slots));
+}
+#endif
+
 static void fib_table_print(struct seq_file *seq, struct fib_table *tb)
 {
 	if (tb->tb_id == RT_TABLE_LOCAL)
@@ -2654,6 +2939,9 @@ static int fib_triestat_seq_show(struct seq_file *seq, void *v)
 
 			trie_collect_stats(t, &stat);
 			trie_show_stats(seq, &stat);
+#ifdef CONFIG_IP_FIB_DIR24_8
+			trie_show_dir(seq, rcu_dereference(t->dir));
+#endif
 #ifdef CONFIG_IP_FIB_TRIE_STATS
 			trie_show_usage(seq, t->stats);
 #endif
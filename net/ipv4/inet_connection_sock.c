@@ -665,10 +665,18 @@ struct sock *inet_csk_accept(struct sock *sk, struct proto_accept_arg *arg)
 {
 	struct inet_connection_sock *icsk = inet_csk(sk);
 	struct request_sock_queue *queue = &icsk->icsk_accept_queue;
-	struct request_sock *req;
+	struct request_sock *req = NULL;
 	struct sock *newsk;
 	int error;
 
+	/* Per-CPU accept queues are consumed without the listener lock,
+	 * which is then only needed to wait for a connection.
+	 */
+	if (rcu_access_pointer(queue->rskq_pcpu))
+		req = reqsk_queue_pcpu_remove(queue, sk);
+	if (req)
+		goto found;
+
 	lock_sock(sk);
 
 	/* We need to make sure that this socket is listening,
@@ -678,8 +686,11 @@ struct sock *inet_csk_accept(struct sock *sk, struct proto_accept_arg *arg)
 	if (sk->sk_state != TCP_LISTEN)
 		goto out_err;
 
-	/* Find already established connection */
-	if (reqsk_queue_empty(queue)) {
+	/* Find already established connection. A lockless accept() on
+	 * per-CPU queues may take it first, in which case wait again.
+	 */
+	while (reqsk_queue_empty(queue) ||
+	       !(req = reqsk_queue_remove(queue, sk))) {
 		long timeo = sock_rcvtimeo(sk, arg->flags & O_NONBLOCK);
 
 		/* If this is a non blocking socket don't sleep */
@@ -691,7 +702,8 @@ struct sock *inet_csk_accept(struct sock *sk, struct proto_accept_arg *arg)
 		if (error)
 			goto out_err;
 	}
-	req = reqsk_queue_remove(queue, sk);
+	release_sock(sk);
+found:
 	arg->is_empty = reqsk_queue_empty(queue);
 	newsk = req->sk;
 
@@ -711,9 +723,7 @@ struct sock *inet_csk_accept(struct sock *sk, struct proto_accept_arg *arg)
 		spin_unlock_bh(&queue->fastopenq.lock);
 	}
 
-out:
-	release_sock(sk);
-	if (newsk && mem_cgroup_sockets_enabled) {
+	if (mem_cgroup_sockets_enabled) {
 		gfp_t gfp = GFP_KERNEL | __GFP_NOFAIL;
 		int amt = 0;
 
@@ -740,15 +750,13 @@ struct sock *inet_csk_accept(struct sock *sk, struct proto_accept_arg *arg)
 	if (req)
 		reqsk_put(req);
 
-	if (newsk)
-		inet_init_csk_locks(newsk);
+	inet_init_csk_locks(newsk);
 
 	return newsk;
 out_err:
-	newsk = NULL;
-	req = NULL;
+	release_sock(sk);
 	arg->err = error;
-	goto out;
+	return NULL;
 }
 EXPORT_SYMBOL(inet_csk_accept);
 
@@ -1349,7 +1357,9 @@ int inet_csk_listen_start(struct sock *sk)
 	if (unlikely(err))
 		return err;
 
-	reqsk_queue_alloc(&icsk->icsk_accept_queue);
+	err = reqsk_queue_alloc(&icsk->icsk_accept_queue);
+	if (unlikely(err))
+		return err;
 
 	sk->sk_ack_backlog = 0;
 	inet_csk_delack_init(sk);
@@ -1372,6 +1382,7 @@ int inet_csk_listen_start(struct sock *sk)
 	}
 
 	inet_sk_set_state(sk, TCP_CLOSE);
+	reqsk_queue_free(&icsk->icsk_accept_queue);
 	return err;
 }
 EXPORT_SYMBOL_GPL(inet_csk_listen_start);
@@ -1405,6 +1416,34 @@ struct sock *inet_csk_reqsk_queue_add(struct sock *sk,
 				      struct sock *child)
 {
 	struct request_sock_queue *queue = &inet_csk(sk)->icsk_accept_queue;
+	struct request_sock_pcpu *pcpu;
+
+	rcu_read_lock();
+	pcpu = rcu_dereference(queue->rskq_pcpu);
+	if (pcpu) {
+		struct request_sock_pcpu_queue *q;
+
+		q = per_cpu_ptr(pcpu->q, raw_smp_processor_id());
+		spin_lock(&q->lock);
+		if (unlikely(sk->sk_state != TCP_LISTEN)) {
+			inet_child_forget(sk, req, child);
+			child = NULL;
+		} else {
+			req->sk = child;
+			req->dl_next = NULL;
+			if (q->head == NULL)
+				WRITE_ONCE(q->head, req);
+			else
+				q->tail->dl_next = req;
+			q->tail = req;
+			atomic_inc(&queue->rskq_pcpu_len);
+			sk_acceptq_update_atomic(sk, 1);
+		}
+		spin_unlock(&q->lock);
+		rcu_read_unlock();
+		return child;
+	}
+	rcu_read_unlock();
 
 	spin_lock(&queue->rskq_lock);
 	if (unlikely(sk->sk_state != TCP_LISTEN)) {
@@ -1489,6 +1528,7 @@ void inet_csk_listen_stop(struct sock *sk)
 	 * To be honest, we are not able to make either
 	 * of the variants now.			--ANK
 	 */
+	reqsk_queue_free(queue);
 	while ((req = reqsk_queue_remove(queue, sk)) != NULL) {
 		struct sock *child = req->sk, *nsk;
 		struct request_sock *nreq;
@@ -306,6 +306,11 @@ static const struct snmp_mib snmp4_net_list[] = {
 	SNMP_MIB_ITEM("TCPAOKeyNotFound", LINUX_MIB_TCPAOKEYNOTFOUND),
 	SNMP_MIB_ITEM("TCPAOGood", LINUX_MIB_TCPAOGOOD),
 	SNMP_MIB_ITEM("TCPAODroppedIcmps", LINUX_MIB_TCPAODROPPEDICMPS),
+	SNMP_MIB_ITEM("ReusePortLoadKeep", LINUX_MIB_REUSEPORTLOADKEEP),
+	SNMP_MIB_ITEM("ReusePortLoadDivert", LINUX_MIB_REUSEPORTLOADDIVERT),
+	SNMP_MIB_ITEM("ReusePortLoadOverload", LINUX_MIB_REUSEPORTLOADOVERLOAD),
+	SNMP_MIB_ITEM("IP6RtPcpuCacheHit", LINUX_MIB_IP6RTPCPUCACHEHIT),
+	SNMP_MIB_ITEM("IP6RtPcpuCacheMiss", LINUX_MIB_IP6RTPCPUCACHEMISS),
 	SNMP_MIB_SENTINEL
 };
 
@@ -434,6 +434,30 @@ static int proc_udp_hash_entries(const struct ctl_table *table, int write,
 	return proc_dointvec(&tbl, write, buffer, lenp, ppos);
 }
 
+#ifdef CONFIG_IP_FIB_DIR24_8
+static int proc_fib_dir24_8(const struct ctl_table *table, int write,
+			    void *buffer, size_t *lenp, loff_t *ppos)
+{
+	struct net *net = container_of(table->data, struct net,
+				       ipv4.sysctl_fib_dir24_8);
+	struct fib_table *tb;
+	int ret;
+
+	rtnl_lock();
+	ret = proc_dou8vec_minmax(table, write, buffer, lenp, ppos);
+	if (write && ret == 0) {
+		tb = fib_get_table(net, RT_TABLE_MAIN);
+		if (tb)
+			ret = fib_table_dir_set(tb, net->ipv4.sysctl_fib_dir24_8);
+		if (ret)
+			net->ipv4.sysctl_fib_dir24_8 = 0;
+	}
+	rtnl_unlock();
+
+	return ret;
+}
+#endif
+
 #ifdef CONFIG_IP_ROUTE_MULTIPATH
 static int proc_fib_multipath_hash_policy(const struct ctl_table *table, int write,
 					  void *buffer, size_t *lenp,
@@ -1444,6 +1468,15 @@ static struct ctl_table ipv4_net_table[] = {
 		.extra1		= SYSCTL_ZERO,
 		.extra2		= SYSCTL_ONE,
 	},
+	{
+		.procname	= "tcp_timer_coalesce",
+		.data		= &init_net.ipv4.sysctl_tcp_timer_coalesce,
+		.maxlen		= sizeof(u8),
+		.mode		= 0644,
+		.proc_handler	= proc_dou8vec_minmax,
+		.extra1		= SYSCTL_ZERO,
+		.extra2		= SYSCTL_ONE,
+	},
 	{
 		.procname       = "tcp_reflect_tos",
 		.data           = &init_net.ipv4.sysctl_tcp_reflect_tos,
@@ -1508,6 +1541,17 @@ static struct ctl_table ipv4_net_table[] = {
 		.extra1		= SYSCTL_ZERO,
 		.extra2		= SYSCTL_TWO,
 	},
+#ifdef CONFIG_IP_FIB_DIR24_8
+	{
+		.procname	= "fib_dir24_8",
+		.data		= &init_net.ipv4.sysctl_fib_dir24_8,
+		.maxlen		= sizeof(u8),
+		.mode		= 0644,
+		.proc_handler	= proc_fib_dir24_8,
+		.extra1		= SYSCTL_ZERO,
+		.extra2		= SYSCTL_ONE,
+	},
+#endif
 	{
 		.procname       = "tcp_plb_enabled",
 		.data           = &init_net.ipv4.sysctl_tcp_plb_enabled,
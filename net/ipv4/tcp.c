@@ -1051,6 +1051,7 @@ int tcp_sendmsg_fastopen(struct sock *sk, struct msghdr *msg, int *copied,
 
 int tcp_sendmsg_locked(struct sock *sk, struct msghdr *msg, size_t size)
 {
+	struct net_devmem_dmabuf_binding *binding = NULL;
 	struct tcp_sock *tp = tcp_sk(sk);
 	struct ubuf_info *uarg = NULL;
 	struct sk_buff *skb;
@@ -1063,6 +1064,15 @@ int tcp_sendmsg_locked(struct sock *sk, struct msghdr *msg, size_t size)
 
 	flags = msg->msg_flags;
 
+	sockcm_init(&sockc, sk);
+	if (msg->msg_controllen) {
+		err = sock_cmsg_send(sk, msg, &sockc);
+		if (unlikely(err)) {
+			err = -EINVAL;
+			goto out_err;
+		}
+	}
+
 	if ((flags & MSG_ZEROCOPY) && size) {
 		if (msg->msg_ubuf) {
 			uarg = msg->msg_ubuf;
@@ -1070,7 +1080,8 @@ int tcp_sendmsg_locked(struct sock *sk, struct msghdr *msg, size_t size)
 				zc = MSG_ZEROCOPY;
 		} else if (sock_flag(sk, SOCK_ZEROCOPY)) {
 			skb = tcp_write_queue_tail(sk);
-			uarg = msg_zerocopy_realloc(sk, size, skb_zcopy(skb));
+			uarg = msg_zerocopy_realloc(sk, size, skb_zcopy(skb),
+						    !!sockc.dmabuf_id);
 			if (!uarg) {
 				err = -ENOBUFS;
 				goto out_err;
@@ -1085,6 +1096,23 @@ int tcp_sendmsg_locked(struct sock *sk, struct msghdr *msg, size_t size)
 			zc = MSG_SPLICE_PAGES;
 	}
 
+	if (sockc.dmabuf_id) {
+		/* The iovecs hold offsets into the dma-buf, which can only be
+		 * sent by reference.
+		 */
+		if (zc != MSG_ZEROCOPY || msg->msg_ubuf) {
+			err = -EINVAL;
+			goto out_err;
+		}
+
+		binding = net_devmem_get_binding(sk, sockc.dmabuf_id);
+		if (IS_ERR(binding)) {
+			err = PTR_ERR(binding);
+			binding = NULL;
+			goto out_err;
+		}
+	}
+
 	if (unlikely(flags & MSG_FASTOPEN ||
 		     inet_test_bit(DEFER_CONNECT, sk)) &&
 	    !tp->repair) {
@@ -1123,15 +1151,6 @@ int tcp_sendmsg_locked(struct sock *sk, struct msghdr *msg, size_t size)
 		/* 'common' sending to sendq */
 	}
 
-	sockcm_init(&sockc, sk);
-	if (msg->msg_controllen) {
-		err = sock_cmsg_send(sk, msg, &sockc);
-		if (unlikely(err)) {
-			err = -EINVAL;
-			goto out_err;
-		}
-	}
-
 	/* This should be in poll */
 	sk_clear_bit(SOCKWQ_ASYNC_NOSPACE, sk);
 
@@ -1248,7 +1267,8 @@ int tcp_sendmsg_locked(struct sock *sk, struct msghdr *msg, size_t size)
 					goto wait_for_space;
 			}
 
-			err = skb_zerocopy_iter_stream(sk, skb, msg, copy, uarg);
+			err = skb_zerocopy_iter_stream(sk, skb, msg, copy, uarg,
+						       binding);
 			if (err == -EMSGSIZE || err == -EEXIST) {
 				tcp_mark_push(tp, skb);
 				goto new_segment;
@@ -1329,6 +1349,8 @@ int tcp_sendmsg_locked(struct sock *sk, struct msghdr *msg, size_t size)
 	/* msg->msg_ubuf is pinned by the caller so we don't take extra refs */
 	if (uarg && !msg->msg_ubuf)
 		net_zcopy_put(uarg);
+	if (binding)
+		net_devmem_dmabuf_binding_put(binding);
 	return copied + copied_syn;
 
 do_error:
@@ -1340,6 +1362,8 @@ int tcp_sendmsg_locked(struct sock *sk, struct msghdr *msg, size_t size)
 	/* msg->msg_ubuf is pinned by the caller so we don't take extra refs */
 	if (uarg && !msg->msg_ubuf)
 		net_zcopy_put_abort(uarg, true);
+	if (binding)
+		net_devmem_dmabuf_binding_put(binding);
 	err = sk_stream_error(sk, flags, err);
 	/* make sure we wake any epoll edge trigger waiter */
 	if (unlikely(tcp_rtx_and_write_queues_empty(sk) && err == -EAGAIN)) {
@@ -1822,12 +1846,20 @@ static bool can_map_frag(const skb_frag_t *frag)
 {
 	struct page *page;
 
-	if (skb_frag_size(frag) != PAGE_SIZE || skb_frag_off(frag))
+	if (!skb_frag_size(frag) || !PAGE_ALIGNED(skb_frag_size(frag)) ||
+	    !PAGE_ALIGNED(skb_frag_off(frag)))
 		return false;
 
-	page = skb_frag_page(frag);
+	page = compound_head(skb_frag_page(frag));
+
+	if (page->mapping)
+		return false;
 
-	if (PageCompound(page) || page->mapping)
+	/* High order rx buffers are fine as long as they come from a page
+	 * pool, compound pages of unknown origin may belong to a filesystem.
+	 */
+	if (PageCompound(page) &&
+	    (page->pp_magic & ~0x3UL) != PP_SIGNATURE)
 		return false;
 
 	return true;
@@ -1864,6 +1896,12 @@ static void tcp_zerocopy_set_hint_for_skb(struct sock *sk,
 	if (!frag)
 		return;
 
+	/* The rest of a multi-page frag can still be mapped. */
+	if (PAGE_ALIGNED(frag_offset) && can_map_frag(frag)) {
+		zc->recv_skip_hint = 0;
+		return;
+	}
+
 	if (frag_offset) {
 		struct skb_shared_info *info = skb_shinfo(skb);
 
@@ -2119,6 +2157,7 @@ static int tcp_zerocopy_receive(struct sock *sk,
 	struct tcp_sock *tp = tcp_sk(sk);
 	const skb_frag_t *frags = NULL;
 	unsigned int pages_to_map = 0;
+	unsigned int frag_page = 0;
 	struct vm_area_struct *vma;
 	struct sk_buff *skb = NULL;
 	u32 seq = tp->copied_seq;
@@ -2192,25 +2231,37 @@ static int tcp_zerocopy_receive(struct sock *sk,
 			}
 			zc->recv_skip_hint = skb->len - offset;
 			frags = skb_advance_to_frag(skb, offset, &offset_frag);
-			if (!frags || offset_frag)
+			if (!frags)
+				break;
+			/* We may resume part way through a multi-page frag. */
+			if (offset_frag && (!PAGE_ALIGNED(offset_frag) ||
+					    !can_map_frag(frags)))
 				break;
+			frag_page = offset_frag >> PAGE_SHIFT;
 		}
 
-		mappable_offset = find_next_mappable_frag(frags,
-							  zc->recv_skip_hint);
-		if (mappable_offset) {
-			zc->recv_skip_hint = mappable_offset;
-			break;
+		if (!frag_page) {
+			mappable_offset = find_next_mappable_frag(frags,
+								  zc->recv_skip_hint);
+			if (mappable_offset) {
+				zc->recv_skip_hint = mappable_offset;
+				break;
+			}
 		}
 		page = skb_frag_page(frags);
 		if (WARN_ON_ONCE(!page))
 			break;
+		page = nth_page(page, (skb_frag_off(frags) >> PAGE_SHIFT) +
+				      frag_page);
 
 		prefetchw(page);
 		pages[pages_to_map++] = page;
 		length += PAGE_SIZE;
 		zc->recv_skip_hint -= PAGE_SIZE;
-		frags++;
+		if (++frag_page == skb_frag_size(frags) >> PAGE_SHIFT) {
+			frags++;
+			frag_page = 0;
+		}
 		if (pages_to_map == TCP_ZEROCOPY_PAGE_BATCH_SIZE ||
 		    zc->recv_skip_hint < PAGE_SIZE) {
 			/* Either full batch, or we're about to go to next skb
@@ -2486,13 +2537,13 @@ static int tcp_recvmsg_dmabuf(struct sock *sk, const struct sk_buff *skb,
 			 * skb_frags_readable() correctly, we still don't want
 			 * to crash here.
 			 */
-			if (!skb_frag_net_iov(frag)) {
+			niov = skb_frag_net_iov(frag);
+			if (!niov || !net_is_devmem_iov(niov)) {
 				net_err_ratelimited("Found non-dmabuf skb with net_iov");
 				err = -ENODEV;
 				goto out;
 			}
 
-			niov = skb_frag_net_iov(frag);
 			end = start + skb_frag_size(frag);
 			copy = end - offset;
 
@@ -3986,6 +4037,12 @@ int do_tcp_setsockopt(struct sock *sk, int level, int optname,
 			err = -EOPNOTSUPP;
 		}
 		break;
+	case TCP_ACCEPT_PERCPU:
+		if (val > 1 || val < 0 || sk->sk_state != TCP_CLOSE)
+			err = -EINVAL;
+		else
+			WRITE_ONCE(icsk->icsk_accept_queue.rskq_pcpu_accept, val);
+		break;
 	case TCP_FASTOPEN_NO_COOKIE:
 		if (val > 1 || val < 0)
 			err = -EINVAL;
@@ -4508,6 +4565,10 @@ int do_tcp_getsockopt(struct sock *sk, int level,
 		val = tp->fastopen_connect;
 		break;
 
+	case TCP_ACCEPT_PERCPU:
+		val = READ_ONCE(icsk->icsk_accept_queue.rskq_pcpu_accept);
+		break;
+
 	case TCP_FASTOPEN_NO_COOKIE:
 		val = tp->fastopen_no_cookie;
 		break;
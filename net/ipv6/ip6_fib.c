@@ -1992,6 +1992,10 @@ static void fib6_del_route(struct fib6_table *table, struct fib6_node *fn,
 		fn = fib6_repair_tree(net, table, fn);
 	}
 
+	/* The per-cpu input route caches hold the route's dsts without a
+	 * reference, invalidate them before it can be released.
+	 */
+	fib6_new_sernum(net);
 	fib6_purge_rt(rt, fn, net);
 
 	if (!info->skip_notify_kernel) {
@@ -2271,6 +2275,12 @@ static void __fib6_clean_all(struct net *net,
 		}
 	}
 	rcu_read_unlock();
+
+	/* Walks without a new sernum still change routes (next hops going
+	 * down, MTU, prefsrc), invalidate the per-cpu input route caches.
+	 */
+	if (sernum == FIB6_NO_SERNUM_CHANGE)
+		fib6_new_sernum(net);
 }
 
 void fib6_clean_all(struct net *net, int (*func)(struct fib6_info *, void *),
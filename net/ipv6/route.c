@@ -40,6 +40,7 @@
 #include <linux/seq_file.h>
 #include <linux/nsproxy.h>
 #include <linux/slab.h>
+#include <linux/hash.h>
 #include <linux/jhash.h>
 #include <linux/siphash.h>
 #include <net/net_namespace.h>
@@ -2567,6 +2568,96 @@ u32 rt6_multipath_hash(const struct net *net, const struct flowi6 *fl6,
 }
 
 /* Called with rcu held */
+/* Per-cpu cache of input route lookups, net.ipv6.route.pcpu_cache.
+ *
+ * Entries hold the per-cpu rt6_info of the route that was found, without a
+ * reference, and are valid as long as the global fib6_sernum did not change:
+ * route insertion, deletion, exception creation and the fib6_clean_all()
+ * walks run on device and address events all bump it, before any route
+ * they affect can be released. They are also aged out after a second, so
+ * that next hop selection among routes of the same metric is not frozen.
+ *
+ * Only destinations whose lookup depends on nothing but the destination and
+ * the input device are cached: no custom rules or source routes in the
+ * netns, no multipath or expiring route, no exception.
+ */
+#define RT6_PCPU_CACHE_BITS	6
+
+struct rt6_pcpu_cache_entry {
+	struct in6_addr		daddr;
+	int			iif;
+	int			sernum;
+	unsigned long		expires;
+	struct rt6_info		*rt;
+};
+
+struct rt6_pcpu_cache {
+	struct rt6_pcpu_cache_entry	ent[1 << RT6_PCPU_CACHE_BITS];
+};
+
+static bool rt6_pcpu_cache_usable(const struct net *net)
+{
+	return READ_ONCE(net->ipv6.sysctl.ip6_rt_pcpu_cache) &&
+	       READ_ONCE(net->ipv6.rt6_pcpu_cache) && in_softirq() &&
+	       !fib6_has_custom_rules(net) && !fib6_routes_require_src(net);
+}
+
+static bool rt6_pcpu_cache_eligible(const struct rt6_info *rt)
+{
+	const struct fib6_info *from;
+
+	if (!(rt->rt6i_flags & RTF_PCPU))
+		return false;
+
+	from = rcu_dereference(rt->from);
+	return from && !from->nh && !from->fib6_nsiblings &&
+	       !(from->fib6_flags & RTF_EXPIRES);
+}
+
+static struct dst_entry *ip6_route_input_cached(struct net *net,
+						struct net_device *dev,
+						struct flowi6 *fl6,
+						const struct sk_buff *skb,
+						int flags)
+{
+	struct rt6_pcpu_cache_entry *ent;
+	struct rt6_pcpu_cache *cache;
+	struct dst_entry *dst;
+	int sernum;
+	u32 hash;
+
+	if (!rt6_pcpu_cache_usable(net))
+		return ip6_route_input_lookup(net, dev, fl6, skb, flags);
+
+	hash = hash_32(ipv6_addr_hash(&fl6->daddr) ^ fl6->flowi6_iif,
+		       RT6_PCPU_CACHE_BITS);
+	cache = this_cpu_ptr(net->ipv6.rt6_pcpu_cache);
+	ent = &cache->ent[hash];
+	sernum = atomic_read(&net->ipv6.fib6_sernum);
+
+	if (ent->rt && ent->sernum == sernum && ent->iif == fl6->flowi6_iif &&
+	    time_before(jiffies, ent->expires) &&
+	    ipv6_addr_equal(&ent->daddr, &fl6->daddr)) {
+		__NET_INC_STATS(net, LINUX_MIB_IP6RTPCPUCACHEHIT);
+		return &ent->rt->dst;
+	}
+
+	__NET_INC_STATS(net, LINUX_MIB_IP6RTPCPUCACHEMISS);
+
+	dst = ip6_route_input_lookup(net, dev, fl6, skb, flags);
+	if (!dst->error && rt6_pcpu_cache_eligible(dst_rt6_info(dst))) {
+		ent->daddr = fl6->daddr;
+		ent->iif = fl6->flowi6_iif;
+		ent->sernum = sernum;
+		ent->expires = jiffies + HZ;
+		ent->rt = dst_rt6_info(dst);
+	} else {
+		ent->rt = NULL;
+	}
+
+	return dst;
+}
+
 void ip6_route_input(struct sk_buff *skb)
 {
 	const struct ipv6hdr *iph = ipv6_hdr(skb);
@@ -2593,7 +2684,7 @@ void ip6_route_input(struct sk_buff *skb)
 	if (unlikely(fl6.flowi6_proto == IPPROTO_ICMPV6))
 		fl6.mp_hash = rt6_multipath_hash(net, &fl6, skb, flkeys);
 	skb_dst_drop(skb);
-	skb_dst_set_noref(skb, ip6_route_input_lookup(net, skb->dev,
+	skb_dst_set_noref(skb, ip6_route_input_cached(net, skb->dev,
 						      &fl6, skb, flags));
 }
 
@@ -6389,6 +6480,42 @@ static int ipv6_sysctl_rtcache_flush(const struct ctl_table *ctl, int write,
 	return 0;
 }
 
+static DEFINE_MUTEX(rt6_pcpu_cache_mutex);
+
+/* The cache is only allocated once enabled, and then kept until the netns
+ * goes away, so that the receive path never sees it disappear.
+ */
+static int ipv6_sysctl_rt_pcpu_cache(const struct ctl_table *ctl, int write,
+				     void *buffer, size_t *lenp, loff_t *ppos)
+{
+	struct net *net = (struct net *)ctl->extra1;
+	struct ctl_table tmp = *ctl;
+	struct rt6_pcpu_cache __percpu *cache;
+	int ret;
+
+	tmp.extra1 = SYSCTL_ZERO;
+	tmp.extra2 = SYSCTL_ONE;
+	if (!write)
+		return proc_dou8vec_minmax(&tmp, write, buffer, lenp, ppos);
+
+	mutex_lock(&rt6_pcpu_cache_mutex);
+	ret = proc_dou8vec_minmax(&tmp, write, buffer, lenp, ppos);
+	if (ret || !READ_ONCE(net->ipv6.sysctl.ip6_rt_pcpu_cache) ||
+	    net->ipv6.rt6_pcpu_cache)
+		goto out;
+
+	cache = alloc_percpu(struct rt6_pcpu_cache);
+	if (!cache) {
+		WRITE_ONCE(net->ipv6.sysctl.ip6_rt_pcpu_cache, 0);
+		ret = -ENOMEM;
+		goto out;
+	}
+	smp_store_release(&net->ipv6.rt6_pcpu_cache, cache);
+out:
+	mutex_unlock(&rt6_pcpu_cache_mutex);
+	return ret;
+}
+
 static struct ctl_table ipv6_route_table_template[] = {
 	{
 		.procname	=	"max_size",
@@ -6469,6 +6596,13 @@ static struct ctl_table ipv6_route_table_template[] = {
 		.extra1		=	SYSCTL_ZERO,
 		.extra2		=	SYSCTL_ONE,
 	},
+	{
+		.procname	=	"pcpu_cache",
+		.data		=	&init_net.ipv6.sysctl.ip6_rt_pcpu_cache,
+		.maxlen		=	sizeof(u8),
+		.mode		=	0644,
+		.proc_handler	=	ipv6_sysctl_rt_pcpu_cache,
+	},
 };
 
 struct ctl_table * __net_init ipv6_route_sysctl_init(struct net *net)
@@ -6492,6 +6626,8 @@ struct ctl_table * __net_init ipv6_route_sysctl_init(struct net *net)
 		table[8].data = &net->ipv6.sysctl.ip6_rt_min_advmss;
 		table[9].data = &net->ipv6.sysctl.ip6_rt_gc_min_interval;
 		table[10].data = &net->ipv6.sysctl.skip_notify_on_dev_down;
+		table[11].data = &net->ipv6.sysctl.ip6_rt_pcpu_cache;
+		table[11].extra1 = net;
 	}
 
 	return table;
@@ -6591,6 +6727,7 @@ static int __net_init ip6_route_net_init(struct net *net)
 
 static void __net_exit ip6_route_net_exit(struct net *net)
 {
+	free_percpu(net->ipv6.rt6_pcpu_cache);
 	kfree(net->ipv6.fib6_null_entry);
 	kfree(net->ipv6.ip6_null_entry);
 #ifdef CONFIG_IPV6_MULTIPLE_TABLES
@@ -245,6 +245,92 @@ static u32 hash_conntrack(const struct net *net,
 	return scale_hash(hash_conntrack_raw(tuple, zoneid, net));
 }
 
+/* Lower bounds of the expiry time of the conntracks hashed to each bucket,
+ * and to each group of NF_CT_GC_GROUP buckets, so that gc_worker() can skip
+ * chains in which nothing can have timed out yet.
+ *
+ * Bounds are lowered when a conntrack is inserted and when its timeout is
+ * shortened by __nf_ct_refresh_acct(). gc_worker() never sets them more than
+ * GC_SCAN_INTERVAL_CLAMP ahead, so timeout changes made behind our back are
+ * still seen within that time.
+ */
+#define NF_CT_GC_GROUP		64
+
+struct nf_ct_gc_hint {
+	unsigned int	size;
+	u32		*group;
+	u32		bucket[];
+};
+
+static struct nf_ct_gc_hint __rcu *nf_ct_gc_hint __read_mostly;
+
+static struct nf_ct_gc_hint *nf_ct_gc_hint_alloc(unsigned int size)
+{
+	unsigned int i, groups = DIV_ROUND_UP(size, NF_CT_GC_GROUP);
+	struct nf_ct_gc_hint *hint;
+	u32 now = nfct_time_stamp;
+
+	hint = kvmalloc(struct_size(hint, bucket, size) +
+			groups * sizeof(u32), GFP_KERNEL);
+	if (!hint)
+		return NULL;
+
+	hint->size = size;
+	hint->group = &hint->bucket[size];
+	/* everything is due until gc_worker() had a look */
+	for (i = 0; i < size; i++)
+		hint->bucket[i] = now;
+	for (i = 0; i < groups; i++)
+		hint->group[i] = now;
+	return hint;
+}
+
+static void nf_ct_gc_hint_lower(u32 *bound, u32 expires)
+{
+	u32 old = READ_ONCE(*bound);
+
+	do {
+		if ((s32)(old - expires) <= 0)
+			return;
+	} while (!try_cmpxchg(bound, &old, expires));
+}
+
+/* Must be called after the conntrack was hashed or got its new timeout. */
+static void nf_ct_gc_hint_add(unsigned int bucket, u32 expires)
+{
+	struct nf_ct_gc_hint *hint;
+
+	rcu_read_lock();
+	hint = rcu_dereference(nf_ct_gc_hint);
+	if (hint && bucket < hint->size) {
+		nf_ct_gc_hint_lower(&hint->bucket[bucket], expires);
+		nf_ct_gc_hint_lower(&hint->group[bucket / NF_CT_GC_GROUP],
+				    expires);
+	}
+	rcu_read_unlock();
+}
+
+static void nf_ct_gc_hint_add_ct(const struct nf_conn *ct, u32 expires)
+{
+	const struct net *net = nf_ct_net(ct);
+	struct nf_ct_gc_hint *hint;
+	int dir;
+
+	rcu_read_lock();
+	hint = rcu_dereference(nf_ct_gc_hint);
+	for (dir = 0; hint && dir < IP_CT_DIR_MAX; dir++) {
+		unsigned int zone_id = nf_ct_zone_id(nf_ct_zone(ct), dir);
+		unsigned int bucket;
+
+		bucket = __hash_conntrack(net, &ct->tuplehash[dir].tuple,
+					  zone_id, hint->size);
+		nf_ct_gc_hint_lower(&hint->bucket[bucket], expires);
+		nf_ct_gc_hint_lower(&hint->group[bucket / NF_CT_GC_GROUP],
+				    expires);
+	}
+	rcu_read_unlock();
+}
+
 static bool nf_ct_get_tuple_ports(const struct sk_buff *skb,
 				  unsigned int dataoff,
 				  struct nf_conntrack_tuple *tuple)
@@ -834,6 +920,9 @@ static void __nf_conntrack_hash_insert(struct nf_conn *ct,
 			   &nf_conntrack_hash[hash]);
 	hlist_nulls_add_head_rcu(&ct->tuplehash[IP_CT_DIR_REPLY].hnnode,
 			   &nf_conntrack_hash[reply_hash]);
+
+	nf_ct_gc_hint_add(hash, READ_ONCE(ct->timeout));
+	nf_ct_gc_hint_add(reply_hash, READ_ONCE(ct->timeout));
 }
 
 static bool nf_ct_ext_valid_pre(const struct nf_ct_ext *ext)
@@ -1121,6 +1210,7 @@ static int nf_ct_resolve_clash_harder(struct sk_buff *skb, u32 repl_idx)
 
 	hlist_nulls_add_head_rcu(&loser_ct->tuplehash[IP_CT_DIR_REPLY].hnnode,
 				 &nf_conntrack_hash[repl_idx]);
+	nf_ct_gc_hint_add(repl_idx, READ_ONCE(loser_ct->timeout));
 
 	NF_CT_STAT_INC(net, clash_resolve);
 	return NF_ACCEPT;
@@ -1496,13 +1586,39 @@ static bool gc_worker_can_early_drop(const struct nf_conn *ct)
 	return false;
 }
 
+static bool nf_ct_gc_hint_due(u32 bound, u32 now)
+{
+	return (s32)(bound - now) <= 0;
+}
+
+/* Recompute the bound of @group from its buckets, unless it got lowered
+ * since we read @old.
+ */
+static void nf_ct_gc_hint_end_group(struct nf_ct_gc_hint *hint,
+				    unsigned int group, u32 old)
+{
+	unsigned int i = group * NF_CT_GC_GROUP;
+	unsigned int end = min(i + NF_CT_GC_GROUP, hint->size);
+	u32 bound = READ_ONCE(hint->bucket[i]);
+
+	while (++i < end) {
+		u32 b = READ_ONCE(hint->bucket[i]);
+
+		if ((s32)(b - bound) < 0)
+			bound = b;
+	}
+	cmpxchg(&hint->group[group], old, bound);
+}
+
 static void gc_worker(struct work_struct *work)
 {
 	unsigned int i, hashsz, nf_conntrack_max95 = 0;
 	u32 end_time, start_time = nfct_time_stamp;
+	struct nf_ct_gc_hint *group_hint = NULL;
 	struct conntrack_gc_work *gc_work;
 	unsigned int expired_count = 0;
 	unsigned long next_run;
+	u32 group_bound = 0;
 	s32 delta_time;
 	long count;
 
@@ -1526,7 +1642,9 @@ static void gc_worker(struct work_struct *work)
 	do {
 		struct nf_conntrack_tuple_hash *h;
 		struct hlist_nulls_head *ct_hash;
+		struct nf_ct_gc_hint *hint;
 		struct hlist_nulls_node *n;
+		u32 bound = 0, min_expires;
 		struct nf_conn *tmp;
 
 		rcu_read_lock();
@@ -1537,10 +1655,38 @@ static void gc_worker(struct work_struct *work)
 			break;
 		}
 
+		hint = rcu_dereference(nf_ct_gc_hint);
+		if (hint && hint->size != hashsz)
+			hint = NULL;
+		if (hint != group_hint)
+			group_hint = NULL;
+
+		if (hint) {
+			/* Pairs with the cmpxchg() in nf_ct_gc_hint_lower(),
+			 * conntracks hashed before the bound was lowered are
+			 * visible in the chain.
+			 */
+			if (i % NF_CT_GC_GROUP == 0) {
+				group_bound = smp_load_acquire(&hint->group[i / NF_CT_GC_GROUP]);
+				if (!nf_conntrack_max95 &&
+				    !nf_ct_gc_hint_due(group_bound, start_time)) {
+					i = min(i + NF_CT_GC_GROUP, hashsz) - 1;
+					goto next_bucket;
+				}
+				group_hint = hint;
+			}
+			bound = smp_load_acquire(&hint->bucket[i]);
+			if (!nf_conntrack_max95 &&
+			    !nf_ct_gc_hint_due(bound, start_time))
+				goto next_bucket;
+		}
+		min_expires = start_time + GC_SCAN_INTERVAL_CLAMP;
+
 		hlist_nulls_for_each_entry_rcu(h, n, &ct_hash[i], hnnode) {
 			struct nf_conntrack_net *cnet;
 			struct net *net;
 			long expires;
+			u32 timeout;
 
 			tmp = nf_ct_tuplehash_to_ctrack(h);
 
@@ -1564,6 +1710,10 @@ static void gc_worker(struct work_struct *work)
 				continue;
 			}
 
+			timeout = READ_ONCE(tmp->timeout);
+			if ((s32)(timeout - min_expires) < 0)
+				min_expires = timeout;
+
 			expires = clamp(nf_ct_expires(tmp), GC_SCAN_INTERVAL_MIN, GC_SCAN_INTERVAL_CLAMP);
 			expires = (expires - (long)next_run) / ++count;
 			next_run += expires;
@@ -1600,6 +1750,15 @@ static void gc_worker(struct work_struct *work)
 		 * was moved to another chain.  But given gc is best-effort
 		 * we will just continue with next hash slot.
 		 */
+		if (hint)
+			cmpxchg(&hint->bucket[i], bound, min_expires);
+next_bucket:
+		if (group_hint && ((i + 1) % NF_CT_GC_GROUP == 0 ||
+				   i + 1 == hashsz)) {
+			nf_ct_gc_hint_end_group(group_hint, i / NF_CT_GC_GROUP,
+						group_bound);
+			group_hint = NULL;
+		}
 		rcu_read_unlock();
 		cond_resched();
 		i++;
@@ -2086,16 +2245,26 @@ void __nf_ct_refresh_acct(struct nf_conn *ct,
 			  u32 extra_jiffies,
 			  unsigned int bytes)
 {
+	u32 timeout;
+
 	/* Only update if this is not a fixed timeout */
 	if (test_bit(IPS_FIXED_TIMEOUT_BIT, &ct->status))
 		goto acct;
 
 	/* If not in hash table, timer will not be active yet */
-	if (nf_ct_is_confirmed(ct))
-		extra_jiffies += nfct_time_stamp;
+	if (!nf_ct_is_confirmed(ct)) {
+		if (READ_ONCE(ct->timeout) != extra_jiffies)
+			WRITE_ONCE(ct->timeout, extra_jiffies);
+		goto acct;
+	}
 
-	if (READ_ONCE(ct->timeout) != extra_jiffies)
+	extra_jiffies += nfct_time_stamp;
+	timeout = READ_ONCE(ct->timeout);
+	if (timeout != extra_jiffies) {
 		WRITE_ONCE(ct->timeout, extra_jiffies);
+		if ((s32)(extra_jiffies - timeout) < 0)
+			nf_ct_gc_hint_add_ct(ct, extra_jiffies);
+	}
 acct:
 	if (bytes)
 		nf_ct_acct_update(ct, CTINFO2DIR(ctinfo), bytes);
@@ -2451,6 +2620,7 @@ void nf_conntrack_cleanup_end(void)
 	RCU_INIT_POINTER(nf_ct_hook, NULL);
 	cancel_delayed_work_sync(&conntrack_gc_work.dwork);
 	kvfree(nf_conntrack_hash);
+	kvfree(rcu_dereference_protected(nf_ct_gc_hint, 1));
 
 	nf_conntrack_proto_fini();
 	nf_conntrack_helper_fini();
@@ -2531,6 +2701,7 @@ EXPORT_SYMBOL_GPL(nf_ct_alloc_hashtable);
 
 int nf_conntrack_hash_resize(unsigned int hashsize)
 {
+	struct nf_ct_gc_hint *hint, *old_hint;
 	int i, bucket;
 	unsigned int old_size;
 	struct hlist_nulls_head *hash, *old_hash;
@@ -2552,6 +2723,9 @@ int nf_conntrack_hash_resize(unsigned int hashsize)
 		return 0;
 	}
 
+	/* gc_worker() copes without hints, so failing here is not fatal */
+	hint = nf_ct_gc_hint_alloc(hashsize);
+
 	local_bh_disable();
 	nf_conntrack_all_lock();
 	write_seqcount_begin(&nf_conntrack_generation);
@@ -2578,9 +2752,12 @@ int nf_conntrack_hash_resize(unsigned int hashsize)
 		}
 	}
 	old_hash = nf_conntrack_hash;
+	old_hint = rcu_dereference_protected(nf_ct_gc_hint,
+					     lockdep_is_held(&nf_conntrack_mutex));
 
 	nf_conntrack_hash = hash;
 	nf_conntrack_htable_size = hashsize;
+	rcu_assign_pointer(nf_ct_gc_hint, hint);
 
 	write_seqcount_end(&nf_conntrack_generation);
 	nf_conntrack_all_unlock();
@@ -2590,6 +2767,7 @@ int nf_conntrack_hash_resize(unsigned int hashsize)
 
 	synchronize_net();
 	kvfree(old_hash);
+	kvfree(old_hint);
 	return 0;
 }
 
@@ -2649,6 +2827,8 @@ int nf_conntrack_init_start(void)
 	nf_conntrack_hash = nf_ct_alloc_hashtable(&nf_conntrack_htable_size, 1);
 	if (!nf_conntrack_hash)
 		return -ENOMEM;
+	RCU_INIT_POINTER(nf_ct_gc_hint,
+			 nf_ct_gc_hint_alloc(nf_conntrack_htable_size));
 
 	nf_conntrack_max = max_factor * nf_conntrack_htable_size;
 
@@ -2690,6 +2870,7 @@ int nf_conntrack_init_start(void)
 err_expect:
 	kmem_cache_destroy(nf_conntrack_cachep);
 err_cachep:
+	kvfree(rcu_dereference_protected(nf_ct_gc_hint, 1));
 	kvfree(nf_conntrack_hash);
 	return ret;
 }
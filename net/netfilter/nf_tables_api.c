@@ -4471,7 +4471,11 @@ static const struct nft_set_type *nft_set_types[] = {
 	&nft_set_bitmap_type,
 	&nft_set_rbtree_type,
 #if defined(CONFIG_X86_64) && !defined(CONFIG_UML)
+	&nft_set_pipapo_avx512_type,
 	&nft_set_pipapo_avx2_type,
+#endif
+#if defined(CONFIG_ARM64) && defined(CONFIG_KERNEL_MODE_NEON)
+	&nft_set_pipapo_neon_type,
 #endif
 	&nft_set_pipapo_type,
 };
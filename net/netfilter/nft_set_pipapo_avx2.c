@@ -1,6 +1,6 @@
 // SPDX-License-Identifier: GPL-2.0-only
 
-/* PIPAPO: PIle PAcket POlicies: AVX2 packet lookup routines
+/* PIPAPO: PIle PAcket POlicies: AVX2 and AVX-512 packet lookup routines
  *
  * Copyright (c) 2019-2020 Red Hat GmbH
  *
@@ -1246,3 +1246,286 @@ bool nft_pipapo_avx2_lookup(const struct net *net, const struct nft_set *set,
 
 	return ret >= 0;
 }
+
+/* AVX-512 variant: the same algorithm, operating on 512-bit ZMM registers, so
+ * that each step intersects two 256-bit bucket words at a time. Lookup table
+ * buckets are only aligned to NFT_PIPAPO_ALIGN (the size of a YMM register),
+ * so loads and stores can't assume 64-byte alignment: use unaligned moves,
+ * which carry no penalty on AVX-512 capable CPUs for aligned data anyway.
+ *
+ * Buckets have a size in longs that's a multiple of NFT_PIPAPO_LONGS_PER_M256,
+ * but not necessarily of NFT_PIPAPO_LONGS_PER_M512: an odd trailing 256-bit
+ * word is handled with the AVX2 operations defined above.
+ */
+#define NFT_PIPAPO_LONGS_PER_M512	(NFT_PIPAPO_LONGS_PER_M256 * 2)
+
+/* Maximum number of bit groups in a field, with 4-bit groups */
+#define NFT_PIPAPO_AVX512_MAX_GROUPS					\
+	(NFT_PIPAPO_MAX_BITS / NFT_PIPAPO_GROUP_BITS_LARGE_SET)
+
+#define NFT_PIPAPO_AVX512_LOAD(reg, loc)				\
+	asm volatile("vmovdqu64 %0, %%zmm" #reg : : "m" (loc))
+
+#define NFT_PIPAPO_AVX512_AND(dst, a, b)				\
+	asm volatile("vpandq %zmm" #a ", %zmm" #b ", %zmm" #dst)
+
+/* Jump to label if @reg is zero, using k1 as scratch mask register */
+#define NFT_PIPAPO_AVX512_NOMATCH_GOTO(reg, label)			\
+	asm goto("vptestmq %%zmm" #reg ", %%zmm" #reg ", %%k1;"	\
+		 "kortestw %%k1, %%k1;"					\
+		 "je %l[" #label "]" : : : : label)
+
+#define NFT_PIPAPO_AVX512_STORE(loc, reg)				\
+	asm volatile("vmovdqu64 %%zmm" #reg ", %0" : "=m" (loc) : : "memory")
+
+#define NFT_PIPAPO_AVX512_ZERO(reg)					\
+	asm volatile("vpxorq %zmm" #reg ", %zmm" #reg ", %zmm" #reg)
+
+/**
+ * nft_pipapo_avx512_buckets() - Select lookup table buckets for packet data
+ * @f:		Field, containing lookup table
+ * @pkt:	Packet data, pointer to input nftables register
+ * @b:		Storage for bucket pointers, one per bit group
+ *
+ * Instead of providing a specialised function for each group count, as the
+ * AVX2 implementation does, resolve bucket addresses for all the groups first,
+ * so that the matching loop only needs to walk an array of pointers.
+ */
+static void nft_pipapo_avx512_buckets(const struct nft_pipapo_field *f,
+				      const u8 *pkt, const unsigned long **b)
+{
+	const unsigned long *lt = NFT_PIPAPO_LT_ALIGN(f->lt);
+	unsigned long bsize = f->bsize;
+	int g;
+
+	for (g = 0; g < f->groups; g++) {
+		u8 v;
+
+		if (likely(f->bb == 8))
+			v = pkt[g];
+		else if (g % 2)
+			v = pkt[g / 2] & 0xf;
+		else
+			v = pkt[g / 2] >> 4;
+		NFT_PIPAPO_GROUP_BITS_ARE_8_OR_4;
+
+		b[g] = lt + (g * NFT_PIPAPO_BUCKETS(f->bb) + v) * bsize;
+	}
+}
+
+/**
+ * nft_pipapo_avx512_lookup_field() - AVX-512-based lookup for a single field
+ * @map:	Previous match result, used as initial bitmap
+ * @fill:	Destination bitmap to be filled with current match result
+ * @f:		Field, containing lookup and mapping tables
+ * @offset:	Ignore buckets before the given index, no bits are filled there
+ * @pkt:	Packet data, pointer to input nftables register
+ * @first:	If this is the first field, don't source previous result
+ * @last:	Last field: stop at the first match and return bit index
+ *
+ * See nft_pipapo_avx2_lookup_4b_2(). Here, the intersection of all the buckets
+ * selected for a 512-bit portion of the bitmap is accumulated in zmm0, and
+ * nft_pipapo_avx2_refill() is then called for both halves of it.
+ *
+ * Return: -1 on no match, rule index of match if @last, otherwise first long
+ * word index to be checked next (i.e. first filled word).
+ */
+static int nft_pipapo_avx512_lookup_field(unsigned long *map,
+					  unsigned long *fill,
+					  const struct nft_pipapo_field *f,
+					  int offset, const u8 *pkt,
+					  bool first, bool last)
+{
+	const unsigned long *b[NFT_PIPAPO_AVX512_MAX_GROUPS];
+	unsigned long bsize = f->bsize;
+	int i, g, ret = -1, r;
+
+	nft_pipapo_avx512_buckets(f, pkt, b);
+
+	for (i = offset * NFT_PIPAPO_LONGS_PER_M256; i < bsize;) {
+		if (bsize - i < NFT_PIPAPO_LONGS_PER_M512)
+			goto tail;
+
+		if (first) {
+			NFT_PIPAPO_AVX512_LOAD(0, b[0][i]);
+		} else {
+			NFT_PIPAPO_AVX512_LOAD(0, map[i]);
+			NFT_PIPAPO_AVX512_NOMATCH_GOTO(0, nothing);
+			NFT_PIPAPO_AVX512_LOAD(1, b[0][i]);
+			NFT_PIPAPO_AVX512_AND(0, 0, 1);
+		}
+
+		for (g = 1; g < f->groups; g++) {
+			NFT_PIPAPO_AVX512_LOAD(1, b[g][i]);
+			NFT_PIPAPO_AVX512_AND(0, 0, 1);
+		}
+
+		NFT_PIPAPO_AVX512_NOMATCH_GOTO(0, nomatch);
+		NFT_PIPAPO_AVX512_STORE(map[i], 0);
+
+		r = nft_pipapo_avx2_refill(i, &map[i], fill, f->mt, last);
+		if (last && r >= 0)
+			return r;
+		if (r != -1 && ret == -1)
+			ret = r / XSAVE_YMM_SIZE;
+
+		r = nft_pipapo_avx2_refill(i + NFT_PIPAPO_LONGS_PER_M256,
+					   &map[i + NFT_PIPAPO_LONGS_PER_M256],
+					   fill, f->mt, last);
+		if (last)
+			return r;
+		if (r != -1 && ret == -1)
+			ret = r / XSAVE_YMM_SIZE;
+
+		i += NFT_PIPAPO_LONGS_PER_M512;
+		continue;
+nomatch:
+		NFT_PIPAPO_AVX512_STORE(map[i], 15);
+nothing:
+		i += NFT_PIPAPO_LONGS_PER_M512;
+		continue;
+
+tail:
+		/* Trailing 256-bit word: the upper halves of ZMM registers
+		 * are simply not used here.
+		 */
+		if (first) {
+			NFT_PIPAPO_AVX2_LOAD(0, b[0][i]);
+		} else {
+			NFT_PIPAPO_AVX2_LOAD(0, map[i]);
+			NFT_PIPAPO_AVX2_NOMATCH_GOTO(0, tail_nothing);
+			NFT_PIPAPO_AVX2_LOAD(1, b[0][i]);
+			NFT_PIPAPO_AVX2_AND(0, 0, 1);
+		}
+
+		for (g = 1; g < f->groups; g++) {
+			NFT_PIPAPO_AVX2_LOAD(1, b[g][i]);
+			NFT_PIPAPO_AVX2_AND(0, 0, 1);
+		}
+
+		NFT_PIPAPO_AVX2_NOMATCH_GOTO(0, tail_nomatch);
+		NFT_PIPAPO_AVX2_STORE(map[i], 0);
+
+		r = nft_pipapo_avx2_refill(i, &map[i], fill, f->mt, last);
+		if (last)
+			return r;
+		if (r != -1 && ret == -1)
+			ret = r / XSAVE_YMM_SIZE;
+
+		break;
+tail_nomatch:
+		NFT_PIPAPO_AVX2_STORE(map[i], 15);
+tail_nothing:
+		break;
+	}
+
+	return ret;
+}
+
+/**
+ * nft_pipapo_avx512_estimate() - Set size, space and lookup complexity
+ * @desc:	Set description, element count and field description used
+ * @features:	Flags: NFT_SET_INTERVAL needs to be there
+ * @est:	Storage for estimation data
+ *
+ * This set type is listed before the AVX2 one, so that, with identical
+ * estimates, it's preferred whenever AVX-512 is available.
+ *
+ * Return: true if set is compatible and AVX-512 available, false otherwise.
+ */
+bool nft_pipapo_avx512_estimate(const struct nft_set_desc *desc, u32 features,
+				struct nft_set_estimate *est)
+{
+	if (!boot_cpu_has(X86_FEATURE_AVX512F) ||
+	    !cpu_has_xfeatures(XFEATURE_MASK_SSE | XFEATURE_MASK_YMM |
+			       XFEATURE_MASK_AVX512, NULL))
+		return false;
+
+	return nft_pipapo_avx2_estimate(desc, features, est);
+}
+
+/**
+ * nft_pipapo_avx512_lookup() - Lookup function for AVX-512 implementation
+ * @net:	Network namespace
+ * @set:	nftables API set representation
+ * @key:	nftables API element representation containing key data
+ * @ext:	nftables API extension pointer, filled with matching reference
+ *
+ * See nft_pipapo_avx2_lookup(): this only differs in the implementation of
+ * field matching steps.
+ *
+ * Return: true on match, false otherwise.
+ */
+bool nft_pipapo_avx512_lookup(const struct net *net, const struct nft_set *set,
+			      const u32 *key, const struct nft_set_ext **ext)
+{
+	struct nft_pipapo *priv = nft_set_priv(set);
+	struct nft_pipapo_scratch *scratch;
+	u8 genmask = nft_genmask_cur(net);
+	const struct nft_pipapo_match *m;
+	const struct nft_pipapo_field *f;
+	const u8 *rp = (const u8 *)key;
+	unsigned long *res, *fill;
+	bool map_index;
+	int i, ret = 0;
+
+	local_bh_disable();
+
+	if (unlikely(!irq_fpu_usable())) {
+		bool fallback_res = nft_pipapo_lookup(net, set, key, ext);
+
+		local_bh_enable();
+		return fallback_res;
+	}
+
+	m = rcu_dereference(priv->match);
+
+	kernel_fpu_begin_mask(0);
+
+	scratch = *raw_cpu_ptr(m->scratch);
+	if (unlikely(!scratch)) {
+		kernel_fpu_end();
+		local_bh_enable();
+		return false;
+	}
+
+	map_index = scratch->map_index;
+
+	res  = scratch->map + (map_index ? m->bsize_max : 0);
+	fill = scratch->map + (map_index ? 0 : m->bsize_max);
+
+	/* Clearing zmm15 also clears ymm15, used for AVX2 tail operations */
+	NFT_PIPAPO_AVX512_ZERO(15);
+
+next_match:
+	nft_pipapo_for_each_field(f, i, m) {
+		bool last = i == m->field_count - 1, first = !i;
+
+		ret = nft_pipapo_avx512_lookup_field(res, fill, f, ret, rp,
+						     first, last);
+		if (ret < 0)
+			goto out;
+
+		if (last) {
+			*ext = &f->mt[ret].e->ext;
+			if (unlikely(nft_set_elem_expired(*ext) ||
+				     !nft_set_elem_active(*ext, genmask))) {
+				ret = 0;
+				goto next_match;
+			}
+
+			goto out;
+		}
+
+		swap(res, fill);
+		rp += NFT_PIPAPO_GROUPS_PADDED_SIZE(f);
+	}
+
+out:
+	if (i % 2)
+		scratch->map_index = !map_index;
+	kernel_fpu_end();
+	local_bh_enable();
+
+	return ret >= 0;
+}
@@ -0,0 +1,184 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+/* PIPAPO: PIle PAcket POlicies: NEON packet lookup routines
+ *
+ * The algorithm is the same as nft_pipapo_lookup(), see DOC: Theory of
+ * Operation in nft_set_pipapo.c, but bucket intersections for a whole field
+ * are done in a single pass over the result map, using NEON registers as
+ * accumulators. The actual NEON code lives in nft_set_pipapo_neon_inner.c, as
+ * it needs different compiler flags, and this file must not use any FP/SIMD
+ * register outside kernel_neon_begin() and kernel_neon_end().
+ */
+
+#include <linux/kernel.h>
+#include <linux/init.h>
+#include <linux/module.h>
+#include <linux/netlink.h>
+#include <linux/netfilter.h>
+#include <linux/netfilter/nf_tables.h>
+#include <net/netfilter/nf_tables_core.h>
+#include <uapi/linux/netfilter/nf_tables.h>
+#include <linux/bitmap.h>
+#include <linux/bitops.h>
+
+#include <asm/neon.h>
+#include <asm/simd.h>
+
+#include "nft_set_pipapo_neon.h"
+#include "nft_set_pipapo.h"
+
+/* Maximum number of bit groups in a field, with 4-bit groups */
+#define NFT_PIPAPO_NEON_MAX_GROUPS					\
+	(NFT_PIPAPO_MAX_BITS / NFT_PIPAPO_GROUP_BITS_LARGE_SET)
+
+/**
+ * nft_pipapo_neon_buckets() - Select lookup table buckets for packet data
+ * @f:		Field, containing lookup table
+ * @pkt:	Packet data, pointer to input nftables register
+ * @b:		Storage for bucket pointers, one per bit group
+ */
+static void nft_pipapo_neon_buckets(const struct nft_pipapo_field *f,
+				    const u8 *pkt, const unsigned long **b)
+{
+	const unsigned long *lt = NFT_PIPAPO_LT_ALIGN(f->lt);
+	unsigned long bsize = f->bsize;
+	int g;
+
+	for (g = 0; g < f->groups; g++) {
+		u8 v;
+
+		if (likely(f->bb == 8))
+			v = pkt[g];
+		else if (g % 2)
+			v = pkt[g / 2] & 0xf;
+		else
+			v = pkt[g / 2] >> 4;
+		NFT_PIPAPO_GROUP_BITS_ARE_8_OR_4;
+
+		b[g] = lt + (g * NFT_PIPAPO_BUCKETS(f->bb) + v) * bsize;
+	}
+}
+
+/**
+ * nft_pipapo_neon_estimate() - Set size, space and lookup complexity
+ * @desc:	Set description, element count and field description used
+ * @features:	Flags: NFT_SET_INTERVAL needs to be there
+ * @est:	Storage for estimation data
+ *
+ * Return: true if set is compatible and NEON available, false otherwise.
+ */
+bool nft_pipapo_neon_estimate(const struct nft_set_desc *desc, u32 features,
+			      struct nft_set_estimate *est)
+{
+	if (!(features & NFT_SET_INTERVAL) ||
+	    desc->field_count < NFT_PIPAPO_MIN_FIELDS)
+		return false;
+
+	if (!cpu_has_neon())
+		return false;
+
+	est->size = pipapo_estimate_size(desc);
+	if (!est->size)
+		return false;
+
+	est->lookup = NFT_SET_CLASS_O_LOG_N;
+
+	est->space = NFT_SET_CLASS_O_N;
+
+	return true;
+}
+
+/**
+ * nft_pipapo_neon_lookup() - Lookup function for NEON implementation
+ * @net:	Network namespace
+ * @set:	nftables API set representation
+ * @key:	nftables API element representation containing key data
+ * @ext:	nftables API extension pointer, filled with matching reference
+ *
+ * Return: true on match, false otherwise.
+ */
+bool nft_pipapo_neon_lookup(const struct net *net, const struct nft_set *set,
+			    const u32 *key, const struct nft_set_ext **ext)
+{
+	const unsigned long *b[NFT_PIPAPO_NEON_MAX_GROUPS];
+	struct nft_pipapo *priv = nft_set_priv(set);
+	struct nft_pipapo_scratch *scratch;
+	unsigned long *res_map, *fill_map;
+	u8 genmask = nft_genmask_cur(net);
+	const struct nft_pipapo_match *m;
+	const struct nft_pipapo_field *f;
+	const u8 *rp = (const u8 *)key;
+	bool map_index, ret = false;
+	int i;
+
+	local_bh_disable();
+
+	if (unlikely(!may_use_simd())) {
+		ret = nft_pipapo_lookup(net, set, key, ext);
+
+		local_bh_enable();
+		return ret;
+	}
+
+	m = rcu_dereference(priv->match);
+
+	if (unlikely(!m || !*raw_cpu_ptr(m->scratch)))
+		goto out;
+
+	scratch = *raw_cpu_ptr(m->scratch);
+
+	map_index = scratch->map_index;
+
+	res_map  = scratch->map + (map_index ? m->bsize_max : 0);
+	fill_map = scratch->map + (map_index ? 0 : m->bsize_max);
+
+	pipapo_resmap_init(m, res_map);
+
+	kernel_neon_begin();
+
+	nft_pipapo_for_each_field(f, i, m) {
+		bool last = i == m->field_count - 1;
+		int r;
+
+		nft_pipapo_neon_buckets(f, rp, b);
+		if (!nft_pipapo_neon_and_buckets(res_map, b, f->groups,
+						 f->bsize)) {
+			/* Nothing left in res_map, and fill_map is clean */
+			scratch->map_index = map_index;
+			goto out_neon;
+		}
+
+		rp += f->groups / NFT_PIPAPO_GROUPS_PER_BYTE(f);
+
+next_match:
+		r = pipapo_refill(res_map, f->bsize, f->rules, fill_map, f->mt,
+				  last);
+		if (r < 0) {
+			scratch->map_index = map_index;
+			goto out_neon;
+		}
+
+		if (last) {
+			*ext = &f->mt[r].e->ext;
+			if (unlikely(nft_set_elem_expired(*ext) ||
+				     !nft_set_elem_active(*ext, genmask)))
+				goto next_match;
+
+			/* See nft_pipapo_lookup() */
+			scratch->map_index = map_index;
+			ret = true;
+			goto out_neon;
+		}
+
+		map_index = !map_index;
+		swap(res_map, fill_map);
+
+		rp += NFT_PIPAPO_GROUPS_PADDING(f);
+	}
+
+out_neon:
+	kernel_neon_end();
+out:
+	local_bh_enable();
+	return ret;
+}
@@ -0,0 +1,18 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#ifndef _NFT_SET_PIPAPO_NEON_H
+#define _NFT_SET_PIPAPO_NEON_H
+
+#if defined(CONFIG_ARM64) && defined(CONFIG_KERNEL_MODE_NEON)
+struct nft_set_desc;
+struct nft_set_estimate;
+
+bool nft_pipapo_neon_estimate(const struct nft_set_desc *desc, u32 features,
+			      struct nft_set_estimate *est);
+
+/* Built with FPU flags, call only between kernel_neon_begin() and _end() */
+bool nft_pipapo_neon_and_buckets(unsigned long *map,
+				 const unsigned long * const *b,
+				 unsigned int groups, unsigned int bsize);
+#endif /* defined(CONFIG_ARM64) && defined(CONFIG_KERNEL_MODE_NEON) */
+
+#endif /* _NFT_SET_PIPAPO_NEON_H */
@@ -0,0 +1,102 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+/* PIPAPO: PIle PAcket POlicies: NEON bucket intersection
+ *
+ * This file is built with FPU flags, so that NEON intrinsics can be used, and
+ * nothing in here may be called outside a kernel_neon_begin() and
+ * kernel_neon_end() pair: see nft_set_pipapo_neon.c for the glue code.
+ */
+
+#include <linux/types.h>
+#include <asm/neon-intrinsics.h>
+
+#include "nft_set_pipapo_neon.h"
+
+/* Non-zero if any bit is set in @v */
+static inline uint32_t nft_pipapo_neon_any(uint64x2_t v)
+{
+	return vmaxvq_u32(vreinterpretq_u32_u64(v));
+}
+
+/**
+ * nft_pipapo_neon_and_buckets() - Intersect result map with selected buckets
+ * @map:	Result map from previous field, updated in place
+ * @b:		Selected lookup table bucket, for each bit group
+ * @groups:	Number of bit groups in field
+ * @bsize:	Bucket size, in longs
+ *
+ * This is the equivalent of pipapo_and_field_buckets_4bit() and
+ * pipapo_and_field_buckets_8bit(), except that, instead of a complete pass on
+ * the result map for each group, a block of 512 bits is loaded once, all the
+ * buckets are intersected with it in registers, and stored back. Blocks that
+ * are already empty in @map are skipped altogether.
+ *
+ * Buckets are not aligned to any particular boundary, and their size is an
+ * arbitrary number of longs: remainders are handled with single 128-bit
+ * vectors, then with a scalar operation on the last word, if any.
+ *
+ * Return: true if any bit is left in @map, false otherwise.
+ */
+bool nft_pipapo_neon_and_buckets(unsigned long *map,
+				 const unsigned long * const *b,
+				 unsigned int groups, unsigned int bsize)
+{
+	uint64_t *dp = (uint64_t *)map;
+	uint32_t match = 0;
+	unsigned int i, g;
+
+	for (i = 0; i + 8 <= bsize; i += 8) {
+		uint64x2_t v0, v1, v2, v3;
+
+		v0 = vld1q_u64(dp + i + 0);
+		v1 = vld1q_u64(dp + i + 2);
+		v2 = vld1q_u64(dp + i + 4);
+		v3 = vld1q_u64(dp + i + 6);
+
+		if (!nft_pipapo_neon_any(vorrq_u64(vorrq_u64(v0, v1),
+						   vorrq_u64(v2, v3))))
+			continue;
+
+		for (g = 0; g < groups; g++) {
+			const uint64_t *bp = (const uint64_t *)b[g] + i;
+
+			v0 = vandq_u64(v0, vld1q_u64(bp + 0));
+			v1 = vandq_u64(v1, vld1q_u64(bp + 2));
+			v2 = vandq_u64(v2, vld1q_u64(bp + 4));
+			v3 = vandq_u64(v3, vld1q_u64(bp + 6));
+		}
+
+		vst1q_u64(dp + i + 0, v0);
+		vst1q_u64(dp + i + 2, v1);
+		vst1q_u64(dp + i + 4, v2);
+		vst1q_u64(dp + i + 6, v3);
+
+		match |= nft_pipapo_neon_any(vorrq_u64(vorrq_u64(v0, v1),
+						       vorrq_u64(v2, v3)));
+	}
+
+	for (; i + 2 <= bsize; i += 2) {
+		uint64x2_t v = vld1q_u64(dp + i);
+
+		if (!nft_pipapo_neon_any(v))
+			continue;
+
+		for (g = 0; g < groups; g++)
+			v = vandq_u64(v, vld1q_u64((const uint64_t *)b[g] + i));
+
+		vst1q_u64(dp + i, v);
+		match |= nft_pipapo_neon_any(v);
+	}
+
+	if (i < bsize && map[i]) {
+		unsigned long v = map[i];
+
+		for (g = 0; g < groups; g++)
+			v &= b[g][i];
+
+		map[i] = v;
+		match |= !!v;
+	}
+
+	return match;
+}
@@ -1318,6 +1318,7 @@ static int fq_dump_stats(struct Qdisc *sch, struct gnet_dump *d)
 static struct Qdisc_ops fq_qdisc_ops __read_mostly = {
 	.id		=	"fq",
 	.priv_size	=	sizeof(struct fq_sched_data),
+	.static_flags	=	TCQ_F_DEFER_ENQUEUE,
 
 	.enqueue	=	fq_enqueue,
 	.dequeue	=	fq_dequeue,
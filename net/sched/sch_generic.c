@@ -950,6 +950,7 @@ struct Qdisc *qdisc_alloc(struct netdev_queue *dev_queue,
 		goto errout;
 	__skb_queue_head_init(&sch->gso_skb);
 	__skb_queue_head_init(&sch->skb_bad_txq);
+	init_llist_head(&sch->defer_list);
 	gnet_stats_basic_sync_init(&sch->bstats);
 	lockdep_register_key(&sch->root_lock_key);
 	spin_lock_init(&sch->q.lock);
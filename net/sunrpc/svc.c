@@ -757,6 +757,9 @@ void svc_pool_wake_idle_thread(struct svc_pool *pool)
 	}
 	rcu_read_unlock();
 
+	/* Let the service know it could use more threads in this pool */
+	if (!test_bit(SP_STARVED, &pool->sp_flags))
+		set_bit(SP_STARVED, &pool->sp_flags);
 }
 EXPORT_SYMBOL_GPL(svc_pool_wake_idle_thread);
 
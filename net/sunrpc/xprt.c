@@ -1056,6 +1056,24 @@ xprt_request_rb_remove(struct rpc_xprt *xprt, struct rpc_rqst *req)
 	rb_erase(&req->rq_recv, &xprt->recv_queue);
 }
 
+/*
+ * Keep a smoothed (1/8 gain) estimate of the time it takes this
+ * transport to get a reply, for the multipath transport selection.
+ */
+static void xprt_update_srtt(struct rpc_xprt *xprt, ktime_t rtt)
+{
+	long sample = ktime_to_us(rtt);
+	unsigned long srtt = xprt->srtt_us;
+
+	if (sample <= 0)
+		sample = 1;
+	if (!srtt)
+		srtt = sample;
+	else
+		srtt += (sample - (long)srtt) / 8;
+	WRITE_ONCE(xprt->srtt_us, srtt ?: 1);
+}
+
 /**
  * xprt_lookup_rqst - find an RPC request corresponding to an XID
  * @xprt: transport on which the original request was transmitted
@@ -1071,6 +1089,8 @@ struct rpc_rqst *xprt_lookup_rqst(struct rpc_xprt *xprt, __be32 xid)
 	if (entry != NULL) {
 		trace_xprt_lookup_rqst(xprt, xid, 0);
 		entry->rq_rtt = ktime_sub(ktime_get(), entry->rq_xtime);
+		if (entry->rq_ntrans == 1)
+			xprt_update_srtt(xprt, entry->rq_rtt);
 		return entry;
 	}
 
@@ -427,29 +427,63 @@ struct rpc_xprt *__xprt_switch_find_next_entry_roundrobin(struct list_head *head
 	return xprt_switch_find_first_entry(head);
 }
 
+/*
+ * Average reply latency of the active transports that have one yet, which
+ * stands in for the latency of those that have not been measured.
+ */
+static unsigned long xprt_switch_avg_srtt(struct list_head *head)
+{
+	unsigned long sum = 0, srtt;
+	unsigned int n = 0;
+	struct rpc_xprt *pos;
+
+	list_for_each_entry_rcu(pos, head, xprt_switch) {
+		if (!xprt_is_active(pos))
+			continue;
+		srtt = READ_ONCE(pos->srtt_us);
+		if (srtt) {
+			sum += srtt;
+			n++;
+		}
+	}
+	return n ? sum / n : 1;
+}
+
 static
 struct rpc_xprt *xprt_switch_find_next_entry_roundrobin(struct rpc_xprt_switch *xps,
 		const struct rpc_xprt *cur)
 {
 	struct list_head *head = &xps->xps_xprt_list;
-	struct rpc_xprt *xprt;
-	unsigned int nactive;
-
-	for (;;) {
-		unsigned long xprt_queuelen, xps_queuelen;
+	struct rpc_xprt *xprt, *best = NULL;
+	u64 cost, best_cost = U64_MAX;
+	unsigned long avg_srtt;
+	unsigned int i, nactive;
+
+	nactive = max(READ_ONCE(xps->xps_nactive), 1U);
+	avg_srtt = xprt_switch_avg_srtt(head);
+
+	/*
+	 * Pick the transport a new request would wait the least on: the
+	 * tasks already queued on it, paced by how quickly it has been
+	 * getting replies, so that one slow connection does not hold back
+	 * the others.  Start after the cursor so that ties are broken in
+	 * round-robin order.
+	 */
+	for (i = 0; i < nactive; i++) {
+		unsigned long srtt;
 
 		xprt = __xprt_switch_find_next_entry_roundrobin(head, cur);
 		if (!xprt)
 			break;
-		xprt_queuelen = atomic_long_read(&xprt->queuelen);
-		xps_queuelen = atomic_long_read(&xps->xps_queuelen);
-		nactive = READ_ONCE(xps->xps_nactive);
-		/* Exit loop if xprt_queuelen <= average queue length */
-		if (xprt_queuelen * nactive <= xps_queuelen)
-			break;
+		srtt = READ_ONCE(xprt->srtt_us) ?: avg_srtt;
+		cost = (u64)(atomic_long_read(&xprt->queuelen) + 1) * srtt;
+		if (cost < best_cost) {
+			best_cost = cost;
+			best = xprt;
+		}
 		cur = xprt;
 	}
-	return xprt;
+	return best;
 }
 
 static
@@ -70,6 +70,7 @@ static void rpcrdma_sendctx_put_locked(struct rpcrdma_xprt *r_xprt,
 static int rpcrdma_reqs_setup(struct rpcrdma_xprt *r_xprt);
 static void rpcrdma_reqs_reset(struct rpcrdma_xprt *r_xprt);
 static void rpcrdma_reps_unmap(struct rpcrdma_xprt *r_xprt);
+static void rpcrdma_reps_prealloc(struct rpcrdma_xprt *r_xprt);
 static void rpcrdma_mrs_create(struct rpcrdma_xprt *r_xprt);
 static void rpcrdma_mrs_destroy(struct rpcrdma_xprt *r_xprt);
 static void rpcrdma_ep_get(struct rpcrdma_ep *ep);
@@ -512,6 +513,7 @@ int rpcrdma_xprt_connect(struct rpcrdma_xprt *r_xprt)
 	 * outstanding Receives.
 	 */
 	rpcrdma_ep_get(ep);
+	rpcrdma_reps_prealloc(r_xprt);
 	rpcrdma_post_recvs(r_xprt, 1);
 
 	rc = rdma_connect(ep->re_id, &ep->re_remote_cma);
@@ -1026,6 +1028,30 @@ static void rpcrdma_reps_unmap(struct rpcrdma_xprt *r_xprt)
 		rpcrdma_regbuf_dma_unmap(rep->rr_rdmabuf);
 }
 
+/* Fill the free list with enough mapped reps for a full credit window
+ * when the transport first connects, so that Receive refills after a
+ * burst of Replies do not have to allocate and map buffers. The reps
+ * are kept across reconnects and only need to be mapped again.
+ */
+static void rpcrdma_reps_prealloc(struct rpcrdma_xprt *r_xprt)
+{
+	struct rpcrdma_buffer *buf = &r_xprt->rx_buf;
+	struct rpcrdma_rep *rep;
+	unsigned int i;
+
+	if (!list_empty(&buf->rb_all_reps))
+		return;
+
+	for (i = 0; i < r_xprt->rx_ep->re_max_requests +
+			RPCRDMA_MAX_RECV_BATCH; i++) {
+		rep = rpcrdma_rep_create(r_xprt);
+		if (!rep)
+			break;
+		rpcrdma_regbuf_dma_map(r_xprt, rep->rr_rdmabuf);
+		rpcrdma_rep_put(buf, rep);
+	}
+}
+
 static void rpcrdma_reps_destroy(struct rpcrdma_buffer *buf)
 {
 	struct rpcrdma_rep *rep;
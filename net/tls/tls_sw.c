@@ -2727,6 +2727,33 @@ static void tls_finish_key_update(struct sock *sk, struct tls_context *tls_ctx)
 	ctx->saved_data_ready(sk);
 }
 
+/* Wrap the cipher in pcrypt, which spreads requests over the CPUs set in
+ * /sys/kernel/pcrypt/ and completes them in order. pcrypt is async, which
+ * lets tls_sw_recvmsg() submit all ready records before waiting for them;
+ * that's only done for TLS 1.2, the content type of TLS 1.3 records being
+ * known only after decryption. Fall back to the plain cipher otherwise.
+ */
+static struct crypto_aead *
+tls_alloc_parallel_aead(struct tls_context *ctx,
+			const struct tls_crypto_info *crypto_info,
+			const struct tls_cipher_desc *cipher_desc)
+{
+	char name[CRYPTO_MAX_ALG_NAME];
+	struct crypto_aead *aead;
+
+	if (crypto_info->version == TLS_1_2_VERSION &&
+	    snprintf(name, sizeof(name), "pcrypt(%s)",
+		     cipher_desc->cipher_name) < sizeof(name)) {
+		aead = crypto_alloc_aead(name, 0, 0);
+		if (!IS_ERR(aead))
+			return aead;
+	}
+
+	ctx->rx_parallel = 0;
+
+	return NULL;
+}
+
 int tls_set_sw_offload(struct sock *sk, int tx,
 		       struct tls_crypto_info *new_crypto_info)
 {
@@ -2788,7 +2815,12 @@ int tls_set_sw_offload(struct sock *sk, int tx,
 	rec_seq = crypto_info_rec_seq(src_crypto_info, cipher_desc);
 
 	if (!*aead) {
-		*aead = crypto_alloc_aead(cipher_desc->cipher_name, 0, 0);
+		if (!tx && ctx->rx_parallel)
+			*aead = tls_alloc_parallel_aead(ctx, src_crypto_info,
+							cipher_desc);
+		if (!*aead)
+			*aead = crypto_alloc_aead(cipher_desc->cipher_name,
+						  0, 0);
 		if (IS_ERR(*aead)) {
 			rc = PTR_ERR(*aead);
 			*aead = NULL;
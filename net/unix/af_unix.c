@@ -643,6 +643,7 @@ static void unix_sock_destructor(struct sock *sk)
 	struct unix_sock *u = unix_sk(sk);
 
 	skb_queue_purge_reason(&sk->sk_receive_queue, SKB_DROP_REASON_SOCKET_CLOSE);
+	skb_queue_purge(&sk->sk_error_queue);
 
 	DEBUG_NET_WARN_ON_ONCE(refcount_read(&sk->sk_wmem_alloc));
 	DEBUG_NET_WARN_ON_ONCE(!sk_unhashed(sk));
@@ -2235,9 +2236,28 @@ static int queue_oob(struct socket *sock, struct msghdr *msg, struct sock *other
 }
 #endif
 
+/* Attach the user pages backing the next @len bytes of @msg to @skb. They are
+ * charged to sk_wmem_alloc through skb->sk, as spliced pages are.
+ */
+static int unix_stream_zerocopy(struct sk_buff *skb, struct msghdr *msg,
+				int len, struct ubuf_info *uarg)
+{
+	int err;
+
+	err = __zerocopy_sg_from_iter(msg, NULL, skb, &msg->msg_iter, len,
+				      NULL);
+	if (err == -EFAULT || (err == -EMSGSIZE && !skb->len))
+		return err;
+
+	skb_zcopy_set(skb, uarg, NULL);
+
+	return skb->len;
+}
+
 static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 			       size_t len)
 {
+	struct ubuf_info *uarg = NULL;
 	struct sock *sk = sock->sk;
 	struct sk_buff *skb = NULL;
 	struct sock *other = NULL;
@@ -2275,11 +2295,26 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 	if (READ_ONCE(sk->sk_shutdown) & SEND_SHUTDOWN)
 		goto out_pipe;
 
+	if ((msg->msg_flags & MSG_ZEROCOPY) && len &&
+	    !(msg->msg_flags & MSG_SPLICE_PAGES) &&
+	    sock_flag(sk, SOCK_ZEROCOPY)) {
+		uarg = msg_zerocopy_realloc(sk, len, NULL, false);
+		if (!uarg) {
+			err = -ENOBUFS;
+			goto out_err;
+		}
+	}
+
 	while (sent < len) {
 		int size = len - sent;
 		int data_len;
 
-		if (unlikely(msg->msg_flags & MSG_SPLICE_PAGES)) {
+		if (unlikely(msg->msg_flags & MSG_SPLICE_PAGES) || uarg) {
+			/* Keep two messages in the pipe so it schedules better */
+			if (uarg)
+				size = min_t(int, size,
+					     (READ_ONCE(sk->sk_sndbuf) >> 1) - 64);
+
 			skb = sock_alloc_send_pskb(sk, 0, 0,
 						   msg->msg_flags & MSG_DONTWAIT,
 						   &err, 0);
@@ -2317,6 +2352,12 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 
 			size = err;
 			refcount_add(size, &sk->sk_wmem_alloc);
+		} else if (uarg) {
+			err = unix_stream_zerocopy(skb, msg, size, uarg);
+			if (err < 0)
+				goto out_free;
+
+			size = err;
 		} else {
 			skb_put(skb, size - data_len);
 			skb->data_len = data_len;
@@ -2349,6 +2390,7 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 	}
 #endif
 
+	net_zcopy_put(uarg);
 	scm_destroy(&scm);
 
 	return sent;
@@ -2362,6 +2404,11 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 out_free:
 	consume_skb(skb);
 out_err:
+	/* Nothing was queued: no completion notification for this call */
+	if (uarg && !sent)
+		net_zcopy_put_abort(uarg, true);
+	else
+		net_zcopy_put(uarg);
 	scm_destroy(&scm);
 	return sent ? : err;
 }
@@ -2742,6 +2789,14 @@ static int unix_stream_read_skb(struct sock *sk, skb_read_actor_t recv_actor)
 	}
 #endif
 
+	/* The skb can be redirected anywhere, don't let it keep MSG_ZEROCOPY
+	 * pages of the sender after its completion notification.
+	 */
+	if (skb_orphan_frags_rx(skb, GFP_ATOMIC)) {
+		kfree_skb(skb);
+		return -ENOMEM;
+	}
+
 	return recv_actor(sk, skb);
 }
 
@@ -2982,10 +3037,17 @@ static int unix_stream_recvmsg(struct socket *sock, struct msghdr *msg,
 		.flags = flags
 	};
 
-#ifdef CONFIG_BPF_SYSCALL
 	struct sock *sk = sock->sk;
+#ifdef CONFIG_BPF_SYSCALL
 	const struct proto *prot = READ_ONCE(sk->sk_prot);
+#endif
+
+	/* MSG_ZEROCOPY completion notifications */
+	if (unlikely(flags & MSG_ERRQUEUE))
+		return sock_recv_errqueue(sk, msg, size, SOL_SOCKET,
+					  SO_ZEROCOPY);
 
+#ifdef CONFIG_BPF_SYSCALL
 	if (prot != &unix_stream_proto)
 		return prot->recvmsg(sk, msg, size, flags, NULL);
 #endif
@@ -2996,6 +3058,15 @@ static int unix_stream_splice_actor(struct sk_buff *skb,
 				    int skip, int chunk,
 				    struct unix_stream_read_state *state)
 {
+	int err;
+
+	/* The pipe could hold on to MSG_ZEROCOPY pages past the completion
+	 * notification, hand it a copy instead.
+	 */
+	err = skb_orphan_frags_rx(skb, GFP_KERNEL);
+	if (err)
+		return err;
+
 	return skb_splice_bits(skb, state->socket->sk,
 			       UNIXCB(skb).consumed + skip,
 			       state->pipe, chunk, state->splice_flags);
@@ -3214,7 +3285,8 @@ static __poll_t unix_poll(struct file *file, struct socket *sock, poll_table *wa
 	state = READ_ONCE(sk->sk_state);
 
 	/* exceptional events? */
-	if (READ_ONCE(sk->sk_err))
+	if (READ_ONCE(sk->sk_err) ||
+	    !skb_queue_empty_lockless(&sk->sk_error_queue))
 		mask |= EPOLLERR;
 	if (shutdown == SHUTDOWN_MASK)
 		mask |= EPOLLHUP;
@@ -33,6 +33,8 @@
 #include "xsk.h"
 
 #define TX_BATCH_SIZE 32
+/* Copy mode skbs handed over to the driver at once */
+#define TX_BULK_SIZE 8
 #define MAX_PER_SOCKET_BUDGET (TX_BATCH_SIZE)
 
 void xsk_set_rx_need_wakeup(struct xsk_buff_pool *pool)
@@ -771,14 +773,93 @@ static struct sk_buff *xsk_build_skb(struct xdp_sock *xs,
 	return ERR_PTR(err);
 }
 
+/* Give the descriptors of the last skbs built back to user-space */
+static void xsk_cancel_skbs(struct xdp_sock *xs, struct sk_buff **skbs, int n)
+{
+	u32 descs = 0;
+	int i;
+
+	for (i = 0; i < n; i++) {
+		descs += xsk_get_num_desc(skbs[i]);
+		skbs[i]->destructor = sock_wfree;
+		/* Free skb without triggering the perf drop trace */
+		consume_skb(skbs[i]);
+	}
+
+	xskq_cons_cancel_n(xs->tx, descs);
+	xsk_cq_cancel_locked(xs->pool, descs);
+}
+
+static void xsk_drop_skbs(struct xdp_sock *xs, struct sk_buff **skbs, int n)
+{
+	int i;
+
+	/* SKBs completed but not sent */
+	for (i = 0; i < n; i++) {
+		dev_core_stats_tx_dropped_inc(xs->dev);
+		kfree_skb(skbs[i]);
+	}
+}
+
+/* Send the skbs built from the last descriptors consumed from the TX ring.
+ * Returns 0 if all of them were sent, or the error to report to user-space.
+ */
+static int xsk_generic_xmit_bulk(struct xdp_sock *xs, struct sk_buff **skbs,
+				 int n, bool *sent_frame)
+{
+	int i, sent, err = 0;
+
+	for (i = 0; i < n; i++) {
+		struct sk_buff *skb;
+		bool again = false;
+
+		skb = validate_xmit_skb_list(skbs[i], xs->dev, &again);
+		if (likely(skb == skbs[i]))
+			continue;
+
+		dev_core_stats_tx_dropped_inc(xs->dev);
+		kfree_skb_list(skb);
+		xsk_cancel_skbs(xs, skbs + i + 1, n - i - 1);
+		err = -EBUSY;
+		n = i;
+		break;
+	}
+
+	if (!n)
+		return err;
+
+	sent = __dev_direct_xmit_bulk(skbs, n, xs->queue_id);
+	if (sent < 0) {
+		xsk_drop_skbs(xs, skbs, n);
+		return -EBUSY;
+	}
+
+	if (sent)
+		*sent_frame = true;
+
+	if (sent == n)
+		return err;
+
+	/* The descriptors of the dropped skb come after the remaining ones */
+	if (err) {
+		xsk_drop_skbs(xs, skbs + sent, n - sent);
+		return err;
+	}
+
+	/* Tell user-space to retry the send */
+	xsk_cancel_skbs(xs, skbs + sent, n - sent);
+	return -EAGAIN;
+}
+
 static int __xsk_generic_xmit(struct sock *sk)
 {
+	struct sk_buff *skbs[TX_BULK_SIZE];
 	struct xdp_sock *xs = xdp_sk(sk);
 	u32 max_batch = TX_BATCH_SIZE;
 	bool sent_frame = false;
 	struct xdp_desc desc;
 	struct sk_buff *skb;
-	int err = 0;
+	int err = 0, n = 0;
 
 	mutex_lock(&xs->mutex);
 
@@ -791,12 +872,36 @@ static int __xsk_generic_xmit(struct sock *sk)
 	if (xs->queue_id >= xs->dev->real_num_tx_queues)
 		goto out;
 
-	while (xskq_cons_peek_desc(xs->tx, &desc, xs->pool)) {
+	for (;;) {
+		/* The descriptors of the skbs not sent yet may still need to
+		 * be given back with xskq_cons_cancel_n(). Send them before
+		 * peeking can publish the consumer index past them.
+		 */
+		if (n && !xskq_has_descs(xs->tx)) {
+			err = xsk_generic_xmit_bulk(xs, skbs, n, &sent_frame);
+			n = 0;
+			if (err)
+				goto out;
+		}
+
+		if (!xskq_cons_peek_desc(xs->tx, &desc, xs->pool))
+			break;
+
 		if (max_batch-- == 0) {
 			err = -EAGAIN;
 			goto out;
 		}
 
+		/* Same for multi-buffer packets, which consume descriptors
+		 * before they are complete.
+		 */
+		if (n && !xs->skb && xp_mb_desc(&desc)) {
+			err = xsk_generic_xmit_bulk(xs, skbs, n, &sent_frame);
+			n = 0;
+			if (err)
+				goto out;
+		}
+
 		/* This is the backpressure mechanism for the Tx path.
 		 * Reserve space in the completion queue and only proceed
 		 * if there is space in it. This avoids having to implement
@@ -821,25 +926,21 @@ static int __xsk_generic_xmit(struct sock *sk)
 			continue;
 		}
 
-		err = __dev_direct_xmit(skb, xs->queue_id);
-		if  (err == NETDEV_TX_BUSY) {
-			/* Tell user-space to retry the send */
-			xskq_cons_cancel_n(xs->tx, xsk_get_num_desc(skb));
-			xsk_consume_skb(skb);
-			err = -EAGAIN;
-			goto out;
+		xs->skb = NULL;
+		skbs[n++] = skb;
+		if (n == TX_BULK_SIZE) {
+			err = xsk_generic_xmit_bulk(xs, skbs, n, &sent_frame);
+			n = 0;
+			if (err)
+				goto out;
 		}
+	}
 
-		/* Ignore NET_XMIT_CN as packet might have been sent */
-		if (err == NET_XMIT_DROP) {
-			/* SKB completed but not sent */
-			err = -EBUSY;
-			xs->skb = NULL;
+	if (n) {
+		err = xsk_generic_xmit_bulk(xs, skbs, n, &sent_frame);
+		n = 0;
+		if (err)
 			goto out;
-		}
-
-		sent_frame = true;
-		xs->skb = NULL;
 	}
 
 	if (xskq_has_descs(xs->tx)) {
@@ -849,6 +950,13 @@ static int __xsk_generic_xmit(struct sock *sk)
 	}
 
 out:
+	if (n) {
+		int ret = xsk_generic_xmit_bulk(xs, skbs, n, &sent_frame);
+
+		if (!err)
+			err = ret;
+	}
+
 	if (sent_frame)
 		if (xsk_tx_writeable(xs))
 			sk->sk_write_space(sk);
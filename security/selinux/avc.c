@@ -20,6 +20,9 @@
 #include <linux/skbuff.h>
 #include <linux/percpu.h>
 #include <linux/list.h>
+#include <linux/jhash.h>
+#include <linux/log2.h>
+#include <linux/vmalloc.h>
 #include <net/sock.h>
 #include <linux/un.h>
 #include <net/af_unix.h>
@@ -35,6 +38,7 @@
 #include <trace/events/avc.h>
 
 #define AVC_CACHE_SLOTS			512
+#define AVC_CACHE_MAX_SLOTS		(1 << 20)
 #define AVC_DEF_CACHE_THRESHOLD		512
 #define AVC_CACHE_RECLAIM		16
 
@@ -69,8 +73,9 @@ struct avc_xperms_node {
 };
 
 struct avc_cache {
-	struct hlist_head	slots[AVC_CACHE_SLOTS]; /* head for avc_node->list */
-	spinlock_t		slots_lock[AVC_CACHE_SLOTS]; /* lock for writes */
+	struct hlist_head	*slots; /* head for avc_node->list */
+	spinlock_t		*slots_lock; /* lock for writes */
+	unsigned int		nr_slots; /* power of two */
 	atomic_t		lru_hint;	/* LRU hint for reclaim scan */
 	atomic_t		active_nodes;
 	u32			latest_notif;	/* latest revocation notification */
@@ -93,12 +98,40 @@ struct selinux_avc {
 
 static struct selinux_avc selinux_avc;
 
-void selinux_avc_init(void)
+/*
+ * Number of hash slots, set with selinux_avc_slots= for systems that raise
+ * avc/cache_threshold far beyond its default, e.g. to hold the decisions
+ * for many distinct MCS categories. Rounded up to a power of two.
+ */
+static unsigned int avc_cache_slots __initdata = AVC_CACHE_SLOTS;
+
+static int __init avc_cache_slots_setup(char *str)
 {
+	unsigned int slots;
+
+	if (!kstrtouint(str, 0, &slots) && slots)
+		avc_cache_slots = roundup_pow_of_two(min(slots,
+						(unsigned int)AVC_CACHE_MAX_SLOTS));
+	return 1;
+}
+__setup("selinux_avc_slots=", avc_cache_slots_setup);
+
+void __init selinux_avc_init(void)
+{
+	struct avc_cache *cache = &selinux_avc.avc_cache;
 	int i;
 
 	selinux_avc.avc_cache_threshold = AVC_DEF_CACHE_THRESHOLD;
-	for (i = 0; i < AVC_CACHE_SLOTS; i++) {
+	cache->nr_slots = avc_cache_slots;
+	cache->slots = kvcalloc(cache->nr_slots, sizeof(*cache->slots),
+				GFP_KERNEL);
+	cache->slots_lock = kvcalloc(cache->nr_slots,
+				     sizeof(*cache->slots_lock), GFP_KERNEL);
+	if (!cache->slots || !cache->slots_lock)
+		panic("SELinux: failed to allocate %u AVC slots\n",
+		      cache->nr_slots);
+
+	for (i = 0; i < cache->nr_slots; i++) {
 		INIT_HLIST_HEAD(&selinux_avc.avc_cache.slots[i]);
 		spin_lock_init(&selinux_avc.avc_cache.slots_lock[i]);
 	}
@@ -122,9 +155,14 @@ static struct kmem_cache *avc_xperms_data_cachep __ro_after_init;
 static struct kmem_cache *avc_xperms_decision_cachep __ro_after_init;
 static struct kmem_cache *avc_xperms_cachep __ro_after_init;
 
+/*
+ * SIDs are handed out sequentially, so with many similar contexts (e.g. one
+ * per MCS category pair) a simple xor of them piles up in a few slots.
+ */
 static inline u32 avc_hash(u32 ssid, u32 tsid, u16 tclass)
 {
-	return (ssid ^ (tsid<<2) ^ (tclass<<4)) & (AVC_CACHE_SLOTS - 1);
+	return jhash_3words(ssid, tsid, tclass, 0) &
+	       (selinux_avc.avc_cache.nr_slots - 1);
 }
 
 /**
@@ -150,7 +188,7 @@ int avc_get_hash_stats(char *page)
 
 	slots_used = 0;
 	max_chain_len = 0;
-	for (i = 0; i < AVC_CACHE_SLOTS; i++) {
+	for (i = 0; i < selinux_avc.avc_cache.nr_slots; i++) {
 		head = &selinux_avc.avc_cache.slots[i];
 		if (!hlist_empty(head)) {
 			slots_used++;
@@ -167,7 +205,7 @@ int avc_get_hash_stats(char *page)
 	return scnprintf(page, PAGE_SIZE, "entries: %d\nbuckets used: %d/%d\n"
 			 "longest chain: %d\n",
 			 atomic_read(&selinux_avc.avc_cache.active_nodes),
-			 slots_used, AVC_CACHE_SLOTS, max_chain_len);
+			 slots_used, selinux_avc.avc_cache.nr_slots, max_chain_len);
 }
 
 /*
@@ -464,9 +502,9 @@ static inline int avc_reclaim_node(void)
 	struct hlist_head *head;
 	spinlock_t *lock;
 
-	for (try = 0, ecx = 0; try < AVC_CACHE_SLOTS; try++) {
+	for (try = 0, ecx = 0; try < selinux_avc.avc_cache.nr_slots; try++) {
 		hvalue = atomic_inc_return(&selinux_avc.avc_cache.lru_hint) &
-			(AVC_CACHE_SLOTS - 1);
+			(selinux_avc.avc_cache.nr_slots - 1);
 		head = &selinux_avc.avc_cache.slots[hvalue];
 		lock = &selinux_avc.avc_cache.slots_lock[hvalue];
 
@@ -930,7 +968,7 @@ static void avc_flush(void)
 	unsigned long flag;
 	int i;
 
-	for (i = 0; i < AVC_CACHE_SLOTS; i++) {
+	for (i = 0; i < selinux_avc.avc_cache.nr_slots; i++) {
 		head = &selinux_avc.avc_cache.slots[i];
 		lock = &selinux_avc.avc_cache.slots_lock[i];
 
@@ -74,6 +74,22 @@ enum netdev_qstats_scope {
 	NETDEV_QSTATS_SCOPE_QUEUE = 1,
 };
 
+/**
+ * enum netdev_napi_threaded
+ * @NETDEV_NAPI_THREADED_DISABLED: The NAPI instance is polled from softirq
+ *   context.
+ * @NETDEV_NAPI_THREADED_ENABLED: The NAPI instance is polled by its own
+ *   kernel thread.
+ * @NETDEV_NAPI_THREADED_ADAPTIVE: The NAPI instance is polled from softirq
+ *   context and moved to its kernel thread while it keeps exhausting its
+ *   budget, then back once the load drops.
+ */
+enum netdev_napi_threaded {
+	NETDEV_NAPI_THREADED_DISABLED,
+	NETDEV_NAPI_THREADED_ENABLED,
+	NETDEV_NAPI_THREADED_ADAPTIVE,
+};
+
 enum {
 	NETDEV_A_DEV_IFINDEX = 1,
 	NETDEV_A_DEV_PAD,
@@ -125,6 +141,15 @@ enum {
 	NETDEV_A_NAPI_DEFER_HARD_IRQS,
 	NETDEV_A_NAPI_GRO_FLUSH_TIMEOUT,
 	NETDEV_A_NAPI_IRQ_SUSPEND_TIMEOUT,
+	NETDEV_A_NAPI_GRO_BUCKETS,
+	NETDEV_A_NAPI_GRO_FLOW_LIMIT,
+	NETDEV_A_NAPI_GRO_PACKETS,
+	NETDEV_A_NAPI_GRO_MERGED,
+	NETDEV_A_NAPI_GRO_EVICTED,
+	NETDEV_A_NAPI_GRO_OVERLIMIT,
+	NETDEV_A_NAPI_THREADED,
+	NETDEV_A_NAPI_POLL_TIME_SOFTIRQ,
+	NETDEV_A_NAPI_POLL_TIME_THREADED,
 
 	__NETDEV_A_NAPI_MAX,
 	NETDEV_A_NAPI_MAX = (__NETDEV_A_NAPI_MAX - 1)
@@ -183,6 +208,8 @@ enum {
 	NETDEV_A_DMABUF_QUEUES,
 	NETDEV_A_DMABUF_FD,
 	NETDEV_A_DMABUF_ID,
+	NETDEV_A_DMABUF_TX_BYTES,
+	NETDEV_A_DMABUF_TX_INFLIGHT,
 
 	__NETDEV_A_DMABUF_MAX,
 	NETDEV_A_DMABUF_MAX = (__NETDEV_A_DMABUF_MAX - 1)
@@ -203,6 +230,8 @@ enum {
 	NETDEV_CMD_QSTATS_GET,
 	NETDEV_CMD_BIND_RX,
 	NETDEV_CMD_NAPI_SET,
+	NETDEV_CMD_BIND_TX,
+	NETDEV_CMD_DMABUF_GET,
 
 	__NETDEV_CMD_MAX,
 	NETDEV_CMD_MAX = (__NETDEV_CMD_MAX - 1)
@@ -33,6 +33,8 @@
 
 static bool done = false;
 static int futex_flag = 0;
+static unsigned int futex2_flags;
+static unsigned int futex_stride = 1;
 
 struct timeval bench__start, bench__end, bench__runtime;
 static struct mutex thread_lock;
@@ -59,6 +61,7 @@ static const struct option options[] = {
 	OPT_BOOLEAN( 's', "silent",  &params.silent, "Silent mode: do not display data/details"),
 	OPT_BOOLEAN( 'S', "shared",  &params.fshared, "Use shared futexes instead of private ones"),
 	OPT_BOOLEAN( 'm', "mlockall", &params.mlockall, "Lock all current and future memory"),
+	OPT_BOOLEAN( 'n', "numa",    &params.numa, "Use FUTEX2_NUMA futexes, queued on the node of their first user"),
 	OPT_END()
 };
 
@@ -89,7 +92,11 @@ static void *workerfn(void *arg)
 			 * such as internal waitqueue handling, thus enlarging
 			 * the critical region protected by hb->lock.
 			 */
-			ret = futex_wait(&w->futex[i], 1234, NULL, futex_flag);
+			if (params.numa)
+				ret = futex2_wait(&w->futex[i * futex_stride],
+						  1234, futex2_flags, NULL);
+			else
+				ret = futex_wait(&w->futex[i], 1234, NULL, futex_flag);
 			if (!params.silent &&
 			    (!ret || errno != EAGAIN || errno != EWOULDBLOCK))
 				warn("Non-expected futex return call");
@@ -162,8 +169,17 @@ int bench_futex_hash(int argc, const char **argv)
 	if (!params.fshared)
 		futex_flag = FUTEX_PRIVATE_FLAG;
 
-	printf("Run summary [PID %d]: %d threads, each operating on %d [%s] futexes for %d secs.\n\n",
-	       getpid(), params.nthreads, params.nfutexes, params.fshared ? "shared":"private", params.runtime);
+	if (params.numa) {
+		/* Each futex is followed by the node it is queued on */
+		futex_stride = 2;
+		futex2_flags = FUTEX2_SIZE_U32 | FUTEX2_NUMA;
+		if (!params.fshared)
+			futex2_flags |= FUTEX2_PRIVATE;
+	}
+
+	printf("Run summary [PID %d]: %d threads, each operating on %d [%s%s] futexes for %d secs.\n\n",
+	       getpid(), params.nthreads, params.nfutexes, params.fshared ? "shared":"private",
+	       params.numa ? " numa" : "", params.runtime);
 
 	init_stats(&throughput_stats);
 	mutex_init(&thread_lock);
@@ -181,10 +197,18 @@ int bench_futex_hash(int argc, const char **argv)
 
 	for (i = 0; i < params.nthreads; i++) {
 		worker[i].tid = i;
-		worker[i].futex = calloc(params.nfutexes, sizeof(*worker[i].futex));
+		worker[i].futex = calloc(params.nfutexes * futex_stride,
+					 sizeof(*worker[i].futex));
 		if (!worker[i].futex)
 			goto errmem;
 
+		if (params.numa) {
+			unsigned int j;
+
+			for (j = 0; j < params.nfutexes; j++)
+				worker[i].futex[j * futex_stride + 1] = FUTEX_NO_NODE;
+		}
+
 		CPU_ZERO_S(size, cpuset);
 
 		CPU_SET_S(perf_cpu_map__cpu(cpu, i % perf_cpu_map__nr(cpu)).cpu, size, cpuset);
@@ -235,7 +259,7 @@ int bench_futex_hash(int argc, const char **argv)
 			else
 				printf("[thread %2d] futexes: %p ... %p [ %ld ops/sec ]\n",
 				       worker[i].tid, &worker[i].futex[0],
-				       &worker[i].futex[params.nfutexes-1], t);
+				       &worker[i].futex[(params.nfutexes-1) * futex_stride], t);
 		}
 
 		zfree(&worker[i].futex);
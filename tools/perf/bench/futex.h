@@ -11,6 +11,7 @@
 #include <unistd.h>
 #include <sys/syscall.h>
 #include <sys/types.h>
+#include <time.h>
 #include <linux/futex.h>
 
 struct bench_futex_parameters {
@@ -20,6 +21,7 @@ struct bench_futex_parameters {
 	bool multi; /* lock-pi */
 	bool pi; /* requeue-pi */
 	bool broadcast; /* requeue */
+	bool numa; /* hash */
 	unsigned int runtime; /* seconds*/
 	unsigned int nthreads;
 	unsigned int nfutexes;
@@ -69,6 +71,31 @@ futex_wait(u_int32_t *uaddr, u_int32_t val, struct timespec *timeout, int opflag
 	return futex_syscall(uaddr, FUTEX_WAIT, val, timeout, NULL, 0, opflags);
 }
 
+#ifndef __NR_futex_wait
+# define __NR_futex_wait 455
+#endif
+
+#ifndef FUTEX2_NUMA
+# define FUTEX2_NUMA 0x04
+#endif
+
+#ifndef FUTEX_NO_NODE
+# define FUTEX_NO_NODE (-1)
+#endif
+
+/**
+ * futex2_wait() - block on uaddr with futex2 flags, such as FUTEX2_NUMA
+ * @flags:	FUTEX2_* flags, size included
+ * @timeout:	absolute CLOCK_MONOTONIC timeout
+ */
+static inline int
+futex2_wait(volatile void *uaddr, unsigned long val, unsigned int flags,
+	    struct timespec *timeout)
+{
+	return syscall(__NR_futex_wait, uaddr, val, FUTEX_BITSET_MATCH_ANY,
+		       flags, timeout, CLOCK_MONOTONIC);
+}
+
 /**
  * futex_wake() - wake one or more tasks blocked on uaddr
  * @nr_wake:	wake up to this many tasks
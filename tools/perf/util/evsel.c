@@ -1386,6 +1386,12 @@ void evsel__config(struct evsel *evsel, struct record_opts *opts,
 	if (target__has_cpu(&opts->target) || opts->sample_cpu)
 		evsel__set_sample_bit(evsel, CPU);
 
+	if (opts->callchain_delta && !opts->target.per_thread &&
+	    (attr->sample_type & PERF_SAMPLE_CALLCHAIN)) {
+		attr->callchain_delta = 1;
+		evsel__set_sample_bit(evsel, CPU);
+	}
+
 	/*
 	 * When the user explicitly disabled time don't force it here.
 	 */
@@ -3072,10 +3078,25 @@ int evsel__parse_sample(struct evsel *evsel, union perf_event *event,
 		const u64 max_callchain_nr = UINT64_MAX / sizeof(u64);
 
 		OVERFLOW_CHECK_u64(array);
-		data->callchain = (struct ip_callchain *)array++;
-		if (data->callchain->nr > max_callchain_nr)
-			return -EFAULT;
-		sz = data->callchain->nr * sizeof(u64);
+		if (evsel->core.attr.callchain_delta) {
+			static struct ip_callchain no_callchain;
+			u64 nr, shared;
+
+			/* Expanded by perf_session__expand_callchain() */
+			data->callchain = &no_callchain;
+			data->callchain_delta = (u64 *)array;
+			nr = *array++;
+			OVERFLOW_CHECK_u64(array);
+			shared = *array++ & ~PERF_CALLCHAIN_SHARED_NOREF;
+			if (nr > max_callchain_nr || shared > nr)
+				return -EFAULT;
+			sz = (nr - shared) * sizeof(u64);
+		} else {
+			data->callchain = (struct ip_callchain *)array++;
+			if (data->callchain->nr > max_callchain_nr)
+				return -EFAULT;
+			sz = data->callchain->nr * sizeof(u64);
+		}
 		OVERFLOW_CHECK(array, sz, max_size);
 		array = (void *)array + sz;
 	}
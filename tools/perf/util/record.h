@@ -27,6 +27,7 @@ struct record_opts {
 	bool	      sample_time;
 	bool	      sample_time_set;
 	bool	      sample_cpu;
+	bool	      callchain_delta;
 	bool	      sample_identifier;
 	bool	      period;
 	bool	      period_set;
@@ -112,6 +112,7 @@ struct perf_sample {
 	char insn[MAX_INSN];
 	void *raw_data;
 	struct ip_callchain *callchain;
+	u64 *callchain_delta;	/* attr.callchain_delta: { nr, shared, ips[] } */
 	struct branch_stack *branch_stack;
 	u64 *branch_stack_cntr;
 	struct regs_dump  user_regs;
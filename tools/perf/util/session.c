@@ -257,6 +257,10 @@ void perf_session__delete(struct perf_session *session)
 #ifdef HAVE_LIBTRACEEVENT
 	trace_event__cleanup(&session->tevent);
 #endif
+	for (u32 i = 0; i < session->nr_callchain_refs; i++)
+		free(session->callchain_refs[i]);
+	free(session->callchain_refs);
+	free(session->callchain_scratch);
 	free(session);
 }
 
@@ -1344,6 +1348,66 @@ static int machines__deliver_event(struct machines *machines,
 	}
 }
 
+/*
+ * Rebuild the callchain of an attr.callchain_delta sample: the kernel only
+ * wrote the entries that differ from the reference callchain of the CPU,
+ * the last @shared entries are those of the reference.
+ */
+static int perf_session__expand_callchain(struct perf_session *session,
+					  struct perf_sample *sample)
+{
+	u64 nr = sample->callchain_delta[0];
+	u64 shared = sample->callchain_delta[1];
+	bool noref = shared & PERF_CALLCHAIN_SHARED_NOREF;
+	struct ip_callchain *ref = NULL, *chain;
+	u32 cpu = sample->cpu;
+
+	shared &= ~PERF_CALLCHAIN_SHARED_NOREF;
+
+	if (cpu >= session->nr_callchain_refs) {
+		struct ip_callchain **refs;
+		u32 nr_refs = cpu + 1;
+
+		if (cpu == (u32)-1)
+			return -EINVAL;
+
+		refs = realloc(session->callchain_refs, nr_refs * sizeof(*refs));
+		if (!refs)
+			return -ENOMEM;
+		memset(refs + session->nr_callchain_refs, 0,
+		       (nr_refs - session->nr_callchain_refs) * sizeof(*refs));
+		session->callchain_refs = refs;
+		session->nr_callchain_refs = nr_refs;
+	}
+
+	ref = session->callchain_refs[cpu];
+	if (shared > (ref ? ref->nr : 0)) {
+		pr_warning_once("callchain delta without a reference, lost samples?\n");
+		return 0;
+	}
+
+	chain = realloc(session->callchain_scratch,
+			sizeof(*chain) + nr * sizeof(u64));
+	if (!chain)
+		return -ENOMEM;
+	session->callchain_scratch = chain;
+
+	chain->nr = nr;
+	memcpy(chain->ips, sample->callchain_delta + 2,
+	       (nr - shared) * sizeof(u64));
+	if (shared)
+		memcpy(chain->ips + nr - shared, ref->ips + ref->nr - shared,
+		       shared * sizeof(u64));
+
+	if (!noref) {
+		session->callchain_refs[cpu] = chain;
+		session->callchain_scratch = ref;
+	}
+
+	sample->callchain = chain;
+	return 0;
+}
+
 static int perf_session__deliver_event(struct perf_session *session,
 				       union perf_event *event,
 				       const struct perf_tool *tool,
@@ -1358,6 +1422,14 @@ static int perf_session__deliver_event(struct perf_session *session,
 		return ret;
 	}
 
+	if (sample.callchain_delta) {
+		ret = perf_session__expand_callchain(session, &sample);
+		if (ret) {
+			pr_err("Can't expand callchain, err = %d\n", ret);
+			return ret;
+		}
+	}
+
 	ret = auxtrace__process_event(session, event, &sample, tool);
 	if (ret < 0)
 		return ret;
@@ -91,6 +91,13 @@ struct perf_session {
 	struct zstd_data	zstd_data;
 	struct decomp_data	decomp_data;
 	struct decomp_data	*active_decomp;
+	/**
+	 * @callchain_refs: Per CPU reference callchains of attr.callchain_delta
+	 * samples, @callchain_scratch holds the expansion of the current one.
+	 */
+	struct ip_callchain	**callchain_refs;
+	u32			nr_callchain_refs;
+	struct ip_callchain	*callchain_scratch;
 };
 
 struct decomp {
@@ -11,6 +11,7 @@
 #include "mptcp_sock.skel.h"
 #include "mptcpify.skel.h"
 #include "mptcp_subflow.skel.h"
+#include "mptcp_bpf_first.skel.h"
 
 #define NS_TEST "mptcp_ns"
 #define ADDR_1	"10.0.1.1"
@@ -436,6 +437,63 @@ static void test_subflow(void)
 	close(cgroup_fd);
 }
 
+static void run_sched(const char *sched)
+{
+	int server_fd, client_fd;
+
+	SYS(fail, "ip netns exec %s sysctl -qw net.mptcp.scheduler=%s",
+	    NS_TEST, sched);
+
+	server_fd = start_mptcp_server(AF_INET, ADDR_1, PORT_1, 0);
+	if (!ASSERT_OK_FD(server_fd, "start_mptcp_server"))
+		return;
+
+	client_fd = connect_to_fd(server_fd, 0);
+	if (!ASSERT_OK_FD(client_fd, "connect_to_fd"))
+		goto close_server;
+
+	wait_for_new_subflows(client_fd);
+	ASSERT_OK(send_recv_data(server_fd, client_fd, 10 * 1024 * 1024),
+		  "send_recv_data");
+
+	close(client_fd);
+close_server:
+	close(server_fd);
+fail:
+	return;
+}
+
+static void test_first(void)
+{
+	struct mptcp_bpf_first *skel;
+	struct netns_obj *netns;
+	struct bpf_link *link;
+
+	skel = mptcp_bpf_first__open_and_load();
+	if (!ASSERT_OK_PTR(skel, "open_and_load: first"))
+		return;
+
+	link = bpf_map__attach_struct_ops(skel->maps.first);
+	if (!ASSERT_OK_PTR(link, "bpf_map__attach_struct_ops"))
+		goto skel_destroy;
+
+	netns = netns_new(NS_TEST, true);
+	if (!ASSERT_OK_PTR(netns, "netns_new: first"))
+		goto link_destroy;
+
+	if (endpoint_init("subflow") < 0)
+		goto close_netns;
+
+	run_sched("bpf_first");
+
+close_netns:
+	netns_free(netns);
+link_destroy:
+	bpf_link__destroy(link);
+skel_destroy:
+	mptcp_bpf_first__destroy(skel);
+}
+
 void test_mptcp(void)
 {
 	if (test__start_subtest("base"))
@@ -444,4 +502,6 @@ void test_mptcp(void)
 		test_mptcpify();
 	if (test__start_subtest("subflow"))
 		test_subflow();
+	if (test__start_subtest("first"))
+		test_first();
 }
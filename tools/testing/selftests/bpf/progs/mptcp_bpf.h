@@ -4,6 +4,14 @@
 
 #include "bpf_experimental.h"
 
+/* mptcp scheduler kfuncs from net/mptcp/bpf.c */
+extern struct mptcp_subflow_context *
+bpf_mptcp_subflow_ctx_by_pos(const struct mptcp_sched_data *data,
+			     unsigned int pos) __ksym;
+extern void
+bpf_mptcp_subflow_set_scheduled(struct mptcp_subflow_context *subflow,
+				bool scheduled) __ksym;
+
 /* list helpers from include/linux/list.h */
 static inline int list_is_head(const struct list_head *list,
 			       const struct list_head *head)
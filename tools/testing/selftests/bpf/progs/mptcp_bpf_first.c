@@ -0,0 +1,26 @@
+// SPDX-License-Identifier: GPL-2.0
+
+#include "mptcp_bpf.h"
+#include <bpf/bpf_tracing.h>
+
+char _license[] SEC("license") = "GPL";
+
+SEC("struct_ops")
+int BPF_PROG(bpf_first_get_subflow, struct mptcp_sock *msk,
+	     struct mptcp_sched_data *data)
+{
+	struct mptcp_subflow_context *subflow;
+
+	subflow = bpf_mptcp_subflow_ctx_by_pos(data, 0);
+	if (!subflow)
+		return -1;
+
+	bpf_mptcp_subflow_set_scheduled(subflow, true);
+	return 0;
+}
+
+SEC(".struct_ops.link")
+struct mptcp_sched_ops first = {
+	.get_subflow	= (void *)bpf_first_get_subflow,
+	.name		= "bpf_first",
+};
@@ -31,6 +31,9 @@ struct __clone_args {
 	__aligned_u64 set_tid;
 	__aligned_u64 set_tid_size;
 	__aligned_u64 cgroup;
+	__aligned_u64 exec_path;
+	__aligned_u64 exec_argv;
+	__aligned_u64 exec_envp;
 };
 
 static pid_t sys_clone3(struct __clone_args *args, size_t size)
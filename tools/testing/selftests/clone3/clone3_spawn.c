@@ -0,0 +1,119 @@
+// SPDX-License-Identifier: GPL-2.0
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/sched.h>
+#include <linux/types.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
+#include "../kselftest.h"
+#include "clone3_selftests.h"
+
+#ifndef CLONE_SPAWN
+#define CLONE_SPAWN 0x400000000ULL
+#endif
+
+static int wait_for_pid(pid_t pid)
+{
+	int status, ret;
+
+again:
+	ret = waitpid(pid, &status, 0);
+	if (ret == -1) {
+		if (errno == EINTR)
+			goto again;
+
+		return -1;
+	}
+
+	if (!WIFEXITED(status))
+		return -1;
+
+	return WEXITSTATUS(status);
+}
+
+static pid_t spawn(const char *path, char *const argv[], __u64 flags)
+{
+	struct __clone_args args = {
+		.flags = CLONE_SPAWN | flags,
+		.exit_signal = SIGCHLD,
+		.exec_path = ptr_to_u64(path),
+		.exec_argv = ptr_to_u64(argv),
+		.exec_envp = ptr_to_u64(environ),
+	};
+
+	return sys_clone3(&args, sizeof(args));
+}
+
+static void test_clone3_spawn(void)
+{
+	char *const true_argv[] = { "/bin/sh", "-c", "exit 0", NULL };
+	char *const false_argv[] = { "/bin/sh", "-c", "exit 3", NULL };
+	char *const missing_argv[] = { "/nonexistent", NULL };
+	pid_t pid;
+
+	pid = spawn("/bin/sh", true_argv, 0);
+	if (pid < 0) {
+		if (errno == EINVAL)
+			ksft_exit_skip("CLONE_SPAWN is not supported\n");
+		ksft_exit_fail_msg("%s - clone3(CLONE_SPAWN) failed\n",
+				   strerror(errno));
+	}
+	if (wait_for_pid(pid) != 0)
+		ksft_exit_fail_msg("Spawned program did not exit with 0\n");
+
+	pid = spawn("/bin/sh", false_argv, 0);
+	if (pid < 0 || wait_for_pid(pid) != 3)
+		ksft_exit_fail_msg("Spawned program did not exit with 3\n");
+
+	pid = spawn("/nonexistent", missing_argv, 0);
+	if (pid < 0 || wait_for_pid(pid) != 127)
+		ksft_exit_fail_msg("Missing program did not exit with 127\n");
+
+	ksft_test_result_pass("Spawned programs with clone3(CLONE_SPAWN)\n");
+}
+
+static void test_clone3_spawn_invalid(void)
+{
+	char *const argv[] = { "/bin/sh", "-c", "exit 0", NULL };
+	struct __clone_args args = {
+		.flags = CLONE_SPAWN,
+		.exit_signal = SIGCHLD,
+	};
+	pid_t pid;
+
+	/* A spawned child needs a program */
+	pid = sys_clone3(&args, sizeof(args));
+	if (pid >= 0 || errno != EINVAL)
+		ksft_exit_fail_msg("clone3(CLONE_SPAWN) without exec_path succeeded\n");
+
+	/* And shares nothing but the mm it is about to replace */
+	pid = spawn("/bin/sh", argv, CLONE_VM);
+	if (pid >= 0 || errno != EINVAL)
+		ksft_exit_fail_msg("clone3(CLONE_SPAWN | CLONE_VM) succeeded\n");
+
+	pid = spawn("/bin/sh", argv, CLONE_THREAD | CLONE_SIGHAND);
+	if (pid >= 0 || errno != EINVAL)
+		ksft_exit_fail_msg("clone3(CLONE_SPAWN | CLONE_THREAD) succeeded\n");
+
+	ksft_test_result_pass("Rejected invalid clone3(CLONE_SPAWN) arguments\n");
+}
+
+int main(int argc, char **argv)
+{
+	ksft_print_header();
+	ksft_set_plan(2);
+	test_clone3_supported();
+
+	test_clone3_spawn();
+	test_clone3_spawn_invalid();
+
+	ksft_exit_pass();
+}
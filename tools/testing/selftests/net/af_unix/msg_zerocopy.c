@@ -0,0 +1,159 @@
+// SPDX-License-Identifier: GPL-2.0
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <linux/errqueue.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+
+#include "../../kselftest_harness.h"
+
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY	60
+#endif
+
+#ifndef SO_EE_ORIGIN_ZEROCOPY
+#define SO_EE_ORIGIN_ZEROCOPY	5
+#endif
+
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY	0x4000000
+#endif
+
+#define BUF_SIZE	(16 * 4096)
+#define NR_SENDS	8
+
+FIXTURE(msg_zerocopy)
+{
+	int fd[2];
+	char *buf;
+};
+
+FIXTURE_SETUP(msg_zerocopy)
+{
+	int ret, one = 1;
+
+	ret = socketpair(AF_UNIX, SOCK_STREAM, 0, self->fd);
+	ASSERT_EQ(0, ret);
+
+	ret = setsockopt(self->fd[0], SOL_SOCKET, SO_ZEROCOPY,
+			 &one, sizeof(one));
+	ASSERT_EQ(0, ret);
+
+	self->buf = mmap(NULL, BUF_SIZE, PROT_READ | PROT_WRITE,
+			 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	ASSERT_NE(MAP_FAILED, self->buf);
+}
+
+FIXTURE_TEARDOWN(msg_zerocopy)
+{
+	munmap(self->buf, BUF_SIZE);
+	close(self->fd[0]);
+	close(self->fd[1]);
+}
+
+static int recv_completion(int fd, __u32 *lo, __u32 *hi)
+{
+	char control[CMSG_SPACE(sizeof(struct sock_extended_err))];
+	struct sock_extended_err *serr;
+	struct msghdr msg = {
+		.msg_control = control,
+		.msg_controllen = sizeof(control),
+	};
+	struct cmsghdr *cmsg;
+
+	if (recvmsg(fd, &msg, MSG_ERRQUEUE) < 0)
+		return -errno;
+
+	cmsg = CMSG_FIRSTHDR(&msg);
+	if (!cmsg || cmsg->cmsg_level != SOL_SOCKET ||
+	    cmsg->cmsg_type != SO_ZEROCOPY)
+		return -EPROTO;
+
+	serr = (void *)CMSG_DATA(cmsg);
+	if (serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY || serr->ee_errno)
+		return -EPROTO;
+
+	*lo = serr->ee_info;
+	*hi = serr->ee_data;
+
+	return 0;
+}
+
+TEST_F(msg_zerocopy, stream)
+{
+	char *rbuf = malloc(BUF_SIZE);
+	__u32 lo, hi, next = 0;
+	struct pollfd pfd = {
+		.fd = self->fd[0],
+		.events = 0,
+	};
+	int i, ret;
+
+	ASSERT_NE(NULL, rbuf);
+
+	for (i = 0; i < NR_SENDS; i++) {
+		ssize_t len = 0;
+
+		memset(self->buf, 'a' + i, BUF_SIZE);
+
+		ASSERT_EQ(BUF_SIZE, send(self->fd[0], self->buf, BUF_SIZE,
+					 MSG_ZEROCOPY));
+
+		/* No completion until the peer consumes the data */
+		ASSERT_EQ(-EAGAIN, recv_completion(self->fd[0], &lo, &hi));
+
+		while (len < BUF_SIZE) {
+			ret = recv(self->fd[1], rbuf + len, BUF_SIZE - len, 0);
+			ASSERT_LT(0, ret);
+			len += ret;
+		}
+
+		ASSERT_EQ(0, memcmp(rbuf, self->buf, BUF_SIZE));
+
+		ASSERT_EQ(1, poll(&pfd, 1, 1000));
+		ASSERT_TRUE(pfd.revents & POLLERR);
+
+		ASSERT_EQ(0, recv_completion(self->fd[0], &lo, &hi));
+		ASSERT_EQ(next, lo);
+		ASSERT_EQ(next, hi);
+		next++;
+	}
+
+	free(rbuf);
+}
+
+TEST_F(msg_zerocopy, no_sockopt)
+{
+	char c = 'x';
+	__u32 lo, hi;
+	int zero = 0;
+
+	ASSERT_EQ(0, setsockopt(self->fd[0], SOL_SOCKET, SO_ZEROCOPY,
+				&zero, sizeof(zero)));
+
+	/* MSG_ZEROCOPY is ignored without SO_ZEROCOPY, as for TCP */
+	ASSERT_EQ(1, send(self->fd[0], &c, 1, MSG_ZEROCOPY));
+	ASSERT_EQ(1, recv(self->fd[1], &c, 1, 0));
+	ASSERT_EQ(-EAGAIN, recv_completion(self->fd[0], &lo, &hi));
+}
+
+TEST(dgram_unsupported)
+{
+	int fd[2], one = 1;
+
+	ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_DGRAM, 0, fd));
+	ASSERT_EQ(-1, setsockopt(fd[0], SOL_SOCKET, SO_ZEROCOPY,
+				 &one, sizeof(one)));
+	ASSERT_EQ(EOPNOTSUPP, errno);
+
+	close(fd[0]);
+	close(fd[1]);
+}
+
+TEST_HARNESS_MAIN
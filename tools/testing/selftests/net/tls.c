@@ -2572,6 +2572,56 @@ TEST(no_pad) {
 	close(cfd);
 }
 
+TEST(rx_parallel) {
+	struct tls12_crypto_info_aes_gcm_256 tls12;
+	char buf[TLS_PAYLOAD_MAX_LEN * 4];
+	char buf2[TLS_PAYLOAD_MAX_LEN * 4];
+	int ret, fd, cfd, val;
+	socklen_t len;
+	bool notls;
+
+	memset(&tls12, 0, sizeof(tls12));
+	tls12.info.version = TLS_1_2_VERSION;
+	tls12.info.cipher_type = TLS_CIPHER_AES_GCM_256;
+
+	ulp_sock_pair(_metadata, &fd, &cfd, &notls);
+
+	if (notls)
+		exit(KSFT_SKIP);
+
+	val = 1;
+	ret = setsockopt(cfd, SOL_TLS, TLS_RX_PARALLEL,
+			 (void *)&val, sizeof(val));
+	EXPECT_EQ(ret, 0);
+
+	ret = setsockopt(fd, SOL_TLS, TLS_TX, &tls12, sizeof(tls12));
+	EXPECT_EQ(ret, 0);
+
+	ret = setsockopt(cfd, SOL_TLS, TLS_RX, &tls12, sizeof(tls12));
+	EXPECT_EQ(ret, 0);
+
+	/* Can't be changed once the cipher is set up */
+	ret = setsockopt(cfd, SOL_TLS, TLS_RX_PARALLEL,
+			 (void *)&val, sizeof(val));
+	EXPECT_EQ(ret, -1);
+	EXPECT_EQ(errno, EBUSY);
+
+	/* 0 if pcrypt is not available */
+	len = sizeof(val);
+	val = 2;
+	ret = getsockopt(cfd, SOL_TLS, TLS_RX_PARALLEL, (void *)&val, &len);
+	EXPECT_EQ(ret, 0);
+	EXPECT_LE(val, 1);
+
+	memrnd(buf, sizeof(buf));
+	EXPECT_EQ(send(fd, buf, sizeof(buf), 0), sizeof(buf));
+	EXPECT_EQ(recv(cfd, buf2, sizeof(buf2), MSG_WAITALL), sizeof(buf2));
+	EXPECT_EQ(memcmp(buf, buf2, sizeof(buf)), 0);
+
+	close(fd);
+	close(cfd);
+}
+
 TEST(tls_v6ops) {
 	struct tls_crypto_info_keys tls12;
 	struct sockaddr_in6 addr, addr2;
@@ -578,6 +578,40 @@ int main(void)
 		assert(err == -ENOENT);
 	}
 
+	/* Test PROCMAP_STATS ioctl() for /proc/$PID/maps */
+	{
+		char path_buf[256];
+		struct procmap_stats s;
+		int fd, err;
+
+		snprintf(path_buf, sizeof(path_buf), "/proc/%u/maps", pid);
+		fd = open(path_buf, O_RDONLY);
+		if (fd == -1)
+			return 1;
+
+		memset(&s, 0, sizeof(s));
+		s.size = sizeof(s);
+		s.start = VADDR - PAGE_SIZE;
+		s.end = VADDR + 2 * PAGE_SIZE;
+
+		err = ioctl(fd, PROCMAP_STATS, &s);
+		if (err < 0 && errno == ENOTTY)
+			return 0;
+		assert(err == 0);
+
+		assert(s.nr_vmas == 1);
+		assert(s.walk_end == VADDR + 2 * PAGE_SIZE);
+		assert(s.rss <= PAGE_SIZE);
+		assert(s.anonymous == 0);
+		assert(s.swap == 0);
+
+		/* Empty range */
+		s.start = s.end;
+		err = ioctl(fd, PROCMAP_STATS, &s);
+		err = err < 0 ? -errno : 0;
+		assert(err == -EINVAL);
+	}
+
 	return 0;
 }
 #else